@@ -0,0 +1,129 @@
+#include "BlockCache.h"
+#include "PortableFile.h"
+
+BlockCache::BlockCache(size_t blockSize, size_t blockCount)
+    : m_file(nullptr)
+    , m_fileSize(0)
+    , m_blockSize(blockSize)
+    , m_blockCount(blockCount > 0 ? blockCount : 1)
+{
+}
+
+BlockCache::~BlockCache()
+{
+    close();
+}
+
+bool BlockCache::open(const std::wstring& path)
+{
+    close();
+
+    PortableFile::Info info;
+    if (!PortableFile::getInfo(path, info))
+    {
+        return false;
+    }
+    m_file = PortableFile::open(path, "rb");
+    if (!m_file)
+    {
+        return false;
+    }
+
+    // Буферизация stdio не нужна: читаем целыми блоками
+    setvbuf(m_file, nullptr, _IONBF, 0);
+    m_fileSize = info.size;
+    return true;
+}
+
+void BlockCache::close()
+{
+    if (m_file)
+    {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+    m_fileSize = 0;
+    m_blocks.clear();
+    m_lookup.clear();
+}
+
+uint64_t BlockCache::fileSize() const
+{
+    return m_fileSize;
+}
+
+size_t BlockCache::blockSize() const
+{
+    return m_blockSize;
+}
+
+const char* BlockCache::blockAt(uint64_t offset, uint64_t& blockStart, size_t& size)
+{
+    if (!m_file || offset >= m_fileSize)
+    {
+        return nullptr;
+    }
+
+    uint64_t index = offset / m_blockSize;
+    blockStart = index * m_blockSize;
+
+    std::unordered_map<uint64_t, BlockList::iterator>::iterator found = m_lookup.find(index);
+    if (found != m_lookup.end())
+    {
+        // Перемещаем блок в начало списка
+        m_blocks.splice(m_blocks.begin(), m_blocks, found->second);
+        size = m_blocks.front().data.size();
+        return m_blocks.front().data.data();
+    }
+
+    // Вытесняем давно не использованный блок, переиспользуя его буфер
+    Block block;
+    if (m_blocks.size() >= m_blockCount)
+    {
+        block.data.swap(m_blocks.back().data);
+        m_lookup.erase(m_blocks.back().index);
+        m_blocks.pop_back();
+    }
+
+    uint64_t remaining = m_fileSize - blockStart;
+    block.index = index;
+    block.data.resize(static_cast<size_t>(remaining < m_blockSize ? remaining : m_blockSize));
+    if (!PortableFile::seek(m_file, blockStart) ||
+        fread(block.data.data(), 1, block.data.size(), m_file) != block.data.size())
+    {
+        return nullptr;
+    }
+
+    m_blocks.push_front(Block());
+    m_blocks.front().index = index;
+    m_blocks.front().data.swap(block.data);
+    m_lookup[index] = m_blocks.begin();
+
+    size = m_blocks.front().data.size();
+    return m_blocks.front().data.data();
+}
+
+size_t BlockCache::read(uint64_t offset, size_t size, std::string& output)
+{
+    size_t total = 0;
+    while (total < size)
+    {
+        uint64_t blockStart;
+        size_t blockLength;
+        const char* data = blockAt(offset + total, blockStart, blockLength);
+        if (!data)
+        {
+            break;
+        }
+
+        size_t inner = static_cast<size_t>(offset + total - blockStart);
+        size_t count = blockLength - inner;
+        if (count > size - total)
+        {
+            count = size - total;
+        }
+        output.append(data + inner, count);
+        total += count;
+    }
+    return total;
+}
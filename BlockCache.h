@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief LRU-кэш блоков файла фиксированного размера
+ *
+ * Читает файл блоками и держит в памяти не более заданного числа блоков,
+ * поэтому расход памяти не зависит от размера файла. Не потокобезопасен:
+ * используется одним потоком (окном просмотра).
+ */
+class BlockCache
+{
+public:
+    /**
+     * @brief Конструктор
+     * @param blockSize Размер блока в байтах (четный)
+     * @param blockCount Максимальное количество блоков в памяти
+     */
+    BlockCache(size_t blockSize, size_t blockCount);
+    ~BlockCache();
+
+    /**
+     * @brief Открыть файл
+     * @param path Путь к файлу
+     * @return true при успехе
+     */
+    bool open(const std::wstring& path);
+
+    /**
+     * @brief Закрыть файл и очистить кэш
+     */
+    void close();
+
+    /**
+     * @brief Получить размер файла
+     * @return Размер в байтах
+     */
+    uint64_t fileSize() const;
+
+    /**
+     * @brief Получить размер блока
+     * @return Размер в байтах
+     */
+    size_t blockSize() const;
+
+    /**
+     * @brief Получить блок, содержащий смещение
+     * @param offset Смещение в файле
+     * @param blockStart Смещение начала блока
+     * @param size Размер данных в блоке (последний блок может быть короче)
+     * @return Указатель на данные (действителен до следующего вызова) или nullptr
+     */
+    const char* blockAt(uint64_t offset, uint64_t& blockStart, size_t& size);
+
+    /**
+     * @brief Прочитать диапазон байт (может пересекать границы блоков)
+     * @param offset Смещение в файле
+     * @param size Количество байт
+     * @param output Строка, в конец которой дописываются байты
+     * @return Количество прочитанных байт
+     */
+    size_t read(uint64_t offset, size_t size, std::string& output);
+
+private:
+    struct Block
+    {
+        uint64_t index;                 ///< Номер блока в файле
+        std::vector<char> data;         ///< Данные блока
+    };
+
+    typedef std::list<Block> BlockList;
+
+    FILE* m_file;                                           ///< Открытый файл
+    uint64_t m_fileSize;                                    ///< Размер файла
+    size_t m_blockSize;                                     ///< Размер блока
+    size_t m_blockCount;                                    ///< Емкость кэша
+    BlockList m_blocks;                                     ///< Блоки, недавно использованные - в начале
+    std::unordered_map<uint64_t, BlockList::iterator> m_lookup;  ///< Поиск блока по номеру
+
+    BlockCache(const BlockCache&);
+    BlockCache& operator=(const BlockCache&);
+};
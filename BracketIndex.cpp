@@ -0,0 +1,296 @@
+#include "BracketIndex.h"
+#include <algorithm>
+
+namespace
+{
+    const size_t NO_CHUNK = ~static_cast<size_t>(0);
+
+    bool isOpening(wchar_t character)
+    {
+        return character == L'(' || character == L'[' || character == L'{';
+    }
+
+    bool isClosing(wchar_t character)
+    {
+        return character == L')' || character == L']' || character == L'}';
+    }
+
+    bool isPair(wchar_t opening, wchar_t closing)
+    {
+        return (opening == L'(' && closing == L')') || (opening == L'[' && closing == L']') ||
+               (opening == L'{' && closing == L'}');
+    }
+}
+
+BracketIndex::BracketIndex()
+    : m_leafCount(1)
+    , m_chunkCount(0)
+{
+    Summary empty = { 0, 0 };
+    m_tree.assign(2, empty);
+}
+
+void BracketIndex::onTextReset(const ChunkedText& text)
+{
+    std::vector<Summary> summaries(text.chunkCount());
+    for (size_t i = 0; i < text.chunkCount(); ++i)
+    {
+        summaries[i] = summarize(text.chunkText(i));
+    }
+    rebuild(summaries);
+}
+
+void BracketIndex::onTextEdited(const ChunkedText& text, const TextEdit& edit, const ChunkChange& change)
+{
+    if (change.removedChunks == change.insertedChunks)
+    {
+        // Сводка зависит только от скобок: правка без скобок внутри одного
+        // блока ничего не меняет (обычный ввод текста). Если блоков
+        // несколько, их границы могли сдвинуться и скобки - перейти в
+        // соседний блок, поэтому их сводки пересчитываются
+        if (change.insertedChunks == 1 &&
+            std::find_if(edit.removedText.begin(), edit.removedText.end(), isBracket) == edit.removedText.end() &&
+            std::find_if(edit.insertedText, edit.insertedText + edit.insertedLength, isBracket) == edit.insertedText + edit.insertedLength)
+        {
+            return;
+        }
+
+        // Структура не изменилась - обновляем пути от затронутых листьев
+        for (size_t i = 0; i < change.insertedChunks; ++i)
+        {
+            size_t index = change.firstChunk + i;
+            updateLeaf(index, summarize(text.chunkText(index)));
+        }
+        return;
+    }
+
+    std::vector<Summary> summaries(m_tree.begin() + m_leafCount, m_tree.begin() + m_leafCount + m_chunkCount);
+    std::vector<Summary> inserted(change.insertedChunks);
+    for (size_t i = 0; i < change.insertedChunks; ++i)
+    {
+        inserted[i] = summarize(text.chunkText(change.firstChunk + i));
+    }
+    summaries.erase(summaries.begin() + change.firstChunk,
+                    summaries.begin() + change.firstChunk + change.removedChunks);
+    summaries.insert(summaries.begin() + change.firstChunk, inserted.begin(), inserted.end());
+    rebuild(summaries);
+}
+
+bool BracketIndex::findMatch(const ChunkedText& text, size_t offset, size_t& match) const
+{
+    if (offset >= text.length())
+    {
+        return false;
+    }
+    wchar_t bracket = text.charAt(offset);
+    if (!isBracket(bracket))
+    {
+        return false;
+    }
+
+    size_t inner = 0;
+    size_t chunk = text.findChunk(offset, inner);
+    const std::wstring& current = text.chunkText(chunk);
+    size_t depth = 1;
+    size_t found = NO_CHUNK;
+
+    if (isOpening(bracket))
+    {
+        // Сначала остаток своего блока, затем блок из дерева
+        for (size_t i = inner + 1; i < current.size() && found == NO_CHUNK; ++i)
+        {
+            depth += isOpening(current[i]) ? 1 : 0;
+            depth -= isClosing(current[i]) ? 1 : 0;
+            if (depth == 0)
+            {
+                found = text.chunkOffset(chunk) + i;
+            }
+        }
+        if (found == NO_CHUNK)
+        {
+            size_t target = findForward(1, 0, m_leafCount, chunk + 1, depth);
+            if (target == NO_CHUNK)
+            {
+                return false;
+            }
+            const std::wstring& block = text.chunkText(target);
+            for (size_t i = 0; i < block.size() && found == NO_CHUNK; ++i)
+            {
+                depth += isOpening(block[i]) ? 1 : 0;
+                depth -= isClosing(block[i]) ? 1 : 0;
+                if (depth == 0)
+                {
+                    found = text.chunkOffset(target) + i;
+                }
+            }
+        }
+    }
+    else
+    {
+        for (size_t i = inner; i-- > 0 && found == NO_CHUNK;)
+        {
+            depth += isClosing(current[i]) ? 1 : 0;
+            depth -= isOpening(current[i]) ? 1 : 0;
+            if (depth == 0)
+            {
+                found = text.chunkOffset(chunk) + i;
+            }
+        }
+        if (found == NO_CHUNK)
+        {
+            size_t target = findBackward(1, 0, m_leafCount, chunk, depth);
+            if (target == NO_CHUNK)
+            {
+                return false;
+            }
+            const std::wstring& block = text.chunkText(target);
+            for (size_t i = block.size(); i-- > 0 && found == NO_CHUNK;)
+            {
+                depth += isClosing(block[i]) ? 1 : 0;
+                depth -= isOpening(block[i]) ? 1 : 0;
+                if (depth == 0)
+                {
+                    found = text.chunkOffset(target) + i;
+                }
+            }
+        }
+    }
+
+    if (found == NO_CHUNK)
+    {
+        return false;
+    }
+    wchar_t other = text.charAt(found);
+    if (isOpening(bracket) ? !isPair(bracket, other) : !isPair(other, bracket))
+    {
+        return false;
+    }
+    match = found;
+    return true;
+}
+
+bool BracketIndex::isBracket(wchar_t character)
+{
+    return isOpening(character) || isClosing(character);
+}
+
+BracketIndex::Summary BracketIndex::summarize(const std::wstring& chunk)
+{
+    Summary summary = { 0, 0 };
+    for (size_t i = 0; i < chunk.size(); ++i)
+    {
+        if (isOpening(chunk[i]))
+        {
+            ++summary.opens;
+        }
+        else if (isClosing(chunk[i]))
+        {
+            // Закрывающая скобка сначала закрывает открытую в этом же блоке
+            if (summary.opens > 0)
+            {
+                --summary.opens;
+            }
+            else
+            {
+                ++summary.closes;
+            }
+        }
+    }
+    return summary;
+}
+
+BracketIndex::Summary BracketIndex::combine(const Summary& left, const Summary& right)
+{
+    // Закрывающие скобки правого участка закрывают открытые в левом
+    Summary summary;
+    summary.closes = left.closes + (right.closes > left.opens ? right.closes - left.opens : 0);
+    summary.opens = right.opens + (left.opens > right.closes ? left.opens - right.closes : 0);
+    return summary;
+}
+
+void BracketIndex::rebuild(const std::vector<Summary>& summaries)
+{
+    m_chunkCount = summaries.size();
+    m_leafCount = 1;
+    while (m_leafCount < m_chunkCount)
+    {
+        m_leafCount *= 2;
+    }
+
+    Summary empty = { 0, 0 };
+    m_tree.assign(2 * m_leafCount, empty);
+    std::copy(summaries.begin(), summaries.end(), m_tree.begin() + m_leafCount);
+    for (size_t node = m_leafCount - 1; node > 0; --node)
+    {
+        m_tree[node] = combine(m_tree[2 * node], m_tree[2 * node + 1]);
+    }
+}
+
+void BracketIndex::updateLeaf(size_t index, const Summary& summary)
+{
+    size_t node = m_leafCount + index;
+    m_tree[node] = summary;
+    for (node /= 2; node > 0; node /= 2)
+    {
+        m_tree[node] = combine(m_tree[2 * node], m_tree[2 * node + 1]);
+    }
+}
+
+size_t BracketIndex::findForward(size_t node, size_t left, size_t right, size_t from, size_t& depth) const
+{
+    if (right <= from)
+    {
+        return NO_CHUNK;
+    }
+    if (left >= from)
+    {
+        // Участок целиком правее: если он не закрывает все скобки, он пропускается
+        const Summary& summary = m_tree[node];
+        if (summary.closes < depth)
+        {
+            depth = depth - summary.closes + summary.opens;
+            return NO_CHUNK;
+        }
+        if (right - left == 1)
+        {
+            return left;
+        }
+    }
+
+    size_t middle = (left + right) / 2;
+    size_t found = findForward(2 * node, left, middle, from, depth);
+    if (found != NO_CHUNK)
+    {
+        return found;
+    }
+    return findForward(2 * node + 1, middle, right, from, depth);
+}
+
+size_t BracketIndex::findBackward(size_t node, size_t left, size_t right, size_t to, size_t& depth) const
+{
+    if (left >= to)
+    {
+        return NO_CHUNK;
+    }
+    if (right <= to)
+    {
+        const Summary& summary = m_tree[node];
+        if (summary.opens < depth)
+        {
+            depth = depth - summary.opens + summary.closes;
+            return NO_CHUNK;
+        }
+        if (right - left == 1)
+        {
+            return left;
+        }
+    }
+
+    size_t middle = (left + right) / 2;
+    size_t found = findBackward(2 * node + 1, middle, right, to, depth);
+    if (found != NO_CHUNK)
+    {
+        return found;
+    }
+    return findBackward(2 * node, left, middle, to, depth);
+}
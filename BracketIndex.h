@@ -0,0 +1,90 @@
+#pragma once
+
+#include "TextChangeTracker.h"
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Индекс скобок документа для поиска парной скобки
+ *
+ * Для каждого блока ChunkedText хранится число незакрытых в нем
+ * открывающих и лишних закрывающих скобок. Сводки блоков объединены в
+ * дерево отрезков, поэтому блок, в котором глубина вложенности
+ * возвращается к скобке, находится спуском по дереву за O(log n), а
+ * точная позиция - просмотром одного блока. Правка пересчитывает только
+ * затронутые блоки. Скобки (), [] и {} считаются одной вложенностью;
+ * пара разных скобок считается несовпадением. Строки и комментарии не
+ * разбираются. Класс не зависит от WinAPI.
+ */
+class BracketIndex : public ITextChangeListener
+{
+public:
+    BracketIndex();
+
+    void onTextReset(const ChunkedText& text) override;
+    void onTextEdited(const ChunkedText& text, const TextEdit& edit, const ChunkChange& change) override;
+
+    /**
+     * @brief Найти парную скобку
+     * @param text Текст, по которому построен индекс
+     * @param offset Позиция скобки
+     * @param match Позиция парной скобки
+     * @return false если в позиции нет скобки, пары нет или скобки разные
+     */
+    bool findMatch(const ChunkedText& text, size_t offset, size_t& match) const;
+
+    /**
+     * @brief Проверить, является ли символ скобкой
+     * @param character Символ
+     * @return true для (, ), [, ], {, }
+     */
+    static bool isBracket(wchar_t character);
+
+private:
+    /**
+     * @brief Сводка участка текста: непарные скобки
+     */
+    struct Summary
+    {
+        size_t opens;   ///< Открывающие скобки без пары внутри участка
+        size_t closes;  ///< Закрывающие скобки без пары внутри участка
+    };
+
+    std::vector<Summary> m_tree;    ///< Дерево отрезков, листья с m_leafCount
+    size_t m_leafCount;             ///< Число листьев (степень двойки)
+    size_t m_chunkCount;            ///< Число блоков текста
+
+    /**
+     * @brief Посчитать сводку блока
+     */
+    static Summary summarize(const std::wstring& chunk);
+
+    /**
+     * @brief Объединить сводки соседних участков
+     */
+    static Summary combine(const Summary& left, const Summary& right);
+
+    /**
+     * @brief Перестроить дерево по сводкам блоков
+     */
+    void rebuild(const std::vector<Summary>& summaries);
+
+    /**
+     * @brief Обновить лист и его предков
+     */
+    void updateLeaf(size_t index, const Summary& summary);
+
+    /**
+     * @brief Найти первый блок не раньше from, закрывающий depth скобок
+     * @param depth Незакрытые скобки; уменьшается на пропущенные блоки
+     * @return Номер блока или NO_CHUNK
+     */
+    size_t findForward(size_t node, size_t left, size_t right, size_t from, size_t& depth) const;
+
+    /**
+     * @brief Найти последний блок раньше to, открывающий depth скобок
+     * @param depth Непарные закрывающие скобки; уменьшается на пропущенные блоки
+     * @return Номер блока или NO_CHUNK
+     */
+    size_t findBackward(size_t node, size_t left, size_t right, size_t to, size_t& depth) const;
+};
@@ -0,0 +1,219 @@
+#include "ChunkHashTree.h"
+
+namespace
+{
+    const uint64_t MODULUS = (1ULL << 61) - 1;      ///< Простое число Мерсенна 2^61-1
+    const uint64_t BASE = 0x1F3D5B79A5C3E1ULL;      ///< Основание полинома (меньше модуля)
+    const uint64_t MASK30 = (1ULL << 30) - 1;
+    const uint64_t MASK31 = (1ULL << 31) - 1;
+
+    uint64_t reduce(uint64_t value)
+    {
+        value = (value & MODULUS) + (value >> 61);
+        return value >= MODULUS ? value - MODULUS : value;
+    }
+
+    // Умножение по модулю 2^61-1 без 128-битной арифметики (ее нет в MSVC)
+    uint64_t multiply(uint64_t a, uint64_t b)
+    {
+        uint64_t aHigh = a >> 31;
+        uint64_t aLow = a & MASK31;
+        uint64_t bHigh = b >> 31;
+        uint64_t bLow = b & MASK31;
+        uint64_t middle = aLow * bHigh + aHigh * bLow;
+        return reduce(aHigh * bHigh * 2 + (middle >> 30) + ((middle & MASK30) << 31) + aLow * bLow);
+    }
+
+    // Умножение на символ (меньше 2^17): два умножения вместо четырех
+    uint64_t multiplySmall(uint64_t small, uint64_t b)
+    {
+        uint64_t high = small * (b >> 31);
+        return reduce(small * (b & MASK31) + (high >> 30) + ((high & MASK30) << 31));
+    }
+
+    uint64_t add(uint64_t a, uint64_t b)
+    {
+        uint64_t sum = a + b;
+        return sum >= MODULUS ? sum - MODULUS : sum;
+    }
+
+    uint64_t power(uint64_t exponent)
+    {
+        uint64_t result = 1;
+        uint64_t base = BASE;
+        while (exponent > 0)
+        {
+            if (exponent & 1)
+            {
+                result = multiply(result, base);
+            }
+            base = multiply(base, base);
+            exponent >>= 1;
+        }
+        return result;
+    }
+}
+
+ChunkHashTree::ChunkHashTree()
+    : m_capacity(1)
+    , m_chunkCount(0)
+    , m_length(0)
+    , m_hasSaved(false)
+{
+    Node empty = { 0, 1 };
+    m_tree.assign(2, empty);
+    m_saved.hash = 0;
+    m_saved.length = 0;
+}
+
+void ChunkHashTree::onTextReset(const ChunkedText& text)
+{
+    std::vector<Node> leaves;
+    leaves.reserve(text.chunkCount());
+    for (size_t i = 0; i < text.chunkCount(); ++i)
+    {
+        leaves.push_back(hashChunk(text.chunkText(i)));
+    }
+    m_length = text.length();
+    rebuild(leaves);
+}
+
+void ChunkHashTree::onTextEdited(const ChunkedText& text, const TextEdit& edit, const ChunkChange& change)
+{
+    (void)edit;
+    m_length = text.length();
+
+    if (change.removedChunks == change.insertedChunks)
+    {
+        // Структура не изменилась - пересчитываем только затронутые блоки
+        for (size_t i = 0; i < change.insertedChunks; ++i)
+        {
+            size_t index = change.firstChunk + i;
+            updateLeaf(index, hashChunk(text.chunkText(index)));
+        }
+        return;
+    }
+
+    // Блоки разделились или слились: сдвигаем листья и перестраиваем дерево
+    std::vector<Node> leaves(m_tree.begin() + m_capacity, m_tree.begin() + m_capacity + m_chunkCount);
+    leaves.erase(leaves.begin() + change.firstChunk, leaves.begin() + change.firstChunk + change.removedChunks);
+    std::vector<Node> inserted;
+    inserted.reserve(change.insertedChunks);
+    for (size_t i = 0; i < change.insertedChunks; ++i)
+    {
+        inserted.push_back(hashChunk(text.chunkText(change.firstChunk + i)));
+    }
+    leaves.insert(leaves.begin() + change.firstChunk, inserted.begin(), inserted.end());
+    rebuild(leaves);
+}
+
+ChunkHashTree::Digest ChunkHashTree::digest() const
+{
+    Digest result;
+    result.hash = m_tree[1].hash;
+    result.length = m_length;
+    return result;
+}
+
+void ChunkHashTree::markSaved()
+{
+    m_saved = digest();
+    m_hasSaved = true;
+}
+
+void ChunkHashTree::markUnsaved()
+{
+    m_hasSaved = false;
+}
+
+bool ChunkHashTree::getSavedDigest(Digest& saved) const
+{
+    saved = m_saved;
+    return m_hasSaved;
+}
+
+void ChunkHashTree::setSavedDigest(const Digest& saved)
+{
+    m_saved = saved;
+    m_hasSaved = true;
+}
+
+bool ChunkHashTree::isModified() const
+{
+    return !m_hasSaved || m_saved.hash != m_tree[1].hash || m_saved.length != m_length;
+}
+
+ChunkHashTree::Digest ChunkHashTree::computeDigest(const wchar_t* text, size_t length)
+{
+    Digest result;
+    result.hash = hashChunk(std::wstring(text, length)).hash;
+    result.length = length;
+    return result;
+}
+
+ChunkHashTree::Node ChunkHashTree::hashChunk(const std::wstring& chunk)
+{
+    static const uint64_t BASE2 = power(2);
+    static const uint64_t BASE3 = power(3);
+    static const uint64_t BASE4 = power(4);
+
+    // Схема Горнера: символ с номером i входит с множителем BASE^(n-1-i).
+    // Четыре символа за шаг: их умножения независимы друг от друга, и
+    // цепочку зависимостей образует одно умножение на BASE^4
+    Node node = { 0, power(chunk.size()) };
+    size_t i = 0;
+    for (; i + 4 <= chunk.size(); i += 4)
+    {
+        // Слагаемые меньше 2^61, поэтому их сумма не переполняется и
+        // приводится по модулю один раз
+        uint64_t sum = multiply(node.hash, BASE4) +
+                       multiplySmall(static_cast<uint64_t>(chunk[i]) + 1, BASE3) +
+                       multiplySmall(static_cast<uint64_t>(chunk[i + 1]) + 1, BASE2) +
+                       multiplySmall(static_cast<uint64_t>(chunk[i + 2]) + 1, BASE) +
+                       static_cast<uint64_t>(chunk[i + 3]) + 1;
+        node.hash = reduce(sum);
+    }
+    for (; i < chunk.size(); ++i)
+    {
+        node.hash = add(multiply(node.hash, BASE), static_cast<uint64_t>(chunk[i]) + 1);
+    }
+    return node;
+}
+
+ChunkHashTree::Node ChunkHashTree::combine(const Node& left, const Node& right)
+{
+    Node node = { add(multiply(left.hash, right.power), right.hash), multiply(left.power, right.power) };
+    return node;
+}
+
+void ChunkHashTree::rebuild(const std::vector<Node>& leaves)
+{
+    m_chunkCount = leaves.size();
+    m_capacity = 1;
+    while (m_capacity < m_chunkCount)
+    {
+        m_capacity *= 2;
+    }
+
+    // Пустые листья (хеш 0, множитель 1) не влияют на результат
+    Node empty = { 0, 1 };
+    m_tree.assign(2 * m_capacity, empty);
+    for (size_t i = 0; i < m_chunkCount; ++i)
+    {
+        m_tree[m_capacity + i] = leaves[i];
+    }
+    for (size_t i = m_capacity - 1; i > 0; --i)
+    {
+        m_tree[i] = combine(m_tree[2 * i], m_tree[2 * i + 1]);
+    }
+}
+
+void ChunkHashTree::updateLeaf(size_t index, const Node& leaf)
+{
+    size_t i = m_capacity + index;
+    m_tree[i] = leaf;
+    for (i /= 2; i > 0; i /= 2)
+    {
+        m_tree[i] = combine(m_tree[2 * i], m_tree[2 * i + 1]);
+    }
+}
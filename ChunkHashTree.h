@@ -0,0 +1,114 @@
+#pragma once
+
+#include "TextChangeTracker.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Хеш текста документа, поддерживаемый по блокам
+ *
+ * Для каждого блока ChunkedText хранится полиномиальный хеш по модулю
+ * 2^61-1; хеши блоков объединяются в дереве отрезков, поэтому после правки
+ * внутри блока хеш всего текста пересчитывается за O(log n). Хеш не зависит
+ * от того, как текст разбит на блоки, и позволяет точно определить, совпадает
+ * ли текст с сохраненной версией (ввод и удаление одного символа не делают
+ * документ измененным). Класс не зависит от WinAPI.
+ */
+class ChunkHashTree : public ITextChangeListener
+{
+public:
+    /**
+     * @brief Отпечаток текста
+     */
+    struct Digest
+    {
+        uint64_t hash;      ///< Полиномиальный хеш текста
+        size_t length;      ///< Длина текста в символах
+    };
+
+    ChunkHashTree();
+
+    void onTextReset(const ChunkedText& text) override;
+    void onTextEdited(const ChunkedText& text, const TextEdit& edit, const ChunkChange& change) override;
+
+    /**
+     * @brief Получить отпечаток текущего текста
+     * @return Отпечаток
+     */
+    Digest digest() const;
+
+    /**
+     * @brief Запомнить текущий текст как совпадающий с файлом на диске
+     */
+    void markSaved();
+
+    /**
+     * @brief Забыть сохраненную версию (документ изменен до следующего сохранения)
+     */
+    void markUnsaved();
+
+    /**
+     * @brief Получить отпечаток сохраненной версии
+     * @param saved Отпечаток
+     * @return false если сохраненная версия неизвестна
+     */
+    bool getSavedDigest(Digest& saved) const;
+
+    /**
+     * @brief Установить отпечаток сохраненной версии (при переключении документов)
+     * @param saved Отпечаток
+     */
+    void setSavedDigest(const Digest& saved);
+
+    /**
+     * @brief Отличается ли текст от сохраненной версии
+     * @return true если текст изменен или сохраненная версия неизвестна
+     */
+    bool isModified() const;
+
+    /**
+     * @brief Вычислить отпечаток строки целиком (совпадает с отпечатком дерева)
+     * @param text Указатель на текст
+     * @param length Длина текста
+     * @return Отпечаток
+     */
+    static Digest computeDigest(const wchar_t* text, size_t length);
+
+private:
+    /**
+     * @brief Хеш фрагмента и BASE^длина (для приписывания справа)
+     */
+    struct Node
+    {
+        uint64_t hash;
+        uint64_t power;
+    };
+
+    std::vector<Node> m_tree;   ///< Дерево отрезков (листья с индекса m_capacity)
+    size_t m_capacity;          ///< Число листьев (степень двойки)
+    size_t m_chunkCount;        ///< Число блоков текста
+    size_t m_length;            ///< Длина текста
+    Digest m_saved;             ///< Отпечаток сохраненной версии
+    bool m_hasSaved;            ///< Сохраненная версия известна
+
+    /**
+     * @brief Хеш блока текста
+     */
+    static Node hashChunk(const std::wstring& chunk);
+
+    /**
+     * @brief Объединить хеши соседних фрагментов
+     */
+    static Node combine(const Node& left, const Node& right);
+
+    /**
+     * @brief Перестроить дерево по хешам блоков
+     * @param leaves Хеши блоков по порядку
+     */
+    void rebuild(const std::vector<Node>& leaves);
+
+    /**
+     * @brief Заменить хеш блока и пересчитать путь до корня
+     */
+    void updateLeaf(size_t index, const Node& leaf);
+};
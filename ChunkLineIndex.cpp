@@ -0,0 +1,141 @@
+#include "ChunkLineIndex.h"
+#include <algorithm>
+
+ChunkLineIndex::ChunkLineIndex()
+    : m_lineFeedCount(0)
+{
+    m_tree.assign(1, 0);
+}
+
+void ChunkLineIndex::onTextReset(const ChunkedText& text)
+{
+    m_counts.resize(text.chunkCount());
+    for (size_t i = 0; i < text.chunkCount(); ++i)
+    {
+        m_counts[i] = countLineFeeds(text.chunkText(i));
+    }
+    rebuildIndex();
+}
+
+void ChunkLineIndex::onTextEdited(const ChunkedText& text, const TextEdit& edit, const ChunkChange& change)
+{
+    (void)edit;
+
+    if (change.removedChunks == change.insertedChunks)
+    {
+        // Структура не изменилась - обновляем дерево по затронутым блокам
+        for (size_t i = 0; i < change.insertedChunks; ++i)
+        {
+            size_t index = change.firstChunk + i;
+            size_t count = countLineFeeds(text.chunkText(index));
+            size_t oldCount = m_counts[index];
+            m_counts[index] = count;
+            m_lineFeedCount = m_lineFeedCount - oldCount + count;
+            for (size_t j = index + 1; j < m_tree.size(); j += j & (~j + 1))
+            {
+                m_tree[j] = m_tree[j] - oldCount + count;
+            }
+        }
+        return;
+    }
+
+    std::vector<size_t> inserted(change.insertedChunks);
+    for (size_t i = 0; i < change.insertedChunks; ++i)
+    {
+        inserted[i] = countLineFeeds(text.chunkText(change.firstChunk + i));
+    }
+    m_counts.erase(m_counts.begin() + change.firstChunk, m_counts.begin() + change.firstChunk + change.removedChunks);
+    m_counts.insert(m_counts.begin() + change.firstChunk, inserted.begin(), inserted.end());
+    rebuildIndex();
+}
+
+size_t ChunkLineIndex::lineCount() const
+{
+    return m_lineFeedCount + 1;
+}
+
+size_t ChunkLineIndex::lineStart(const ChunkedText& text, size_t line) const
+{
+    if (line == 0 || m_counts.empty())
+    {
+        return 0;
+    }
+    if (line > m_lineFeedCount)
+    {
+        line = m_lineFeedCount;
+    }
+
+    // Спуск по дереву: последний блок, до которого меньше line переводов строки
+    size_t step = 1;
+    while (step * 2 <= m_counts.size())
+    {
+        step *= 2;
+    }
+    size_t position = 0;
+    size_t remaining = line;
+    for (; step > 0; step /= 2)
+    {
+        if (position + step <= m_counts.size() && m_tree[position + step] < remaining)
+        {
+            position += step;
+            remaining -= m_tree[position];
+        }
+    }
+
+    // В блоке position лежит remaining-й из его переводов строки
+    const std::wstring& chunk = text.chunkText(position);
+    size_t inner = 0;
+    for (; inner < chunk.size(); ++inner)
+    {
+        if (chunk[inner] == L'\n' && --remaining == 0)
+        {
+            break;
+        }
+    }
+    return text.chunkOffset(position) + inner + 1;
+}
+
+size_t ChunkLineIndex::lineOfOffset(const ChunkedText& text, size_t offset) const
+{
+    if (m_counts.empty())
+    {
+        return 0;
+    }
+
+    size_t inner;
+    size_t chunk = text.findChunk(offset, inner);
+    const std::wstring& chunkText = text.chunkText(chunk);
+    return prefix(chunk) + static_cast<size_t>(std::count(chunkText.begin(), chunkText.begin() + inner, L'\n'));
+}
+
+size_t ChunkLineIndex::countLineFeeds(const std::wstring& chunk)
+{
+    return static_cast<size_t>(std::count(chunk.begin(), chunk.end(), L'\n'));
+}
+
+size_t ChunkLineIndex::prefix(size_t index) const
+{
+    size_t sum = 0;
+    for (size_t i = index; i > 0; i -= i & (~i + 1))
+    {
+        sum += m_tree[i];
+    }
+    return sum;
+}
+
+void ChunkLineIndex::rebuildIndex()
+{
+    // Построение дерева Фенвика за O(n)
+    m_tree.assign(m_counts.size() + 1, 0);
+    m_lineFeedCount = 0;
+    for (size_t i = 1; i <= m_counts.size(); ++i)
+    {
+        m_lineFeedCount += m_counts[i - 1];
+        m_tree[i] += m_counts[i - 1];
+        size_t parent = i + (i & (~i + 1));
+        if (parent <= m_counts.size())
+        {
+            m_tree[parent] += m_tree[i];
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "TextChangeTracker.h"
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Индекс логических строк документа по блокам текста
+ *
+ * Для каждого блока ChunkedText хранится число переводов строки, суммы
+ * лежат в дереве Фенвика. Начало строки находится спуском по дереву за
+ * O(log n) и просмотром одного блока (не больше MAX_CHUNK_SIZE символов),
+ * поэтому переход к строке не зависит от длины документа и от переноса по
+ * словам в EDIT-контроле. Правка пересчитывает только затронутые блоки.
+ * Класс не зависит от WinAPI.
+ */
+class ChunkLineIndex : public ITextChangeListener
+{
+public:
+    ChunkLineIndex();
+
+    void onTextReset(const ChunkedText& text) override;
+    void onTextEdited(const ChunkedText& text, const TextEdit& edit, const ChunkChange& change) override;
+
+    /**
+     * @brief Получить количество логических строк
+     * @return Количество строк (не меньше одной)
+     */
+    size_t lineCount() const;
+
+    /**
+     * @brief Получить начало логической строки
+     * @param text Текст, по которому построен индекс
+     * @param line Номер строки (с нуля; больше последней - последняя)
+     * @return Позиция первого символа строки
+     */
+    size_t lineStart(const ChunkedText& text, size_t line) const;
+
+    /**
+     * @brief Получить номер логической строки по позиции
+     * @param text Текст, по которому построен индекс
+     * @param offset Позиция в тексте
+     * @return Номер строки (с нуля)
+     */
+    size_t lineOfOffset(const ChunkedText& text, size_t offset) const;
+
+private:
+    std::vector<size_t> m_counts;   ///< Число переводов строки в блоках
+    std::vector<size_t> m_tree;     ///< Дерево Фенвика по m_counts (1-based)
+    size_t m_lineFeedCount;         ///< Всего переводов строки
+
+    /**
+     * @brief Посчитать переводы строки в блоке
+     */
+    static size_t countLineFeeds(const std::wstring& chunk);
+
+    /**
+     * @brief Префиксная сумма переводов строки в блоках [0, index)
+     */
+    size_t prefix(size_t index) const;
+
+    /**
+     * @brief Перестроить дерево Фенвика
+     */
+    void rebuildIndex();
+};
@@ -0,0 +1,137 @@
+#include "ChunkedPaste.h"
+#include "LineEndingScanner.h"
+#include <cwchar>
+
+ChunkedPaste::ChunkedPaste(wchar_t* output, size_t capacity)
+    : m_output(output)
+    , m_capacity(capacity)
+    , m_length(0)
+    , m_afterReturn(false)
+{
+}
+
+bool ChunkedPaste::append(const wchar_t* text, size_t length)
+{
+    size_t position = 0;
+
+    // "\n" в начале куска завершает пару "\r\n", уже записанную целиком
+    if (m_afterReturn && length > 0 && text[0] == L'\n')
+    {
+        position = 1;
+    }
+    if (length > 0)
+    {
+        m_afterReturn = false;
+    }
+
+    while (position < length)
+    {
+        // Участок без переводов строк копируется целиком
+        size_t runEnd = position;
+        while (runEnd < length && text[runEnd] != L'\n' && text[runEnd] != L'\r')
+        {
+            ++runEnd;
+        }
+        size_t run = runEnd - position;
+        if (run > m_capacity - m_length)
+        {
+            return false;
+        }
+        wmemcpy(m_output + m_length, text + position, run);
+        m_length += run;
+        if (runEnd == length)
+        {
+            break;
+        }
+
+        // Любой перевод строки записывается как "\r\n"
+        if (m_capacity - m_length < 2)
+        {
+            return false;
+        }
+        m_output[m_length++] = L'\r';
+        m_output[m_length++] = L'\n';
+        position = runEnd + 1;
+        if (text[runEnd] == L'\r')
+        {
+            if (position == length)
+            {
+                m_afterReturn = true;
+            }
+            else if (text[position] == L'\n')
+            {
+                ++position;
+            }
+        }
+    }
+    return true;
+}
+
+size_t ChunkedPaste::length() const
+{
+    return m_length;
+}
+
+size_t ChunkedPaste::measure(const wchar_t* text, size_t length)
+{
+    // Для 16-битного wchar_t (Windows) подходит векторный подсчет по байтам
+    LineEndingScanner::Counts counts = sizeof(wchar_t) == 2
+        ? LineEndingScanner::scan(text, length * sizeof(wchar_t), 2, false)
+        : LineEndingScanner::scanText(text, length);
+    return length + static_cast<size_t>(LineEndingScanner::expansion(counts));
+}
+
+bool ChunkedPaste::insert(const wchar_t* document, size_t documentLength, size_t start, size_t end,
+                          const wchar_t* text, size_t length, wchar_t* output, size_t capacity,
+                          const Progress& progress)
+{
+    size_t suffix = documentLength - end;
+    size_t total = start + length + suffix;
+    if (capacity < start + suffix + 1)
+    {
+        return false;
+    }
+    size_t done = 0;
+
+    // Текст документа до и после вставки тоже копируется кусками, чтобы
+    // ход работы обновлялся и отмена срабатывала без задержки
+    for (size_t offset = 0; offset < start; offset += CHUNK_SIZE)
+    {
+        size_t count = start - offset < CHUNK_SIZE ? start - offset : CHUNK_SIZE;
+        wmemcpy(output + offset, document + offset, count);
+        done += count;
+        if (progress && !progress(done, total))
+        {
+            return false;
+        }
+    }
+
+    ChunkedPaste paste(output + start, capacity - start - suffix - 1);
+    for (size_t offset = 0; offset < length; offset += CHUNK_SIZE)
+    {
+        size_t count = length - offset < CHUNK_SIZE ? length - offset : CHUNK_SIZE;
+        if (!paste.append(text + offset, count))
+        {
+            return false;
+        }
+        done += count;
+        if (progress && !progress(done, total))
+        {
+            return false;
+        }
+    }
+
+    wchar_t* tail = output + start + paste.length();
+    for (size_t offset = 0; offset < suffix; offset += CHUNK_SIZE)
+    {
+        size_t count = suffix - offset < CHUNK_SIZE ? suffix - offset : CHUNK_SIZE;
+        wmemcpy(tail + offset, document + end + offset, count);
+        done += count;
+        if (progress && !progress(done, total))
+        {
+            return false;
+        }
+    }
+    tail[suffix] = L'\0';
+    return true;
+}
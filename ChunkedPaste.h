@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+/**
+ * @brief Вставка большого текста в документ одной правкой
+ *
+ * Вставляемый текст (например, из буфера обмена) приводится к переводам
+ * строк "\r\n" по кускам и пишется прямо в заранее выделенный буфер нового
+ * текста документа, без промежуточной полной копии. Длина результата
+ * известна заранее (measure), поэтому буфер выделяется один раз.
+ * Источник может поступать кусками произвольной длины (append), в том
+ * числе после перекодирования; "\r" на границе кусков обрабатывается
+ * правильно. Не зависит от WinAPI.
+ */
+class ChunkedPaste
+{
+public:
+    static const size_t CHUNK_SIZE = 1024 * 1024;   ///< Символов в одном куске
+
+    /**
+     * @brief Ход работы: обработано done из total символов; false - отменить
+     */
+    typedef std::function<bool(size_t done, size_t total)> Progress;
+
+    /**
+     * @brief Конструктор
+     * @param output Буфер для вставляемого текста
+     * @param capacity Размер буфера в символах
+     */
+    ChunkedPaste(wchar_t* output, size_t capacity);
+
+    /**
+     * @brief Дописать кусок вставляемого текста, приведя переводы строк к CRLF
+     * @param text Кусок текста
+     * @param length Длина куска
+     * @return false если буфер переполнен
+     */
+    bool append(const wchar_t* text, size_t length);
+
+    /**
+     * @brief Получить длину записанного текста
+     * @return Количество символов
+     */
+    size_t length() const;
+
+    /**
+     * @brief Посчитать длину текста после приведения переводов строк к CRLF
+     * @param text Текст
+     * @param length Длина текста
+     * @return Длина результата
+     */
+    static size_t measure(const wchar_t* text, size_t length);
+
+    /**
+     * @brief Собрать текст документа с заменой фрагмента на вставку
+     *
+     * В output пишутся document[0, start), вставка с переводами строк CRLF,
+     * document[end, documentLength) и завершающий нуль.
+     * @param document Текущий текст документа
+     * @param documentLength Длина текста документа
+     * @param start Начало заменяемого фрагмента (выделения)
+     * @param end Конец заменяемого фрагмента
+     * @param text Вставляемый текст
+     * @param length Длина вставляемого текста
+     * @param output Буфер результата
+     * @param capacity Размер буфера: не меньше
+     *        start + measure(text, length) + (documentLength - end) + 1
+     * @param progress Ход работы (может быть пустым)
+     * @return false если сборка отменена или буфер мал
+     */
+    static bool insert(const wchar_t* document, size_t documentLength, size_t start, size_t end,
+                       const wchar_t* text, size_t length, wchar_t* output, size_t capacity,
+                       const Progress& progress);
+
+private:
+    wchar_t* m_output;          ///< Буфер результата
+    size_t m_capacity;          ///< Размер буфера
+    size_t m_length;            ///< Записано символов
+    bool m_afterReturn;         ///< Предыдущий кусок закончился на "\r"
+};
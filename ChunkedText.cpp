@@ -0,0 +1,269 @@
+#include "ChunkedText.h"
+#include <algorithm>
+#include <utility>
+
+ChunkedText::ChunkedText()
+    : m_length(0)
+{
+}
+
+void ChunkedText::assign(const wchar_t* text, size_t length)
+{
+    m_chunks.clear();
+    splitIntoChunks(text, length, m_chunks);
+    m_length = length;
+    rebuildIndex();
+}
+
+size_t ChunkedText::length() const
+{
+    return m_length;
+}
+
+size_t ChunkedText::chunkCount() const
+{
+    return m_chunks.size();
+}
+
+const std::wstring& ChunkedText::chunkText(size_t index) const
+{
+    return *m_chunks[index];
+}
+
+ChunkedText::ChunkPtr ChunkedText::chunk(size_t index) const
+{
+    return m_chunks[index];
+}
+
+size_t ChunkedText::chunkOffset(size_t index) const
+{
+    // Префиксная сумма длин блоков [0, index)
+    size_t sum = 0;
+    for (size_t i = index; i > 0; i -= i & (~i + 1))
+    {
+        sum += m_tree[i];
+    }
+    return sum;
+}
+
+size_t ChunkedText::findChunk(size_t offset, size_t& innerOffset) const
+{
+    if (m_chunks.empty())
+    {
+        innerOffset = 0;
+        return 0;
+    }
+    if (offset >= m_length)
+    {
+        innerOffset = m_chunks.back()->size();
+        return m_chunks.size() - 1;
+    }
+
+    // Спуск по дереву Фенвика: ищем последний блок, начало которого <= offset
+    size_t position = 0;
+    size_t remaining = offset;
+    size_t step = 1;
+    while (step * 2 <= m_chunks.size())
+    {
+        step *= 2;
+    }
+    for (; step > 0; step /= 2)
+    {
+        size_t next = position + step;
+        if (next <= m_chunks.size() && m_tree[next] <= remaining)
+        {
+            position = next;
+            remaining -= m_tree[next];
+        }
+    }
+
+    innerOffset = remaining;
+    return position;
+}
+
+wchar_t ChunkedText::charAt(size_t offset) const
+{
+    size_t inner = 0;
+    size_t index = findChunk(offset, inner);
+    return (*m_chunks[index])[inner];
+}
+
+void ChunkedText::appendRange(size_t offset, size_t count, std::wstring& output) const
+{
+    if (count == 0 || offset >= m_length)
+    {
+        return;
+    }
+    count = std::min(count, m_length - offset);
+
+    size_t inner = 0;
+    size_t index = findChunk(offset, inner);
+    while (count > 0 && index < m_chunks.size())
+    {
+        const std::wstring& chunk = *m_chunks[index];
+        size_t take = std::min(count, chunk.size() - inner);
+        output.append(chunk, inner, take);
+        count -= take;
+        inner = 0;
+        ++index;
+    }
+}
+
+std::wstring ChunkedText::substr(size_t offset, size_t count) const
+{
+    std::wstring result;
+    appendRange(offset, count, result);
+    return result;
+}
+
+std::wstring ChunkedText::toString() const
+{
+    std::wstring result;
+    result.reserve(m_length);
+    for (size_t i = 0; i < m_chunks.size(); ++i)
+    {
+        result += *m_chunks[i];
+    }
+    return result;
+}
+
+ChunkChange ChunkedText::replace(size_t offset, size_t removeCount, const wchar_t* text, size_t textLength)
+{
+    ChunkChange change = { 0, 0, 0 };
+    offset = std::min(offset, m_length);
+    removeCount = std::min(removeCount, m_length - offset);
+
+    if (m_chunks.empty())
+    {
+        splitIntoChunks(text, textLength, m_chunks);
+        m_length = textLength;
+        rebuildIndex();
+        change.insertedChunks = m_chunks.size();
+        return change;
+    }
+
+    // Определяем диапазон затрагиваемых блоков
+    size_t firstInner = 0;
+    size_t first = findChunk(offset, firstInner);
+    size_t lastInner = 0;
+    size_t last = findChunk(offset + removeCount, lastInner);
+
+    // Новые блоки собираются из частей без промежуточной строки: начало
+    // первого блока, вставляемый текст, конец последнего блока
+    Segment segments[4] = {
+        { m_chunks[first]->data(), firstInner },
+        { text, textLength },
+        { m_chunks[last]->data() + lastInner, m_chunks[last]->size() - lastInner },
+        { nullptr, 0 }
+    };
+    size_t mergedLength = firstInner + textLength + segments[2].length;
+
+    // Слишком маленький блок присоединяем к соседнему
+    if (mergedLength < TARGET_CHUNK_SIZE / 4 && last + 1 < m_chunks.size() &&
+        mergedLength + m_chunks[last + 1]->size() <= MAX_CHUNK_SIZE)
+    {
+        ++last;
+        segments[3].data = m_chunks[last]->data();
+        segments[3].length = m_chunks[last]->size();
+    }
+
+    std::vector<ChunkPtr> pieces;
+    splitIntoChunks(segments, 4, pieces);
+
+    size_t removedChunks = last - first + 1;
+    m_length = m_length - removeCount + textLength;
+
+    if (pieces.size() == removedChunks)
+    {
+        // Структура не изменилась - точечно обновляем дерево смещений
+        for (size_t i = 0; i < pieces.size(); ++i)
+        {
+            size_t oldLength = m_chunks[first + i]->size();
+            m_chunks[first + i] = pieces[i];
+            updateIndex(first + i, oldLength, pieces[i]->size());
+        }
+    }
+    else
+    {
+        m_chunks.erase(m_chunks.begin() + first, m_chunks.begin() + last + 1);
+        m_chunks.insert(m_chunks.begin() + first, pieces.begin(), pieces.end());
+        rebuildIndex();
+    }
+
+    change.firstChunk = first;
+    change.removedChunks = removedChunks;
+    change.insertedChunks = pieces.size();
+    return change;
+}
+
+void ChunkedText::splitIntoChunks(const wchar_t* text, size_t length, std::vector<ChunkPtr>& output)
+{
+    Segment segment = { text, length };
+    splitIntoChunks(&segment, 1, output);
+}
+
+void ChunkedText::splitIntoChunks(const Segment* segments, size_t segmentCount, std::vector<ChunkPtr>& output)
+{
+    size_t length = 0;
+    for (size_t i = 0; i < segmentCount; ++i)
+    {
+        length += segments[i].length;
+    }
+    if (length == 0)
+    {
+        return;
+    }
+
+    // Делим на равные части не больше целевого размера
+    size_t count = (length + TARGET_CHUNK_SIZE - 1) / TARGET_CHUNK_SIZE;
+    if (length <= MAX_CHUNK_SIZE)
+    {
+        count = 1;
+    }
+    size_t pieceSize = (length + count - 1) / count;
+
+    // Часть может начинаться в одном отрезке и заканчиваться в другом
+    size_t segment = 0;
+    size_t inner = 0;
+    for (size_t start = 0; start < length; start += pieceSize)
+    {
+        size_t size = std::min(pieceSize, length - start);
+        std::wstring piece;
+        piece.reserve(size);
+        while (piece.size() < size)
+        {
+            size_t count = std::min(size - piece.size(), segments[segment].length - inner);
+            piece.append(segments[segment].data + inner, count);
+            inner += count;
+            if (inner == segments[segment].length)
+            {
+                ++segment;
+                inner = 0;
+            }
+        }
+        output.push_back(std::make_shared<const std::wstring>(std::move(piece)));
+    }
+}
+
+void ChunkedText::rebuildIndex()
+{
+    // Построение дерева Фенвика за O(n)
+    m_tree.assign(m_chunks.size() + 1, 0);
+    for (size_t i = 1; i <= m_chunks.size(); ++i)
+    {
+        m_tree[i] += m_chunks[i - 1]->size();
+        size_t parent = i + (i & (~i + 1));
+        if (parent <= m_chunks.size())
+        {
+            m_tree[parent] += m_tree[i];
+        }
+    }
+}
+
+void ChunkedText::updateIndex(size_t index, size_t oldLength, size_t newLength)
+{
+    for (size_t i = index + 1; i <= m_chunks.size(); i += i & (~i + 1))
+    {
+        m_tree[i] = m_tree[i] - oldLength + newLength;
+    }
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Описание структурного изменения списка блоков
+ *
+ * Блоки [firstChunk, firstChunk + removedChunks) заменены блоками
+ * [firstChunk, firstChunk + insertedChunks).
+ */
+struct ChunkChange
+{
+    size_t firstChunk;      ///< Индекс первого затронутого блока
+    size_t removedChunks;   ///< Количество удаленных блоков
+    size_t insertedChunks;  ///< Количество вставленных блоков
+};
+
+/**
+ * @brief Текст документа, разбитый на неизменяемые блоки
+ *
+ * Каждый блок - неизменяемая строка под shared_ptr, поэтому копия
+ * ChunkedText (снимок) стоит O(число блоков) и не копирует текст.
+ * Правка пересоздает только затронутые блоки, смещения блоков
+ * хранятся в дереве Фенвика и ищутся за O(log n).
+ * Класс не зависит от WinAPI.
+ */
+class ChunkedText
+{
+public:
+    typedef std::shared_ptr<const std::wstring> ChunkPtr;
+
+    static const size_t TARGET_CHUNK_SIZE = 4096;   ///< Желаемый размер блока (символов)
+    static const size_t MAX_CHUNK_SIZE = 8192;      ///< Максимальный размер блока
+
+    ChunkedText();
+
+    /**
+     * @brief Заменить весь текст
+     * @param text Указатель на текст
+     * @param length Длина текста в символах
+     */
+    void assign(const wchar_t* text, size_t length);
+
+    /**
+     * @brief Получить длину текста
+     * @return Количество символов
+     */
+    size_t length() const;
+
+    /**
+     * @brief Получить количество блоков
+     * @return Количество блоков
+     */
+    size_t chunkCount() const;
+
+    /**
+     * @brief Получить текст блока
+     * @param index Индекс блока
+     * @return Ссылка на неизменяемый текст блока
+     */
+    const std::wstring& chunkText(size_t index) const;
+
+    /**
+     * @brief Получить блок для совместного владения
+     * @param index Индекс блока
+     * @return Указатель на неизменяемый блок
+     */
+    ChunkPtr chunk(size_t index) const;
+
+    /**
+     * @brief Получить смещение начала блока в документе
+     * @param index Индекс блока
+     * @return Смещение в символах
+     */
+    size_t chunkOffset(size_t index) const;
+
+    /**
+     * @brief Найти блок, содержащий позицию
+     * @param offset Позиция в документе (0..length)
+     * @param innerOffset Позиция внутри найденного блока
+     * @return Индекс блока; для позиции length - последний блок
+     */
+    size_t findChunk(size_t offset, size_t& innerOffset) const;
+
+    /**
+     * @brief Получить символ по позиции
+     * @param offset Позиция (меньше length)
+     * @return Символ
+     */
+    wchar_t charAt(size_t offset) const;
+
+    /**
+     * @brief Дописать фрагмент текста в строку
+     * @param offset Начало фрагмента
+     * @param count Длина фрагмента
+     * @param output Строка-приемник
+     */
+    void appendRange(size_t offset, size_t count, std::wstring& output) const;
+
+    /**
+     * @brief Получить фрагмент текста
+     * @param offset Начало фрагмента
+     * @param count Длина фрагмента
+     * @return Фрагмент текста
+     */
+    std::wstring substr(size_t offset, size_t count) const;
+
+    /**
+     * @brief Собрать весь текст в одну строку
+     * @return Полный текст
+     */
+    std::wstring toString() const;
+
+    /**
+     * @brief Заменить фрагмент текста
+     * @param offset Начало заменяемого фрагмента
+     * @param removeCount Длина заменяемого фрагмента
+     * @param text Вставляемый текст
+     * @param textLength Длина вставляемого текста
+     * @return Описание изменения списка блоков
+     */
+    ChunkChange replace(size_t offset, size_t removeCount, const wchar_t* text, size_t textLength);
+
+private:
+    std::vector<ChunkPtr> m_chunks;     ///< Неизменяемые блоки текста
+    std::vector<size_t> m_tree;         ///< Дерево Фенвика по длинам блоков (1-based)
+    size_t m_length;                    ///< Общая длина текста
+
+    /**
+     * @brief Разбить строку на блоки и добавить их в вектор
+     * @param text Указатель на текст
+     * @param length Длина текста
+     * @param output Вектор-приемник
+     */
+    static void splitIntoChunks(const wchar_t* text, size_t length, std::vector<ChunkPtr>& output);
+
+    /**
+     * @brief Отрезок текста, из которого собираются блоки
+     */
+    struct Segment
+    {
+        const wchar_t* data;    ///< Указатель на текст
+        size_t length;          ///< Длина текста
+    };
+
+    /**
+     * @brief Разбить на блоки текст, составленный из нескольких отрезков
+     * @param segments Отрезки текста по порядку
+     * @param segmentCount Количество отрезков
+     * @param output Вектор-приемник
+     */
+    static void splitIntoChunks(const Segment* segments, size_t segmentCount, std::vector<ChunkPtr>& output);
+
+    /**
+     * @brief Перестроить дерево смещений
+     */
+    void rebuildIndex();
+
+    /**
+     * @brief Изменить длину блока в дереве смещений
+     * @param index Индекс блока
+     * @param oldLength Прежняя длина
+     * @param newLength Новая длина
+     */
+    void updateIndex(size_t index, size_t oldLength, size_t newLength);
+};
@@ -0,0 +1,797 @@
+#include "CompareView.h"
+
+namespace
+{
+    const WCHAR COMPARE_CLASS_NAME[] = L"CompareView";
+    const int WHEEL_LINES = 3;                  ///< Строк на один шаг колеса мыши
+    const int HORIZONTAL_PAGE_COLUMNS = 16;     ///< Столбцов на шаг горизонтальной прокрутки
+    const int DIVIDER_WIDTH = 4;                ///< Ширина разделителя колонок
+    const int TAB_WIDTH = 4;                    ///< Пробелов на символ табуляции
+    const COLORREF CHANGED_COLOR = RGB(255, 244, 196);  ///< Измененная строка
+    const COLORREF DELETED_COLOR = RGB(255, 220, 220);  ///< Удаленная строка
+    const COLORREF INSERTED_COLOR = RGB(214, 245, 214); ///< Добавленная строка
+    const COLORREF MISSING_COLOR = RGB(232, 232, 232);  ///< Строки нет с этой стороны
+}
+
+CompareView::CompareView(HINSTANCE hInstance)
+    : m_hInstance(hInstance)
+    , m_hWnd(NULL)
+    , m_hFont(NULL)
+    , m_textColor(RGB(0, 0, 0))
+    , m_backgroundColor(RGB(255, 255, 255))
+    , m_lineHeight(16)
+    , m_charWidth(8)
+    , m_rowCount(0)
+    , m_firstRow(0)
+    , m_firstColumn(0)
+    , m_maxColumns(0)
+    , m_numberDigits(1)
+    , m_currentBlock(NO_BLOCK)
+    , m_cancel(false)
+    , m_processedLines(0)
+    , m_totalLines(0)
+    , m_isComparing(FALSE)
+    , m_isCanceled(FALSE)
+    , m_generation(0)
+{
+}
+
+CompareView::~CompareView()
+{
+    cancelCompare();
+    if (m_hWnd)
+    {
+        DestroyWindow(m_hWnd);
+        m_hWnd = NULL;
+    }
+}
+
+BOOL CompareView::compare(HWND hOwner, const std::wstring& oldTitle, std::wstring& oldText,
+                          const std::wstring& newTitle, std::wstring& newText)
+{
+    cancelCompare();
+    if (!m_hWnd && !create(hOwner))
+    {
+        return FALSE;
+    }
+
+    m_oldTitle = oldTitle;
+    m_newTitle = newTitle;
+    m_oldText.swap(oldText);
+    m_newText.swap(newText);
+    m_hunks.clear();
+    m_blocks.clear();
+    m_oldStarts.clear();
+    m_newStarts.clear();
+    m_rowCount = 0;
+    m_firstRow = 0;
+    m_firstColumn = 0;
+    m_maxColumns = 0;
+    m_currentBlock = NO_BLOCK;
+    m_processedLines = 0;
+    m_totalLines = 0;
+    m_cancel = false;
+    m_isCanceled = FALSE;
+    m_isComparing = TRUE;
+    UINT generation = ++m_generation;
+
+    // Пока идет сравнение, поток владеет текстами и результатами; окно только
+    // показывает ход работы и узнает о завершении из сообщения
+    HWND hWnd = m_hWnd;
+    m_worker = std::thread([this, hWnd, generation]() {
+        bool isDone = LineDiff::compute(m_oldText.c_str(), m_oldText.size(), m_newText.c_str(), m_newText.size(),
+            m_hunks, LineDiff::ALGORITHM_HISTOGRAM, [this](size_t processedLines, size_t totalLines)
+            {
+                m_processedLines = processedLines;
+                m_totalLines = totalLines;
+                return !m_cancel;
+            });
+        if (isDone)
+        {
+            findLineStarts(m_oldText, m_oldStarts);
+            findLineStarts(m_newText, m_newStarts);
+            buildBlocks();
+        }
+        PostMessage(hWnd, WM_COMPARE_DONE, (WPARAM)generation, isDone ? 1 : 0);
+    });
+
+    SetTimer(m_hWnd, TIMER_PROGRESS, PROGRESS_REFRESH_INTERVAL, NULL);
+    updateTitle();
+    updateScrollBars();
+    InvalidateRect(m_hWnd, NULL, TRUE);
+    ShowWindow(m_hWnd, SW_SHOW);
+    SetForegroundWindow(m_hWnd);
+    return TRUE;
+}
+
+HWND CompareView::getHandle() const
+{
+    return m_hWnd;
+}
+
+void CompareView::setFont(HFONT hFont)
+{
+    m_hFont = hFont;
+    updateMetrics();
+    updateScrollBars();
+    if (m_hWnd)
+    {
+        InvalidateRect(m_hWnd, NULL, TRUE);
+    }
+}
+
+void CompareView::setColors(COLORREF textColor, COLORREF backgroundColor)
+{
+    m_textColor = textColor;
+    m_backgroundColor = backgroundColor;
+    if (m_hWnd)
+    {
+        InvalidateRect(m_hWnd, NULL, TRUE);
+    }
+}
+
+BOOL CompareView::create(HWND hOwner)
+{
+    WNDCLASSEXW wcex = {};
+    wcex.cbSize = sizeof(WNDCLASSEX);
+    wcex.style = CS_HREDRAW | CS_VREDRAW;
+    wcex.lpfnWndProc = compareProc;
+    wcex.hInstance = m_hInstance;
+    wcex.hCursor = LoadCursor(nullptr, IDC_ARROW);
+    wcex.lpszClassName = COMPARE_CLASS_NAME;
+
+    if (!RegisterClassExW(&wcex) && GetLastError() != ERROR_CLASS_ALREADY_EXISTS)
+    {
+        return FALSE;
+    }
+
+    // Отдельное окно верхнего уровня, принадлежащее главному окну
+    m_hWnd = CreateWindowExW(
+        0,
+        COMPARE_CLASS_NAME,
+        L"",
+        WS_OVERLAPPEDWINDOW | WS_VSCROLL | WS_HSCROLL,
+        CW_USEDEFAULT, CW_USEDEFAULT, 1000, 700,
+        hOwner,
+        NULL,
+        m_hInstance,
+        this
+    );
+    if (!m_hWnd)
+    {
+        return FALSE;
+    }
+
+    updateMetrics();
+    return TRUE;
+}
+
+void CompareView::cancelCompare()
+{
+    m_cancel = true;
+    if (m_worker.joinable())
+    {
+        m_worker.join();
+    }
+    m_isComparing = FALSE;
+}
+
+void CompareView::findLineStarts(const std::wstring& text, std::vector<size_t>& starts)
+{
+    starts.clear();
+    starts.push_back(0);
+    size_t start = 0;
+    while (start < text.size())
+    {
+        size_t lineFeed = text.find(L'\n', start);
+        start = lineFeed == std::wstring::npos ? text.size() : lineFeed + 1;
+        starts.push_back(start);
+    }
+}
+
+void CompareView::buildBlocks()
+{
+    // Общие строки идут одним блоком, каждый фрагмент отличий - отдельным;
+    // в блоке отличий строк окна столько, сколько строк у большей стороны
+    m_blocks.clear();
+    size_t row = 0;
+    size_t oldLine = 0;
+    size_t newLine = 0;
+    for (size_t i = 0; i < m_hunks.size(); ++i)
+    {
+        const LineDiff::Hunk& hunk = m_hunks[i];
+        if (hunk.oldLine > oldLine)
+        {
+            Block equal = { row, oldLine, newLine, hunk.oldLine - oldLine, hunk.oldLine - oldLine, false };
+            m_blocks.push_back(equal);
+            row += equal.oldCount;
+        }
+
+        Block changed = { row, hunk.oldLine, hunk.newLine, hunk.oldLineCount, hunk.newLineCount, true };
+        m_blocks.push_back(changed);
+        row += hunk.oldLineCount > hunk.newLineCount ? hunk.oldLineCount : hunk.newLineCount;
+        oldLine = hunk.oldLine + hunk.oldLineCount;
+        newLine = hunk.newLine + hunk.newLineCount;
+    }
+
+    size_t oldLineCount = m_oldStarts.size() - 1;
+    if (oldLine < oldLineCount)
+    {
+        Block equal = { row, oldLine, newLine, oldLineCount - oldLine, oldLineCount - oldLine, false };
+        m_blocks.push_back(equal);
+        row += equal.oldCount;
+    }
+    m_rowCount = row;
+}
+
+size_t CompareView::findBlock(size_t row) const
+{
+    size_t low = 0;
+    size_t high = m_blocks.size();
+    while (high - low > 1)
+    {
+        size_t middle = (low + high) / 2;
+        if (m_blocks[middle].firstRow <= row)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+std::wstring CompareView::getLine(const std::wstring& text, const std::vector<size_t>& starts, size_t line)
+{
+    size_t start = starts[line];
+    size_t end = starts[line + 1];
+    while (end > start && (text[end - 1] == L'\n' || text[end - 1] == L'\r'))
+    {
+        --end;
+    }
+
+    std::wstring result;
+    result.reserve(end - start);
+    for (size_t i = start; i < end; ++i)
+    {
+        if (text[i] == L'\t')
+        {
+            result.append(TAB_WIDTH, L' ');
+        }
+        else
+        {
+            result.push_back(text[i]);
+        }
+    }
+    return result;
+}
+
+int CompareView::getPageSize() const
+{
+    RECT rect;
+    if (!m_hWnd || !GetClientRect(m_hWnd, &rect))
+    {
+        return 1;
+    }
+    int page = (rect.bottom - rect.top) / m_lineHeight - 1;
+    return page > 1 ? page : 1;
+}
+
+void CompareView::scrollTo(size_t row)
+{
+    size_t page = static_cast<size_t>(getPageSize());
+    size_t maxFirstRow = m_rowCount > page ? m_rowCount - page : 0;
+    if (row > maxFirstRow)
+    {
+        row = maxFirstRow;
+    }
+
+    if (row != m_firstRow)
+    {
+        m_firstRow = row;
+        InvalidateRect(m_hWnd, NULL, FALSE);
+    }
+    updateScrollBars();
+}
+
+void CompareView::goToChange(BOOL forward)
+{
+    if (m_isComparing || m_blocks.empty())
+    {
+        return;
+    }
+
+    // После перехода поиск идет от выбранного отличия, иначе от верха окна
+    BOOL hasCurrent = m_currentBlock != NO_BLOCK;
+    size_t reference = hasCurrent ? m_blocks[m_currentBlock].firstRow : m_firstRow;
+    size_t found = NO_BLOCK;
+    for (size_t i = 0; i < m_blocks.size(); ++i)
+    {
+        const Block& block = m_blocks[i];
+        if (!block.isChanged)
+        {
+            continue;
+        }
+        if (forward)
+        {
+            if (block.firstRow > reference || (!hasCurrent && block.firstRow == reference))
+            {
+                found = i;
+                break;
+            }
+        }
+        else if (block.firstRow < reference)
+        {
+            found = i;
+        }
+    }
+
+    if (found == NO_BLOCK)
+    {
+        MessageBeep(MB_OK);
+        return;
+    }
+
+    // Отличие показывается в верхней трети окна
+    m_currentBlock = found;
+    size_t margin = static_cast<size_t>(getPageSize() / 3);
+    size_t row = m_blocks[found].firstRow;
+    scrollTo(row > margin ? row - margin : 0);
+    InvalidateRect(m_hWnd, NULL, FALSE);
+}
+
+void CompareView::updateScrollBars()
+{
+    if (!m_hWnd)
+    {
+        return;
+    }
+
+    SCROLLINFO si = {};
+    si.cbSize = sizeof(si);
+    si.fMask = SIF_RANGE | SIF_PAGE | SIF_POS | SIF_DISABLENOSCROLL;
+    si.nMin = 0;
+    si.nMax = static_cast<int>(m_rowCount);
+    si.nPage = static_cast<UINT>(getPageSize());
+    si.nPos = static_cast<int>(m_firstRow);
+    SetScrollInfo(m_hWnd, SB_VERT, &si, TRUE);
+
+    RECT rect;
+    GetClientRect(m_hWnd, &rect);
+    si.nMax = m_maxColumns;
+    si.nPage = static_cast<UINT>((rect.right - rect.left) / 2 / m_charWidth);
+    si.nPos = m_firstColumn;
+    SetScrollInfo(m_hWnd, SB_HORZ, &si, TRUE);
+}
+
+void CompareView::updateMetrics()
+{
+    if (!m_hWnd)
+    {
+        return;
+    }
+
+    HDC hdc = GetDC(m_hWnd);
+    HFONT hOldFont = m_hFont ? (HFONT)SelectObject(hdc, m_hFont) : NULL;
+    TEXTMETRICW tm;
+    if (GetTextMetricsW(hdc, &tm))
+    {
+        m_lineHeight = tm.tmHeight + tm.tmExternalLeading;
+        m_charWidth = tm.tmAveCharWidth;
+    }
+    if (hOldFont)
+    {
+        SelectObject(hdc, hOldFont);
+    }
+    ReleaseDC(m_hWnd, hdc);
+
+    if (m_lineHeight < 1)
+    {
+        m_lineHeight = 1;
+    }
+    if (m_charWidth < 1)
+    {
+        m_charWidth = 1;
+    }
+}
+
+void CompareView::updateTitle()
+{
+    std::wstring title = L"Сравнение: " + m_oldTitle + L" — " + m_newTitle;
+    SetWindowTextW(m_hWnd, title.c_str());
+}
+
+void CompareView::paint(HDC hdc)
+{
+    RECT client;
+    GetClientRect(m_hWnd, &client);
+    HFONT hOldFont = m_hFont ? (HFONT)SelectObject(hdc, m_hFont) : NULL;
+
+    int half = (client.right - client.left - DIVIDER_WIDTH) / 2;
+    RECT leftColumn = { client.left, 0, client.left + half, m_lineHeight };
+    RECT rightColumn = { client.left + half + DIVIDER_WIDTH, 0, client.right, m_lineHeight };
+
+    // Строка заголовков
+    SetTextColor(hdc, GetSysColor(COLOR_BTNTEXT));
+    SetBkColor(hdc, GetSysColor(COLOR_BTNFACE));
+    ExtTextOutW(hdc, leftColumn.left, 0, ETO_OPAQUE | ETO_CLIPPED, &leftColumn,
+        m_oldTitle.c_str(), static_cast<UINT>(m_oldTitle.size()), NULL);
+    ExtTextOutW(hdc, rightColumn.left, 0, ETO_OPAQUE | ETO_CLIPPED, &rightColumn,
+        m_newTitle.c_str(), static_cast<UINT>(m_newTitle.size()), NULL);
+
+    int y = m_lineHeight;
+    if (!m_isComparing && !m_blocks.empty())
+    {
+        // Ширина номеров строк по самому большому номеру
+        size_t maxLine = m_oldStarts.size() > m_newStarts.size() ? m_oldStarts.size() : m_newStarts.size();
+        m_numberDigits = 1;
+        for (size_t value = maxLine; value >= 10; value /= 10)
+        {
+            ++m_numberDigits;
+        }
+
+        size_t blockIndex = findBlock(m_firstRow);
+        size_t row = m_firstRow;
+        for (; row < m_rowCount && y < client.bottom; ++row, y += m_lineHeight)
+        {
+            while (blockIndex + 1 < m_blocks.size() && m_blocks[blockIndex + 1].firstRow <= row)
+            {
+                ++blockIndex;
+            }
+            const Block& block = m_blocks[blockIndex];
+            size_t offset = row - block.firstRow;
+            BOOL hasOld = offset < block.oldCount;
+            BOOL hasNew = offset < block.newCount;
+
+            COLORREF oldBackground = m_backgroundColor;
+            COLORREF newBackground = m_backgroundColor;
+            if (block.isChanged)
+            {
+                oldBackground = !hasOld ? MISSING_COLOR : (hasNew ? CHANGED_COLOR : DELETED_COLOR);
+                newBackground = !hasNew ? MISSING_COLOR : (hasOld ? CHANGED_COLOR : INSERTED_COLOR);
+            }
+
+            leftColumn.top = y;
+            leftColumn.bottom = y + m_lineHeight;
+            rightColumn.top = y;
+            rightColumn.bottom = y + m_lineHeight;
+            paintCell(hdc, leftColumn, m_oldText, m_oldStarts, block.oldLine + offset, hasOld, oldBackground);
+            paintCell(hdc, rightColumn, m_newText, m_newStarts, block.newLine + offset, hasNew, newBackground);
+        }
+    }
+
+    // Остаток колонок и разделитель
+    SetBkColor(hdc, m_backgroundColor);
+    if (y < client.bottom)
+    {
+        RECT rest = { client.left, y, client.right, client.bottom };
+        ExtTextOutW(hdc, 0, 0, ETO_OPAQUE, &rest, L"", 0, NULL);
+    }
+    SetBkColor(hdc, GetSysColor(COLOR_BTNFACE));
+    RECT divider = { client.left + half, 0, client.left + half + DIVIDER_WIDTH, client.bottom };
+    ExtTextOutW(hdc, 0, 0, ETO_OPAQUE, &divider, L"", 0, NULL);
+
+    // Ход сравнения или итог показывается в правом нижнем углу
+    WCHAR status[96];
+    if (m_isComparing)
+    {
+        size_t total = m_totalLines;
+        int percent = total > 0 ? static_cast<int>(m_processedLines * 100 / total) : 0;
+        swprintf_s(status, 96, L" Сравнение: %d%% (Esc - прервать) ", percent);
+    }
+    else if (m_isCanceled)
+    {
+        swprintf_s(status, 96, L" Сравнение прервано ");
+    }
+    else if (m_hunks.empty())
+    {
+        swprintf_s(status, 96, L" Тексты совпадают ");
+    }
+    else
+    {
+        swprintf_s(status, 96, L" Отличий: %u (F8 - следующее, Shift+F8 - предыдущее) ",
+            static_cast<unsigned>(m_hunks.size()));
+    }
+    SIZE size;
+    GetTextExtentPoint32W(hdc, status, static_cast<int>(wcslen(status)), &size);
+    SetTextColor(hdc, m_backgroundColor);
+    SetBkColor(hdc, m_textColor);
+    ExtTextOutW(hdc, client.right - size.cx, client.bottom - size.cy, ETO_OPAQUE, NULL,
+        status, static_cast<UINT>(wcslen(status)), NULL);
+
+    if (hOldFont)
+    {
+        SelectObject(hdc, hOldFont);
+    }
+}
+
+void CompareView::paintCell(HDC hdc, const RECT& rect, const std::wstring& text, const std::vector<size_t>& starts,
+                            size_t line, BOOL hasLine, COLORREF background)
+{
+    SetTextColor(hdc, m_textColor);
+    SetBkColor(hdc, background);
+    if (!hasLine)
+    {
+        ExtTextOutW(hdc, rect.left, rect.top, ETO_OPAQUE, &rect, L"", 0, NULL);
+        return;
+    }
+
+    WCHAR number[32];
+    swprintf_s(number, 32, L"%*u ", m_numberDigits, static_cast<unsigned>(line + 1));
+    std::wstring content = getLine(text, starts, line);
+    if (static_cast<int>(content.size()) > m_maxColumns)
+    {
+        m_maxColumns = static_cast<int>(content.size());
+    }
+
+    // Номер строки не прокручивается по горизонтали
+    std::wstring cell = number;
+    if (static_cast<int>(content.size()) > m_firstColumn)
+    {
+        cell.append(content, static_cast<size_t>(m_firstColumn), std::wstring::npos);
+    }
+    ExtTextOutW(hdc, rect.left, rect.top, ETO_OPAQUE | ETO_CLIPPED, &rect,
+        cell.c_str(), static_cast<UINT>(cell.size()), NULL);
+}
+
+void CompareView::onVScroll(int code)
+{
+    size_t page = static_cast<size_t>(getPageSize());
+    m_currentBlock = NO_BLOCK;
+    switch (code)
+    {
+    case SB_LINEUP:
+        scrollTo(m_firstRow > 0 ? m_firstRow - 1 : 0);
+        break;
+    case SB_LINEDOWN:
+        scrollTo(m_firstRow + 1);
+        break;
+    case SB_PAGEUP:
+        scrollTo(m_firstRow > page ? m_firstRow - page : 0);
+        break;
+    case SB_PAGEDOWN:
+        scrollTo(m_firstRow + page);
+        break;
+    case SB_TOP:
+        scrollTo(0);
+        break;
+    case SB_BOTTOM:
+        scrollTo(m_rowCount);
+        break;
+    case SB_THUMBTRACK:
+    case SB_THUMBPOSITION:
+    {
+        SCROLLINFO si = {};
+        si.cbSize = sizeof(si);
+        si.fMask = SIF_TRACKPOS;
+        GetScrollInfo(m_hWnd, SB_VERT, &si);
+        scrollTo(static_cast<size_t>(si.nTrackPos));
+        break;
+    }
+    }
+}
+
+void CompareView::onHScroll(int code)
+{
+    int column = m_firstColumn;
+    switch (code)
+    {
+    case SB_LINELEFT:
+        column -= 1;
+        break;
+    case SB_LINERIGHT:
+        column += 1;
+        break;
+    case SB_PAGELEFT:
+        column -= HORIZONTAL_PAGE_COLUMNS;
+        break;
+    case SB_PAGERIGHT:
+        column += HORIZONTAL_PAGE_COLUMNS;
+        break;
+    case SB_THUMBTRACK:
+    case SB_THUMBPOSITION:
+    {
+        SCROLLINFO si = {};
+        si.cbSize = sizeof(si);
+        si.fMask = SIF_TRACKPOS;
+        GetScrollInfo(m_hWnd, SB_HORZ, &si);
+        column = si.nTrackPos;
+        break;
+    }
+    }
+
+    if (column > m_maxColumns)
+    {
+        column = m_maxColumns;
+    }
+    if (column < 0)
+    {
+        column = 0;
+    }
+    if (column != m_firstColumn)
+    {
+        m_firstColumn = column;
+        InvalidateRect(m_hWnd, NULL, FALSE);
+        updateScrollBars();
+    }
+}
+
+void CompareView::onKeyDown(WPARAM key)
+{
+    BOOL isControl = (GetKeyState(VK_CONTROL) & 0x8000) != 0;
+    BOOL isShift = (GetKeyState(VK_SHIFT) & 0x8000) != 0;
+    switch (key)
+    {
+    case VK_UP:
+        onVScroll(SB_LINEUP);
+        break;
+    case VK_DOWN:
+        onVScroll(SB_LINEDOWN);
+        break;
+    case VK_PRIOR:
+        onVScroll(SB_PAGEUP);
+        break;
+    case VK_NEXT:
+        onVScroll(SB_PAGEDOWN);
+        break;
+    case VK_LEFT:
+        onHScroll(SB_LINELEFT);
+        break;
+    case VK_RIGHT:
+        onHScroll(SB_LINERIGHT);
+        break;
+    case VK_HOME:
+        if (isControl)
+        {
+            onVScroll(SB_TOP);
+        }
+        m_firstColumn = 0;
+        InvalidateRect(m_hWnd, NULL, FALSE);
+        updateScrollBars();
+        break;
+    case VK_END:
+        if (isControl)
+        {
+            onVScroll(SB_BOTTOM);
+        }
+        break;
+    case VK_F8:
+        goToChange(isShift ? FALSE : TRUE);
+        break;
+    case VK_ESCAPE:
+        // Первое нажатие прерывает сравнение, следующее закрывает окно
+        if (m_isComparing)
+        {
+            m_cancel = true;
+        }
+        else
+        {
+            DestroyWindow(m_hWnd);
+        }
+        break;
+    }
+}
+
+void CompareView::onCompareDone(UINT generation, BOOL isDone)
+{
+    if (generation != m_generation || !m_isComparing)
+    {
+        return;
+    }
+
+    if (m_worker.joinable())
+    {
+        m_worker.join();
+    }
+    KillTimer(m_hWnd, TIMER_PROGRESS);
+    m_isComparing = FALSE;
+    m_isCanceled = !isDone;
+    if (!isDone)
+    {
+        m_hunks.clear();
+        m_blocks.clear();
+        m_rowCount = 0;
+    }
+
+    updateScrollBars();
+    InvalidateRect(m_hWnd, NULL, FALSE);
+    if (!m_hunks.empty())
+    {
+        goToChange(TRUE);
+    }
+}
+
+LRESULT CALLBACK CompareView::compareProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
+{
+    if (message == WM_NCCREATE)
+    {
+        CREATESTRUCTW* cs = (CREATESTRUCTW*)lParam;
+        SetWindowLongPtr(hWnd, GWLP_USERDATA, (LONG_PTR)cs->lpCreateParams);
+        ((CompareView*)cs->lpCreateParams)->m_hWnd = hWnd;
+    }
+
+    CompareView* instance = (CompareView*)GetWindowLongPtr(hWnd, GWLP_USERDATA);
+    if (instance)
+    {
+        return instance->handleMessage(message, wParam, lParam);
+    }
+    return DefWindowProc(hWnd, message, wParam, lParam);
+}
+
+LRESULT CompareView::handleMessage(UINT message, WPARAM wParam, LPARAM lParam)
+{
+    switch (message)
+    {
+    case WM_PAINT:
+    {
+        PAINTSTRUCT ps;
+        HDC hdc = BeginPaint(m_hWnd, &ps);
+        paint(hdc);
+        EndPaint(m_hWnd, &ps);
+        return 0;
+    }
+
+    case WM_ERASEBKGND:
+        // Фон заливается при отрисовке строк
+        return 1;
+
+    case WM_SIZE:
+        updateScrollBars();
+        InvalidateRect(m_hWnd, NULL, FALSE);
+        return 0;
+
+    case WM_VSCROLL:
+        onVScroll(LOWORD(wParam));
+        return 0;
+
+    case WM_HSCROLL:
+        onHScroll(LOWORD(wParam));
+        return 0;
+
+    case WM_KEYDOWN:
+        onKeyDown(wParam);
+        return 0;
+
+    case WM_MOUSEWHEEL:
+    {
+        int delta = GET_WHEEL_DELTA_WPARAM(wParam) / WHEEL_DELTA;
+        size_t rows = static_cast<size_t>(delta < 0 ? -delta : delta) * WHEEL_LINES;
+        m_currentBlock = NO_BLOCK;
+        if (delta > 0)
+        {
+            scrollTo(m_firstRow > rows ? m_firstRow - rows : 0);
+        }
+        else
+        {
+            scrollTo(m_firstRow + rows);
+        }
+        return 0;
+    }
+
+    case WM_TIMER:
+        if (wParam == TIMER_PROGRESS)
+        {
+            InvalidateRect(m_hWnd, NULL, FALSE);
+        }
+        return 0;
+
+    case WM_COMPARE_DONE:
+        onCompareDone((UINT)wParam, lParam != 0);
+        return 0;
+
+    case WM_DESTROY:
+        // Поток сравнения не должен пережить окно, которому пишет
+        cancelCompare();
+        KillTimer(m_hWnd, TIMER_PROGRESS);
+        return 0;
+
+    case WM_NCDESTROY:
+        SetWindowLongPtr(m_hWnd, GWLP_USERDATA, 0);
+        m_hWnd = NULL;
+        return 0;
+    }
+
+    return DefWindowProc(m_hWnd, message, wParam, lParam);
+}
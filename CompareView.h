@@ -0,0 +1,246 @@
+#pragma once
+
+#include "framework.h"
+#include "LineDiff.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Окно сравнения двух текстов (бок о бок)
+ *
+ * Сравнение выполняется в фоновом потоке (LineDiff в режиме гистограммы);
+ * пока оно идет, окно показывает ход работы, а Esc прерывает его. Затем
+ * строки обоих текстов выводятся в две колонки, выровненные по найденным
+ * фрагментам; измененные, удаленные и добавленные строки подсвечиваются.
+ */
+class CompareView
+{
+public:
+    /**
+     * @brief Конструктор
+     * @param hInstance Дескриптор экземпляра приложения
+     */
+    CompareView(HINSTANCE hInstance);
+
+    /**
+     * @brief Деструктор
+     */
+    ~CompareView();
+
+    /**
+     * @brief Сравнить тексты и показать окно
+     *
+     * Тексты забираются у вызывающего кода без копирования. Незавершенное
+     * прежнее сравнение прерывается.
+     * @param hOwner Окно-владелец
+     * @param oldTitle Заголовок левой колонки
+     * @param oldText Левый (старый) текст
+     * @param newTitle Заголовок правой колонки
+     * @param newText Правый (новый) текст
+     * @return FALSE если окно не удалось создать
+     */
+    BOOL compare(HWND hOwner, const std::wstring& oldTitle, std::wstring& oldText,
+                 const std::wstring& newTitle, std::wstring& newText);
+
+    /**
+     * @brief Получить дескриптор окна
+     * @return Дескриптор окна (NULL если окно закрыто)
+     */
+    HWND getHandle() const;
+
+    /**
+     * @brief Установить шрифт
+     * @param hFont Шрифт (принадлежит вызывающему коду)
+     */
+    void setFont(HFONT hFont);
+
+    /**
+     * @brief Установить цвета текста и фона
+     * @param textColor Цвет текста
+     * @param backgroundColor Цвет фона
+     */
+    void setColors(COLORREF textColor, COLORREF backgroundColor);
+
+private:
+    /**
+     * @brief Блок выровненных строк: общие строки или один фрагмент отличий
+     */
+    struct Block
+    {
+        size_t firstRow;    ///< Первая строка окна
+        size_t oldLine;     ///< Первая строка старого текста
+        size_t newLine;     ///< Первая строка нового текста
+        size_t oldCount;    ///< Количество строк старого текста
+        size_t newCount;    ///< Количество строк нового текста
+        bool isChanged;     ///< Блок отличий
+    };
+
+    HINSTANCE m_hInstance;                  ///< Дескриптор экземпляра приложения
+    HWND m_hWnd;                            ///< Окно сравнения
+    HFONT m_hFont;                          ///< Шрифт
+    COLORREF m_textColor;                   ///< Цвет текста
+    COLORREF m_backgroundColor;             ///< Цвет фона
+    int m_lineHeight;                       ///< Высота строки в пикселях
+    int m_charWidth;                        ///< Средняя ширина символа
+
+    std::wstring m_oldTitle;                ///< Заголовок левой колонки
+    std::wstring m_newTitle;                ///< Заголовок правой колонки
+    std::wstring m_oldText;                 ///< Левый текст
+    std::wstring m_newText;                 ///< Правый текст
+    std::vector<size_t> m_oldStarts;        ///< Начала строк левого текста (плюс конец)
+    std::vector<size_t> m_newStarts;        ///< Начала строк правого текста (плюс конец)
+    std::vector<LineDiff::Hunk> m_hunks;    ///< Найденные отличия
+    std::vector<Block> m_blocks;            ///< Блоки выровненных строк
+    size_t m_rowCount;                      ///< Количество строк окна
+    size_t m_firstRow;                      ///< Первая видимая строка
+    int m_firstColumn;                      ///< Первый видимый столбец
+    int m_maxColumns;                       ///< Самая длинная из показанных строк
+    int m_numberDigits;                     ///< Ширина номеров строк (символы)
+    size_t m_currentBlock;                  ///< Блок, выбранный переходом к отличию
+
+    // Фоновое сравнение
+    std::thread m_worker;                   ///< Поток сравнения
+    std::atomic<bool> m_cancel;             ///< Флаг отмены
+    std::atomic<size_t> m_processedLines;   ///< Обработано строк левого текста
+    std::atomic<size_t> m_totalLines;       ///< Всего строк левого текста
+    BOOL m_isComparing;                     ///< Сравнение идет
+    BOOL m_isCanceled;                      ///< Сравнение прервано
+    UINT m_generation;                      ///< Номер сравнения (устаревшие сообщения пропускаются)
+
+    static const UINT TIMER_PROGRESS = 1;               ///< ID таймера хода сравнения
+    static const UINT PROGRESS_REFRESH_INTERVAL = 100;  ///< Интервал обновления (мс)
+    static const UINT WM_COMPARE_DONE = WM_APP + 11;    ///< Сравнение завершено
+    static const size_t NO_BLOCK = static_cast<size_t>(-1);
+
+    /**
+     * @brief Создать окно
+     * @param hOwner Окно-владелец
+     * @return TRUE при успехе
+     */
+    BOOL create(HWND hOwner);
+
+    /**
+     * @brief Прервать сравнение и дождаться потока
+     */
+    void cancelCompare();
+
+    /**
+     * @brief Найти начала строк текста
+     * @param text Текст
+     * @param starts Начала строк (плюс конец текста)
+     */
+    static void findLineStarts(const std::wstring& text, std::vector<size_t>& starts);
+
+    /**
+     * @brief Построить блоки выровненных строк по найденным отличиям
+     */
+    void buildBlocks();
+
+    /**
+     * @brief Найти блок, содержащий строку окна
+     * @param row Строка окна
+     * @return Индекс блока
+     */
+    size_t findBlock(size_t row) const;
+
+    /**
+     * @brief Получить строку текста для вывода (без перевода строки, табуляция заменена пробелами)
+     * @param text Текст
+     * @param starts Начала строк
+     * @param line Номер строки
+     * @return Строка
+     */
+    static std::wstring getLine(const std::wstring& text, const std::vector<size_t>& starts, size_t line);
+
+    /**
+     * @brief Количество строк, помещающихся в окне (без строки заголовков)
+     * @return Количество строк
+     */
+    int getPageSize() const;
+
+    /**
+     * @brief Прокрутить к строке с ограничением диапазона
+     * @param row Первая видимая строка
+     */
+    void scrollTo(size_t row);
+
+    /**
+     * @brief Перейти к следующему или предыдущему отличию
+     * @param forward TRUE - к следующему
+     */
+    void goToChange(BOOL forward);
+
+    /**
+     * @brief Обновить полосы прокрутки
+     */
+    void updateScrollBars();
+
+    /**
+     * @brief Измерить шрифт
+     */
+    void updateMetrics();
+
+    /**
+     * @brief Обновить заголовок окна
+     */
+    void updateTitle();
+
+    /**
+     * @brief Отрисовать окно
+     * @param hdc Контекст устройства
+     */
+    void paint(HDC hdc);
+
+    /**
+     * @brief Отрисовать одну колонку строки окна
+     * @param hdc Контекст устройства
+     * @param rect Область колонки
+     * @param text Текст колонки
+     * @param starts Начала строк текста
+     * @param line Номер строки текста
+     * @param hasLine Строка есть в этой колонке
+     * @param background Цвет фона
+     */
+    void paintCell(HDC hdc, const RECT& rect, const std::wstring& text, const std::vector<size_t>& starts,
+                   size_t line, BOOL hasLine, COLORREF background);
+
+    /**
+     * @brief Обработать вертикальную прокрутку
+     * @param code Код прокрутки
+     */
+    void onVScroll(int code);
+
+    /**
+     * @brief Обработать горизонтальную прокрутку
+     * @param code Код прокрутки
+     */
+    void onHScroll(int code);
+
+    /**
+     * @brief Обработать нажатие клавиши
+     * @param key Код виртуальной клавиши
+     */
+    void onKeyDown(WPARAM key);
+
+    /**
+     * @brief Обработать завершение сравнения
+     * @param generation Номер сравнения
+     * @param isDone FALSE если сравнение прервано
+     */
+    void onCompareDone(UINT generation, BOOL isDone);
+
+    /**
+     * @brief Процедура окна сравнения
+     */
+    static LRESULT CALLBACK compareProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
+
+    /**
+     * @brief Обработать сообщение окна
+     */
+    LRESULT handleMessage(UINT message, WPARAM wParam, LPARAM lParam);
+
+    CompareView(const CompareView&);
+    CompareView& operator=(const CompareView&);
+};
@@ -0,0 +1,97 @@
+#include "ContentHash.h"
+#include <cstring>
+
+namespace
+{
+    const uint64_t PRIME_1 = 0x9E3779B185EBCA87ULL;
+    const uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+
+    inline uint64_t rotateLeft(uint64_t value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    inline uint64_t mix(uint64_t hash, uint64_t word)
+    {
+        hash ^= rotateLeft(word * PRIME_2, 31) * PRIME_1;
+        return rotateLeft(hash, 27) * PRIME_1 + PRIME_2;
+    }
+
+    inline uint64_t mixTail(uint64_t hash, const unsigned char* bytes, size_t size)
+    {
+        uint64_t tail = 0;
+        for (size_t i = 0, shift = 0; i < size; ++i, shift += 8)
+        {
+            tail |= static_cast<uint64_t>(bytes[i]) << shift;
+        }
+        hash = mix(hash, tail);
+
+        // Финальное перемешивание битов
+        hash ^= hash >> 33;
+        hash *= PRIME_2;
+        hash ^= hash >> 29;
+        return hash;
+    }
+}
+
+uint64_t ContentHash::compute(const void* data, size_t size, uint64_t seed)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = seed ^ (PRIME_1 + static_cast<uint64_t>(size));
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        hash = mix(hash, word);
+    }
+
+    // Хвост меньше 8 байт
+    return mixTail(hash, bytes + i, size - i);
+}
+
+ContentHash::ContentHash(uint64_t totalSize, uint64_t seed)
+    : m_hash(seed ^ (PRIME_1 + totalSize))
+    , m_pendingSize(0)
+{
+}
+
+void ContentHash::update(const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+    // Сначала дополняем неполное слово с прошлого раза
+    size_t i = 0;
+    if (m_pendingSize > 0)
+    {
+        while (m_pendingSize < 8 && i < size)
+        {
+            m_pending[m_pendingSize++] = bytes[i++];
+        }
+        if (m_pendingSize < 8)
+        {
+            return;
+        }
+        uint64_t word;
+        memcpy(&word, m_pending, sizeof(word));
+        m_hash = mix(m_hash, word);
+        m_pendingSize = 0;
+    }
+
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        m_hash = mix(m_hash, word);
+    }
+    while (i < size)
+    {
+        m_pending[m_pendingSize++] = bytes[i++];
+    }
+}
+
+uint64_t ContentHash::finish() const
+{
+    return mixTail(m_hash, m_pending, m_pendingSize);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Быстрый 64-битный хеш содержимого
+ *
+ * Обрабатывает данные словами по 8 байт, поэтому подходит для сравнения
+ * больших файлов. Не является криптографическим. Не зависит от WinAPI.
+ */
+class ContentHash
+{
+public:
+    /**
+     * @brief Вычислить хеш блока данных
+     * @param data Указатель на данные
+     * @param size Размер в байтах
+     * @param seed Начальное значение (для продолжения хеширования по частям)
+     * @return Значение хеша
+     */
+    static uint64_t compute(const void* data, size_t size, uint64_t seed = 0);
+
+    /**
+     * @brief Начать хеширование данных, поступающих по частям
+     *
+     * Результат finish совпадает с compute для тех же данных целиком,
+     * поэтому общий размер нужно знать заранее.
+     * @param totalSize Общий размер данных в байтах
+     * @param seed Начальное значение
+     */
+    explicit ContentHash(uint64_t totalSize, uint64_t seed = 0);
+
+    /**
+     * @brief Добавить очередную часть данных
+     * @param data Указатель на данные
+     * @param size Размер в байтах
+     */
+    void update(const void* data, size_t size);
+
+    /**
+     * @brief Получить хеш всех добавленных данных
+     * @return Значение хеша
+     */
+    uint64_t finish() const;
+
+private:
+    uint64_t m_hash;                ///< Состояние после обработанных полных слов
+    unsigned char m_pending[8];     ///< Байты неполного слова
+    size_t m_pendingSize;           ///< Количество байт неполного слова
+};
@@ -0,0 +1,20 @@
+#include "DocumentFormat.h"
+
+namespace
+{
+    const uint32_t FLAG_BOM = 1;
+    const uint32_t LINE_ENDING_SHIFT = 1;
+    const uint32_t LINE_ENDING_MASK = 3;
+}
+
+uint32_t DocumentFormat::packFlags() const
+{
+    return (hasBom ? FLAG_BOM : 0) | (static_cast<uint32_t>(lineEnding) << LINE_ENDING_SHIFT);
+}
+
+void DocumentFormat::unpackFlags(uint32_t flags)
+{
+    hasBom = (flags & FLAG_BOM) != 0;
+    uint32_t style = (flags >> LINE_ENDING_SHIFT) & LINE_ENDING_MASK;
+    lineEnding = style <= LINE_ENDING_CR ? static_cast<LineEnding>(style) : LINE_ENDING_CRLF;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief Формат файла документа: кодировка, BOM и стиль перевода строк
+ *
+ * Запоминается при открытии файла, чтобы сохранить документ в том же виде,
+ * в каком он был прочитан. Не зависит от WinAPI.
+ */
+struct DocumentFormat
+{
+    /**
+     * @brief Стиль перевода строк
+     */
+    enum LineEnding
+    {
+        LINE_ENDING_CRLF,   ///< "\r\n" (Windows)
+        LINE_ENDING_LF,     ///< "\n" (Unix)
+        LINE_ENDING_CR      ///< "\r" (старый Mac OS)
+    };
+
+    static const uint32_t CODE_PAGE_UTF8 = 65001;
+    static const uint32_t CODE_PAGE_UTF16LE = 1200;
+    static const uint32_t CODE_PAGE_UTF16BE = 1201;
+
+    uint32_t codePage;      ///< Кодовая страница
+    bool hasBom;            ///< Файл начинается с BOM
+    LineEnding lineEnding;  ///< Стиль перевода строк
+
+    DocumentFormat()
+        : codePage(CODE_PAGE_UTF8), hasBom(false), lineEnding(LINE_ENDING_CRLF)
+    {
+    }
+
+    /**
+     * @brief Упаковать BOM и стиль перевода строк в число (для снимка сеанса)
+     * @return Флаги формата
+     */
+    uint32_t packFlags() const;
+
+    /**
+     * @brief Восстановить BOM и стиль перевода строк из флагов
+     * @param flags Флаги, полученные packFlags
+     */
+    void unpackFlags(uint32_t flags);
+};
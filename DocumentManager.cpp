@@ -0,0 +1,386 @@
+#include "DocumentManager.h"
+#include <algorithm>
+
+DocumentManager::DocumentManager(Decoder decoder, size_t memoryBudget, size_t threadCount)
+    : m_decoder(decoder)
+    , m_memoryBudget(memoryBudget)
+    , m_residentBytes(0)
+    , m_nextId(1)
+    , m_clock(0)
+    , m_pool(new TaskPool(threadCount))
+{
+}
+
+DocumentManager::~DocumentManager()
+{
+    // Останавливаем пул до уничтожения документов, с которыми работают задачи
+    m_pool.reset();
+}
+
+DocumentId DocumentManager::createDocument()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    DocumentId id = m_nextId++;
+    Document& document = m_documents[id];
+    document.state = TEXT_ACQUIRED; // Новый документ сразу открывается в редакторе
+    document.lastUsed = ++m_clock;
+    m_order.push_back(id);
+    return id;
+}
+
+DocumentId DocumentManager::openDocument(const std::wstring& path)
+{
+    DocumentId id;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        id = m_nextId++;
+        Document& document = m_documents[id];
+        document.info.path = path;
+        document.state = TEXT_QUEUED;
+        document.lastUsed = ++m_clock;
+        m_order.push_back(id);
+    }
+
+    m_pool->submit([this, id]() { decodeInBackground(id); });
+    return id;
+}
+
+DocumentId DocumentManager::openViewOnlyDocument(const std::wstring& path)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    DocumentId id = m_nextId++;
+    Document& document = m_documents[id];
+    document.info.path = path;
+    document.info.isReadOnly = true;
+    document.state = TEXT_EXTERNAL;
+    document.lastUsed = ++m_clock;
+    m_order.push_back(id);
+    return id;
+}
+
+void DocumentManager::closeDocument(DocumentId id)
+{
+    std::unique_ptr<EditJournal> journal;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::map<DocumentId, Document>::iterator it = m_documents.find(id);
+        if (it == m_documents.end())
+        {
+            return;
+        }
+
+        if (it->second.state == TEXT_RESIDENT)
+        {
+            m_residentBytes -= textBytes(it->second.text);
+        }
+        journal = std::move(it->second.journal);
+        m_documents.erase(it);
+        m_order.erase(std::find(m_order.begin(), m_order.end(), id));
+    }
+
+    // Закрытый документ восстанавливать не нужно; поток журнала ждем без блокировки
+    if (journal)
+    {
+        journal->stop(true);
+    }
+}
+
+size_t DocumentManager::documentCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_order.size();
+}
+
+DocumentId DocumentManager::documentAt(size_t index) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return index < m_order.size() ? m_order[index] : 0;
+}
+
+size_t DocumentManager::indexOf(DocumentId id) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<size_t>(std::find(m_order.begin(), m_order.end(), id) - m_order.begin());
+}
+
+DocumentId DocumentManager::findByPath(const std::wstring& path) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < m_order.size(); ++i)
+    {
+        std::map<DocumentId, Document>::const_iterator it = m_documents.find(m_order[i]);
+        if (!path.empty() && it->second.info.path == path)
+        {
+            return m_order[i];
+        }
+    }
+    return 0;
+}
+
+DocumentInfo DocumentManager::getInfo(DocumentId id) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::map<DocumentId, Document>::const_iterator it = m_documents.find(id);
+    return it != m_documents.end() ? it->second.info : DocumentInfo();
+}
+
+void DocumentManager::setInfo(DocumentId id, const DocumentInfo& info)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::map<DocumentId, Document>::iterator it = m_documents.find(id);
+    if (it != m_documents.end())
+    {
+        it->second.info = info;
+    }
+}
+
+bool DocumentManager::acquireText(DocumentId id, ChunkedText& text)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    std::map<DocumentId, Document>::iterator it = m_documents.find(id);
+    if (it == m_documents.end() || it->second.state == TEXT_EXTERNAL)
+    {
+        return false;
+    }
+    it->second.lastUsed = ++m_clock;
+
+    // Документ нужен сейчас: не ждем своей очереди в пуле, декодируем сразу
+    if (it->second.state == TEXT_QUEUED || it->second.state == TEXT_EVICTED)
+    {
+        it->second.state = TEXT_DECODING;
+        DocumentInfo info = it->second.info;
+        lock.unlock();
+
+        ChunkedText decoded;
+        bool success = decodeFile(info.path, info, decoded);
+
+        lock.lock();
+        it = m_documents.find(id);
+        it->second.info.format = info.format;
+        it->second.info.contentHash = info.contentHash;
+        it->second.info.fileInfo = info.fileInfo;
+        it->second.info.hasFileInfo = info.hasFileInfo;
+        it->second.state = success ? TEXT_ACQUIRED : TEXT_FAILED;
+        m_decoded.notify_all();
+        if (success)
+        {
+            text = decoded;
+        }
+        return success;
+    }
+
+    // Декодирование уже идет в рабочем потоке
+    m_decoded.wait(lock, [this, id]()
+    {
+        std::map<DocumentId, Document>::iterator current = m_documents.find(id);
+        return current == m_documents.end() || current->second.state != TEXT_DECODING;
+    });
+    it = m_documents.find(id);
+    if (it == m_documents.end() || it->second.state == TEXT_FAILED)
+    {
+        return false;
+    }
+    if (it->second.state == TEXT_EVICTED)
+    {
+        // Выгружен сразу после декодирования: читаем заново
+        lock.unlock();
+        return acquireText(id, text);
+    }
+
+    if (it->second.state == TEXT_RESIDENT)
+    {
+        m_residentBytes -= textBytes(it->second.text);
+    }
+    text = it->second.text;
+    it->second.text = ChunkedText();
+    it->second.state = TEXT_ACQUIRED;
+    return true;
+}
+
+void DocumentManager::storeText(DocumentId id, const ChunkedText& text)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::map<DocumentId, Document>::iterator it = m_documents.find(id);
+    if (it == m_documents.end() || it->second.state == TEXT_EXTERNAL)
+    {
+        return;
+    }
+
+    if (it->second.state == TEXT_RESIDENT)
+    {
+        m_residentBytes -= textBytes(it->second.text);
+    }
+    it->second.text = text;
+    it->second.lastUsed = ++m_clock;
+    makeResident(it->second);
+}
+
+EditJournal* DocumentManager::openJournal(DocumentId id, const std::wstring& journalPath)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::map<DocumentId, Document>::iterator it = m_documents.find(id);
+    if (it == m_documents.end())
+    {
+        return nullptr;
+    }
+
+    if (!it->second.journal)
+    {
+        std::unique_ptr<EditJournal> journal(new EditJournal(journalPath));
+        if (!journal->start())
+        {
+            return nullptr;
+        }
+        it->second.journal = std::move(journal);
+    }
+    return it->second.journal.get();
+}
+
+EditJournal* DocumentManager::getJournal(DocumentId id) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::map<DocumentId, Document>::const_iterator it = m_documents.find(id);
+    return (it == m_documents.end()) ? nullptr : it->second.journal.get();
+}
+
+void DocumentManager::closeJournal(DocumentId id, bool removeFile)
+{
+    std::unique_ptr<EditJournal> journal;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::map<DocumentId, Document>::iterator it = m_documents.find(id);
+        if (it == m_documents.end())
+        {
+            return;
+        }
+        journal = std::move(it->second.journal);
+    }
+
+    if (journal)
+    {
+        journal->stop(removeFile);
+    }
+}
+
+void DocumentManager::closeJournals(bool removeFiles)
+{
+    std::vector<std::unique_ptr<EditJournal> > journals;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (std::map<DocumentId, Document>::iterator it = m_documents.begin(); it != m_documents.end(); ++it)
+        {
+            if (it->second.journal)
+            {
+                journals.push_back(std::move(it->second.journal));
+            }
+        }
+    }
+
+    for (size_t i = 0; i < journals.size(); ++i)
+    {
+        journals[i]->stop(removeFiles);
+    }
+}
+
+size_t DocumentManager::residentBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_residentBytes;
+}
+
+void DocumentManager::decodeInBackground(DocumentId id)
+{
+    DocumentInfo info;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::map<DocumentId, Document>::iterator it = m_documents.find(id);
+        if (it == m_documents.end() || it->second.state != TEXT_QUEUED)
+        {
+            return; // Документ закрыт или уже декодирован по запросу
+        }
+        it->second.state = TEXT_DECODING;
+        info = it->second.info;
+    }
+
+    ChunkedText text;
+    bool success = decodeFile(info.path, info, text);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::map<DocumentId, Document>::iterator it = m_documents.find(id);
+    if (it != m_documents.end())
+    {
+        it->second.info.format = info.format;
+        it->second.info.contentHash = info.contentHash;
+        it->second.info.fileInfo = info.fileInfo;
+        it->second.info.hasFileInfo = info.hasFileInfo;
+        if (success)
+        {
+            it->second.text = text;
+            makeResident(it->second);
+        }
+        else
+        {
+            it->second.state = TEXT_FAILED;
+        }
+    }
+    m_decoded.notify_all();
+}
+
+bool DocumentManager::decodeFile(const std::wstring& path, DocumentInfo& info, ChunkedText& text) const
+{
+    info.hasFileInfo = PortableFile::getInfo(path, info.fileInfo);
+    if (!info.hasFileInfo)
+    {
+        return false;
+    }
+
+    DecodedDocument decoded;
+    decoded.contentHash = 0;
+    if (!m_decoder(path, decoded))
+    {
+        return false;
+    }
+
+    info.format = decoded.format;
+    info.contentHash = decoded.contentHash;
+    text.assign(decoded.text.data(), decoded.text.size());
+    return true;
+}
+
+void DocumentManager::makeResident(Document& document)
+{
+    document.state = TEXT_RESIDENT;
+    m_residentBytes += textBytes(document.text);
+    enforceBudget();
+}
+
+void DocumentManager::enforceBudget()
+{
+    while (m_residentBytes > m_memoryBudget)
+    {
+        // Выгружаем только то, что можно перечитать с диска без потерь
+        Document* victim = nullptr;
+        for (std::map<DocumentId, Document>::iterator it = m_documents.begin(); it != m_documents.end(); ++it)
+        {
+            Document& document = it->second;
+            if (document.state == TEXT_RESIDENT && !document.info.isModified && !document.info.path.empty() &&
+                (!victim || document.lastUsed < victim->lastUsed))
+            {
+                victim = &document;
+            }
+        }
+        if (!victim)
+        {
+            return;
+        }
+
+        m_residentBytes -= textBytes(victim->text);
+        victim->text = ChunkedText();
+        victim->state = TEXT_EVICTED;
+    }
+}
+
+size_t DocumentManager::textBytes(const ChunkedText& text)
+{
+    return text.length() * sizeof(wchar_t);
+}
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ChunkedText.h"
+#include "DocumentFormat.h"
+#include "EditJournal.h"
+#include "PortableFile.h"
+#include "TaskPool.h"
+
+/**
+ * @brief Идентификатор документа (0 - нет документа)
+ */
+typedef size_t DocumentId;
+
+/**
+ * @brief Сведения о документе, не относящиеся к тексту
+ */
+struct DocumentInfo
+{
+    std::wstring path;              ///< Путь к файлу (пусто для нового документа)
+    bool isModified;                ///< Есть несохраненные изменения
+    DocumentFormat format;          ///< Кодировка, BOM и переводы строк файла
+    uint64_t contentHash;           ///< Хеш байтов файла на диске
+    PortableFile::Info fileInfo;    ///< Размер и время изменения файла
+    bool hasFileInfo;               ///< Поле fileInfo заполнено
+    uint64_t selectionStart;        ///< Начало выделения
+    uint64_t selectionEnd;          ///< Конец выделения
+    uint64_t firstVisibleLine;      ///< Первая видимая строка
+    bool isReadOnly;                ///< Открыт только для просмотра (большой файл)
+    uint64_t savedTextHash;         ///< Хеш текста сохраненной версии (ChunkHashTree)
+    uint64_t savedTextLength;       ///< Длина текста сохраненной версии
+    bool hasSavedText;              ///< Сохраненная версия известна
+
+    DocumentInfo()
+        : isModified(false), contentHash(0), hasFileInfo(false)
+        , selectionStart(0), selectionEnd(0), firstVisibleLine(0), isReadOnly(false)
+        , savedTextHash(0), savedTextLength(0), hasSavedText(false)
+    {
+        fileInfo.size = 0;
+        fileInfo.modifiedTime = 0;
+    }
+};
+
+/**
+ * @brief Результат декодирования файла
+ */
+struct DecodedDocument
+{
+    std::wstring text;      ///< Текст в Unicode
+    DocumentFormat format;  ///< Определенный формат файла
+    uint64_t contentHash;   ///< Хеш байтов файла
+};
+
+/**
+ * @brief Менеджер открытых документов
+ *
+ * Хранит тексты неактивных документов, декодирует файлы в общем пуле
+ * потоков и соблюдает общий бюджет памяти: тексты давно не использованных
+ * неизмененных документов выгружаются и при активации снова читаются
+ * с диска. Текст активного документа принадлежит редактору (acquireText /
+ * storeText) и в бюджете не учитывается. У каждого документа свой журнал
+ * восстановления: переключение вкладок не затрагивает журналы неактивных
+ * измененных документов. Декодирование выполняет переданная функция,
+ * поэтому класс не зависит от WinAPI.
+ */
+class DocumentManager
+{
+public:
+    /**
+     * @brief Функция чтения и декодирования файла
+     */
+    typedef std::function<bool(const std::wstring& path, DecodedDocument& result)> Decoder;
+
+    /**
+     * @brief Конструктор
+     * @param decoder Функция декодирования (вызывается из рабочих потоков)
+     * @param memoryBudget Бюджет памяти для текстов неактивных документов (байт)
+     * @param threadCount Количество потоков декодирования (0 - по числу ядер)
+     */
+    DocumentManager(Decoder decoder, size_t memoryBudget, size_t threadCount = 0);
+    ~DocumentManager();
+
+    /**
+     * @brief Создать новый пустой документ (его текст сразу принадлежит редактору)
+     * @return Идентификатор документа
+     */
+    DocumentId createDocument();
+
+    /**
+     * @brief Открыть файл (декодирование выполняется в фоне)
+     * @param path Путь к файлу
+     * @return Идентификатор документа
+     */
+    DocumentId openDocument(const std::wstring& path);
+
+    /**
+     * @brief Открыть файл только для просмотра
+     *
+     * Текст такого документа не декодируется и не хранится менеджером:
+     * его читает окно просмотра большого файла.
+     * @param path Путь к файлу
+     * @return Идентификатор документа
+     */
+    DocumentId openViewOnlyDocument(const std::wstring& path);
+
+    /**
+     * @brief Закрыть документ
+     * @param id Идентификатор документа
+     */
+    void closeDocument(DocumentId id);
+
+    /**
+     * @brief Получить количество документов
+     * @return Количество документов
+     */
+    size_t documentCount() const;
+
+    /**
+     * @brief Получить документ по порядковому номеру
+     * @param index Номер (в порядке открытия)
+     * @return Идентификатор документа или 0
+     */
+    DocumentId documentAt(size_t index) const;
+
+    /**
+     * @brief Получить порядковый номер документа
+     * @param id Идентификатор документа
+     * @return Номер или documentCount(), если документ не найден
+     */
+    size_t indexOf(DocumentId id) const;
+
+    /**
+     * @brief Найти документ по пути к файлу
+     * @param path Путь к файлу
+     * @return Идентификатор документа или 0
+     */
+    DocumentId findByPath(const std::wstring& path) const;
+
+    /**
+     * @brief Получить сведения о документе
+     * @param id Идентификатор документа
+     * @return Копия сведений
+     */
+    DocumentInfo getInfo(DocumentId id) const;
+
+    /**
+     * @brief Обновить сведения о документе
+     * @param id Идентификатор документа
+     * @param info Новые сведения
+     */
+    void setInfo(DocumentId id, const DocumentInfo& info);
+
+    /**
+     * @brief Забрать текст документа для редактирования
+     *
+     * Дожидается фонового декодирования (или выполняет его сразу, если
+     * задача еще в очереди) и перечитывает выгруженный текст с диска.
+     * @param id Идентификатор документа
+     * @param text Текст документа
+     * @return false если файл не удалось прочитать
+     */
+    bool acquireText(DocumentId id, ChunkedText& text);
+
+    /**
+     * @brief Вернуть текст документа после редактирования
+     *
+     * Блоки текста разделяются с переданным объектом без копирования.
+     * @param id Идентификатор документа
+     * @param text Текущий текст документа
+     */
+    void storeText(DocumentId id, const ChunkedText& text);
+
+    /**
+     * @brief Создать и запустить журнал восстановления документа
+     *
+     * Если журнал уже есть, возвращается он: его записи соответствуют
+     * тексту, который документ получил при последнем storeText.
+     * @param id Идентификатор документа
+     * @param journalPath Путь к файлу журнала
+     * @return Журнал (принадлежит менеджеру) или nullptr, если файл не создан
+     */
+    EditJournal* openJournal(DocumentId id, const std::wstring& journalPath);
+
+    /**
+     * @brief Получить журнал восстановления документа
+     * @param id Идентификатор документа
+     * @return Журнал или nullptr, если он не открыт
+     */
+    EditJournal* getJournal(DocumentId id) const;
+
+    /**
+     * @brief Остановить и закрыть журнал документа
+     * @param id Идентификатор документа
+     * @param removeFile Удалить файл журнала (в документе нечего восстанавливать)
+     */
+    void closeJournal(DocumentId id, bool removeFile);
+
+    /**
+     * @brief Остановить журналы всех документов (штатное завершение)
+     * @param removeFiles Удалить файлы журналов
+     */
+    void closeJournals(bool removeFiles);
+
+    /**
+     * @brief Получить объем памяти, занятый текстами неактивных документов
+     * @return Размер в байтах
+     */
+    size_t residentBytes() const;
+
+private:
+    /**
+     * @brief Состояние текста документа
+     */
+    enum TextState
+    {
+        TEXT_QUEUED,        ///< Ожидает декодирования в очереди
+        TEXT_DECODING,      ///< Декодируется
+        TEXT_RESIDENT,      ///< Текст в памяти менеджера
+        TEXT_ACQUIRED,      ///< Текст забран редактором
+        TEXT_EVICTED,       ///< Текст выгружен, читается с диска при активации
+        TEXT_FAILED,        ///< Файл не удалось прочитать
+        TEXT_EXTERNAL       ///< Текст не хранится (документ только для просмотра)
+    };
+
+    struct Document
+    {
+        DocumentInfo info;
+        ChunkedText text;
+        TextState state;
+        uint64_t lastUsed;
+        std::unique_ptr<EditJournal> journal;   ///< Журнал восстановления (если открыт)
+    };
+
+    Decoder m_decoder;                              ///< Функция декодирования
+    size_t m_memoryBudget;                          ///< Бюджет памяти
+    size_t m_residentBytes;                         ///< Занятая память
+    DocumentId m_nextId;                            ///< Следующий идентификатор
+    uint64_t m_clock;                               ///< Счетчик обращений (для LRU)
+    std::vector<DocumentId> m_order;                ///< Порядок документов
+    std::map<DocumentId, Document> m_documents;     ///< Документы
+    mutable std::mutex m_mutex;                     ///< Защита данных
+    std::condition_variable m_decoded;              ///< Сигнал о завершении декодирования
+    std::unique_ptr<TaskPool> m_pool;               ///< Пул декодирования (уничтожается первым)
+
+    /**
+     * @brief Декодировать документ в рабочем потоке
+     * @param id Идентификатор документа
+     */
+    void decodeInBackground(DocumentId id);
+
+    /**
+     * @brief Прочитать файл и заполнить документ
+     * @param path Путь к файлу
+     * @param info Сведения о документе
+     * @param text Текст документа
+     * @return true при успехе
+     */
+    bool decodeFile(const std::wstring& path, DocumentInfo& info, ChunkedText& text) const;
+
+    /**
+     * @brief Принять текст в память менеджера и соблюсти бюджет (под блокировкой)
+     * @param document Документ
+     */
+    void makeResident(Document& document);
+
+    /**
+     * @brief Выгрузить давно не использованные документы сверх бюджета (под блокировкой)
+     */
+    void enforceBudget();
+
+    static size_t textBytes(const ChunkedText& text);
+
+    DocumentManager(const DocumentManager&);
+    DocumentManager& operator=(const DocumentManager&);
+};
@@ -0,0 +1,560 @@
+#include "EditJournal.h"
+#include "PortableFile.h"
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+    const char JOURNAL_MAGIC[4] = { 'T', 'E', 'J', '1' };
+    const size_t HEADER_SIZE = 8;
+
+    const uint8_t RECORD_SNAPSHOT = 1;
+    const uint8_t RECORD_EDIT = 2;
+    const uint8_t RECORD_IN_SYNC = 3;
+    const uint8_t SNAPSHOT_FLAG_SAVED = 0x01;
+
+    // Заголовок записи: тип (1 байт) + размер данных (8 байт)
+    const size_t RECORD_HEADER_SIZE = 9;
+    const size_t RECORD_CHECKSUM_SIZE = 4;
+
+    /**
+     * @brief Инкрементальная контрольная сумма FNV-1a (32 бита)
+     */
+    class Checksum
+    {
+    public:
+        Checksum() : m_value(2166136261u) {}
+
+        void update(const void* data, size_t size)
+        {
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            for (size_t i = 0; i < size; ++i)
+            {
+                m_value = (m_value ^ bytes[i]) * 16777619u;
+            }
+        }
+
+        uint32_t value() const { return m_value; }
+
+    private:
+        uint32_t m_value;
+    };
+
+    void appendInteger(std::string& output, uint64_t value, size_t size)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            output.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+    }
+
+    uint64_t readInteger(const unsigned char* data, size_t size)
+    {
+        uint64_t value = 0;
+        for (size_t i = 0; i < size; ++i)
+        {
+            value |= static_cast<uint64_t>(data[i]) << (8 * i);
+        }
+        return value;
+    }
+
+    void appendUnits(std::string& output, const wchar_t* text, size_t length)
+    {
+        output.append(reinterpret_cast<const char*>(text), length * sizeof(wchar_t));
+    }
+
+    // Данные в журнале не выровнены, поэтому символы копируются побайтно
+    std::wstring readUnits(const unsigned char* data, size_t length)
+    {
+        std::wstring result(length, L'\0');
+        if (length > 0)
+        {
+            memcpy(&result[0], data, length * sizeof(wchar_t));
+        }
+        return result;
+    }
+
+    /**
+     * @brief Последовательное чтение записей журнала из буфера
+     */
+    class RecordReader
+    {
+    public:
+        RecordReader(const std::string& data, size_t position)
+            : m_data(reinterpret_cast<const unsigned char*>(data.data()))
+            , m_size(data.size())
+            , m_position(position)
+        {
+        }
+
+        // Прочитать следующую целую запись; false - конец журнала или повреждение
+        bool next(uint8_t& type, const unsigned char*& payload, uint64_t& payloadSize)
+        {
+            if (m_size - m_position < RECORD_HEADER_SIZE)
+            {
+                return false;
+            }
+            type = m_data[m_position];
+            payloadSize = readInteger(m_data + m_position + 1, 8);
+            if (payloadSize > m_size - m_position - RECORD_HEADER_SIZE ||
+                m_size - m_position - RECORD_HEADER_SIZE - payloadSize < RECORD_CHECKSUM_SIZE)
+            {
+                return false; // Недописанная запись
+            }
+
+            payload = m_data + m_position + RECORD_HEADER_SIZE;
+            Checksum checksum;
+            checksum.update(m_data + m_position, RECORD_HEADER_SIZE);
+            checksum.update(payload, static_cast<size_t>(payloadSize));
+            uint32_t stored = static_cast<uint32_t>(readInteger(payload + payloadSize, RECORD_CHECKSUM_SIZE));
+            if (stored != checksum.value())
+            {
+                return false; // Поврежденная запись
+            }
+
+            m_position += RECORD_HEADER_SIZE + static_cast<size_t>(payloadSize) + RECORD_CHECKSUM_SIZE;
+            return true;
+        }
+
+    private:
+        const unsigned char* m_data;
+        size_t m_size;
+        size_t m_position;
+    };
+}
+
+EditJournal::EditJournal(const std::wstring& journalPath, const Options& options)
+    : m_journalPath(journalPath)
+    , m_options(options)
+    , m_stopRequested(false)
+    , m_isRunning(false)
+    , m_barriersRequested(0)
+    , m_barriersDone(0)
+    , m_bytesSinceSnapshot(0)
+    , m_snapshotPending(false)
+    , m_file(nullptr)
+{
+}
+
+EditJournal::~EditJournal()
+{
+    stop(false);
+}
+
+bool EditJournal::start()
+{
+    if (m_isRunning)
+    {
+        return true;
+    }
+
+    m_file = PortableFile::open(m_journalPath, "wb");
+    if (!m_file)
+    {
+        return false;
+    }
+
+    std::string header;
+    writeHeader(header);
+    fwrite(header.data(), 1, header.size(), m_file);
+    PortableFile::sync(m_file);
+
+    m_stopRequested = false;
+    m_isRunning = true;
+    m_writerThread = std::thread(&EditJournal::writerLoop, this);
+    return true;
+}
+
+void EditJournal::stop(bool removeFile)
+{
+    if (m_isRunning)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopRequested = true;
+        }
+        m_wakeUp.notify_one();
+        m_writerThread.join();
+        m_isRunning = false;
+    }
+
+    if (m_file)
+    {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+    if (removeFile)
+    {
+        PortableFile::remove(m_journalPath);
+    }
+}
+
+void EditJournal::setDocumentPath(const std::wstring& documentPath)
+{
+    m_documentPath = documentPath;
+}
+
+void EditJournal::markSaved(const ChunkedText& text)
+{
+    enqueueSnapshot(text, true);
+}
+
+void EditJournal::markUnsaved(const ChunkedText& text)
+{
+    enqueueSnapshot(text, false);
+}
+
+void EditJournal::markInSync()
+{
+    if (!m_isRunning)
+    {
+        return;
+    }
+
+    // Запись без данных: после нее восстановление считает текст сохраненным
+    PendingRecord record;
+    record.kind = PendingRecord::Bytes;
+    record.isSaved = false;
+    record.bytes.push_back(static_cast<char>(RECORD_IN_SYNC));
+    appendInteger(record.bytes, 0, 8);
+
+    Checksum checksum;
+    checksum.update(record.bytes.data(), record.bytes.size());
+    appendInteger(record.bytes, checksum.value(), RECORD_CHECKSUM_SIZE);
+
+    m_bytesSinceSnapshot += record.bytes.size();
+    enqueue(record);
+}
+
+void EditJournal::compactIfNeeded(const ChunkedText& text)
+{
+    if (m_bytesSinceSnapshot.load() >= m_options.compactThreshold && !m_snapshotPending.load())
+    {
+        // Текст после уплотнения по-прежнему не сохранен
+        enqueueSnapshot(text, false);
+    }
+}
+
+void EditJournal::flush()
+{
+    if (!m_isRunning)
+    {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    uint64_t target = ++m_barriersRequested;
+    PendingRecord record;
+    record.kind = PendingRecord::Barrier;
+    record.isSaved = false;
+    m_queue.push_back(std::move(record));
+    m_wakeUp.notify_one();
+    m_flushed.wait(lock, [this, target]() { return m_barriersDone >= target || !m_isRunning; });
+}
+
+void EditJournal::onTextReset(const ChunkedText& text)
+{
+    // Текст только что загружен из файла или создан пустым
+    enqueueSnapshot(text, true);
+}
+
+void EditJournal::onTextEdited(const ChunkedText& text, const TextEdit& edit, const ChunkChange& change)
+{
+    (void)text;
+    (void)change;
+    if (!m_isRunning)
+    {
+        return;
+    }
+
+    // Сериализация правки на потоке UI занимает микросекунды
+    std::string payload;
+    appendInteger(payload, edit.offset, 8);
+    appendInteger(payload, edit.removedText.size(), 8);
+    appendInteger(payload, edit.insertedLength, 8);
+    appendUnits(payload, edit.insertedText, edit.insertedLength);
+
+    PendingRecord record;
+    record.kind = PendingRecord::Bytes;
+    record.isSaved = false;
+    record.bytes.reserve(RECORD_HEADER_SIZE + payload.size() + RECORD_CHECKSUM_SIZE);
+    record.bytes.push_back(static_cast<char>(RECORD_EDIT));
+    appendInteger(record.bytes, payload.size(), 8);
+    record.bytes += payload;
+
+    Checksum checksum;
+    checksum.update(record.bytes.data(), record.bytes.size());
+    appendInteger(record.bytes, checksum.value(), RECORD_CHECKSUM_SIZE);
+
+    m_bytesSinceSnapshot += record.bytes.size();
+    enqueue(record);
+}
+
+void EditJournal::enqueue(PendingRecord& record)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_queue.push_back(std::move(record));
+    // Не будим поток: записи сбрасываются пакетом по таймеру
+}
+
+void EditJournal::enqueueSnapshot(const ChunkedText& text, bool isSaved)
+{
+    if (!m_isRunning)
+    {
+        return;
+    }
+
+    PendingRecord record;
+    record.kind = PendingRecord::Snapshot;
+    record.snapshot = text; // Копируются только ссылки на неизменяемые блоки
+    record.documentPath = m_documentPath;
+    record.isSaved = isSaved;
+
+    m_snapshotPending = true;
+    enqueue(record);
+}
+
+void EditJournal::writerLoop()
+{
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point lastSync = Clock::now();
+    bool needsSync = false;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_wakeUp.wait_for(lock, std::chrono::milliseconds(m_options.flushIntervalMs), [this]() {
+            return m_stopRequested || m_barriersDone < m_barriersRequested;
+        });
+
+        std::deque<PendingRecord> batch;
+        batch.swap(m_queue);
+        bool stopping = m_stopRequested;
+        lock.unlock();
+
+        uint64_t barriers = 0;
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            const PendingRecord& record = batch[i];
+            switch (record.kind)
+            {
+            case PendingRecord::Bytes:
+                if (m_file)
+                {
+                    fwrite(record.bytes.data(), 1, record.bytes.size(), m_file);
+                    needsSync = true;
+                }
+                break;
+            case PendingRecord::Snapshot:
+                if (writeSnapshotFile(record))
+                {
+                    needsSync = false;
+                    lastSync = Clock::now();
+                }
+                m_bytesSinceSnapshot = 0;
+                m_snapshotPending = false;
+                break;
+            case PendingRecord::Barrier:
+                ++barriers;
+                break;
+            }
+        }
+
+        if (m_file && needsSync)
+        {
+            fflush(m_file);
+            Clock::time_point now = Clock::now();
+            if (barriers > 0 || stopping ||
+                now - lastSync >= std::chrono::milliseconds(m_options.syncIntervalMs))
+            {
+                PortableFile::sync(m_file);
+                lastSync = now;
+                needsSync = false;
+            }
+        }
+
+        lock.lock();
+        if (barriers > 0)
+        {
+            m_barriersDone += barriers;
+            m_flushed.notify_all();
+        }
+        if (stopping && m_queue.empty())
+        {
+            break;
+        }
+    }
+    m_flushed.notify_all();
+}
+
+bool EditJournal::writeSnapshotFile(const PendingRecord& record)
+{
+    const ChunkedText& text = record.snapshot;
+
+    std::string prefix;
+    std::string pathBytes;
+    appendUnits(pathBytes, record.documentPath.data(), record.documentPath.size());
+
+    uint64_t payloadSize = 1 + 4 + pathBytes.size() + 8 + static_cast<uint64_t>(text.length()) * sizeof(wchar_t);
+    prefix.push_back(static_cast<char>(RECORD_SNAPSHOT));
+    appendInteger(prefix, payloadSize, 8);
+    prefix.push_back(static_cast<char>(record.isSaved ? SNAPSHOT_FLAG_SAVED : 0));
+    appendInteger(prefix, record.documentPath.size(), 4);
+    prefix += pathBytes;
+    appendInteger(prefix, text.length(), 8);
+
+    // Новый журнал пишется рядом и атомарно заменяет старый
+    std::wstring tempPath = m_journalPath + L".tmp";
+    FILE* target = PortableFile::open(tempPath, "wb");
+    bool isTempFile = (target != nullptr);
+    if (!target)
+    {
+        target = m_file; // Не удалось создать файл - дописываем снимок в текущий журнал
+        if (!target)
+        {
+            return false;
+        }
+    }
+
+    if (isTempFile)
+    {
+        std::string header;
+        writeHeader(header);
+        fwrite(header.data(), 1, header.size(), target);
+    }
+
+    Checksum checksum;
+    checksum.update(prefix.data(), prefix.size());
+    bool success = fwrite(prefix.data(), 1, prefix.size(), target) == prefix.size();
+    for (size_t i = 0; i < text.chunkCount() && success; ++i)
+    {
+        const std::wstring& chunk = text.chunkText(i);
+        size_t bytes = chunk.size() * sizeof(wchar_t);
+        checksum.update(chunk.data(), bytes);
+        success = fwrite(chunk.data(), 1, bytes, target) == bytes;
+    }
+
+    std::string suffix;
+    appendInteger(suffix, checksum.value(), RECORD_CHECKSUM_SIZE);
+    success = success && fwrite(suffix.data(), 1, suffix.size(), target) == suffix.size();
+    success = PortableFile::sync(target) && success;
+
+    if (!isTempFile)
+    {
+        return success;
+    }
+
+    fclose(target);
+    if (!success)
+    {
+        PortableFile::remove(tempPath);
+        return false;
+    }
+
+    if (m_file)
+    {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+    bool replaced = PortableFile::replace(tempPath, m_journalPath);
+    m_file = PortableFile::open(m_journalPath, "ab");
+    return replaced && m_file != nullptr;
+}
+
+void EditJournal::writeHeader(std::string& output)
+{
+    output.append(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+    output.push_back(static_cast<char>(sizeof(wchar_t)));
+    output.append(HEADER_SIZE - sizeof(JOURNAL_MAGIC) - 1, '\0');
+}
+
+bool EditJournal::recover(const std::wstring& journalPath, RecoveredDocument& result)
+{
+    FILE* file = PortableFile::open(journalPath, "rb");
+    if (!file)
+    {
+        return false;
+    }
+
+    std::string data;
+    char buffer[65536];
+    size_t bytesRead;
+    while ((bytesRead = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        data.append(buffer, bytesRead);
+    }
+    fclose(file);
+
+    if (data.size() < HEADER_SIZE || memcmp(data.data(), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0 ||
+        static_cast<size_t>(data[sizeof(JOURNAL_MAGIC)]) != sizeof(wchar_t))
+    {
+        return false;
+    }
+
+    ChunkedText text;
+    bool hasSnapshot = false;
+    result.hasUnsavedChanges = false;
+    result.documentPath.clear();
+
+    RecordReader reader(data, HEADER_SIZE);
+    uint8_t type = 0;
+    const unsigned char* payload = nullptr;
+    uint64_t payloadSize = 0;
+    while (reader.next(type, payload, payloadSize))
+    {
+        if (type == RECORD_SNAPSHOT && payloadSize >= 1 + 4 + 8)
+        {
+            uint8_t flags = payload[0];
+            uint64_t pathLength = readInteger(payload + 1, 4);
+            if (1 + 4 + pathLength * sizeof(wchar_t) + 8 > payloadSize)
+            {
+                break;
+            }
+            const unsigned char* pathData = payload + 1 + 4;
+            const unsigned char* lengthData = pathData + pathLength * sizeof(wchar_t);
+            uint64_t textLength = readInteger(lengthData, 8);
+            if (1 + 4 + pathLength * sizeof(wchar_t) + 8 + textLength * sizeof(wchar_t) != payloadSize)
+            {
+                break;
+            }
+
+            result.documentPath = readUnits(pathData, static_cast<size_t>(pathLength));
+            std::wstring snapshotText = readUnits(lengthData + 8, static_cast<size_t>(textLength));
+            text.assign(snapshotText.data(), snapshotText.size());
+            result.hasUnsavedChanges = (flags & SNAPSHOT_FLAG_SAVED) == 0;
+            hasSnapshot = true;
+        }
+        else if (type == RECORD_EDIT && payloadSize >= 24 && hasSnapshot)
+        {
+            uint64_t offset = readInteger(payload, 8);
+            uint64_t removeCount = readInteger(payload + 8, 8);
+            uint64_t insertCount = readInteger(payload + 16, 8);
+            if (24 + insertCount * sizeof(wchar_t) != payloadSize ||
+                offset > text.length() || removeCount > text.length() - offset)
+            {
+                break;
+            }
+
+            std::wstring inserted = readUnits(payload + 24, static_cast<size_t>(insertCount));
+            text.replace(static_cast<size_t>(offset), static_cast<size_t>(removeCount),
+                         inserted.data(), inserted.size());
+            result.hasUnsavedChanges = true;
+        }
+        else if (type == RECORD_IN_SYNC && payloadSize == 0 && hasSnapshot)
+        {
+            result.hasUnsavedChanges = false;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (!hasSnapshot)
+    {
+        return false;
+    }
+
+    result.text = text.toString();
+    return true;
+}
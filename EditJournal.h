@@ -0,0 +1,167 @@
+#pragma once
+
+#include "TextChangeTracker.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief Документ, восстановленный из журнала правок
+ */
+struct RecoveredDocument
+{
+    std::wstring documentPath;  ///< Путь к файлу документа (пустой для нового документа)
+    std::wstring text;          ///< Восстановленный текст
+    bool hasUnsavedChanges;     ///< Есть ли правки после последнего сохранения
+};
+
+/**
+ * @brief Журнал правок для восстановления после сбоя
+ *
+ * Подписывается на TextChangeTracker и дописывает каждую правку в файл.
+ * Запись выполняет фоновый поток: записи накапливаются в очереди и
+ * сбрасываются пакетами, fsync выполняется не чаще заданного интервала.
+ * Когда журнал разрастается, он уплотняется до одного снимка текста.
+ * Класс не зависит от WinAPI.
+ */
+class EditJournal : public ITextChangeListener
+{
+public:
+    /**
+     * @brief Параметры записи журнала
+     */
+    struct Options
+    {
+        unsigned int flushIntervalMs;   ///< Интервал пакетной записи
+        unsigned int syncIntervalMs;    ///< Минимальный интервал между fsync
+        uint64_t compactThreshold;      ///< Размер правок, после которого журнал уплотняется
+
+        Options() : flushIntervalMs(200), syncIntervalMs(1000), compactThreshold(8 * 1024 * 1024) {}
+    };
+
+    /**
+     * @brief Конструктор
+     * @param journalPath Путь к файлу журнала
+     * @param options Параметры записи
+     */
+    EditJournal(const std::wstring& journalPath, const Options& options = Options());
+
+    /**
+     * @brief Деструктор (останавливает фоновый поток, файл сохраняется)
+     */
+    ~EditJournal();
+
+    /**
+     * @brief Создать новый журнал и запустить фоновую запись
+     * @return true если файл журнала создан
+     */
+    bool start();
+
+    /**
+     * @brief Остановить запись журнала
+     * @param removeFile Удалить файл журнала (штатное завершение)
+     */
+    void stop(bool removeFile);
+
+    /**
+     * @brief Задать путь к файлу документа для следующих снимков
+     * @param documentPath Путь к файлу документа
+     */
+    void setDocumentPath(const std::wstring& documentPath);
+
+    /**
+     * @brief Отметить сохранение документа (журнал уплотняется до снимка)
+     * @param text Текст сохраненного документа
+     */
+    void markSaved(const ChunkedText& text);
+
+    /**
+     * @brief Записать снимок несохраненного текста (например, после восстановления)
+     * @param text Текущий текст документа
+     */
+    void markUnsaved(const ChunkedText& text);
+
+    /**
+     * @brief Отметить, что текст совпадает с файлом, без записи снимка
+     *
+     * Используется, когда правки пришли из самого файла (например, дописанные
+     * строки в режиме слежения): снимок всего текста при этом не нужен.
+     */
+    void markInSync();
+
+    /**
+     * @brief Запланировать уплотнение, если журнал превысил порог
+     * @param text Текущий текст документа
+     */
+    void compactIfNeeded(const ChunkedText& text);
+
+    /**
+     * @brief Дождаться записи и fsync всех поставленных в очередь записей
+     */
+    void flush();
+
+    void onTextReset(const ChunkedText& text) override;
+    void onTextEdited(const ChunkedText& text, const TextEdit& edit, const ChunkChange& change) override;
+
+    /**
+     * @brief Восстановить документ из файла журнала
+     *
+     * Записи читаются до первой поврежденной или недописанной записи,
+     * поэтому журнал, оборванный сбоем, восстанавливается до последней
+     * целой правки.
+     *
+     * @param journalPath Путь к файлу журнала
+     * @param result Восстановленный документ
+     * @return true если журнал прочитан и содержит снимок текста
+     */
+    static bool recover(const std::wstring& journalPath, RecoveredDocument& result);
+
+private:
+    /**
+     * @brief Запись, ожидающая фоновой обработки
+     */
+    struct PendingRecord
+    {
+        enum Kind
+        {
+            Bytes,      ///< Готовые байты записи правки
+            Snapshot,   ///< Снимок текста с уплотнением журнала
+            Barrier     ///< Точка синхронизации для flush()
+        };
+
+        Kind kind;                  ///< Тип записи
+        std::string bytes;          ///< Сериализованная запись (для Bytes)
+        ChunkedText snapshot;       ///< Снимок текста (для Snapshot)
+        std::wstring documentPath;  ///< Путь к документу (для Snapshot)
+        bool isSaved;               ///< Снимок соответствует сохраненному файлу
+    };
+
+    std::wstring m_journalPath;             ///< Путь к файлу журнала
+    Options m_options;                      ///< Параметры записи
+    std::wstring m_documentPath;            ///< Текущий путь к документу
+
+    std::thread m_writerThread;             ///< Фоновый поток записи
+    std::mutex m_mutex;                     ///< Защита очереди
+    std::condition_variable m_wakeUp;       ///< Сигнал фоновому потоку
+    std::condition_variable m_flushed;      ///< Сигнал о выполненном flush()
+    std::deque<PendingRecord> m_queue;      ///< Очередь записей
+    bool m_stopRequested;                   ///< Запрошена остановка
+    bool m_isRunning;                       ///< Фоновый поток запущен
+    uint64_t m_barriersRequested;           ///< Количество запрошенных flush()
+    uint64_t m_barriersDone;                ///< Количество выполненных flush()
+
+    std::atomic<uint64_t> m_bytesSinceSnapshot; ///< Объем правок после последнего снимка
+    std::atomic<bool> m_snapshotPending;        ///< Снимок уже в очереди
+
+    FILE* m_file;                           ///< Файл журнала (только фоновый поток)
+
+    void enqueue(PendingRecord& record);
+    void enqueueSnapshot(const ChunkedText& text, bool isSaved);
+    void writerLoop();
+    bool writeSnapshotFile(const PendingRecord& record);
+    static void writeHeader(std::string& output);
+};
@@ -0,0 +1,600 @@
+#include "EncodingDetector.h"
+#include "PortableFile.h"
+#include "Utf8Codec.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+// Определения нужны: константы передаются по ссылке (std::min)
+const size_t EncodingDetector::SAMPLE_SIZE;
+const size_t EncodingDetector::MAX_SAMPLES;
+
+namespace
+{
+    const size_t MAX_THREADS = 8;                   ///< Наибольшее число потоков оценки
+    const double EARLY_STOP_MARGIN = 64.0;          ///< Перевес (в натуральных логарифмах) для остановки
+    const size_t UTF8_CONFIDENT_SEQUENCES = 64;     ///< Последовательностей UTF-8 для остановки
+    const size_t UTF16_MIN_UNITS = 1024;            ///< Единиц UTF-16 для остановки
+
+    // Классы байтов верхней половины однобайтовой таблицы
+    const unsigned char CLASS_OTHER = 0;            ///< Псевдографика и неопределенные байты
+    const unsigned char CLASS_PUNCT = 1;            ///< Знаки препинания и символы
+    const unsigned char CLASS_RARE_LETTER = 2;      ///< Буквы других языков
+    const unsigned char CLASS_COMMON_LETTER = 3;    ///< Частые буквы западноевропейских языков
+    const unsigned char CLASS_LOWER = 0x40;         ///< Флаг строчной русской буквы (младшие биты - номер)
+    const unsigned char CLASS_UPPER = 0x80;         ///< Флаг прописной русской буквы
+
+    // Частоты русских букв (на тысячу) в порядке алфавита, последняя - ё
+    const double RUSSIAN_FREQUENCIES[33] =
+    {
+        80.1, 15.9, 45.4, 17.0, 29.8, 84.5, 9.4, 16.5, 73.5, 12.1, 34.9,
+        44.0, 32.1, 67.0, 109.7, 28.1, 47.3, 54.7, 62.6, 26.2, 2.6, 9.7,
+        4.8, 14.4, 7.3, 3.6, 0.4, 19.0, 17.4, 3.2, 6.4, 20.1, 0.4
+    };
+    const size_t LETTER_YO = 32;
+
+    // Буквы KOI8-R с 0xC0 по 0xDF (строчные) по номеру в алфавите
+    const unsigned char KOI8_LETTERS[32] =
+    {
+        30, 0, 1, 22, 4, 5, 20, 3, 21, 8, 9, 10, 11, 12, 13, 14,
+        15, 31, 16, 17, 18, 19, 6, 2, 28, 27, 7, 24, 29, 25, 23, 26
+    };
+
+    /**
+     * @brief Модель однобайтовой кодировки: класс и вес каждого байта 0x80-0xFF
+     */
+    struct SingleByteModel
+    {
+        unsigned char classes[128];
+        double logEmission[128];
+        bool isCyrillic;
+    };
+
+    void markBytes(unsigned char* classes, const unsigned char* bytes, size_t count, unsigned char value)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            classes[bytes[i] - 0x80] = value;
+        }
+    }
+
+    void buildClasses(size_t model, unsigned char* classes)
+    {
+        std::fill(classes, classes + 128, CLASS_OTHER);
+        switch (model)
+        {
+        case 0: // Windows-1251
+        {
+            for (unsigned char i = 0; i < 32; ++i)
+            {
+                classes[0xC0 - 0x80 + i] = CLASS_UPPER | i;
+                classes[0xE0 - 0x80 + i] = CLASS_LOWER | i;
+            }
+            classes[0xA8 - 0x80] = CLASS_UPPER | LETTER_YO;
+            classes[0xB8 - 0x80] = CLASS_LOWER | LETTER_YO;
+            static const unsigned char punct[] =
+            {
+                0x82, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8B, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97,
+                0x99, 0x9B, 0xA0, 0xA4, 0xA6, 0xA7, 0xA9, 0xAB, 0xAC, 0xAD, 0xAE, 0xB0, 0xB1, 0xB5,
+                0xB6, 0xB7, 0xB9, 0xBB
+            };
+            static const unsigned char rare[] =
+            {
+                0x80, 0x81, 0x83, 0x8A, 0x8C, 0x8D, 0x8E, 0x8F, 0x90, 0x9A, 0x9C, 0x9D, 0x9E, 0x9F,
+                0xA1, 0xA2, 0xA3, 0xA5, 0xAA, 0xAF, 0xB2, 0xB3, 0xB4, 0xBA, 0xBC, 0xBD, 0xBE, 0xBF
+            };
+            markBytes(classes, punct, sizeof(punct), CLASS_PUNCT);
+            markBytes(classes, rare, sizeof(rare), CLASS_RARE_LETTER);
+            break;
+        }
+        case 1: // KOI8-R
+        {
+            for (unsigned char i = 0; i < 32; ++i)
+            {
+                classes[0xC0 - 0x80 + i] = CLASS_LOWER | KOI8_LETTERS[i];
+                classes[0xE0 - 0x80 + i] = CLASS_UPPER | KOI8_LETTERS[i];
+            }
+            classes[0xA3 - 0x80] = CLASS_LOWER | LETTER_YO;
+            classes[0xB3 - 0x80] = CLASS_UPPER | LETTER_YO;
+            static const unsigned char punct[] = { 0x9A, 0x9C, 0x9D, 0x9E, 0x9F, 0xBF };
+            markBytes(classes, punct, sizeof(punct), CLASS_PUNCT);
+            break;
+        }
+        case 2: // CP866
+        {
+            for (unsigned char i = 0; i < 32; ++i)
+            {
+                classes[i] = CLASS_UPPER | i;
+            }
+            for (unsigned char i = 0; i < 16; ++i)
+            {
+                classes[0xA0 - 0x80 + i] = CLASS_LOWER | i;
+                classes[0xE0 - 0x80 + i] = CLASS_LOWER | (16 + i);
+            }
+            classes[0xF0 - 0x80] = CLASS_UPPER | LETTER_YO;
+            classes[0xF1 - 0x80] = CLASS_LOWER | LETTER_YO;
+            static const unsigned char punct[] = { 0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFF };
+            static const unsigned char rare[] = { 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7 };
+            markBytes(classes, punct, sizeof(punct), CLASS_PUNCT);
+            markBytes(classes, rare, sizeof(rare), CLASS_RARE_LETTER);
+            break;
+        }
+        default: // Windows-1252
+        {
+            for (size_t i = 0xC0; i <= 0xFF; ++i)
+            {
+                classes[i - 0x80] = CLASS_RARE_LETTER;
+            }
+            for (size_t i = 0xA0; i <= 0xBF; ++i)
+            {
+                classes[i - 0x80] = CLASS_PUNCT;
+            }
+            classes[0xD7 - 0x80] = CLASS_PUNCT;
+            classes[0xF7 - 0x80] = CLASS_PUNCT;
+            static const unsigned char punct[] =
+            {
+                0x80, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8B, 0x91, 0x92, 0x93, 0x94,
+                0x95, 0x96, 0x97, 0x98, 0x99, 0x9B
+            };
+            static const unsigned char rare[] = { 0x8A, 0x8C, 0x8E, 0x9A, 0x9C, 0x9E, 0x9F };
+            static const unsigned char common[] =
+            {
+                0xDF, 0xE0, 0xE1, 0xE2, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xEB,
+                0xED, 0xEE, 0xEF, 0xF1, 0xF3, 0xF4, 0xF6, 0xF8, 0xF9, 0xFA, 0xFB, 0xFC
+            };
+            markBytes(classes, punct, sizeof(punct), CLASS_PUNCT);
+            markBytes(classes, rare, sizeof(rare), CLASS_RARE_LETTER);
+            markBytes(classes, common, sizeof(common), CLASS_COMMON_LETTER);
+            break;
+        }
+        }
+    }
+
+    /**
+     * @brief Модели кандидатов (строятся один раз)
+     *
+     * Вес байта - вероятность встретить его среди байтов верхней половины
+     * таблицы в тексте на соответствующем языке.
+     */
+    struct Models
+    {
+        SingleByteModel models[4];
+        double cyrillicContext[3];      ///< Буква после латинской буквы, после буквы, после прочего
+        double latinContext[3];
+        double cyrillicAsciiAfterLetter;
+        double latinAsciiAfterLetter;
+        double neutral;
+
+        Models()
+        {
+            for (size_t m = 0; m < 4; ++m)
+            {
+                SingleByteModel& model = models[m];
+                model.isCyrillic = (m != 3);
+                buildClasses(m, model.classes);
+
+                size_t commonCount = 0;
+                for (size_t i = 0; i < 128; ++i)
+                {
+                    commonCount += (model.classes[i] == CLASS_COMMON_LETTER) ? 1 : 0;
+                }
+                for (size_t i = 0; i < 128; ++i)
+                {
+                    unsigned char byteClass = model.classes[i];
+                    double probability;
+                    if (byteClass & CLASS_LOWER)
+                    {
+                        probability = 0.95 * 0.93 * RUSSIAN_FREQUENCIES[byteClass & 0x3F] / 1000.0;
+                    }
+                    else if (byteClass & CLASS_UPPER)
+                    {
+                        probability = 0.95 * 0.07 * RUSSIAN_FREQUENCIES[byteClass & 0x3F] / 1000.0;
+                    }
+                    else if (byteClass == CLASS_COMMON_LETTER)
+                    {
+                        probability = 0.9 / commonCount;
+                    }
+                    else if (byteClass == CLASS_RARE_LETTER)
+                    {
+                        probability = model.isCyrillic ? 0.0005 : 0.002;
+                    }
+                    else if (byteClass == CLASS_PUNCT)
+                    {
+                        probability = 0.002;
+                    }
+                    else
+                    {
+                        probability = 0.0001;
+                    }
+                    model.logEmission[i] = std::log(probability);
+                }
+            }
+
+            cyrillicContext[0] = std::log(0.01);
+            cyrillicContext[1] = std::log(0.75);
+            cyrillicContext[2] = std::log(0.24);
+            latinContext[0] = std::log(0.6);
+            latinContext[1] = std::log(0.1);
+            latinContext[2] = std::log(0.3);
+            cyrillicAsciiAfterLetter = std::log(0.02);
+            latinAsciiAfterLetter = std::log(0.7);
+            neutral = std::log(0.3);
+        }
+    };
+
+    const Models& getModels()
+    {
+        static const Models models;
+        return models;
+    }
+
+    bool isAsciiLetter(unsigned char byte)
+    {
+        return (byte >= 'A' && byte <= 'Z') || (byte >= 'a' && byte <= 'z');
+    }
+
+    bool isLetterClass(unsigned char byteClass)
+    {
+        return byteClass >= CLASS_RARE_LETTER;
+    }
+
+    // Употребительные диапазоны Unicode: текст в UTF-16 почти целиком из них
+    bool isPlausibleUnit(unsigned int unit)
+    {
+        return unit == 0x09 || unit == 0x0A || unit == 0x0D ||
+            (unit >= 0x20 && unit < 0x7F) ||
+            (unit >= 0xA0 && unit < 0x250) ||
+            (unit >= 0x370 && unit < 0x530) ||
+            (unit >= 0x2000 && unit < 0x2070) ||
+            (unit >= 0x20A0 && unit < 0x2200) ||
+            (unit >= 0x3000 && unit < 0xA000) ||
+            (unit >= 0xAC00 && unit < 0xD7B0) ||
+            (unit >= 0xFF00 && unit < 0xFFF0);
+    }
+}
+
+EncodingDetector::Result EncodingDetector::detect(const char* data, size_t size)
+{
+    Result result;
+    ReadSample read = [data](uint64_t offset, size_t length, std::string& storage, const char*& sample)
+    {
+        (void)length;
+        (void)storage;
+        sample = data + offset;
+        return true;
+    };
+    run(size, read, result);
+    return result;
+}
+
+bool EncodingDetector::detectFile(const std::wstring& path, Result& result)
+{
+    PortableFile::Info info;
+    if (!PortableFile::getInfo(path, info))
+    {
+        return false;
+    }
+
+    // Каждый поток открывает файл сам, чтобы не делить позицию чтения
+    ReadSample read = [&path](uint64_t offset, size_t length, std::string& storage, const char*& sample)
+    {
+        FILE* file = PortableFile::open(path, "rb");
+        if (!file)
+        {
+            return false;
+        }
+        storage.resize(length);
+        bool isRead = PortableFile::seek(file, offset) &&
+            (length == 0 || fread(&storage[0], 1, length, file) == length);
+        fclose(file);
+        sample = storage.data();
+        return isRead;
+    };
+    return run(info.size, read, result);
+}
+
+bool EncodingDetector::isSingleByte(uint32_t codePage)
+{
+    return codePage == CODE_PAGE_WINDOWS_1251 || codePage == CODE_PAGE_KOI8_R ||
+        codePage == CODE_PAGE_CP866 || codePage == CODE_PAGE_WINDOWS_1252;
+}
+
+bool EncodingDetector::run(uint64_t size, const ReadSample& read, Result& result)
+{
+    result.codePage = CODE_PAGE_UTF8;
+    result.fallbackCodePage = CODE_PAGE_WINDOWS_1251;
+    result.bomLength = 0;
+    result.confidence = 1.0;
+    result.sampledBytes = 0;
+
+    // BOM решает сразу
+    std::string storage;
+    const char* head = nullptr;
+    size_t headLength = static_cast<size_t>(std::min<uint64_t>(size, 3));
+    if (!read(0, headLength, storage, head))
+    {
+        return false;
+    }
+    result.bomLength = detectBom(reinterpret_cast<const unsigned char*>(head), headLength, result.codePage);
+    if (result.bomLength > 0 || size == 0)
+    {
+        return true;
+    }
+
+    // Блоки разнесены по всему файлу; смещения четные, чтобы не сбить пары UTF-16
+    size_t sampleCount = 1;
+    if (size > SAMPLE_SIZE)
+    {
+        sampleCount = static_cast<size_t>(std::min<uint64_t>(MAX_SAMPLES, size / SAMPLE_SIZE));
+    }
+    std::vector<uint64_t> offsets(sampleCount, 0);
+    for (size_t i = 1; i < sampleCount; ++i)
+    {
+        uint64_t offset = (size - SAMPLE_SIZE) * i / (sampleCount - 1);
+        offsets[i] = offset & ~static_cast<uint64_t>(1);
+    }
+
+    // Порядок обхода с обращенными битами: каждая волна покрывает файл все плотнее
+    size_t capacity = 1;
+    size_t bits = 0;
+    while (capacity < sampleCount)
+    {
+        capacity *= 2;
+        ++bits;
+    }
+    std::vector<size_t> order;
+    order.reserve(sampleCount);
+    for (size_t i = 0; i < capacity; ++i)
+    {
+        size_t reversed = 0;
+        for (size_t bit = 0; bit < bits; ++bit)
+        {
+            if (i & (static_cast<size_t>(1) << bit))
+            {
+                reversed |= static_cast<size_t>(1) << (bits - 1 - bit);
+            }
+        }
+        if (reversed < sampleCount)
+        {
+            order.push_back(reversed);
+        }
+    }
+
+    size_t threadCount = std::max<size_t>(1, std::min<size_t>(MAX_THREADS, std::thread::hardware_concurrency()));
+
+    Score total = {};
+    total.isUtf8Valid = true;
+    size_t next = 0;
+    while (next < order.size())
+    {
+        size_t waveSize = std::min(threadCount, order.size() - next);
+        std::vector<Score> scores(waveSize);
+        std::vector<char> isRead(waveSize, 0);
+
+        auto scoreOne = [&](size_t slot)
+        {
+            size_t index = order[next + slot];
+            uint64_t offset = offsets[index];
+            size_t length = static_cast<size_t>(std::min<uint64_t>(SAMPLE_SIZE, size - offset));
+            std::string buffer;
+            const char* sample = nullptr;
+            if (read(offset, length, buffer, sample))
+            {
+                scoreSample(reinterpret_cast<const unsigned char*>(sample), length,
+                            offset == 0, offset + length == size, scores[slot]);
+                isRead[slot] = 1;
+            }
+        };
+
+        // Первый блок волны оценивается в текущем потоке
+        std::vector<std::thread> workers;
+        for (size_t slot = 1; slot < waveSize; ++slot)
+        {
+            workers.push_back(std::thread(scoreOne, slot));
+        }
+        scoreOne(0);
+        for (size_t i = 0; i < workers.size(); ++i)
+        {
+            workers[i].join();
+        }
+
+        for (size_t slot = 0; slot < waveSize; ++slot)
+        {
+            if (!isRead[slot])
+            {
+                return false;
+            }
+            accumulate(total, scores[slot]);
+        }
+        next += waveSize;
+
+        if (decide(total, next == order.size(), result))
+        {
+            break;
+        }
+    }
+    result.sampledBytes = total.bytes;
+    return true;
+}
+
+size_t EncodingDetector::detectBom(const unsigned char* bytes, size_t size, uint32_t& codePage)
+{
+    if (size >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF)
+    {
+        codePage = CODE_PAGE_UTF8;
+        return 3;
+    }
+    if (size >= 2 && bytes[0] == 0xFF && bytes[1] == 0xFE)
+    {
+        codePage = CODE_PAGE_UTF16LE;
+        return 2;
+    }
+    if (size >= 2 && bytes[0] == 0xFE && bytes[1] == 0xFF)
+    {
+        codePage = CODE_PAGE_UTF16BE;
+        return 2;
+    }
+    return 0;
+}
+
+void EncodingDetector::scoreSample(const unsigned char* data, size_t size, bool isFileStart, bool isFileEnd, Score& score)
+{
+    const Models& models = getModels();
+    score = Score();
+    score.bytes = size;
+
+    // UTF-8: блок из середины файла может начинаться внутри последовательности
+    size_t skip = 0;
+    if (!isFileStart)
+    {
+        while (skip < 3 && skip < size && (data[skip] & 0xC0) == 0x80)
+        {
+            ++skip;
+        }
+    }
+    score.isUtf8Valid = Utf8Codec::isValid(reinterpret_cast<const char*>(data) + skip, size - skip, !isFileEnd);
+
+    // UTF-16: старший байт единицы у латиницы и кириллицы - 0x00 или 0x04
+    score.utf16Units = size / 2;
+    for (size_t i = 0; i + 1 < size; i += 2)
+    {
+        unsigned int low = data[i];
+        unsigned int high = data[i + 1];
+        score.utf16NarrowLE += (high == 0x00 || high == 0x04) ? 1 : 0;
+        score.utf16NarrowBE += (low == 0x00 || low == 0x04) ? 1 : 0;
+        score.utf16PlausibleLE += isPlausibleUnit(low | (high << 8)) ? 1 : 0;
+        score.utf16PlausibleBE += isPlausibleUnit((low << 8) | high) ? 1 : 0;
+    }
+
+    // Однобайтовые кодировки: вес байта и то, с чем он соседствует
+    unsigned char previous = ' ';
+    for (size_t i = 0; i < size; ++i)
+    {
+        unsigned char byte = data[i];
+        if (byte < 0x80)
+        {
+            if (previous >= 0x80 && isAsciiLetter(byte))
+            {
+                for (size_t m = 0; m < SINGLE_BYTE_COUNT; ++m)
+                {
+                    const SingleByteModel& model = models.models[m];
+                    if (!isLetterClass(model.classes[previous - 0x80]))
+                    {
+                        score.logLikelihood[m] += models.neutral;
+                    }
+                    else
+                    {
+                        score.logLikelihood[m] += model.isCyrillic ?
+                            models.cyrillicAsciiAfterLetter : models.latinAsciiAfterLetter;
+                    }
+                }
+            }
+            previous = byte;
+            continue;
+        }
+
+        ++score.highBytes;
+        if (byte >= 0xC2 && byte <= 0xF4)
+        {
+            ++score.utf8Sequences;
+        }
+        for (size_t m = 0; m < SINGLE_BYTE_COUNT; ++m)
+        {
+            const SingleByteModel& model = models.models[m];
+            double weight = model.logEmission[byte - 0x80];
+            if (!isLetterClass(model.classes[byte - 0x80]))
+            {
+                weight += models.neutral;
+            }
+            else
+            {
+                size_t context = 2;
+                if (isAsciiLetter(previous))
+                {
+                    context = 0;
+                }
+                else if (previous >= 0x80 && isLetterClass(model.classes[previous - 0x80]))
+                {
+                    context = 1;
+                }
+                weight += model.isCyrillic ? models.cyrillicContext[context] : models.latinContext[context];
+            }
+            score.logLikelihood[m] += weight;
+        }
+        previous = byte;
+    }
+}
+
+void EncodingDetector::accumulate(Score& total, const Score& sample)
+{
+    total.bytes += sample.bytes;
+    total.highBytes += sample.highBytes;
+    total.isUtf8Valid = total.isUtf8Valid && sample.isUtf8Valid;
+    total.utf8Sequences += sample.utf8Sequences;
+    total.utf16Units += sample.utf16Units;
+    total.utf16NarrowLE += sample.utf16NarrowLE;
+    total.utf16NarrowBE += sample.utf16NarrowBE;
+    total.utf16PlausibleLE += sample.utf16PlausibleLE;
+    total.utf16PlausibleBE += sample.utf16PlausibleBE;
+    for (size_t m = 0; m < SINGLE_BYTE_COUNT; ++m)
+    {
+        total.logLikelihood[m] += sample.logLikelihood[m];
+    }
+}
+
+bool EncodingDetector::decide(const Score& total, bool isComplete, Result& result)
+{
+    static const uint32_t SINGLE_BYTE_CODE_PAGES[SINGLE_BYTE_COUNT] =
+    {
+        CODE_PAGE_WINDOWS_1251, CODE_PAGE_KOI8_R, CODE_PAGE_CP866, CODE_PAGE_WINDOWS_1252
+    };
+
+    // Лучшая однобайтовая кодировка нужна и как запасной вариант для UTF-8
+    size_t best = 0;
+    for (size_t m = 1; m < SINGLE_BYTE_COUNT; ++m)
+    {
+        if (total.logLikelihood[m] > total.logLikelihood[best])
+        {
+            best = m;
+        }
+    }
+    double margin = -1.0;
+    for (size_t m = 0; m < SINGLE_BYTE_COUNT; ++m)
+    {
+        if (m != best && (margin < 0 || total.logLikelihood[best] - total.logLikelihood[m] < margin))
+        {
+            margin = total.logLikelihood[best] - total.logLikelihood[m];
+        }
+    }
+    result.fallbackCodePage = SINGLE_BYTE_CODE_PAGES[best];
+
+    // UTF-16 без BOM: большинство старших байтов 0 или 0x04, почти все символы употребительны
+    if (total.utf16Units > 0)
+    {
+        bool isLittleEndian = total.utf16NarrowLE * 10 >= total.utf16Units * 6 &&
+            total.utf16PlausibleLE * 100 >= total.utf16Units * 95;
+        bool isBigEndian = total.utf16NarrowBE * 10 >= total.utf16Units * 6 &&
+            total.utf16PlausibleBE * 100 >= total.utf16Units * 95;
+        if (isLittleEndian != isBigEndian)
+        {
+            result.codePage = isLittleEndian ? CODE_PAGE_UTF16LE : CODE_PAGE_UTF16BE;
+            size_t plausible = isLittleEndian ? total.utf16PlausibleLE : total.utf16PlausibleBE;
+            result.confidence = static_cast<double>(plausible) / total.utf16Units;
+            return isComplete || total.utf16Units >= UTF16_MIN_UNITS;
+        }
+    }
+
+    // Корректный UTF-8 с многобайтовыми последовательностями почти не бывает случайным;
+    // чистый ASCII тоже считается UTF-8
+    if (total.isUtf8Valid)
+    {
+        result.codePage = CODE_PAGE_UTF8;
+        result.confidence = 1.0 - 1.0 / (2.0 + total.utf8Sequences);
+        return isComplete || total.utf8Sequences >= UTF8_CONFIDENT_SEQUENCES;
+    }
+
+    result.codePage = SINGLE_BYTE_CODE_PAGES[best];
+    result.confidence = 1.0 - std::exp(-margin);
+    return isComplete || margin >= EARLY_STOP_MARGIN;
+}
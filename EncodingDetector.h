@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/**
+ * @brief Определение кодировки текста по выборке блоков
+ *
+ * Вместо проверки всего файла берутся блоки, равномерно разнесенные по нему;
+ * блоки оцениваются параллельно, волнами по числу ядер. Для каждого блока
+ * проверяется корректность UTF-8, признаки UTF-16 без BOM (старшие байты
+ * символов почти всегда 0 или 0x04) и считается правдоподобие однобайтовых
+ * кодировок (Windows-1251, KOI8-R, CP866, Windows-1252) по частотам букв и
+ * тому, стоят ли буквы верхней половины таблицы подряд (кириллица) или
+ * поодиночке среди латиницы. Как только перевес одной кодировки достаточен,
+ * оставшиеся блоки не читаются. Не зависит от WinAPI.
+ */
+class EncodingDetector
+{
+public:
+    static const uint32_t CODE_PAGE_UTF8 = 65001;
+    static const uint32_t CODE_PAGE_UTF16LE = 1200;
+    static const uint32_t CODE_PAGE_UTF16BE = 1201;
+    static const uint32_t CODE_PAGE_WINDOWS_1251 = 1251;
+    static const uint32_t CODE_PAGE_KOI8_R = 20866;
+    static const uint32_t CODE_PAGE_CP866 = 866;
+    static const uint32_t CODE_PAGE_WINDOWS_1252 = 1252;
+
+    static const size_t SAMPLE_SIZE = 64 * 1024;   ///< Размер блока выборки
+    static const size_t MAX_SAMPLES = 32;           ///< Наибольшее число блоков
+
+    /**
+     * @brief Результат определения
+     */
+    struct Result
+    {
+        uint32_t codePage;          ///< Кодовая страница
+        uint32_t fallbackCodePage;  ///< Лучшая однобайтовая кодировка (если UTF-8 не подтвердится)
+        size_t bomLength;           ///< Длина BOM в байтах (0 если его нет)
+        double confidence;          ///< Уверенность от 0 до 1
+        size_t sampledBytes;        ///< Сколько байт просмотрено
+    };
+
+    /**
+     * @brief Определить кодировку данных в памяти
+     * @param data Указатель на байты
+     * @param size Количество байт
+     * @return Результат
+     */
+    static Result detect(const char* data, size_t size);
+
+    /**
+     * @brief Определить кодировку файла, читая только блоки выборки
+     * @param path Путь к файлу
+     * @param result Результат
+     * @return false если файл не удалось прочитать
+     */
+    static bool detectFile(const std::wstring& path, Result& result);
+
+    /**
+     * @brief Является ли кодировка однобайтовой
+     * @param codePage Кодовая страница
+     * @return true для Windows-1251, KOI8-R, CP866 и Windows-1252
+     */
+    static bool isSingleByte(uint32_t codePage);
+
+private:
+    /**
+     * @brief Однобайтовые кодировки-кандидаты (в порядке предпочтения при равенстве)
+     */
+    enum SingleByte
+    {
+        SINGLE_BYTE_1251,
+        SINGLE_BYTE_KOI8_R,
+        SINGLE_BYTE_866,
+        SINGLE_BYTE_1252,
+        SINGLE_BYTE_COUNT
+    };
+
+    /**
+     * @brief Оценка блока (или суммы блоков)
+     */
+    struct Score
+    {
+        size_t bytes;                               ///< Просмотрено байт
+        size_t highBytes;                           ///< Байтов 0x80-0xFF
+        bool isUtf8Valid;                           ///< Все блоки - корректный UTF-8
+        size_t utf8Sequences;                       ///< Многобайтовых последовательностей UTF-8
+        size_t utf16Units;                          ///< Двухбайтовых единиц
+        size_t utf16NarrowLE;                       ///< Единиц LE со старшим байтом 0 или 0x04
+        size_t utf16NarrowBE;                       ///< То же для BE
+        size_t utf16PlausibleLE;                    ///< Единиц LE из употребительных диапазонов Unicode
+        size_t utf16PlausibleBE;                    ///< То же для BE
+        double logLikelihood[SINGLE_BYTE_COUNT];    ///< Логарифм правдоподобия однобайтовых кодировок
+    };
+
+    /**
+     * @brief Получить блок выборки: указатель на данные блока (storage - буфер для чтения)
+     * @return false при ошибке чтения
+     */
+    typedef std::function<bool(uint64_t offset, size_t length, std::string& storage,
+                               const char*& sample)> ReadSample;
+
+    /**
+     * @brief Общая часть detect и detectFile
+     * @param size Размер данных
+     * @param read Чтение блока
+     * @param result Результат
+     * @return false при ошибке чтения
+     */
+    static bool run(uint64_t size, const ReadSample& read, Result& result);
+
+    /**
+     * @brief Распознать BOM
+     * @return Длина BOM (0 если его нет)
+     */
+    static size_t detectBom(const unsigned char* bytes, size_t size, uint32_t& codePage);
+
+    /**
+     * @brief Оценить блок
+     * @param data Байты блока
+     * @param size Длина блока
+     * @param isFileStart Блок начинается с начала данных
+     * @param isFileEnd Блок заканчивается концом данных
+     * @param score Оценка
+     */
+    static void scoreSample(const unsigned char* data, size_t size, bool isFileStart, bool isFileEnd, Score& score);
+
+    /**
+     * @brief Прибавить оценку блока к общей
+     */
+    static void accumulate(Score& total, const Score& sample);
+
+    /**
+     * @brief Принять решение по накопленной оценке
+     * @param total Сумма оценок просмотренных блоков
+     * @param isComplete Просмотрены все блоки
+     * @param result Результат
+     * @return true если уверенность достаточна (или блоков больше нет)
+     */
+    static bool decide(const Score& total, bool isComplete, Result& result);
+};
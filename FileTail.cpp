@@ -0,0 +1,130 @@
+#include "FileTail.h"
+#include "PortableFile.h"
+#include "Utf8Codec.h"
+
+FileTail::FileTail()
+    : m_offset(0)
+    , m_knownSize(0)
+    , m_encoding(LargeFileDocument::ENCODING_UTF8)
+{
+}
+
+void FileTail::start(const std::wstring& path, uint64_t offset, LargeFileDocument::Encoding encoding,
+                     const std::vector<wchar_t>& singleByteTable)
+{
+    m_path = path;
+    m_offset = offset;
+    m_knownSize = offset;
+    m_encoding = encoding;
+    m_singleByteTable = singleByteTable;
+    m_singleByteTable.resize(256, L'?');
+    m_pending.clear();
+}
+
+FileTail::Status FileTail::read(std::wstring& text)
+{
+    PortableFile::Info info;
+    if (!PortableFile::getInfo(m_path, info))
+    {
+        return TAIL_FAILED;
+    }
+    m_knownSize = info.size;
+    if (info.size < m_offset)
+    {
+        return TAIL_TRUNCATED;
+    }
+    if (info.size == m_offset)
+    {
+        return TAIL_UNCHANGED;
+    }
+
+    FILE* file = PortableFile::open(m_path, "rb");
+    if (!file)
+    {
+        return TAIL_FAILED;
+    }
+
+    uint64_t available = info.size - m_offset;
+    size_t count = static_cast<size_t>(available < MAX_READ_SIZE ? available : MAX_READ_SIZE);
+    std::string bytes = m_pending;
+    size_t pendingSize = bytes.size();
+    bytes.resize(pendingSize + count);
+    size_t bytesRead = 0;
+    if (PortableFile::seek(file, m_offset))
+    {
+        bytesRead = fread(&bytes[pendingSize], 1, count, file);
+    }
+    fclose(file);
+    if (bytesRead == 0)
+    {
+        return TAIL_FAILED;
+    }
+    bytes.resize(pendingSize + bytesRead);
+    m_offset += bytesRead;
+
+    // Оборванный символ дочитывается при следующем вызове; завершающий '\r'
+    // тоже ждет продолжения, чтобы пара "\r\n" не разошлась по двум чтениям
+    size_t complete = completeLength(bytes.data(), bytes.size());
+    complete -= trailingCarriageReturn(bytes.data(), complete);
+    m_pending.assign(bytes, complete, std::string::npos);
+    LargeFileDocument::decodeBytes(m_encoding, m_singleByteTable, bytes.data(), complete, text);
+    return TAIL_APPENDED;
+}
+
+bool FileTail::hasMoreData() const
+{
+    return m_knownSize > m_offset;
+}
+
+uint64_t FileTail::offset() const
+{
+    return m_offset;
+}
+
+uint64_t FileTail::decodedOffset() const
+{
+    return m_offset - m_pending.size();
+}
+
+size_t FileTail::completeLength(const char* data, size_t size) const
+{
+    switch (m_encoding)
+    {
+    case LargeFileDocument::ENCODING_UTF8:
+        return Utf8Codec::completeLength(data, size);
+    case LargeFileDocument::ENCODING_UTF16LE:
+    case LargeFileDocument::ENCODING_UTF16BE:
+    {
+        // Нечетный байт и старшая половина суррогатной пары ждут продолжения
+        size_t length = size & ~static_cast<size_t>(1);
+        if (length >= 2)
+        {
+            const unsigned char* last = reinterpret_cast<const unsigned char*>(data) + length - 2;
+            unsigned int unit = (m_encoding == LargeFileDocument::ENCODING_UTF16BE)
+                ? ((last[0] << 8) | last[1]) : ((last[1] << 8) | last[0]);
+            if (unit >= 0xD800 && unit <= 0xDBFF)
+            {
+                length -= 2;
+            }
+        }
+        return length;
+    }
+    case LargeFileDocument::ENCODING_SINGLE_BYTE:
+    default:
+        return size;
+    }
+}
+
+size_t FileTail::trailingCarriageReturn(const char* data, size_t size) const
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    switch (m_encoding)
+    {
+    case LargeFileDocument::ENCODING_UTF16LE:
+        return (size >= 2 && bytes[size - 2] == '\r' && bytes[size - 1] == 0) ? 2 : 0;
+    case LargeFileDocument::ENCODING_UTF16BE:
+        return (size >= 2 && bytes[size - 2] == 0 && bytes[size - 1] == '\r') ? 2 : 0;
+    default:
+        return (size >= 1 && bytes[size - 1] == '\r') ? 1 : 0;
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "LargeFileDocument.h"
+
+/**
+ * @brief Чтение дописанного в конец файла текста
+ *
+ * Запоминает смещение уже прочитанной части и при каждом вызове читает
+ * только новые байты. Оборванный на границе чтения символ (UTF-8 или
+ * UTF-16) откладывается до следующего вызова. Файл открывается только на
+ * время чтения, чтобы не мешать ротации журналов. Не зависит от WinAPI.
+ */
+class FileTail
+{
+public:
+    /**
+     * @brief Результат чтения
+     */
+    enum Status
+    {
+        TAIL_UNCHANGED,     ///< Новых данных нет
+        TAIL_APPENDED,      ///< Прочитан дописанный текст
+        TAIL_TRUNCATED,     ///< Файл стал короче прочитанной части (усечен или заменен)
+        TAIL_FAILED         ///< Файл недоступен
+    };
+
+    static const size_t MAX_READ_SIZE = 4 * 1024 * 1024;   ///< Предел чтения за один вызов
+
+    FileTail();
+
+    /**
+     * @brief Начать чтение с заданного смещения
+     * @param path Путь к файлу
+     * @param offset Смещение уже показанной части файла
+     * @param encoding Кодировка файла
+     * @param singleByteTable Таблица однобайтовой кодировки (256 символов)
+     */
+    void start(const std::wstring& path, uint64_t offset, LargeFileDocument::Encoding encoding,
+               const std::vector<wchar_t>& singleByteTable);
+
+    /**
+     * @brief Прочитать новые данные (не больше MAX_READ_SIZE байт)
+     * @param text Строка, в конец которой дописывается декодированный текст
+     * @return Результат чтения
+     */
+    Status read(std::wstring& text);
+
+    /**
+     * @brief Проверить, остались ли непрочитанные данные после последнего чтения
+     * @return true если файл длиннее прочитанной части
+     */
+    bool hasMoreData() const;
+
+    /**
+     * @brief Получить смещение прочитанной части
+     * @return Смещение в байтах
+     */
+    uint64_t offset() const;
+
+    /**
+     * @brief Получить смещение конца декодированного текста
+     *
+     * Меньше offset() на размер отложенного оборванного символа.
+     * @return Смещение в байтах
+     */
+    uint64_t decodedOffset() const;
+
+private:
+    std::wstring m_path;                    ///< Путь к файлу
+    uint64_t m_offset;                      ///< Смещение прочитанной части
+    uint64_t m_knownSize;                   ///< Размер файла при последнем чтении
+    LargeFileDocument::Encoding m_encoding; ///< Кодировка
+    std::vector<wchar_t> m_singleByteTable; ///< Таблица однобайтовой кодировки
+    std::string m_pending;                  ///< Байты оборванного символа
+
+    /**
+     * @brief Длина фрагмента из целых символов
+     * @param data Указатель на байты
+     * @param size Количество байт
+     * @return Количество байт, которые можно декодировать сейчас
+     */
+    size_t completeLength(const char* data, size_t size) const;
+
+    /**
+     * @brief Размер завершающего '\r' в кодировке файла
+     * @param data Указатель на байты
+     * @param size Количество байт
+     * @return Количество байт, отложенных до следующего чтения (0, если '\r' нет)
+     */
+    size_t trailingCarriageReturn(const char* data, size_t size) const;
+};
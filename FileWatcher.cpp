@@ -0,0 +1,213 @@
+#include "FileWatcher.h"
+#include "Utf8Codec.h"
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <cwchar>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef _WIN32
+    const DWORD NOTIFY_BUFFER_SIZE = 16 * 1024;
+#endif
+}
+
+FileWatcher::FileWatcher()
+    : m_stopRequested(false)
+    , m_directoryHandle(nullptr)
+    , m_stopEvent(nullptr)
+    , m_descriptor(-1)
+{
+    m_stopPipe[0] = -1;
+    m_stopPipe[1] = -1;
+}
+
+FileWatcher::~FileWatcher()
+{
+    stop();
+}
+
+bool FileWatcher::start(const std::wstring& path, Callback onChange)
+{
+    stop();
+    m_path = path;
+    m_onChange = onChange;
+    m_stopRequested = false;
+
+#ifdef _WIN32
+    // Уведомления приходят для каталога, поэтому следим за родительской папкой
+    size_t separator = path.find_last_of(L"\\/");
+    std::wstring directory = (separator == std::wstring::npos) ? L"." : path.substr(0, separator);
+    HANDLE hDirectory = CreateFileW(directory.c_str(), FILE_LIST_DIRECTORY,
+                                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                                    OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    if (hDirectory == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    m_directoryHandle = hDirectory;
+    m_stopEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (!m_stopEvent)
+    {
+        CloseHandle(hDirectory);
+        m_directoryHandle = nullptr;
+        return false;
+    }
+#else
+    m_descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_descriptor < 0)
+    {
+        return false;
+    }
+    std::string utf8Path = Utf8Codec::encode(path);
+    if (inotify_add_watch(m_descriptor, utf8Path.c_str(),
+                          IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVE_SELF | IN_DELETE_SELF) < 0 ||
+        pipe(m_stopPipe) != 0)
+    {
+        ::close(m_descriptor);
+        m_descriptor = -1;
+        return false;
+    }
+#endif
+
+    m_thread = std::thread(&FileWatcher::watchLoop, this);
+    return true;
+}
+
+void FileWatcher::stop()
+{
+    if (!m_thread.joinable())
+    {
+        return;
+    }
+
+    m_stopRequested = true;
+#ifdef _WIN32
+    SetEvent(m_stopEvent);
+    m_thread.join();
+    CloseHandle(m_directoryHandle);
+    CloseHandle(m_stopEvent);
+    m_directoryHandle = nullptr;
+    m_stopEvent = nullptr;
+#else
+    char signal = 0;
+    if (write(m_stopPipe[1], &signal, 1) < 0)
+    {
+        // Поток все равно проснется по таймауту и увидит флаг остановки
+    }
+    m_thread.join();
+    ::close(m_descriptor);
+    ::close(m_stopPipe[0]);
+    ::close(m_stopPipe[1]);
+    m_descriptor = -1;
+    m_stopPipe[0] = -1;
+    m_stopPipe[1] = -1;
+#endif
+}
+
+bool FileWatcher::isRunning() const
+{
+    return m_thread.joinable();
+}
+
+void FileWatcher::watchLoop()
+{
+#ifdef _WIN32
+    size_t separator = m_path.find_last_of(L"\\/");
+    std::wstring fileName = (separator == std::wstring::npos) ? m_path : m_path.substr(separator + 1);
+
+    std::vector<DWORD> buffer(NOTIFY_BUFFER_SIZE / sizeof(DWORD));
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    HANDLE handles[2] = { overlapped.hEvent, (HANDLE)m_stopEvent };
+
+    while (!m_stopRequested)
+    {
+        ResetEvent(overlapped.hEvent);
+        if (!ReadDirectoryChangesW((HANDLE)m_directoryHandle, &buffer[0], NOTIFY_BUFFER_SIZE, FALSE,
+                                   FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME,
+                                   NULL, &overlapped, NULL))
+        {
+            break;
+        }
+
+        // NTFS обновляет размер в записи каталога с задержкой, пока писатель
+        // держит файл открытым, поэтому по таймауту файл проверяется и без уведомления
+        DWORD wait = WaitForMultipleObjects(2, handles, FALSE, POLL_INTERVAL);
+        if (wait != WAIT_OBJECT_0)
+        {
+            // Незавершенный запрос отменяется до повторного использования буфера
+            DWORD ignored;
+            CancelIo((HANDLE)m_directoryHandle);
+            GetOverlappedResult((HANDLE)m_directoryHandle, &overlapped, &ignored, TRUE);
+            if (wait != WAIT_TIMEOUT)
+            {
+                break;
+            }
+            m_onChange();
+            continue;
+        }
+
+        DWORD bytesReturned = 0;
+        if (!GetOverlappedResult((HANDLE)m_directoryHandle, &overlapped, &bytesReturned, FALSE))
+        {
+            break;
+        }
+
+        // Переполнение буфера (0 байт) означает, что уведомления потеряны
+        bool isChanged = (bytesReturned == 0);
+        const BYTE* entry = (const BYTE*)&buffer[0];
+        while (!isChanged && bytesReturned > 0)
+        {
+            const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)entry;
+            std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+            isChanged = (_wcsicmp(name.c_str(), fileName.c_str()) == 0);
+            if (info->NextEntryOffset == 0)
+            {
+                break;
+            }
+            entry += info->NextEntryOffset;
+        }
+        if (isChanged)
+        {
+            m_onChange();
+        }
+    }
+    CloseHandle(overlapped.hEvent);
+#else
+    pollfd descriptors[2];
+    descriptors[0].fd = m_descriptor;
+    descriptors[0].events = POLLIN;
+    descriptors[1].fd = m_stopPipe[0];
+    descriptors[1].events = POLLIN;
+
+    char events[4096];
+    while (!m_stopRequested)
+    {
+        int ready = poll(descriptors, 2, static_cast<int>(POLL_INTERVAL));
+        if (ready < 0 || m_stopRequested || (descriptors[1].revents & POLLIN))
+        {
+            break;
+        }
+
+        // Все накопившиеся события сводятся в один вызов обработчика;
+        // по таймауту файл проверяется и без уведомления (например, на сетевом диске)
+        bool isChanged = (ready == 0);
+        while (read(m_descriptor, events, sizeof(events)) > 0)
+        {
+            isChanged = true;
+        }
+        if (isChanged)
+        {
+            m_onChange();
+        }
+    }
+#endif
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Наблюдение за изменениями одного файла
+ *
+ * Фоновый поток ждет уведомлений ОС (ReadDirectoryChangesW в Windows,
+ * inotify в Linux) и вызывает обработчик при каждом изменении файла.
+ * Обработчик вызывается из фонового потока и должен быть коротким
+ * (например, отправлять сообщение окну).
+ */
+class FileWatcher
+{
+public:
+    /**
+     * @brief Обработчик изменения файла
+     */
+    typedef std::function<void()> Callback;
+
+    static const unsigned POLL_INTERVAL = 500;  ///< Интервал контрольной проверки (мс)
+
+    FileWatcher();
+    ~FileWatcher();
+
+    /**
+     * @brief Начать наблюдение
+     * @param path Путь к файлу
+     * @param onChange Обработчик изменения
+     * @return true если наблюдение запущено
+     */
+    bool start(const std::wstring& path, Callback onChange);
+
+    /**
+     * @brief Остановить наблюдение (ждет завершения потока)
+     */
+    void stop();
+
+    /**
+     * @brief Проверить, идет ли наблюдение
+     * @return true если поток запущен
+     */
+    bool isRunning() const;
+
+private:
+    std::wstring m_path;                ///< Путь к файлу
+    Callback m_onChange;                ///< Обработчик изменения
+    std::thread m_thread;               ///< Поток ожидания уведомлений
+    std::atomic<bool> m_stopRequested;  ///< Запрошена остановка
+    void* m_directoryHandle;            ///< Дескриптор каталога (Windows)
+    void* m_stopEvent;                  ///< Событие остановки (Windows)
+    int m_descriptor;                   ///< Дескриптор inotify (Linux)
+    int m_stopPipe[2];                  ///< Канал остановки (Linux)
+
+    /**
+     * @brief Цикл ожидания уведомлений
+     */
+    void watchLoop();
+
+    FileWatcher(const FileWatcher&);
+    FileWatcher& operator=(const FileWatcher&);
+};
@@ -0,0 +1,336 @@
+#include "FoldMap.h"
+#include <algorithm>
+
+namespace
+{
+    const size_t READ_BATCH_LINES = 1024;
+
+    bool isOpening(wchar_t character)
+    {
+        return character == L'(' || character == L'[' || character == L'{';
+    }
+
+    bool isClosing(wchar_t character)
+    {
+        return character == L')' || character == L']' || character == L'}';
+    }
+
+    // Отступ строки в столбцах; false для пустой строки или строки из пробелов
+    bool getIndent(const std::wstring& line, size_t& indent, size_t& textStart)
+    {
+        indent = 0;
+        for (textStart = 0; textStart < line.size(); ++textStart)
+        {
+            if (line[textStart] == L' ')
+            {
+                ++indent;
+            }
+            else if (line[textStart] == L'\t')
+            {
+                indent += FoldMap::TAB_SIZE - indent % FoldMap::TAB_SIZE;
+            }
+            else
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+FoldMap::FoldMap()
+{
+    m_hiddenBefore.assign(1, 0);
+}
+
+void FoldMap::clear()
+{
+    m_folds.clear();
+    m_hidden.clear();
+    m_hiddenBefore.assign(1, 0);
+}
+
+bool FoldMap::toggle(uint64_t header, uint64_t lastLine)
+{
+    std::map<uint64_t, uint64_t>::iterator it = m_folds.find(header);
+    if (it != m_folds.end())
+    {
+        m_folds.erase(it);
+        unhideInterval(header + 1);
+        return false;
+    }
+    if (lastLine <= header)
+    {
+        return false;
+    }
+    m_folds[header] = lastLine;
+    hideInterval(header + 1, lastLine);
+    return true;
+}
+
+bool FoldMap::isFolded(uint64_t header) const
+{
+    return m_folds.find(header) != m_folds.end();
+}
+
+void FoldMap::reveal(uint64_t line)
+{
+    size_t index = intervalAtOrBefore(line);
+    if (index == m_hidden.size() || line > m_hidden[index].last)
+    {
+        return;
+    }
+
+    // Блок скрывает строку, если заголовок выше нее, а конец не выше;
+    // заголовки таких блоков лежат в скрытом интервале строки или перед ним
+    uint64_t first = m_hidden[index].first;
+    std::map<uint64_t, uint64_t>::iterator it = m_folds.lower_bound(first - 1);
+    while (it != m_folds.end() && it->first < line)
+    {
+        if (it->second >= line)
+        {
+            it = m_folds.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    unhideInterval(first);
+}
+
+size_t FoldMap::foldCount() const
+{
+    return m_folds.size();
+}
+
+uint64_t FoldMap::visibleLineCount(uint64_t lineCount) const
+{
+    uint64_t hidden = m_hiddenBefore.back();
+    return lineCount > hidden ? lineCount - hidden : 0;
+}
+
+uint64_t FoldMap::toVisible(uint64_t line) const
+{
+    size_t index = intervalAtOrBefore(line);
+    if (index == m_hidden.size())
+    {
+        return line;
+    }
+    if (line <= m_hidden[index].last)
+    {
+        // Скрытая строка показывается заголовком своего блока
+        return m_hidden[index].first - 1 - m_hiddenBefore[index];
+    }
+    return line - m_hiddenBefore[index + 1];
+}
+
+uint64_t FoldMap::toDocument(uint64_t visibleLine) const
+{
+    // Строка после интервала i имеет видимый номер не меньше first - hiddenBefore[i];
+    // эти номера строго возрастают, поэтому подходит двоичный поиск
+    size_t low = 0;
+    size_t high = m_hidden.size();
+    while (low < high)
+    {
+        size_t middle = (low + high) / 2;
+        if (m_hidden[middle].first - m_hiddenBefore[middle] <= visibleLine)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return visibleLine + m_hiddenBefore[low];
+}
+
+uint64_t FoldMap::visibleRunEnd(uint64_t line) const
+{
+    size_t index = intervalAtOrBefore(line);
+    size_t next = index == m_hidden.size() ? 0 : index + 1;
+    return next < m_hidden.size() ? m_hidden[next].first : NO_LINE;
+}
+
+uint64_t FoldMap::nextVisible(uint64_t line) const
+{
+    size_t index = intervalAtOrBefore(line + 1);
+    if (index != m_hidden.size() && line + 1 <= m_hidden[index].last)
+    {
+        return m_hidden[index].last + 1;
+    }
+    return line + 1;
+}
+
+bool FoldMap::findRegion(uint64_t header, const LineReader& reader, uint64_t& lastLine)
+{
+    std::vector<std::wstring> lines;
+    if (reader(header, 1, lines) == 0)
+    {
+        return false;
+    }
+    const std::wstring headerText = lines[0];
+    size_t headerIndent = 0;
+    size_t textStart = 0;
+    if (!getIndent(headerText, headerIndent, textStart))
+    {
+        return false;
+    }
+
+    size_t end = headerText.find_last_not_of(L" \t");
+    bool isBracketBlock = isOpening(headerText[end]);
+    size_t depth = 0;
+    if (isBracketBlock)
+    {
+        for (size_t i = textStart; i <= end; ++i)
+        {
+            if (isOpening(headerText[i]))
+            {
+                ++depth;
+            }
+            else if (isClosing(headerText[i]) && depth > 0)
+            {
+                --depth;
+            }
+        }
+    }
+
+    // Строки читаются пачками; блок длиннее предела не сворачивается
+    uint64_t last = NO_LINE;
+    uint64_t line = header + 1;
+    while (line - header <= MAX_REGION_LINES)
+    {
+        size_t count = reader(line, READ_BATCH_LINES, lines);
+        for (size_t i = 0; i < count; ++i, ++line)
+        {
+            const std::wstring& text = lines[i];
+            if (isBracketBlock)
+            {
+                for (size_t j = 0; j < text.size(); ++j)
+                {
+                    depth += isOpening(text[j]) ? 1 : 0;
+                    if (isClosing(text[j]) && --depth == 0)
+                    {
+                        lastLine = line;
+                        return true;
+                    }
+                }
+                continue;
+            }
+
+            size_t indent = 0;
+            if (!getIndent(text, indent, textStart))
+            {
+                continue;
+            }
+            if (indent > headerIndent)
+            {
+                last = line;
+                continue;
+            }
+
+            // Закрывающая строка на уровне заголовка сворачивается вместе с блоком
+            if (indent == headerIndent && last != NO_LINE &&
+                (isClosing(text[textStart]) || text.compare(textStart, 2, L"</") == 0))
+            {
+                last = line;
+            }
+            lastLine = last;
+            return last != NO_LINE;
+        }
+
+        if (count < READ_BATCH_LINES)
+        {
+            // Конец документа: блок по отступам кончается на последней вложенной строке
+            lastLine = last;
+            return !isBracketBlock && last != NO_LINE;
+        }
+    }
+    return false;
+}
+
+void FoldMap::hideInterval(uint64_t first, uint64_t last)
+{
+    // Новый интервал поглощает пересекающиеся с ним и соседние интервалы
+    Interval merged = { first, last };
+    size_t begin = intervalAtOrBefore(first);
+    if (begin == m_hidden.size() || m_hidden[begin].last + 1 < first)
+    {
+        begin = (begin == m_hidden.size()) ? 0 : begin + 1;
+    }
+    size_t end = begin;
+    while (end < m_hidden.size() && m_hidden[end].first <= last + 1)
+    {
+        merged.first = std::min(merged.first, m_hidden[end].first);
+        merged.last = std::max(merged.last, m_hidden[end].last);
+        ++end;
+    }
+    replaceIntervals(begin, end - begin, std::vector<Interval>(1, merged));
+}
+
+void FoldMap::unhideInterval(uint64_t first)
+{
+    // Развернутый блок лежал внутри одного интервала: он собирается заново
+    // только из блоков, заголовки которых попадают в этот интервал
+    size_t index = intervalAtOrBefore(first);
+    const Interval old = m_hidden[index];
+    std::vector<Interval> pieces;
+    std::map<uint64_t, uint64_t>::const_iterator it = m_folds.lower_bound(old.first - 1);
+    for (; it != m_folds.end() && it->first < old.last; ++it)
+    {
+        Interval interval = { it->first + 1, it->second };
+        if (!pieces.empty() && interval.first <= pieces.back().last + 1)
+        {
+            pieces.back().last = std::max(pieces.back().last, interval.last);
+        }
+        else
+        {
+            pieces.push_back(interval);
+        }
+    }
+    replaceIntervals(index, 1, pieces);
+}
+
+void FoldMap::replaceIntervals(size_t index, size_t count, const std::vector<Interval>& intervals)
+{
+    uint64_t removed = m_hiddenBefore[index + count] - m_hiddenBefore[index];
+    m_hidden.erase(m_hidden.begin() + index, m_hidden.begin() + index + count);
+    m_hidden.insert(m_hidden.begin() + index, intervals.begin(), intervals.end());
+
+    std::vector<uint64_t> sums(intervals.size());
+    uint64_t total = m_hiddenBefore[index];
+    for (size_t i = 0; i < intervals.size(); ++i)
+    {
+        total += intervals[i].last - intervals[i].first + 1;
+        sums[i] = total;
+    }
+    m_hiddenBefore.erase(m_hiddenBefore.begin() + index + 1, m_hiddenBefore.begin() + index + 1 + count);
+    m_hiddenBefore.insert(m_hiddenBefore.begin() + index + 1, sums.begin(), sums.end());
+
+    // Суммы за измененным участком сдвигаются на разницу скрытых строк
+    uint64_t delta = (total - m_hiddenBefore[index]) - removed;
+    for (size_t i = index + 1 + intervals.size(); i < m_hiddenBefore.size(); ++i)
+    {
+        m_hiddenBefore[i] += delta;
+    }
+}
+
+size_t FoldMap::intervalAtOrBefore(uint64_t line) const
+{
+    size_t low = 0;
+    size_t high = m_hidden.size();
+    while (low < high)
+    {
+        size_t middle = (low + high) / 2;
+        if (m_hidden[middle].first <= line)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low == 0 ? m_hidden.size() : low - 1;
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Свернутые блоки документа и соответствие видимых строк строкам документа
+ *
+ * Свернутый блок - строка-заголовок и скрытые за ней строки. Вложенные и
+ * пересекающиеся блоки объединяются в упорядоченный список непересекающихся
+ * скрытых интервалов с префиксными суммами их длин, поэтому перевод номера
+ * видимой строки в номер строки документа и обратно - двоичный поиск,
+ * O(log n) независимо от числа свернутых блоков. Сворачивание,
+ * разворачивание и reveal меняют только затронутый участок списка,
+ * собирая его из блоков с заголовками внутри этого участка. Отрисовка
+ * окна переходит от строки к строке за O(1), перескакивая скрытые
+ * интервалы. Не зависит от WinAPI.
+ */
+class FoldMap
+{
+public:
+    /**
+     * @brief Прочитать строки документа
+     * @param firstLine Первая строка
+     * @param count Количество строк
+     * @param lines Текст строк (без перевода строки)
+     * @return Количество прочитанных строк (меньше count в конце документа)
+     */
+    typedef std::function<size_t(uint64_t firstLine, size_t count, std::vector<std::wstring>& lines)> LineReader;
+
+    static const uint64_t NO_LINE = ~0ULL;                  ///< Нет строки
+    static const uint64_t MAX_REGION_LINES = 1000000;       ///< Предел просмотра при поиске блока
+    static const size_t TAB_SIZE = 4;                       ///< Ширина табуляции для отступов
+
+    FoldMap();
+
+    /**
+     * @brief Развернуть все блоки
+     */
+    void clear();
+
+    /**
+     * @brief Свернуть блок или развернуть свернутый с тем же заголовком
+     * @param header Строка-заголовок
+     * @param lastLine Последняя скрываемая строка
+     * @return true если блок свернут
+     */
+    bool toggle(uint64_t header, uint64_t lastLine);
+
+    /**
+     * @brief Проверить, свернут ли блок с заголовком
+     * @param header Строка-заголовок
+     * @return true если свернут
+     */
+    bool isFolded(uint64_t header) const;
+
+    /**
+     * @brief Развернуть все блоки, скрывающие строку
+     * @param line Строка документа
+     */
+    void reveal(uint64_t line);
+
+    /**
+     * @brief Получить количество свернутых блоков
+     * @return Количество блоков
+     */
+    size_t foldCount() const;
+
+    /**
+     * @brief Получить количество видимых строк
+     * @param lineCount Количество строк документа
+     * @return Количество строк без скрытых
+     */
+    uint64_t visibleLineCount(uint64_t lineCount) const;
+
+    /**
+     * @brief Перевести строку документа в номер видимой строки
+     * @param line Строка документа (скрытая - в номер ее заголовка)
+     * @return Номер видимой строки
+     */
+    uint64_t toVisible(uint64_t line) const;
+
+    /**
+     * @brief Перевести номер видимой строки в строку документа
+     * @param visibleLine Номер видимой строки
+     * @return Строка документа
+     */
+    uint64_t toDocument(uint64_t visibleLine) const;
+
+    /**
+     * @brief Получить конец непрерывного участка видимых строк
+     * @param line Видимая строка документа
+     * @return Первая скрытая строка после line или NO_LINE
+     */
+    uint64_t visibleRunEnd(uint64_t line) const;
+
+    /**
+     * @brief Получить следующую видимую строку
+     * @param line Видимая строка документа
+     * @return Следующая видимая строка документа
+     */
+    uint64_t nextVisible(uint64_t line) const;
+
+    /**
+     * @brief Найти блок, который сворачивается по строке-заголовку
+     *
+     * Если строка кончается открывающей скобкой, блок доходит до строки
+     * с парной закрывающей скобкой. Иначе в блок входят следующие строки
+     * с отступом больше, чем у заголовка (и пустые строки между ними), а
+     * также строка с тем же отступом, начинающаяся с закрывающей скобки
+     * или закрывающего тега.
+     * @param header Строка-заголовок
+     * @param reader Чтение строк документа
+     * @param lastLine Последняя строка блока
+     * @return false если блока нет или он длиннее MAX_REGION_LINES
+     */
+    static bool findRegion(uint64_t header, const LineReader& reader, uint64_t& lastLine);
+
+private:
+    /**
+     * @brief Скрытый интервал строк [first, last]
+     */
+    struct Interval
+    {
+        uint64_t first;
+        uint64_t last;
+    };
+
+    std::map<uint64_t, uint64_t> m_folds;   ///< Свернутые блоки: заголовок -> последняя строка
+    std::vector<Interval> m_hidden;         ///< Непересекающиеся скрытые интервалы по возрастанию
+    std::vector<uint64_t> m_hiddenBefore;   ///< Скрытых строк в интервалах [0, i)
+
+    /**
+     * @brief Добавить свернутый интервал [first, last] без перестройки списка
+     */
+    void hideInterval(uint64_t first, uint64_t last);
+
+    /**
+     * @brief Пересобрать интервал, содержащий строку first развернутого блока
+     */
+    void unhideInterval(uint64_t first);
+
+    /**
+     * @brief Заменить count интервалов с номера index и обновить префиксные суммы
+     */
+    void replaceIntervals(size_t index, size_t count, const std::vector<Interval>& intervals);
+
+    /**
+     * @brief Найти последний интервал, начинающийся не позже строки
+     * @return Номер интервала или m_hidden.size()
+     */
+    size_t intervalAtOrBefore(uint64_t line) const;
+};
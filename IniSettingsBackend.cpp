@@ -0,0 +1,165 @@
+#include "IniSettingsBackend.h"
+#include "PortableFile.h"
+#include "Utf8Codec.h"
+#include <cstdlib>
+
+const char* IniSettingsBackend::SECTION_NAME = "Settings";
+
+IniSettingsBackend::IniSettingsBackend(const std::wstring& filePath)
+    : m_filePath(filePath)
+{
+}
+
+bool IniSettingsBackend::loadAll(SettingsMap& values)
+{
+    FILE* file = PortableFile::open(m_filePath, "rb");
+    if (!file)
+    {
+        return true; // Файла еще нет - используются значения по умолчанию
+    }
+
+    // Читаем файл целиком одним вызовом
+    std::string content;
+    char chunk[4096];
+    size_t bytesRead;
+    while ((bytesRead = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        content.append(chunk, bytesRead);
+    }
+    fclose(file);
+
+    bool inSection = false;
+    size_t lineStart = 0;
+    while (lineStart < content.size())
+    {
+        size_t lineEnd = content.find('\n', lineStart);
+        if (lineEnd == std::string::npos)
+        {
+            lineEnd = content.size();
+        }
+
+        std::string line = content.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
+        if (!line.empty() && line[line.size() - 1] == '\r')
+        {
+            line.erase(line.size() - 1);
+        }
+        if (line.empty() || line[0] == ';' || line[0] == '#')
+        {
+            continue;
+        }
+        if (line[0] == '[')
+        {
+            inSection = (line == std::string("[") + SECTION_NAME + "]");
+            continue;
+        }
+        if (!inSection)
+        {
+            continue;
+        }
+
+        size_t separator = line.find('=');
+        if (separator == std::string::npos || separator + 2 >= line.size() ||
+            line[separator + 2] != ':')
+        {
+            continue; // Пропускаем поврежденные строки
+        }
+
+        std::wstring name = Utf8Codec::decode(line.substr(0, separator));
+        char typeTag = line[separator + 1];
+        std::string rawValue = line.substr(separator + 3);
+
+        if (typeTag == 's')
+        {
+            values[name] = SettingValue::fromString(Utf8Codec::decode(unescape(rawValue)));
+        }
+        else if (typeTag == 'd')
+        {
+            values[name] = SettingValue::fromNumber(
+                static_cast<uint32_t>(strtoul(rawValue.c_str(), nullptr, 10)));
+        }
+    }
+    return true;
+}
+
+bool IniSettingsBackend::saveBatch(const SettingsMap& values, const std::set<std::wstring>& dirtyNames)
+{
+    (void)dirtyNames; // INI-файл всегда переписывается целиком
+
+    std::string content = std::string("[") + SECTION_NAME + "]\n";
+    for (SettingsMap::const_iterator it = values.begin(); it != values.end(); ++it)
+    {
+        content += Utf8Codec::encode(it->first);
+        if (it->second.type == SettingValue::String)
+        {
+            content += "=s:";
+            content += escape(Utf8Codec::encode(it->second.text));
+        }
+        else
+        {
+            content += "=d:";
+            content += std::to_string(it->second.number);
+        }
+        content += '\n';
+    }
+
+    std::wstring tempPath = m_filePath + L".tmp";
+    FILE* file = PortableFile::open(tempPath, "wb");
+    if (!file)
+    {
+        return false;
+    }
+
+    bool success = fwrite(content.data(), 1, content.size(), file) == content.size();
+    success = PortableFile::sync(file) && success;
+    fclose(file);
+
+    if (!success || !PortableFile::replace(tempPath, m_filePath))
+    {
+        PortableFile::remove(tempPath);
+        return false;
+    }
+    return true;
+}
+
+std::string IniSettingsBackend::escape(const std::string& text)
+{
+    std::string result;
+    result.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        switch (text[i])
+        {
+        case '\\': result += "\\\\"; break;
+        case '\n': result += "\\n"; break;
+        case '\r': result += "\\r"; break;
+        default: result += text[i]; break;
+        }
+    }
+    return result;
+}
+
+std::string IniSettingsBackend::unescape(const std::string& text)
+{
+    std::string result;
+    result.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        if (text[i] == '\\' && i + 1 < text.size())
+        {
+            ++i;
+            switch (text[i])
+            {
+            case 'n': result += '\n'; break;
+            case 'r': result += '\r'; break;
+            default: result += text[i]; break;
+            }
+        }
+        else
+        {
+            result += text[i];
+        }
+    }
+    return result;
+}
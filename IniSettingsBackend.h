@@ -0,0 +1,43 @@
+#pragma once
+
+#include "SettingsBackend.h"
+
+/**
+ * @brief Файловый бэкенд настроек в формате INI
+ *
+ * Файл хранится в UTF-8, каждое значение записывается как
+ * "Имя=s:строка" или "Имя=d:число". Запись выполняется во временный
+ * файл с последующей атомарной заменой, поэтому прерванное сохранение
+ * не повреждает существующие настройки. Бэкенд не зависит от WinAPI.
+ */
+class IniSettingsBackend : public ISettingsBackend
+{
+public:
+    /**
+     * @brief Конструктор
+     * @param filePath Путь к INI-файлу
+     */
+    explicit IniSettingsBackend(const std::wstring& filePath);
+
+    bool loadAll(SettingsMap& values) override;
+    bool saveBatch(const SettingsMap& values, const std::set<std::wstring>& dirtyNames) override;
+
+private:
+    std::wstring m_filePath;    ///< Путь к INI-файлу
+
+    static const char* SECTION_NAME;
+
+    /**
+     * @brief Экранировать перевод строки и обратную косую черту
+     * @param text Исходный текст в UTF-8
+     * @return Экранированный текст
+     */
+    static std::string escape(const std::string& text);
+
+    /**
+     * @brief Снять экранирование
+     * @param text Экранированный текст в UTF-8
+     * @return Исходный текст
+     */
+    static std::string unescape(const std::string& text);
+};
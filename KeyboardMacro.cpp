@@ -0,0 +1,99 @@
+#include "KeyboardMacro.h"
+
+namespace
+{
+    const size_t WORD_MASK = 0xFFFF;
+}
+
+KeyboardMacro::KeyboardMacro()
+    : m_lastStep(0)
+{
+}
+
+void KeyboardMacro::clear()
+{
+    m_code.clear();
+    m_lastStep = 0;
+}
+
+bool KeyboardMacro::isEmpty() const
+{
+    return m_code.empty();
+}
+
+void KeyboardMacro::recordOperation(Opcode opcode)
+{
+    addStep(opcode, 1, true);
+}
+
+void KeyboardMacro::recordText(const wchar_t* text, size_t length)
+{
+    if (length == 0)
+    {
+        return;
+    }
+    addStep(OP_INSERT, length, true);
+    m_code.insert(m_code.end(), text, text + length);
+}
+
+void KeyboardMacro::recordFind(const std::wstring& text)
+{
+    // Поиск не сливается: каждое нажатие F3 ищет следующее вхождение
+    addStep(OP_FIND_NEXT, text.size(), false);
+    m_code.insert(m_code.end(), text.begin(), text.end());
+}
+
+void KeyboardMacro::decode(std::vector<Step>& steps) const
+{
+    steps.clear();
+    size_t position = 0;
+    while (position + HEADER_SIZE <= m_code.size())
+    {
+        Step step;
+        step.opcode = static_cast<Opcode>(m_code[position]);
+        size_t count = (static_cast<size_t>(m_code[position + 1]) & WORD_MASK) |
+                       ((static_cast<size_t>(m_code[position + 2]) & WORD_MASK) << 16);
+        position += HEADER_SIZE;
+
+        if (step.opcode == OP_INSERT || step.opcode == OP_FIND_NEXT)
+        {
+            step.count = 1;
+            step.text = m_code.data() + position;
+            step.length = count;
+            position += count;
+        }
+        else
+        {
+            step.count = count;
+            step.text = nullptr;
+            step.length = 0;
+        }
+        steps.push_back(step);
+    }
+}
+
+size_t KeyboardMacro::codeSize() const
+{
+    return m_code.size();
+}
+
+void KeyboardMacro::addStep(Opcode opcode, size_t count, bool canMerge)
+{
+    if (canMerge && !m_code.empty() && m_code[m_lastStep] == static_cast<wchar_t>(opcode))
+    {
+        size_t total = (static_cast<size_t>(m_code[m_lastStep + 1]) & WORD_MASK) |
+                       ((static_cast<size_t>(m_code[m_lastStep + 2]) & WORD_MASK) << 16);
+        total += count;
+        if (total <= 0xFFFFFFFF)
+        {
+            m_code[m_lastStep + 1] = static_cast<wchar_t>(total & WORD_MASK);
+            m_code[m_lastStep + 2] = static_cast<wchar_t>((total >> 16) & WORD_MASK);
+            return;
+        }
+    }
+
+    m_lastStep = m_code.size();
+    m_code.push_back(static_cast<wchar_t>(opcode));
+    m_code.push_back(static_cast<wchar_t>(count & WORD_MASK));
+    m_code.push_back(static_cast<wchar_t>((count >> 16) & WORD_MASK));
+}
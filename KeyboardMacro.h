@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Записанный макрос клавиатуры в виде компактного байт-кода
+ *
+ * Каждый шаг - единица с кодом операции, две единицы счетчика (число
+ * повторов для перемещений и удалений, длина для ввода текста и поиска)
+ * и символы текста. Подряд идущие одинаковые шаги при записи сливаются
+ * (набранные символы - в одну вставку, нажатия стрелки - в одно
+ * перемещение со счетчиком), поэтому макрос занимает несколько десятков
+ * единиц и разбирается один раз на все повторы. Не зависит от WinAPI.
+ */
+class KeyboardMacro
+{
+public:
+    /**
+     * @brief Операция шага
+     */
+    enum Opcode
+    {
+        OP_INSERT = 1,      ///< Вставить текст (заменяет выделение)
+        OP_DELETE_BACK,     ///< Удалить выделение или символ перед курсором
+        OP_DELETE_FORWARD,  ///< Удалить выделение или символ после курсора
+        OP_CHAR_LEFT,       ///< Курсор на символ влево
+        OP_CHAR_RIGHT,      ///< Курсор на символ вправо
+        OP_LINE_UP,         ///< Курсор на строку вверх
+        OP_LINE_DOWN,       ///< Курсор на строку вниз
+        OP_LINE_HOME,       ///< Курсор в начало строки
+        OP_LINE_END,        ///< Курсор в конец строки
+        OP_FIND_NEXT        ///< Выделить следующее вхождение текста
+    };
+
+    /**
+     * @brief Шаг макроса, разобранный из байт-кода
+     */
+    struct Step
+    {
+        Opcode opcode;          ///< Операция
+        size_t count;           ///< Число повторов (для OP_INSERT и OP_FIND_NEXT - 1)
+        const wchar_t* text;    ///< Текст операнда (для OP_INSERT и OP_FIND_NEXT)
+        size_t length;          ///< Длина текста
+    };
+
+    KeyboardMacro();
+
+    /**
+     * @brief Очистить макрос
+     */
+    void clear();
+
+    /**
+     * @brief Проверить, пуст ли макрос
+     * @return true если шагов нет
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief Записать операцию без текста
+     * @param opcode Операция (кроме OP_INSERT и OP_FIND_NEXT)
+     */
+    void recordOperation(Opcode opcode);
+
+    /**
+     * @brief Записать ввод текста
+     * @param text Текст
+     * @param length Длина текста
+     */
+    void recordText(const wchar_t* text, size_t length);
+
+    /**
+     * @brief Записать поиск следующего вхождения
+     * @param text Искомый текст
+     */
+    void recordFind(const std::wstring& text);
+
+    /**
+     * @brief Разобрать шаги макроса
+     * @param steps Результат (указатели на текст действительны, пока макрос не изменен)
+     */
+    void decode(std::vector<Step>& steps) const;
+
+    /**
+     * @brief Получить размер байт-кода
+     * @return Количество единиц wchar_t
+     */
+    size_t codeSize() const;
+
+private:
+    static const size_t HEADER_SIZE = 3;    ///< Операция и два слова счетчика
+
+    std::vector<wchar_t> m_code;    ///< Байт-код в единицах wchar_t
+    size_t m_lastStep;              ///< Начало последнего шага (для слияния)
+
+    /**
+     * @brief Начать новый шаг или продолжить последний такой же
+     * @param opcode Операция
+     * @param count Прибавка к счетчику
+     * @param canMerge Можно ли слить с последним шагом
+     */
+    void addStep(Opcode opcode, size_t count, bool canMerge);
+};
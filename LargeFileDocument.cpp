@@ -0,0 +1,597 @@
+#include "LargeFileDocument.h"
+#include "PortableFile.h"
+#include "Utf8Codec.h"
+#include <cstring>
+
+namespace
+{
+    const size_t DETECT_SAMPLE_SIZE = 64 * 1024;
+    const size_t FIND_BUFFER_SIZE = 1024 * 1024;
+
+    /**
+     * @brief Дописать кодовую точку в строку с учетом размера wchar_t
+     */
+    void appendCodePoint(unsigned int codePoint, std::wstring& output)
+    {
+        if (sizeof(wchar_t) == 2 && codePoint > 0xFFFF)
+        {
+            codePoint -= 0x10000;
+            output.push_back(static_cast<wchar_t>(0xD800 + (codePoint >> 10)));
+            output.push_back(static_cast<wchar_t>(0xDC00 + (codePoint & 0x3FF)));
+        }
+        else
+        {
+            output.push_back(static_cast<wchar_t>(codePoint));
+        }
+    }
+}
+
+LargeFileDocument::LargeFileDocument()
+    : m_encoding(ENCODING_UTF8)
+    , m_dataStart(0)
+    , m_cache(CACHE_BLOCK_SIZE, CACHE_BLOCK_COUNT)
+    , m_hintLine(0)
+    , m_hintOffset(0)
+{
+}
+
+LargeFileDocument::~LargeFileDocument()
+{
+    close();
+}
+
+bool LargeFileDocument::open(const std::wstring& path, const std::vector<wchar_t>& singleByteTable)
+{
+    close();
+    if (!m_cache.open(path))
+    {
+        return false;
+    }
+
+    m_path = path;
+    m_singleByteTable = singleByteTable;
+    if (m_singleByteTable.size() != 256)
+    {
+        m_singleByteTable.resize(256);
+        for (size_t i = 0; i < 256; ++i)
+        {
+            m_singleByteTable[i] = static_cast<wchar_t>(i);
+        }
+    }
+
+    // Кодировка определяется по BOM или по началу файла
+    std::string sample;
+    m_cache.read(0, DETECT_SAMPLE_SIZE, sample);
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(sample.data());
+    m_dataStart = 0;
+    if (sample.size() >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF)
+    {
+        m_encoding = ENCODING_UTF8;
+        m_dataStart = 3;
+    }
+    else if (sample.size() >= 2 && bytes[0] == 0xFF && bytes[1] == 0xFE)
+    {
+        m_encoding = ENCODING_UTF16LE;
+        m_dataStart = 2;
+    }
+    else if (sample.size() >= 2 && bytes[0] == 0xFE && bytes[1] == 0xFF)
+    {
+        m_encoding = ENCODING_UTF16BE;
+        m_dataStart = 2;
+    }
+    else if (Utf8Codec::isValid(sample.data(), sample.size(), sample.size() < m_cache.fileSize()))
+    {
+        m_encoding = ENCODING_UTF8;
+    }
+    else
+    {
+        m_encoding = ENCODING_SINGLE_BYTE;
+    }
+
+    m_hintLine = 0;
+    m_hintOffset = m_dataStart;
+    m_index.start(path, m_dataStart, unitSize(), m_encoding == ENCODING_UTF16BE);
+    return true;
+}
+
+void LargeFileDocument::close()
+{
+    m_index.stop();
+    m_cache.close();
+    m_path.clear();
+    m_hintLine = 0;
+    m_hintOffset = 0;
+}
+
+const std::wstring& LargeFileDocument::path() const
+{
+    return m_path;
+}
+
+LargeFileDocument::Encoding LargeFileDocument::encoding() const
+{
+    return m_encoding;
+}
+
+uint64_t LargeFileDocument::fileSize() const
+{
+    return m_cache.fileSize();
+}
+
+uint64_t LargeFileDocument::lineCount() const
+{
+    return m_index.lineCount();
+}
+
+bool LargeFileDocument::isIndexComplete() const
+{
+    return m_index.isComplete();
+}
+
+double LargeFileDocument::indexProgress() const
+{
+    if (m_index.isComplete() || m_cache.fileSize() == 0)
+    {
+        return 1.0;
+    }
+    return static_cast<double>(m_index.scannedBytes()) / static_cast<double>(m_cache.fileSize());
+}
+
+size_t LargeFileDocument::readLines(uint64_t firstLine, size_t count, std::vector<std::wstring>& lines)
+{
+    lines.clear();
+    uint64_t offset;
+    if (!lineStartOffset(firstLine, offset))
+    {
+        return 0;
+    }
+
+    std::string bytes;
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint64_t lineEnd;
+        uint64_t nextLine;
+        LineScan scan = scanLine(offset, lineEnd, nextLine);
+
+        // Длинные строки обрезаются: в память читается не больше MAX_LINE_BYTES
+        uint64_t length = lineEnd - offset;
+        bytes.clear();
+        m_cache.read(offset, static_cast<size_t>(length < MAX_LINE_BYTES ? length : MAX_LINE_BYTES), bytes);
+
+        lines.push_back(std::wstring());
+        decode(bytes.data(), bytes.size(), lines.back());
+        if (!lines.back().empty() && lines.back()[lines.back().size() - 1] == L'\r')
+        {
+            lines.back().erase(lines.back().size() - 1);
+        }
+
+        if (scan != LINE_NEXT)
+        {
+            break;
+        }
+        offset = nextLine;
+    }
+    return lines.size();
+}
+
+size_t LargeFileDocument::readSegments(uint64_t firstLine, size_t count, uint64_t column, size_t columnCount,
+                                       std::vector<LineSegment>& segments)
+{
+    segments.clear();
+    uint64_t offset;
+    if (!lineStartOffset(firstLine, offset))
+    {
+        return 0;
+    }
+
+    std::string bytes;
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint64_t lineEnd;
+        uint64_t nextLine;
+        LineScan scan = scanLine(offset, lineEnd, nextLine);
+
+        segments.push_back(LineSegment());
+        LineSegment& segment = segments.back();
+        if (scan != LINE_PENDING && lineEnd - offset <= MAX_LINE_BYTES)
+        {
+            bytes.clear();
+            m_cache.read(offset, static_cast<size_t>(lineEnd - offset), bytes);
+            decode(bytes.data(), bytes.size(), segment.text);
+            if (!segment.text.empty() && segment.text[segment.text.size() - 1] == L'\r')
+            {
+                segment.text.erase(segment.text.size() - 1);
+            }
+            segment.column = 0;
+            segment.length = segment.text.size();
+            segment.isLong = false;
+        }
+        else
+        {
+            readSegment(offset, lineEnd, scan == LINE_PENDING, column, columnCount, segment);
+        }
+
+        if (scan != LINE_NEXT)
+        {
+            break;
+        }
+        offset = nextLine;
+    }
+    return segments.size();
+}
+
+bool LargeFileDocument::lineStartOffset(uint64_t line, uint64_t& offset)
+{
+    uint64_t currentLine;
+    uint64_t currentOffset;
+    if (!m_index.checkpointForLine(line, currentLine, currentOffset))
+    {
+        return false;
+    }
+
+    // Последовательная прокрутка продолжает просмотр с последней найденной строки
+    if (m_hintLine <= line && m_hintLine > currentLine)
+    {
+        currentLine = m_hintLine;
+        currentOffset = m_hintOffset;
+    }
+
+    while (currentLine < line)
+    {
+        uint64_t lineEnd;
+        uint64_t nextLine;
+        if (scanLine(currentOffset, lineEnd, nextLine) != LINE_NEXT)
+        {
+            return false;
+        }
+        currentOffset = nextLine;
+        ++currentLine;
+    }
+
+    m_hintLine = currentLine;
+    m_hintOffset = currentOffset;
+    offset = currentOffset;
+    return true;
+}
+
+bool LargeFileDocument::lineOfOffset(uint64_t offset, uint64_t& line)
+{
+    uint64_t currentLine;
+    uint64_t currentOffset;
+    if (offset < m_dataStart)
+    {
+        offset = m_dataStart;
+    }
+    if (!m_index.checkpointForOffset(offset, currentLine, currentOffset))
+    {
+        return false;
+    }
+
+    for (;;)
+    {
+        uint64_t lineEnd;
+        uint64_t nextLine;
+        if (scanLine(currentOffset, lineEnd, nextLine) != LINE_NEXT || nextLine > offset)
+        {
+            break;
+        }
+        currentOffset = nextLine;
+        ++currentLine;
+    }
+    line = currentLine;
+    return true;
+}
+
+bool LargeFileDocument::columnOfOffset(uint64_t line, uint64_t offset, uint64_t& column)
+{
+    uint64_t lineStart;
+    if (!lineStartOffset(line, lineStart) || offset < lineStart)
+    {
+        return false;
+    }
+
+    uint64_t lineEnd;
+    uint64_t nextLine;
+    uint64_t length = offset - lineStart;
+    if (scanLine(lineStart, lineEnd, nextLine) == LINE_PENDING || lineEnd - lineStart > MAX_LINE_BYTES)
+    {
+        column = length / unitSize();
+        return true;
+    }
+
+    std::string bytes;
+    m_cache.read(lineStart, static_cast<size_t>(length), bytes);
+
+    std::wstring prefix;
+    decode(bytes.data(), bytes.size(), prefix);
+    column = prefix.size();
+    return true;
+}
+
+uint64_t LargeFileDocument::find(const std::wstring& text, uint64_t fromOffset, const std::atomic<bool>* cancel) const
+{
+    std::string needle;
+    if (text.empty() || !encode(text, needle))
+    {
+        return NOT_FOUND;
+    }
+
+    FILE* file = PortableFile::open(m_path, "rb");
+    if (!file)
+    {
+        return NOT_FOUND;
+    }
+
+    // Соседние куски перекрываются на длину образца без одного байта
+    unsigned unit = unitSize();
+    uint64_t position = fromOffset < m_dataStart ? m_dataStart : fromOffset;
+    std::vector<char> buffer(FIND_BUFFER_SIZE + needle.size());
+    uint64_t result = NOT_FOUND;
+    while (result == NOT_FOUND && !(cancel && cancel->load()) && PortableFile::seek(file, position))
+    {
+        size_t count = fread(buffer.data(), 1, buffer.size(), file);
+        if (count < needle.size())
+        {
+            break;
+        }
+
+        const char* end = buffer.data() + count - needle.size() + 1;
+        for (const char* candidate = buffer.data(); candidate < end; ++candidate)
+        {
+            candidate = static_cast<const char*>(memchr(candidate, needle[0], static_cast<size_t>(end - candidate)));
+            if (!candidate)
+            {
+                break;
+            }
+
+            uint64_t offset = position + static_cast<uint64_t>(candidate - buffer.data());
+            if ((offset - m_dataStart) % unit == 0 && memcmp(candidate, needle.data(), needle.size()) == 0)
+            {
+                result = offset;
+                break;
+            }
+        }
+
+        if (count < buffer.size())
+        {
+            break;
+        }
+        position += count - needle.size() + 1;
+    }
+
+    fclose(file);
+    return result;
+}
+
+unsigned LargeFileDocument::unitSize() const
+{
+    return (m_encoding == ENCODING_UTF16LE || m_encoding == ENCODING_UTF16BE) ? 2 : 1;
+}
+
+LargeFileDocument::LineScan LargeFileDocument::scanLine(uint64_t offset, uint64_t& lineEnd, uint64_t& nextLine)
+{
+    unsigned unit = unitSize();
+    if (m_index.longLineEnd(offset, lineEnd))
+    {
+        bool isLast = (lineEnd >= m_cache.fileSize());
+        nextLine = isLast ? lineEnd : lineEnd + unit;
+        return isLast ? LINE_LAST : LINE_NEXT;
+    }
+
+    // Строку длиннее LONG_LINE_BYTES индекс запомнит, когда дойдет до ее конца
+    bool bigEndian = (m_encoding == ENCODING_UTF16BE);
+    uint64_t limit = offset + SparseLineIndex::LONG_LINE_BYTES + unit;
+    uint64_t position = offset;
+    for (;;)
+    {
+        if (position >= limit)
+        {
+            lineEnd = position;
+            nextLine = position;
+            return LINE_PENDING;
+        }
+
+        uint64_t blockStart;
+        size_t blockLength;
+        const char* data = m_cache.blockAt(position, blockStart, blockLength);
+        if (!data)
+        {
+            // Конец файла: строка последняя
+            lineEnd = m_cache.fileSize();
+            nextLine = lineEnd;
+            return LINE_LAST;
+        }
+
+        const char* begin = data + (position - blockStart);
+        const char* end = data + blockLength;
+        const char* lineFeed = SparseLineIndex::findLineFeed(begin, end, position, unit, bigEndian);
+        if (lineFeed != end)
+        {
+            lineEnd = blockStart + static_cast<uint64_t>(lineFeed - data);
+            nextLine = lineEnd + unit;
+            return LINE_NEXT;
+        }
+        position = blockStart + blockLength;
+    }
+}
+
+void LargeFileDocument::readSegment(uint64_t lineStart, uint64_t lineEnd, bool isPending, uint64_t column,
+                                    size_t columnCount, LineSegment& segment)
+{
+    unsigned unit = unitSize();
+    bool bigEndian = (m_encoding == ENCODING_UTF16BE);
+    uint64_t units = (lineEnd - lineStart) / unit;
+    std::string bytes;
+
+    // Перевод строки "\r\n" не входит в длину строки
+    if (!isPending && units > 0 && m_cache.read(lineEnd - unit, unit, bytes) == unit &&
+        bytes[bigEndian ? unit - 1 : 0] == '\r' && (unit == 1 || bytes[bigEndian ? 0 : 1] == 0))
+    {
+        --units;
+    }
+
+    // Начало участка сдвигается назад на границу символа: через байты
+    // продолжения UTF-8 или младшую половину суррогатной пары UTF-16
+    uint64_t start = lineStart + (column < units ? column : units) * unit;
+    if (m_encoding == ENCODING_UTF8 && start > lineStart)
+    {
+        uint64_t back = start - lineStart < 3 ? start - lineStart : 3;
+        bytes.clear();
+        m_cache.read(start - back, static_cast<size_t>(back) + 1, bytes);
+        size_t position = back;
+        while (position > 0 && position < bytes.size() && (static_cast<unsigned char>(bytes[position]) & 0xC0) == 0x80)
+        {
+            --position;
+        }
+        start -= back - position;
+    }
+    else if (unit == 2 && start > lineStart)
+    {
+        bytes.clear();
+        if (m_cache.read(start, 2, bytes) == 2)
+        {
+            unsigned char high = static_cast<unsigned char>(bytes[bigEndian ? 0 : 1]);
+            if (high >= 0xDC && high <= 0xDF)
+            {
+                start -= 2;
+            }
+        }
+    }
+
+    // Символ UTF-8 занимает до 4 байт, символ UTF-16 - до двух единиц
+    uint64_t lineBytes = lineStart + units * unit;
+    uint64_t size = (static_cast<uint64_t>(columnCount) + 2) * (m_encoding == ENCODING_UTF8 ? 4 : 2) * unit;
+    if (size > MAX_LINE_BYTES)
+    {
+        size = MAX_LINE_BYTES;
+    }
+    if (size > lineBytes - start)
+    {
+        size = lineBytes - start;
+    }
+    bytes.clear();
+    m_cache.read(start, static_cast<size_t>(size), bytes);
+
+    // Неполный символ в конце участка отбрасывается
+    size_t complete = bytes.size();
+    if (m_encoding == ENCODING_UTF8)
+    {
+        complete = Utf8Codec::completeLength(bytes.data(), bytes.size());
+    }
+    else if (unit == 2 && complete >= 2)
+    {
+        complete &= ~static_cast<size_t>(1);
+        unsigned char high = static_cast<unsigned char>(bytes[complete - (bigEndian ? 2 : 1)]);
+        if (high >= 0xD8 && high <= 0xDB)
+        {
+            complete -= 2;
+        }
+    }
+
+    segment.text.clear();
+    decode(bytes.data(), complete, segment.text);
+    segment.column = (start - lineStart) / unit;
+    segment.length = units;
+    segment.isLong = true;
+}
+
+void LargeFileDocument::decode(const char* data, size_t size, std::wstring& output) const
+{
+    decodeBytes(m_encoding, m_singleByteTable, data, size, output);
+}
+
+void LargeFileDocument::decodeBytes(Encoding encoding, const std::vector<wchar_t>& singleByteTable,
+                                    const char* data, size_t size, std::wstring& output)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    switch (encoding)
+    {
+    case ENCODING_UTF8:
+        Utf8Codec::decodeAppend(data, size, output);
+        break;
+    case ENCODING_UTF16LE:
+    case ENCODING_UTF16BE:
+    {
+        bool bigEndian = (encoding == ENCODING_UTF16BE);
+        for (size_t i = 0; i + 1 < size; i += 2)
+        {
+            unsigned int unit = bigEndian ? ((bytes[i] << 8) | bytes[i + 1]) : ((bytes[i + 1] << 8) | bytes[i]);
+
+            // В Linux wchar_t 32-битный: суррогатные пары собираются в одну кодовую точку
+            if (sizeof(wchar_t) > 2 && unit >= 0xD800 && unit <= 0xDBFF && i + 3 < size)
+            {
+                unsigned int low = bigEndian ? ((bytes[i + 2] << 8) | bytes[i + 3]) : ((bytes[i + 3] << 8) | bytes[i + 2]);
+                if (low >= 0xDC00 && low <= 0xDFFF)
+                {
+                    appendCodePoint(0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00), output);
+                    i += 2;
+                    continue;
+                }
+            }
+            output.push_back(static_cast<wchar_t>(unit));
+        }
+        break;
+    }
+    case ENCODING_SINGLE_BYTE:
+    default:
+        output.reserve(output.size() + size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            output.push_back(singleByteTable[bytes[i]]);
+        }
+        break;
+    }
+}
+
+bool LargeFileDocument::encode(const std::wstring& text, std::string& output) const
+{
+    output.clear();
+    switch (m_encoding)
+    {
+    case ENCODING_UTF8:
+        output = Utf8Codec::encode(text);
+        return true;
+    case ENCODING_UTF16LE:
+    case ENCODING_UTF16BE:
+    {
+        bool bigEndian = (m_encoding == ENCODING_UTF16BE);
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            unsigned int codePoint = static_cast<unsigned int>(text[i]);
+            unsigned int units[2] = { codePoint, 0 };
+            size_t unitCount = 1;
+            if (codePoint > 0xFFFF)
+            {
+                codePoint -= 0x10000;
+                units[0] = 0xD800 + (codePoint >> 10);
+                units[1] = 0xDC00 + (codePoint & 0x3FF);
+                unitCount = 2;
+            }
+            for (size_t j = 0; j < unitCount; ++j)
+            {
+                char high = static_cast<char>(units[j] >> 8);
+                char low = static_cast<char>(units[j] & 0xFF);
+                output.push_back(bigEndian ? high : low);
+                output.push_back(bigEndian ? low : high);
+            }
+        }
+        return true;
+    }
+    case ENCODING_SINGLE_BYTE:
+    default:
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            size_t byte = 0;
+            while (byte < 256 && m_singleByteTable[byte] != text[i])
+            {
+                ++byte;
+            }
+            if (byte == 256)
+            {
+                return false;
+            }
+            output.push_back(static_cast<char>(byte));
+        }
+        return true;
+    }
+}
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "BlockCache.h"
+#include "SparseLineIndex.h"
+
+/**
+ * @brief Большой файл, открытый только для просмотра
+ *
+ * Файл не загружается целиком: строки читаются через LRU-кэш блоков
+ * фиксированного размера и декодируются по запросу, а разреженный индекс
+ * строк строится в фоне. Расход памяти ограничен и не зависит от размера
+ * файла. Строки длиннее MAX_LINE_BYTES читаются участками: столбцы в них
+ * считаются в кодовых единицах, поэтому начало участка вычисляется без
+ * декодирования предшествующей части строки. Не зависит от WinAPI.
+ */
+class LargeFileDocument
+{
+public:
+    /**
+     * @brief Кодировка файла
+     */
+    enum Encoding
+    {
+        ENCODING_SINGLE_BYTE,   ///< Однобайтовая кодовая страница (по таблице)
+        ENCODING_UTF8,          ///< UTF-8
+        ENCODING_UTF16LE,       ///< UTF-16 Little Endian
+        ENCODING_UTF16BE        ///< UTF-16 Big Endian
+    };
+
+    /**
+     * @brief Участок строки, попадающий в окно
+     */
+    struct LineSegment
+    {
+        std::wstring text;      ///< Текст участка (без перевода строки)
+        uint64_t column;        ///< Столбец начала участка
+        uint64_t length;        ///< Длина строки в столбцах (для недочитанной строки - известная часть)
+        bool isLong;            ///< Длинная строка: столбцы считаются в кодовых единицах
+    };
+
+    static const uint64_t NOT_FOUND = ~0ULL;                ///< Результат неудачного поиска
+    static const size_t MAX_LINE_BYTES = 64 * 1024;         ///< Предел декодируемой длины строки
+    static const size_t CACHE_BLOCK_SIZE = 64 * 1024;       ///< Размер блока кэша
+    static const size_t CACHE_BLOCK_COUNT = 64;             ///< Количество блоков в кэше
+
+    LargeFileDocument();
+    ~LargeFileDocument();
+
+    /**
+     * @brief Открыть файл и запустить построение индекса строк
+     * @param path Путь к файлу
+     * @param singleByteTable Таблица 256 символов для однобайтовой кодировки
+     *        (пустая таблица - Latin-1)
+     * @return true при успехе
+     */
+    bool open(const std::wstring& path, const std::vector<wchar_t>& singleByteTable);
+
+    /**
+     * @brief Закрыть файл
+     */
+    void close();
+
+    /**
+     * @brief Получить путь к файлу
+     * @return Путь
+     */
+    const std::wstring& path() const;
+
+    /**
+     * @brief Получить кодировку файла
+     * @return Кодировка
+     */
+    Encoding encoding() const;
+
+    /**
+     * @brief Получить размер файла
+     * @return Размер в байтах
+     */
+    uint64_t fileSize() const;
+
+    /**
+     * @brief Получить количество известных строк
+     * @return Количество строк (растет, пока индекс строится)
+     */
+    uint64_t lineCount() const;
+
+    /**
+     * @brief Проверить, построен ли индекс строк
+     * @return true если индекс построен
+     */
+    bool isIndexComplete() const;
+
+    /**
+     * @brief Получить долю проиндексированного файла
+     * @return Значение от 0 до 1
+     */
+    double indexProgress() const;
+
+    /**
+     * @brief Прочитать строки
+     * @param firstLine Номер первой строки
+     * @param count Количество строк
+     * @param lines Результат (длинные строки обрезаются до MAX_LINE_BYTES)
+     * @return Количество прочитанных строк
+     */
+    size_t readLines(uint64_t firstLine, size_t count, std::vector<std::wstring>& lines);
+
+    /**
+     * @brief Прочитать участки строк, видимые с заданного столбца
+     *
+     * Короткие строки читаются целиком (column участка равен 0). Из длинной
+     * строки читается только участок от столбца column, выровненный назад
+     * на границу символа, длиной около columnCount символов.
+     * @param firstLine Номер первой строки
+     * @param count Количество строк
+     * @param column Первый видимый столбец
+     * @param columnCount Количество видимых столбцов
+     * @param segments Результат
+     * @return Количество прочитанных строк
+     */
+    size_t readSegments(uint64_t firstLine, size_t count, uint64_t column, size_t columnCount,
+                        std::vector<LineSegment>& segments);
+
+    /**
+     * @brief Получить смещение начала строки
+     * @param line Номер строки
+     * @param offset Смещение в файле
+     * @return false если строка еще не проиндексирована
+     */
+    bool lineStartOffset(uint64_t line, uint64_t& offset);
+
+    /**
+     * @brief Получить номер строки по смещению
+     * @param offset Смещение в файле (смещение внутри BOM относится к первой строке)
+     * @param line Номер строки
+     * @return false если смещение еще не проиндексировано
+     */
+    bool lineOfOffset(uint64_t offset, uint64_t& line);
+
+    /**
+     * @brief Получить столбец по смещению внутри строки
+     *
+     * Для коротких строк столбец считается в символах UTF-16, для длинных -
+     * в кодовых единицах (как в LineSegment).
+     * @param line Номер строки
+     * @param offset Смещение в файле (не раньше начала строки)
+     * @param column Номер столбца
+     * @return false если строка еще не проиндексирована
+     */
+    bool columnOfOffset(uint64_t line, uint64_t offset, uint64_t& column);
+
+    /**
+     * @brief Найти текст (с учетом регистра)
+     *
+     * Читает файл собственным дескриптором, поэтому может выполняться
+     * в отдельном потоке одновременно с чтением строк.
+     * @param text Искомый текст
+     * @param fromOffset Смещение, с которого начинается поиск
+     * @param cancel Флаг отмены (может быть nullptr)
+     * @return Смещение найденного текста или NOT_FOUND
+     */
+    uint64_t find(const std::wstring& text, uint64_t fromOffset, const std::atomic<bool>* cancel) const;
+
+    /**
+     * @brief Декодировать байты в заданной кодировке
+     *
+     * Фрагмент должен состоять из целых символов (для UTF-8 и UTF-16).
+     * @param encoding Кодировка
+     * @param singleByteTable Таблица однобайтовой кодировки (256 символов)
+     * @param data Указатель на байты
+     * @param size Количество байт
+     * @param output Строка, в конец которой дописывается результат
+     */
+    static void decodeBytes(Encoding encoding, const std::vector<wchar_t>& singleByteTable,
+                            const char* data, size_t size, std::wstring& output);
+
+private:
+    /**
+     * @brief Результат просмотра строки
+     */
+    enum LineScan
+    {
+        LINE_NEXT,      ///< За строкой есть следующая
+        LINE_LAST,      ///< Строка последняя в файле
+        LINE_PENDING    ///< Конец длинной строки еще не найден индексом
+    };
+
+    std::wstring m_path;                    ///< Путь к файлу
+    Encoding m_encoding;                    ///< Кодировка
+    uint64_t m_dataStart;                   ///< Начало текста (после BOM)
+    std::vector<wchar_t> m_singleByteTable; ///< Таблица однобайтовой кодировки
+    BlockCache m_cache;                     ///< Кэш блоков
+    SparseLineIndex m_index;                ///< Индекс строк
+    uint64_t m_hintLine;                    ///< Последняя найденная строка
+    uint64_t m_hintOffset;                  ///< Смещение последней найденной строки
+
+    unsigned unitSize() const;
+
+    /**
+     * @brief Найти конец строки через кэш
+     *
+     * Конец длинной строки берется из индекса; сама строка просматривается
+     * не дальше SparseLineIndex::LONG_LINE_BYTES.
+     * @param offset Начало строки
+     * @param lineEnd Смещение перевода строки (или конца файла; для
+     *        LINE_PENDING - конец просмотренной части)
+     * @param nextLine Начало следующей строки
+     * @return Результат просмотра
+     */
+    LineScan scanLine(uint64_t offset, uint64_t& lineEnd, uint64_t& nextLine);
+
+    /**
+     * @brief Прочитать участок длинной строки
+     * @param lineStart Начало строки
+     * @param lineEnd Конец строки (или известной части)
+     * @param isPending Конец строки еще не найден
+     * @param column Первый видимый столбец (в кодовых единицах)
+     * @param columnCount Количество видимых столбцов
+     * @param segment Результат
+     */
+    void readSegment(uint64_t lineStart, uint64_t lineEnd, bool isPending, uint64_t column,
+                     size_t columnCount, LineSegment& segment);
+
+    /**
+     * @brief Декодировать байты строки
+     * @param data Байты
+     * @param size Количество байт
+     * @param output Результат
+     */
+    void decode(const char* data, size_t size, std::wstring& output) const;
+
+    /**
+     * @brief Закодировать искомый текст в кодировку файла
+     * @param text Текст
+     * @param output Байты
+     * @return false если текст не представим в кодировке файла
+     */
+    bool encode(const std::wstring& text, std::string& output) const;
+
+    LargeFileDocument(const LargeFileDocument&);
+    LargeFileDocument& operator=(const LargeFileDocument&);
+};
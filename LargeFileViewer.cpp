@@ -0,0 +1,1132 @@
+#include "LargeFileViewer.h"
+#include <windowsx.h>
+
+namespace
+{
+    const WCHAR VIEWER_CLASS_NAME[] = L"LargeFileViewer";
+    const int WHEEL_LINES = 3;                  ///< Строк на один шаг колеса мыши
+    const int HORIZONTAL_PAGE_COLUMNS = 16;     ///< Столбцов на шаг горизонтальной прокрутки
+}
+
+LargeFileViewer::LargeFileViewer(HINSTANCE hInstance)
+    : m_hInstance(hInstance)
+    , m_hWnd(NULL)
+    , m_hFont(NULL)
+    , m_textColor(RGB(0, 0, 0))
+    , m_backgroundColor(RGB(255, 255, 255))
+    , m_lineHeight(16)
+    , m_charWidth(8)
+    , m_firstLine(0)
+    , m_firstColumn(0)
+    , m_maxColumns(0)
+    , m_scrollScale(1)
+    , m_columnScale(1)
+    , m_currentLine(FoldMap::NO_LINE)
+    , m_isWordWrap(FALSE)
+    , m_firstRow(0)
+    , m_wrapLayout(*this)
+    , m_layoutFirstLine(0)
+    , m_cancelSearch(false)
+    , m_searchOffset(0)
+    , m_isSearchWrapped(FALSE)
+    , m_matchOffset(0)
+    , m_matchLine(0)
+    , m_matchColumn(0)
+    , m_hasMatch(FALSE)
+{
+}
+
+LargeFileViewer::~LargeFileViewer()
+{
+    cancelSearch();
+    if (m_hWnd)
+    {
+        DestroyWindow(m_hWnd);
+        m_hWnd = NULL;
+    }
+    m_document.close();
+}
+
+BOOL LargeFileViewer::create(HWND hParent)
+{
+    WNDCLASSEXW wcex = {};
+    wcex.cbSize = sizeof(WNDCLASSEX);
+    wcex.style = CS_HREDRAW | CS_VREDRAW | CS_DBLCLKS;
+    wcex.lpfnWndProc = viewerProc;
+    wcex.hInstance = m_hInstance;
+    wcex.hCursor = LoadCursor(nullptr, IDC_IBEAM);
+    wcex.lpszClassName = VIEWER_CLASS_NAME;
+
+    // Класс регистрируется один раз на все окна просмотра
+    if (!RegisterClassExW(&wcex) && GetLastError() != ERROR_CLASS_ALREADY_EXISTS)
+    {
+        return FALSE;
+    }
+
+    m_hWnd = CreateWindowExW(
+        WS_EX_CLIENTEDGE,
+        VIEWER_CLASS_NAME,
+        L"",
+        WS_CHILD | WS_VSCROLL | WS_HSCROLL,
+        0, 0, 0, 0,
+        hParent,
+        NULL,
+        m_hInstance,
+        this
+    );
+
+    return m_hWnd != NULL;
+}
+
+BOOL LargeFileViewer::openFile(const std::wstring& filePath, const std::vector<wchar_t>& singleByteTable)
+{
+    cancelSearch();
+    if (!m_document.open(filePath, singleByteTable))
+    {
+        return FALSE;
+    }
+
+    m_firstLine = 0;
+    m_firstRow = 0;
+    m_firstColumn = 0;
+    m_maxColumns = 0;
+    m_layoutLines.clear();
+    m_hasMatch = FALSE;
+    m_matchLine = 0;
+    m_folds.clear();
+    m_currentLine = FoldMap::NO_LINE;
+
+    if (m_hWnd)
+    {
+        // Пока индекс строится, полоса прокрутки периодически обновляется
+        SetTimer(m_hWnd, TIMER_INDEX, INDEX_REFRESH_INTERVAL, NULL);
+        updateScrollBars();
+        InvalidateRect(m_hWnd, NULL, TRUE);
+    }
+    return TRUE;
+}
+
+HWND LargeFileViewer::getHandle() const
+{
+    return m_hWnd;
+}
+
+void LargeFileViewer::setFont(HFONT hFont)
+{
+    m_hFont = hFont;
+    updateMetrics();
+    updateScrollBars();
+    if (m_hWnd)
+    {
+        InvalidateRect(m_hWnd, NULL, TRUE);
+    }
+}
+
+void LargeFileViewer::setColors(COLORREF textColor, COLORREF backgroundColor)
+{
+    m_textColor = textColor;
+    m_backgroundColor = backgroundColor;
+    if (m_hWnd)
+    {
+        InvalidateRect(m_hWnd, NULL, TRUE);
+    }
+}
+
+void LargeFileViewer::setWordWrap(BOOL enabled)
+{
+    if (m_isWordWrap == enabled)
+    {
+        return;
+    }
+
+    m_isWordWrap = enabled;
+    m_firstRow = 0;
+    m_firstColumn = 0;
+    m_layoutLines.clear();
+
+    // С переносом блоки не сворачиваются: свернутые разворачиваются, и
+    // переводы номеров строк в этом режиме не меняют их
+    if (enabled)
+    {
+        m_folds.clear();
+    }
+    if (m_hWnd)
+    {
+        updateScrollBars();
+        InvalidateRect(m_hWnd, NULL, FALSE);
+    }
+}
+
+BOOL LargeFileViewer::goToLine(uint64_t line)
+{
+    uint64_t lineCount = m_document.lineCount();
+    if (line >= lineCount)
+    {
+        if (!m_document.isIndexComplete())
+        {
+            return FALSE;
+        }
+        line = lineCount > 0 ? lineCount - 1 : 0;
+    }
+
+    m_folds.reveal(line);
+    scrollTo(line);
+    return TRUE;
+}
+
+BOOL LargeFileViewer::goToOffset(uint64_t offset)
+{
+    uint64_t fileSize = m_document.fileSize();
+    if (offset >= fileSize)
+    {
+        offset = fileSize > 0 ? fileSize - 1 : 0;
+    }
+
+    // Строка находится по ближайшей контрольной точке индекса и короткому просмотру
+    uint64_t line;
+    if (!m_document.lineOfOffset(offset, line))
+    {
+        return FALSE;
+    }
+    m_folds.reveal(line);
+    scrollTo(line);
+
+    uint64_t column;
+    if (!m_isWordWrap && m_document.columnOfOffset(line, offset, column))
+    {
+        uint64_t visibleColumns = static_cast<uint64_t>(getVisibleColumns());
+        if (column < m_firstColumn || column >= m_firstColumn + visibleColumns)
+        {
+            m_firstColumn = column > HORIZONTAL_PAGE_COLUMNS ? column - HORIZONTAL_PAGE_COLUMNS : 0;
+            InvalidateRect(m_hWnd, NULL, FALSE);
+            updateScrollBars();
+        }
+    }
+    return TRUE;
+}
+
+uint64_t LargeFileViewer::getFileSize() const
+{
+    return m_document.fileSize();
+}
+
+uint64_t LargeFileViewer::getFirstVisibleLine() const
+{
+    return m_firstLine;
+}
+
+uint64_t LargeFileViewer::getLineCount() const
+{
+    return m_document.lineCount();
+}
+
+void LargeFileViewer::findNext(const std::wstring& text)
+{
+    if (text.empty())
+    {
+        return;
+    }
+
+    // Повторный поиск того же текста продолжается после найденного вхождения
+    uint64_t fromOffset = 0;
+    if (m_hasMatch && text == m_searchText)
+    {
+        fromOffset = m_matchOffset + 1;
+    }
+    else if (!m_document.lineStartOffset(m_firstLine, fromOffset))
+    {
+        fromOffset = 0;
+    }
+
+    m_searchText = text;
+    m_isSearchWrapped = fromOffset == 0;
+    startSearch(fromOffset);
+}
+
+int LargeFileViewer::getPageSize() const
+{
+    RECT rect;
+    if (!m_hWnd || !GetClientRect(m_hWnd, &rect))
+    {
+        return 1;
+    }
+    int page = (rect.bottom - rect.top) / m_lineHeight;
+    return page > 1 ? page : 1;
+}
+
+int LargeFileViewer::getVisibleColumns() const
+{
+    RECT rect;
+    if (!m_hWnd || !GetClientRect(m_hWnd, &rect))
+    {
+        return 1;
+    }
+    int columns = (rect.right - rect.left) / m_charWidth;
+    return columns > 1 ? columns : 1;
+}
+
+BOOL LargeFileViewer::toggleFold()
+{
+    if (m_isWordWrap)
+    {
+        return FALSE;
+    }
+
+    uint64_t line = m_currentLine != FoldMap::NO_LINE ? m_currentLine : m_firstLine;
+    if (m_folds.isFolded(line))
+    {
+        m_folds.toggle(line, line);
+    }
+    else
+    {
+        FoldMap::LineReader reader = [this](uint64_t firstLine, size_t count, std::vector<std::wstring>& lines) {
+            return m_document.readLines(firstLine, count, lines);
+        };
+        uint64_t lastLine;
+        if (!FoldMap::findRegion(line, reader, lastLine))
+        {
+            return FALSE;
+        }
+        m_folds.toggle(line, lastLine);
+    }
+
+    // Первая видимая строка могла попасть в свернутый блок
+    scrollTo(m_firstLine);
+    InvalidateRect(m_hWnd, NULL, FALSE);
+    return TRUE;
+}
+
+void LargeFileViewer::unfoldAll()
+{
+    m_folds.clear();
+    if (m_hWnd)
+    {
+        scrollTo(m_firstLine);
+        InvalidateRect(m_hWnd, NULL, FALSE);
+    }
+}
+
+void LargeFileViewer::scrollTo(uint64_t line)
+{
+    // Окно прокручивается по видимым строкам: свернутые блоки не занимают
+    // места, а скрытая строка показывается заголовком своего блока
+    uint64_t lineCount = m_folds.visibleLineCount(m_document.lineCount());
+    uint64_t page = static_cast<uint64_t>(getPageSize());
+    uint64_t maxFirstLine = lineCount > page ? lineCount - page : 0;
+    line = m_folds.toVisible(line);
+
+    // Пока индекс не достроен, конец файла еще неизвестен. При переносе
+    // строки занимают разное число экранных строк, и конец ограничивает scrollRows
+    if (line > maxFirstLine && m_document.isIndexComplete() && !m_isWordWrap)
+    {
+        line = maxFirstLine;
+    }
+    if (line >= lineCount && lineCount > 0)
+    {
+        line = lineCount - 1;
+    }
+    line = m_folds.toDocument(line);
+
+    if (line != m_firstLine || m_firstRow != 0)
+    {
+        m_firstLine = line;
+        m_firstRow = 0;
+        InvalidateRect(m_hWnd, NULL, FALSE);
+    }
+    updateScrollBars();
+}
+
+void LargeFileViewer::scrollLines(int64_t delta)
+{
+    uint64_t visible = m_folds.toVisible(m_firstLine);
+    if (delta < 0)
+    {
+        uint64_t distance = static_cast<uint64_t>(-delta);
+        visible = visible > distance ? visible - distance : 0;
+    }
+    else
+    {
+        visible += static_cast<uint64_t>(delta);
+    }
+    scrollTo(m_folds.toDocument(visible));
+}
+
+uint64_t LargeFileViewer::lineAtPoint(int y) const
+{
+    if (m_isWordWrap || y < 0)
+    {
+        return FoldMap::NO_LINE;
+    }
+    size_t row = static_cast<size_t>(y / m_lineHeight);
+    return row < m_visibleLines.size() ? m_visibleLines[row] : FoldMap::NO_LINE;
+}
+
+void LargeFileViewer::scrollRows(int64_t delta)
+{
+    // Окно разметки захватывает страницу до и две после первой видимой строки,
+    // поэтому сдвиг на страницу не выходит за размеченные строки
+    uint64_t page = static_cast<uint64_t>(getPageSize());
+    uint64_t before = m_firstLine < page ? m_firstLine : page;
+    layoutWindow(m_firstLine - before, static_cast<size_t>(before + page * 2 + 1));
+    if (m_wrapLayout.lineCount() <= before)
+    {
+        scrollTo(m_firstLine);
+        return;
+    }
+
+    size_t index = static_cast<size_t>(m_firstLine - m_layoutFirstLine);
+    size_t row = m_firstRow < m_wrapLayout.rowCount(index) ? m_firstRow : m_wrapLayout.rowCount(index) - 1;
+    int64_t target = static_cast<int64_t>(m_wrapLayout.visualLineOf(index) + row) + delta;
+
+    // В конце файла последняя экранная строка остается внизу окна
+    int64_t last = static_cast<int64_t>(m_wrapLayout.visualLineCount()) - 1;
+    if (m_document.isIndexComplete() && m_layoutFirstLine + m_layoutLines.size() >= m_document.lineCount())
+    {
+        last -= static_cast<int64_t>(page) - 1;
+    }
+    if (target > last)
+    {
+        target = last;
+    }
+    if (target < 0)
+    {
+        target = 0;
+    }
+
+    index = m_wrapLayout.lineOfVisual(static_cast<uint64_t>(target), row);
+    if (m_layoutFirstLine + index != m_firstLine || row != m_firstRow)
+    {
+        m_firstLine = m_layoutFirstLine + index;
+        m_firstRow = row;
+        InvalidateRect(m_hWnd, NULL, FALSE);
+    }
+    updateScrollBars();
+}
+
+void LargeFileViewer::layoutWindow(uint64_t firstLine, size_t count)
+{
+    WrapLayout::LineSource source = [this](size_t line, std::wstring& text) {
+        text = m_layoutLines[line];
+    };
+    uint64_t end = firstLine + count;
+    uint64_t layoutEnd = m_layoutFirstLine + m_layoutLines.size();
+
+    // Окна не пересекаются: разметка строится заново
+    if (m_layoutLines.empty() || firstLine >= layoutEnd || end <= m_layoutFirstLine)
+    {
+        m_document.readLines(firstLine, count, m_layoutLines);
+        m_layoutFirstLine = firstLine;
+        m_wrapLayout.reset(m_layoutLines.size(), source, getWrapWidth());
+        return;
+    }
+
+    // Иначе дочитываются и размечаются только строки, вошедшие в окно
+    std::vector<std::wstring> added;
+    if (firstLine < m_layoutFirstLine)
+    {
+        m_document.readLines(firstLine, static_cast<size_t>(m_layoutFirstLine - firstLine), added);
+        m_layoutLines.insert(m_layoutLines.begin(), added.begin(), added.end());
+        m_wrapLayout.replaceLines(0, 0, added.size(), source);
+        m_layoutFirstLine = firstLine;
+    }
+    else if (firstLine > m_layoutFirstLine)
+    {
+        size_t removed = static_cast<size_t>(firstLine - m_layoutFirstLine);
+        m_layoutLines.erase(m_layoutLines.begin(), m_layoutLines.begin() + removed);
+        m_wrapLayout.replaceLines(0, removed, 0, source);
+        m_layoutFirstLine = firstLine;
+    }
+
+    layoutEnd = m_layoutFirstLine + m_layoutLines.size();
+    if (end > layoutEnd)
+    {
+        size_t position = m_layoutLines.size();
+        m_document.readLines(layoutEnd, static_cast<size_t>(end - layoutEnd), added);
+        m_layoutLines.insert(m_layoutLines.end(), added.begin(), added.end());
+        m_wrapLayout.replaceLines(position, 0, added.size(), source);
+    }
+    else if (end < layoutEnd)
+    {
+        size_t kept = static_cast<size_t>(end - m_layoutFirstLine);
+        m_wrapLayout.replaceLines(kept, m_layoutLines.size() - kept, 0, source);
+        m_layoutLines.resize(kept);
+    }
+}
+
+int LargeFileViewer::getWrapWidth() const
+{
+    RECT rect;
+    if (!m_hWnd || !GetClientRect(m_hWnd, &rect))
+    {
+        return 0;
+    }
+    return rect.right - rect.left;
+}
+
+int LargeFileViewer::width(wchar_t symbol) const
+{
+    size_t index = static_cast<size_t>(symbol);
+    return index < m_glyphWidths.size() ? m_glyphWidths[index] : m_charWidth;
+}
+
+void LargeFileViewer::updateScrollBars()
+{
+    if (!m_hWnd)
+    {
+        return;
+    }
+
+    // Полоса прокрутки 32-битная, поэтому для длинных файлов одна ее единица
+    // соответствует нескольким строкам
+    uint64_t lineCount = m_folds.visibleLineCount(m_document.lineCount());
+    m_scrollScale = lineCount / SCROLL_RANGE + 1;
+
+    SCROLLINFO si = {};
+    si.cbSize = sizeof(si);
+    si.fMask = SIF_RANGE | SIF_PAGE | SIF_POS | SIF_DISABLENOSCROLL;
+    si.nMin = 0;
+    si.nMax = static_cast<int>(lineCount / m_scrollScale);
+    si.nPage = static_cast<UINT>(getPageSize() / m_scrollScale + 1);
+    si.nPos = static_cast<int>(m_folds.toVisible(m_firstLine) / m_scrollScale);
+    SetScrollInfo(m_hWnd, SB_VERT, &si, TRUE);
+
+    // Длина строки в столбцах тоже может превышать 32-битный диапазон
+    m_columnScale = m_maxColumns / SCROLL_RANGE + 1;
+    si.nMax = m_isWordWrap ? 0 : static_cast<int>(m_maxColumns / m_columnScale);
+    si.nPage = static_cast<UINT>(getVisibleColumns() / m_columnScale);
+    si.nPos = static_cast<int>(m_firstColumn / m_columnScale);
+    SetScrollInfo(m_hWnd, SB_HORZ, &si, TRUE);
+}
+
+void LargeFileViewer::updateMetrics()
+{
+    if (!m_hWnd)
+    {
+        return;
+    }
+
+    HDC hdc = GetDC(m_hWnd);
+    HFONT hOldFont = m_hFont ? (HFONT)SelectObject(hdc, m_hFont) : NULL;
+    TEXTMETRICW tm;
+    if (GetTextMetricsW(hdc, &tm))
+    {
+        m_lineHeight = tm.tmHeight + tm.tmExternalLeading;
+        m_charWidth = tm.tmAveCharWidth;
+    }
+
+    // Ширина символов для переноса по словам; разметка строится заново
+    m_glyphWidths.assign(0x10000, 0);
+    if (!GetCharWidth32W(hdc, 0, 0xFFFF, &m_glyphWidths[0]))
+    {
+        m_glyphWidths.clear();
+    }
+    m_layoutLines.clear();
+    if (hOldFont)
+    {
+        SelectObject(hdc, hOldFont);
+    }
+    ReleaseDC(m_hWnd, hdc);
+
+    if (m_lineHeight < 1)
+    {
+        m_lineHeight = 1;
+    }
+    if (m_charWidth < 1)
+    {
+        m_charWidth = 1;
+    }
+}
+
+void LargeFileViewer::paint(HDC hdc)
+{
+    RECT client;
+    GetClientRect(m_hWnd, &client);
+
+    HFONT hOldFont = m_hFont ? (HFONT)SelectObject(hdc, m_hFont) : NULL;
+    SetTextColor(hdc, m_textColor);
+    SetBkColor(hdc, m_backgroundColor);
+
+    int y = 0;
+    if (m_isWordWrap)
+    {
+        y = paintWrapped(hdc, client);
+    }
+    else
+    {
+        // Из длинных строк читается только участок под окном, поэтому
+        // отрисовка не зависит от длины строки. Видимые строки читаются
+        // непрерывными участками между свернутыми блоками
+        size_t page = static_cast<size_t>(getPageSize() + 1);
+        size_t columns = static_cast<size_t>(getVisibleColumns()) + 1;
+        m_visibleSegments.clear();
+        m_visibleLines.clear();
+        std::vector<LargeFileDocument::LineSegment> run;
+        uint64_t line = m_firstLine;
+        while (m_visibleSegments.size() < page)
+        {
+            uint64_t runEnd = m_folds.visibleRunEnd(line);
+            size_t count = page - m_visibleSegments.size();
+            if (runEnd - line < count)
+            {
+                count = static_cast<size_t>(runEnd - line);
+            }
+            m_document.readSegments(line, count, m_firstColumn, columns, run);
+            for (size_t i = 0; i < run.size(); ++i)
+            {
+                m_visibleSegments.push_back(run[i]);
+                m_visibleLines.push_back(line + i);
+            }
+            if (run.size() < count)
+            {
+                break;
+            }
+            line = m_folds.nextVisible(line + count - 1);
+        }
+
+        // Свернутый заголовок подчеркивается цветом текста
+        HBRUSH hFoldBrush = m_folds.foldCount() > 0 ? CreateSolidBrush(m_textColor) : NULL;
+
+        for (size_t i = 0; i < m_visibleSegments.size(); ++i, y += m_lineHeight)
+        {
+            const LargeFileDocument::LineSegment& segment = m_visibleSegments[i];
+            if (segment.length > m_maxColumns)
+            {
+                m_maxColumns = segment.length;
+            }
+
+            // Участок длинной строки начинается с символа, в который попал первый
+            // видимый столбец; этот символ виден лишь частично и пропускается
+            size_t skip = 0;
+            if (!segment.isLong)
+            {
+                skip = m_firstColumn < segment.text.size() ? static_cast<size_t>(m_firstColumn) : segment.text.size();
+            }
+            else if (segment.column < m_firstColumn && !segment.text.empty())
+            {
+                skip = (IS_HIGH_SURROGATE(segment.text[0]) && segment.text.size() > 1) ? 2 : 1;
+            }
+
+            // Строка рисуется целиком с заливкой фона, поэтому мерцания нет
+            RECT lineRect = { client.left, y, client.right, y + m_lineHeight };
+            const WCHAR* text = segment.text.c_str() + skip;
+            int length = static_cast<int>(segment.text.size() - skip);
+            ExtTextOutW(hdc, client.left, y, ETO_OPAQUE | ETO_CLIPPED, &lineRect, text, length, NULL);
+
+            // Найденный текст выделяется инверсией цветов, если попал в участок
+            if (hFoldBrush && m_folds.isFolded(m_visibleLines[i]))
+            {
+                RECT foldRect = { client.left, y + m_lineHeight - 1, client.right, y + m_lineHeight };
+                FillRect(hdc, &foldRect, hFoldBrush);
+            }
+
+            if (m_hasMatch && m_visibleLines[i] == m_matchLine && m_matchColumn >= m_firstColumn &&
+                m_matchColumn - m_firstColumn < static_cast<uint64_t>(length))
+            {
+                int column = static_cast<int>(m_matchColumn - m_firstColumn);
+                int matchLength = static_cast<int>(m_searchText.size());
+                if (matchLength > length - column)
+                {
+                    matchLength = length - column;
+                }
+                SIZE prefix;
+                SIZE match;
+                GetTextExtentPoint32W(hdc, text, column, &prefix);
+                GetTextExtentPoint32W(hdc, text + column, matchLength, &match);
+                RECT matchRect = { client.left + prefix.cx, y, client.left + prefix.cx + match.cx, y + m_lineHeight };
+                InvertRect(hdc, &matchRect);
+            }
+        }
+        if (hFoldBrush)
+        {
+            DeleteObject(hFoldBrush);
+        }
+    }
+
+    if (y < client.bottom)
+    {
+        RECT rest = { client.left, y, client.right, client.bottom };
+        ExtTextOutW(hdc, 0, 0, ETO_OPAQUE, &rest, L"", 0, NULL);
+    }
+
+    // Ход построения индекса показывается в правом нижнем углу
+    if (!m_document.isIndexComplete())
+    {
+        WCHAR status[64];
+        swprintf_s(status, 64, L" Индексация строк: %d%% ", static_cast<int>(m_document.indexProgress() * 100.0));
+        SIZE size;
+        GetTextExtentPoint32W(hdc, status, static_cast<int>(wcslen(status)), &size);
+        SetTextColor(hdc, m_backgroundColor);
+        SetBkColor(hdc, m_textColor);
+        ExtTextOutW(hdc, client.right - size.cx, client.bottom - size.cy, ETO_OPAQUE, NULL,
+            status, static_cast<UINT>(wcslen(status)), NULL);
+    }
+
+    if (hOldFont)
+    {
+        SelectObject(hdc, hOldFont);
+    }
+}
+
+int LargeFileViewer::paintWrapped(HDC hdc, const RECT& client)
+{
+    // Каждая логическая строка занимает хотя бы одну экранную, поэтому
+    // страницы логических строк хватает на все окно
+    layoutWindow(m_firstLine, static_cast<size_t>(getPageSize() + 1));
+
+    int y = 0;
+    size_t index = 0;
+    size_t row = m_firstRow;
+    while (y < client.bottom && index < m_layoutLines.size())
+    {
+        const std::wstring& line = m_layoutLines[index];
+        size_t rowCount = m_wrapLayout.rowCount(index);
+        if (row >= rowCount)
+        {
+            row = rowCount - 1;
+        }
+        size_t start = m_wrapLayout.rowStart(index, row);
+        size_t end = row + 1 < rowCount ? m_wrapLayout.rowStart(index, row + 1) : line.size();
+        const WCHAR* text = line.c_str() + start;
+        int length = static_cast<int>(end - start);
+
+        RECT rowRect = { client.left, y, client.right, y + m_lineHeight };
+        ExtTextOutW(hdc, client.left, y, ETO_OPAQUE | ETO_CLIPPED, &rowRect, text, length, NULL);
+
+        // Найденный текст выделяется в той экранной строке, где он начинается
+        size_t matchColumn = static_cast<size_t>(m_matchColumn);
+        if (m_hasMatch && m_layoutFirstLine + index == m_matchLine && matchColumn >= start && matchColumn < end)
+        {
+            int column = static_cast<int>(matchColumn - start);
+            int matchLength = static_cast<int>(m_searchText.size());
+            if (matchLength > length - column)
+            {
+                matchLength = length - column;
+            }
+            SIZE prefix;
+            SIZE match;
+            GetTextExtentPoint32W(hdc, text, column, &prefix);
+            GetTextExtentPoint32W(hdc, text + column, matchLength, &match);
+            RECT matchRect = { client.left + prefix.cx, y, client.left + prefix.cx + match.cx, y + m_lineHeight };
+            InvertRect(hdc, &matchRect);
+        }
+
+        y += m_lineHeight;
+        if (++row >= rowCount)
+        {
+            row = 0;
+            ++index;
+        }
+    }
+    return y;
+}
+
+void LargeFileViewer::onVScroll(int code)
+{
+    uint64_t page = static_cast<uint64_t>(getPageSize());
+    if (m_isWordWrap)
+    {
+        // С переносом строки и страницы отсчитываются в экранных строках
+        switch (code)
+        {
+        case SB_LINEUP:
+            scrollRows(-1);
+            return;
+        case SB_LINEDOWN:
+            scrollRows(1);
+            return;
+        case SB_PAGEUP:
+            scrollRows(-static_cast<int64_t>(page));
+            return;
+        case SB_PAGEDOWN:
+            scrollRows(static_cast<int64_t>(page));
+            return;
+        case SB_BOTTOM:
+            scrollTo(m_document.lineCount());
+            scrollRows(0);
+            return;
+        }
+    }
+
+    switch (code)
+    {
+    case SB_LINEUP:
+        scrollLines(-1);
+        break;
+    case SB_LINEDOWN:
+        scrollLines(1);
+        break;
+    case SB_PAGEUP:
+        scrollLines(-static_cast<int64_t>(page));
+        break;
+    case SB_PAGEDOWN:
+        scrollLines(static_cast<int64_t>(page));
+        break;
+    case SB_TOP:
+        scrollTo(0);
+        break;
+    case SB_BOTTOM:
+        scrollTo(m_document.lineCount());
+        break;
+    case SB_THUMBTRACK:
+    case SB_THUMBPOSITION:
+    {
+        SCROLLINFO si = {};
+        si.cbSize = sizeof(si);
+        si.fMask = SIF_TRACKPOS;
+        GetScrollInfo(m_hWnd, SB_VERT, &si);
+        scrollTo(m_folds.toDocument(static_cast<uint64_t>(si.nTrackPos) * m_scrollScale));
+        break;
+    }
+    }
+}
+
+void LargeFileViewer::onHScroll(int code)
+{
+    if (m_isWordWrap)
+    {
+        return;
+    }
+
+    uint64_t visibleColumns = static_cast<uint64_t>(getVisibleColumns());
+    uint64_t lastColumn = m_maxColumns > visibleColumns ? m_maxColumns - visibleColumns : 0;
+    int64_t column = static_cast<int64_t>(m_firstColumn);
+    switch (code)
+    {
+    case SB_LEFT:
+        column = 0;
+        break;
+    case SB_RIGHT:
+        column = static_cast<int64_t>(lastColumn);
+        break;
+    case SB_LINELEFT:
+        column -= 1;
+        break;
+    case SB_LINERIGHT:
+        column += 1;
+        break;
+    case SB_PAGELEFT:
+        column -= HORIZONTAL_PAGE_COLUMNS;
+        break;
+    case SB_PAGERIGHT:
+        column += HORIZONTAL_PAGE_COLUMNS;
+        break;
+    case SB_THUMBTRACK:
+    case SB_THUMBPOSITION:
+    {
+        SCROLLINFO si = {};
+        si.cbSize = sizeof(si);
+        si.fMask = SIF_TRACKPOS;
+        GetScrollInfo(m_hWnd, SB_HORZ, &si);
+        column = static_cast<int64_t>(si.nTrackPos) * static_cast<int64_t>(m_columnScale);
+        break;
+    }
+    }
+
+    if (column > static_cast<int64_t>(m_maxColumns))
+    {
+        column = static_cast<int64_t>(m_maxColumns);
+    }
+    if (column < 0)
+    {
+        column = 0;
+    }
+    if (static_cast<uint64_t>(column) != m_firstColumn)
+    {
+        m_firstColumn = static_cast<uint64_t>(column);
+        InvalidateRect(m_hWnd, NULL, FALSE);
+        updateScrollBars();
+    }
+}
+
+void LargeFileViewer::onKeyDown(WPARAM key)
+{
+    BOOL isControl = (GetKeyState(VK_CONTROL) & 0x8000) != 0;
+    switch (key)
+    {
+    case VK_UP:
+        onVScroll(SB_LINEUP);
+        break;
+    case VK_DOWN:
+        onVScroll(SB_LINEDOWN);
+        break;
+    case VK_PRIOR:
+        onVScroll(SB_PAGEUP);
+        break;
+    case VK_NEXT:
+        onVScroll(SB_PAGEDOWN);
+        break;
+    case VK_LEFT:
+        onHScroll(SB_LINELEFT);
+        break;
+    case VK_RIGHT:
+        onHScroll(SB_LINERIGHT);
+        break;
+    case VK_HOME:
+        if (isControl)
+        {
+            onVScroll(SB_TOP);
+        }
+        m_firstColumn = 0;
+        InvalidateRect(m_hWnd, NULL, FALSE);
+        updateScrollBars();
+        break;
+    case VK_END:
+        if (isControl)
+        {
+            onVScroll(SB_BOTTOM);
+        }
+        onHScroll(SB_RIGHT);
+        break;
+    }
+}
+
+void LargeFileViewer::startSearch(uint64_t fromOffset)
+{
+    cancelSearch();
+    m_cancelSearch = false;
+    m_searchOffset = fromOffset;
+
+    // Поток получает копию текста; результат возвращается сообщением окну
+    HWND hWnd = m_hWnd;
+    std::wstring text = m_searchText;
+    m_searchThread = std::thread([this, hWnd, text, fromOffset]() {
+        uint64_t offset = m_document.find(text, fromOffset, &m_cancelSearch);
+        if (!m_cancelSearch)
+        {
+            uint64_t* result = new uint64_t(offset);
+            if (!PostMessage(hWnd, WM_SEARCH_DONE, 0, (LPARAM)result))
+            {
+                delete result;
+            }
+        }
+    });
+}
+
+void LargeFileViewer::onSearchDone(uint64_t offset)
+{
+    if (m_searchThread.joinable())
+    {
+        m_searchThread.join();
+    }
+
+    if (offset == LargeFileDocument::NOT_FOUND)
+    {
+        // Один раз поиск продолжается с начала файла
+        if (!m_isSearchWrapped)
+        {
+            m_isSearchWrapped = TRUE;
+            startSearch(0);
+            return;
+        }
+        m_hasMatch = FALSE;
+        InvalidateRect(m_hWnd, NULL, FALSE);
+        MessageBoxW(GetParent(m_hWnd), L"Текст не найден.", L"Поиск", MB_OK | MB_ICONINFORMATION);
+        return;
+    }
+
+    uint64_t line;
+    uint64_t column;
+    if (!m_document.lineOfOffset(offset, line) || !m_document.columnOfOffset(line, offset, column))
+    {
+        // Вхождение дальше проиндексированной части: позиция запоминается,
+        // переход выполнится по таймеру индекса
+        m_hasMatch = FALSE;
+        m_matchOffset = offset;
+        m_matchLine = LargeFileDocument::NOT_FOUND;
+        return;
+    }
+
+    m_hasMatch = TRUE;
+    m_matchOffset = offset;
+    m_matchLine = line;
+    m_matchColumn = column;
+
+    // Найденная строка показывается в верхней трети окна; блок, в котором
+    // она свернута, разворачивается
+    m_folds.reveal(line);
+    uint64_t margin = static_cast<uint64_t>(getPageSize() / 3);
+    uint64_t visibleLine = m_folds.toVisible(line);
+    uint64_t firstVisible = m_folds.toVisible(m_firstLine);
+    if (visibleLine < firstVisible || visibleLine >= firstVisible + static_cast<uint64_t>(getPageSize()))
+    {
+        scrollTo(m_folds.toDocument(visibleLine > margin ? visibleLine - margin : 0));
+    }
+
+    if (m_isWordWrap)
+    {
+        // Вхождение в длинной строке может оказаться ниже окна: прокручиваем по экранным строкам
+        uint64_t page = static_cast<uint64_t>(getPageSize());
+        layoutWindow(m_firstLine, static_cast<size_t>(page + 1));
+        if (line >= m_layoutFirstLine && line - m_layoutFirstLine < m_wrapLayout.lineCount())
+        {
+            size_t index = static_cast<size_t>(line - m_layoutFirstLine);
+            size_t firstIndex = static_cast<size_t>(m_firstLine - m_layoutFirstLine);
+            uint64_t matchRow = m_wrapLayout.visualLineOf(index) + m_wrapLayout.rowOfColumn(index, static_cast<size_t>(column));
+            uint64_t firstRow = m_wrapLayout.visualLineOf(firstIndex) + m_firstRow;
+            if (matchRow < firstRow || matchRow >= firstRow + page)
+            {
+                int64_t top = static_cast<int64_t>(matchRow > margin ? matchRow - margin : 0);
+                scrollRows(top - static_cast<int64_t>(firstRow));
+            }
+        }
+        InvalidateRect(m_hWnd, NULL, FALSE);
+        return;
+    }
+
+    uint64_t visibleColumns = static_cast<uint64_t>(getVisibleColumns());
+    if (m_matchColumn < m_firstColumn || m_matchColumn >= m_firstColumn + visibleColumns)
+    {
+        m_firstColumn = m_matchColumn > HORIZONTAL_PAGE_COLUMNS ? m_matchColumn - HORIZONTAL_PAGE_COLUMNS : 0;
+    }
+    InvalidateRect(m_hWnd, NULL, FALSE);
+    updateScrollBars();
+}
+
+void LargeFileViewer::cancelSearch()
+{
+    m_cancelSearch = true;
+    if (m_searchThread.joinable())
+    {
+        m_searchThread.join();
+    }
+}
+
+LRESULT CALLBACK LargeFileViewer::viewerProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
+{
+    if (message == WM_NCCREATE)
+    {
+        CREATESTRUCTW* cs = (CREATESTRUCTW*)lParam;
+        SetWindowLongPtr(hWnd, GWLP_USERDATA, (LONG_PTR)cs->lpCreateParams);
+        ((LargeFileViewer*)cs->lpCreateParams)->m_hWnd = hWnd;
+    }
+
+    LargeFileViewer* instance = (LargeFileViewer*)GetWindowLongPtr(hWnd, GWLP_USERDATA);
+    if (instance)
+    {
+        return instance->handleMessage(message, wParam, lParam);
+    }
+    return DefWindowProc(hWnd, message, wParam, lParam);
+}
+
+LRESULT LargeFileViewer::handleMessage(UINT message, WPARAM wParam, LPARAM lParam)
+{
+    switch (message)
+    {
+    case WM_PAINT:
+    {
+        PAINTSTRUCT ps;
+        HDC hdc = BeginPaint(m_hWnd, &ps);
+        paint(hdc);
+        EndPaint(m_hWnd, &ps);
+        return 0;
+    }
+
+    case WM_ERASEBKGND:
+        // Фон заливается при отрисовке строк
+        return 1;
+
+    case WM_SIZE:
+        if (m_isWordWrap && !m_layoutLines.empty())
+        {
+            // Переразмечаются только строки, которые не помещались в прежнюю или новую ширину
+            m_wrapLayout.setWidth(getWrapWidth(), [this](size_t line, std::wstring& text) {
+                text = m_layoutLines[line];
+            });
+            if (m_firstLine >= m_layoutFirstLine && m_firstLine - m_layoutFirstLine < m_wrapLayout.lineCount())
+            {
+                size_t rowCount = m_wrapLayout.rowCount(static_cast<size_t>(m_firstLine - m_layoutFirstLine));
+                if (m_firstRow >= rowCount)
+                {
+                    m_firstRow = rowCount - 1;
+                }
+            }
+        }
+        updateScrollBars();
+        return 0;
+
+    case WM_VSCROLL:
+        onVScroll(LOWORD(wParam));
+        return 0;
+
+    case WM_HSCROLL:
+        onHScroll(LOWORD(wParam));
+        return 0;
+
+    case WM_KEYDOWN:
+        onKeyDown(wParam);
+        return 0;
+
+    case WM_MOUSEWHEEL:
+    {
+        int delta = GET_WHEEL_DELTA_WPARAM(wParam) / WHEEL_DELTA;
+        if (m_isWordWrap)
+        {
+            scrollRows(-static_cast<int64_t>(delta) * WHEEL_LINES);
+        }
+        else
+        {
+            scrollLines(-static_cast<int64_t>(delta) * WHEEL_LINES);
+        }
+        return 0;
+    }
+
+    case WM_LBUTTONDOWN:
+        // Строка под курсором - заголовок для сворачивания
+        m_currentLine = lineAtPoint(GET_Y_LPARAM(lParam));
+        SetFocus(m_hWnd);
+        return 0;
+
+    case WM_LBUTTONDBLCLK:
+        m_currentLine = lineAtPoint(GET_Y_LPARAM(lParam));
+        if (!toggleFold())
+        {
+            MessageBeep(MB_OK);
+        }
+        return 0;
+
+    case WM_TIMER:
+        if (wParam == TIMER_INDEX)
+        {
+            if (m_document.isIndexComplete())
+            {
+                KillTimer(m_hWnd, TIMER_INDEX);
+            }
+            if (!m_hasMatch && m_matchLine == LargeFileDocument::NOT_FOUND)
+            {
+                uint64_t line;
+                if (m_document.lineOfOffset(m_matchOffset, line) || m_document.isIndexComplete())
+                {
+                    onSearchDone(m_matchOffset);
+                }
+            }
+            updateScrollBars();
+            InvalidateRect(m_hWnd, NULL, FALSE);
+        }
+        return 0;
+
+    case WM_SEARCH_DONE:
+    {
+        uint64_t* result = (uint64_t*)lParam;
+        uint64_t offset = *result;
+        delete result;
+        onSearchDone(offset);
+        return 0;
+    }
+
+    case WM_NCDESTROY:
+    {
+        // Результаты поиска, не дошедшие до окна, освобождаются здесь
+        MSG msg;
+        while (PeekMessage(&msg, m_hWnd, WM_SEARCH_DONE, WM_SEARCH_DONE, PM_REMOVE))
+        {
+            delete (uint64_t*)msg.lParam;
+        }
+        KillTimer(m_hWnd, TIMER_INDEX);
+        SetWindowLongPtr(m_hWnd, GWLP_USERDATA, 0);
+        m_hWnd = NULL;
+        return 0;
+    }
+    }
+
+    return DefWindowProc(m_hWnd, message, wParam, lParam);
+}
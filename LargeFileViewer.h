@@ -0,0 +1,300 @@
+#pragma once
+
+#include "framework.h"
+#include "FoldMap.h"
+#include "LargeFileDocument.h"
+#include "WrapLayout.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Окно просмотра большого файла (только чтение)
+ *
+ * Рисует видимые строки LargeFileDocument самостоятельно, без EDIT-контрола,
+ * поэтому расход памяти не зависит от размера файла. Поддерживает прокрутку,
+ * переход к строке, поиск в фоновом потоке и перенос по словам (разметка
+ * WrapLayout строится только для строк около видимой области). Из длинных
+ * строк без переноса читается и измеряется только видимый участок.
+ * Без переноса блоки по скобкам или отступам сворачиваются (FoldMap):
+ * окно прокручивается и рисуется по видимым строкам.
+ */
+class LargeFileViewer : private GlyphWidthProvider
+{
+public:
+    /**
+     * @brief Конструктор
+     * @param hInstance Дескриптор экземпляра приложения
+     */
+    LargeFileViewer(HINSTANCE hInstance);
+
+    /**
+     * @brief Деструктор
+     */
+    ~LargeFileViewer();
+
+    /**
+     * @brief Создать окно просмотра
+     * @param hParent Дескриптор родительского окна
+     * @return TRUE при успехе
+     */
+    BOOL create(HWND hParent);
+
+    /**
+     * @brief Открыть файл
+     * @param filePath Путь к файлу
+     * @param singleByteTable Таблица однобайтовой кодировки (256 символов)
+     * @return TRUE при успехе
+     */
+    BOOL openFile(const std::wstring& filePath, const std::vector<wchar_t>& singleByteTable);
+
+    /**
+     * @brief Получить дескриптор окна
+     * @return Дескриптор окна
+     */
+    HWND getHandle() const;
+
+    /**
+     * @brief Установить шрифт
+     * @param hFont Шрифт (принадлежит вызывающему коду)
+     */
+    void setFont(HFONT hFont);
+
+    /**
+     * @brief Установить цвета текста и фона
+     * @param textColor Цвет текста
+     * @param backgroundColor Цвет фона
+     */
+    void setColors(COLORREF textColor, COLORREF backgroundColor);
+
+    /**
+     * @brief Включить или выключить перенос по словам
+     * @param enabled TRUE - переносить строки по ширине окна
+     */
+    void setWordWrap(BOOL enabled);
+
+    /**
+     * @brief Перейти к строке
+     * @param line Номер строки (с нуля)
+     * @return FALSE если строка еще не проиндексирована
+     */
+    BOOL goToLine(uint64_t line);
+
+    /**
+     * @brief Перейти к смещению в файле
+     * @param offset Смещение в байтах (за концом файла - конец файла)
+     * @return FALSE если смещение еще не проиндексировано
+     */
+    BOOL goToOffset(uint64_t offset);
+
+    /**
+     * @brief Получить размер файла
+     * @return Размер в байтах
+     */
+    uint64_t getFileSize() const;
+
+    /**
+     * @brief Получить первую видимую строку
+     * @return Номер строки
+     */
+    uint64_t getFirstVisibleLine() const;
+
+    /**
+     * @brief Получить количество известных строк
+     * @return Количество строк
+     */
+    uint64_t getLineCount() const;
+
+    /**
+     * @brief Найти следующее вхождение текста (поиск идет в фоне)
+     * @param text Искомый текст
+     */
+    void findNext(const std::wstring& text);
+
+    /**
+     * @brief Свернуть или развернуть блок, начинающийся с текущей строки
+     *
+     * Текущая строка - последняя, по которой щелкнули мышью (иначе первая
+     * видимая). Сворачивание работает без переноса по словам.
+     * @return FALSE если блока нет или включен перенос
+     */
+    BOOL toggleFold();
+
+    /**
+     * @brief Развернуть все блоки
+     */
+    void unfoldAll();
+
+private:
+    HINSTANCE m_hInstance;                  ///< Дескриптор экземпляра приложения
+    HWND m_hWnd;                            ///< Окно просмотра
+    HFONT m_hFont;                          ///< Шрифт
+    COLORREF m_textColor;                   ///< Цвет текста
+    COLORREF m_backgroundColor;             ///< Цвет фона
+    int m_lineHeight;                       ///< Высота строки в пикселях
+    int m_charWidth;                        ///< Средняя ширина символа
+    LargeFileDocument m_document;           ///< Просматриваемый файл
+    uint64_t m_firstLine;                   ///< Первая видимая строка
+    uint64_t m_firstColumn;                 ///< Первый видимый столбец
+    uint64_t m_maxColumns;                  ///< Самая длинная из показанных строк
+    uint64_t m_scrollScale;                 ///< Строк на единицу полосы прокрутки
+    uint64_t m_columnScale;                 ///< Столбцов на единицу горизонтальной полосы
+    std::vector<LargeFileDocument::LineSegment> m_visibleSegments;  ///< Участки строк последней отрисовки
+    std::vector<uint64_t> m_visibleLines;   ///< Строки документа в экранных строках последней отрисовки
+
+    // Сворачивание блоков
+    FoldMap m_folds;                        ///< Свернутые блоки
+    uint64_t m_currentLine;                 ///< Строка, по которой щелкнули последней
+
+    // Перенос по словам
+    BOOL m_isWordWrap;                      ///< Перенос по словам включен
+    size_t m_firstRow;                      ///< Первая видимая экранная строка внутри m_firstLine
+    std::vector<int> m_glyphWidths;         ///< Ширина символов шрифта
+    WrapLayout m_wrapLayout;                ///< Разметка строк окна разметки
+    uint64_t m_layoutFirstLine;             ///< Первая строка окна разметки
+    std::vector<std::wstring> m_layoutLines;    ///< Текст строк окна разметки
+
+    // Поиск
+    std::thread m_searchThread;             ///< Поток поиска
+    std::atomic<bool> m_cancelSearch;       ///< Флаг отмены поиска
+    std::wstring m_searchText;              ///< Искомый текст
+    uint64_t m_searchOffset;                ///< Смещение, с которого идет поиск
+    BOOL m_isSearchWrapped;                 ///< Поиск продолжен с начала файла
+    uint64_t m_matchOffset;                 ///< Смещение найденного текста
+    uint64_t m_matchLine;                   ///< Строка найденного текста
+    uint64_t m_matchColumn;                 ///< Столбец найденного текста
+    BOOL m_hasMatch;                        ///< Есть выделенное вхождение
+
+    static const UINT TIMER_INDEX = 1;              ///< ID таймера обновления индекса
+    static const UINT INDEX_REFRESH_INTERVAL = 250; ///< Интервал обновления (мс)
+    static const UINT WM_SEARCH_DONE = WM_APP + 10; ///< Поиск завершен
+    static const int SCROLL_RANGE = 1 << 30;        ///< Предел диапазона полосы прокрутки
+
+    /**
+     * @brief Количество строк, помещающихся в окне
+     * @return Количество строк
+     */
+    int getPageSize() const;
+
+    /**
+     * @brief Количество столбцов, помещающихся в окне
+     * @return Количество столбцов
+     */
+    int getVisibleColumns() const;
+
+    /**
+     * @brief Прокрутить к строке с ограничением диапазона
+     * @param line Номер первой видимой строки
+     */
+    void scrollTo(uint64_t line);
+
+    /**
+     * @brief Прокрутить на заданное число видимых строк (без переноса)
+     * @param delta Число строк (отрицательное - вверх)
+     */
+    void scrollLines(int64_t delta);
+
+    /**
+     * @brief Получить строку документа по координате в окне (без переноса)
+     * @param y Координата в клиентской области
+     * @return Номер строки или FoldMap::NO_LINE
+     */
+    uint64_t lineAtPoint(int y) const;
+
+    /**
+     * @brief Прокрутить на заданное число экранных строк (перенос по словам)
+     * @param delta Число строк (отрицательное - вверх)
+     */
+    void scrollRows(int64_t delta);
+
+    /**
+     * @brief Разметить строки [firstLine, firstLine + count)
+     *
+     * Строки, уже размеченные при прошлом вызове, повторно не читаются и
+     * не размечаются: окно разметки сдвигается вместе с прокруткой.
+     * @param firstLine Первая строка
+     * @param count Количество строк
+     */
+    void layoutWindow(uint64_t firstLine, size_t count);
+
+    /**
+     * @brief Ширина области вывода для переноса
+     * @return Ширина в пикселях
+     */
+    int getWrapWidth() const;
+
+    /**
+     * @brief Ширина символа текущего шрифта (GlyphWidthProvider)
+     */
+    int width(wchar_t symbol) const override;
+
+    /**
+     * @brief Обновить полосы прокрутки
+     */
+    void updateScrollBars();
+
+    /**
+     * @brief Измерить шрифт
+     */
+    void updateMetrics();
+
+    /**
+     * @brief Отрисовать окно
+     * @param hdc Контекст устройства
+     */
+    void paint(HDC hdc);
+
+    /**
+     * @brief Отрисовать строки с переносом по словам
+     * @param hdc Контекст устройства
+     * @param client Клиентская область
+     * @return Нижняя граница нарисованных строк
+     */
+    int paintWrapped(HDC hdc, const RECT& client);
+
+    /**
+     * @brief Обработать вертикальную прокрутку
+     * @param code Код прокрутки
+     */
+    void onVScroll(int code);
+
+    /**
+     * @brief Обработать горизонтальную прокрутку
+     * @param code Код прокрутки
+     */
+    void onHScroll(int code);
+
+    /**
+     * @brief Обработать нажатие клавиши
+     * @param key Код виртуальной клавиши
+     */
+    void onKeyDown(WPARAM key);
+
+    /**
+     * @brief Запустить поиск с заданного смещения
+     * @param fromOffset Смещение
+     */
+    void startSearch(uint64_t fromOffset);
+
+    /**
+     * @brief Обработать результат поиска
+     * @param offset Смещение найденного текста или NOT_FOUND
+     */
+    void onSearchDone(uint64_t offset);
+
+    /**
+     * @brief Остановить поиск
+     */
+    void cancelSearch();
+
+    /**
+     * @brief Процедура окна просмотра
+     */
+    static LRESULT CALLBACK viewerProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
+
+    /**
+     * @brief Обработать сообщение окна
+     */
+    LRESULT handleMessage(UINT message, WPARAM wParam, LPARAM lParam);
+};
@@ -0,0 +1,460 @@
+#include "LineDiff.h"
+#include "ContentHash.h"
+#include <algorithm>
+#include <cwchar>
+#include <unordered_map>
+
+void LineDiff::compute(const wchar_t* oldText, size_t oldLength,
+                       const wchar_t* newText, size_t newLength,
+                       std::vector<Hunk>& hunks, size_t maxCost)
+{
+    compute(oldText, oldLength, newText, newLength, hunks, ALGORITHM_MYERS, Progress(), maxCost);
+}
+
+bool LineDiff::compute(const wchar_t* oldText, size_t oldLength,
+                       const wchar_t* newText, size_t newLength,
+                       std::vector<Hunk>& hunks, Algorithm algorithm,
+                       const Progress& progress, size_t maxCost)
+{
+    hunks.clear();
+    Lines oldLines;
+    Lines newLines;
+    splitLines(oldText, oldLength, oldLines);
+    splitLines(newText, newLength, newLines);
+    size_t classCount = (algorithm == ALGORITHM_HISTOGRAM) ? classifyLines(oldLines, newLines) : 0;
+
+    LineDiff diff(oldLines, newLines, algorithm, progress, maxCost, hunks);
+    diff.m_classCounts.assign(classCount, 0);
+    diff.m_classLast.resize(classCount);
+    if (!diff.diffRange(0, oldLines.hashes.size(), 0, newLines.hashes.size()))
+    {
+        hunks.clear();
+        return false;
+    }
+    diff.reportProgress(oldLines.hashes.size());
+    return true;
+}
+
+size_t LineDiff::mapOffset(const std::vector<Hunk>& hunks, size_t offset)
+{
+    long long delta = 0;
+    for (size_t i = 0; i < hunks.size(); ++i)
+    {
+        const Hunk& hunk = hunks[i];
+        if (offset < hunk.oldOffset)
+        {
+            break;
+        }
+        if (offset < hunk.oldOffset + hunk.oldLength)
+        {
+            return hunk.newOffset;
+        }
+        delta = static_cast<long long>(hunk.newOffset + hunk.newLength) -
+                static_cast<long long>(hunk.oldOffset + hunk.oldLength);
+    }
+    return static_cast<size_t>(static_cast<long long>(offset) + delta);
+}
+
+void LineDiff::mergeHunks(const std::vector<Hunk>& hunks, size_t maxGap, std::vector<Hunk>& merged)
+{
+    merged.clear();
+    for (size_t i = 0; i < hunks.size(); ++i)
+    {
+        const Hunk& hunk = hunks[i];
+        if (merged.empty() || hunk.oldOffset - (merged.back().oldOffset + merged.back().oldLength) >= maxGap)
+        {
+            merged.push_back(hunk);
+            continue;
+        }
+
+        // Промежуток одинаков в обеих версиях и входит в объединенный фрагмент
+        Hunk& last = merged.back();
+        last.oldLineCount = hunk.oldLine + hunk.oldLineCount - last.oldLine;
+        last.newLineCount = hunk.newLine + hunk.newLineCount - last.newLine;
+        last.oldLength = hunk.oldOffset + hunk.oldLength - last.oldOffset;
+        last.newLength = hunk.newOffset + hunk.newLength - last.newOffset;
+    }
+}
+
+LineDiff::LineDiff(const Lines& oldLines, const Lines& newLines, Algorithm algorithm,
+                   const Progress& progress, size_t budget, std::vector<Hunk>& hunks)
+    : m_old(oldLines)
+    , m_new(newLines)
+    , m_algorithm(algorithm)
+    , m_progress(progress)
+    , m_isCanceled(false)
+    , m_budget(budget)
+    , m_hunks(hunks)
+{
+}
+
+void LineDiff::splitLines(const wchar_t* text, size_t length, Lines& lines)
+{
+    lines.text = text;
+    lines.starts.clear();
+    lines.hashes.clear();
+    lines.starts.push_back(0);
+
+    size_t start = 0;
+    while (start < length)
+    {
+        const wchar_t* lineFeed = wmemchr(text + start, L'\n', length - start);
+        size_t end = lineFeed ? static_cast<size_t>(lineFeed - text) + 1 : length;
+        lines.hashes.push_back(ContentHash::compute(text + start, (end - start) * sizeof(wchar_t)));
+        lines.starts.push_back(end);
+        start = end;
+    }
+}
+
+size_t LineDiff::classifyLines(Lines& oldLines, Lines& newLines)
+{
+    // Один проход по обоим текстам: дальше гистограмма любого диапазона
+    // считается в массивах по номеру класса, без хеш-таблицы на каждом шаге
+    std::unordered_map<uint64_t, size_t> classes;
+    classes.reserve(oldLines.hashes.size());
+    Lines* const texts[] = { &oldLines, &newLines };
+    for (size_t t = 0; t < 2; ++t)
+    {
+        Lines& lines = *texts[t];
+        lines.classes.resize(lines.hashes.size());
+        for (size_t i = 0; i < lines.hashes.size(); ++i)
+        {
+            lines.classes[i] = classes.insert(std::make_pair(lines.hashes[i], classes.size())).first->second;
+        }
+    }
+    return classes.size();
+}
+
+bool LineDiff::equal(size_t oldIndex, size_t newIndex) const
+{
+    if (m_old.hashes[oldIndex] != m_new.hashes[newIndex])
+    {
+        return false;
+    }
+
+    // Совпадение хеша проверяется по содержимому, чтобы коллизия не скрыла правку
+    size_t oldStart = m_old.starts[oldIndex];
+    size_t newStart = m_new.starts[newIndex];
+    size_t length = m_old.starts[oldIndex + 1] - oldStart;
+    return length == m_new.starts[newIndex + 1] - newStart &&
+           wmemcmp(m_old.text + oldStart, m_new.text + newStart, length) == 0;
+}
+
+bool LineDiff::reportProgress(size_t processedLines)
+{
+    if (!m_isCanceled && m_progress && !m_progress(processedLines, m_old.hashes.size()))
+    {
+        m_isCanceled = true;
+    }
+    return !m_isCanceled;
+}
+
+bool LineDiff::diffRange(size_t oldBegin, size_t oldEnd, size_t newBegin, size_t newEnd)
+{
+    // Диапазоны обрабатываются через явный стек: глубина рекурсии могла бы
+    // достигать числа правок
+    std::vector<Range> pending;
+    Range initial = { oldBegin, oldEnd, newBegin, newEnd };
+    pending.push_back(initial);
+
+    while (!pending.empty())
+    {
+        Range range = pending.back();
+        pending.pop_back();
+
+        // Диапазоны снимаются со стека слева направо, поэтому начало диапазона
+        // и есть число обработанных строк
+        if (!reportProgress(range.oldBegin))
+        {
+            return false;
+        }
+
+        // Общее начало и конец не участвуют в поиске
+        while (range.oldBegin < range.oldEnd && range.newBegin < range.newEnd &&
+               equal(range.oldBegin, range.newBegin))
+        {
+            ++range.oldBegin;
+            ++range.newBegin;
+        }
+        while (range.oldEnd > range.oldBegin && range.newEnd > range.newBegin &&
+               equal(range.oldEnd - 1, range.newEnd - 1))
+        {
+            --range.oldEnd;
+            --range.newEnd;
+        }
+
+        if (range.oldBegin == range.oldEnd && range.newBegin == range.newEnd)
+        {
+            continue;
+        }
+        if (range.oldBegin == range.oldEnd || range.newBegin == range.newEnd)
+        {
+            addHunk(range.oldBegin, range.oldEnd, range.newBegin, range.newEnd);
+            continue;
+        }
+
+        if (m_algorithm == ALGORITHM_HISTOGRAM && splitByRareLines(range, pending))
+        {
+            continue;
+        }
+
+        size_t oldSplit;
+        size_t newSplit;
+        bool isSplit = bisect(range.oldBegin, range.oldEnd, range.newBegin, range.newEnd, oldSplit, newSplit);
+        if (m_isCanceled)
+        {
+            return false;
+        }
+        if (!isSplit ||
+            (oldSplit == range.oldBegin && newSplit == range.newBegin) ||
+            (oldSplit == range.oldEnd && newSplit == range.newEnd))
+        {
+            // Бюджет исчерпан или общих строк нет: область заменяется целиком
+            addHunk(range.oldBegin, range.oldEnd, range.newBegin, range.newEnd);
+            continue;
+        }
+
+        // Правая половина кладется первой, чтобы фрагменты шли по порядку
+        Range right = { oldSplit, range.oldEnd, newSplit, range.newEnd };
+        Range left = { range.oldBegin, oldSplit, range.newBegin, newSplit };
+        pending.push_back(right);
+        pending.push_back(left);
+    }
+    return true;
+}
+
+bool LineDiff::splitByRareLines(const Range& range, std::vector<Range>& pending)
+{
+    // Гистограмма старого диапазона: число вхождений каждой строки и цепочка
+    // ее вхождений (от последнего к первому)
+    const size_t NO_LINE = static_cast<size_t>(-1);
+    std::vector<size_t> previous(range.oldEnd - range.oldBegin);
+    for (size_t i = range.oldBegin; i < range.oldEnd; ++i)
+    {
+        size_t lineClass = m_old.classes[i];
+        previous[i - range.oldBegin] = m_classCounts[lineClass] > 0 ? m_classLast[lineClass] : NO_LINE;
+        m_classLast[lineClass] = i;
+        ++m_classCounts[lineClass];
+    }
+
+    // Для каждой строки нового диапазона, которая встречается в старом не
+    // чаще лучшего найденного, общий участок расширяется в обе стороны.
+    // Выбирается участок с наименьшим числом вхождений входящих в него
+    // строк, а при равенстве - самый длинный
+    size_t bestOld = 0;
+    size_t bestNew = 0;
+    size_t bestLength = 0;
+    size_t bestCount = MAX_OCCURRENCES + 1;
+    for (size_t j = range.newBegin; j < range.newEnd;)
+    {
+        size_t nextNew = j + 1;
+        size_t lineClass = m_new.classes[j];
+        size_t count = m_classCounts[lineClass];
+        if (count == 0 || count > bestCount)
+        {
+            j = nextNew;
+            continue;
+        }
+
+        for (size_t i = m_classLast[lineClass]; i != NO_LINE; i = previous[i - range.oldBegin])
+        {
+            if (!equal(i, j))
+            {
+                continue;
+            }
+
+            size_t oldStart = i;
+            size_t newStart = j;
+            size_t regionCount = count;
+            while (oldStart > range.oldBegin && newStart > range.newBegin && equal(oldStart - 1, newStart - 1))
+            {
+                --oldStart;
+                --newStart;
+                regionCount = std::min(regionCount, m_classCounts[m_old.classes[oldStart]]);
+            }
+            size_t oldStop = i + 1;
+            size_t newStop = j + 1;
+            while (oldStop < range.oldEnd && newStop < range.newEnd && equal(oldStop, newStop))
+            {
+                regionCount = std::min(regionCount, m_classCounts[m_old.classes[oldStop]]);
+                ++oldStop;
+                ++newStop;
+            }
+
+            // Строки внутри найденного участка заново не рассматриваются
+            nextNew = std::max(nextNew, newStop);
+            if (oldStop - oldStart > bestLength || regionCount < bestCount)
+            {
+                bestOld = oldStart;
+                bestNew = newStart;
+                bestLength = oldStop - oldStart;
+                bestCount = regionCount;
+            }
+        }
+        j = nextNew;
+    }
+
+    // Счетчики обнуляются только для классов этого диапазона
+    for (size_t i = range.oldBegin; i < range.oldEnd; ++i)
+    {
+        m_classCounts[m_old.classes[i]] = 0;
+    }
+    if (bestLength == 0)
+    {
+        return false;
+    }
+
+    // Правая часть кладется первой, чтобы фрагменты шли по порядку
+    Range right = { bestOld + bestLength, range.oldEnd, bestNew + bestLength, range.newEnd };
+    Range left = { range.oldBegin, bestOld, range.newBegin, bestNew };
+    pending.push_back(right);
+    pending.push_back(left);
+    return true;
+}
+
+bool LineDiff::bisect(size_t oldBegin, size_t oldEnd, size_t newBegin, size_t newEnd,
+                      size_t& oldSplit, size_t& newSplit)
+{
+    // Прямой и обратный поиск идут навстречу друг другу до пересечения
+    const long long n = static_cast<long long>(oldEnd - oldBegin);
+    const long long m = static_cast<long long>(newEnd - newBegin);
+    const long long maxD = (n + m + 1) / 2;
+    const long long offset = maxD;
+    const long long length = 2 * maxD + 2;
+    m_forward.assign(static_cast<size_t>(length), -1);
+    m_backward.assign(static_cast<size_t>(length), -1);
+    m_forward[static_cast<size_t>(offset + 1)] = 0;
+    m_backward[static_cast<size_t>(offset + 1)] = 0;
+
+    const long long delta = n - m;
+    const bool isFrontOdd = (delta % 2 != 0);
+    long long k1Start = 0;
+    long long k1End = 0;
+    long long k2Start = 0;
+    long long k2End = 0;
+
+    for (long long d = 0; d < maxD; ++d)
+    {
+        if (m_budget == 0 || !reportProgress(oldBegin))
+        {
+            return false;
+        }
+        --m_budget;
+
+        for (long long k1 = -d + k1Start; k1 <= d - k1End; k1 += 2)
+        {
+            size_t k1Offset = static_cast<size_t>(offset + k1);
+            long long x1;
+            if (k1 == -d || (k1 != d && m_forward[k1Offset - 1] < m_forward[k1Offset + 1]))
+            {
+                x1 = m_forward[k1Offset + 1];
+            }
+            else
+            {
+                x1 = m_forward[k1Offset - 1] + 1;
+            }
+            long long y1 = x1 - k1;
+            while (x1 < n && y1 < m && equal(oldBegin + static_cast<size_t>(x1), newBegin + static_cast<size_t>(y1)))
+            {
+                ++x1;
+                ++y1;
+            }
+            m_forward[k1Offset] = x1;
+
+            if (x1 > n)
+            {
+                k1End += 2;
+            }
+            else if (y1 > m)
+            {
+                k1Start += 2;
+            }
+            else if (isFrontOdd)
+            {
+                long long k2Offset = offset + delta - k1;
+                if (k2Offset >= 0 && k2Offset < length && m_backward[static_cast<size_t>(k2Offset)] != -1 &&
+                    x1 >= n - m_backward[static_cast<size_t>(k2Offset)])
+                {
+                    oldSplit = oldBegin + static_cast<size_t>(x1);
+                    newSplit = newBegin + static_cast<size_t>(y1);
+                    return true;
+                }
+            }
+        }
+
+        for (long long k2 = -d + k2Start; k2 <= d - k2End; k2 += 2)
+        {
+            size_t k2Offset = static_cast<size_t>(offset + k2);
+            long long x2;
+            if (k2 == -d || (k2 != d && m_backward[k2Offset - 1] < m_backward[k2Offset + 1]))
+            {
+                x2 = m_backward[k2Offset + 1];
+            }
+            else
+            {
+                x2 = m_backward[k2Offset - 1] + 1;
+            }
+            long long y2 = x2 - k2;
+            while (x2 < n && y2 < m &&
+                   equal(oldBegin + static_cast<size_t>(n - x2 - 1), newBegin + static_cast<size_t>(m - y2 - 1)))
+            {
+                ++x2;
+                ++y2;
+            }
+            m_backward[k2Offset] = x2;
+
+            if (x2 > n)
+            {
+                k2End += 2;
+            }
+            else if (y2 > m)
+            {
+                k2Start += 2;
+            }
+            else if (!isFrontOdd)
+            {
+                long long k1Offset = offset + delta - k2;
+                if (k1Offset >= 0 && k1Offset < length && m_forward[static_cast<size_t>(k1Offset)] != -1)
+                {
+                    long long x1 = m_forward[static_cast<size_t>(k1Offset)];
+                    long long y1 = offset + x1 - k1Offset;
+                    if (x1 >= n - x2)
+                    {
+                        oldSplit = oldBegin + static_cast<size_t>(x1);
+                        newSplit = newBegin + static_cast<size_t>(y1);
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+
+void LineDiff::addHunk(size_t oldBegin, size_t oldEnd, size_t newBegin, size_t newEnd)
+{
+    // Фрагмент, вплотную примыкающий к предыдущему, объединяется с ним
+    if (!m_hunks.empty())
+    {
+        Hunk& last = m_hunks.back();
+        if (last.oldLine + last.oldLineCount == oldBegin && last.newLine + last.newLineCount == newBegin)
+        {
+            last.oldLineCount += oldEnd - oldBegin;
+            last.newLineCount += newEnd - newBegin;
+            last.oldLength = m_old.starts[oldEnd] - last.oldOffset;
+            last.newLength = m_new.starts[newEnd] - last.newOffset;
+            return;
+        }
+    }
+
+    Hunk hunk;
+    hunk.oldLine = oldBegin;
+    hunk.oldLineCount = oldEnd - oldBegin;
+    hunk.newLine = newBegin;
+    hunk.newLineCount = newEnd - newBegin;
+    hunk.oldOffset = m_old.starts[oldBegin];
+    hunk.oldLength = m_old.starts[oldEnd] - hunk.oldOffset;
+    hunk.newOffset = m_new.starts[newBegin];
+    hunk.newLength = m_new.starts[newEnd] - hunk.newOffset;
+    m_hunks.push_back(hunk);
+}
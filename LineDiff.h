@@ -0,0 +1,208 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Построчное сравнение двух текстов
+ *
+ * Строки сравниваются по 64-битным хешам (с проверкой содержимого при
+ * совпадении хеша). После отсечения общего начала и конца применяется
+ * алгоритм Майерса O(ND) в варианте с линейной памятью (поиск средней
+ * точки и рекурсия), поэтому небольшие правки в больших файлах находятся
+ * быстро. В режиме гистограммы область сначала делится по общему участку
+ * из самых редких строк (наименьшее число вхождений, не обязательно одно),
+ * что сохраняет скорость на входах в миллионы строк с разбросанными
+ * правками и не дает выравнивать тексты по пустым строкам и скобкам.
+ * Не зависит от WinAPI.
+ */
+class LineDiff
+{
+public:
+    /**
+     * @brief Отличающийся фрагмент: строки старого текста заменяются строками нового
+     */
+    struct Hunk
+    {
+        size_t oldLine;         ///< Первая строка в старом тексте
+        size_t oldLineCount;    ///< Количество строк в старом тексте
+        size_t newLine;         ///< Первая строка в новом тексте
+        size_t newLineCount;    ///< Количество строк в новом тексте
+        size_t oldOffset;       ///< Смещение фрагмента в старом тексте (символы)
+        size_t oldLength;       ///< Длина фрагмента в старом тексте
+        size_t newOffset;       ///< Смещение фрагмента в новом тексте
+        size_t newLength;       ///< Длина фрагмента в новом тексте
+    };
+
+    /**
+     * @brief Алгоритм сравнения
+     */
+    enum Algorithm
+    {
+        ALGORITHM_MYERS,        ///< Только алгоритм Майерса
+        ALGORITHM_HISTOGRAM     ///< Разбиение по участкам из самых редких строк, затем алгоритм Майерса
+    };
+
+    /**
+     * @brief Ход сравнения: обработано строк старого текста из общего числа
+     * @return false чтобы прервать сравнение
+     */
+    typedef std::function<bool(size_t processedLines, size_t totalLines)> Progress;
+
+    static const size_t DEFAULT_MAX_COST = 1 << 16;    ///< Предел числа правок для точного поиска
+    static const size_t MAX_OCCURRENCES = 64;           ///< Строки с большим числом вхождений не служат опорой
+
+    /**
+     * @brief Сравнить тексты
+     *
+     * Строка включает завершающий '\n'. Если отличий больше maxCost,
+     * оставшаяся область отдается одним фрагментом (результат по-прежнему
+     * корректен, но не минимален).
+     * @param oldText Старый текст
+     * @param oldLength Длина старого текста
+     * @param newText Новый текст
+     * @param newLength Длина нового текста
+     * @param hunks Результат (фрагменты по возрастанию позиции)
+     * @param maxCost Предел числа правок
+     */
+    static void compute(const wchar_t* oldText, size_t oldLength,
+                        const wchar_t* newText, size_t newLength,
+                        std::vector<Hunk>& hunks, size_t maxCost = DEFAULT_MAX_COST);
+
+    /**
+     * @brief Сравнить тексты с выбором алгоритма и отчетом о ходе работы
+     *
+     * Функция хода работы вызывается из того же потока; она же проверяет
+     * отмену.
+     * @param oldText Старый текст
+     * @param oldLength Длина старого текста
+     * @param newText Новый текст
+     * @param newLength Длина нового текста
+     * @param hunks Результат (фрагменты по возрастанию позиции)
+     * @param algorithm Алгоритм
+     * @param progress Функция хода работы (может быть пустой)
+     * @param maxCost Предел числа правок
+     * @return false если сравнение прервано (hunks пуст)
+     */
+    static bool compute(const wchar_t* oldText, size_t oldLength,
+                        const wchar_t* newText, size_t newLength,
+                        std::vector<Hunk>& hunks, Algorithm algorithm,
+                        const Progress& progress, size_t maxCost = DEFAULT_MAX_COST);
+
+    /**
+     * @brief Перенести позицию старого текста в новый текст
+     *
+     * Позиция внутри измененного фрагмента переносится в его начало.
+     * @param hunks Фрагменты, найденные compute
+     * @param offset Позиция в старом тексте
+     * @return Позиция в новом тексте
+     */
+    static size_t mapOffset(const std::vector<Hunk>& hunks, size_t offset);
+
+    /**
+     * @brief Объединить близкие фрагменты
+     *
+     * Фрагменты, между которыми меньше maxGap символов старого текста,
+     * сливаются в один вместе с одинаковым текстом между ними. Так правка
+     * документа состоит из немногих участков, а далекие фрагменты не
+     * превращаются в замену всего текста между ними.
+     * @param hunks Фрагменты, найденные compute
+     * @param maxGap Наибольший промежуток между объединяемыми фрагментами
+     * @param merged Результат (фрагменты по возрастанию позиции)
+     */
+    static void mergeHunks(const std::vector<Hunk>& hunks, size_t maxGap, std::vector<Hunk>& merged);
+
+private:
+    /**
+     * @brief Строки одного текста
+     */
+    struct Lines
+    {
+        const wchar_t* text;            ///< Текст
+        std::vector<size_t> starts;     ///< Начала строк (плюс конец текста)
+        std::vector<uint64_t> hashes;   ///< Хеши строк
+        std::vector<size_t> classes;    ///< Номера классов строк с равным хешем (для гистограммы)
+    };
+
+    /**
+     * @brief Сравниваемые диапазоны строк
+     */
+    struct Range
+    {
+        size_t oldBegin;
+        size_t oldEnd;
+        size_t newBegin;
+        size_t newEnd;
+    };
+
+    const Lines& m_old;                 ///< Строки старого текста
+    const Lines& m_new;                 ///< Строки нового текста
+    Algorithm m_algorithm;              ///< Алгоритм
+    const Progress& m_progress;         ///< Функция хода работы
+    bool m_isCanceled;                  ///< Сравнение прервано
+    size_t m_budget;                    ///< Оставшийся предел числа правок
+    std::vector<Hunk>& m_hunks;         ///< Результат
+    std::vector<long long> m_forward;   ///< Фронт прямого поиска
+    std::vector<long long> m_backward;  ///< Фронт обратного поиска
+    std::vector<size_t> m_classCounts;  ///< Вхождения классов строк в старый диапазон (гистограмма)
+    std::vector<size_t> m_classLast;    ///< Последнее вхождение класса в старый диапазон
+
+    LineDiff(const Lines& oldLines, const Lines& newLines, Algorithm algorithm,
+             const Progress& progress, size_t budget, std::vector<Hunk>& hunks);
+
+    /**
+     * @brief Разбить текст на строки и посчитать хеши
+     */
+    static void splitLines(const wchar_t* text, size_t length, Lines& lines);
+
+    /**
+     * @brief Присвоить строкам обоих текстов номера классов по хешу
+     * @return Количество классов
+     */
+    static size_t classifyLines(Lines& oldLines, Lines& newLines);
+
+    /**
+     * @brief Сравнить строку старого текста со строкой нового
+     */
+    bool equal(size_t oldIndex, size_t newIndex) const;
+
+    /**
+     * @brief Сообщить о ходе работы
+     * @param processedLines Обработано строк старого текста
+     * @return false если сравнение прервано
+     */
+    bool reportProgress(size_t processedLines);
+
+    /**
+     * @brief Сравнить диапазоны строк
+     * @return false если сравнение прервано
+     */
+    bool diffRange(size_t oldBegin, size_t oldEnd, size_t newBegin, size_t newEnd);
+
+    /**
+     * @brief Разбить диапазон по общему участку из самых редких строк
+     *
+     * Общий участок выбирается по наименьшему числу вхождений его строк в
+     * старый диапазон (при равенстве - самый длинный); части до и после
+     * него кладутся в стек.
+     * @return false если общих строк с числом вхождений до MAX_OCCURRENCES нет
+     */
+    bool splitByRareLines(const Range& range, std::vector<Range>& pending);
+
+    /**
+     * @brief Найти точку, через которую проходит кратчайший путь правок
+     * @return false если точка не найдена в пределах бюджета
+     */
+    bool bisect(size_t oldBegin, size_t oldEnd, size_t newBegin, size_t newEnd,
+                size_t& oldSplit, size_t& newSplit);
+
+    /**
+     * @brief Добавить фрагмент (соседние фрагменты объединяются)
+     */
+    void addHunk(size_t oldBegin, size_t oldEnd, size_t newBegin, size_t newEnd);
+
+    LineDiff(const LineDiff&);
+    LineDiff& operator=(const LineDiff&);
+};
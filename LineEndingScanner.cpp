@@ -0,0 +1,218 @@
+#include "LineEndingScanner.h"
+#include <cwchar>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define LINE_ENDING_SCANNER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // Число единичных битов в 16-битной маске
+    inline unsigned int countBits(unsigned int value)
+    {
+        value = value - ((value >> 1) & 0x5555);
+        value = (value & 0x3333) + ((value >> 2) & 0x3333);
+        value = (value + (value >> 4)) & 0x0F0F;
+        return (value + (value >> 8)) & 0x1F;
+    }
+
+    inline unsigned int readUnit(const unsigned char* bytes, bool isBigEndian)
+    {
+        return isBigEndian ? ((bytes[0] << 8) | bytes[1]) : (bytes[0] | (bytes[1] << 8));
+    }
+}
+
+LineEndingScanner::Counts LineEndingScanner::scan(const void* data, size_t size, size_t unitSize, bool isBigEndian)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t lineFeeds = 0;
+    uint64_t carriageReturns = 0;
+    uint64_t pairs = 0;
+    size_t i = 0;
+
+    if (unitSize == 2)
+    {
+        size = size & ~static_cast<size_t>(1);
+#ifdef LINE_ENDING_SCANNER_SSE2
+        // Единица загружается как little-endian: для BE "\n" выглядит как 0x0A00
+        const __m128i lineFeed = _mm_set1_epi16(static_cast<short>(isBigEndian ? 0x0A00 : 0x000A));
+        const __m128i carriageReturn = _mm_set1_epi16(static_cast<short>(isBigEndian ? 0x0D00 : 0x000D));
+        for (; i + 18 <= size; i += 16)
+        {
+            __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i));
+            unsigned int lineFeedMask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi16(current, lineFeed)));
+            unsigned int returnMask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi16(current, carriageReturn)));
+            if ((lineFeedMask | returnMask) == 0)
+            {
+                continue;
+            }
+            __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i + 2));
+            unsigned int nextMask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi16(next, lineFeed)));
+            lineFeeds += countBits(lineFeedMask) / 2;
+            carriageReturns += countBits(returnMask) / 2;
+            pairs += countBits(returnMask & nextMask) / 2;
+        }
+#endif
+        for (; i + 2 <= size; i += 2)
+        {
+            unsigned int unit = readUnit(bytes + i, isBigEndian);
+            if (unit == 0x0A)
+            {
+                ++lineFeeds;
+            }
+            else if (unit == 0x0D)
+            {
+                ++carriageReturns;
+                if (i + 4 <= size && readUnit(bytes + i + 2, isBigEndian) == 0x0A)
+                {
+                    ++pairs;
+                }
+            }
+        }
+    }
+    else
+    {
+#ifdef LINE_ENDING_SCANNER_SSE2
+        // Пара "\r\n": маска '\r' в текущих 16 байтах и маска '\n' в байтах со сдвигом на один
+        const __m128i lineFeed = _mm_set1_epi8('\n');
+        const __m128i carriageReturn = _mm_set1_epi8('\r');
+        for (; i + 17 <= size; i += 16)
+        {
+            __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i));
+            unsigned int lineFeedMask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(current, lineFeed)));
+            unsigned int returnMask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(current, carriageReturn)));
+            if ((lineFeedMask | returnMask) == 0)
+            {
+                continue;
+            }
+            __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i + 1));
+            unsigned int nextMask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(next, lineFeed)));
+            lineFeeds += countBits(lineFeedMask);
+            carriageReturns += countBits(returnMask);
+            pairs += countBits(returnMask & nextMask);
+        }
+#endif
+        for (; i < size; ++i)
+        {
+            if (bytes[i] == '\n')
+            {
+                ++lineFeeds;
+            }
+            else if (bytes[i] == '\r')
+            {
+                ++carriageReturns;
+                if (i + 1 < size && bytes[i + 1] == '\n')
+                {
+                    ++pairs;
+                }
+            }
+        }
+    }
+
+    Counts counts;
+    counts.crlf = pairs;
+    counts.lf = lineFeeds - pairs;
+    counts.cr = carriageReturns - pairs;
+    return counts;
+}
+
+LineEndingScanner::Counts LineEndingScanner::scanText(const wchar_t* text, size_t length)
+{
+    Counts counts = { 0, 0, 0 };
+    for (size_t i = 0; i < length; ++i)
+    {
+        if (text[i] == L'\r')
+        {
+            if (i + 1 < length && text[i + 1] == L'\n')
+            {
+                ++counts.crlf;
+                ++i;
+            }
+            else
+            {
+                ++counts.cr;
+            }
+        }
+        else if (text[i] == L'\n')
+        {
+            ++counts.lf;
+        }
+    }
+    return counts;
+}
+
+DocumentFormat::LineEnding LineEndingScanner::dominant(const Counts& counts)
+{
+    if (counts.lf > counts.crlf && counts.lf >= counts.cr)
+    {
+        return DocumentFormat::LINE_ENDING_LF;
+    }
+    if (counts.cr > counts.crlf && counts.cr > counts.lf)
+    {
+        return DocumentFormat::LINE_ENDING_CR;
+    }
+    return DocumentFormat::LINE_ENDING_CRLF;
+}
+
+uint64_t LineEndingScanner::expansion(const Counts& counts)
+{
+    return counts.lf + counts.cr;
+}
+
+void LineEndingScanner::normalize(std::wstring& text, const Counts& counts)
+{
+    size_t extra = static_cast<size_t>(expansion(counts));
+    if (extra == 0)
+    {
+        return;
+    }
+
+    // Сдвиг с конца: участки между переводами строк переносятся целиком,
+    // каждый одиночный перевод строки раздвигает текст на один символ
+    size_t read = text.size();
+    text.resize(text.size() + extra);
+    wchar_t* data = &text[0];
+    size_t write = text.size();
+    wchar_t next = 0;
+    while (write > read)
+    {
+        size_t start = read;
+        while (start > 0 && data[start - 1] != L'\n' && data[start - 1] != L'\r')
+        {
+            --start;
+        }
+        size_t length = read - start;
+        write -= length;
+        wmemmove(data + write, data + start, length);
+        read = start;
+        if (length > 0)
+        {
+            next = data[write];
+        }
+        if (read == 0)
+        {
+            break;
+        }
+
+        wchar_t symbol = data[--read];
+        if (symbol == L'\n')
+        {
+            data[--write] = L'\n';
+            if (read == 0 || data[read - 1] != L'\r')
+            {
+                data[--write] = L'\r';
+            }
+        }
+        else if (next != L'\n')
+        {
+            data[--write] = L'\n';
+            data[--write] = L'\r';
+        }
+        else
+        {
+            data[--write] = L'\r';
+        }
+        next = symbol;
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "DocumentFormat.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Подсчет переводов строк в байтах файла и приведение текста к CRLF
+ *
+ * EDIT-контрол понимает только "\r\n", поэтому текст файлов с переводами
+ * "\n" или "\r" при загрузке приводится к CRLF, а стиль файла запоминается
+ * в DocumentFormat и восстанавливается при сохранении (TextEncoder).
+ * Исходные байты не меняются: переводы строк считаются прямо в них
+ * (SSE2 по 16 байт за шаг, для UTF-16 - по восемь двухбайтовых единиц),
+ * и по этим счетчикам строка заранее получает окончательный размер, а
+ * приведение выполняется на месте, без второй копии текста.
+ * Не зависит от WinAPI.
+ */
+class LineEndingScanner
+{
+public:
+    /**
+     * @brief Количество переводов строк каждого вида
+     */
+    struct Counts
+    {
+        uint64_t crlf;  ///< Пар "\r\n"
+        uint64_t lf;    ///< Одиночных "\n"
+        uint64_t cr;    ///< Одиночных "\r"
+    };
+
+    /**
+     * @brief Посчитать переводы строк в байтах файла
+     *
+     * Для UTF-8 и однобайтовых кодировок байты 0x0A и 0x0D встречаются только
+     * в переводах строк, поэтому счетчики совпадают со счетчиками в тексте.
+     * @param data Байты (без BOM)
+     * @param size Количество байт
+     * @param unitSize Размер единицы кодировки: 1 или 2 (UTF-16)
+     * @param isBigEndian Порядок байтов UTF-16
+     * @return Счетчики
+     */
+    static Counts scan(const void* data, size_t size, size_t unitSize, bool isBigEndian);
+
+    /**
+     * @brief Посчитать переводы строк в тексте
+     * @param text Текст
+     * @param length Длина текста
+     * @return Счетчики
+     */
+    static Counts scanText(const wchar_t* text, size_t length);
+
+    /**
+     * @brief Преобладающий стиль перевода строк
+     * @param counts Счетчики
+     * @return Самый частый стиль (CRLF, если переводов строк нет)
+     */
+    static DocumentFormat::LineEnding dominant(const Counts& counts);
+
+    /**
+     * @brief Сколько символов добавит приведение к CRLF
+     * @param counts Счетчики
+     * @return Число одиночных "\n" и "\r"
+     */
+    static uint64_t expansion(const Counts& counts);
+
+    /**
+     * @brief Привести одиночные "\n" и "\r" к "\r\n" на месте
+     *
+     * Если емкость строки заранее увеличена на expansion(counts), память
+     * не перераспределяется.
+     * @param text Текст
+     * @param counts Счетчики этого же текста
+     */
+    static void normalize(std::wstring& text, const Counts& counts);
+};
@@ -0,0 +1,353 @@
+#include "LineOperations.h"
+#include "ContentHash.h"
+#include "TaskPool.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+#include <thread>
+
+namespace
+{
+    typedef LineOperations::Line Line;
+
+    // Строка с восемью символами после общего начала всех строк,
+    // упакованными в числа: большинство сравнений решается без обращения
+    // к тексту, разбросанному по памяти
+    struct KeyedLine
+    {
+        uint64_t key[2];
+        Line line;
+    };
+
+    // Четыре символа с позиции start (недостающие - нули)
+    uint64_t lineKey(const wchar_t* text, const Line& line, size_t start)
+    {
+        uint64_t key = 0;
+        for (size_t i = start; i < start + 4; ++i)
+        {
+            key <<= 16;
+            if (i < line.length)
+            {
+                key |= static_cast<uint16_t>(text[line.offset + i]);
+            }
+        }
+        return key;
+    }
+
+    // Строки по кодам символов; при равных ключах сравнивается текст
+    // после общего начала
+    struct OrdinalLess
+    {
+        const wchar_t* text;
+        size_t prefix;
+
+        bool operator()(const KeyedLine& left, const KeyedLine& right) const
+        {
+            if (left.key[0] != right.key[0])
+            {
+                return left.key[0] < right.key[0];
+            }
+            if (left.key[1] != right.key[1])
+            {
+                return left.key[1] < right.key[1];
+            }
+            return LineOperations::compareOrdinal(text + left.line.offset + prefix, left.line.length - prefix,
+                                                  text + right.line.offset + prefix, right.line.length - prefix) < 0;
+        }
+    };
+
+    // Строки по заданному сравнению
+    struct CompareLess
+    {
+        const wchar_t* text;
+        const LineOperations::Compare* compare;
+
+        bool operator()(const Line& left, const Line& right) const
+        {
+            return (*compare)(text + left.offset, left.length, text + right.offset, right.length) < 0;
+        }
+    };
+
+    // Задачи выполняются в отдельных потоках; последняя - в вызывающем
+    void runTasks(std::vector<std::function<void()> >& tasks)
+    {
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i + 1 < tasks.size(); ++i)
+        {
+            threads.push_back(std::thread(tasks[i]));
+        }
+        if (!tasks.empty())
+        {
+            tasks.back()();
+        }
+        for (size_t i = 0; i < threads.size(); ++i)
+        {
+            threads[i].join();
+        }
+    }
+
+    template <typename Item, typename Less>
+    void parallelSort(std::vector<Item>& lines, Less less, size_t threadCount)
+    {
+        size_t count = lines.size();
+        size_t runCount = std::min(threadCount, count / LineOperations::MIN_LINES_PER_THREAD);
+        if (runCount <= 1)
+        {
+            std::stable_sort(lines.begin(), lines.end(), less);
+            return;
+        }
+
+        // Участки сортируются независимо
+        std::vector<size_t> bounds(runCount + 1);
+        for (size_t i = 0; i <= runCount; ++i)
+        {
+            bounds[i] = count * i / runCount;
+        }
+        std::vector<std::function<void()> > tasks;
+        for (size_t i = 0; i < runCount; ++i)
+        {
+            Item* first = &lines[0] + bounds[i];
+            Item* last = &lines[0] + bounds[i + 1];
+            tasks.push_back([first, last, less]() { std::stable_sort(first, last, less); });
+        }
+        runTasks(tasks);
+
+        // Соседние участки сливаются попарно, пока не останется один.
+        // Слияние пары делится на части по строкам левого участка; граница в
+        // правом участке - первая строка не меньше граничной, поэтому
+        // равные строки левого участка остаются впереди (слияние устойчиво)
+        std::vector<Item> buffer(count);
+        Item* source = &lines[0];
+        Item* target = &buffer[0];
+        while (bounds.size() > 2)
+        {
+            size_t pairCount = (bounds.size() - 1) / 2;
+            size_t partsPerPair = std::max<size_t>(1, threadCount / pairCount);
+            std::vector<size_t> merged;
+            tasks.clear();
+            for (size_t pair = 0; pair < pairCount; ++pair)
+            {
+                Item* leftBegin = source + bounds[2 * pair];
+                Item* middle = source + bounds[2 * pair + 1];
+                Item* rightEnd = source + bounds[2 * pair + 2];
+                Item* output = target + bounds[2 * pair];
+                merged.push_back(bounds[2 * pair]);
+
+                size_t leftLength = static_cast<size_t>(middle - leftBegin);
+                Item* rightBegin = middle;
+                for (size_t part = 0; part < partsPerPair; ++part)
+                {
+                    Item* leftFirst = leftBegin + leftLength * part / partsPerPair;
+                    Item* leftLast = leftBegin + leftLength * (part + 1) / partsPerPair;
+                    Item* rightFirst = rightBegin;
+                    Item* rightLast = (part + 1 == partsPerPair) ? rightEnd
+                        : std::lower_bound(rightFirst, rightEnd, *leftLast, less);
+                    Item* partOutput = output + (leftFirst - leftBegin) + (rightFirst - middle);
+                    tasks.push_back([leftFirst, leftLast, rightFirst, rightLast, partOutput, less]()
+                    {
+                        std::merge(leftFirst, leftLast, rightFirst, rightLast, partOutput, less);
+                    });
+                    rightBegin = rightLast;
+                }
+            }
+
+            // Непарный последний участок переносится как есть
+            if ((bounds.size() - 1) % 2 != 0)
+            {
+                size_t first = bounds[bounds.size() - 2];
+                std::copy(source + first, source + count, target + first);
+                merged.push_back(first);
+            }
+            merged.push_back(count);
+
+            runTasks(tasks);
+            bounds.swap(merged);
+            std::swap(source, target);
+        }
+
+        if (source != &lines[0])
+        {
+            lines.swap(buffer);
+        }
+    }
+}
+
+void LineOperations::split(const wchar_t* text, size_t length, std::vector<Line>& lines)
+{
+    lines.clear();
+    size_t start = 0;
+    for (;;)
+    {
+        const wchar_t* found = static_cast<const wchar_t*>(wmemchr(text + start, L'\n', length - start));
+        size_t end = found ? static_cast<size_t>(found - text) : length;
+        size_t lineEnd = (found && end > start && text[end - 1] == L'\r') ? end - 1 : end;
+        Line line = { start, lineEnd - start };
+        lines.push_back(line);
+        if (!found)
+        {
+            break;
+        }
+        start = end + 1;
+    }
+}
+
+void LineOperations::sort(const wchar_t* text, std::vector<Line>& lines, const Compare& compare, size_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = TaskPool::defaultThreadCount();
+    }
+
+    if (compare)
+    {
+        CompareLess less = { text, &compare };
+        parallelSort(lines, less, threadCount);
+    }
+    else
+    {
+        // Общее начало (например, одинаковая дата в выгрузке) не различает
+        // строки, поэтому ключи берутся после него
+        size_t prefix = lines.empty() ? 0 : lines[0].length;
+        for (size_t i = 1; i < lines.size() && prefix > 0; ++i)
+        {
+            const wchar_t* first = text + lines[0].offset;
+            const wchar_t* current = text + lines[i].offset;
+            size_t length = std::min(prefix, lines[i].length);
+            size_t common = 0;
+            while (common < length && first[common] == current[common])
+            {
+                ++common;
+            }
+            prefix = common;
+        }
+
+        std::vector<KeyedLine> keyed(lines.size());
+        for (size_t i = 0; i < lines.size(); ++i)
+        {
+            keyed[i].key[0] = lineKey(text, lines[i], prefix);
+            keyed[i].key[1] = lineKey(text, lines[i], prefix + 4);
+            keyed[i].line = lines[i];
+        }
+        OrdinalLess less = { text, prefix };
+        parallelSort(keyed, less, threadCount);
+        for (size_t i = 0; i < lines.size(); ++i)
+        {
+            lines[i] = keyed[i].line;
+        }
+    }
+}
+
+void LineOperations::unique(const wchar_t* text, std::vector<Line>& lines, size_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = TaskPool::defaultThreadCount();
+    }
+
+    // Хеши строк считаются параллельно
+    size_t count = lines.size();
+    std::vector<uint64_t> hashes(count);
+    size_t partCount = std::max<size_t>(1, std::min(threadCount, count / MIN_LINES_PER_THREAD));
+    std::vector<std::function<void()> > tasks;
+    for (size_t part = 0; part < partCount; ++part)
+    {
+        size_t first = count * part / partCount;
+        size_t last = count * (part + 1) / partCount;
+        tasks.push_back([text, &lines, &hashes, first, last]()
+        {
+            for (size_t i = first; i < last; ++i)
+            {
+                hashes[i] = ContentHash::compute(text + lines[i].offset, lines[i].length * sizeof(wchar_t));
+            }
+        });
+    }
+    runTasks(tasks);
+
+    // Таблица с открытой адресацией хранит номера оставленных строк. Они
+    // не сдвигаются: оставленная строка переносится только назад, на место
+    // уже просмотренной
+    size_t tableSize = 1;
+    while (tableSize < 2 * count)
+    {
+        tableSize *= 2;
+    }
+    const size_t EMPTY_SLOT = static_cast<size_t>(-1);
+    std::vector<size_t> table(tableSize, EMPTY_SLOT);
+    size_t kept = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const Line line = lines[i];
+        uint64_t hash = hashes[i];
+        size_t slot = static_cast<size_t>(hash) & (tableSize - 1);
+        bool isDuplicate = false;
+        for (; table[slot] != EMPTY_SLOT; slot = (slot + 1) & (tableSize - 1))
+        {
+            const Line& other = lines[table[slot]];
+            if (hashes[table[slot]] == hash && other.length == line.length &&
+                wmemcmp(text + other.offset, text + line.offset, line.length) == 0)
+            {
+                isDuplicate = true;
+                break;
+            }
+        }
+        if (!isDuplicate)
+        {
+            lines[kept] = line;
+            hashes[kept] = hash;
+            table[slot] = kept;
+            ++kept;
+        }
+    }
+    lines.resize(kept);
+}
+
+void LineOperations::reverse(std::vector<Line>& lines)
+{
+    std::reverse(lines.begin(), lines.end());
+}
+
+void LineOperations::trimTrailing(const wchar_t* text, std::vector<Line>& lines)
+{
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        Line& line = lines[i];
+        while (line.length > 0 &&
+               (text[line.offset + line.length - 1] == L' ' || text[line.offset + line.length - 1] == L'\t'))
+        {
+            --line.length;
+        }
+    }
+}
+
+void LineOperations::join(const wchar_t* text, const std::vector<Line>& lines, const wchar_t* separator,
+                          std::wstring& result)
+{
+    size_t separatorLength = wcslen(separator);
+    size_t length = lines.empty() ? 0 : separatorLength * (lines.size() - 1);
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        length += lines[i].length;
+    }
+
+    result.clear();
+    result.reserve(length);
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        if (i > 0)
+        {
+            result.append(separator, separatorLength);
+        }
+        result.append(text + lines[i].offset, lines[i].length);
+    }
+}
+
+int LineOperations::compareOrdinal(const wchar_t* left, size_t leftLength, const wchar_t* right, size_t rightLength)
+{
+    int result = wmemcmp(left, right, std::min(leftLength, rightLength));
+    if (result != 0)
+    {
+        return result;
+    }
+    return leftLength < rightLength ? -1 : (leftLength > rightLength ? 1 : 0);
+}
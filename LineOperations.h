@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Операции над строками текста: сортировка, удаление повторов,
+ * обратный порядок и удаление пробелов в конце строк
+ *
+ * Строки представлены отрезками (смещение и длина) в исходном буфере,
+ * поэтому операции переставляют и укорачивают отрезки, не копируя текст;
+ * новый текст собирается один раз в join. Сортировка устойчивая: участки
+ * сортируются в отдельных потоках, затем сливаются попарно, и каждое
+ * слияние тоже делится между потоками по медианам. Класс не зависит от
+ * WinAPI.
+ */
+class LineOperations
+{
+public:
+    /**
+     * @brief Строка в буфере (без перевода строки)
+     */
+    struct Line
+    {
+        size_t offset;      ///< Смещение начала строки
+        size_t length;      ///< Длина строки
+    };
+
+    /**
+     * @brief Сравнение строк
+     * @return Отрицательное число, ноль или положительное число, как у wcscmp
+     */
+    typedef std::function<int(const wchar_t* left, size_t leftLength,
+                              const wchar_t* right, size_t rightLength)> Compare;
+
+    static const size_t MIN_LINES_PER_THREAD = 16384;  ///< Меньшие участки сортируются в одном потоке
+
+    /**
+     * @brief Разбить текст на строки
+     *
+     * Строки разделяются '\n'; '\r' перед ним не входит в строку.
+     * Строк всегда на одну больше, чем переводов строки.
+     * @param text Текст
+     * @param length Длина текста
+     * @param lines Строки текста
+     */
+    static void split(const wchar_t* text, size_t length, std::vector<Line>& lines);
+
+    /**
+     * @brief Устойчиво отсортировать строки
+     * @param text Буфер, в который указывают строки
+     * @param lines Строки
+     * @param compare Сравнение (пустое - по кодам символов)
+     * @param threadCount Количество потоков (0 - по числу ядер)
+     */
+    static void sort(const wchar_t* text, std::vector<Line>& lines, const Compare& compare, size_t threadCount);
+
+    /**
+     * @brief Удалить повторяющиеся строки, оставив первое вхождение каждой
+     * @param text Буфер, в который указывают строки
+     * @param lines Строки
+     * @param threadCount Количество потоков для хеширования (0 - по числу ядер)
+     */
+    static void unique(const wchar_t* text, std::vector<Line>& lines, size_t threadCount);
+
+    /**
+     * @brief Расставить строки в обратном порядке
+     * @param lines Строки
+     */
+    static void reverse(std::vector<Line>& lines);
+
+    /**
+     * @brief Удалить пробелы и табуляции в конце строк
+     * @param text Буфер, в который указывают строки
+     * @param lines Строки
+     */
+    static void trimTrailing(const wchar_t* text, std::vector<Line>& lines);
+
+    /**
+     * @brief Собрать текст из строк
+     * @param text Буфер, в который указывают строки
+     * @param lines Строки
+     * @param separator Перевод строки между строками
+     * @param result Собранный текст
+     */
+    static void join(const wchar_t* text, const std::vector<Line>& lines, const wchar_t* separator,
+                     std::wstring& result);
+
+    /**
+     * @brief Сравнить строки по кодам символов
+     * @return Отрицательное число, ноль или положительное число
+     */
+    static int compareOrdinal(const wchar_t* left, size_t leftLength, const wchar_t* right, size_t rightLength);
+};
@@ -0,0 +1,312 @@
+#include "MacroPlayer.h"
+#include <algorithm>
+#include <cwchar>
+
+namespace
+{
+    const size_t NO_POSITION = ~static_cast<size_t>(0);
+    const size_t MIN_GAP_SIZE = 64 * 1024;
+}
+
+MacroPlayer::MacroPlayer(const wchar_t* text, size_t length, size_t anchor, size_t caret)
+    : m_gapStart(length)
+    , m_gapEnd(length + MIN_GAP_SIZE)
+    , m_caret(std::min(caret, length))
+    , m_anchor(std::min(anchor, length))
+    , m_column(NO_POSITION)
+    , m_originalLength(length)
+    , m_changeStart(NO_POSITION)
+    , m_unchangedSuffix(length)
+{
+    m_buffer.resize(length + MIN_GAP_SIZE);
+    std::copy(text, text + length, m_buffer.begin());
+}
+
+size_t MacroPlayer::run(const KeyboardMacro& macro, size_t times)
+{
+    // Байт-код разбирается один раз на все повторы
+    std::vector<KeyboardMacro::Step> steps;
+    macro.decode(steps);
+    if (steps.empty())
+    {
+        return 0;
+    }
+
+    for (size_t iteration = 0; iteration < times; ++iteration)
+    {
+        for (size_t i = 0; i < steps.size(); ++i)
+        {
+            for (size_t repeat = 0; repeat < steps[i].count; ++repeat)
+            {
+                if (!execute(steps[i]))
+                {
+                    return iteration;
+                }
+            }
+        }
+    }
+    return times;
+}
+
+size_t MacroPlayer::length() const
+{
+    return m_buffer.size() - (m_gapEnd - m_gapStart);
+}
+
+void MacroPlayer::getSelection(size_t& anchor, size_t& caret) const
+{
+    anchor = m_anchor;
+    caret = m_caret;
+}
+
+bool MacroPlayer::getChange(size_t& start, size_t& oldLength, std::wstring& newText) const
+{
+    if (m_changeStart == NO_POSITION)
+    {
+        return false;
+    }
+
+    start = m_changeStart;
+    oldLength = m_originalLength - m_unchangedSuffix - start;
+    size_t newLength = length() - m_unchangedSuffix - start;
+    size_t end = start + newLength;
+
+    // Участок может лежать по обе стороны разрыва
+    newText.clear();
+    newText.reserve(newLength);
+    if (start < m_gapStart)
+    {
+        newText.append(m_buffer.data() + start, std::min(end, m_gapStart) - start);
+    }
+    if (end > m_gapStart)
+    {
+        size_t from = std::max(start, m_gapStart);
+        newText.append(m_buffer.data() + from + (m_gapEnd - m_gapStart), end - from);
+    }
+    return true;
+}
+
+bool MacroPlayer::execute(const KeyboardMacro::Step& step)
+{
+    size_t selectionStart = std::min(m_anchor, m_caret);
+    size_t selectionEnd = std::max(m_anchor, m_caret);
+
+    // Столбец запоминается на время серии перемещений по строкам
+    if (step.opcode != KeyboardMacro::OP_LINE_UP && step.opcode != KeyboardMacro::OP_LINE_DOWN)
+    {
+        m_column = NO_POSITION;
+    }
+
+    switch (step.opcode)
+    {
+    case KeyboardMacro::OP_INSERT:
+        deleteSelection();
+        replace(m_caret, 0, step.text, step.length);
+        m_caret += step.length;
+        break;
+    case KeyboardMacro::OP_DELETE_BACK:
+        if (!deleteSelection())
+        {
+            if (m_caret == 0)
+            {
+                return false;
+            }
+            size_t size = previousCharSize(m_caret);
+            m_caret -= size;
+            replace(m_caret, size, nullptr, 0);
+        }
+        break;
+    case KeyboardMacro::OP_DELETE_FORWARD:
+        if (!deleteSelection())
+        {
+            if (m_caret == length())
+            {
+                return false;
+            }
+            replace(m_caret, nextCharSize(m_caret), nullptr, 0);
+        }
+        break;
+    case KeyboardMacro::OP_CHAR_LEFT:
+        if (selectionStart != selectionEnd)
+        {
+            m_caret = selectionStart;
+        }
+        else if (m_caret == 0)
+        {
+            return false;
+        }
+        else
+        {
+            m_caret -= previousCharSize(m_caret);
+        }
+        break;
+    case KeyboardMacro::OP_CHAR_RIGHT:
+        if (selectionStart != selectionEnd)
+        {
+            m_caret = selectionEnd;
+        }
+        else if (m_caret == length())
+        {
+            return false;
+        }
+        else
+        {
+            m_caret += nextCharSize(m_caret);
+        }
+        break;
+    case KeyboardMacro::OP_LINE_UP:
+    case KeyboardMacro::OP_LINE_DOWN:
+    {
+        size_t start = lineStart(m_caret);
+        if (m_column == NO_POSITION)
+        {
+            m_column = m_caret - start;
+        }
+
+        size_t target;
+        if (step.opcode == KeyboardMacro::OP_LINE_UP)
+        {
+            if (start == 0)
+            {
+                return false;
+            }
+            target = lineStart(start - 1);
+        }
+        else
+        {
+            size_t end = lineEnd(m_caret);
+            if (end == length())
+            {
+                return false;
+            }
+            target = end + nextCharSize(end);
+        }
+        m_caret = std::min(target + m_column, lineEnd(target));
+        break;
+    }
+    case KeyboardMacro::OP_LINE_HOME:
+        m_caret = lineStart(m_caret);
+        break;
+    case KeyboardMacro::OP_LINE_END:
+        m_caret = lineEnd(m_caret);
+        break;
+    case KeyboardMacro::OP_FIND_NEXT:
+        // find выделяет найденный текст сам
+        return find(step.text, step.length);
+    default:
+        return false;
+    }
+
+    m_anchor = m_caret;
+    return true;
+}
+
+wchar_t MacroPlayer::charAt(size_t position) const
+{
+    return position < m_gapStart ? m_buffer[position] : m_buffer[position + (m_gapEnd - m_gapStart)];
+}
+
+void MacroPlayer::moveGap(size_t position)
+{
+    if (position < m_gapStart)
+    {
+        size_t count = m_gapStart - position;
+        wmemmove(m_buffer.data() + m_gapEnd - count, m_buffer.data() + position, count);
+        m_gapStart -= count;
+        m_gapEnd -= count;
+    }
+    else if (position > m_gapStart)
+    {
+        size_t count = position - m_gapStart;
+        wmemmove(m_buffer.data() + m_gapStart, m_buffer.data() + m_gapEnd, count);
+        m_gapStart += count;
+        m_gapEnd += count;
+    }
+}
+
+void MacroPlayer::replace(size_t position, size_t removeCount, const wchar_t* text, size_t count)
+{
+    // Конец текста после правки не меняется: его длина ограничивает участок изменений
+    size_t currentLength = length();
+    m_changeStart = std::min(m_changeStart, position);
+    m_unchangedSuffix = std::min(m_unchangedSuffix, currentLength - position - removeCount);
+
+    moveGap(position);
+    m_gapEnd += removeCount;
+    if (m_gapEnd - m_gapStart < count)
+    {
+        // Разрыв расширяется с запасом, чтобы следующие вставки не перемещали текст
+        size_t tail = m_buffer.size() - m_gapEnd;
+        size_t gap = std::max(count, std::max(MIN_GAP_SIZE, m_buffer.size() / 2));
+        std::vector<wchar_t> buffer(m_gapStart + gap + tail);
+        std::copy(m_buffer.begin(), m_buffer.begin() + m_gapStart, buffer.begin());
+        std::copy(m_buffer.begin() + m_gapEnd, m_buffer.end(), buffer.begin() + m_gapStart + gap);
+        m_buffer.swap(buffer);
+        m_gapEnd = m_gapStart + gap;
+    }
+    std::copy(text, text + count, m_buffer.begin() + m_gapStart);
+    m_gapStart += count;
+}
+
+bool MacroPlayer::deleteSelection()
+{
+    if (m_anchor == m_caret)
+    {
+        return false;
+    }
+    size_t start = std::min(m_anchor, m_caret);
+    replace(start, std::max(m_anchor, m_caret) - start, nullptr, 0);
+    m_anchor = m_caret = start;
+    return true;
+}
+
+size_t MacroPlayer::lineStart(size_t position) const
+{
+    while (position > 0 && charAt(position - 1) != L'\n')
+    {
+        --position;
+    }
+    return position;
+}
+
+size_t MacroPlayer::lineEnd(size_t position) const
+{
+    size_t end = length();
+    while (position < end && charAt(position) != L'\r' && charAt(position) != L'\n')
+    {
+        ++position;
+    }
+    return position;
+}
+
+size_t MacroPlayer::previousCharSize(size_t position) const
+{
+    return (position >= 2 && charAt(position - 1) == L'\n' && charAt(position - 2) == L'\r') ? 2 : 1;
+}
+
+size_t MacroPlayer::nextCharSize(size_t position) const
+{
+    return (position + 1 < length() && charAt(position) == L'\r' && charAt(position + 1) == L'\n') ? 2 : 1;
+}
+
+bool MacroPlayer::find(const wchar_t* text, size_t count)
+{
+    if (count == 0)
+    {
+        return false;
+    }
+
+    // После переноса разрыва к курсору остаток текста лежит подряд
+    size_t from = std::max(m_anchor, m_caret);
+    moveGap(from);
+    const wchar_t* begin = m_buffer.data() + m_gapEnd;
+    const wchar_t* end = m_buffer.data() + m_buffer.size();
+    const wchar_t* found = std::search(begin, end, text, text + count);
+    if (found == end)
+    {
+        return false;
+    }
+    m_anchor = from + static_cast<size_t>(found - begin);
+    m_caret = m_anchor + count;
+    return true;
+}
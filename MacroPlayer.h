@@ -0,0 +1,127 @@
+#pragma once
+
+#include "KeyboardMacro.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Выполнение макроса над копией текста одной правкой
+ *
+ * Текст хранится в буфере с разрывом (gap buffer): разрыв стоит у курсора,
+ * поэтому вставка и удаление стоят O(длины правки), а перемещение курсора
+ * на соседнюю строку - O(длины строки). Макрос, проходящий по файлу
+ * строка за строкой, выполняется за один проход независимо от числа
+ * повторов. Запоминаются границы изменившегося участка, чтобы документ
+ * получил результат одной заменой и перерисовался один раз.
+ * Переводы строк - "\r\n" (как в EDIT-контроле). Не зависит от WinAPI.
+ */
+class MacroPlayer
+{
+public:
+    /**
+     * @brief Конструктор
+     * @param text Текст документа
+     * @param length Длина текста
+     * @param anchor Неподвижный конец выделения
+     * @param caret Курсор
+     */
+    MacroPlayer(const wchar_t* text, size_t length, size_t anchor, size_t caret);
+
+    /**
+     * @brief Выполнить макрос несколько раз
+     *
+     * Выполнение прекращается на шаге, который невозможен (курсор в
+     * начале или в конце текста, нет следующей строки, текст не найден).
+     * @param macro Макрос
+     * @param times Число повторов
+     * @return Число полностью выполненных повторов
+     */
+    size_t run(const KeyboardMacro& macro, size_t times);
+
+    /**
+     * @brief Получить длину текста
+     * @return Количество символов
+     */
+    size_t length() const;
+
+    /**
+     * @brief Получить выделение после выполнения
+     * @param anchor Неподвижный конец выделения
+     * @param caret Курсор
+     */
+    void getSelection(size_t& anchor, size_t& caret) const;
+
+    /**
+     * @brief Получить изменившийся участок
+     * @param start Начало участка
+     * @param oldLength Длина участка в исходном тексте
+     * @param newText Новый текст участка
+     * @return false если текст не изменился
+     */
+    bool getChange(size_t& start, size_t& oldLength, std::wstring& newText) const;
+
+private:
+    std::vector<wchar_t> m_buffer;  ///< Текст с разрывом [m_gapStart, m_gapEnd)
+    size_t m_gapStart;              ///< Начало разрыва (позиция курсора в буфере)
+    size_t m_gapEnd;                ///< Конец разрыва
+    size_t m_caret;                 ///< Курсор
+    size_t m_anchor;                ///< Неподвижный конец выделения
+    size_t m_column;                ///< Столбец для перемещения по строкам
+    size_t m_originalLength;        ///< Длина исходного текста
+    size_t m_changeStart;           ///< Начало изменений
+    size_t m_unchangedSuffix;       ///< Длина неизменного конца текста
+
+    /**
+     * @brief Выполнить один шаг
+     * @return false если шаг невозможен
+     */
+    bool execute(const KeyboardMacro::Step& step);
+
+    /**
+     * @brief Получить символ по позиции в тексте
+     */
+    wchar_t charAt(size_t position) const;
+
+    /**
+     * @brief Перенести разрыв в позицию текста
+     */
+    void moveGap(size_t position);
+
+    /**
+     * @brief Заменить фрагмент текста и расширить изменившийся участок
+     */
+    void replace(size_t position, size_t removeCount, const wchar_t* text, size_t count);
+
+    /**
+     * @brief Удалить выделенный текст
+     * @return false если выделения нет
+     */
+    bool deleteSelection();
+
+    /**
+     * @brief Получить начало строки, содержащей позицию
+     */
+    size_t lineStart(size_t position) const;
+
+    /**
+     * @brief Получить конец строки (перед "\r\n"), содержащей позицию
+     */
+    size_t lineEnd(size_t position) const;
+
+    /**
+     * @brief Получить длину символа перед позицией ("\r\n" - один символ)
+     */
+    size_t previousCharSize(size_t position) const;
+
+    /**
+     * @brief Получить длину символа после позиции ("\r\n" - один символ)
+     */
+    size_t nextCharSize(size_t position) const;
+
+    /**
+     * @brief Найти текст от курсора и выделить его
+     * @return false если текст не найден
+     */
+    bool find(const wchar_t* text, size_t count);
+};
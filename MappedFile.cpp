@@ -0,0 +1,149 @@
+#include "MappedFile.h"
+#include "Utf8Codec.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_isOpen(false)
+    , m_fileHandle(nullptr)
+    , m_mappingHandle(nullptr)
+    , m_descriptor(-1)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::wstring& path)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(hFile, &fileSize) ||
+        static_cast<uint64_t>(fileSize.QuadPart) > static_cast<uint64_t>(static_cast<SIZE_T>(-1)))
+    {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    m_fileHandle = hFile;
+    m_size = static_cast<uint64_t>(fileSize.QuadPart);
+    if (m_size > 0)
+    {
+        HANDLE hMapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        void* view = hMapping ? MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+        if (!view)
+        {
+            if (hMapping)
+            {
+                CloseHandle(hMapping);
+            }
+            CloseHandle(hFile);
+            m_fileHandle = nullptr;
+            m_size = 0;
+            return false;
+        }
+        m_mappingHandle = hMapping;
+        m_data = static_cast<const unsigned char*>(view);
+    }
+#else
+    int descriptor = ::open(Utf8Codec::encode(path).c_str(), O_RDONLY);
+    if (descriptor < 0)
+    {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(descriptor, &st) != 0)
+    {
+        ::close(descriptor);
+        return false;
+    }
+
+    m_descriptor = descriptor;
+    m_size = static_cast<uint64_t>(st.st_size);
+    if (m_size > 0)
+    {
+        void* view = mmap(nullptr, static_cast<size_t>(m_size), PROT_READ, MAP_SHARED, descriptor, 0);
+        if (view == MAP_FAILED)
+        {
+            ::close(descriptor);
+            m_descriptor = -1;
+            m_size = 0;
+            return false;
+        }
+        m_data = static_cast<const unsigned char*>(view);
+    }
+#endif
+
+    m_isOpen = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+    if (m_data)
+    {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mappingHandle)
+    {
+        CloseHandle(m_mappingHandle);
+    }
+    if (m_fileHandle)
+    {
+        CloseHandle(m_fileHandle);
+    }
+#else
+    if (m_data)
+    {
+        munmap(const_cast<unsigned char*>(m_data), static_cast<size_t>(m_size));
+    }
+    if (m_descriptor >= 0)
+    {
+        ::close(m_descriptor);
+    }
+#endif
+
+    m_data = nullptr;
+    m_size = 0;
+    m_isOpen = false;
+    m_fileHandle = nullptr;
+    m_mappingHandle = nullptr;
+    m_descriptor = -1;
+}
+
+bool MappedFile::isOpen() const
+{
+    return m_isOpen;
+}
+
+const unsigned char* MappedFile::data() const
+{
+    return m_data;
+}
+
+uint64_t MappedFile::size() const
+{
+    return m_size;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Файл, отображенный в память только для чтения
+ *
+ * Использует CreateFileMapping в Windows и mmap в Linux.
+ */
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    /**
+     * @brief Отобразить файл в память целиком
+     * @param path Путь к файлу
+     * @return true если файл отображен (пустой файл отображается с размером 0)
+     */
+    bool open(const std::wstring& path);
+
+    /**
+     * @brief Закрыть отображение
+     */
+    void close();
+
+    /**
+     * @brief Проверить, открыт ли файл
+     * @return true если файл открыт
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Получить указатель на данные
+     * @return Указатель на начало файла (nullptr для пустого файла)
+     */
+    const unsigned char* data() const;
+
+    /**
+     * @brief Получить размер файла
+     * @return Размер в байтах
+     */
+    uint64_t size() const;
+
+private:
+    const unsigned char* m_data;    ///< Начало отображения
+    uint64_t m_size;                ///< Размер файла
+    bool m_isOpen;                  ///< Флаг открытого файла
+    void* m_fileHandle;             ///< Дескриптор файла (Windows)
+    void* m_mappingHandle;          ///< Дескриптор отображения (Windows)
+    int m_descriptor;               ///< Файловый дескриптор (Linux)
+
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+};
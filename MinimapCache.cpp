@@ -0,0 +1,266 @@
+#include "MinimapCache.h"
+#include <algorithm>
+
+MinimapCache::MinimapCache()
+    : m_linesPerRow(1)
+    , m_lineCount(1)
+    , m_version(0)
+{
+    Tile empty = { 0, 1, std::vector<uint16_t>(WIDTH, 0) };
+    m_tiles.assign(1, empty);
+}
+
+void MinimapCache::onTextReset(const ChunkedText& text)
+{
+    ++m_version;
+    rebuild(text);
+}
+
+void MinimapCache::onTextEdited(const ChunkedText& text, const TextEdit& edit, const ChunkChange& change)
+{
+    (void)change;
+    ++m_version;
+
+    // Плитки от той, где начинается правка, до той, где кончается удаленный
+    // текст, рисуются заново; границы участка остаются на началах строк
+    size_t firstStart = 0;
+    size_t lastStart = 0;
+    size_t first = findTile(edit.offset, firstStart);
+    size_t last = findTile(edit.offset + edit.removedText.size(), lastStart);
+    size_t oldEnd = lastStart + m_tiles[last].length;
+    bool isLast = last + 1 == m_tiles.size();
+    size_t length = oldEnd - firstStart - edit.removedText.size() + edit.insertedLength;
+
+    std::vector<Tile> tiles;
+    rasterize(text, firstStart, length, isLast, tiles);
+    for (size_t i = first; i <= last; ++i)
+    {
+        m_lineCount -= m_tiles[i].lineCount;
+    }
+    for (size_t i = 0; i < tiles.size(); ++i)
+    {
+        m_lineCount += tiles[i].lineCount;
+    }
+    m_tiles.erase(m_tiles.begin() + first, m_tiles.begin() + last + 1);
+    m_tiles.insert(m_tiles.begin() + first, tiles.begin(), tiles.end());
+
+    // Масштаб меняется только при двукратном отклонении от желаемого,
+    // поэтому полная перестройка не повторяется при вводе около границы
+    size_t rows = m_lineCount / m_linesPerRow;
+    if ((rows > 2 * TARGET_ROWS && m_linesPerRow < MAX_LINES_PER_ROW) ||
+        (rows < TARGET_ROWS / 2 && m_linesPerRow > 1))
+    {
+        rebuild(text);
+    }
+}
+
+size_t MinimapCache::render(size_t height, std::vector<uint8_t>& pixels) const
+{
+    pixels.assign(height * WIDTH, 0);
+    if (height == 0)
+    {
+        return 0;
+    }
+
+    // Строки растра раскладываются по строкам карты по своим строкам текста:
+    // несколько строк растра в одной точке суммируются, одна строка растра
+    // на нескольких точках повторяется
+    double scale = pixelsPerLine(height);
+    std::vector<uint32_t> sums(height * WIDTH, 0);
+    std::vector<uint32_t> lines(height, 0);
+    size_t line = 0;
+    for (size_t i = 0; i < m_tiles.size(); ++i)
+    {
+        const Tile& tile = m_tiles[i];
+        size_t rows = tile.cells.size() / WIDTH;
+        for (size_t row = 0; row < rows; ++row)
+        {
+            size_t count = std::min(m_linesPerRow, tile.lineCount - row * m_linesPerRow);
+            size_t top = static_cast<size_t>(line * scale);
+            size_t bottom = static_cast<size_t>((line + count) * scale);
+            line += count;
+            if (top >= height)
+            {
+                break;
+            }
+            bottom = std::min(std::max(bottom, top + 1), height);
+
+            const uint16_t* cells = &tile.cells[row * WIDTH];
+            for (size_t y = top; y < bottom; ++y)
+            {
+                lines[y] += static_cast<uint32_t>(count);
+                uint32_t* sum = &sums[y * WIDTH];
+                for (size_t x = 0; x < WIDTH; ++x)
+                {
+                    sum[x] += cells[x];
+                }
+            }
+        }
+    }
+
+    // Яркость - доля занятых символами клеток под точкой
+    for (size_t y = 0; y < height; ++y)
+    {
+        if (lines[y] == 0)
+        {
+            continue;
+        }
+        uint32_t capacity = lines[y] * static_cast<uint32_t>(COLUMNS_PER_PIXEL);
+        for (size_t x = 0; x < WIDTH; ++x)
+        {
+            uint32_t value = sums[y * WIDTH + x] * 255 / capacity;
+            pixels[y * WIDTH + x] = static_cast<uint8_t>(std::min<uint32_t>(value, 255));
+        }
+    }
+    return std::min(height, static_cast<size_t>(m_lineCount * scale + 0.5));
+}
+
+size_t MinimapCache::lineAtRow(size_t y, size_t height) const
+{
+    size_t line = static_cast<size_t>(y / pixelsPerLine(height));
+    return std::min(line, m_lineCount - 1);
+}
+
+size_t MinimapCache::rowOfLine(size_t line, size_t height) const
+{
+    return static_cast<size_t>(line * pixelsPerLine(height));
+}
+
+size_t MinimapCache::lineCount() const
+{
+    return m_lineCount;
+}
+
+uint32_t MinimapCache::version() const
+{
+    return m_version;
+}
+
+size_t MinimapCache::tileCount() const
+{
+    return m_tiles.size();
+}
+
+size_t MinimapCache::memoryUsage() const
+{
+    size_t bytes = m_tiles.capacity() * sizeof(Tile);
+    for (size_t i = 0; i < m_tiles.size(); ++i)
+    {
+        bytes += m_tiles[i].cells.capacity() * sizeof(uint16_t);
+    }
+    return bytes;
+}
+
+void MinimapCache::rebuild(const ChunkedText& text)
+{
+    size_t lineCount = 1;
+    for (size_t i = 0; i < text.chunkCount(); ++i)
+    {
+        const std::wstring& chunk = text.chunkText(i);
+        lineCount += std::count(chunk.begin(), chunk.end(), L'\n');
+    }
+    m_linesPerRow = 1;
+    while (lineCount / m_linesPerRow > TARGET_ROWS && m_linesPerRow < MAX_LINES_PER_ROW)
+    {
+        m_linesPerRow *= 2;
+    }
+
+    m_tiles.clear();
+    rasterize(text, 0, text.length(), true, m_tiles);
+    m_lineCount = lineCount;
+}
+
+void MinimapCache::rasterize(const ChunkedText& text, size_t offset, size_t length, bool isLast,
+                             std::vector<Tile>& output) const
+{
+    const size_t tileLines = TILE_ROWS * m_linesPerRow;
+    const size_t maxColumn = WIDTH * COLUMNS_PER_PIXEL;
+    Tile tile = { 0, 0, std::vector<uint16_t>() };
+    size_t column = 0;
+
+    size_t inner = 0;
+    size_t chunk = length > 0 ? text.findChunk(offset, inner) : 0;
+    while (length > 0)
+    {
+        const std::wstring& block = text.chunkText(chunk);
+        size_t count = std::min(block.size() - inner, length);
+        for (size_t i = inner; i < inner + count; ++i)
+        {
+            wchar_t character = block[i];
+            ++tile.length;
+            if (character == L'\n')
+            {
+                column = 0;
+                if (++tile.lineCount == tileLines)
+                {
+                    tile.cells.resize(TILE_ROWS * WIDTH, 0);
+                    output.push_back(Tile());
+                    output.back().length = tile.length;
+                    output.back().lineCount = tile.lineCount;
+                    output.back().cells.swap(tile.cells);
+                    tile.length = 0;
+                    tile.lineCount = 0;
+                }
+            }
+            else if (character == L'\t')
+            {
+                column += TAB_SIZE - column % TAB_SIZE;
+            }
+            else if (character == L' ')
+            {
+                ++column;
+            }
+            else if (character != L'\r' && !(character >= 0xDC00 && character <= 0xDFFF))
+            {
+                // Вторая половина суррогатной пары не занимает столбца
+                if (column < maxColumn)
+                {
+                    size_t cell = (tile.lineCount / m_linesPerRow) * WIDTH + column / COLUMNS_PER_PIXEL;
+                    if (tile.cells.size() <= cell)
+                    {
+                        tile.cells.resize((cell / WIDTH + 1) * WIDTH, 0);
+                    }
+                    ++tile.cells[cell];
+                }
+                ++column;
+            }
+        }
+        length -= count;
+        inner = 0;
+        ++chunk;
+    }
+
+    // Последняя строка текста начинается после последнего перевода строки
+    if (isLast)
+    {
+        ++tile.lineCount;
+    }
+    if (isLast || tile.length > 0)
+    {
+        tile.cells.resize((tile.lineCount + m_linesPerRow - 1) / m_linesPerRow * WIDTH, 0);
+        output.push_back(Tile());
+        output.back().length = tile.length;
+        output.back().lineCount = tile.lineCount;
+        output.back().cells.swap(tile.cells);
+    }
+}
+
+size_t MinimapCache::findTile(size_t offset, size_t& tileStart) const
+{
+    tileStart = 0;
+    for (size_t i = 0; i + 1 < m_tiles.size(); ++i)
+    {
+        if (offset < tileStart + m_tiles[i].length)
+        {
+            return i;
+        }
+        tileStart += m_tiles[i].length;
+    }
+    return m_tiles.size() - 1;
+}
+
+double MinimapCache::pixelsPerLine(size_t height) const
+{
+    double scale = static_cast<double>(height) / static_cast<double>(m_lineCount);
+    return std::min(scale, static_cast<double>(MAX_PIXELS_PER_LINE));
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "TextChangeTracker.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Уменьшенный растр документа для мини-карты
+ *
+ * Документ делится на плитки - полосы из TILE_ROWS строк растра. Строка
+ * растра сводит m_linesPerRow строк текста: для каждой точки хранится
+ * число непробельных символов в ее COLUMNS_PER_PIXEL столбцах всех этих
+ * строк. Плитка хранит свою длину в символах и число строк, а не позицию,
+ * поэтому правка перерисовывает только затронутые плитки, даже если
+ * добавляет или удаляет строки. Масштаб (степень двойки) подбирается так,
+ * чтобы растр всего документа занимал около TARGET_ROWS строк, и меняется
+ * с полной перестройкой, только когда число строк выросло или упало вдвое.
+ * Картинка нужной высоты собирается из плиток за O(TARGET_ROWS * WIDTH).
+ * Класс не зависит от WinAPI.
+ */
+class MinimapCache : public ITextChangeListener
+{
+public:
+    static const size_t WIDTH = 64;                 ///< Ширина растра в точках
+    static const size_t COLUMNS_PER_PIXEL = 2;      ///< Столбцов текста на точку
+    static const size_t TAB_SIZE = 4;               ///< Ширина табуляции
+    static const size_t TILE_ROWS = 1;              ///< Строк растра в плитке
+    static const size_t TARGET_ROWS = 2048;         ///< Желаемое число строк растра документа
+    static const size_t MAX_LINES_PER_ROW = 16384;  ///< Предел сжатия (счетчики 16-битные)
+    static const size_t MAX_PIXELS_PER_LINE = 2;    ///< Наибольшая высота строки текста на карте
+
+    MinimapCache();
+
+    void onTextReset(const ChunkedText& text) override;
+    void onTextEdited(const ChunkedText& text, const TextEdit& edit, const ChunkChange& change) override;
+
+    /**
+     * @brief Нарисовать мини-карту
+     * @param height Высота карты в точках
+     * @param pixels Яркость точек (WIDTH на строку, 0 - пусто, 255 - сплошной текст)
+     * @return Высота занятой документом части карты
+     */
+    size_t render(size_t height, std::vector<uint8_t>& pixels) const;
+
+    /**
+     * @brief Получить строку текста по строке карты
+     * @param y Строка карты
+     * @param height Высота карты
+     * @return Номер строки документа
+     */
+    size_t lineAtRow(size_t y, size_t height) const;
+
+    /**
+     * @brief Получить строку карты по строке текста
+     * @param line Номер строки документа
+     * @param height Высота карты
+     * @return Строка карты
+     */
+    size_t rowOfLine(size_t line, size_t height) const;
+
+    /**
+     * @brief Получить количество строк документа
+     * @return Количество строк
+     */
+    size_t lineCount() const;
+
+    /**
+     * @brief Получить номер версии (растет при каждой правке)
+     * @return Номер версии
+     */
+    uint32_t version() const;
+
+    /**
+     * @brief Получить количество плиток
+     * @return Количество плиток
+     */
+    size_t tileCount() const;
+
+    /**
+     * @brief Оценить занимаемую память
+     * @return Байт в растре плиток
+     */
+    size_t memoryUsage() const;
+
+private:
+    /**
+     * @brief Плитка: полоса растра над непрерывным участком целых строк
+     */
+    struct Tile
+    {
+        size_t length;                  ///< Символов в плитке (с переводами строк)
+        size_t lineCount;               ///< Строк, начинающихся в плитке
+        std::vector<uint16_t> cells;    ///< Растр: непробельные символы под точкой
+    };
+
+    std::vector<Tile> m_tiles;          ///< Плитки по порядку; все, кроме последней, кончаются переводом строки
+    size_t m_linesPerRow;               ///< Строк текста в строке растра
+    size_t m_lineCount;                 ///< Строк в документе
+    uint32_t m_version;                 ///< Номер версии
+
+    /**
+     * @brief Построить плитки для всего текста с подходящим масштабом
+     */
+    void rebuild(const ChunkedText& text);
+
+    /**
+     * @brief Разбить участок текста на плитки и нарисовать их
+     * @param text Текст документа
+     * @param offset Начало участка (начало строки)
+     * @param length Длина участка (до начала строки или до конца текста)
+     * @param isLast Участок доходит до конца текста
+     * @param output Плитки участка
+     */
+    void rasterize(const ChunkedText& text, size_t offset, size_t length, bool isLast,
+                   std::vector<Tile>& output) const;
+
+    /**
+     * @brief Найти плитку, содержащую позицию
+     * @param offset Позиция в документе
+     * @param tileStart Начало найденной плитки
+     * @return Номер плитки; для позиции в конце текста - последняя
+     */
+    size_t findTile(size_t offset, size_t& tileStart) const;
+
+    /**
+     * @brief Получить высоту строки текста на карте
+     */
+    double pixelsPerLine(size_t height) const;
+};
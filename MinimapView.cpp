@@ -0,0 +1,287 @@
+#include "MinimapView.h"
+#include <windowsx.h>
+
+namespace
+{
+    const WCHAR MINIMAP_CLASS_NAME[] = L"MinimapView";
+
+    // Канал цвета между фоном и текстом по яркости точки
+    BYTE blend(BYTE background, BYTE text, uint8_t value)
+    {
+        return (BYTE)((background * (255 - value) + text * value) / 255);
+    }
+}
+
+MinimapView::MinimapView(HINSTANCE hInstance, const MinimapCache& cache)
+    : m_hInstance(hInstance)
+    , m_hWnd(NULL)
+    , m_hTarget(NULL)
+    , m_cache(cache)
+    , m_textColor(RGB(0, 0, 0))
+    , m_backgroundColor(RGB(255, 255, 255))
+    , m_paintedVersion(0)
+    , m_paintedFirstLine(-1)
+    , m_isDragging(FALSE)
+{
+}
+
+MinimapView::~MinimapView()
+{
+    if (m_hWnd)
+    {
+        DestroyWindow(m_hWnd);
+        m_hWnd = NULL;
+    }
+}
+
+BOOL MinimapView::create(HWND hParent)
+{
+    WNDCLASSEXW wcex = {};
+    wcex.cbSize = sizeof(WNDCLASSEX);
+    wcex.style = CS_HREDRAW | CS_VREDRAW;
+    wcex.lpfnWndProc = viewProc;
+    wcex.hInstance = m_hInstance;
+    wcex.hCursor = LoadCursor(nullptr, IDC_ARROW);
+    wcex.lpszClassName = MINIMAP_CLASS_NAME;
+
+    if (!RegisterClassExW(&wcex) && GetLastError() != ERROR_CLASS_ALREADY_EXISTS)
+    {
+        return FALSE;
+    }
+
+    m_hWnd = CreateWindowExW(
+        0,
+        MINIMAP_CLASS_NAME,
+        L"",
+        WS_CHILD,
+        0, 0, 0, 0,
+        hParent,
+        NULL,
+        m_hInstance,
+        this
+    );
+    if (!m_hWnd)
+    {
+        return FALSE;
+    }
+
+    SetTimer(m_hWnd, TIMER_REFRESH, REFRESH_INTERVAL, NULL);
+    return TRUE;
+}
+
+HWND MinimapView::getHandle() const
+{
+    return m_hWnd;
+}
+
+void MinimapView::setTarget(HWND hTarget)
+{
+    m_hTarget = hTarget;
+    m_paintedFirstLine = -1;
+    refresh();
+}
+
+void MinimapView::setColors(COLORREF textColor, COLORREF backgroundColor)
+{
+    m_textColor = textColor;
+    m_backgroundColor = backgroundColor;
+    if (m_hWnd)
+    {
+        InvalidateRect(m_hWnd, NULL, FALSE);
+    }
+}
+
+int MinimapView::getWidth()
+{
+    return static_cast<int>(MinimapCache::WIDTH);
+}
+
+void MinimapView::paint(HDC hdc)
+{
+    RECT client;
+    GetClientRect(m_hWnd, &client);
+    size_t height = client.bottom > 0 ? static_cast<size_t>(client.bottom) : 0;
+    if (!m_hTarget)
+    {
+        return;
+    }
+    m_paintedVersion = m_cache.version();
+    m_paintedFirstLine = (int)SendMessage(m_hTarget, EM_GETFIRSTVISIBLELINE, 0, 0);
+    if (height == 0)
+    {
+        return;
+    }
+
+    // Растр собирается из плиток и окрашивается смешением цветов текста и фона
+    m_cache.render(height, m_pixels);
+    m_bitmap.resize(m_pixels.size());
+    for (size_t i = 0; i < m_pixels.size(); ++i)
+    {
+        uint8_t value = m_pixels[i];
+        m_bitmap[i] = RGB(blend(GetBValue(m_backgroundColor), GetBValue(m_textColor), value),
+                          blend(GetGValue(m_backgroundColor), GetGValue(m_textColor), value),
+                          blend(GetRValue(m_backgroundColor), GetRValue(m_textColor), value));
+    }
+
+    BITMAPINFO bmi = {};
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = static_cast<LONG>(MinimapCache::WIDTH);
+    bmi.bmiHeader.biHeight = -static_cast<LONG>(height);   // Строки сверху вниз
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    SetDIBitsToDevice(hdc, 0, 0, static_cast<DWORD>(MinimapCache::WIDTH), static_cast<DWORD>(height),
+                      0, 0, 0, static_cast<UINT>(height), &m_bitmap[0], &bmi, DIB_RGB_COLORS);
+
+    // Рамка видимой части EDIT-контрола
+    size_t firstLine = static_cast<size_t>(m_paintedFirstLine > 0 ? m_paintedFirstLine : 0);
+    RECT frame = { 0, 0, client.right, 0 };
+    frame.top = static_cast<LONG>(m_cache.rowOfLine(firstLine, height));
+    frame.bottom = static_cast<LONG>(m_cache.rowOfLine(firstLine + getTargetPageLines(), height));
+    if (frame.bottom < frame.top + 2)
+    {
+        frame.bottom = frame.top + 2;
+    }
+    HBRUSH hBrush = CreateSolidBrush(m_textColor);
+    FrameRect(hdc, &frame, hBrush);
+    DeleteObject(hBrush);
+}
+
+int MinimapView::getTargetPageLines() const
+{
+    RECT rect;
+    if (!GetClientRect(m_hTarget, &rect))
+    {
+        return 1;
+    }
+
+    HDC hdc = GetDC(m_hTarget);
+    HFONT hFont = (HFONT)SendMessage(m_hTarget, WM_GETFONT, 0, 0);
+    HFONT hOldFont = hFont ? (HFONT)SelectObject(hdc, hFont) : NULL;
+    TEXTMETRICW tm;
+    int lineHeight = GetTextMetricsW(hdc, &tm) ? tm.tmHeight : 0;
+    if (hOldFont)
+    {
+        SelectObject(hdc, hOldFont);
+    }
+    ReleaseDC(m_hTarget, hdc);
+
+    int lines = lineHeight > 0 ? (rect.bottom - rect.top) / lineHeight : 1;
+    return lines > 1 ? lines : 1;
+}
+
+void MinimapView::scrollTarget(int y)
+{
+    RECT client;
+    GetClientRect(m_hWnd, &client);
+    if (client.bottom <= 0)
+    {
+        return;
+    }
+    if (y < 0)
+    {
+        y = 0;
+    }
+
+    size_t line = m_cache.lineAtRow(static_cast<size_t>(y), static_cast<size_t>(client.bottom));
+    int page = getTargetPageLines();
+    int target = static_cast<int>(line) - page / 2;
+    int firstLine = (int)SendMessage(m_hTarget, EM_GETFIRSTVISIBLELINE, 0, 0);
+    SendMessage(m_hTarget, EM_LINESCROLL, 0, (target > 0 ? target : 0) - firstLine);
+    refresh();
+}
+
+void MinimapView::refresh()
+{
+    if (!m_hWnd || !m_hTarget || !IsWindowVisible(m_hWnd))
+    {
+        return;
+    }
+
+    int firstLine = (int)SendMessage(m_hTarget, EM_GETFIRSTVISIBLELINE, 0, 0);
+    if (m_cache.version() != m_paintedVersion || firstLine != m_paintedFirstLine)
+    {
+        InvalidateRect(m_hWnd, NULL, FALSE);
+    }
+}
+
+LRESULT CALLBACK MinimapView::viewProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
+{
+    if (message == WM_NCCREATE)
+    {
+        CREATESTRUCTW* cs = (CREATESTRUCTW*)lParam;
+        SetWindowLongPtr(hWnd, GWLP_USERDATA, (LONG_PTR)cs->lpCreateParams);
+        ((MinimapView*)cs->lpCreateParams)->m_hWnd = hWnd;
+    }
+
+    MinimapView* instance = (MinimapView*)GetWindowLongPtr(hWnd, GWLP_USERDATA);
+    if (instance)
+    {
+        return instance->handleMessage(message, wParam, lParam);
+    }
+    return DefWindowProc(hWnd, message, wParam, lParam);
+}
+
+LRESULT MinimapView::handleMessage(UINT message, WPARAM wParam, LPARAM lParam)
+{
+    switch (message)
+    {
+    case WM_PAINT:
+    {
+        PAINTSTRUCT ps;
+        HDC hdc = BeginPaint(m_hWnd, &ps);
+        paint(hdc);
+        EndPaint(m_hWnd, &ps);
+        return 0;
+    }
+
+    case WM_ERASEBKGND:
+        // Растр закрывает все окно
+        return 1;
+
+    case WM_LBUTTONDOWN:
+        m_isDragging = TRUE;
+        SetCapture(m_hWnd);
+        scrollTarget(GET_Y_LPARAM(lParam));
+        return 0;
+
+    case WM_MOUSEMOVE:
+        if (m_isDragging)
+        {
+            scrollTarget(GET_Y_LPARAM(lParam));
+        }
+        return 0;
+
+    case WM_LBUTTONUP:
+        if (m_isDragging)
+        {
+            ReleaseCapture();
+        }
+        return 0;
+
+    case WM_CAPTURECHANGED:
+        m_isDragging = FALSE;
+        return 0;
+
+    case WM_MOUSEWHEEL:
+        // Колесо над картой прокручивает сам EDIT-контрол
+        SendMessage(m_hTarget, WM_MOUSEWHEEL, wParam, lParam);
+        refresh();
+        return 0;
+
+    case WM_TIMER:
+        if (wParam == TIMER_REFRESH)
+        {
+            refresh();
+        }
+        return 0;
+
+    case WM_NCDESTROY:
+        KillTimer(m_hWnd, TIMER_REFRESH);
+        SetWindowLongPtr(m_hWnd, GWLP_USERDATA, 0);
+        m_hWnd = NULL;
+        return 0;
+    }
+
+    return DefWindowProc(m_hWnd, message, wParam, lParam);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "framework.h"
+#include "MinimapCache.h"
+#include <vector>
+
+/**
+ * @brief Панель мини-карты рядом с EDIT-контролом
+ *
+ * Рисует уменьшенный документ из MinimapCache и рамку видимой части
+ * EDIT-контрола. Щелчок или перетаскивание по карте прокручивает
+ * EDIT-контрол. Окно само проверяет по таймеру, изменились ли текст или
+ * прокрутка, поэтому правки из любого места не требуют уведомлений.
+ * Строки считаются строками EDIT-контрола: при переносе по словам рамка
+ * показывает видимую часть приблизительно.
+ */
+class MinimapView
+{
+public:
+    /**
+     * @brief Конструктор
+     * @param hInstance Дескриптор экземпляра приложения
+     * @param cache Растр документа (принадлежит вызывающему коду)
+     */
+    MinimapView(HINSTANCE hInstance, const MinimapCache& cache);
+
+    /**
+     * @brief Деструктор
+     */
+    ~MinimapView();
+
+    /**
+     * @brief Создать окно мини-карты
+     * @param hParent Дескриптор родительского окна
+     * @return TRUE при успехе
+     */
+    BOOL create(HWND hParent);
+
+    /**
+     * @brief Задать EDIT-контрол, который показывает карта
+     * @param hTarget Дескриптор EDIT-контрола (пересоздается при смене переноса)
+     */
+    void setTarget(HWND hTarget);
+
+    /**
+     * @brief Получить дескриптор окна
+     * @return Дескриптор окна
+     */
+    HWND getHandle() const;
+
+    /**
+     * @brief Установить цвета текста и фона
+     * @param textColor Цвет текста
+     * @param backgroundColor Цвет фона
+     */
+    void setColors(COLORREF textColor, COLORREF backgroundColor);
+
+    /**
+     * @brief Получить ширину окна
+     * @return Ширина в пикселях (по ширине растра)
+     */
+    static int getWidth();
+
+private:
+    static const UINT TIMER_REFRESH = 1;            ///< ID таймера проверки изменений
+    static const UINT REFRESH_INTERVAL = 100;       ///< Интервал проверки (мс)
+
+    HINSTANCE m_hInstance;                  ///< Дескриптор экземпляра приложения
+    HWND m_hWnd;                            ///< Окно мини-карты
+    HWND m_hTarget;                         ///< Показываемый EDIT-контрол
+    const MinimapCache& m_cache;            ///< Растр документа
+    COLORREF m_textColor;                   ///< Цвет текста
+    COLORREF m_backgroundColor;             ///< Цвет фона
+    std::vector<uint8_t> m_pixels;          ///< Яркость точек последней отрисовки
+    std::vector<DWORD> m_bitmap;            ///< Точки в цветах окна (32 бита)
+    uint32_t m_paintedVersion;              ///< Версия растра последней отрисовки
+    int m_paintedFirstLine;                 ///< Первая видимая строка последней отрисовки
+    BOOL m_isDragging;                      ///< Идет перетаскивание по карте
+
+    /**
+     * @brief Нарисовать карту и рамку видимой части
+     */
+    void paint(HDC hdc);
+
+    /**
+     * @brief Получить число строк, видимых в EDIT-контроле
+     */
+    int getTargetPageLines() const;
+
+    /**
+     * @brief Прокрутить EDIT-контрол так, чтобы строка под точкой была в середине
+     * @param y Координата в клиентской области
+     */
+    void scrollTarget(int y);
+
+    /**
+     * @brief Перерисовать карту, если изменились текст или прокрутка
+     */
+    void refresh();
+
+    static LRESULT CALLBACK viewProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
+    LRESULT handleMessage(UINT message, WPARAM wParam, LPARAM lParam);
+};
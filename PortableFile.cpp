@@ -0,0 +1,93 @@
+#include "PortableFile.h"
+#include "Utf8Codec.h"
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+FILE* PortableFile::open(const std::wstring& path, const char* mode)
+{
+#ifdef _WIN32
+    std::wstring wideMode(mode, mode + strlen(mode));
+    FILE* file = nullptr;
+    if (_wfopen_s(&file, path.c_str(), wideMode.c_str()) != 0)
+    {
+        return nullptr;
+    }
+    return file;
+#else
+    return fopen(Utf8Codec::encode(path).c_str(), mode);
+#endif
+}
+
+bool PortableFile::seek(FILE* file, uint64_t offset)
+{
+#ifdef _WIN32
+    return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+bool PortableFile::sync(FILE* file)
+{
+    if (!file || fflush(file) != 0)
+    {
+        return false;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool PortableFile::replace(const std::wstring& source, const std::wstring& target)
+{
+#ifdef _WIN32
+    return MoveFileExW(source.c_str(), target.c_str(),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE;
+#else
+    return rename(Utf8Codec::encode(source).c_str(), Utf8Codec::encode(target).c_str()) == 0;
+#endif
+}
+
+bool PortableFile::remove(const std::wstring& path)
+{
+#ifdef _WIN32
+    return DeleteFileW(path.c_str()) != FALSE;
+#else
+    return unlink(Utf8Codec::encode(path).c_str()) == 0;
+#endif
+}
+
+bool PortableFile::getInfo(const std::wstring& path, Info& info)
+{
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data) ||
+        (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+    {
+        return false;
+    }
+    info.size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    info.modifiedTime = static_cast<int64_t>(
+        (static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) |
+        data.ftLastWriteTime.dwLowDateTime);
+    return true;
+#else
+    struct stat st;
+    if (stat(Utf8Codec::encode(path).c_str(), &st) != 0 || S_ISDIR(st.st_mode))
+    {
+        return false;
+    }
+    info.size = static_cast<uint64_t>(st.st_size);
+    info.modifiedTime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    return true;
+#endif
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Переносимые файловые операции
+ *
+ * Скрывает различия между WinAPI/CRT Windows и POSIX: пути всегда
+ * передаются как wide-строки, а в Linux перекодируются в UTF-8.
+ */
+class PortableFile
+{
+public:
+    /**
+     * @brief Сведения о файле, достаточные для проверки его актуальности
+     */
+    struct Info
+    {
+        uint64_t size;          ///< Размер файла в байтах
+        int64_t modifiedTime;   ///< Время последней записи (в единицах ОС)
+    };
+
+    /**
+     * @brief Открыть файл
+     * @param path Путь к файлу
+     * @param mode Режим в формате fopen ("rb", "wb", "ab" и т.д.)
+     * @return Указатель на FILE или nullptr при ошибке
+     */
+    static FILE* open(const std::wstring& path, const char* mode);
+
+    /**
+     * @brief Переместить позицию чтения (поддерживает файлы больше 4 ГБ)
+     * @param file Открытый файл
+     * @param offset Смещение от начала файла
+     * @return true при успехе
+     */
+    static bool seek(FILE* file, uint64_t offset);
+
+    /**
+     * @brief Сбросить буферы файла на диск (fflush + fsync)
+     * @param file Открытый файл
+     * @return true при успехе
+     */
+    static bool sync(FILE* file);
+
+    /**
+     * @brief Атомарно заменить файл другим файлом
+     * @param source Путь к новому файлу
+     * @param target Путь к заменяемому файлу
+     * @return true при успехе
+     */
+    static bool replace(const std::wstring& source, const std::wstring& target);
+
+    /**
+     * @brief Удалить файл
+     * @param path Путь к файлу
+     * @return true если файл удален
+     */
+    static bool remove(const std::wstring& path);
+
+    /**
+     * @brief Получить размер и время изменения файла
+     * @param path Путь к файлу
+     * @param info Структура для результата
+     * @return true если файл существует и сведения получены
+     */
+    static bool getInfo(const std::wstring& path, Info& info);
+};
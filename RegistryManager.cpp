@@ -1,82 +1,37 @@
 #include "RegistryManager.h"
-#include <iostream>
+#include "RegistrySettingsBackend.h"
 
-RegistryManager::RegistryManager() : hKey(nullptr)
+RegistryManager::RegistryManager()
+    : m_settings(std::unique_ptr<ISettingsBackend>(
+          new RegistrySettingsBackend(HKEY_CURRENT_USER, REGISTRY_KEY_PATH)))
 {
+    // Читаем все значения один раз при старте
+    m_settings.load();
 }
 
-RegistryManager::~RegistryManager()
+RegistryManager::RegistryManager(std::unique_ptr<ISettingsBackend> backend)
+    : m_settings(std::move(backend))
 {
-    CloseRegistryKey();
+    m_settings.load();
 }
 
-BOOL RegistryManager::OpenRegistryKey()
+RegistryManager::~RegistryManager()
 {
-    LONG result = RegOpenKeyExW(
-        HKEY_CURRENT_USER,
-        REGISTRY_KEY_PATH,
-        0,
-        KEY_READ | KEY_WRITE,
-        &hKey
-    );
-
-    if (result != ERROR_SUCCESS)
-    {
-        // Если ключ не существует, создаем его
-        return CreateRegistryKey();
-    }
-
-    return TRUE;
+    Flush();
 }
 
-BOOL RegistryManager::CreateRegistryKey()
+BOOL RegistryManager::Flush()
 {
-    LONG result = RegCreateKeyExW(
-        HKEY_CURRENT_USER,
-        REGISTRY_KEY_PATH,
-        0,
-        nullptr,
-        REG_OPTION_NON_VOLATILE,
-        KEY_READ | KEY_WRITE,
-        nullptr,
-        &hKey,
-        nullptr
-    );
-
-    return (result == ERROR_SUCCESS);
-}
-
-void RegistryManager::CloseRegistryKey()
-{
-    if (hKey)
-    {
-        RegCloseKey(hKey);
-        hKey = nullptr;
-    }
+    return m_settings.flush() ? TRUE : FALSE;
 }
 
 BOOL RegistryManager::SaveFontSettings(const LOGFONTW& logFont)
 {
-    if (!OpenRegistryKey())
-        return FALSE;
-
-    BOOL success = TRUE;
-
     // Сохраняем имя шрифта
-    DWORD dataSize = static_cast<DWORD>((wcslen(logFont.lfFaceName) + 1) * sizeof(WCHAR));
-    if (RegSetValueExW(hKey, FONT_NAME_KEY, 0, REG_SZ, 
-                      (const BYTE*)logFont.lfFaceName, dataSize) != ERROR_SUCCESS)
-    {
-        success = FALSE;
-    }
+    m_settings.setString(FONT_NAME_KEY, logFont.lfFaceName);
 
     // Сохраняем размер шрифта
-    DWORD fontSize = static_cast<DWORD>(logFont.lfHeight);
-    if (RegSetValueExW(hKey, FONT_SIZE_KEY, 0, REG_DWORD, 
-                      (const BYTE*)&fontSize, sizeof(DWORD)) != ERROR_SUCCESS)
-    {
-        success = FALSE;
-    }
+    m_settings.setNumber(FONT_SIZE_KEY, static_cast<DWORD>(logFont.lfHeight));
 
     // Сохраняем стиль шрифта (жирный, курсив и т.д.)
     DWORD fontStyle = 0;
@@ -89,29 +44,20 @@ BOOL RegistryManager::SaveFontSettings(const LOGFONTW& logFont)
     if (logFont.lfStrikeOut)
         fontStyle |= 0x08; // Зачеркнутый
 
-    if (RegSetValueExW(hKey, FONT_STYLE_KEY, 0, REG_DWORD, 
-                      (const BYTE*)&fontStyle, sizeof(DWORD)) != ERROR_SUCCESS)
-    {
-        success = FALSE;
-    }
+    m_settings.setNumber(FONT_STYLE_KEY, fontStyle);
 
-    return success;
+    return TRUE;
 }
 
 BOOL RegistryManager::LoadFontSettings(LOGFONTW& logFont)
 {
-    if (!OpenRegistryKey())
-        return FALSE;
-
     BOOL success = TRUE;
 
     // Загружаем имя шрифта
-    WCHAR fontName[LF_FACESIZE] = { 0 };
-    DWORD dataSize = sizeof(fontName);
-    if (RegQueryValueExW(hKey, FONT_NAME_KEY, nullptr, nullptr, 
-                        (BYTE*)fontName, &dataSize) == ERROR_SUCCESS)
+    std::wstring fontName;
+    if (m_settings.getString(FONT_NAME_KEY, fontName) && fontName.length() < LF_FACESIZE)
     {
-        wcscpy_s(logFont.lfFaceName, LF_FACESIZE, fontName);
+        wcscpy_s(logFont.lfFaceName, LF_FACESIZE, fontName.c_str());
     }
     else
     {
@@ -121,10 +67,8 @@ BOOL RegistryManager::LoadFontSettings(LOGFONTW& logFont)
     }
 
     // Загружаем размер шрифта
-    DWORD fontSize = 16; // Значение по умолчанию
-    dataSize = sizeof(DWORD);
-    if (RegQueryValueExW(hKey, FONT_SIZE_KEY, nullptr, nullptr, 
-                        (BYTE*)&fontSize, &dataSize) == ERROR_SUCCESS)
+    uint32_t fontSize = 16; // Значение по умолчанию
+    if (m_settings.getNumber(FONT_SIZE_KEY, fontSize))
     {
         logFont.lfHeight = static_cast<LONG>(fontSize);
     }
@@ -135,10 +79,8 @@ BOOL RegistryManager::LoadFontSettings(LOGFONTW& logFont)
     }
 
     // Загружаем стиль шрифта
-    DWORD fontStyle = 0;
-    dataSize = sizeof(DWORD);
-    if (RegQueryValueExW(hKey, FONT_STYLE_KEY, nullptr, nullptr, 
-                        (BYTE*)&fontStyle, &dataSize) == ERROR_SUCCESS)
+    uint32_t fontStyle = 0;
+    if (m_settings.getNumber(FONT_STYLE_KEY, fontStyle))
     {
         logFont.lfWeight = (fontStyle & 0x01) ? FW_BOLD : FW_NORMAL;
         logFont.lfItalic = (fontStyle & 0x02) ? TRUE : FALSE;
@@ -169,25 +111,16 @@ BOOL RegistryManager::LoadFontSettings(LOGFONTW& logFont)
 
 BOOL RegistryManager::SaveTextColor(COLORREF color)
 {
-    if (!OpenRegistryKey())
-        return FALSE;
-
-    return (RegSetValueExW(hKey, TEXT_COLOR_KEY, 0, REG_DWORD, 
-                          (const BYTE*)&color, sizeof(DWORD)) == ERROR_SUCCESS);
+    m_settings.setNumber(TEXT_COLOR_KEY, color);
+    return TRUE;
 }
 
 BOOL RegistryManager::LoadTextColor(COLORREF& color)
 {
-    if (!OpenRegistryKey())
-    {
-        color = RGB(0, 0, 0); // Черный по умолчанию
-        return FALSE;
-    }
-
-    DWORD dataSize = sizeof(DWORD);
-    if (RegQueryValueExW(hKey, TEXT_COLOR_KEY, nullptr, nullptr, 
-                        (BYTE*)&color, &dataSize) == ERROR_SUCCESS)
+    uint32_t value = 0;
+    if (m_settings.getNumber(TEXT_COLOR_KEY, value))
     {
+        color = value;
         return TRUE;
     }
     else
@@ -199,25 +132,16 @@ BOOL RegistryManager::LoadTextColor(COLORREF& color)
 
 BOOL RegistryManager::SaveBackgroundColor(COLORREF color)
 {
-    if (!OpenRegistryKey())
-        return FALSE;
-
-    return (RegSetValueExW(hKey, BACKGROUND_COLOR_KEY, 0, REG_DWORD, 
-                          (const BYTE*)&color, sizeof(DWORD)) == ERROR_SUCCESS);
+    m_settings.setNumber(BACKGROUND_COLOR_KEY, color);
+    return TRUE;
 }
 
 BOOL RegistryManager::LoadBackgroundColor(COLORREF& color)
 {
-    if (!OpenRegistryKey())
-    {
-        color = RGB(255, 255, 255); // Белый по умолчанию
-        return FALSE;
-    }
-
-    DWORD dataSize = sizeof(DWORD);
-    if (RegQueryValueExW(hKey, BACKGROUND_COLOR_KEY, nullptr, nullptr, 
-                        (BYTE*)&color, &dataSize) == ERROR_SUCCESS)
+    uint32_t value = 0;
+    if (m_settings.getNumber(BACKGROUND_COLOR_KEY, value))
     {
+        color = value;
         return TRUE;
     }
     else
@@ -229,68 +153,82 @@ BOOL RegistryManager::LoadBackgroundColor(COLORREF& color)
 
 BOOL RegistryManager::SaveLastFile(const std::wstring& filePath)
 {
-    if (!OpenRegistryKey())
-        return FALSE;
-
-    DWORD dataSize = static_cast<DWORD>((filePath.length() + 1) * sizeof(WCHAR));
-    return (RegSetValueExW(hKey, LAST_FILE_KEY, 0, REG_SZ, 
-                          (const BYTE*)filePath.c_str(), dataSize) == ERROR_SUCCESS);
+    m_settings.setString(LAST_FILE_KEY, filePath);
+    return TRUE;
 }
 
 BOOL RegistryManager::LoadLastFile(std::wstring& filePath)
 {
-    if (!OpenRegistryKey())
+    if (m_settings.getString(LAST_FILE_KEY, filePath))
+    {
+        return TRUE;
+    }
+    else
     {
         filePath.clear();
         return FALSE;
     }
+}
+
+BOOL RegistryManager::SaveLastFileState(BOOL hasFile)
+{
+    m_settings.setNumber(LAST_FILE_STATE_KEY, hasFile ? 1 : 0);
+    return TRUE;
+}
 
-    WCHAR buffer[MAX_PATH] = { 0 };
-    DWORD dataSize = sizeof(buffer);
-    
-    if (RegQueryValueExW(hKey, LAST_FILE_KEY, nullptr, nullptr, 
-                        (BYTE*)buffer, &dataSize) == ERROR_SUCCESS)
+BOOL RegistryManager::LoadLastFileState(BOOL& hasFile)
+{
+    uint32_t fileState = 0;
+    if (m_settings.getNumber(LAST_FILE_STATE_KEY, fileState))
     {
-        filePath = buffer;
+        hasFile = (fileState != 0);
         return TRUE;
     }
     else
     {
-        filePath.clear();
+        hasFile = FALSE; // По умолчанию считаем, что файл не открыт
         return FALSE;
     }
 }
 
-BOOL RegistryManager::SaveLastFileState(BOOL hasFile)
+BOOL RegistryManager::SaveWordWrap(BOOL enabled)
 {
-    if (!OpenRegistryKey())
-        return FALSE;
-
-    DWORD fileState = hasFile ? 1 : 0;
-    return (RegSetValueExW(hKey, LAST_FILE_STATE_KEY, 0, REG_DWORD, 
-                          (const BYTE*)&fileState, sizeof(DWORD)) == ERROR_SUCCESS);
+    m_settings.setNumber(WORD_WRAP_KEY, enabled ? 1 : 0);
+    return TRUE;
 }
 
-BOOL RegistryManager::LoadLastFileState(BOOL& hasFile)
+BOOL RegistryManager::LoadWordWrap(BOOL& enabled)
 {
-    if (!OpenRegistryKey())
+    uint32_t value = 0;
+    if (m_settings.getNumber(WORD_WRAP_KEY, value))
     {
-        hasFile = FALSE; // По умолчанию считаем, что файл не открыт
+        enabled = (value != 0);
+        return TRUE;
+    }
+    else
+    {
+        enabled = FALSE; // По умолчанию строки не переносятся
         return FALSE;
     }
+}
+
+BOOL RegistryManager::SaveMinimap(BOOL visible)
+{
+    m_settings.setNumber(MINIMAP_KEY, visible ? 1 : 0);
+    return TRUE;
+}
 
-    DWORD fileState = 0;
-    DWORD dataSize = sizeof(DWORD);
-    
-    if (RegQueryValueExW(hKey, LAST_FILE_STATE_KEY, nullptr, nullptr, 
-                        (BYTE*)&fileState, &dataSize) == ERROR_SUCCESS)
+BOOL RegistryManager::LoadMinimap(BOOL& visible)
+{
+    uint32_t value = 0;
+    if (m_settings.getNumber(MINIMAP_KEY, value))
     {
-        hasFile = (fileState != 0);
+        visible = (value != 0);
         return TRUE;
     }
     else
     {
-        hasFile = FALSE; // По умолчанию считаем, что файл не открыт
+        visible = FALSE; // По умолчанию мини-карта скрыта
         return FALSE;
     }
-}
\ No newline at end of file
+}
@@ -2,9 +2,14 @@
 
 #include <windows.h>
 #include <string>
+#include "SettingsStore.h"
 
 /**
- * @brief Класс для управления настройками приложения в реестре Windows
+ * @brief Класс для управления настройками приложения
+ *
+ * Настройки один раз загружаются в кэш SettingsStore при создании объекта.
+ * Методы Save* и Load* работают только с памятью, а запись в хранилище
+ * (по умолчанию реестр Windows) выполняется пакетно методом Flush().
  */
 class RegistryManager
 {
@@ -17,11 +22,16 @@ private:
     static constexpr LPCWSTR BACKGROUND_COLOR_KEY = L"BackgroundColor";
     static constexpr LPCWSTR LAST_FILE_KEY = L"LastFile";
     static constexpr LPCWSTR LAST_FILE_STATE_KEY = L"LastFileState";
+    static constexpr LPCWSTR WORD_WRAP_KEY = L"WordWrap";
+    static constexpr LPCWSTR MINIMAP_KEY = L"Minimap";
 
-    HKEY hKey;
+    SettingsStore m_settings;
 
 public:
+    // Настройки хранятся в реестре HKEY_CURRENT_USER
     RegistryManager();
+    // Настройки хранятся в произвольном бэкенде (например, IniSettingsBackend)
+    explicit RegistryManager(std::unique_ptr<ISettingsBackend> backend);
     ~RegistryManager();
 
     // Методы для работы с шрифтом
@@ -42,8 +52,14 @@ public:
     BOOL SaveLastFileState(BOOL hasFile);
     BOOL LoadLastFileState(BOOL& hasFile);
 
-    // Общие методы
-    BOOL OpenRegistryKey();
-    void CloseRegistryKey();
-    BOOL CreateRegistryKey();
+    // Методы для работы с переносом по словам
+    BOOL SaveWordWrap(BOOL enabled);
+    BOOL LoadWordWrap(BOOL& enabled);
+
+    // Методы для работы с мини-картой
+    BOOL SaveMinimap(BOOL visible);
+    BOOL LoadMinimap(BOOL& visible);
+
+    // Пакетная запись измененных значений в хранилище
+    BOOL Flush();
 };
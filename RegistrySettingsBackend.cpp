@@ -0,0 +1,113 @@
+#include "RegistrySettingsBackend.h"
+#include <vector>
+
+RegistrySettingsBackend::RegistrySettingsBackend(HKEY rootKey, const std::wstring& keyPath)
+    : m_rootKey(rootKey)
+    , m_keyPath(keyPath)
+{
+}
+
+bool RegistrySettingsBackend::loadAll(SettingsMap& values)
+{
+    HKEY hKey = nullptr;
+    if (RegOpenKeyExW(m_rootKey, m_keyPath.c_str(), 0, KEY_READ, &hKey) != ERROR_SUCCESS)
+    {
+        return true; // Ключа еще нет - используются значения по умолчанию
+    }
+
+    // Узнаем максимальные размеры, чтобы выделить буферы один раз
+    DWORD valueCount = 0;
+    DWORD maxNameLength = 0;
+    DWORD maxDataSize = 0;
+    if (RegQueryInfoKeyW(hKey, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+                         &valueCount, &maxNameLength, &maxDataSize, nullptr, nullptr) != ERROR_SUCCESS)
+    {
+        RegCloseKey(hKey);
+        return false;
+    }
+
+    std::vector<WCHAR> nameBuffer(maxNameLength + 1);
+    std::vector<BYTE> dataBuffer(maxDataSize + sizeof(WCHAR));
+
+    for (DWORD index = 0; index < valueCount; ++index)
+    {
+        DWORD nameLength = static_cast<DWORD>(nameBuffer.size());
+        DWORD dataSize = maxDataSize;
+        DWORD type = 0;
+        LONG result = RegEnumValueW(hKey, index, nameBuffer.data(), &nameLength, nullptr,
+                                    &type, dataBuffer.data(), &dataSize);
+        if (result == ERROR_NO_MORE_ITEMS)
+        {
+            break;
+        }
+        if (result != ERROR_SUCCESS)
+        {
+            continue;
+        }
+
+        std::wstring name(nameBuffer.data(), nameLength);
+        if (type == REG_DWORD && dataSize == sizeof(DWORD))
+        {
+            DWORD number = 0;
+            memcpy(&number, dataBuffer.data(), sizeof(DWORD));
+            values[name] = SettingValue::fromNumber(number);
+        }
+        else if (type == REG_SZ)
+        {
+            // Строка может быть записана без завершающего нуля
+            const WCHAR* text = reinterpret_cast<const WCHAR*>(dataBuffer.data());
+            size_t length = dataSize / sizeof(WCHAR);
+            while (length > 0 && text[length - 1] == L'\0')
+            {
+                --length;
+            }
+            values[name] = SettingValue::fromString(std::wstring(text, length));
+        }
+    }
+
+    RegCloseKey(hKey);
+    return true;
+}
+
+bool RegistrySettingsBackend::saveBatch(const SettingsMap& values, const std::set<std::wstring>& dirtyNames)
+{
+    HKEY hKey = nullptr;
+    if (RegCreateKeyExW(m_rootKey, m_keyPath.c_str(), 0, nullptr, REG_OPTION_NON_VOLATILE,
+                        KEY_WRITE, nullptr, &hKey, nullptr) != ERROR_SUCCESS)
+    {
+        return false;
+    }
+
+    bool success = true;
+    for (std::set<std::wstring>::const_iterator it = dirtyNames.begin(); it != dirtyNames.end(); ++it)
+    {
+        SettingsMap::const_iterator value = values.find(*it);
+        if (value == values.end())
+        {
+            continue;
+        }
+
+        LONG result;
+        if (value->second.type == SettingValue::String)
+        {
+            const std::wstring& text = value->second.text;
+            DWORD dataSize = static_cast<DWORD>((text.length() + 1) * sizeof(WCHAR));
+            result = RegSetValueExW(hKey, it->c_str(), 0, REG_SZ,
+                                    reinterpret_cast<const BYTE*>(text.c_str()), dataSize);
+        }
+        else
+        {
+            DWORD number = value->second.number;
+            result = RegSetValueExW(hKey, it->c_str(), 0, REG_DWORD,
+                                    reinterpret_cast<const BYTE*>(&number), sizeof(DWORD));
+        }
+
+        if (result != ERROR_SUCCESS)
+        {
+            success = false;
+        }
+    }
+
+    RegCloseKey(hKey);
+    return success;
+}
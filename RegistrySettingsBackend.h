@@ -0,0 +1,28 @@
+#pragma once
+
+#include <windows.h>
+#include "SettingsBackend.h"
+
+/**
+ * @brief Бэкенд настроек в реестре Windows
+ *
+ * Ключ реестра открывается один раз на загрузку и один раз на пакетную
+ * запись, а не при каждом обращении к отдельному значению.
+ */
+class RegistrySettingsBackend : public ISettingsBackend
+{
+public:
+    /**
+     * @brief Конструктор
+     * @param rootKey Корневой раздел (например, HKEY_CURRENT_USER)
+     * @param keyPath Путь к ключу настроек
+     */
+    RegistrySettingsBackend(HKEY rootKey, const std::wstring& keyPath);
+
+    bool loadAll(SettingsMap& values) override;
+    bool saveBatch(const SettingsMap& values, const std::set<std::wstring>& dirtyNames) override;
+
+private:
+    HKEY m_rootKey;             ///< Корневой раздел реестра
+    std::wstring m_keyPath;     ///< Путь к ключу настроек
+};
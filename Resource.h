@@ -25,7 +25,46 @@
 #define IDM_SETTINGS_BG_COLOR           121
 #define IDI_GRAPHICSEDITOR              122
 #define IDI_TEXTEDITOR                  123
+#define IDM_FILE_CLOSE                  124
+#define IDM_WINDOW_NEXT_TAB             125
+#define IDM_WINDOW_PREV_TAB             126
+#define IDM_EDIT_FIND                   127
 #define IDR_MAINFRAME                   128
+#define IDD_INPUT                       129
+#define IDM_EDIT_FIND_NEXT              130
+#define IDM_EDIT_GOTO                   131
+#define IDM_VIEW_FOLLOW                 132
+#define IDM_FILE_COMPARE_SAVED          133
+#define IDM_FILE_COMPARE_FILE           134
+#define IDM_FILE_SAVE_UTF8              135
+#define IDM_FILE_SAVE_UTF8_BOM          136
+#define IDM_FILE_SAVE_UTF16LE           137
+#define IDM_FILE_SAVE_UTF16BE           138
+#define IDM_FILE_SAVE_1251              139
+#define IDM_FILE_SAVE_KOI8R             140
+#define IDM_FILE_SAVE_866               141
+#define IDM_FILE_SAVE_1252              142
+#define IDM_VIEW_WORD_WRAP              143
+#define IDM_EDIT_GOTO_OFFSET            144
+#define IDM_EDIT_GOTO_PERCENT           145
+#define IDM_EDIT_ADD_CARET_ABOVE        146
+#define IDM_EDIT_ADD_CARET_BELOW        147
+#define IDM_EDIT_COLUMN_SELECT          148
+#define IDM_EDIT_MACRO_RECORD           149
+#define IDM_EDIT_MACRO_PLAY             150
+#define IDM_EDIT_MACRO_PLAY_REPEAT      151
+#define IDM_EDIT_COMPLETE_WORD          152
+#define IDM_EDIT_GOTO_BRACKET           153
+#define IDM_VIEW_TOGGLE_FOLD            154
+#define IDM_VIEW_UNFOLD_ALL             155
+#define IDM_VIEW_MINIMAP                156
+#define IDM_EDIT_LINES_SORT             157
+#define IDM_EDIT_LINES_SORT_ORDINAL     158
+#define IDM_EDIT_LINES_UNIQUE           159
+#define IDM_EDIT_LINES_REVERSE          160
+#define IDM_EDIT_LINES_TRIM             161
+#define IDC_INPUT_PROMPT                1000
+#define IDC_INPUT_TEXT                  1001
 #define IDC_STATIC                      -1
 
 // Next default values for new objects
@@ -33,9 +72,9 @@
 #ifdef APSTUDIO_INVOKED
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NO_MFC                     1
-#define _APS_NEXT_RESOURCE_VALUE        129
+#define _APS_NEXT_RESOURCE_VALUE        162
 #define _APS_NEXT_COMMAND_VALUE         32771
-#define _APS_NEXT_CONTROL_VALUE         1000
+#define _APS_NEXT_CONTROL_VALUE         1002
 #define _APS_NEXT_SYMED_VALUE           110
 #endif
 #endif
@@ -0,0 +1,237 @@
+#include "SelectionModel.h"
+#include <algorithm>
+
+SelectionModel::SelectionModel()
+    : m_primary(0)
+{
+    reset(0, 0);
+}
+
+void SelectionModel::reset(size_t anchor, size_t caret)
+{
+    Selection selection = { anchor, caret };
+    m_selections.assign(1, selection);
+    m_primary = 0;
+}
+
+void SelectionModel::add(size_t anchor, size_t caret)
+{
+    Selection selection = { anchor, caret };
+    bool isBackward = caret < anchor;
+
+    // Первое выделение, которое не заканчивается раньше нового
+    size_t first = 0;
+    size_t last = m_selections.size();
+    while (first < last)
+    {
+        size_t middle = (first + last) / 2;
+        if (m_selections[middle].end() < selection.start())
+        {
+            first = middle + 1;
+        }
+        else
+        {
+            last = middle;
+        }
+    }
+
+    // Поглощаем все выделения, которые пересекаются с новым или касаются его
+    last = first;
+    while (last < m_selections.size() && m_selections[last].start() <= selection.end())
+    {
+        size_t start = std::min(selection.start(), m_selections[last].start());
+        size_t end = std::max(selection.end(), m_selections[last].end());
+        selection.anchor = isBackward ? end : start;
+        selection.caret = isBackward ? start : end;
+        ++last;
+    }
+    if (last > first)
+    {
+        m_selections.erase(m_selections.begin() + first, m_selections.begin() + last);
+    }
+    m_selections.insert(m_selections.begin() + first, selection);
+    m_primary = first;
+}
+
+bool SelectionModel::addCaretOnLine(const ChunkedText& text, const ChunkLineIndex& lines, int lineStep)
+{
+    size_t caret = primary().caret;
+    size_t line = lines.lineOfOffset(text, caret);
+    if ((lineStep < 0 && line < (size_t)-lineStep) ||
+        (lineStep > 0 && line + lineStep >= lines.lineCount()))
+    {
+        return false;
+    }
+
+    size_t column = caret - lines.lineStart(text, line);
+    size_t target = line + lineStep;
+    size_t position = std::min(lines.lineStart(text, target) + column, lineEnd(text, lines, target));
+    add(position, position);
+    return true;
+}
+
+void SelectionModel::selectColumn(const ChunkedText& text, const ChunkLineIndex& lines, size_t anchor, size_t caret)
+{
+    size_t anchorLine = lines.lineOfOffset(text, anchor);
+    size_t caretLine = lines.lineOfOffset(text, caret);
+    size_t anchorColumn = anchor - lines.lineStart(text, anchorLine);
+    size_t caretColumn = caret - lines.lineStart(text, caretLine);
+
+    size_t firstLine = std::min(anchorLine, caretLine);
+    size_t lastLine = std::max(anchorLine, caretLine);
+    m_selections.clear();
+    m_selections.reserve(lastLine - firstLine + 1);
+    for (size_t line = firstLine; line <= lastLine; ++line)
+    {
+        size_t start = lines.lineStart(text, line);
+        size_t end = lineEnd(text, lines, line);
+        Selection selection = { std::min(start + anchorColumn, end), std::min(start + caretColumn, end) };
+        m_selections.push_back(selection);
+    }
+    m_primary = caretLine - firstLine;
+}
+
+size_t SelectionModel::count() const
+{
+    return m_selections.size();
+}
+
+const SelectionModel::Selection& SelectionModel::at(size_t index) const
+{
+    return m_selections[index];
+}
+
+const SelectionModel::Selection& SelectionModel::primary() const
+{
+    return m_selections[m_primary];
+}
+
+void SelectionModel::insert(size_t length, std::vector<Edit>& edits)
+{
+    edits.resize(m_selections.size());
+    for (size_t i = 0; i < m_selections.size(); ++i)
+    {
+        edits[i].offset = m_selections[i].start();
+        edits[i].removeCount = m_selections[i].end() - m_selections[i].start();
+    }
+    applyEdits(edits, length);
+}
+
+void SelectionModel::deleteBackward(const ChunkedText& text, std::vector<Edit>& edits)
+{
+    remove(text, false, edits);
+}
+
+void SelectionModel::deleteForward(const ChunkedText& text, std::vector<Edit>& edits)
+{
+    remove(text, true, edits);
+}
+
+size_t SelectionModel::composeSpan(const ChunkedText& text, const std::vector<Edit>& edits,
+                                   const std::wstring& inserted, std::wstring& output, size_t& spanLength)
+{
+    output.clear();
+    spanLength = 0;
+    if (edits.empty())
+    {
+        return 0;
+    }
+
+    size_t spanStart = edits.front().offset;
+    size_t spanEnd = edits.back().offset + edits.back().removeCount;
+    spanLength = spanEnd - spanStart;
+    output.reserve(spanLength + edits.size() * inserted.size());
+
+    size_t position = spanStart;
+    for (size_t i = 0; i < edits.size(); ++i)
+    {
+        text.appendRange(position, edits[i].offset - position, output);
+        output += inserted;
+        position = edits[i].offset + edits[i].removeCount;
+    }
+    return spanStart;
+}
+
+size_t SelectionModel::lineEnd(const ChunkedText& text, const ChunkLineIndex& lines, size_t line)
+{
+    if (line + 1 >= lines.lineCount())
+    {
+        return text.length();
+    }
+
+    // Следующая строка начинается после "\n"; "\r" перед ним тоже не входит в строку
+    size_t end = lines.lineStart(text, line + 1) - 1;
+    if (end > 0 && text.charAt(end - 1) == L'\r')
+    {
+        --end;
+    }
+    return end;
+}
+
+void SelectionModel::remove(const ChunkedText& text, bool forward, std::vector<Edit>& edits)
+{
+    edits.resize(m_selections.size());
+    size_t previousEnd = 0;
+    for (size_t i = 0; i < m_selections.size(); ++i)
+    {
+        size_t start = m_selections[i].start();
+        size_t end = m_selections[i].end();
+        if (start == end)
+        {
+            // Пустое выделение удаляет соседний символ, перевод строки - целиком
+            if (forward && end < text.length())
+            {
+                end += (text.charAt(end) == L'\r' && end + 1 < text.length() && text.charAt(end + 1) == L'\n') ? 2 : 1;
+            }
+            else if (!forward && start > 0)
+            {
+                start -= (text.charAt(start - 1) == L'\n' && start > 1 && text.charAt(start - 2) == L'\r') ? 2 : 1;
+            }
+        }
+
+        // Соседние курсоры не удаляют один символ дважды
+        start = std::max(start, previousEnd);
+        end = std::max(end, start);
+        edits[i].offset = start;
+        edits[i].removeCount = end - start;
+        previousEnd = end;
+    }
+    applyEdits(edits, 0);
+
+    // Курсоры в начале или в конце текста удалять нечего
+    edits.erase(std::remove_if(edits.begin(), edits.end(),
+                               [](const Edit& edit) { return edit.removeCount == 0; }),
+                edits.end());
+}
+
+void SelectionModel::applyEdits(const std::vector<Edit>& edits, size_t length)
+{
+    // Каждая замена сдвигает последующие выделения на разницу длин
+    size_t primary = m_primary;
+    size_t count = 0;
+    long long delta = 0;
+    for (size_t i = 0; i < edits.size(); ++i)
+    {
+        size_t caret = (size_t)((long long)edits[i].offset + delta) + length;
+        delta += (long long)length - (long long)edits[i].removeCount;
+
+        // Курсоры, оказавшиеся в одной позиции, объединяются
+        if (count > 0 && m_selections[count - 1].caret == caret)
+        {
+            if (i == m_primary)
+            {
+                primary = count - 1;
+            }
+            continue;
+        }
+        if (i == m_primary)
+        {
+            primary = count;
+        }
+        m_selections[count].anchor = caret;
+        m_selections[count].caret = caret;
+        ++count;
+    }
+    m_selections.resize(count);
+    m_primary = primary;
+}
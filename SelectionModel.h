@@ -0,0 +1,163 @@
+#pragma once
+
+#include "ChunkedText.h"
+#include "ChunkLineIndex.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Набор курсоров и выделений для одновременной правки
+ *
+ * Выделения хранятся в одном массиве, упорядоченном по началу и без
+ * пересечений, поэтому ввод символа во все курсоры - один проход по
+ * массиву. Правка описывается списком замен в координатах текста до нее
+ * (по возрастанию позиции); вызывающий код применяет их к тексту от
+ * последней к первой, и каждая стоит O(log n) в ChunkedText и индексах.
+ * Одно из выделений основное: его показывает EDIT-контрол.
+ * Класс не зависит от WinAPI.
+ */
+class SelectionModel
+{
+public:
+    /**
+     * @brief Выделение: якорь и курсор (совпадают, если выделения нет)
+     */
+    struct Selection
+    {
+        size_t anchor;  ///< Неподвижный конец выделения
+        size_t caret;   ///< Конец выделения с курсором
+
+        size_t start() const { return anchor < caret ? anchor : caret; }
+        size_t end() const { return anchor < caret ? caret : anchor; }
+    };
+
+    /**
+     * @brief Замена фрагмента текста в координатах до правки
+     */
+    struct Edit
+    {
+        size_t offset;          ///< Начало заменяемого фрагмента
+        size_t removeCount;     ///< Длина заменяемого фрагмента
+    };
+
+    SelectionModel();
+
+    /**
+     * @brief Оставить одно выделение
+     * @param anchor Якорь
+     * @param caret Курсор
+     */
+    void reset(size_t anchor, size_t caret);
+
+    /**
+     * @brief Добавить выделение и сделать его основным
+     *
+     * Пересекающиеся и соприкасающиеся выделения объединяются.
+     * @param anchor Якорь
+     * @param caret Курсор
+     */
+    void add(size_t anchor, size_t caret);
+
+    /**
+     * @brief Добавить курсор на соседней строке в том же столбце
+     * @param text Текст документа
+     * @param lines Индекс строк этого текста
+     * @param lineStep Смещение строки от основного курсора (-1 - выше, 1 - ниже)
+     * @return false если строки нет
+     */
+    bool addCaretOnLine(const ChunkedText& text, const ChunkLineIndex& lines, int lineStep);
+
+    /**
+     * @brief Заменить выделения столбцовым (прямоугольным) выделением
+     *
+     * На каждой строке между якорем и курсором выделяются столбцы между
+     * их столбцами (в символах, по длине строки). Основным становится
+     * выделение на строке курсора.
+     * @param text Текст документа
+     * @param lines Индекс строк этого текста
+     * @param anchor Угол прямоугольника
+     * @param caret Противоположный угол с курсором
+     */
+    void selectColumn(const ChunkedText& text, const ChunkLineIndex& lines, size_t anchor, size_t caret);
+
+    /**
+     * @brief Получить количество выделений
+     * @return Количество (не меньше одного)
+     */
+    size_t count() const;
+
+    /**
+     * @brief Получить выделение по номеру
+     * @param index Номер в порядке возрастания позиции
+     * @return Выделение
+     */
+    const Selection& at(size_t index) const;
+
+    /**
+     * @brief Получить основное выделение
+     * @return Выделение
+     */
+    const Selection& primary() const;
+
+    /**
+     * @brief Заменить каждое выделение текстом (ввод во все курсоры)
+     * @param length Длина вставляемого текста
+     * @param edits Замены в координатах до правки
+     */
+    void insert(size_t length, std::vector<Edit>& edits);
+
+    /**
+     * @brief Удалить выделения или символ перед каждым курсором
+     * @param text Текст документа ("\r\n" удаляется целиком)
+     * @param edits Замены в координатах до правки (пустой, если удалять нечего)
+     */
+    void deleteBackward(const ChunkedText& text, std::vector<Edit>& edits);
+
+    /**
+     * @brief Удалить выделения или символ после каждого курсора
+     * @param text Текст документа ("\r\n" удаляется целиком)
+     * @param edits Замены в координатах до правки
+     */
+    void deleteForward(const ChunkedText& text, std::vector<Edit>& edits);
+
+    /**
+     * @brief Собрать новый текст участка, покрывающего все замены
+     *
+     * Нужен тексту, хранящемуся одним массивом (EDIT-контрол): весь
+     * пакет замен применяется одной заменой участка, и отмена
+     * возвращает его целиком.
+     * @param text Текст до правки
+     * @param edits Замены
+     * @param inserted Текст, вставляемый каждой заменой
+     * @param output Новый текст участка
+     * @param spanLength Длина участка в тексте до правки
+     * @return Начало участка
+     */
+    static size_t composeSpan(const ChunkedText& text, const std::vector<Edit>& edits,
+                              const std::wstring& inserted, std::wstring& output, size_t& spanLength);
+
+private:
+    std::vector<Selection> m_selections;    ///< Выделения по возрастанию начала
+    size_t m_primary;                       ///< Номер основного выделения
+
+    /**
+     * @brief Получить конец строки без перевода строки
+     */
+    static size_t lineEnd(const ChunkedText& text, const ChunkLineIndex& lines, size_t line);
+
+    /**
+     * @brief Применить удаление: пустые выделения расширяются на символ
+     * @param text Текст документа
+     * @param forward Удалять символ после курсора
+     * @param edits Замены
+     */
+    void remove(const ChunkedText& text, bool forward, std::vector<Edit>& edits);
+
+    /**
+     * @brief Перенести выделения в текст после замен и объединить совпавшие
+     * @param edits Замены (по одной на выделение)
+     * @param length Длина текста, вставленного каждой заменой
+     */
+    void applyEdits(const std::vector<Edit>& edits, size_t length);
+};
@@ -0,0 +1,44 @@
+#include "SelectionSnapshot.h"
+#include <algorithm>
+#include <cwchar>
+
+SelectionSnapshot::SelectionSnapshot(const ChunkedText& text, size_t offset, size_t count)
+    : m_firstOffset(0)
+    , m_length(0)
+{
+    if (offset >= text.length() || count == 0)
+    {
+        return;
+    }
+    m_length = std::min(count, text.length() - offset);
+
+    size_t index = text.findChunk(offset, m_firstOffset);
+    size_t covered = 0;
+    while (covered < m_firstOffset + m_length && index < text.chunkCount())
+    {
+        m_chunks.push_back(text.chunk(index));
+        covered += m_chunks.back()->size();
+        ++index;
+    }
+}
+
+size_t SelectionSnapshot::length() const
+{
+    return m_length;
+}
+
+void SelectionSnapshot::copyTo(wchar_t* output) const
+{
+    size_t remaining = m_length;
+    size_t inner = m_firstOffset;
+    for (size_t i = 0; i < m_chunks.size() && remaining > 0; ++i)
+    {
+        const std::wstring& chunk = *m_chunks[i];
+        size_t take = std::min(remaining, chunk.size() - inner);
+        wmemcpy(output, chunk.data() + inner, take);
+        output += take;
+        remaining -= take;
+        inner = 0;
+    }
+    *output = L'\0';
+}
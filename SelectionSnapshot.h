@@ -0,0 +1,43 @@
+#pragma once
+
+#include "ChunkedText.h"
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Неизменяемый снимок выделенного фрагмента для буфера обмена
+ *
+ * Снимок хранит только указатели на блоки ChunkedText, покрывающие
+ * фрагмент, поэтому создается за время, пропорциональное числу блоков,
+ * без копирования текста. Последующие правки документа пересоздают свои
+ * блоки и снимок не меняют. Текст собирается только по запросу, когда
+ * другая программа обращается к буферу обмена. Не зависит от WinAPI.
+ */
+class SelectionSnapshot
+{
+public:
+    /**
+     * @brief Конструктор
+     * @param text Текст документа
+     * @param offset Начало фрагмента
+     * @param count Длина фрагмента (обрезается по концу текста)
+     */
+    SelectionSnapshot(const ChunkedText& text, size_t offset, size_t count);
+
+    /**
+     * @brief Получить длину фрагмента
+     * @return Количество символов
+     */
+    size_t length() const;
+
+    /**
+     * @brief Записать фрагмент в буфер с завершающим нулем (формат CF_UNICODETEXT)
+     * @param output Буфер не меньше length() + 1 символов
+     */
+    void copyTo(wchar_t* output) const;
+
+private:
+    std::vector<ChunkedText::ChunkPtr> m_chunks;    ///< Блоки, покрывающие фрагмент
+    size_t m_firstOffset;                           ///< Начало фрагмента в первом блоке
+    size_t m_length;                                ///< Длина фрагмента
+};
@@ -0,0 +1,267 @@
+#include "SessionSnapshot.h"
+#include "ChunkedText.h"
+#include "ContentHash.h"
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    const char SNAPSHOT_MAGIC[4] = { 'T', 'E', 'S', '1' };
+    const size_t HEADER_SIZE = 88;
+
+    /**
+     * @brief Заголовок файла снимка (все поля little-endian, без выравнивания)
+     */
+    struct SnapshotHeader
+    {
+        uint32_t unitSize;
+        uint32_t codePage;
+        uint32_t formatFlags;
+        uint64_t fileSize;
+        int64_t fileModifiedTime;
+        uint64_t contentHash;
+        uint64_t selectionStart;
+        uint64_t selectionEnd;
+        uint64_t firstVisibleLine;
+        uint64_t pathLength;
+        uint64_t lineCount;
+        uint64_t textLength;
+    };
+
+    size_t alignUp(size_t value)
+    {
+        return (value + 7) & ~static_cast<size_t>(7);
+    }
+
+    template <typename T>
+    void putValue(std::vector<unsigned char>& buffer, size_t& position, T value)
+    {
+        memcpy(&buffer[position], &value, sizeof(value));
+        position += sizeof(value);
+    }
+
+    template <typename T>
+    T getValue(const unsigned char*& position)
+    {
+        T value;
+        memcpy(&value, position, sizeof(value));
+        position += sizeof(value);
+        return value;
+    }
+
+    bool writeAll(FILE* file, const void* data, size_t size)
+    {
+        return size == 0 || fwrite(data, 1, size, file) == size;
+    }
+}
+
+SessionSnapshot::SessionSnapshot()
+    : m_text(nullptr)
+    , m_textLength(0)
+    , m_lineIndex(nullptr)
+    , m_lineCount(0)
+{
+}
+
+bool SessionSnapshot::write(const std::wstring& snapshotPath, const SessionState& state, const ChunkedText& text)
+{
+    // Индекс начала строк: строка начинается после '\n'
+    std::vector<uint64_t> lineOffsets;
+    lineOffsets.push_back(0);
+    for (size_t i = 0; i < text.chunkCount(); ++i)
+    {
+        const std::wstring& chunk = text.chunkText(i);
+        size_t base = text.chunkOffset(i);
+        for (size_t j = 0; j < chunk.size(); ++j)
+        {
+            if (chunk[j] == L'\n')
+            {
+                lineOffsets.push_back(base + j + 1);
+            }
+        }
+    }
+
+    // Заголовок и путь, дополненные до кратного 8 размера
+    size_t pathBytes = state.documentPath.size() * sizeof(wchar_t);
+    std::vector<unsigned char> head(alignUp(HEADER_SIZE + pathBytes), 0);
+    size_t position = 0;
+    memcpy(&head[0], SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    position += sizeof(SNAPSHOT_MAGIC);
+    putValue<uint32_t>(head, position, static_cast<uint32_t>(sizeof(wchar_t)));
+    putValue<uint32_t>(head, position, state.format.codePage);
+    putValue<uint32_t>(head, position, state.format.packFlags());
+    putValue<uint64_t>(head, position, state.fileSize);
+    putValue<int64_t>(head, position, state.fileModifiedTime);
+    putValue<uint64_t>(head, position, state.contentHash);
+    putValue<uint64_t>(head, position, state.selectionStart);
+    putValue<uint64_t>(head, position, state.selectionEnd);
+    putValue<uint64_t>(head, position, state.firstVisibleLine);
+    putValue<uint64_t>(head, position, static_cast<uint64_t>(state.documentPath.size()));
+    putValue<uint64_t>(head, position, static_cast<uint64_t>(lineOffsets.size()));
+    putValue<uint64_t>(head, position, static_cast<uint64_t>(text.length()));
+    if (pathBytes > 0)
+    {
+        memcpy(&head[HEADER_SIZE], state.documentPath.data(), pathBytes);
+    }
+
+    std::wstring tempPath = snapshotPath + L".tmp";
+    FILE* file = PortableFile::open(tempPath, "wb");
+    if (!file)
+    {
+        return false;
+    }
+
+    bool success = writeAll(file, &head[0], head.size()) &&
+                   writeAll(file, &lineOffsets[0], lineOffsets.size() * sizeof(uint64_t));
+    for (size_t i = 0; success && i < text.chunkCount(); ++i)
+    {
+        const std::wstring& chunk = text.chunkText(i);
+        success = writeAll(file, chunk.data(), chunk.size() * sizeof(wchar_t));
+    }
+
+    // Завершающий ноль позволяет передавать текст из отображения напрямую
+    const wchar_t terminator = L'\0';
+    success = success && writeAll(file, &terminator, sizeof(terminator)) && PortableFile::sync(file);
+    success = (fclose(file) == 0) && success;
+
+    if (!success || !PortableFile::replace(tempPath, snapshotPath))
+    {
+        PortableFile::remove(tempPath);
+        return false;
+    }
+    return true;
+}
+
+bool SessionSnapshot::verifyContent(const std::wstring& path, uint64_t expectedHash)
+{
+    MappedFile file;
+    if (!file.open(path))
+    {
+        return false;
+    }
+    return ContentHash::compute(file.data(), static_cast<size_t>(file.size())) == expectedHash;
+}
+
+bool SessionSnapshot::open(const std::wstring& snapshotPath)
+{
+    close();
+    if (!m_file.open(snapshotPath) || m_file.size() < HEADER_SIZE)
+    {
+        close();
+        return false;
+    }
+
+    const unsigned char* base = m_file.data();
+    const unsigned char* position = base;
+    if (memcmp(position, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)
+    {
+        close();
+        return false;
+    }
+    position += sizeof(SNAPSHOT_MAGIC);
+
+    SnapshotHeader header;
+    header.unitSize = getValue<uint32_t>(position);
+    header.codePage = getValue<uint32_t>(position);
+    header.formatFlags = getValue<uint32_t>(position);
+    header.fileSize = getValue<uint64_t>(position);
+    header.fileModifiedTime = getValue<int64_t>(position);
+    header.contentHash = getValue<uint64_t>(position);
+    header.selectionStart = getValue<uint64_t>(position);
+    header.selectionEnd = getValue<uint64_t>(position);
+    header.firstVisibleLine = getValue<uint64_t>(position);
+    header.pathLength = getValue<uint64_t>(position);
+    header.lineCount = getValue<uint64_t>(position);
+    header.textLength = getValue<uint64_t>(position);
+
+    // Проверка размеров, чтобы поврежденный снимок не вывел за границы отображения
+    uint64_t available = m_file.size();
+    if (header.unitSize != sizeof(wchar_t) || header.lineCount == 0 ||
+        header.pathLength > available || header.lineCount > available || header.textLength > available)
+    {
+        close();
+        return false;
+    }
+
+    uint64_t indexOffset = alignUp(HEADER_SIZE + static_cast<size_t>(header.pathLength) * sizeof(wchar_t));
+    uint64_t textOffset = indexOffset + header.lineCount * sizeof(uint64_t);
+    uint64_t expectedSize = textOffset + (header.textLength + 1) * sizeof(wchar_t);
+    if (expectedSize != available)
+    {
+        close();
+        return false;
+    }
+
+    const wchar_t* text = reinterpret_cast<const wchar_t*>(base + textOffset);
+    if (text[header.textLength] != L'\0')
+    {
+        close();
+        return false;
+    }
+
+    m_state.documentPath.assign(reinterpret_cast<const wchar_t*>(base + HEADER_SIZE),
+                                static_cast<size_t>(header.pathLength));
+    m_state.fileSize = header.fileSize;
+    m_state.fileModifiedTime = header.fileModifiedTime;
+    m_state.contentHash = header.contentHash;
+    m_state.format.codePage = header.codePage;
+    m_state.format.unpackFlags(header.formatFlags);
+    m_state.selectionStart = header.selectionStart;
+    m_state.selectionEnd = header.selectionEnd;
+    m_state.firstVisibleLine = header.firstVisibleLine;
+
+    m_text = text;
+    m_textLength = static_cast<size_t>(header.textLength);
+    m_lineIndex = base + indexOffset;
+    m_lineCount = static_cast<size_t>(header.lineCount);
+    return true;
+}
+
+void SessionSnapshot::close()
+{
+    m_file.close();
+    m_state = SessionState();
+    m_text = nullptr;
+    m_textLength = 0;
+    m_lineIndex = nullptr;
+    m_lineCount = 0;
+}
+
+bool SessionSnapshot::matches(const std::wstring& documentPath, const PortableFile::Info& info) const
+{
+    return m_text != nullptr &&
+           m_state.documentPath == documentPath &&
+           m_state.fileSize == info.size &&
+           m_state.fileModifiedTime == info.modifiedTime;
+}
+
+const SessionState& SessionSnapshot::state() const
+{
+    return m_state;
+}
+
+const wchar_t* SessionSnapshot::text() const
+{
+    return m_text;
+}
+
+size_t SessionSnapshot::textLength() const
+{
+    return m_textLength;
+}
+
+size_t SessionSnapshot::lineCount() const
+{
+    return m_lineCount;
+}
+
+uint64_t SessionSnapshot::lineOffset(size_t line) const
+{
+    if (line >= m_lineCount)
+    {
+        return m_textLength;
+    }
+    uint64_t offset;
+    memcpy(&offset, m_lineIndex + line * sizeof(uint64_t), sizeof(offset));
+    return offset;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "DocumentFormat.h"
+#include "MappedFile.h"
+#include "PortableFile.h"
+
+class ChunkedText;
+
+/**
+ * @brief Состояние сеанса, сохраняемое вместе с текстом документа
+ */
+struct SessionState
+{
+    std::wstring documentPath;      ///< Путь к документу
+    uint64_t fileSize;              ///< Размер файла на диске
+    int64_t fileModifiedTime;       ///< Время изменения файла на диске
+    uint64_t contentHash;           ///< Хеш байтов файла (ContentHash)
+    DocumentFormat format;          ///< Определенный формат файла
+    uint64_t selectionStart;        ///< Начало выделения
+    uint64_t selectionEnd;          ///< Конец выделения
+    uint64_t firstVisibleLine;      ///< Первая видимая строка
+
+    SessionState()
+        : fileSize(0), fileModifiedTime(0), contentHash(0)
+        , selectionStart(0), selectionEnd(0), firstVisibleLine(0)
+    {
+    }
+};
+
+/**
+ * @brief Снимок последнего документа для быстрого восстановления сеанса
+ *
+ * Хранит уже декодированный текст, индекс начала строк и позицию
+ * прокрутки. При запуске снимок отображается в память и текст берется
+ * прямо из отображения без чтения и перекодирования исходного файла.
+ * Актуальность проверяется по размеру и времени изменения файла,
+ * а полная проверка содержимого (verifyContent) выполняется в фоне.
+ */
+class SessionSnapshot
+{
+public:
+    SessionSnapshot();
+
+    /**
+     * @brief Записать снимок (через временный файл с атомарной заменой)
+     * @param snapshotPath Путь к файлу снимка
+     * @param state Состояние сеанса
+     * @param text Текст документа
+     * @return true при успехе
+     */
+    static bool write(const std::wstring& snapshotPath, const SessionState& state, const ChunkedText& text);
+
+    /**
+     * @brief Проверить, что содержимое файла совпадает с хешем
+     * @param path Путь к файлу
+     * @param expectedHash Ожидаемый хеш
+     * @return true если файл прочитан и хеш совпал
+     */
+    static bool verifyContent(const std::wstring& path, uint64_t expectedHash);
+
+    /**
+     * @brief Открыть снимок и проверить его структуру
+     * @param snapshotPath Путь к файлу снимка
+     * @return true если снимок корректен
+     */
+    bool open(const std::wstring& snapshotPath);
+
+    /**
+     * @brief Закрыть снимок
+     */
+    void close();
+
+    /**
+     * @brief Проверить, относится ли снимок к текущей версии файла
+     * @param documentPath Путь к документу
+     * @param info Размер и время изменения файла
+     * @return true если путь, размер и время совпадают
+     */
+    bool matches(const std::wstring& documentPath, const PortableFile::Info& info) const;
+
+    /**
+     * @brief Получить сохраненное состояние
+     * @return Состояние сеанса
+     */
+    const SessionState& state() const;
+
+    /**
+     * @brief Получить текст документа (завершается нулем, указывает в отображение)
+     * @return Указатель на текст
+     */
+    const wchar_t* text() const;
+
+    /**
+     * @brief Получить длину текста
+     * @return Длина в символах
+     */
+    size_t textLength() const;
+
+    /**
+     * @brief Получить количество строк
+     * @return Количество строк
+     */
+    size_t lineCount() const;
+
+    /**
+     * @brief Получить смещение начала строки
+     * @param line Номер строки (с нуля)
+     * @return Смещение в символах
+     */
+    uint64_t lineOffset(size_t line) const;
+
+private:
+    MappedFile m_file;                  ///< Отображение файла снимка
+    SessionState m_state;               ///< Состояние сеанса
+    const wchar_t* m_text;              ///< Текст в отображении
+    size_t m_textLength;                ///< Длина текста
+    const unsigned char* m_lineIndex;   ///< Индекс строк в отображении
+    size_t m_lineCount;                 ///< Количество строк
+};
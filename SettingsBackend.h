@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+
+/**
+ * @brief Значение настройки: строка или 32-битное число
+ *
+ * Соответствует типам REG_SZ и REG_DWORD, которые использует приложение.
+ */
+struct SettingValue
+{
+    enum Type
+    {
+        String,     ///< Строковое значение
+        Number      ///< Числовое значение (DWORD)
+    };
+
+    Type type;              ///< Тип значения
+    std::wstring text;      ///< Строковое значение (для String)
+    uint32_t number;        ///< Числовое значение (для Number)
+
+    SettingValue() : type(Number), number(0) {}
+
+    static SettingValue fromString(const std::wstring& value)
+    {
+        SettingValue result;
+        result.type = String;
+        result.text = value;
+        return result;
+    }
+
+    static SettingValue fromNumber(uint32_t value)
+    {
+        SettingValue result;
+        result.type = Number;
+        result.number = value;
+        return result;
+    }
+
+    bool operator==(const SettingValue& other) const
+    {
+        return type == other.type &&
+               (type == String ? text == other.text : number == other.number);
+    }
+
+    bool operator!=(const SettingValue& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+typedef std::map<std::wstring, SettingValue> SettingsMap;
+
+/**
+ * @brief Интерфейс хранилища настроек
+ *
+ * Бэкенд читает все значения одним проходом при старте и записывает
+ * накопленные изменения одной пакетной операцией.
+ */
+class ISettingsBackend
+{
+public:
+    virtual ~ISettingsBackend() {}
+
+    /**
+     * @brief Загрузить все значения
+     * @param values Словарь для результата
+     * @return true если хранилище прочитано (отсутствие хранилища не ошибка)
+     */
+    virtual bool loadAll(SettingsMap& values) = 0;
+
+    /**
+     * @brief Записать изменения пакетом
+     * @param values Полный набор значений
+     * @param dirtyNames Имена измененных значений
+     * @return true если все значения записаны
+     */
+    virtual bool saveBatch(const SettingsMap& values, const std::set<std::wstring>& dirtyNames) = 0;
+};
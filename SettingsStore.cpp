@@ -0,0 +1,112 @@
+#include "SettingsStore.h"
+
+SettingsStore::SettingsStore(std::unique_ptr<ISettingsBackend> backend)
+    : m_backend(std::move(backend))
+    , m_isLoaded(false)
+{
+}
+
+SettingsStore::~SettingsStore()
+{
+    flush();
+}
+
+bool SettingsStore::load()
+{
+    if (m_isLoaded)
+    {
+        return true;
+    }
+
+    m_isLoaded = true;
+    if (!m_backend)
+    {
+        return false;
+    }
+
+    SettingsMap loaded;
+    if (!m_backend->loadAll(loaded))
+    {
+        return false;
+    }
+
+    // Значения, измененные до загрузки, имеют приоритет над сохраненными
+    for (SettingsMap::const_iterator it = loaded.begin(); it != loaded.end(); ++it)
+    {
+        if (m_dirtyNames.find(it->first) == m_dirtyNames.end())
+        {
+            m_values[it->first] = it->second;
+        }
+    }
+    return true;
+}
+
+bool SettingsStore::getString(const std::wstring& name, std::wstring& value) const
+{
+    SettingsMap::const_iterator it = m_values.find(name);
+    if (it == m_values.end() || it->second.type != SettingValue::String)
+    {
+        return false;
+    }
+    value = it->second.text;
+    return true;
+}
+
+bool SettingsStore::getNumber(const std::wstring& name, uint32_t& value) const
+{
+    SettingsMap::const_iterator it = m_values.find(name);
+    if (it == m_values.end() || it->second.type != SettingValue::Number)
+    {
+        return false;
+    }
+    value = it->second.number;
+    return true;
+}
+
+void SettingsStore::setString(const std::wstring& name, const std::wstring& value)
+{
+    setValue(name, SettingValue::fromString(value));
+}
+
+void SettingsStore::setNumber(const std::wstring& name, uint32_t value)
+{
+    setValue(name, SettingValue::fromNumber(value));
+}
+
+bool SettingsStore::isDirty() const
+{
+    return !m_dirtyNames.empty();
+}
+
+bool SettingsStore::flush()
+{
+    if (m_dirtyNames.empty())
+    {
+        return true;
+    }
+    if (!m_backend)
+    {
+        return false;
+    }
+
+    if (!m_backend->saveBatch(m_values, m_dirtyNames))
+    {
+        // Оставляем значения помеченными, чтобы повторить запись позже
+        return false;
+    }
+
+    m_dirtyNames.clear();
+    return true;
+}
+
+void SettingsStore::setValue(const std::wstring& name, const SettingValue& value)
+{
+    SettingsMap::iterator it = m_values.find(name);
+    if (it != m_values.end() && it->second == value)
+    {
+        return; // Значение не изменилось, запись не нужна
+    }
+
+    m_values[name] = value;
+    m_dirtyNames.insert(name);
+}
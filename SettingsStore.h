@@ -0,0 +1,86 @@
+#pragma once
+
+#include "SettingsBackend.h"
+#include <memory>
+
+/**
+ * @brief Кэш настроек приложения в памяти
+ *
+ * Значения загружаются из бэкенда один раз, чтение и запись идут в память,
+ * измененные значения помечаются и записываются в бэкенд одним вызовом flush().
+ */
+class SettingsStore
+{
+public:
+    /**
+     * @brief Конструктор
+     * @param backend Бэкенд хранения настроек
+     */
+    explicit SettingsStore(std::unique_ptr<ISettingsBackend> backend);
+
+    /**
+     * @brief Деструктор (сбрасывает несохраненные изменения в бэкенд)
+     */
+    ~SettingsStore();
+
+    /**
+     * @brief Загрузить настройки из бэкенда (выполняется один раз)
+     * @return true если загрузка прошла успешно
+     */
+    bool load();
+
+    /**
+     * @brief Получить строковое значение
+     * @param name Имя значения
+     * @param value Результат
+     * @return true если значение найдено и имеет строковый тип
+     */
+    bool getString(const std::wstring& name, std::wstring& value) const;
+
+    /**
+     * @brief Получить числовое значение
+     * @param name Имя значения
+     * @param value Результат
+     * @return true если значение найдено и имеет числовой тип
+     */
+    bool getNumber(const std::wstring& name, uint32_t& value) const;
+
+    /**
+     * @brief Установить строковое значение
+     * @param name Имя значения
+     * @param value Новое значение
+     */
+    void setString(const std::wstring& name, const std::wstring& value);
+
+    /**
+     * @brief Установить числовое значение
+     * @param name Имя значения
+     * @param value Новое значение
+     */
+    void setNumber(const std::wstring& name, uint32_t value);
+
+    /**
+     * @brief Проверить, есть ли несохраненные изменения
+     * @return true если есть измененные значения
+     */
+    bool isDirty() const;
+
+    /**
+     * @brief Записать все измененные значения одним пакетом
+     * @return true если изменений нет или они успешно записаны
+     */
+    bool flush();
+
+private:
+    std::unique_ptr<ISettingsBackend> m_backend;    ///< Бэкенд хранения
+    SettingsMap m_values;                           ///< Значения в памяти
+    std::set<std::wstring> m_dirtyNames;            ///< Имена измененных значений
+    bool m_isLoaded;                                ///< Флаг выполненной загрузки
+
+    /**
+     * @brief Записать значение и пометить его измененным
+     * @param name Имя значения
+     * @param value Новое значение
+     */
+    void setValue(const std::wstring& name, const SettingValue& value);
+};
@@ -0,0 +1,261 @@
+#include "SparseLineIndex.h"
+#include "PortableFile.h"
+#include <cstring>
+
+namespace
+{
+    const size_t SCAN_BUFFER_SIZE = 4 * 1024 * 1024;
+}
+
+SparseLineIndex::SparseLineIndex()
+    : m_isStopping(false)
+    , m_isComplete(false)
+    , m_lineCount(0)
+    , m_scannedBytes(0)
+    , m_stride(DEFAULT_STRIDE)
+{
+}
+
+SparseLineIndex::~SparseLineIndex()
+{
+    stop();
+}
+
+void SparseLineIndex::start(const std::wstring& path, uint64_t dataStart, unsigned unitSize, bool bigEndian)
+{
+    stop();
+
+    m_isStopping = false;
+    m_isComplete = false;
+    m_lineCount = 1;
+    m_scannedBytes = dataStart;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stride = DEFAULT_STRIDE;
+        m_checkpoints.assign(1, dataStart);
+        m_longLines.clear();
+    }
+    m_thread = std::thread(&SparseLineIndex::scan, this, path, dataStart, unitSize, bigEndian);
+}
+
+void SparseLineIndex::stop()
+{
+    m_isStopping = true;
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_checkpoints.clear();
+    m_longLines.clear();
+    m_lineCount = 0;
+    m_scannedBytes = 0;
+    m_isComplete = false;
+}
+
+bool SparseLineIndex::isComplete() const
+{
+    return m_isComplete;
+}
+
+uint64_t SparseLineIndex::lineCount() const
+{
+    return m_lineCount;
+}
+
+uint64_t SparseLineIndex::scannedBytes() const
+{
+    return m_scannedBytes;
+}
+
+bool SparseLineIndex::checkpointForLine(uint64_t line, uint64_t& checkpointLine, uint64_t& checkpointOffset) const
+{
+    if (line >= m_lineCount.load())
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_checkpoints.empty())
+    {
+        return false;
+    }
+
+    uint64_t index = line / m_stride;
+    if (index >= m_checkpoints.size())
+    {
+        index = m_checkpoints.size() - 1;
+    }
+    checkpointLine = index * m_stride;
+    checkpointOffset = m_checkpoints[static_cast<size_t>(index)];
+    return true;
+}
+
+bool SparseLineIndex::checkpointForOffset(uint64_t offset, uint64_t& checkpointLine, uint64_t& checkpointOffset) const
+{
+    if (!m_isComplete && offset >= m_scannedBytes.load())
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_checkpoints.empty() || offset < m_checkpoints[0])
+    {
+        return false;
+    }
+
+    // Последняя контрольная точка, не превышающая смещение
+    size_t low = 0;
+    size_t high = m_checkpoints.size();
+    while (high - low > 1)
+    {
+        size_t middle = (low + high) / 2;
+        if (m_checkpoints[middle] <= offset)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    checkpointLine = static_cast<uint64_t>(low) * m_stride;
+    checkpointOffset = m_checkpoints[low];
+    return true;
+}
+
+bool SparseLineIndex::longLineEnd(uint64_t lineStart, uint64_t& lineEnd) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t low = 0;
+    size_t high = m_longLines.size();
+    while (low < high)
+    {
+        size_t middle = (low + high) / 2;
+        if (m_longLines[middle].start < lineStart)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    if (low == m_longLines.size() || m_longLines[low].start != lineStart)
+    {
+        return false;
+    }
+    lineEnd = m_longLines[low].end;
+    return true;
+}
+
+const char* SparseLineIndex::findLineFeed(const char* begin, const char* end, uint64_t baseOffset,
+                                          unsigned unitSize, bool bigEndian)
+{
+    const char* position = begin;
+    while (position < end)
+    {
+        const char* found = static_cast<const char*>(memchr(position, '\n', static_cast<size_t>(end - position)));
+        if (!found)
+        {
+            return end;
+        }
+        if (unitSize == 1)
+        {
+            return found;
+        }
+
+        // Для UTF-16 байт 0x0A должен быть младшим байтом выровненной единицы
+        uint64_t offset = baseOffset + static_cast<uint64_t>(found - begin);
+        if (!bigEndian && offset % 2 == 0 && found + 1 < end && found[1] == 0)
+        {
+            return found;
+        }
+        if (bigEndian && offset % 2 == 1 && found > begin && found[-1] == 0)
+        {
+            return found - 1;
+        }
+        position = found + 1;
+    }
+    return end;
+}
+
+void SparseLineIndex::scan(std::wstring path, uint64_t dataStart, unsigned unitSize, bool bigEndian)
+{
+    FILE* file = PortableFile::open(path, "rb");
+    if (!file || !PortableFile::seek(file, dataStart))
+    {
+        if (file)
+        {
+            fclose(file);
+        }
+        m_isComplete = true;
+        return;
+    }
+
+    std::vector<char> buffer(SCAN_BUFFER_SIZE);
+    uint64_t bufferOffset = dataStart;
+    uint64_t lineCount = 1;
+    uint64_t lineBegin = dataStart;
+    size_t count;
+    while (!m_isStopping && (count = fread(buffer.data(), 1, buffer.size(), file)) > 0)
+    {
+        const char* end = buffer.data() + count;
+        const char* position = buffer.data();
+        while (position < end)
+        {
+            const char* lineFeed = findLineFeed(position, end, bufferOffset + (position - buffer.data()),
+                                                unitSize, bigEndian);
+            if (lineFeed == end)
+            {
+                break;
+            }
+
+            uint64_t lineEnd = bufferOffset + static_cast<uint64_t>(lineFeed - buffer.data());
+            addLongLine(lineBegin, lineEnd);
+            uint64_t lineStart = lineEnd + unitSize;
+            lineBegin = lineStart;
+            if (lineCount % m_stride == 0)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_checkpoints.push_back(lineStart);
+                if (m_checkpoints.size() >= MAX_CHECKPOINTS)
+                {
+                    // Удваиваем шаг: остаются точки с четными номерами
+                    for (size_t i = 0; i * 2 < m_checkpoints.size(); ++i)
+                    {
+                        m_checkpoints[i] = m_checkpoints[i * 2];
+                    }
+                    m_checkpoints.resize((m_checkpoints.size() + 1) / 2);
+                    m_stride *= 2;
+                }
+            }
+            ++lineCount;
+            m_lineCount = lineCount;
+            position = lineFeed + unitSize;
+        }
+
+        bufferOffset += count;
+        m_scannedBytes = bufferOffset;
+    }
+
+    fclose(file);
+    if (!m_isStopping)
+    {
+        // Последняя строка заканчивается концом файла
+        addLongLine(lineBegin, bufferOffset);
+    }
+    m_isComplete = !m_isStopping.load();
+}
+
+void SparseLineIndex::addLongLine(uint64_t start, uint64_t end)
+{
+    if (end - start < LONG_LINE_BYTES)
+    {
+        return;
+    }
+    LongLine line = { start, end };
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_longLines.push_back(line);
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Разреженный индекс строк большого файла
+ *
+ * Фоновый поток читает файл последовательно и запоминает смещение
+ * начала каждой stride-й строки. Когда число контрольных точек достигает
+ * предела, шаг удваивается, поэтому память ограничена независимо от
+ * размера файла. Точное начало строки находится от ближайшей контрольной
+ * точки прямым просмотром не более stride строк. Границы длинных строк
+ * (от LONG_LINE_BYTES) запоминаются отдельно, чтобы чтение их участков
+ * не требовало просмотра строки целиком.
+ */
+class SparseLineIndex
+{
+public:
+    static const size_t DEFAULT_STRIDE = 256;               ///< Начальный шаг контрольных точек (строк)
+    static const size_t MAX_CHECKPOINTS = 1 << 20;          ///< Предельное число контрольных точек
+    static const uint64_t LONG_LINE_BYTES = 1024 * 1024;    ///< Длина строки, границы которой запоминаются
+
+    SparseLineIndex();
+    ~SparseLineIndex();
+
+    /**
+     * @brief Запустить построение индекса в фоне
+     * @param path Путь к файлу
+     * @param dataStart Смещение начала текста (после BOM)
+     * @param unitSize Размер кодовой единицы (1 или 2 байта)
+     * @param bigEndian Порядок байт для двухбайтовых единиц
+     */
+    void start(const std::wstring& path, uint64_t dataStart, unsigned unitSize, bool bigEndian);
+
+    /**
+     * @brief Остановить построение и очистить индекс
+     */
+    void stop();
+
+    /**
+     * @brief Проверить, завершено ли построение
+     * @return true если весь файл проиндексирован
+     */
+    bool isComplete() const;
+
+    /**
+     * @brief Получить количество известных строк (окончательное после завершения)
+     * @return Количество строк
+     */
+    uint64_t lineCount() const;
+
+    /**
+     * @brief Получить количество просмотренных байт
+     * @return Смещение, до которого файл проиндексирован
+     */
+    uint64_t scannedBytes() const;
+
+    /**
+     * @brief Найти ближайшую контрольную точку не после строки
+     * @param line Номер строки
+     * @param checkpointLine Номер строки контрольной точки
+     * @param checkpointOffset Смещение начала этой строки
+     * @return false если строка еще не проиндексирована
+     */
+    bool checkpointForLine(uint64_t line, uint64_t& checkpointLine, uint64_t& checkpointOffset) const;
+
+    /**
+     * @brief Найти ближайшую контрольную точку не после смещения
+     * @param offset Смещение в файле
+     * @param checkpointLine Номер строки контрольной точки
+     * @param checkpointOffset Смещение начала этой строки
+     * @return false если смещение еще не проиндексировано
+     */
+    bool checkpointForOffset(uint64_t offset, uint64_t& checkpointLine, uint64_t& checkpointOffset) const;
+
+    /**
+     * @brief Найти конец длинной строки
+     * @param lineStart Смещение начала строки
+     * @param lineEnd Смещение перевода строки (или конца файла для последней строки)
+     * @return false если строка не длинная или еще не проиндексирована
+     */
+    bool longLineEnd(uint64_t lineStart, uint64_t& lineEnd) const;
+
+    /**
+     * @brief Найти конец строки в буфере
+     * @param begin Начало буфера
+     * @param end Конец буфера
+     * @param baseOffset Смещение начала буфера в файле (для выравнивания единиц)
+     * @param unitSize Размер кодовой единицы
+     * @param bigEndian Порядок байт
+     * @return Указатель на первую кодовую единицу перевода строки или end
+     */
+    static const char* findLineFeed(const char* begin, const char* end, uint64_t baseOffset,
+                                    unsigned unitSize, bool bigEndian);
+
+private:
+    /**
+     * @brief Границы длинной строки
+     */
+    struct LongLine
+    {
+        uint64_t start;     ///< Начало строки
+        uint64_t end;       ///< Перевод строки или конец файла
+    };
+
+    std::thread m_thread;                       ///< Поток построения
+    std::atomic<bool> m_isStopping;             ///< Флаг остановки
+    std::atomic<bool> m_isComplete;             ///< Флаг завершения
+    std::atomic<uint64_t> m_lineCount;          ///< Известное количество строк
+    std::atomic<uint64_t> m_scannedBytes;       ///< Просмотренный объем
+    mutable std::mutex m_mutex;                 ///< Защита контрольных точек
+    std::vector<uint64_t> m_checkpoints;        ///< Смещения строк 0, stride, 2*stride, ...
+    size_t m_stride;                            ///< Текущий шаг
+    std::vector<LongLine> m_longLines;          ///< Длинные строки по возрастанию смещения
+
+    /**
+     * @brief Цикл построения индекса
+     */
+    void scan(std::wstring path, uint64_t dataStart, unsigned unitSize, bool bigEndian);
+
+    /**
+     * @brief Запомнить строку, если она длинная
+     * @param start Начало строки
+     * @param end Конец строки
+     */
+    void addLongLine(uint64_t start, uint64_t end);
+
+    SparseLineIndex(const SparseLineIndex&);
+    SparseLineIndex& operator=(const SparseLineIndex&);
+};
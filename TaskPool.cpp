@@ -0,0 +1,72 @@
+#include "TaskPool.h"
+
+TaskPool::TaskPool(size_t threadCount)
+    : m_isStopping(false)
+{
+    if (threadCount == 0)
+    {
+        threadCount = defaultThreadCount();
+    }
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        m_threads.push_back(std::thread(&TaskPool::workerLoop, this));
+    }
+}
+
+TaskPool::~TaskPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopping = true;
+        m_queue.clear();
+    }
+    m_condition.notify_all();
+
+    for (size_t i = 0; i < m_threads.size(); ++i)
+    {
+        m_threads[i].join();
+    }
+}
+
+void TaskPool::submit(Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_isStopping)
+        {
+            return;
+        }
+        m_queue.push_back(std::move(task));
+    }
+    m_condition.notify_one();
+}
+
+size_t TaskPool::threadCount() const
+{
+    return m_threads.size();
+}
+
+size_t TaskPool::defaultThreadCount()
+{
+    unsigned cores = std::thread::hardware_concurrency();
+    return cores > 0 ? static_cast<size_t>(cores) : 1;
+}
+
+void TaskPool::workerLoop()
+{
+    for (;;)
+    {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_isStopping || !m_queue.empty(); });
+            if (m_isStopping)
+            {
+                return;
+            }
+            task = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Пул рабочих потоков для фоновых задач
+ *
+ * Задачи выполняются в порядке постановки в очередь. При уничтожении
+ * пула невыполненные задачи отбрасываются, а рабочие потоки дожидаются
+ * завершения текущих задач. Не зависит от WinAPI.
+ */
+class TaskPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    /**
+     * @brief Конструктор
+     * @param threadCount Количество потоков (0 - по числу ядер)
+     */
+    explicit TaskPool(size_t threadCount = 0);
+    ~TaskPool();
+
+    /**
+     * @brief Поставить задачу в очередь
+     * @param task Задача
+     */
+    void submit(Task task);
+
+    /**
+     * @brief Получить количество рабочих потоков
+     * @return Количество потоков
+     */
+    size_t threadCount() const;
+
+    /**
+     * @brief Количество потоков по умолчанию (по числу ядер, не менее одного)
+     * @return Количество потоков
+     */
+    static size_t defaultThreadCount();
+
+private:
+    std::vector<std::thread> m_threads;     ///< Рабочие потоки
+    std::deque<Task> m_queue;               ///< Очередь задач
+    std::mutex m_mutex;                     ///< Защита очереди
+    std::condition_variable m_condition;    ///< Сигнал о новой задаче
+    bool m_isStopping;                      ///< Флаг остановки
+
+    /**
+     * @brief Цикл рабочего потока
+     */
+    void workerLoop();
+
+    TaskPool(const TaskPool&);
+    TaskPool& operator=(const TaskPool&);
+};
@@ -0,0 +1,127 @@
+#include "TextChangeTracker.h"
+#include <algorithm>
+#include <cwchar>
+
+TextChangeTracker::TextChangeTracker()
+{
+}
+
+void TextChangeTracker::addListener(ITextChangeListener* listener)
+{
+    if (listener && std::find(m_listeners.begin(), m_listeners.end(), listener) == m_listeners.end())
+    {
+        m_listeners.push_back(listener);
+    }
+}
+
+void TextChangeTracker::removeListener(ITextChangeListener* listener)
+{
+    m_listeners.erase(std::remove(m_listeners.begin(), m_listeners.end(), listener), m_listeners.end());
+}
+
+void TextChangeTracker::reset(const wchar_t* text, size_t length)
+{
+    m_text.assign(text, length);
+    for (size_t i = 0; i < m_listeners.size(); ++i)
+    {
+        m_listeners[i]->onTextReset(m_text);
+    }
+}
+
+bool TextChangeTracker::update(const wchar_t* text, size_t length)
+{
+    size_t oldLength = m_text.length();
+    size_t prefix = commonPrefix(text, length);
+    if (prefix == oldLength && prefix == length)
+    {
+        return false; // Текст не изменился
+    }
+
+    size_t suffix = commonSuffix(text, length, prefix);
+    size_t removeCount = oldLength - prefix - suffix;
+    size_t insertCount = length - prefix - suffix;
+
+    applyEdit(prefix, removeCount, text + prefix, insertCount);
+    return true;
+}
+
+void TextChangeTracker::applyEdit(size_t offset, size_t removeCount, const std::wstring& insertedText)
+{
+    applyEdit(offset, removeCount, insertedText.data(), insertedText.size());
+}
+
+void TextChangeTracker::applyEdit(size_t offset, size_t removeCount, const wchar_t* insertedText, size_t insertedLength)
+{
+    TextEdit edit;
+    edit.offset = offset;
+    m_text.appendRange(offset, removeCount, edit.removedText);
+    edit.insertedText = insertedText;
+    edit.insertedLength = insertedLength;
+
+    ChunkChange change = m_text.replace(offset, removeCount, insertedText, insertedLength);
+    for (size_t i = 0; i < m_listeners.size(); ++i)
+    {
+        m_listeners[i]->onTextEdited(m_text, edit, change);
+    }
+}
+
+const ChunkedText& TextChangeTracker::text() const
+{
+    return m_text;
+}
+
+size_t TextChangeTracker::commonPrefix(const wchar_t* text, size_t length) const
+{
+    size_t position = 0;
+    for (size_t index = 0; index < m_text.chunkCount() && position < length; ++index)
+    {
+        const std::wstring& chunk = m_text.chunkText(index);
+        size_t count = std::min(chunk.size(), length - position);
+
+        // Быстрое сравнение целого блока, посимвольно - только при расхождении
+        if (wmemcmp(chunk.data(), text + position, count) != 0)
+        {
+            size_t i = 0;
+            while (chunk[i] == text[position + i])
+            {
+                ++i;
+            }
+            return position + i;
+        }
+
+        position += count;
+        if (count < chunk.size())
+        {
+            break;
+        }
+    }
+    return position;
+}
+
+size_t TextChangeTracker::commonSuffix(const wchar_t* text, size_t length, size_t prefix) const
+{
+    size_t limit = std::min(m_text.length(), length) - prefix;
+    size_t matched = 0;
+    size_t index = m_text.chunkCount();
+
+    while (index > 0 && matched < limit)
+    {
+        --index;
+        const std::wstring& chunk = m_text.chunkText(index);
+        size_t count = std::min(chunk.size(), limit - matched);
+        const wchar_t* chunkTail = chunk.data() + chunk.size() - count;
+        const wchar_t* textTail = text + length - matched - count;
+
+        if (wmemcmp(chunkTail, textTail, count) != 0)
+        {
+            size_t i = 0;
+            while (chunkTail[count - 1 - i] == textTail[count - 1 - i])
+            {
+                ++i;
+            }
+            return matched + i;
+        }
+        matched += count;
+    }
+    return matched;
+}
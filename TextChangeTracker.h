@@ -0,0 +1,124 @@
+#pragma once
+
+#include "ChunkedText.h"
+#include <vector>
+
+/**
+ * @brief Одна правка документа: замена фрагмента текста
+ */
+struct TextEdit
+{
+    size_t offset;              ///< Позиция начала правки
+    std::wstring removedText;   ///< Удаленный текст
+    const wchar_t* insertedText;    ///< Вставленный текст (действителен только во время уведомления)
+    size_t insertedLength;          ///< Длина вставленного текста
+};
+
+/**
+ * @brief Подписчик на изменения текста документа
+ *
+ * Позволяет модулям (журнал, индексы, статистика) обновляться
+ * инкрементально по диапазону правки, не перечитывая весь текст.
+ */
+class ITextChangeListener
+{
+public:
+    virtual ~ITextChangeListener() {}
+
+    /**
+     * @brief Текст документа заменен целиком (открытие, создание файла)
+     * @param text Новый текст
+     */
+    virtual void onTextReset(const ChunkedText& text) = 0;
+
+    /**
+     * @brief В документе выполнена правка
+     * @param text Текст после правки
+     * @param edit Описание правки
+     * @param change Изменение списка блоков текста
+     */
+    virtual void onTextEdited(const ChunkedText& text, const TextEdit& edit, const ChunkChange& change) = 0;
+};
+
+/**
+ * @brief Отслеживание правок документа по теневой копии текста
+ *
+ * EDIT-контрол сообщает только о факте изменения (EN_CHANGE). Трекер
+ * сравнивает новый текст с теневой копией (общий префикс и суффикс),
+ * выделяет одну правку, применяет ее к копии и уведомляет подписчиков.
+ * Сравнение занимает O(n), поэтому правки с известным участком (ввод у
+ * выделения, вставка, программные замены) передаются через applyEdit и
+ * стоят O(длина правки + log n). Класс не зависит от WinAPI.
+ */
+class TextChangeTracker
+{
+public:
+    TextChangeTracker();
+
+    /**
+     * @brief Добавить подписчика
+     * @param listener Подписчик (не принадлежит трекеру)
+     */
+    void addListener(ITextChangeListener* listener);
+
+    /**
+     * @brief Удалить подписчика
+     * @param listener Подписчик
+     */
+    void removeListener(ITextChangeListener* listener);
+
+    /**
+     * @brief Заменить текст целиком
+     * @param text Указатель на текст
+     * @param length Длина текста
+     */
+    void reset(const wchar_t* text, size_t length);
+
+    /**
+     * @brief Сравнить текст с теневой копией и применить найденную правку
+     * @param text Текущий текст документа
+     * @param length Длина текста
+     * @return true если текст изменился
+     */
+    bool update(const wchar_t* text, size_t length);
+
+    /**
+     * @brief Применить известную правку без сравнения текста
+     * @param offset Начало заменяемого фрагмента
+     * @param removeCount Длина заменяемого фрагмента
+     * @param insertedText Вставляемый текст
+     */
+    void applyEdit(size_t offset, size_t removeCount, const std::wstring& insertedText);
+
+    /**
+     * @brief Применить известную правку, не копируя вставляемый текст
+     *
+     * Текст читается прямо из буфера вызывающего (например, из буфера
+     * EDIT-контрола) и копируется только в блоки теневой копии.
+     * @param offset Начало заменяемого фрагмента
+     * @param removeCount Длина заменяемого фрагмента
+     * @param insertedText Указатель на вставляемый текст
+     * @param insertedLength Длина вставляемого текста
+     */
+    void applyEdit(size_t offset, size_t removeCount, const wchar_t* insertedText, size_t insertedLength);
+
+    /**
+     * @brief Получить теневую копию текста
+     * @return Текст документа
+     */
+    const ChunkedText& text() const;
+
+private:
+    ChunkedText m_text;                             ///< Теневая копия текста
+    std::vector<ITextChangeListener*> m_listeners;  ///< Подписчики
+
+    /**
+     * @brief Длина общего префикса теневой копии и текста
+     */
+    size_t commonPrefix(const wchar_t* text, size_t length) const;
+
+    /**
+     * @brief Длина общего суффикса (не заходя в общий префикс)
+     */
+    size_t commonSuffix(const wchar_t* text, size_t length, size_t prefix) const;
+};
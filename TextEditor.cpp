@@ -5,9 +5,42 @@
 #include "TextEditor.h"
 #include "RegistryManager.h"
 #include "DarkScreenManager.h"
+#include "TextChangeTracker.h"
+#include "EditJournal.h"
+#include "ChunkHashTree.h"
+#include "ChunkLineIndex.h"
+#include "SessionSnapshot.h"
+#include "ContentHash.h"
+#include "DocumentManager.h"
+#include "LargeFileViewer.h"
+#include "FileWatcher.h"
+#include "FileTail.h"
+#include "LineDiff.h"
+#include "CompareView.h"
+#include "EncodingDetector.h"
+#include "TextEncoder.h"
+#include "LineEndingScanner.h"
+#include "ChunkedPaste.h"
+#include "SelectionSnapshot.h"
+#include "SelectionModel.h"
+#include "KeyboardMacro.h"
+#include "MacroPlayer.h"
+#include "WordCompletionIndex.h"
+#include "BracketIndex.h"
+#include "MinimapCache.h"
+#include "MinimapView.h"
+#include "TextStatistics.h"
+#include "LineOperations.h"
 #include <commdlg.h>
 #include <commctrl.h>
 #include <locale.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
 
 // Подключаем необходимые библиотеки
 #pragma comment(lib, "comctl32.lib")
@@ -15,6 +48,20 @@
 #define MAX_LOADSTRING 100
 #define TIMER_IDLE 1
 #define IDLE_TIMEOUT 5000
+#define WM_APP_SNAPSHOT_STALE (WM_APP + 1)
+#define WM_APP_FILE_APPENDED (WM_APP + 2)
+#define WM_APP_PASTE_DONE (WM_APP + 3)
+#define WM_APP_PASTE_PROGRESS (WM_APP + 4)
+#define WM_APP_STATUS_UPDATE (WM_APP + 5)
+#define DOCUMENT_MEMORY_BUDGET (64 * 1024 * 1024)
+#define OPEN_FILES_BUFFER_SIZE 32768
+#define LARGE_FILE_THRESHOLD (64ULL * 1024 * 1024)
+#define LONG_LINE_THRESHOLD (4ULL * 1024 * 1024)
+#define LONG_LINE_SCAN_BUFFER_SIZE (1024 * 1024)
+#define INPUT_TEXT_BUFFER_SIZE 1024
+#define STREAMING_PASTE_THRESHOLD (4 * 1024 * 1024)
+#define DELAYED_COPY_THRESHOLD (1024 * 1024)
+#define RELOAD_MERGE_GAP 4096
 
 // Global Variables:
 HINSTANCE hInst;                                // current instance
@@ -40,6 +87,87 @@ COLORREF g_backgroundColor = RGB(255, 255, 255);
 HFONT g_hCurrentFont = NULL;
 HBRUSH g_hBackgroundBrush = NULL;
 
+// Переменные для отслеживания правок и журнала восстановления
+TextChangeTracker* g_pChangeTracker = nullptr;
+EditJournal* g_pEditJournal = nullptr;         // Журнал активного документа (принадлежит менеджеру документов)
+BOOL g_areJournalsEnabled = FALSE;              // Журналы старого сеанса прочитаны, можно создавать новые
+ChunkHashTree* g_pTextHash = nullptr;           // Хеш текста для точного флага изменения
+ChunkLineIndex* g_pLineIndex = nullptr;         // Индекс логических строк для перехода
+WordCompletionIndex* g_pWordIndex = nullptr;    // Слова документа для автодополнения
+BracketIndex* g_pBracketIndex = nullptr;        // Скобки документа для поиска парной
+MinimapCache* g_pMinimapCache = nullptr;        // Уменьшенный растр документа для мини-карты
+TextStatistics* g_pStatistics = nullptr;        // Счетчики документа для строки состояния
+
+// Переменные для быстрого восстановления сеанса
+DocumentFormat g_documentFormat;                // Формат текущего файла (кодировка, BOM, переводы строк)
+ULONGLONG g_documentHash = 0;                   // Хеш байтов файла на диске
+PortableFile::Info g_documentInfo = { 0, 0 };   // Размер и время изменения файла
+BOOL g_hasDocumentInfo = FALSE;                 // Сведения о файле актуальны
+UINT g_documentGeneration = 0;                  // Номер загрузки (для фоновой проверки)
+BOOL g_isSnapshotRestored = FALSE;              // Документ показан из снимка сеанса
+std::thread g_snapshotValidator;                // Фоновая проверка снимка
+
+// Переменные для вкладок документов
+HWND hTabControl = NULL;
+DocumentManager* g_pDocumentManager = nullptr;
+DocumentId g_activeDocument = 0;
+BOOL g_isReplacingText = FALSE;                 // Текст заменяется программно (EN_CHANGE не разбирается)
+BOOL g_isEditPending = FALSE;                   // EDIT-контрол обрабатывает ввод у выделения
+size_t g_pendingEditLength = 0;                 // Длина текста до этого ввода
+size_t g_pendingEditStart = 0;                  // Выделение до этого ввода
+size_t g_pendingEditEnd = 0;
+BOOL g_isWordWrap = FALSE;                      // Перенос по словам в EDIT-контроле и окнах просмотра
+SelectionModel g_selections;                    // Курсоры для одновременной правки (EDIT показывает основной)
+WNDPROC g_pfnEditProc = NULL;                   // Исходная оконная процедура EDIT-контрола
+
+// Правка из нескольких участков, которая отменяется одним шагом: EDIT-контрол
+// помнит только одну правку
+struct UndoGroup
+{
+    struct Span
+    {
+        size_t offset;          // Начало участка в текущем тексте
+        size_t length;          // Длина участка в текущем тексте
+        std::wstring text;      // Текст, который возвращает отмена
+    };
+    std::vector<Span> spans;    // Участки по возрастанию позиции
+};
+UndoGroup* g_pUndoGroup = nullptr;              // Групповая отмена последней правки (или nullptr)
+size_t g_bracketHighlight[2] = { 0, 0 };        // Подсвеченная пара скобок
+BOOL g_hasBracketHighlight = FALSE;             // Пара скобок подсвечена
+KeyboardMacro g_macro;                          // Последний записанный макрос
+BOOL g_isRecordingMacro = FALSE;                // Идет запись макроса
+
+// Переменные для просмотра больших файлов
+std::map<DocumentId, LargeFileViewer*> g_largeFileViewers;  // Окна просмотра по документам
+LargeFileViewer* g_pActiveViewer = nullptr;                 // Окно просмотра активного документа
+std::wstring g_startupLargeFile;                            // Большой файл из прошлого сеанса
+std::wstring g_lastSearchText;                              // Последний искомый текст
+
+// Переменные для режима слежения за файлом
+FileWatcher* g_pFileWatcher = nullptr;          // Наблюдение за файлом активного документа
+FileTail* g_pFileTail = nullptr;                // Чтение дописанного текста
+std::atomic<bool> g_isFollowPending(false);     // Сообщение о дописанном тексте уже в очереди
+BOOL g_isFollowDeferred = FALSE;                // Дописанный текст ждет завершения вставки
+
+// Переменные для сравнения текстов
+CompareView* g_pCompareView = nullptr;          // Окно сравнения (создается при первом сравнении)
+
+// Переменные мини-карты
+MinimapView* g_pMinimapView = nullptr;          // Панель мини-карты справа от EDIT-контрола
+BOOL g_isMinimapVisible = FALSE;                // Мини-карта включена
+
+// Переменные строки состояния
+HWND hStatusBar = NULL;
+BOOL g_isStatusUpdatePending = FALSE;           // Сообщение об обновлении строки состояния уже в очереди
+size_t g_editAnchor = 0;                        // Неподвижный конец выделения EDIT-контрола
+size_t g_editCaret = 0;                         // Конец выделения EDIT-контрола с курсором
+
+// Переменные для вставки больших фрагментов из буфера обмена
+struct PasteJob;
+PasteJob* g_pPasteJob = nullptr;                // Выполняемая вставка (документ заблокирован)
+SelectionSnapshot* g_pClipboardSnapshot = nullptr;  // Скопированный фрагмент до запроса буфера обмена
+
 // Forward declarations of functions included in this code module:
 ATOM                MyRegisterClass(HINSTANCE hInstance);
 BOOL                InitInstance(HINSTANCE, int);
@@ -51,14 +179,20 @@ UINT_PTR CALLBACK   FileDialogHook(HWND hDlg, UINT message, WPARAM wParam, LPARA
 // Функции для текстового редактора
 void                CreateEditControl(HWND hParent);
 void                ResizeEditControl(HWND hParent);
+void                SetWordWrap(HWND hWnd, BOOL enabled);
 BOOL                CreateNewFile(HWND hWnd);
 BOOL                OpenTextFile(HWND hWnd);
 BOOL                LoadFileContent(const WCHAR* filePath);
+BOOL                ReadTextFile(const WCHAR* filePath, std::wstring& text, DocumentFormat& format, ULONGLONG& contentHash);
 BOOL                SaveTextFile(HWND hWnd);
 BOOL                SaveTextFileAs(HWND hWnd);
 void                CutText();
 void                CopyText();
 void                PasteText();
+BOOL                RenderClipboardSnapshot();
+BOOL                StartStreamingPaste(HWND hWnd);
+void                BuildPastedText(PasteJob* job);
+void                FinishStreamingPaste(HWND hWnd, BOOL apply);
 void                SetFileModified(BOOL modified);
 BOOL                PromptSaveChanges(HWND hWnd);
 void                UpdateWindowTitle(HWND hWnd);
@@ -72,6 +206,95 @@ void                ApplyColorSettings();
 BOOL                ShowFontDialog();
 BOOL                ShowColorDialog(BOOL isTextColor);
 
+// Функции для отслеживания правок и восстановления после сбоя
+void                SyncChangeTracker(BOOL reset);
+BOOL                ApplyPendingEdit(const WCHAR* text, size_t length);
+void                InitializeEditJournal(HWND hWnd);
+BOOL                ApplyUndoGroup();
+void                DiscardUndoGroup();
+void                AttachDocumentJournal();
+void                DetachDocumentJournal();
+void                RestoreRecoveredDocument(HWND hWnd, const RecoveredDocument& recovered);
+std::wstring        GetRecoveryJournalPath(DocumentId id);
+std::wstring        GetLocalDataPath(const WCHAR* fileName);
+
+// Функции для быстрого восстановления сеанса
+void                RememberDocumentFile(const DocumentFormat& format, ULONGLONG contentHash);
+BOOL                RestoreSessionDocument(const WCHAR* filePath);
+void                ValidateRestoredSession(HWND hWnd);
+void                SaveSessionSnapshot();
+void                RestoreEditorPosition(uint64_t selectionStart, uint64_t selectionEnd, uint64_t firstVisibleLine);
+
+// Функции для вкладок документов
+void                SetEditorText(const WCHAR* text);
+bool                DecodeDocumentFile(const std::wstring& path, DecodedDocument& result);
+void                CreateTabControl(HWND hParent);
+void                AddDocumentTab(DocumentId id);
+void                UpdateDocumentTab();
+void                RegisterStartupDocument(HWND hWnd);
+void                StoreActiveDocument();
+BOOL                ShowDocument(HWND hWnd, DocumentId id);
+BOOL                ActivateDocument(HWND hWnd, DocumentId id);
+void                OpenDocuments(HWND hWnd, const std::vector<std::wstring>& paths);
+void                NewDocumentTab(HWND hWnd);
+void                CloseActiveDocument(HWND hWnd);
+void                SwitchDocumentTab(HWND hWnd, int step);
+BOOL                PromptSaveAllDocuments(HWND hWnd);
+
+// Функции для просмотра больших файлов и поиска
+BOOL                IsLargeFile(const WCHAR* filePath);
+void                BuildSingleByteTable(UINT codePage, std::vector<wchar_t>& table);
+LargeFileViewer*    CreateLargeFileViewer(HWND hWnd, const std::wstring& path);
+void                DestroyLargeFileViewer(DocumentId id);
+void                ShowLargeFileViewer(LargeFileViewer* viewer);
+INT_PTR CALLBACK    InputDialog(HWND, UINT, WPARAM, LPARAM);
+BOOL                ShowInputDialog(HWND hWnd, const WCHAR* title, const WCHAR* prompt, std::wstring& value);
+void                FindText(HWND hWnd, BOOL askText);
+void                GoToLine(HWND hWnd);
+void                GoToOffset(HWND hWnd);
+void                GoToPercent(HWND hWnd);
+void                SetEditorCaret(size_t offset);
+LRESULT CALLBACK    EditControlProc(HWND, UINT, WPARAM, LPARAM);
+void                AddCaretOnLine(HWND hWnd, int lineStep);
+void                SelectColumn(HWND hWnd);
+void                EditAllCarets(const std::wstring& text, int deleteDirection);
+void                ResetSelections();
+void                RecordMacroKey(UINT message, WPARAM wParam);
+void                ToggleMacroRecording(HWND hWnd);
+void                PlayMacro(HWND hWnd, BOOL askCount);
+void                CompleteWord(HWND hWnd);
+BOOL                IsCodeDocument();
+BOOL                FindBracketAtCaret(size_t& bracket, size_t& match, BOOL& isBeforeCaret);
+void                UpdateBracketHighlight();
+void                DrawBracketHighlight(HWND hEdit);
+BOOL                GetEditCharRect(HWND hEdit, HDC hdc, size_t offset, RECT& rect);
+void                InvalidateBracketHighlight();
+void                GoToMatchingBracket();
+void                ToggleFold(HWND hWnd);
+void                ApplyLineOperation(HWND hWnd, int command);
+void                CreateStatusBar(HWND hParent);
+void                RequestStatusUpdate();
+void                UpdateStatusBar();
+void                TrackEditCaret(UINT message, WPARAM wParam, LPARAM lParam);
+
+// Функции для режима слежения за файлом
+BOOL                StartFollowingFile(HWND hWnd);
+void                StopFollowingFile(HWND hWnd);
+void                ReadFollowedFile(HWND hWnd);
+void                AppendEditorText(const std::wstring& text);
+
+// Функции для отслеживания изменений файла другими программами
+BOOL                IsFileChangedOnDisk();
+void                CheckExternalChanges(HWND hWnd);
+BOOL                ReloadDocumentIncrementally(HWND hWnd);
+
+// Функции для сравнения текстов
+void                CompareWithFile(HWND hWnd, BOOL askFile);
+
+// Функции для выбора кодировки файла
+std::wstring        GetEncodingName(const DocumentFormat& format);
+BOOL                SaveTextFileWithEncoding(HWND hWnd, int commandId);
+
 int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
     _In_opt_ HINSTANCE hPrevInstance,
     _In_ LPWSTR    lpCmdLine,
@@ -103,6 +326,24 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
     // Инициализируем менеджер темного экрана
     g_pDarkScreenManager = new DarkScreenManager(hInstance);
 
+    // Инициализируем теневую копию текста для отслеживания правок
+    g_pChangeTracker = new TextChangeTracker();
+    g_pTextHash = new ChunkHashTree();
+    g_pChangeTracker->addListener(g_pTextHash);
+    g_pLineIndex = new ChunkLineIndex();
+    g_pChangeTracker->addListener(g_pLineIndex);
+    g_pWordIndex = new WordCompletionIndex();
+    g_pChangeTracker->addListener(g_pWordIndex);
+    g_pBracketIndex = new BracketIndex();
+    g_pChangeTracker->addListener(g_pBracketIndex);
+    g_pMinimapCache = new MinimapCache();
+    g_pChangeTracker->addListener(g_pMinimapCache);
+    g_pStatistics = new TextStatistics();
+    g_pChangeTracker->addListener(g_pStatistics);
+
+    // Инициализируем менеджер документов (общий пул декодирования и бюджет памяти)
+    g_pDocumentManager = new DocumentManager(DecodeDocumentFile, DOCUMENT_MEMORY_BUDGET);
+
     // Загружаем заголовок и имя класса из ресурсов
     CHAR titleAnsi[MAX_LOADSTRING];
     LoadStringA(hInstance, IDS_APP_TITLE, titleAnsi, MAX_LOADSTRING);
@@ -144,6 +385,56 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
     {
         delete g_pDarkScreenManager;
     }
+    DiscardUndoGroup();
+    if (g_pCompareView)
+    {
+        delete g_pCompareView;
+    }
+    if (g_pMinimapView)
+    {
+        delete g_pMinimapView;
+    }
+    for (std::map<DocumentId, LargeFileViewer*>::iterator it = g_largeFileViewers.begin();
+         it != g_largeFileViewers.end(); ++it)
+    {
+        delete it->second;
+    }
+    if (g_pDocumentManager)
+    {
+        delete g_pDocumentManager;
+    }
+    if (g_pChangeTracker)
+    {
+        delete g_pChangeTracker;
+    }
+    if (g_pTextHash)
+    {
+        delete g_pTextHash;
+    }
+    if (g_pLineIndex)
+    {
+        delete g_pLineIndex;
+    }
+    if (g_pWordIndex)
+    {
+        delete g_pWordIndex;
+    }
+    if (g_pBracketIndex)
+    {
+        delete g_pBracketIndex;
+    }
+    if (g_pMinimapCache)
+    {
+        delete g_pMinimapCache;
+    }
+    if (g_pStatistics)
+    {
+        delete g_pStatistics;
+    }
+    if (g_pClipboardSnapshot)
+    {
+        delete g_pClipboardSnapshot;
+    }
 
     return (int)msg.wParam;
 }
@@ -236,40 +527,112 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         SetTimer(hWnd, TIMER_IDLE, IDLE_TIMEOUT, NULL);
         GetClientRect(hWnd, &clientRect);
         
-        // Создаем многострочный EDIT-контрол
+        // Стиль EDIT-контрола зависит от переноса по словам, поэтому
+        // эта настройка читается до его создания
+        if (g_pRegistryManager)
+        {
+            g_pRegistryManager->LoadWordWrap(g_isWordWrap);
+            g_pRegistryManager->LoadMinimap(g_isMinimapVisible);
+        }
+        CheckMenuItem(GetMenu(hWnd), IDM_VIEW_WORD_WRAP, MF_BYCOMMAND | (g_isWordWrap ? MF_CHECKED : MF_UNCHECKED));
+        CheckMenuItem(GetMenu(hWnd), IDM_VIEW_MINIMAP, MF_BYCOMMAND | (g_isMinimapVisible ? MF_CHECKED : MF_UNCHECKED));
+
+        // Создаем полосу вкладок, строку состояния, многострочный EDIT-контрол и мини-карту
+        CreateTabControl(hWnd);
+        CreateStatusBar(hWnd);
         CreateEditControl(hWnd);
+        g_pMinimapView = new MinimapView(hInst, *g_pMinimapCache);
+        if (g_pMinimapView->create(hWnd))
+        {
+            g_pMinimapView->setTarget(hEditControl);
+            g_pMinimapView->setColors(g_textColor, g_backgroundColor);
+        }
         
         // Загружаем настройки из реестра (после создания EditControl)
         LoadSettingsFromRegistry();
+
+        // Документ из снимка сеанса сверяем с диском в фоне
+        ValidateRestoredSession(hWnd);
+
+        // Загруженный документ становится первой вкладкой
+        RegisterStartupDocument(hWnd);
+
+        // Запускаем журналы правок (предлагает восстановление после сбоя)
+        InitializeEditJournal(hWnd);
         UpdateWindowTitle(hWnd);
     }
     break;
     case WM_COMMAND:
     {
-        int wmId = LOWORD(wParam);
-        // Parse the menu selections:
-        switch (wmId)
-        {
-        case IDM_FILE_NEW:
+        // Обработка уведомлений от EDIT-контрола
+        if (HIWORD(wParam) == EN_CHANGE && (HWND)lParam == hEditControl)
         {
-            // Проверяем, нужно ли сохранить изменения
-            if (isFileModified && !PromptSaveChanges(hWnd))
+            // Любая правка заменяет групповую отмену; группа ставится после своих правок
+            DiscardUndoGroup();
+            if (g_isReplacingText)
             {
-                break; // Пользователь отменил операцию
+                break; // Вызывающий код сам сбрасывает теневую копию и флаг изменения
+            }
+            SyncChangeTracker(FALSE);
+
+            // Правка могла вернуть текст к сохраненной версии (ввод и удаление символа)
+            BOOL modified = (!g_pTextHash || g_pTextHash->isModified()) ? TRUE : FALSE;
+            if (!modified && isFileModified && g_pEditJournal)
+            {
+                g_pEditJournal->markInSync();
             }
-            CreateNewFile(hWnd);
+            SetFileModified(modified);
+            break;
         }
-        break;
-        case IDM_FILE_OPEN:
+
+        int wmId = LOWORD(wParam);
+
+        // Во время фоновой вставки документ не меняется: команды меню и
+        // сочетания клавиш не выполняются, выход сначала отменяет вставку
+        if (g_pPasteJob)
         {
-            // Проверяем, нужно ли сохранить изменения
-            if (isFileModified && !PromptSaveChanges(hWnd))
+            if (wmId != IDM_EXIT)
             {
-                break; // Пользователь отменил операцию
+                break;
             }
-            OpenTextFile(hWnd);
+            FinishStreamingPaste(hWnd, FALSE);
         }
-        break;
+
+        // Parse the menu selections:
+        switch (wmId)
+        {
+        case IDM_FILE_NEW:
+            // Новый документ открывается в отдельной вкладке
+            NewDocumentTab(hWnd);
+            break;
+        case IDM_FILE_OPEN:
+            OpenTextFile(hWnd);
+            break;
+        case IDM_FILE_CLOSE:
+            CloseActiveDocument(hWnd);
+            break;
+        case IDM_FILE_COMPARE_SAVED:
+            CompareWithFile(hWnd, FALSE);
+            break;
+        case IDM_FILE_COMPARE_FILE:
+            CompareWithFile(hWnd, TRUE);
+            break;
+        case IDM_FILE_SAVE_UTF8:
+        case IDM_FILE_SAVE_UTF8_BOM:
+        case IDM_FILE_SAVE_UTF16LE:
+        case IDM_FILE_SAVE_UTF16BE:
+        case IDM_FILE_SAVE_1251:
+        case IDM_FILE_SAVE_KOI8R:
+        case IDM_FILE_SAVE_866:
+        case IDM_FILE_SAVE_1252:
+            SaveTextFileWithEncoding(hWnd, wmId);
+            break;
+        case IDM_WINDOW_NEXT_TAB:
+            SwitchDocumentTab(hWnd, 1);
+            break;
+        case IDM_WINDOW_PREV_TAB:
+            SwitchDocumentTab(hWnd, -1);
+            break;
         case IDM_FILE_SAVE:
         {
             if (hasFileName)
@@ -291,6 +654,81 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         case IDM_EDIT_PASTE:
             PasteText();
             break;
+        case IDM_EDIT_FIND:
+            FindText(hWnd, TRUE);
+            break;
+        case IDM_EDIT_FIND_NEXT:
+            FindText(hWnd, g_lastSearchText.empty());
+            break;
+        case IDM_EDIT_GOTO:
+            GoToLine(hWnd);
+            break;
+        case IDM_EDIT_GOTO_OFFSET:
+            GoToOffset(hWnd);
+            break;
+        case IDM_EDIT_GOTO_PERCENT:
+            GoToPercent(hWnd);
+            break;
+        case IDM_EDIT_ADD_CARET_ABOVE:
+            AddCaretOnLine(hWnd, -1);
+            break;
+        case IDM_EDIT_ADD_CARET_BELOW:
+            AddCaretOnLine(hWnd, 1);
+            break;
+        case IDM_EDIT_COLUMN_SELECT:
+            SelectColumn(hWnd);
+            break;
+        case IDM_EDIT_MACRO_RECORD:
+            ToggleMacroRecording(hWnd);
+            break;
+        case IDM_EDIT_MACRO_PLAY:
+            PlayMacro(hWnd, FALSE);
+            break;
+        case IDM_EDIT_MACRO_PLAY_REPEAT:
+            PlayMacro(hWnd, TRUE);
+            break;
+        case IDM_EDIT_COMPLETE_WORD:
+            CompleteWord(hWnd);
+            break;
+        case IDM_EDIT_GOTO_BRACKET:
+            GoToMatchingBracket();
+            break;
+        case IDM_EDIT_LINES_SORT:
+        case IDM_EDIT_LINES_SORT_ORDINAL:
+        case IDM_EDIT_LINES_UNIQUE:
+        case IDM_EDIT_LINES_REVERSE:
+        case IDM_EDIT_LINES_TRIM:
+            ApplyLineOperation(hWnd, wmId);
+            break;
+        case IDM_VIEW_FOLLOW:
+            if (g_pFileWatcher)
+            {
+                StopFollowingFile(hWnd);
+            }
+            else
+            {
+                StartFollowingFile(hWnd);
+            }
+            break;
+        case IDM_VIEW_TOGGLE_FOLD:
+            ToggleFold(hWnd);
+            break;
+        case IDM_VIEW_UNFOLD_ALL:
+            if (g_pActiveViewer)
+            {
+                g_pActiveViewer->unfoldAll();
+            }
+            break;
+        case IDM_VIEW_WORD_WRAP:
+            SetWordWrap(hWnd, !g_isWordWrap);
+            SaveSettingsToRegistry();
+            break;
+        case IDM_VIEW_MINIMAP:
+            g_isMinimapVisible = !g_isMinimapVisible;
+            CheckMenuItem(GetMenu(hWnd), IDM_VIEW_MINIMAP, MF_BYCOMMAND | (g_isMinimapVisible ? MF_CHECKED : MF_UNCHECKED));
+            ResizeEditControl(hWnd);
+            SaveSettingsToRegistry();
+            break;
         case IDM_SETTINGS_FONT:
             if (ShowFontDialog())
             {
@@ -310,7 +748,7 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             break;
         case IDM_EXIT:
             // Проверяем, нужно ли сохранить изменения перед выходом
-            if (isFileModified && !PromptSaveChanges(hWnd))
+            if (!PromptSaveAllDocuments(hWnd))
             {
                 break; // Пользователь отменил операцию
             }
@@ -319,11 +757,6 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         default:
             return DefWindowProc(hWnd, message, wParam, lParam);
         }
-        // Обработка уведомлений от EDIT-контрола
-        if (HIWORD(wParam) == EN_CHANGE && (HWND)lParam == hEditControl)
-        {
-            SetFileModified(TRUE);
-        }
     }
     break;
     case WM_PAINT:
@@ -349,7 +782,21 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         {
             g_pDarkScreenManager->handleUserActivity(hWnd);
         }
+        // Во время фоновой вставки фокус у главного окна: Esc отменяет ее
+        if (message == WM_KEYDOWN && wParam == VK_ESCAPE && g_pPasteJob)
+        {
+            FinishStreamingPaste(hWnd, FALSE);
+        }
+        break;
+    case WM_INITMENUPOPUP:
+    {
+        // Сворачивание блоков есть только в окне просмотра большого файла: EDIT-контрол
+        // не умеет скрывать строки. Недоступный пункт не выполняется и сочетанием клавиш
+        UINT foldState = MF_BYCOMMAND | (g_pActiveViewer ? MF_ENABLED : MF_GRAYED);
+        EnableMenuItem((HMENU)wParam, IDM_VIEW_TOGGLE_FOLD, foldState);
+        EnableMenuItem((HMENU)wParam, IDM_VIEW_UNFOLD_ALL, foldState);
         break;
+    }
     case WM_SIZE:
         GetClientRect(hWnd, &clientRect);
         ResizeEditControl(hWnd);
@@ -360,27 +807,127 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         SetTextColor(hdc, g_textColor);
         SetBkColor(hdc, g_backgroundColor);
         
-        // Удаляем старую кисть
-        if (g_hBackgroundBrush)
+        // Кисть общая для всех документов и пересоздается только при смене цвета
+        if (!g_hBackgroundBrush)
         {
-            DeleteObject(g_hBackgroundBrush);
+            g_hBackgroundBrush = CreateSolidBrush(g_backgroundColor);
         }
-        
-        // Создаем новую кисть
-        g_hBackgroundBrush = CreateSolidBrush(g_backgroundColor);
         return (LRESULT)g_hBackgroundBrush;
     }
+    case WM_NOTIFY:
+    {
+        // Переключение вкладки мышью
+        LPNMHDR header = (LPNMHDR)lParam;
+        if (header->hwndFrom == hTabControl && header->code == TCN_SELCHANGE && g_pDocumentManager)
+        {
+            int index = TabCtrl_GetCurSel(hTabControl);
+            ActivateDocument(hWnd, g_pDocumentManager->documentAt((size_t)index));
+        }
+        return DefWindowProc(hWnd, message, wParam, lParam);
+    }
+    case WM_APP_SNAPSHOT_STALE:
+        // Содержимое файла не совпало со снимком: перечитываем файл с диска
+        if ((UINT)wParam == g_documentGeneration && hasFileName)
+        {
+            if (isFileModified || g_pPasteJob)
+            {
+                MessageBoxW(hWnd, L"Файл был изменен на диске после последнего сеанса.",
+                            L"Предупреждение", MB_OK | MB_ICONWARNING);
+            }
+            else if (LoadFileContent(currentFileName))
+            {
+                SetFileModified(FALSE);
+                SyncChangeTracker(TRUE);
+            }
+        }
+        break;
+    case WM_APP_FILE_APPENDED:
+        // Во время вставки документ заблокирован: сообщение остается
+        // отложенным и повторяется, когда вставка завершится или будет отменена
+        if (g_pPasteJob)
+        {
+            g_isFollowDeferred = TRUE;
+            break;
+        }
+        // Файл дописан: читаем новые байты (устаревшие сообщения пропускаются)
+        g_isFollowPending = false;
+        if (g_pFileTail && (UINT)wParam == g_documentGeneration)
+        {
+            ReadFollowedFile(hWnd);
+        }
+        break;
+    case WM_APP_PASTE_PROGRESS:
+        if (g_pPasteJob)
+        {
+            WCHAR title[MAX_LOADSTRING + 32];
+            swprintf_s(title, MAX_LOADSTRING + 32, L"Вставка: %u%% (Esc - отмена) - %s", (UINT)wParam, szTitle);
+            SetWindowTextW(hWnd, title);
+        }
+        break;
+    case WM_APP_PASTE_DONE:
+        if (g_pPasteJob)
+        {
+            FinishStreamingPaste(hWnd, TRUE);
+        }
+        break;
+    case WM_APP_STATUS_UPDATE:
+        // Теневая копия к этому моменту уже синхронизирована с EDIT-контролом
+        g_isStatusUpdatePending = FALSE;
+        UpdateStatusBar();
+        break;
+    case WM_RENDERFORMAT:
+        // Другая программа запросила скопированный текст: буфер обмена уже открыт ею
+        if (wParam == CF_UNICODETEXT)
+        {
+            RenderClipboardSnapshot();
+        }
+        break;
+    case WM_RENDERALLFORMATS:
+        // Окно закрывается: текст должен остаться в буфере обмена
+        if (OpenClipboard(hWnd))
+        {
+            if (GetClipboardOwner() == hWnd)
+            {
+                RenderClipboardSnapshot();
+            }
+            CloseClipboard();
+        }
+        break;
+    case WM_DESTROYCLIPBOARD:
+        // Буфер обмена очищен: снимок больше не понадобится
+        if (g_pClipboardSnapshot)
+        {
+            delete g_pClipboardSnapshot;
+            g_pClipboardSnapshot = nullptr;
+        }
+        break;
+    case WM_ACTIVATEAPP:
+        // При возврате в редактор проверяем, не изменен ли файл другой программой
+        if (wParam && !g_pPasteJob)
+        {
+            CheckExternalChanges(hWnd);
+        }
+        break;
     case WM_CLOSE:
+        // Незавершенная вставка отменяется, документ остается прежним
+        if (g_pPasteJob)
+        {
+            FinishStreamingPaste(hWnd, FALSE);
+        }
         // Проверяем, нужно ли сохранить изменения перед выходом
-        if (isFileModified && !PromptSaveChanges(hWnd))
+        if (!PromptSaveAllDocuments(hWnd))
         {
             return 0; // Отменяем закрытие
         }
         DestroyWindow(hWnd);
         break;
     case WM_QUERYENDSESSION:
+        if (g_pPasteJob)
+        {
+            FinishStreamingPaste(hWnd, FALSE);
+        }
         // Проверяем, нужно ли сохранить изменения при завершении системы
-        if (isFileModified && !PromptSaveChanges(hWnd))
+        if (!PromptSaveAllDocuments(hWnd))
         {
             return FALSE; // Отменяем завершение
         }
@@ -390,8 +937,23 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         {
             g_pDarkScreenManager->killIdleTimer(hWnd);
         }
+        StopFollowingFile(hWnd);
         // Сохраняем настройки в реестр
         SaveSettingsToRegistry();
+
+        // Сохраняем снимок документа для быстрого запуска
+        SaveSessionSnapshot();
+        if (g_snapshotValidator.joinable())
+        {
+            g_snapshotValidator.join();
+        }
+
+        // Штатное завершение: журналы восстановления больше не нужны
+        if (g_pDocumentManager)
+        {
+            DetachDocumentJournal();
+            g_pDocumentManager->closeJournals(true);
+        }
         PostQuitMessage(0);
         break;
     default:
@@ -467,12 +1029,18 @@ UINT_PTR CALLBACK FileDialogHook(HWND hDlg, UINT message, WPARAM wParam, LPARAM
 // Создание многострочного EDIT-контрола
 void CreateEditControl(HWND hParent)
 {
+    // Без ES_AUTOHSCROLL и горизонтальной полосы EDIT-контрол переносит строки по словам
+    DWORD style = WS_CHILD | WS_VISIBLE | WS_VSCROLL | ES_MULTILINE | ES_AUTOVSCROLL;
+    if (!g_isWordWrap)
+    {
+        style |= WS_HSCROLL | ES_AUTOHSCROLL;
+    }
+
     hEditControl = CreateWindowExW(
         WS_EX_CLIENTEDGE,
         L"EDIT",
         L"",
-        WS_CHILD | WS_VISIBLE | WS_VSCROLL | WS_HSCROLL | 
-        ES_MULTILINE | ES_AUTOVSCROLL | ES_AUTOHSCROLL,
+        style,
         0, 0, 0, 0,
         hParent,
         NULL,
@@ -482,6 +1050,9 @@ void CreateEditControl(HWND hParent)
 
     if (hEditControl)
     {
+        // Ввод при нескольких курсорах перехватывается до EDIT-контрола
+        g_pfnEditProc = (WNDPROC)SetWindowLongPtr(hEditControl, GWLP_WNDPROC, (LONG_PTR)EditControlProc);
+
         // Применяем настройки шрифта и цветов
         ApplyFontSettings();
         ApplyColorSettings();
@@ -498,25 +1069,151 @@ void ResizeEditControl(HWND hParent)
     {
         RECT rect;
         GetClientRect(hParent, &rect);
-        SetWindowPos(hEditControl, NULL, 0, 0, 
-                    rect.right, rect.bottom, 
+
+        // Полоса вкладок занимает верхнюю часть окна
+        int tabHeight = 0;
+        if (hTabControl)
+        {
+            RECT displayRect = rect;
+            TabCtrl_AdjustRect(hTabControl, FALSE, &displayRect);
+            tabHeight = displayRect.top - rect.top;
+            SetWindowPos(hTabControl, NULL, 0, 0,
+                        rect.right, tabHeight,
+                        SWP_NOZORDER);
+        }
+
+        // Строка состояния сама встает вдоль нижнего края окна
+        if (hStatusBar)
+        {
+            SendMessage(hStatusBar, WM_SIZE, 0, 0);
+            RECT statusRect;
+            GetWindowRect(hStatusBar, &statusRect);
+            rect.bottom -= statusRect.bottom - statusRect.top;
+            if (rect.bottom < tabHeight)
+            {
+                rect.bottom = tabHeight;
+            }
+
+            int parts[5];
+            int partWidths[5] = { 4, 3, 3, 3, 3 };  // Доли ширины окна
+            int right = 0;
+            for (int i = 0; i < 5; ++i)
+            {
+                right += rect.right * partWidths[i] / 16;
+                parts[i] = right;
+            }
+            parts[4] = -1;
+            SendMessage(hStatusBar, SB_SETPARTS, 5, (LPARAM)parts);
+        }
+
+        // Мини-карта занимает правый край рядом с EDIT-контролом; окна
+        // просмотра больших файлов ее не показывают
+        int minimapWidth = 0;
+        if (g_pMinimapView && g_pMinimapView->getHandle())
+        {
+            minimapWidth = (g_isMinimapVisible && !g_pActiveViewer) ? MinimapView::getWidth() : 0;
+            SetWindowPos(g_pMinimapView->getHandle(), NULL, rect.right - minimapWidth, tabHeight,
+                        minimapWidth, rect.bottom - tabHeight,
+                        SWP_NOZORDER | (minimapWidth > 0 ? SWP_SHOWWINDOW : SWP_HIDEWINDOW));
+        }
+
+        SetWindowPos(hEditControl, NULL, 0, tabHeight, 
+                    rect.right - minimapWidth, rect.bottom - tabHeight, 
                     SWP_NOZORDER);
+
+        // Окна просмотра больших файлов занимают место EDIT-контрола
+        for (std::map<DocumentId, LargeFileViewer*>::iterator it = g_largeFileViewers.begin();
+             it != g_largeFileViewers.end(); ++it)
+        {
+            SetWindowPos(it->second->getHandle(), NULL, 0, tabHeight,
+                        rect.right, rect.bottom - tabHeight,
+                        SWP_NOZORDER);
+        }
+    }
+}
+
+// Включение и выключение переноса по словам
+void SetWordWrap(HWND hWnd, BOOL enabled)
+{
+    g_isWordWrap = enabled;
+    CheckMenuItem(GetMenu(hWnd), IDM_VIEW_WORD_WRAP, MF_BYCOMMAND | (enabled ? MF_CHECKED : MF_UNCHECKED));
+
+    for (std::map<DocumentId, LargeFileViewer*>::iterator it = g_largeFileViewers.begin();
+         it != g_largeFileViewers.end(); ++it)
+    {
+        it->second->setWordWrap(enabled);
+    }
+
+    if (!hEditControl)
+        return;
+
+    // ES_AUTOHSCROLL нельзя снять у созданного EDIT-контрола, поэтому он
+    // пересоздается с тем же текстом, выделением и первой видимой строкой
+    // (номер строки зависит от переноса, поэтому запоминается ее смещение)
+    BOOL wasVisible = IsWindowVisible(hEditControl);
+    HWND hFocus = GetFocus();
+    DWORD selectionStart = 0;
+    DWORD selectionEnd = 0;
+    SendMessage(hEditControl, EM_GETSEL, (WPARAM)&selectionStart, (LPARAM)&selectionEnd);
+    LRESULT firstVisibleLine = SendMessage(hEditControl, EM_GETFIRSTVISIBLELINE, 0, 0);
+    LRESULT firstVisibleOffset = SendMessage(hEditControl, EM_LINEINDEX, (WPARAM)firstVisibleLine, 0);
+    LRESULT limit = SendMessage(hEditControl, EM_GETLIMITTEXT, 0, 0);
+
+    int length = GetWindowTextLengthW(hEditControl);
+    std::wstring text((size_t)length, L'\0');
+    if (length > 0)
+    {
+        GetWindowTextW(hEditControl, &text[0], length + 1);
+    }
+
+    DestroyWindow(hEditControl);
+    hEditControl = NULL;
+    CreateEditControl(hWnd);
+    if (g_pMinimapView)
+    {
+        g_pMinimapView->setTarget(hEditControl);
+    }
+    if (!hEditControl)
+        return;
+
+    SendMessage(hEditControl, EM_SETLIMITTEXT, (WPARAM)limit, 0);
+    SetEditorText(text.c_str());
+    ResizeEditControl(hWnd);
+
+    SendMessage(hEditControl, EM_SETSEL, selectionStart, selectionEnd);
+    LRESULT targetLine = SendMessage(hEditControl, EM_LINEFROMCHAR, (WPARAM)firstVisibleOffset, 0);
+    LRESULT currentLine = SendMessage(hEditControl, EM_GETFIRSTVISIBLELINE, 0, 0);
+    SendMessage(hEditControl, EM_LINESCROLL, 0, targetLine - currentLine);
+
+    if (!wasVisible)
+    {
+        ShowWindow(hEditControl, SW_HIDE);
+    }
+    if (hFocus && IsWindow(hFocus))
+    {
+        SetFocus(hFocus);
     }
 }
 
 // Создание нового файла
 BOOL CreateNewFile(HWND hWnd)
 {
+    StopFollowingFile(hWnd);
+
     // Очищаем содержимое EDIT-контрола
     if (hEditControl)
     {
-        SetWindowTextW(hEditControl, L"");
+        SetEditorText(L"");
     }
     
     // Сбрасываем информацию о текущем файле
     currentFileName[0] = L'\0';
     hasFileName = FALSE;
+    g_documentFormat = DocumentFormat();
+    g_hasDocumentInfo = FALSE;
+    g_documentGeneration++;
     SetFileModified(FALSE);
+    SyncChangeTracker(TRUE);
     
     // Сохраняем состояние "новый файл" в реестре
     if (g_pRegistryManager)
@@ -536,11 +1233,11 @@ BOOL CreateNewFile(HWND hWnd)
     return TRUE;
 }
 
-// Открытие текстового файла
+// Открытие текстовых файлов (каждый в своей вкладке)
 BOOL OpenTextFile(HWND hWnd)
 {
     OPENFILENAME ofn;
-    WCHAR szFile[MAX_PATH] = { 0 };
+    std::vector<WCHAR> fileBuffer(OPEN_FILES_BUFFER_SIZE, L'\0');
     WCHAR titleBuffer[MAX_LOADSTRING];
     
     // Загружаем заголовок из ресурсов
@@ -555,187 +1252,42 @@ BOOL OpenTextFile(HWND hWnd)
     ZeroMemory(&ofn, sizeof(ofn));
     ofn.lStructSize = sizeof(ofn);
     ofn.hwndOwner = hWnd;
-    ofn.lpstrFile = szFile;
-    ofn.nMaxFile = sizeof(szFile);
+    ofn.lpstrFile = &fileBuffer[0];
+    ofn.nMaxFile = OPEN_FILES_BUFFER_SIZE;
     ofn.lpstrFilter = filterBuffer;
     ofn.nFilterIndex = 1;
     ofn.lpstrTitle = titleBuffer;
-    ofn.Flags = OFN_EXPLORER | OFN_FILEMUSTEXIST | OFN_HIDEREADONLY;
+    ofn.Flags = OFN_EXPLORER | OFN_FILEMUSTEXIST | OFN_HIDEREADONLY | OFN_ALLOWMULTISELECT;
 
-    if (GetOpenFileName(&ofn))
+    if (!GetOpenFileName(&ofn))
     {
-        HANDLE hFile = CreateFileW(
-            szFile,
-            GENERIC_READ,
-            FILE_SHARE_READ,
-            NULL,
-            OPEN_EXISTING,
-            FILE_ATTRIBUTE_NORMAL,
-            NULL
-        );
+        return FALSE;
+    }
 
-        if (hFile != INVALID_HANDLE_VALUE)
-        {
-            DWORD fileSize = GetFileSize(hFile, NULL);
-            if (fileSize != INVALID_FILE_SIZE)
-            {
-                // Выделяем память для содержимого файла
-                CHAR* buffer = (CHAR*)malloc(fileSize + 1);
-                if (buffer)
-                {
-                    DWORD bytesRead;
-                    if (ReadFile(hFile, buffer, fileSize, &bytesRead, NULL))
-                    {
-                        buffer[bytesRead] = '\0';
-                        
-                        // Определяем кодировку файла
-                        UINT codePage = CP_UTF8; // По умолчанию UTF-8
-                        
-                        // Проверяем BOM для UTF-8
-                        if (bytesRead >= 3 && 
-                            (unsigned char)buffer[0] == 0xEF && 
-                            (unsigned char)buffer[1] == 0xBB && 
-                            (unsigned char)buffer[2] == 0xBF)
-                        {
-                            codePage = CP_UTF8;
-                            // Пропускаем BOM
-                            memmove(buffer, buffer + 3, bytesRead - 3);
-                            buffer[bytesRead - 3] = '\0';
-                        }
-                        // Проверяем BOM для UTF-16 LE
-                        else if (bytesRead >= 2 && 
-                                 (unsigned char)buffer[0] == 0xFF && 
-                                 (unsigned char)buffer[1] == 0xFE)
-                        {
-                            // Файл уже в UTF-16 LE, читаем напрямую
-                            WCHAR* wideBuffer = (WCHAR*)buffer;
-                            SetWindowTextW(hEditControl, wideBuffer);
-                            
-                            // Сохраняем имя файла
-                            wcscpy_s(currentFileName, MAX_PATH, szFile);
-                            hasFileName = TRUE;
-                            SetFileModified(FALSE);
-                            
-                            // Сохраняем состояние "файл открыт" в реестре
-                            if (g_pRegistryManager)
-                            {
-                                g_pRegistryManager->SaveLastFileState(TRUE);
-                            }
-                            
-                            UpdateWindowTitle(hWnd);
-                            
-                            free(buffer);
-                            CloseHandle(hFile);
-                            return TRUE;
-                        }
-                        // Проверяем BOM для UTF-16 BE
-                        else if (bytesRead >= 2 && 
-                                 (unsigned char)buffer[0] == 0xFE && 
-                                 (unsigned char)buffer[1] == 0xFF)
-                        {
-                            // Конвертируем UTF-16 BE в UTF-16 LE
-                            for (DWORD i = 0; i < bytesRead - 1; i += 2)
-                            {
-                                char temp = buffer[i];
-                                buffer[i] = buffer[i + 1];
-                                buffer[i + 1] = temp;
-                            }
-                            WCHAR* wideBuffer = (WCHAR*)buffer;
-                            SetWindowTextW(hEditControl, wideBuffer);
-                            
-                            // Сохраняем имя файла
-                            wcscpy_s(currentFileName, MAX_PATH, szFile);
-                            hasFileName = TRUE;
-                            SetFileModified(FALSE);
-                            
-                            // Сохраняем состояние "файл открыт" в реестре
-                            if (g_pRegistryManager)
-                            {
-                                g_pRegistryManager->SaveLastFileState(TRUE);
-                            }
-                            
-                            UpdateWindowTitle(hWnd);
-                            
-                            free(buffer);
-                            CloseHandle(hFile);
-                            return TRUE;
-                        }
-                        // Пробуем определить кодировку по содержимому
-                        else
-                        {
-                            // Сначала пробуем UTF-8
-                            int wideSize = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, buffer, -1, NULL, 0);
-                            if (wideSize > 0)
-                            {
-                                codePage = CP_UTF8;
-                            }
-                            else
-                            {
-                                // Если не UTF-8, пробуем системную кодировку (обычно CP1251 для русского)
-                                wideSize = MultiByteToWideChar(CP_ACP, 0, buffer, -1, NULL, 0);
-                                if (wideSize > 0)
-                                {
-                                    codePage = CP_ACP;
-                                }
-                                else
-                                {
-                                    // Последняя попытка - CP1252 (Latin-1)
-                                    codePage = 1252;
-                                }
-                            }
-                        }
-                        
-                        // Конвертируем в Unicode
-                        int wideSize = MultiByteToWideChar(codePage, 0, buffer, -1, NULL, 0);
-                        WCHAR* wideBuffer = (WCHAR*)malloc(wideSize * sizeof(WCHAR));
-                        if (wideBuffer)
-                        {
-                            MultiByteToWideChar(codePage, 0, buffer, -1, wideBuffer, wideSize);
-                            
-                            // Устанавливаем текст в EDIT-контрол
-                            SetWindowTextW(hEditControl, wideBuffer);
-                            
-                            // Сохраняем имя файла
-                            wcscpy_s(currentFileName, MAX_PATH, szFile);
-                            hasFileName = TRUE;
-                            SetFileModified(FALSE);
-                            
-                            // Сохраняем состояние "файл открыт" в реестре
-                            if (g_pRegistryManager)
-                            {
-                                g_pRegistryManager->SaveLastFileState(TRUE);
-                            }
-                            
-                            UpdateWindowTitle(hWnd);
-                            
-                            free(wideBuffer);
-                        }
-                    }
-                    free(buffer);
-                }
-            }
-            CloseHandle(hFile);
-            return TRUE;
-        }
-        else
+    // При выборе нескольких файлов буфер содержит папку и затем имена файлов
+    std::vector<std::wstring> paths;
+    const WCHAR* directory = &fileBuffer[0];
+    const WCHAR* name = directory + wcslen(directory) + 1;
+    if (*name == L'\0')
+    {
+        paths.push_back(directory);
+    }
+    for (; *name != L'\0'; name += wcslen(name) + 1)
+    {
+        std::wstring path = std::wstring(directory) + L"\\" + name;
+        if (path.length() < MAX_PATH)
         {
-            MessageBoxW(hWnd, L"Не удалось открыть файл", L"Ошибка", MB_OK | MB_ICONERROR);
+            paths.push_back(path);
         }
     }
-    return FALSE;
+
+    OpenDocuments(hWnd, paths);
+    return TRUE;
 }
 
-// Загрузка содержимого файла без диалога выбора
-BOOL LoadFileContent(const WCHAR* filePath)
+// Чтение файла с определением кодировки и перекодированием в Unicode
+BOOL ReadTextFile(const WCHAR* filePath, std::wstring& text, DocumentFormat& format, ULONGLONG& contentHash)
 {
-    if (!hEditControl || !filePath || wcslen(filePath) == 0)
-        return FALSE;
-    
-    // Проверяем существование файла
-    DWORD fileAttributes = GetFileAttributesW(filePath);
-    if (fileAttributes == INVALID_FILE_ATTRIBUTES || (fileAttributes & FILE_ATTRIBUTE_DIRECTORY))
-        return FALSE;
-
     HANDLE hFile = CreateFileW(
         filePath,
         GENERIC_READ,
@@ -746,215 +1298,277 @@ BOOL LoadFileContent(const WCHAR* filePath)
         NULL
     );
 
-    if (hFile != INVALID_HANDLE_VALUE)
+    if (hFile == INVALID_HANDLE_VALUE)
+        return FALSE;
+
+    DWORD fileSize = GetFileSize(hFile, NULL);
+    if (fileSize == INVALID_FILE_SIZE)
     {
-        DWORD fileSize = GetFileSize(hFile, NULL);
-        if (fileSize != INVALID_FILE_SIZE)
-        {
-            // Выделяем память для содержимого файла
-            CHAR* buffer = (CHAR*)malloc(fileSize + 1);
-            if (buffer)
+        CloseHandle(hFile);
+        return FALSE;
+    }
+
+    // Выделяем память для содержимого файла
+    CHAR* buffer = (CHAR*)malloc(fileSize + 1);
+    if (!buffer)
+    {
+        CloseHandle(hFile);
+        return FALSE;
+    }
+
+    DWORD bytesRead = 0;
+    BOOL success = ReadFile(hFile, buffer, fileSize, &bytesRead, NULL);
+    CloseHandle(hFile);
+    if (!success)
+    {
+        free(buffer);
+        return FALSE;
+    }
+    buffer[bytesRead] = '\0';
+
+    // Хеш исходных байтов нужен для проверки снимка сеанса
+    contentHash = ContentHash::compute(buffer, bytesRead);
+    text.clear();
+
+    // Кодировка определяется по выборке блоков файла (BOM, UTF-8, UTF-16, однобайтовые)
+    EncodingDetector::Result detected = EncodingDetector::detect(buffer, bytesRead);
+    UINT codePage = detected.codePage;
+    format.hasBom = detected.bomLength > 0;
+    const unsigned char* bytes = (const unsigned char*)buffer + detected.bomLength;
+    size_t dataLength = bytesRead - detected.bomLength;
+    // Переводы строк считаются прямо в байтах: по ним строка сразу получает
+    // окончательный размер, и приведение к CRLF не требует второй копии текста
+    LineEndingScanner::Counts lineEndings = LineEndingScanner::scan(
+        bytes, dataLength, (codePage == 1200 || codePage == 1201) ? 2 : 1, codePage == 1201);
+    size_t expansion = (size_t)LineEndingScanner::expansion(lineEndings);
+    if (codePage == 1200 || codePage == 1201)
+    {
+        BOOL isBigEndian = (codePage == 1201);
+        text.reserve(dataLength / 2 + expansion);
+        text.resize(dataLength / 2);
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            const unsigned char* unit = bytes + i * 2;
+            text[i] = isBigEndian ? (WCHAR)((unit[0] << 8) | unit[1]) : (WCHAR)((unit[1] << 8) | unit[0]);
+        }
+    }
+    else if (dataLength > 0)
+    {
+        // UTF-8 проверен только по выборке: если в непросмотренной части есть
+        // некорректные последовательности, берем лучшую однобайтовую кодировку
+        const CHAR* data = (const CHAR*)bytes;
+        int dataSize = (int)dataLength;
+        int wideSize = 0;
+        if (codePage == CP_UTF8)
+        {
+            wideSize = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, data, dataSize, NULL, 0);
+            if (wideSize == 0 && detected.bomLength == 0)
             {
-                DWORD bytesRead;
-                if (ReadFile(hFile, buffer, fileSize, &bytesRead, NULL))
-                {
-                    buffer[bytesRead] = '\0';
-                    
-                    // Определяем кодировку файла
-                    UINT codePage = CP_UTF8; // По умолчанию UTF-8
-                    
-                    // Проверяем BOM для UTF-8
-                    if (bytesRead >= 3 && 
-                        (unsigned char)buffer[0] == 0xEF && 
-                        (unsigned char)buffer[1] == 0xBB && 
-                        (unsigned char)buffer[2] == 0xBF)
-                    {
-                        codePage = CP_UTF8;
-                        // Пропускаем BOM
-                        memmove(buffer, buffer + 3, bytesRead - 3);
-                        buffer[bytesRead - 3] = '\0';
-                    }
-                    // Проверяем BOM для UTF-16 LE
-                    else if (bytesRead >= 2 && 
-                             (unsigned char)buffer[0] == 0xFF && 
-                             (unsigned char)buffer[1] == 0xFE)
-                    {
-                        // Файл уже в UTF-16 LE, читаем напрямую
-                        WCHAR* wideBuffer = (WCHAR*)buffer;
-                        SetWindowTextW(hEditControl, wideBuffer);
-                        
-                        free(buffer);
-                        CloseHandle(hFile);
-                        return TRUE;
-                    }
-                    // Проверяем BOM для UTF-16 BE
-                    else if (bytesRead >= 2 && 
-                             (unsigned char)buffer[0] == 0xFE && 
-                             (unsigned char)buffer[1] == 0xFF)
-                    {
-                        // Конвертируем UTF-16 BE в UTF-16 LE
-                        for (DWORD i = 0; i < bytesRead - 1; i += 2)
-                        {
-                            char temp = buffer[i];
-                            buffer[i] = buffer[i + 1];
-                            buffer[i + 1] = temp;
-                        }
-                        WCHAR* wideBuffer = (WCHAR*)buffer;
-                        SetWindowTextW(hEditControl, wideBuffer);
-                        
-                        free(buffer);
-                        CloseHandle(hFile);
-                        return TRUE;
-                    }
-                    // Пробуем определить кодировку по содержимому
-                    else
-                    {
-                        // Сначала пробуем UTF-8
-                        int wideSize = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, buffer, -1, NULL, 0);
-                        if (wideSize > 0)
-                        {
-                            codePage = CP_UTF8;
-                        }
-                        else
-                        {
-                            // Если не UTF-8, пробуем системную кодировку (обычно CP1251 для русского)
-                            wideSize = MultiByteToWideChar(CP_ACP, 0, buffer, -1, NULL, 0);
-                            if (wideSize > 0)
-                            {
-                                codePage = CP_ACP;
-                            }
-                            else
-                            {
-                                // Последняя попытка - CP1252 (Latin-1)
-                                codePage = 1252;
-                            }
-                        }
-                    }
-                    
-                    // Конвертируем в Unicode
-                    int wideSize = MultiByteToWideChar(codePage, 0, buffer, -1, NULL, 0);
-                    WCHAR* wideBuffer = (WCHAR*)malloc(wideSize * sizeof(WCHAR));
-                    if (wideBuffer)
-                    {
-                        MultiByteToWideChar(codePage, 0, buffer, -1, wideBuffer, wideSize);
-                        
-                        // Устанавливаем текст в EDIT-контрол
-                        SetWindowTextW(hEditControl, wideBuffer);
-                        
-                        free(wideBuffer);
-                    }
-                }
-                free(buffer);
+                codePage = detected.fallbackCodePage;
             }
         }
-        CloseHandle(hFile);
-        return TRUE;
+        if (wideSize == 0)
+        {
+            wideSize = MultiByteToWideChar(codePage, 0, data, dataSize, NULL, 0);
+        }
+        if (wideSize > 0)
+        {
+            text.reserve(wideSize + expansion);
+            text.resize(wideSize);
+            MultiByteToWideChar(codePage, 0, data, dataSize, &text[0], wideSize);
+        }
     }
+    free(buffer);
+    LineEndingScanner::normalize(text, lineEndings);
+
+    // Формат запоминается, чтобы сохранить файл в том же виде
+    format.codePage = codePage;
+    format.lineEnding = LineEndingScanner::dominant(lineEndings);
+    return TRUE;
+}
+
+// Загрузка содержимого файла без диалога выбора
+BOOL LoadFileContent(const WCHAR* filePath)
+{
+    if (!hEditControl || !filePath || wcslen(filePath) == 0)
+        return FALSE;
     
-    return FALSE;
+    // Проверяем существование файла
+    DWORD fileAttributes = GetFileAttributesW(filePath);
+    if (fileAttributes == INVALID_FILE_ATTRIBUTES || (fileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+        return FALSE;
+
+    std::wstring text;
+    DocumentFormat format;
+    ULONGLONG contentHash = 0;
+    if (!ReadTextFile(filePath, text, format, contentHash))
+        return FALSE;
+
+    // Устанавливаем текст в EDIT-контрол
+    SetEditorText(text.c_str());
+    RememberDocumentFile(format, contentHash);
+    return TRUE;
 }
 
 // Сохранение текстового файла
 BOOL SaveTextFile(HWND hWnd)
 {
+    if (g_pActiveViewer)
+    {
+        MessageBoxW(hWnd, L"Большой файл открыт только для просмотра.", L"Сохранение", MB_OK | MB_ICONINFORMATION);
+        return FALSE;
+    }
+
     if (!hasFileName)
     {
         return SaveTextFileAs(hWnd);
     }
 
-    // Получаем текст из EDIT-контрола
-    int textLength = GetWindowTextLengthW(hEditControl);
-    WCHAR* textBuffer = (WCHAR*)malloc((textLength + 1) * sizeof(WCHAR));
-    if (!textBuffer)
+    // Чужие изменения файла не затираются без подтверждения
+    if (IsFileChangedOnDisk() &&
+        MessageBoxW(hWnd, L"Файл был изменен другой программой.\n\nПерезаписать его?",
+                    L"Сохранение", MB_YESNO | MB_ICONWARNING) != IDYES)
     {
-        MessageBoxW(hWnd, L"Недостаточно памяти", L"Ошибка", MB_OK | MB_ICONERROR);
         return FALSE;
     }
 
-    GetWindowTextW(hEditControl, textBuffer, textLength + 1);
+    if (!g_pChangeTracker)
+        return FALSE;
 
-    // Определяем кодировку для сохранения на основе расширения файла
-    UINT saveCodePage = CP_UTF8; // По умолчанию UTF-8
-    
-    // Получаем расширение файла
-    WCHAR* fileExt = wcsrchr(currentFileName, L'.');
-    if (fileExt)
-    {
-        // Для текстовых и кодовых файлов используем UTF-8
-        if (_wcsicmp(fileExt, L".txt") == 0 ||
-            _wcsicmp(fileExt, L".c") == 0 ||
-            _wcsicmp(fileExt, L".cpp") == 0 ||
-            _wcsicmp(fileExt, L".h") == 0 ||
-            _wcsicmp(fileExt, L".hpp") == 0 ||
-            _wcsicmp(fileExt, L".cs") == 0 ||
-            _wcsicmp(fileExt, L".java") == 0 ||
-            _wcsicmp(fileExt, L".js") == 0 ||
-            _wcsicmp(fileExt, L".html") == 0 ||
-            _wcsicmp(fileExt, L".css") == 0 ||
-            _wcsicmp(fileExt, L".xml") == 0 ||
-            _wcsicmp(fileExt, L".json") == 0 ||
-            _wcsicmp(fileExt, L".py") == 0 ||
-            _wcsicmp(fileExt, L".php") == 0 ||
-            _wcsicmp(fileExt, L".rb") == 0 ||
-            _wcsicmp(fileExt, L".pl") == 0 ||
-            _wcsicmp(fileExt, L".sh") == 0)
-        {
-            saveCodePage = CP_UTF8;
-        }
-        // Для других файлов используем системную кодировку
-        else
+    // Текст кодируется по блокам прямо в файл, без копии всего документа
+    std::vector<wchar_t> table;
+    if (g_documentFormat.codePage != CP_UTF8 && g_documentFormat.codePage != 1200 && g_documentFormat.codePage != 1201)
+    {
+        BuildSingleByteTable(g_documentFormat.codePage, table);
+    }
+    const ChunkedText& text = g_pChangeTracker->text();
+    TextEncoder encoder(g_documentFormat, table);
+    TextEncoder::Measure measured = encoder.measure(text);
+
+    // Символы, которых нет в однобайтовой кодировке, без спроса не теряются
+    if (measured.unmappableCount > 0)
+    {
+        WCHAR message[512];
+        swprintf_s(message, 512,
+                   L"Символов, которых нет в кодировке %s: %llu. Они будут заменены на \"?\".\n\nСохранить файл в UTF-8?",
+                   GetEncodingName(g_documentFormat).c_str(), (unsigned long long)measured.unmappableCount);
+        int answer = MessageBoxW(hWnd, message, L"Сохранение", MB_YESNOCANCEL | MB_ICONWARNING);
+        if (answer == IDCANCEL)
+        {
+            return FALSE;
+        }
+        if (answer == IDYES)
         {
-            saveCodePage = CP_ACP;
+            g_documentFormat.codePage = CP_UTF8;
+            g_documentFormat.hasBom = false;
+            encoder = TextEncoder(g_documentFormat, table);
+            measured = encoder.measure(text);
         }
     }
-    
-    // Конвертируем в выбранную кодировку
-    int bufferSize = WideCharToMultiByte(saveCodePage, 0, textBuffer, -1, NULL, 0, NULL, NULL);
-    CHAR* saveBuffer = (CHAR*)malloc(bufferSize);
-    if (!saveBuffer)
+
+    uint64_t contentHash = 0;
+    if (!encoder.writeFile(currentFileName, text, measured, contentHash))
     {
-        free(textBuffer);
-        MessageBoxW(hWnd, L"Недостаточно памяти", L"Ошибка", MB_OK | MB_ICONERROR);
+        MessageBoxW(hWnd, L"Ошибка при записи файла", L"Ошибка", MB_OK | MB_ICONERROR);
         return FALSE;
     }
 
-    WideCharToMultiByte(saveCodePage, 0, textBuffer, -1, saveBuffer, bufferSize, NULL, NULL);
+    SetFileModified(FALSE);
+    UpdateWindowTitle(hWnd);
 
-    // Создаем/перезаписываем файл
-    HANDLE hFile = CreateFileW(
-        currentFileName,
-        GENERIC_WRITE,
-        0,
-        NULL,
-        CREATE_ALWAYS,
-        FILE_ATTRIBUTE_NORMAL,
-        NULL
-    );
+    // Сохраненный текст становится новой точкой восстановления
+    if (g_pEditJournal)
+    {
+        g_pEditJournal->setDocumentPath(currentFileName);
+        g_pEditJournal->markSaved(text);
+    }
+
+    // Запоминаем записанную версию файла (после закрытия, когда время изменения окончательное)
+    RememberDocumentFile(g_documentFormat, contentHash);
 
-    BOOL success = FALSE;
-    if (hFile != INVALID_HANDLE_VALUE)
+    // Слежение продолжается с конца записанного файла
+    if (g_pFileWatcher)
     {
-        DWORD bytesWritten;
-        if (WriteFile(hFile, saveBuffer, (DWORD)strlen(saveBuffer), &bytesWritten, NULL))
-        {
-            SetFileModified(FALSE);
-            UpdateWindowTitle(hWnd);
-            success = TRUE;
-        }
-        else
-        {
-            MessageBoxW(hWnd, L"Ошибка при записи файла", L"Ошибка", MB_OK | MB_ICONERROR);
-        }
-        CloseHandle(hFile);
+        StopFollowingFile(hWnd);
+        StartFollowingFile(hWnd);
     }
-    else
+    return TRUE;
+}
+
+// Сохранение в кодировке, выбранной в меню
+BOOL SaveTextFileWithEncoding(HWND hWnd, int commandId)
+{
+    if (g_pActiveViewer)
+    {
+        return SaveTextFile(hWnd);
+    }
+
+    DocumentFormat previous = g_documentFormat;
+    g_documentFormat.hasBom = false;
+    switch (commandId)
+    {
+    case IDM_FILE_SAVE_UTF8_BOM:
+        g_documentFormat.codePage = CP_UTF8;
+        g_documentFormat.hasBom = true;
+        break;
+    case IDM_FILE_SAVE_UTF16LE:
+        g_documentFormat.codePage = 1200;
+        g_documentFormat.hasBom = true;
+        break;
+    case IDM_FILE_SAVE_UTF16BE:
+        g_documentFormat.codePage = 1201;
+        g_documentFormat.hasBom = true;
+        break;
+    case IDM_FILE_SAVE_1251:
+        g_documentFormat.codePage = 1251;
+        break;
+    case IDM_FILE_SAVE_KOI8R:
+        g_documentFormat.codePage = 20866;
+        break;
+    case IDM_FILE_SAVE_866:
+        g_documentFormat.codePage = 866;
+        break;
+    case IDM_FILE_SAVE_1252:
+        g_documentFormat.codePage = 1252;
+        break;
+    default:
+        g_documentFormat.codePage = CP_UTF8;
+        break;
+    }
+
+    // Файл перезаписывается, даже если текст не изменялся
+    BOOL saved = hasFileName ? SaveTextFile(hWnd) : SaveTextFileAs(hWnd);
+    if (!saved)
+    {
+        g_documentFormat = previous;
+    }
+    return saved;
+}
+
+// Название кодировки для сообщений
+std::wstring GetEncodingName(const DocumentFormat& format)
+{
+    switch (format.codePage)
     {
-        MessageBoxW(hWnd, L"Не удалось создать файл", L"Ошибка", MB_OK | MB_ICONERROR);
+    case CP_UTF8:
+        return format.hasBom ? L"UTF-8 с BOM" : L"UTF-8";
+    case 1200:
+        return L"UTF-16 LE";
+    case 1201:
+        return L"UTF-16 BE";
+    case 1251:
+        return L"Windows-1251";
+    case 20866:
+        return L"KOI8-R";
+    case 866:
+        return L"CP866";
+    case 1252:
+        return L"Windows-1252";
     }
 
-    free(textBuffer);
-    free(saveBuffer);
-    return success;
+    WCHAR name[64];
+    swprintf_s(name, 64, L"кодовая страница %u", format.codePage);
+    return name;
 }
 
 // Сохранение файла с выбором имени
@@ -964,6 +1578,11 @@ BOOL SaveTextFileAs(HWND hWnd)
     WCHAR szFile[MAX_PATH] = { 0 };
     WCHAR titleBuffer[MAX_LOADSTRING];
 
+    if (g_pActiveViewer)
+    {
+        return SaveTextFile(hWnd);
+    }
+
     // Если есть текущее имя файла, используем его
     if (hasFileName)
     {
@@ -1009,7 +1628,7 @@ BOOL SaveTextFileAs(HWND hWnd)
 // Вырезание текста
 void CutText()
 {
-    if (hEditControl)
+    if (hEditControl && !g_pActiveViewer)
     {
         SendMessage(hEditControl, WM_CUT, 0, 0);
     }
@@ -1018,24 +1637,374 @@ void CutText()
 // Копирование текста
 void CopyText()
 {
-    if (hEditControl)
+    if (!hEditControl)
+        return;
+
+    // Большое выделение публикуется с отложенной отрисовкой: в буфер обмена
+    // заносится только формат, а текст собирается из снимка по запросу
+    DWORD selectionStart = 0;
+    DWORD selectionEnd = 0;
+    SendMessage(hEditControl, EM_GETSEL, (WPARAM)&selectionStart, (LPARAM)&selectionEnd);
+    if (g_pActiveViewer || !g_pChangeTracker || selectionEnd - selectionStart < DELAYED_COPY_THRESHOLD ||
+        g_pChangeTracker->text().length() != (size_t)GetWindowTextLengthW(hEditControl))
     {
         SendMessage(hEditControl, WM_COPY, 0, 0);
+        return;
+    }
+
+    if (!OpenClipboard(hMainWnd))
+        return;
+
+    // EmptyClipboard удаляет прежний снимок через WM_DESTROYCLIPBOARD
+    EmptyClipboard();
+    g_pClipboardSnapshot = new SelectionSnapshot(g_pChangeTracker->text(), selectionStart,
+                                                 selectionEnd - selectionStart);
+    SetClipboardData(CF_UNICODETEXT, NULL);
+    CloseClipboard();
+}
+
+// Сборка скопированного текста из снимка в буфере обмена (буфер обмена открыт)
+BOOL RenderClipboardSnapshot()
+{
+    if (!g_pClipboardSnapshot)
+        return FALSE;
+
+    HGLOBAL hData = GlobalAlloc(GMEM_MOVEABLE, (g_pClipboardSnapshot->length() + 1) * sizeof(WCHAR));
+    WCHAR* data = hData ? (WCHAR*)GlobalLock(hData) : NULL;
+    if (!data)
+    {
+        if (hData)
+        {
+            GlobalFree(hData);
+        }
+        return FALSE;
     }
+    g_pClipboardSnapshot->copyTo(data);
+    GlobalUnlock(hData);
+
+    if (!SetClipboardData(CF_UNICODETEXT, hData))
+    {
+        GlobalFree(hData);
+        return FALSE;
+    }
+    return TRUE;
 }
 
 // Вставка текста
 void PasteText()
 {
-    if (hEditControl)
+    if (hEditControl && !g_pActiveViewer && !g_pPasteJob)
+    {
+        // Большой фрагмент перекодируется в фоне, небольшой вставляет сам EDIT-контрол
+        if (!StartStreamingPaste(hMainWnd))
+        {
+            SendMessage(hEditControl, WM_PASTE, 0, 0);
+        }
+    }
+}
+
+// Вставка большого фрагмента из буфера обмена
+struct PasteJob
+{
+    std::thread worker;                 // Поток перекодирования вставки
+    std::atomic<bool> isCancelled;      // Флаг отмены
+    UINT format;                        // CF_UNICODETEXT, CF_TEXT или CF_OEMTEXT
+    UINT codePage;                      // Кодовая страница для CF_TEXT и CF_OEMTEXT
+    HANDLE hClipboardData;              // Данные буфера обмена (заблокированы, буфер открыт)
+    const void* source;                 // Вставляемый текст
+    size_t sourceSize;                  // Размер текста в единицах формата (без нуля)
+    size_t start;                       // Начало заменяемого выделения
+    size_t end;                         // Конец заменяемого выделения
+    std::unique_ptr<WCHAR[]> inserted;  // Вставка в UTF-16 с переводами строк CRLF
+    size_t insertedLength;              // Длина вставки после приведения переводов строк
+    BOOL isBuilt;                       // Вставка собрана
+
+    PasteJob() : isCancelled(false), format(0), codePage(CP_ACP), hClipboardData(NULL), source(NULL),
+        sourceSize(0), start(0), end(0), insertedLength(0), isBuilt(FALSE)
+    {
+    }
+};
+
+// Кодовая страница текста CF_TEXT или CF_OEMTEXT по языку из CF_LOCALE
+UINT GetClipboardCodePage(UINT format)
+{
+    UINT codePage = (format == CF_OEMTEXT) ? GetOEMCP() : GetACP();
+    HANDLE hLocale = GetClipboardData(CF_LOCALE);
+    const LCID* locale = hLocale ? (const LCID*)GlobalLock(hLocale) : NULL;
+    if (locale)
+    {
+        DWORD value = 0;
+        LCTYPE type = (format == CF_OEMTEXT) ? LOCALE_IDEFAULTCODEPAGE : LOCALE_IDEFAULTANSICODEPAGE;
+        if (GetLocaleInfoW(*locale, type | LOCALE_RETURN_NUMBER, (LPWSTR)&value, sizeof(value) / sizeof(WCHAR)) &&
+            value != 0 && IsValidCodePage(value))
+        {
+            codePage = value;
+        }
+        GlobalUnlock(hLocale);
+    }
+    return codePage;
+}
+
+// Запуск фоновой вставки, если текст в буфере обмена большой
+BOOL StartStreamingPaste(HWND hWnd)
+{
+    if (!OpenClipboard(hWnd))
+        return FALSE;
+
+    // Берем формат, в котором текст был помещен в буфер: запрос другого
+    // формата заставил бы систему создать полную перекодированную копию
+    UINT format = 0;
+    for (UINT next = EnumClipboardFormats(0); next != 0 && format == 0; next = EnumClipboardFormats(next))
+    {
+        if (next == CF_UNICODETEXT || next == CF_TEXT || next == CF_OEMTEXT)
+        {
+            format = next;
+        }
+    }
+    HANDLE hData = format ? GetClipboardData(format) : NULL;
+    SIZE_T dataSize = hData ? GlobalSize(hData) : 0;
+    const void* data = (dataSize >= STREAMING_PASTE_THRESHOLD) ? GlobalLock(hData) : NULL;
+    if (!data)
+    {
+        CloseClipboard();
+        return FALSE;
+    }
+
+    PasteJob* job = new PasteJob();
+    job->format = format;
+    job->hClipboardData = hData;
+    job->source = data;
+    if (format == CF_UNICODETEXT)
+    {
+        const WCHAR* text = (const WCHAR*)data;
+        const WCHAR* terminator = wmemchr(text, L'\0', dataSize / sizeof(WCHAR));
+        job->sourceSize = terminator ? (size_t)(terminator - text) : dataSize / sizeof(WCHAR);
+    }
+    else
+    {
+        const char* text = (const char*)data;
+        const char* terminator = (const char*)memchr(text, '\0', dataSize);
+        job->sourceSize = terminator ? (size_t)(terminator - text) : dataSize;
+        job->codePage = GetClipboardCodePage(format);
+    }
+
+    DWORD selectionStart = 0;
+    DWORD selectionEnd = 0;
+    SendMessage(hEditControl, EM_GETSEL, (WPARAM)&selectionStart, (LPARAM)&selectionEnd);
+    job->start = selectionStart;
+    job->end = selectionEnd;
+
+    // Фоновый поток читает данные прямо из заблокированного блока буфера
+    // обмена, поэтому буфер остается открытым до конца перекодирования:
+    // пока он открыт, другая программа не может очистить его и освободить
+    // блок. Главное окно остается доступным: Esc, закрытие окна и выход
+    // отменяют вставку, остальные команды не выполняются до ее завершения
+    g_pPasteJob = job;
+    EnableWindow(hEditControl, FALSE);
+    EnableWindow(hTabControl, FALSE);
+    SetFocus(hWnd);
+    job->worker = std::thread(BuildPastedText, job);
+    return TRUE;
+}
+
+// Граница куска байтов, не разрезающая многобайтовый символ
+size_t FindTextChunkEnd(const char* text, size_t size, UINT codePage)
+{
+    if (size <= ChunkedPaste::CHUNK_SIZE)
+        return size;
+
+    // Байт 0x0A не бывает частью многобайтового символа
+    const char* lineFeed = NULL;
+    for (size_t i = ChunkedPaste::CHUNK_SIZE; i > 0 && !lineFeed; --i)
+    {
+        if (text[i - 1] == '\n')
+        {
+            lineFeed = text + i;
+        }
+    }
+    if (lineFeed)
+        return (size_t)(lineFeed - text);
+
+    size_t position = 0;
+    if (codePage == CP_UTF8)
+    {
+        position = ChunkedPaste::CHUNK_SIZE;
+        while (position > 0 && ((unsigned char)text[position] & 0xC0) == 0x80)
+        {
+            --position;
+        }
+        return position > 0 ? position : ChunkedPaste::CHUNK_SIZE;
+    }
+    while (position < ChunkedPaste::CHUNK_SIZE)
+    {
+        size_t step = IsDBCSLeadByteEx(codePage, (BYTE)text[position]) ? 2 : 1;
+        if (position + step > ChunkedPaste::CHUNK_SIZE)
+            break;
+        position += step;
+    }
+    return position;
+}
+
+// Перекодирование вставки по кускам (выполняется в фоновом потоке)
+void BuildPastedText(PasteJob* job)
+{
+    HWND hWnd = hMainWnd;
+    UINT lastPercent = 0;
+    ChunkedPaste::Progress progress = [job, hWnd, &lastPercent](size_t done, size_t total)
+    {
+        UINT percent = total ? (UINT)((unsigned long long)done * 100 / total) : 100;
+        if (percent != lastPercent)
+        {
+            lastPercent = percent;
+            PostMessage(hWnd, WM_APP_PASTE_PROGRESS, percent, 0);
+        }
+        return !job->isCancelled.load();
+    };
+
+    // Длина вставки в UTF-16 известна заранее, а для CF_TEXT и CF_OEMTEXT
+    // оценивается сверху: символов не больше, чем байтов, а байты 0x0A и
+    // 0x0D встречаются только в переводах строк
+    size_t bound = 0;
+    if (job->format == CF_UNICODETEXT)
+    {
+        bound = ChunkedPaste::measure((const WCHAR*)job->source, job->sourceSize);
+    }
+    else
+    {
+        LineEndingScanner::Counts counts = LineEndingScanner::scan((const char*)job->source, job->sourceSize, 1, false);
+        bound = job->sourceSize + (size_t)LineEndingScanner::expansion(counts);
+    }
+    job->inserted.reset(new (std::nothrow) WCHAR[bound + 1]);
+    if (job->inserted)
+    {
+        ChunkedPaste paste(job->inserted.get(), bound);
+        bool isBuilt = progress(0, job->sourceSize);
+        if (job->format == CF_UNICODETEXT)
+        {
+            const WCHAR* text = (const WCHAR*)job->source;
+            for (size_t offset = 0; isBuilt && offset < job->sourceSize; )
+            {
+                size_t count = job->sourceSize - offset;
+                if (count > ChunkedPaste::CHUNK_SIZE)
+                {
+                    count = ChunkedPaste::CHUNK_SIZE;
+                }
+                isBuilt = paste.append(text + offset, count);
+                offset += count;
+                isBuilt = isBuilt && progress(offset, job->sourceSize);
+            }
+        }
+        else
+        {
+            // Куски перекодируются во временный буфер и сразу дописываются
+            const char* text = (const char*)job->source;
+            std::vector<WCHAR> chunk(ChunkedPaste::CHUNK_SIZE);
+            for (size_t offset = 0; isBuilt && offset < job->sourceSize; )
+            {
+                size_t count = FindTextChunkEnd(text + offset, job->sourceSize - offset, job->codePage);
+                int length = MultiByteToWideChar(job->codePage, 0, text + offset, (int)count,
+                                                 chunk.data(), (int)chunk.size());
+                isBuilt = (length > 0 || count == 0) && paste.append(chunk.data(), (size_t)length);
+                offset += count;
+                isBuilt = isBuilt && progress(offset, job->sourceSize);
+            }
+        }
+
+        if (isBuilt)
+        {
+            job->insertedLength = paste.length();
+            job->inserted[paste.length()] = L'\0';
+        }
+        job->isBuilt = isBuilt ? TRUE : FALSE;
+    }
+
+    if (!job->isCancelled)
+    {
+        PostMessage(hWnd, WM_APP_PASTE_DONE, 0, 0);
+    }
+}
+
+// Завершение фоновой вставки: вставка заменяет выделение одной отменяемой правкой
+void FinishStreamingPaste(HWND hWnd, BOOL apply)
+{
+    PasteJob* job = g_pPasteJob;
+    if (!apply)
+    {
+        job->isCancelled = true;
+    }
+    if (job->worker.joinable())
+    {
+        job->worker.join();
+    }
+    g_pPasteJob = nullptr;
+
+    // Исходные данные больше не нужны: буфер обмена освобождается для других программ
+    GlobalUnlock(job->hClipboardData);
+    CloseClipboard();
+
+    // Текст, дописанный в файл за время вставки, читается после нее
+    if (g_isFollowDeferred)
+    {
+        g_isFollowDeferred = FALSE;
+        PostMessage(hWnd, WM_APP_FILE_APPENDED, g_documentGeneration, 0);
+    }
+
+    EnableWindow(hEditControl, TRUE);
+    EnableWindow(hTabControl, TRUE);
+
+    if (!apply || !job->isBuilt)
+    {
+        if (apply)
+        {
+            MessageBoxW(hWnd, L"Недостаточно памяти для вставки текста.", L"Ошибка", MB_OK | MB_ICONERROR);
+        }
+        UpdateWindowTitle(hWnd);
+        delete job;
+        return;
+    }
+
+    // Текст и так длиннее прежнего предела, поэтому предел снимается
+    size_t documentLength = (size_t)GetWindowTextLengthW(hEditControl);
+    size_t newLength = job->start + job->insertedLength + (documentLength - job->end);
+    if ((size_t)SendMessage(hEditControl, EM_GETLIMITTEXT, 0, 0) < newLength)
+    {
+        SendMessage(hEditControl, EM_SETLIMITTEXT, 0, 0);
+    }
+
+    // EM_REPLACESEL с флагом отмены: вставку, как и небольшую через WM_PASTE,
+    // отменяет Ctrl+Z
+    ResetSelections();
+    g_isReplacingText = TRUE;
+    SendMessage(hEditControl, EM_SETSEL, (WPARAM)job->start, (LPARAM)job->end);
+    SendMessage(hEditControl, EM_REPLACESEL, TRUE, (LPARAM)job->inserted.get());
+    g_isReplacingText = FALSE;
+    SetFocus(hEditControl);
+
+    // Правка передается теневой копии напрямую, без сравнения всего текста
+    if (g_pChangeTracker)
     {
-        SendMessage(hEditControl, WM_PASTE, 0, 0);
+        g_pChangeTracker->applyEdit(job->start, job->end - job->start, job->inserted.get(), job->insertedLength);
+        if (g_pEditJournal)
+        {
+            g_pEditJournal->compactIfNeeded(g_pChangeTracker->text());
+        }
     }
+    delete job;
+
+    BOOL modified = (!g_pTextHash || g_pTextHash->isModified()) ? TRUE : FALSE;
+    SetFileModified(modified);
+    UpdateWindowTitle(hWnd);
 }
 
 // Установка флага изменения файла
 void SetFileModified(BOOL modified)
 {
+    // Текст совпадает с файлом на диске: его хеш становится точкой отсчета
+    if (!modified && g_pTextHash)
+    {
+        g_pTextHash->markSaved();
+    }
+
     if (isFileModified != modified)
     {
         isFileModified = modified;
@@ -1109,7 +2078,11 @@ void UpdateWindowTitle(HWND hWnd)
         else
             fileName = currentFileName;
 
-        if (isFileModified)
+        if (g_pActiveViewer)
+        {
+            swprintf_s(title, 512, L"%s [только просмотр] - %s", fileName, szTitle);
+        }
+        else if (isFileModified)
         {
             swprintf_s(title, 512, L"%s* - %s", fileName, szTitle);
         }
@@ -1124,10 +2097,22 @@ void UpdateWindowTitle(HWND hWnd)
         wcscpy_s(title, 512, szTitle);
     }
 
-    SetWindowTextW(hWnd, title);
-}
-
-// Загрузка фильтров файлов из ресурсов
+    // EDIT-контрол показывает только основной курсор, поэтому число курсоров видно в заголовке
+    if (g_selections.count() > 1)
+    {
+        size_t length = wcslen(title);
+        swprintf_s(title + length, 512 - length, L" [курсоров: %u]", (UINT)g_selections.count());
+    }
+    if (g_isRecordingMacro)
+    {
+        wcscat_s(title, 512, L" [запись макроса]");
+    }
+
+    SetWindowTextW(hWnd, title);
+    UpdateDocumentTab();
+}
+
+// Загрузка фильтров файлов из ресурсов
 void LoadFileDialogFilters(WCHAR* filterBuffer, int bufferSize)
 {
     CHAR textFilterAnsi[MAX_LOADSTRING];
@@ -1171,13 +2156,21 @@ void LoadSettingsFromRegistry()
     if (savedFileState)
     {
         std::wstring lastFile;
-        if (g_pRegistryManager->LoadLastFile(lastFile) && !lastFile.empty())
+        BOOL hasLastFile = g_pRegistryManager->LoadLastFile(lastFile) && !lastFile.empty();
+        if (hasLastFile && IsLargeFile(lastFile.c_str()))
+        {
+            // Большой файл открывается в окне просмотра после создания вкладок
+            g_startupLargeFile = lastFile;
+            hasFileName = FALSE;
+            currentFileName[0] = L'\0';
+        }
+        else if (hasLastFile)
         {
             wcscpy_s(currentFileName, MAX_PATH, lastFile.c_str());
             hasFileName = TRUE;
             
-            // Загружаем содержимое файла в EditControl
-            if (!LoadFileContent(currentFileName))
+            // Загружаем содержимое файла в EditControl (из снимка сеанса, если он актуален)
+            if (!RestoreSessionDocument(currentFileName))
             {
                 // Если файл не удалось загрузить, сбрасываем состояние
                 hasFileName = FALSE;
@@ -1222,6 +2215,10 @@ void SaveSettingsToRegistry()
     g_pRegistryManager->SaveTextColor(g_textColor);
     g_pRegistryManager->SaveBackgroundColor(g_backgroundColor);
     
+    // Сохраняем перенос по словам и мини-карту
+    g_pRegistryManager->SaveWordWrap(g_isWordWrap);
+    g_pRegistryManager->SaveMinimap(g_isMinimapVisible);
+
     // Сохраняем состояние файла (открыт/новый)
     g_pRegistryManager->SaveLastFileState(hasFileName);
     
@@ -1230,6 +2227,9 @@ void SaveSettingsToRegistry()
     {
         g_pRegistryManager->SaveLastFile(currentFileName);
     }
+
+    // Записываем все измененные значения одним пакетом
+    g_pRegistryManager->Flush();
 }
 
 // Применение настроек шрифта
@@ -1250,6 +2250,16 @@ void ApplyFontSettings()
     {
         SendMessage(hEditControl, WM_SETFONT, (WPARAM)g_hCurrentFont, TRUE);
     }
+
+    for (std::map<DocumentId, LargeFileViewer*>::iterator it = g_largeFileViewers.begin();
+         it != g_largeFileViewers.end(); ++it)
+    {
+        it->second->setFont(g_hCurrentFont);
+    }
+    if (g_pCompareView)
+    {
+        g_pCompareView->setFont(g_hCurrentFont);
+    }
 }
 
 // Применение настроек цветов
@@ -1258,9 +2268,30 @@ void ApplyColorSettings()
     if (!hEditControl)
         return;
 
+    // Пересоздаем общую кисть фона под новый цвет
+    if (g_hBackgroundBrush)
+    {
+        DeleteObject(g_hBackgroundBrush);
+        g_hBackgroundBrush = NULL;
+    }
+
     // Устанавливаем цвет фона через WM_CTLCOLOREDIT
     // Для этого нужно перерисовать окно
     InvalidateRect(hEditControl, NULL, TRUE);
+
+    for (std::map<DocumentId, LargeFileViewer*>::iterator it = g_largeFileViewers.begin();
+         it != g_largeFileViewers.end(); ++it)
+    {
+        it->second->setColors(g_textColor, g_backgroundColor);
+    }
+    if (g_pCompareView)
+    {
+        g_pCompareView->setColors(g_textColor, g_backgroundColor);
+    }
+    if (g_pMinimapView)
+    {
+        g_pMinimapView->setColors(g_textColor, g_backgroundColor);
+    }
 }
 
 // Диалог выбора шрифта
@@ -1321,3 +2352,2404 @@ BOOL ShowColorDialog(BOOL isTextColor)
     return FALSE;
 }
 
+// Синхронизация теневой копии текста с EDIT-контролом
+void SyncChangeTracker(BOOL reset)
+{
+    if (!hEditControl || !g_pChangeTracker)
+        return;
+
+    // Правка не через курсоры или новый текст: позиции дополнительных курсоров устарели
+    ResetSelections();
+
+    if (reset && g_pEditJournal)
+    {
+        g_pEditJournal->setDocumentPath(hasFileName ? currentFileName : L"");
+    }
+
+    // Читаем буфер EDIT-контрола напрямую, без копирования через GetWindowText
+    HLOCAL hBuffer = (HLOCAL)SendMessage(hEditControl, EM_GETHANDLE, 0, 0);
+    const WCHAR* text = hBuffer ? (const WCHAR*)LocalLock(hBuffer) : NULL;
+    if (!text)
+        return;
+
+    size_t length = (size_t)GetWindowTextLengthW(hEditControl);
+    if (reset)
+    {
+        g_pChangeTracker->reset(text, length);
+    }
+    else if (!ApplyPendingEdit(text, length))
+    {
+        // Участок правки неизвестен (отмена, перетаскивание): он находится
+        // сравнением всего текста с теневой копией
+        g_pChangeTracker->update(text, length);
+    }
+    LocalUnlock(hBuffer);
+
+    // Загруженный неизмененный текст - сохраненная версия документа
+    if (reset && g_pTextHash)
+    {
+        if (isFileModified)
+        {
+            g_pTextHash->markUnsaved();
+        }
+        else
+        {
+            g_pTextHash->markSaved();
+        }
+    }
+
+    // Уплотняем журнал, если он разросся
+    if (!reset && g_pEditJournal)
+    {
+        g_pEditJournal->compactIfNeeded(g_pChangeTracker->text());
+    }
+}
+
+// Путь к служебному файлу редактора: %LOCALAPPDATA%\TextEditor\<fileName>
+std::wstring GetLocalDataPath(const WCHAR* fileName)
+{
+    WCHAR appData[MAX_PATH];
+    DWORD length = GetEnvironmentVariableW(L"LOCALAPPDATA", appData, MAX_PATH);
+    if (length == 0 || length >= MAX_PATH)
+        return L"";
+
+    std::wstring directory = std::wstring(appData) + L"\\TextEditor";
+    CreateDirectoryW(directory.c_str(), NULL); // Папка может уже существовать
+    return directory + L"\\" + fileName;
+}
+
+// Путь к журналу восстановления документа
+std::wstring GetRecoveryJournalPath(DocumentId id)
+{
+    std::wstring fileName = L"recovery-" + std::to_wstring((unsigned long long)id) + L".journal";
+    return GetLocalDataPath(fileName.c_str());
+}
+
+// Запуск журналов правок и восстановление документов после аварийного завершения
+void InitializeEditJournal(HWND hWnd)
+{
+    if (!g_pChangeTracker || !g_pDocumentManager)
+        return;
+
+    std::wstring pattern = GetLocalDataPath(L"recovery*.journal");
+    if (pattern.empty())
+        return;
+
+    // Журналы, оставшиеся после сбоя, содержат несохраненные правки документов
+    std::vector<std::wstring> journalPaths;
+    std::vector<RecoveredDocument> recoveredDocuments;
+    WIN32_FIND_DATAW findData;
+    HANDLE hFind = FindFirstFileW(pattern.c_str(), &findData);
+    if (hFind != INVALID_HANDLE_VALUE)
+    {
+        do
+        {
+            std::wstring journalPath = GetLocalDataPath(findData.cFileName);
+            journalPaths.push_back(journalPath);
+            RecoveredDocument recovered;
+            if (EditJournal::recover(journalPath, recovered) && recovered.hasUnsavedChanges)
+            {
+                recoveredDocuments.push_back(recovered);
+            }
+        } while (FindNextFileW(hFind, &findData));
+        FindClose(hFind);
+    }
+
+    BOOL isRestoreAccepted = FALSE;
+    if (!recoveredDocuments.empty() && hEditControl)
+    {
+        std::wstring message = L"Обнаружены несохраненные изменения после аварийного завершения (документов: " +
+            std::to_wstring((unsigned long long)recoveredDocuments.size()) + L").\n\nВосстановить их?";
+        int result = MessageBoxW(hWnd, message.c_str(), L"Восстановление", MB_YESNO | MB_ICONQUESTION);
+        isRestoreAccepted = (result == IDYES) ? TRUE : FALSE;
+    }
+
+    // Старые журналы уже прочитаны: новые журналы документов их заменяют
+    for (size_t i = 0; i < journalPaths.size(); ++i)
+    {
+        DeleteFileW(journalPaths[i].c_str());
+    }
+    g_areJournalsEnabled = TRUE;
+    AttachDocumentJournal();
+
+    if (isRestoreAccepted)
+    {
+        for (size_t i = 0; i < recoveredDocuments.size(); ++i)
+        {
+            RestoreRecoveredDocument(hWnd, recoveredDocuments[i]);
+        }
+    }
+}
+
+// Подключение журнала активного документа к теневой копии текста
+void AttachDocumentJournal()
+{
+    if (!g_areJournalsEnabled || !g_pDocumentManager || !g_pChangeTracker || !g_activeDocument || g_pActiveViewer)
+        return;
+
+    DetachDocumentJournal();
+    EditJournal* journal = g_pDocumentManager->getJournal(g_activeDocument);
+    if (!journal)
+    {
+        std::wstring journalPath = GetRecoveryJournalPath(g_activeDocument);
+        journal = journalPath.empty() ? nullptr : g_pDocumentManager->openJournal(g_activeDocument, journalPath);
+        if (!journal)
+            return;
+
+        // Новый журнал начинается со снимка текущего текста
+        journal->setDocumentPath(hasFileName ? currentFileName : L"");
+        if (isFileModified)
+        {
+            journal->markUnsaved(g_pChangeTracker->text());
+        }
+        else
+        {
+            journal->markSaved(g_pChangeTracker->text());
+        }
+    }
+
+    // Журнал измененного документа уже описывает его текст и не перезаписывается
+    g_pEditJournal = journal;
+    g_pChangeTracker->addListener(journal);
+}
+
+// Отключение журнала активного документа (перед сменой текста в EDIT-контроле)
+void DetachDocumentJournal()
+{
+    if (g_pEditJournal && g_pChangeTracker)
+    {
+        g_pChangeTracker->removeListener(g_pEditJournal);
+    }
+    g_pEditJournal = nullptr;
+}
+
+// Открытие текста, восстановленного из журнала, во вкладке
+void RestoreRecoveredDocument(HWND hWnd, const RecoveredDocument& recovered)
+{
+    // Файл уже открыт во вкладке: восстановленный текст заменяет его текст
+    DocumentId existing = recovered.documentPath.empty() ? 0 : g_pDocumentManager->findByPath(recovered.documentPath);
+    if (existing && g_largeFileViewers.find(existing) != g_largeFileViewers.end())
+    {
+        existing = 0;
+    }
+
+    if (existing)
+    {
+        if (!ActivateDocument(hWnd, existing))
+            return;
+    }
+    else if (hasFileName || isFileModified || g_pActiveViewer || GetWindowTextLengthW(hEditControl) != 0)
+    {
+        // Пустой новый документ заменяется восстановленным, иначе открывается новая вкладка
+        NewDocumentTab(hWnd);
+    }
+
+    SetEditorText(recovered.text.c_str());
+    if (!recovered.documentPath.empty() && recovered.documentPath.length() < MAX_PATH)
+    {
+        wcscpy_s(currentFileName, MAX_PATH, recovered.documentPath.c_str());
+        hasFileName = TRUE;
+    }
+    else
+    {
+        currentFileName[0] = L'\0';
+        hasFileName = FALSE;
+    }
+    SyncChangeTracker(TRUE);
+
+    // Восстановленный текст отличается от файла на диске
+    if (g_pEditJournal)
+    {
+        g_pEditJournal->markUnsaved(g_pChangeTracker->text());
+    }
+    if (g_pTextHash)
+    {
+        g_pTextHash->markUnsaved();
+    }
+    SetFileModified(TRUE);
+    UpdateDocumentTab();
+}
+
+// Запоминание версии текущего файла на диске (для снимка сеанса)
+void RememberDocumentFile(const DocumentFormat& format, ULONGLONG contentHash)
+{
+    g_documentFormat = format;
+    g_documentHash = contentHash;
+    g_hasDocumentInfo = PortableFile::getInfo(currentFileName, g_documentInfo) ? TRUE : FALSE;
+    g_isSnapshotRestored = FALSE;
+    g_documentGeneration++;
+}
+
+// Быстрое восстановление последнего документа из снимка сеанса
+BOOL RestoreSessionDocument(const WCHAR* filePath)
+{
+    std::wstring snapshotPath = GetLocalDataPath(L"session.snapshot");
+    PortableFile::Info info;
+    SessionSnapshot snapshot;
+    if (snapshotPath.empty() || !PortableFile::getInfo(filePath, info) ||
+        !snapshot.open(snapshotPath) || !snapshot.matches(filePath, info))
+    {
+        // Снимка нет или файл изменился: обычная загрузка с определением кодировки
+        return LoadFileContent(filePath);
+    }
+
+    // Текст берется прямо из отображения снимка, без чтения и перекодирования файла
+    SetEditorText(snapshot.text());
+
+    const SessionState& state = snapshot.state();
+    RememberDocumentFile(state.format, state.contentHash);
+    g_isSnapshotRestored = TRUE;
+
+    // Восстанавливаем выделение и прокрутку
+    RestoreEditorPosition(state.selectionStart, state.selectionEnd,
+                          state.firstVisibleLine < snapshot.lineCount() ? state.firstVisibleLine : 0);
+    return TRUE;
+}
+
+// Фоновая сверка восстановленного из снимка документа с файлом на диске
+void ValidateRestoredSession(HWND hWnd)
+{
+    if (!g_isSnapshotRestored || !hasFileName)
+        return;
+
+    // Размер и время совпали, но содержимое могло измениться без смены времени
+    std::wstring filePath = currentFileName;
+    ULONGLONG expectedHash = g_documentHash;
+    UINT generation = g_documentGeneration;
+    g_snapshotValidator = std::thread([hWnd, filePath, expectedHash, generation]()
+    {
+        if (!SessionSnapshot::verifyContent(filePath, expectedHash))
+        {
+            PostMessage(hWnd, WM_APP_SNAPSHOT_STALE, (WPARAM)generation, 0);
+        }
+    });
+}
+
+// Сохранение снимка сеанса при выходе
+void SaveSessionSnapshot()
+{
+    std::wstring snapshotPath = GetLocalDataPath(L"session.snapshot");
+    if (snapshotPath.empty())
+        return;
+
+    // Снимок хранит только текст, совпадающий с файлом на диске
+    if (!hasFileName || isFileModified || !g_hasDocumentInfo || !g_pChangeTracker || !hEditControl)
+    {
+        PortableFile::remove(snapshotPath);
+        return;
+    }
+
+    SessionState state;
+    state.documentPath = currentFileName;
+    state.fileSize = g_documentInfo.size;
+    state.fileModifiedTime = g_documentInfo.modifiedTime;
+    state.contentHash = g_documentHash;
+    state.format = g_documentFormat;
+
+    DWORD selectionStart = 0;
+    DWORD selectionEnd = 0;
+    SendMessage(hEditControl, EM_GETSEL, (WPARAM)&selectionStart, (LPARAM)&selectionEnd);
+    state.selectionStart = selectionStart;
+    state.selectionEnd = selectionEnd;
+    state.firstVisibleLine = (uint64_t)SendMessage(hEditControl, EM_GETFIRSTVISIBLELINE, 0, 0);
+
+    if (!SessionSnapshot::write(snapshotPath, state, g_pChangeTracker->text()))
+    {
+        PortableFile::remove(snapshotPath);
+    }
+}
+
+// Восстановление выделения и прокрутки EDIT-контрола
+void RestoreEditorPosition(uint64_t selectionStart, uint64_t selectionEnd, uint64_t firstVisibleLine)
+{
+    uint64_t length = (uint64_t)GetWindowTextLengthW(hEditControl);
+    DWORD start = (DWORD)(selectionStart < length ? selectionStart : length);
+    DWORD end = (DWORD)(selectionEnd < length ? selectionEnd : length);
+    SendMessage(hEditControl, EM_SETSEL, start, end);
+
+    uint64_t lineCount = (uint64_t)SendMessage(hEditControl, EM_GETLINECOUNT, 0, 0);
+    if (firstVisibleLine < lineCount)
+    {
+        LRESULT currentLine = SendMessage(hEditControl, EM_GETFIRSTVISIBLELINE, 0, 0);
+        SendMessage(hEditControl, EM_LINESCROLL, 0, (LPARAM)((LONG_PTR)firstVisibleLine - currentLine));
+    }
+}
+
+// Замена всего текста EDIT-контрола (без разбора правки по EN_CHANGE)
+void SetEditorText(const WCHAR* text)
+{
+    DiscardUndoGroup();
+    g_isReplacingText = TRUE;
+    SetWindowTextW(hEditControl, text);
+    g_isReplacingText = FALSE;
+}
+
+// Декодирование файла для менеджера документов (вызывается из рабочих потоков)
+bool DecodeDocumentFile(const std::wstring& path, DecodedDocument& result)
+{
+    ULONGLONG contentHash = 0;
+    if (!ReadTextFile(path.c_str(), result.text, result.format, contentHash))
+        return false;
+
+    result.contentHash = contentHash;
+    return true;
+}
+
+// Создание полосы вкладок
+void CreateTabControl(HWND hParent)
+{
+    hTabControl = CreateWindowExW(
+        0,
+        WC_TABCONTROLW,
+        L"",
+        WS_CHILD | WS_VISIBLE | WS_CLIPSIBLINGS | TCS_FOCUSNEVER,
+        0, 0, 0, 0,
+        hParent,
+        NULL,
+        hInst,
+        NULL
+    );
+
+    if (hTabControl)
+    {
+        SendMessage(hTabControl, WM_SETFONT, (WPARAM)GetStockObject(DEFAULT_GUI_FONT), FALSE);
+    }
+}
+
+// Подпись вкладки: имя файла и признак изменения
+std::wstring GetDocumentTabLabel(const std::wstring& path, BOOL modified)
+{
+    std::wstring label = L"Безымянный";
+    if (!path.empty())
+    {
+        size_t separator = path.find_last_of(L"\\/");
+        label = (separator == std::wstring::npos) ? path : path.substr(separator + 1);
+    }
+    if (modified)
+    {
+        label += L"*";
+    }
+    return label;
+}
+
+// Добавление вкладки для документа
+void AddDocumentTab(DocumentId id)
+{
+    if (!hTabControl || !g_pDocumentManager)
+        return;
+
+    DocumentInfo info = g_pDocumentManager->getInfo(id);
+    std::wstring label = GetDocumentTabLabel(info.path, info.isModified);
+
+    TCITEM item;
+    ZeroMemory(&item, sizeof(item));
+    item.mask = TCIF_TEXT;
+    item.pszText = &label[0];
+    TabCtrl_InsertItem(hTabControl, (int)g_pDocumentManager->indexOf(id), &item);
+}
+
+// Обновление подписи вкладки активного документа
+void UpdateDocumentTab()
+{
+    if (!hTabControl || !g_pDocumentManager || !g_activeDocument)
+        return;
+
+    std::wstring label = GetDocumentTabLabel(hasFileName ? currentFileName : L"", isFileModified);
+
+    TCITEM item;
+    ZeroMemory(&item, sizeof(item));
+    item.mask = TCIF_TEXT;
+    item.pszText = &label[0];
+    TabCtrl_SetItem(hTabControl, (int)g_pDocumentManager->indexOf(g_activeDocument), &item);
+}
+
+// Регистрация документа, загруженного при запуске
+void RegisterStartupDocument(HWND hWnd)
+{
+    if (!g_pDocumentManager)
+        return;
+
+    g_activeDocument = g_pDocumentManager->createDocument();
+    AddDocumentTab(g_activeDocument);
+    TabCtrl_SetCurSel(hTabControl, 0);
+    ResizeEditControl(hWnd);
+
+    // Большой файл прошлого сеанса заменяет пустой документ
+    if (!g_startupLargeFile.empty())
+    {
+        std::vector<std::wstring> paths(1, g_startupLargeFile);
+        g_startupLargeFile.clear();
+        OpenDocuments(hWnd, paths);
+    }
+}
+
+// Передача текста и состояния активного документа менеджеру перед переключением
+void StoreActiveDocument()
+{
+    if (!g_pDocumentManager || !g_activeDocument || !g_pChangeTracker)
+        return;
+
+    DocumentInfo info;
+    info.path = hasFileName ? currentFileName : L"";
+    info.isModified = isFileModified ? true : false;
+    info.format = g_documentFormat;
+    info.contentHash = g_documentHash;
+    info.fileInfo = g_documentInfo;
+    info.hasFileInfo = g_hasDocumentInfo ? true : false;
+
+    ChunkHashTree::Digest saved;
+    if (g_pTextHash && g_pTextHash->getSavedDigest(saved))
+    {
+        info.hasSavedText = true;
+        info.savedTextHash = saved.hash;
+        info.savedTextLength = saved.length;
+    }
+
+    if (g_pActiveViewer)
+    {
+        // Текст большого файла остается на диске, запоминается только прокрутка
+        info.isReadOnly = true;
+        info.firstVisibleLine = g_pActiveViewer->getFirstVisibleLine();
+        g_pDocumentManager->setInfo(g_activeDocument, info);
+        g_activeDocument = 0;
+        return;
+    }
+
+    // Журнал измененного документа остается до сохранения или закрытия вкладки
+    DetachDocumentJournal();
+    if (!isFileModified)
+    {
+        g_pDocumentManager->closeJournal(g_activeDocument, true);
+    }
+
+    DWORD selectionStart = 0;
+    DWORD selectionEnd = 0;
+    SendMessage(hEditControl, EM_GETSEL, (WPARAM)&selectionStart, (LPARAM)&selectionEnd);
+    info.selectionStart = selectionStart;
+    info.selectionEnd = selectionEnd;
+    info.firstVisibleLine = (uint64_t)SendMessage(hEditControl, EM_GETFIRSTVISIBLELINE, 0, 0);
+
+    // Сведения передаются раньше текста: от флага изменения зависит, можно ли выгрузить текст
+    g_pDocumentManager->setInfo(g_activeDocument, info);
+    g_pDocumentManager->storeText(g_activeDocument, g_pChangeTracker->text());
+    g_activeDocument = 0;
+}
+
+// Показ документа из менеджера в EDIT-контроле
+BOOL ShowDocument(HWND hWnd, DocumentId id)
+{
+    // Большой файл показывается в своем окне просмотра, текст в редактор не загружается
+    std::map<DocumentId, LargeFileViewer*>::iterator viewer = g_largeFileViewers.find(id);
+    ChunkedText text;
+    if (viewer == g_largeFileViewers.end() && !g_pDocumentManager->acquireText(id, text))
+        return FALSE;
+
+    // Слежение относится к прежнему документу
+    StopFollowingFile(hWnd);
+
+    DocumentInfo info = g_pDocumentManager->getInfo(id);
+    g_activeDocument = id;
+
+    // Глобальные переменные редактора отражают активный документ
+    wcscpy_s(currentFileName, MAX_PATH, info.path.c_str());
+    hasFileName = info.path.empty() ? FALSE : TRUE;
+    g_documentFormat = info.format;
+    g_documentHash = info.contentHash;
+    g_documentInfo = info.fileInfo;
+    g_hasDocumentInfo = info.hasFileInfo ? TRUE : FALSE;
+    g_isSnapshotRestored = FALSE;
+    g_documentGeneration++;
+
+    if (viewer != g_largeFileViewers.end())
+    {
+        // Для большого файла снимок сеанса не пишется, а EDIT-контрол пуст
+        g_hasDocumentInfo = FALSE;
+        SetEditorText(L"");
+        isFileModified = FALSE;
+        SyncChangeTracker(TRUE);
+        ShowLargeFileViewer(viewer->second);
+        viewer->second->goToLine(info.firstVisibleLine);
+    }
+    else
+    {
+        ShowLargeFileViewer(nullptr);
+        SetEditorText(text.toString().c_str());
+        isFileModified = info.isModified ? TRUE : FALSE;
+        SyncChangeTracker(TRUE);
+
+        // Измененный документ сравнивается со своей сохраненной версией
+        if (isFileModified && info.hasSavedText && g_pTextHash)
+        {
+            ChunkHashTree::Digest saved = { info.savedTextHash, (size_t)info.savedTextLength };
+            g_pTextHash->setSavedDigest(saved);
+        }
+        AttachDocumentJournal();
+        RestoreEditorPosition(info.selectionStart, info.selectionEnd, info.firstVisibleLine);
+    }
+
+    TabCtrl_SetCurSel(hTabControl, (int)g_pDocumentManager->indexOf(id));
+    UpdateWindowTitle(hWnd);
+    SetFocus(g_pActiveViewer ? g_pActiveViewer->getHandle() : hEditControl);
+    return TRUE;
+}
+
+// Переключение на другой документ
+BOOL ActivateDocument(HWND hWnd, DocumentId id)
+{
+    if (!g_pDocumentManager || id == 0)
+        return FALSE;
+
+    if (id == g_activeDocument)
+    {
+        TabCtrl_SetCurSel(hTabControl, (int)g_pDocumentManager->indexOf(id));
+        return TRUE;
+    }
+
+    DocumentId previous = g_activeDocument;
+    StoreActiveDocument();
+    if (ShowDocument(hWnd, id))
+    {
+        // Файл неактивной вкладки мог измениться, пока она была скрыта
+        CheckExternalChanges(hWnd);
+        return TRUE;
+    }
+
+    // Файл не удалось прочитать: закрываем его вкладку и возвращаемся к прежнему документу
+    std::wstring message = L"Не удалось открыть файл\n" + g_pDocumentManager->getInfo(id).path;
+    MessageBoxW(hWnd, message.c_str(), L"Ошибка", MB_OK | MB_ICONERROR);
+    TabCtrl_DeleteItem(hTabControl, (int)g_pDocumentManager->indexOf(id));
+    g_pDocumentManager->closeDocument(id);
+
+    if (previous == 0 || !ShowDocument(hWnd, previous))
+    {
+        NewDocumentTab(hWnd);
+    }
+    return FALSE;
+}
+
+// Открытие файлов во вкладках
+void OpenDocuments(HWND hWnd, const std::vector<std::wstring>& paths)
+{
+    if (paths.empty() || !g_pDocumentManager)
+        return;
+
+    // Пустой новый документ заменяется первым открытым файлом
+    DocumentId blankDocument = 0;
+    if (!hasFileName && !isFileModified && GetWindowTextLengthW(hEditControl) == 0)
+    {
+        blankDocument = g_activeDocument;
+    }
+
+    // Файлы декодируются параллельно в пуле менеджера документов
+    DocumentId firstDocument = 0;
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        DocumentId id = g_pDocumentManager->findByPath(paths[i]);
+        if (!id && IsLargeFile(paths[i].c_str()))
+        {
+            // Большой файл не загружается в редактор, а открывается только для просмотра
+            LargeFileViewer* viewer = CreateLargeFileViewer(hWnd, paths[i]);
+            if (!viewer)
+            {
+                std::wstring message = L"Не удалось открыть файл\n" + paths[i];
+                MessageBoxW(hWnd, message.c_str(), L"Ошибка", MB_OK | MB_ICONERROR);
+                continue;
+            }
+            id = g_pDocumentManager->openViewOnlyDocument(paths[i]);
+            g_largeFileViewers[id] = viewer;
+            AddDocumentTab(id);
+            ResizeEditControl(hWnd);
+        }
+        else if (!id)
+        {
+            id = g_pDocumentManager->openDocument(paths[i]);
+            AddDocumentTab(id);
+        }
+        if (!firstDocument)
+        {
+            firstDocument = id;
+        }
+    }
+
+    if (firstDocument && ActivateDocument(hWnd, firstDocument) && blankDocument && blankDocument != g_activeDocument)
+    {
+        TabCtrl_DeleteItem(hTabControl, (int)g_pDocumentManager->indexOf(blankDocument));
+        g_pDocumentManager->closeDocument(blankDocument);
+        TabCtrl_SetCurSel(hTabControl, (int)g_pDocumentManager->indexOf(g_activeDocument));
+    }
+}
+
+// Создание нового документа в отдельной вкладке
+void NewDocumentTab(HWND hWnd)
+{
+    if (g_pDocumentManager)
+    {
+        StoreActiveDocument();
+        ShowLargeFileViewer(nullptr);
+        g_activeDocument = g_pDocumentManager->createDocument();
+        AddDocumentTab(g_activeDocument);
+        TabCtrl_SetCurSel(hTabControl, (int)g_pDocumentManager->indexOf(g_activeDocument));
+    }
+    CreateNewFile(hWnd);
+    AttachDocumentJournal();
+}
+
+// Закрытие активного документа
+void CloseActiveDocument(HWND hWnd)
+{
+    if (!g_pDocumentManager || !g_activeDocument)
+        return;
+
+    // Проверяем, нужно ли сохранить изменения
+    if (isFileModified && !PromptSaveChanges(hWnd))
+        return;
+
+    // Текст закрываемого документа менеджеру не возвращается
+    StopFollowingFile(hWnd);
+    DocumentId closing = g_activeDocument;
+    size_t index = g_pDocumentManager->indexOf(closing);
+    DetachDocumentJournal();
+    g_activeDocument = 0;
+    TabCtrl_DeleteItem(hTabControl, (int)index);
+    g_pDocumentManager->closeDocument(closing);
+    DestroyLargeFileViewer(closing);
+
+    size_t count = g_pDocumentManager->documentCount();
+    if (count == 0)
+    {
+        NewDocumentTab(hWnd);
+        return;
+    }
+    ActivateDocument(hWnd, g_pDocumentManager->documentAt(index < count ? index : count - 1));
+}
+
+// Переключение на соседнюю вкладку
+void SwitchDocumentTab(HWND hWnd, int step)
+{
+    if (!g_pDocumentManager)
+        return;
+
+    size_t count = g_pDocumentManager->documentCount();
+    if (count < 2)
+        return;
+
+    size_t index = g_pDocumentManager->indexOf(g_activeDocument);
+    size_t next = (step > 0) ? (index + 1) % count : (index + count - 1) % count;
+    ActivateDocument(hWnd, g_pDocumentManager->documentAt(next));
+}
+
+// Запрос на сохранение всех измененных документов
+BOOL PromptSaveAllDocuments(HWND hWnd)
+{
+    if (isFileModified && !PromptSaveChanges(hWnd))
+        return FALSE;
+
+    if (!g_pDocumentManager)
+        return TRUE;
+
+    // Каждый измененный документ показывается перед вопросом о сохранении
+    for (size_t i = 0; i < g_pDocumentManager->documentCount(); ++i)
+    {
+        DocumentId id = g_pDocumentManager->documentAt(i);
+        if (id != g_activeDocument && g_pDocumentManager->getInfo(id).isModified)
+        {
+            if (!ActivateDocument(hWnd, id) || (isFileModified && !PromptSaveChanges(hWnd)))
+                return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+// Проверка, что файл не стоит загружать в EDIT-контрол: он слишком велик
+// или содержит строку, на разметке которой EDIT-контрол надолго зависает
+BOOL IsLargeFile(const WCHAR* filePath)
+{
+    PortableFile::Info info;
+    if (!PortableFile::getInfo(filePath, info))
+        return FALSE;
+    if (info.size >= LARGE_FILE_THRESHOLD)
+        return TRUE;
+    if (info.size < LONG_LINE_THRESHOLD)
+        return FALSE;
+
+    FILE* file = PortableFile::open(filePath, "rb");
+    if (!file)
+        return FALSE;
+
+    // Байт '\n' ищется без учета кодировки: в UTF-16 лишние совпадения
+    // только укорачивают строки, поэтому проверка не дает ложных срабатываний
+    std::vector<char> buffer(LONG_LINE_SCAN_BUFFER_SIZE);
+    uint64_t lineLength = 0;
+    BOOL hasLongLine = FALSE;
+    size_t count;
+    while (!hasLongLine && (count = fread(buffer.data(), 1, buffer.size(), file)) > 0)
+    {
+        const char* position = buffer.data();
+        const char* end = buffer.data() + count;
+        while (position < end)
+        {
+            const char* lineFeed = static_cast<const char*>(memchr(position, '\n', end - position));
+            lineLength += (lineFeed ? lineFeed : end) - position;
+            if (lineLength >= LONG_LINE_THRESHOLD)
+            {
+                hasLongLine = TRUE;
+                break;
+            }
+            if (!lineFeed)
+                break;
+            lineLength = 0;
+            position = lineFeed + 1;
+        }
+    }
+    fclose(file);
+    return hasLongLine;
+}
+
+// Таблица однобайтовой кодировки для окна просмотра и режима слежения
+void BuildSingleByteTable(UINT codePage, std::vector<wchar_t>& table)
+{
+    table.assign(256, L'?');
+    for (int i = 0; i < 256; ++i)
+    {
+        char byte = (char)i;
+        WCHAR symbol;
+        if (MultiByteToWideChar(codePage, MB_ERR_INVALID_CHARS, &byte, 1, &symbol, 1) == 1)
+        {
+            table[i] = symbol;
+        }
+    }
+}
+
+// Создание окна просмотра большого файла
+LargeFileViewer* CreateLargeFileViewer(HWND hWnd, const std::wstring& path)
+{
+    // Однобайтовая кодировка определяется по выборке блоков, без чтения всего файла
+    UINT codePage = CP_ACP;
+    EncodingDetector::Result detected;
+    if (EncodingDetector::detectFile(path, detected) && EncodingDetector::isSingleByte(detected.codePage))
+    {
+        codePage = detected.codePage;
+    }
+    std::vector<wchar_t> table;
+    BuildSingleByteTable(codePage, table);
+
+    LargeFileViewer* viewer = new LargeFileViewer(hInst);
+    if (!viewer->create(hWnd) || !viewer->openFile(path, table))
+    {
+        delete viewer;
+        return nullptr;
+    }
+    viewer->setFont(g_hCurrentFont);
+    viewer->setColors(g_textColor, g_backgroundColor);
+    viewer->setWordWrap(g_isWordWrap);
+    return viewer;
+}
+
+// Уничтожение окна просмотра закрытого документа
+void DestroyLargeFileViewer(DocumentId id)
+{
+    std::map<DocumentId, LargeFileViewer*>::iterator it = g_largeFileViewers.find(id);
+    if (it == g_largeFileViewers.end())
+        return;
+
+    if (g_pActiveViewer == it->second)
+    {
+        ShowLargeFileViewer(nullptr);
+    }
+    delete it->second;
+    g_largeFileViewers.erase(it);
+}
+
+// Показ окна просмотра вместо EDIT-контрола (nullptr - вернуть EDIT-контрол)
+void ShowLargeFileViewer(LargeFileViewer* viewer)
+{
+    if (g_pActiveViewer == viewer)
+        return;
+
+    if (g_pActiveViewer)
+    {
+        ShowWindow(g_pActiveViewer->getHandle(), SW_HIDE);
+    }
+    g_pActiveViewer = viewer;
+
+    if (viewer)
+    {
+        ShowWindow(viewer->getHandle(), SW_SHOW);
+        ShowWindow(hEditControl, SW_HIDE);
+    }
+    else
+    {
+        ShowWindow(hEditControl, SW_SHOW);
+    }
+
+    // Мини-карта показывается только рядом с EDIT-контролом
+    if (hEditControl)
+    {
+        ResizeEditControl(GetParent(hEditControl));
+    }
+    RequestStatusUpdate();
+}
+
+// Данные диалога ввода строки
+struct InputDialogData
+{
+    const WCHAR* title;     // Заголовок диалога
+    const WCHAR* prompt;    // Подсказка
+    std::wstring* value;    // Введенное значение
+};
+
+// Message handler for input box.
+INT_PTR CALLBACK InputDialog(HWND hDlg, UINT message, WPARAM wParam, LPARAM lParam)
+{
+    switch (message)
+    {
+    case WM_INITDIALOG:
+    {
+        InputDialogData* data = (InputDialogData*)lParam;
+        SetWindowLongPtr(hDlg, DWLP_USER, (LONG_PTR)data);
+        SetWindowTextW(hDlg, data->title);
+        SetDlgItemTextW(hDlg, IDC_INPUT_PROMPT, data->prompt);
+        SetDlgItemTextW(hDlg, IDC_INPUT_TEXT, data->value->c_str());
+        SendDlgItemMessage(hDlg, IDC_INPUT_TEXT, EM_SETSEL, 0, -1);
+        CenterDialog(hDlg);
+        return (INT_PTR)TRUE;
+    }
+
+    case WM_COMMAND:
+        if (LOWORD(wParam) == IDOK)
+        {
+            InputDialogData* data = (InputDialogData*)GetWindowLongPtr(hDlg, DWLP_USER);
+            WCHAR buffer[INPUT_TEXT_BUFFER_SIZE];
+            GetDlgItemTextW(hDlg, IDC_INPUT_TEXT, buffer, INPUT_TEXT_BUFFER_SIZE);
+            *data->value = buffer;
+        }
+        if (LOWORD(wParam) == IDOK || LOWORD(wParam) == IDCANCEL)
+        {
+            EndDialog(hDlg, LOWORD(wParam));
+            return (INT_PTR)TRUE;
+        }
+        break;
+    }
+    return (INT_PTR)FALSE;
+}
+
+// Запрос строки у пользователя
+BOOL ShowInputDialog(HWND hWnd, const WCHAR* title, const WCHAR* prompt, std::wstring& value)
+{
+    InputDialogData data = { title, prompt, &value };
+    return DialogBoxParam(hInst, MAKEINTRESOURCE(IDD_INPUT), hWnd, InputDialog, (LPARAM)&data) == IDOK;
+}
+
+// Поиск текста в активном документе (с продолжением с начала)
+void FindText(HWND hWnd, BOOL askText)
+{
+    if (askText)
+    {
+        std::wstring text = g_lastSearchText;
+        if (!ShowInputDialog(hWnd, L"Поиск", L"Найти:", text) || text.empty())
+            return;
+        g_lastSearchText = text;
+    }
+
+    // В большом файле поиск идет в фоне, результат показывает окно просмотра
+    if (g_pActiveViewer)
+    {
+        g_pActiveViewer->findNext(g_lastSearchText);
+        return;
+    }
+
+    int length = GetWindowTextLengthW(hEditControl);
+    std::vector<WCHAR> buffer(length + 1);
+    GetWindowTextW(hEditControl, &buffer[0], length + 1);
+
+    DWORD selectionStart = 0;
+    DWORD selectionEnd = 0;
+    SendMessage(hEditControl, EM_GETSEL, (WPARAM)&selectionStart, (LPARAM)&selectionEnd);
+
+    const WCHAR* begin = &buffer[0];
+    const WCHAR* end = begin + length;
+    const WCHAR* from = begin + (selectionEnd < (DWORD)length ? selectionEnd : length);
+    const WCHAR* needle = g_lastSearchText.c_str();
+    const WCHAR* needleEnd = needle + g_lastSearchText.length();
+
+    const WCHAR* found = std::search(from, end, needle, needleEnd);
+    if (found == end)
+    {
+        found = std::search(begin, end, needle, needleEnd);
+    }
+    if (found == end)
+    {
+        MessageBoxW(hWnd, L"Текст не найден.", L"Поиск", MB_OK | MB_ICONINFORMATION);
+        return;
+    }
+
+    DWORD start = (DWORD)(found - begin);
+    SendMessage(hEditControl, EM_SETSEL, start, start + (DWORD)g_lastSearchText.length());
+    SendMessage(hEditControl, EM_SCROLLCARET, 0, 0);
+
+    if (g_isRecordingMacro)
+    {
+        g_macro.recordFind(g_lastSearchText);
+    }
+}
+
+// Переход к строке по номеру
+void GoToLine(HWND hWnd)
+{
+    std::wstring text;
+    if (!ShowInputDialog(hWnd, L"Переход", L"Номер строки:", text))
+        return;
+
+    unsigned long long line = wcstoull(text.c_str(), NULL, 10);
+    if (line == 0)
+        return;
+
+    if (g_pActiveViewer)
+    {
+        if (!g_pActiveViewer->goToLine(line - 1))
+        {
+            MessageBoxW(hWnd, L"Строка еще не проиндексирована. Повторите переход позже.",
+                        L"Переход", MB_OK | MB_ICONINFORMATION);
+        }
+        return;
+    }
+
+    // EM_LINEINDEX при переносе по словам считает экранные строки,
+    // поэтому логическая строка ищется по индексу теневой копии
+    if (!g_pChangeTracker || !g_pLineIndex)
+        return;
+    size_t lineCount = g_pLineIndex->lineCount();
+    size_t index = line > lineCount ? lineCount - 1 : (size_t)(line - 1);
+    SetEditorCaret(g_pLineIndex->lineStart(g_pChangeTracker->text(), index));
+}
+
+// Переход к смещению: в байтах для окна просмотра, в символах для редактора
+void GoToOffset(HWND hWnd)
+{
+    std::wstring text;
+    const WCHAR* prompt = g_pActiveViewer ? L"Смещение в байтах (0x - шестнадцатеричное):"
+                                          : L"Смещение в символах (0x - шестнадцатеричное):";
+    if (!ShowInputDialog(hWnd, L"Переход", prompt, text) || text.empty())
+        return;
+
+    const WCHAR* digits = text.c_str();
+    int base = 10;
+    if (text.size() > 2 && text[0] == L'0' && (text[1] == L'x' || text[1] == L'X'))
+    {
+        digits += 2;
+        base = 16;
+    }
+    WCHAR* end = NULL;
+    unsigned long long offset = wcstoull(digits, &end, base);
+    if (end == digits)
+        return;
+
+    if (g_pActiveViewer)
+    {
+        if (!g_pActiveViewer->goToOffset(offset))
+        {
+            MessageBoxW(hWnd, L"Смещение еще не проиндексировано. Повторите переход позже.",
+                        L"Переход", MB_OK | MB_ICONINFORMATION);
+        }
+        return;
+    }
+
+    size_t length = (size_t)GetWindowTextLengthW(hEditControl);
+    SetEditorCaret(offset > length ? length : (size_t)offset);
+}
+
+// Переход к началу строки, лежащей на заданной доле документа
+void GoToPercent(HWND hWnd)
+{
+    std::wstring text;
+    if (!ShowInputDialog(hWnd, L"Переход", L"Процент от начала документа:", text) || text.empty())
+        return;
+
+    WCHAR* end = NULL;
+    double percent = wcstod(text.c_str(), &end);
+    if (end == text.c_str())
+        return;
+    if (percent < 0.0)
+        percent = 0.0;
+    if (percent > 100.0)
+        percent = 100.0;
+
+    if (g_pActiveViewer)
+    {
+        uint64_t offset = (uint64_t)((double)g_pActiveViewer->getFileSize() * percent / 100.0);
+        if (!g_pActiveViewer->goToOffset(offset))
+        {
+            MessageBoxW(hWnd, L"Эта часть файла еще не проиндексирована. Повторите переход позже.",
+                        L"Переход", MB_OK | MB_ICONINFORMATION);
+        }
+        return;
+    }
+
+    if (!g_pChangeTracker || !g_pLineIndex)
+        return;
+    const ChunkedText& documentText = g_pChangeTracker->text();
+    size_t offset = (size_t)((double)documentText.length() * percent / 100.0);
+    size_t line = g_pLineIndex->lineOfOffset(documentText, offset);
+    SetEditorCaret(g_pLineIndex->lineStart(documentText, line));
+}
+
+// Передача трекеру правки, сделанной вводом у выделения
+//
+// Ввод символа, удаление и команды буфера обмена заменяют участок, который
+// начинается не правее прежнего выделения и кончается на новой каретке.
+// По длинам текста и положению каретки правка восстанавливается за O(1),
+// без сравнения всего текста с теневой копией. Края участка сверяются с
+// копией; при расхождении вызывающий код сравнивает текст целиком
+BOOL ApplyPendingEdit(const WCHAR* text, size_t length)
+{
+    const size_t CHECK_LENGTH = 8;
+
+    if (!g_isEditPending || g_pChangeTracker->text().length() != g_pendingEditLength)
+        return FALSE;
+    g_isEditPending = FALSE;
+
+    DWORD selectionStart = 0;
+    DWORD selectionEnd = 0;
+    SendMessage(hEditControl, EM_GETSEL, (WPARAM)&selectionStart, (LPARAM)&selectionEnd);
+    size_t caret = selectionEnd;
+    if (selectionStart != selectionEnd || caret > length)
+        return FALSE;
+
+    size_t start = std::min(g_pendingEditStart, caret);
+    size_t insertCount = caret - start;
+    if (g_pendingEditLength + insertCount < length)
+        return FALSE;
+    size_t removeCount = g_pendingEditLength + insertCount - length;
+    if (start + removeCount > g_pendingEditLength || g_pendingEditEnd > start + removeCount)
+        return FALSE;
+
+    const ChunkedText& current = g_pChangeTracker->text();
+    for (size_t i = 1; i <= CHECK_LENGTH && i <= start; ++i)
+    {
+        if (current.charAt(start - i) != text[start - i])
+            return FALSE;
+    }
+    for (size_t i = 0; i < CHECK_LENGTH && caret + i < length; ++i)
+    {
+        if (current.charAt(start + removeCount + i) != text[caret + i])
+            return FALSE;
+    }
+
+    g_pChangeTracker->applyEdit(start, removeCount, text + start, insertCount);
+    return TRUE;
+}
+
+// Установка каретки в позицию EDIT-контрола с прокруткой к ней
+void SetEditorCaret(size_t offset)
+{
+    SendMessage(hEditControl, EM_SETSEL, (WPARAM)offset, (LPARAM)offset);
+    SendMessage(hEditControl, EM_SCROLLCARET, 0, 0);
+}
+
+// Оконная процедура EDIT-контрола: при нескольких курсорах ввод идет во все
+LRESULT CALLBACK EditControlProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
+{
+    if (g_isRecordingMacro && (message == WM_CHAR || message == WM_KEYDOWN))
+    {
+        RecordMacroKey(message, wParam);
+    }
+
+    // Правка из нескольких участков (перезагрузка файла) отменяется одним шагом
+    if (g_pUndoGroup)
+    {
+        if ((message == WM_CHAR && wParam == 0x1A) || message == WM_UNDO || message == EM_UNDO)
+        {
+            return ApplyUndoGroup();
+        }
+        if (message == EM_CANUNDO)
+        {
+            return TRUE;
+        }
+    }
+    if (g_selections.count() > 1)
+    {
+        switch (message)
+        {
+        case WM_CHAR:
+            if (wParam == VK_ESCAPE)
+            {
+                ResetSelections();
+                return 0;
+            }
+            if (wParam == VK_BACK)
+            {
+                EditAllCarets(L"", -1);
+                return 0;
+            }
+            if (wParam == VK_RETURN)
+            {
+                EditAllCarets(L"\r\n", 0);
+                return 0;
+            }
+            if ((wParam >= L' ' && wParam != 0x7F) || wParam == L'\t')
+            {
+                EditAllCarets(std::wstring(1, (WCHAR)wParam), 0);
+                return 0;
+            }
+            break;
+        case WM_KEYDOWN:
+            if (wParam == VK_DELETE)
+            {
+                EditAllCarets(L"", 1);
+                return 0;
+            }
+            // Перемещение курсора возвращает одно выделение
+            if (wParam == VK_LEFT || wParam == VK_RIGHT || wParam == VK_UP || wParam == VK_DOWN ||
+                wParam == VK_HOME || wParam == VK_END || wParam == VK_PRIOR || wParam == VK_NEXT)
+            {
+                ResetSelections();
+            }
+            break;
+        case WM_LBUTTONDOWN:
+            ResetSelections();
+            break;
+        }
+    }
+
+    // Ввод и команды буфера обмена меняют текст у выделения: оно
+    // запоминается, чтобы EN_CHANGE передал трекеру участок правки
+    BOOL isEditRecorded = FALSE;
+    if (!g_isEditPending &&
+        ((message == WM_CHAR && (wParam >= L' ' || wParam == VK_BACK || wParam == L'\t' || wParam == VK_RETURN)) ||
+         (message == WM_KEYDOWN && wParam == VK_DELETE) ||
+         message == WM_PASTE || message == WM_CUT || message == WM_CLEAR || message == EM_REPLACESEL))
+    {
+        DWORD selectionStart = 0;
+        DWORD selectionEnd = 0;
+        CallWindowProc(g_pfnEditProc, hWnd, EM_GETSEL, (WPARAM)&selectionStart, (LPARAM)&selectionEnd);
+        g_pendingEditLength = (size_t)CallWindowProc(g_pfnEditProc, hWnd, WM_GETTEXTLENGTH, 0, 0);
+        g_pendingEditStart = selectionStart;
+        g_pendingEditEnd = selectionEnd;
+        g_isEditPending = TRUE;
+        isEditRecorded = TRUE;
+    }
+
+    LRESULT result = CallWindowProc(g_pfnEditProc, hWnd, message, wParam, lParam);
+    if (isEditRecorded)
+    {
+        g_isEditPending = FALSE;
+    }
+    switch (message)
+    {
+    case WM_PAINT:
+        // Рамки поверх текста, нарисованного EDIT-контролом
+        DrawBracketHighlight(hWnd);
+        break;
+    case WM_KEYDOWN:
+    case WM_CHAR:
+    case WM_LBUTTONDOWN:
+    case WM_LBUTTONUP:
+    case WM_SETFOCUS:
+        UpdateBracketHighlight();
+        RequestStatusUpdate();
+        break;
+    case WM_MOUSEMOVE:
+        if (wParam & MK_LBUTTON)
+        {
+            UpdateBracketHighlight();
+            RequestStatusUpdate();
+        }
+        break;
+    case EM_REPLACESEL:
+    case EM_SETSEL:
+    case WM_SETTEXT:
+        // Программные правки и перемещения курсора (вставка, макросы, переходы)
+        RequestStatusUpdate();
+        break;
+    }
+    switch (message)
+    {
+    case WM_KEYDOWN:
+    case WM_CHAR:
+    case WM_LBUTTONDOWN:
+    case WM_LBUTTONUP:
+    case WM_MOUSEMOVE:
+    case EM_REPLACESEL:
+    case EM_SETSEL:
+    case WM_SETTEXT:
+    case WM_UNDO:
+    case EM_UNDO:
+        TrackEditCaret(message, wParam, lParam);
+        break;
+    }
+    return result;
+}
+
+// Отслеживание стороны курсора в выделении EDIT-контрола. EM_GETSEL
+// возвращает концы по возрастанию, поэтому курсор - тот конец, который
+// не совпадает с прежним якорем
+void TrackEditCaret(UINT message, WPARAM wParam, LPARAM lParam)
+{
+    size_t length = (size_t)GetWindowTextLengthW(hEditControl);
+    if (message == EM_SETSEL && (int)wParam >= 0)
+    {
+        // Программное выделение задает якорь и курсор явно (-1 - конец текста)
+        g_editAnchor = (std::min)((size_t)wParam, length);
+        g_editCaret = ((int)lParam < 0) ? length : (std::min)((size_t)lParam, length);
+        return;
+    }
+
+    DWORD selectionStart = 0;
+    DWORD selectionEnd = 0;
+    SendMessage(hEditControl, EM_GETSEL, (WPARAM)&selectionStart, (LPARAM)&selectionEnd);
+    if (selectionStart == selectionEnd || g_editAnchor == selectionStart)
+    {
+        g_editAnchor = selectionStart;
+        g_editCaret = selectionEnd;
+    }
+    else if (g_editAnchor == selectionEnd)
+    {
+        g_editCaret = selectionStart;
+    }
+    else
+    {
+        // Якорь неизвестен (выделение слова двойным щелчком): курсор в конце
+        g_editAnchor = selectionStart;
+        g_editCaret = selectionEnd;
+    }
+}
+
+// Возврат к одному курсору (выделению EDIT-контрола)
+void ResetSelections()
+{
+    if (g_selections.count() > 1)
+    {
+        g_selections.reset(0, 0);
+        UpdateWindowTitle(hMainWnd);
+    }
+}
+
+// Основное выделение показывается EDIT-контролом
+void ShowPrimarySelection()
+{
+    const SelectionModel::Selection& primary = g_selections.primary();
+    SendMessage(hEditControl, EM_SETSEL, (WPARAM)primary.anchor, (LPARAM)primary.caret);
+    SendMessage(hEditControl, EM_SCROLLCARET, 0, 0);
+}
+
+// Добавление курсора на строку выше или ниже основного
+void AddCaretOnLine(HWND hWnd, int lineStep)
+{
+    // Макрос записывает правку одним курсором
+    if (!hEditControl || g_pActiveViewer || !g_pChangeTracker || !g_pLineIndex || g_isRecordingMacro)
+        return;
+
+    // Единственное выделение берется у EDIT-контрола: его могли изменить мышью
+    if (g_selections.count() == 1)
+    {
+        DWORD selectionStart = 0;
+        DWORD selectionEnd = 0;
+        SendMessage(hEditControl, EM_GETSEL, (WPARAM)&selectionStart, (LPARAM)&selectionEnd);
+        g_selections.reset(selectionStart, selectionEnd);
+    }
+    if (g_selections.addCaretOnLine(g_pChangeTracker->text(), *g_pLineIndex, lineStep))
+    {
+        ShowPrimarySelection();
+        UpdateWindowTitle(hWnd);
+    }
+}
+
+// Столбцовое выделение по углам текущего выделения
+void SelectColumn(HWND hWnd)
+{
+    if (!hEditControl || g_pActiveViewer || !g_pChangeTracker || !g_pLineIndex || g_isRecordingMacro)
+        return;
+
+    DWORD selectionStart = 0;
+    DWORD selectionEnd = 0;
+    SendMessage(hEditControl, EM_GETSEL, (WPARAM)&selectionStart, (LPARAM)&selectionEnd);
+    g_selections.selectColumn(g_pChangeTracker->text(), *g_pLineIndex, selectionStart, selectionEnd);
+    ShowPrimarySelection();
+    UpdateWindowTitle(hWnd);
+}
+
+// Ввод или удаление во всех курсорах одной правкой
+void EditAllCarets(const std::wstring& text, int deleteDirection)
+{
+    if (!g_pChangeTracker)
+        return;
+
+    const ChunkedText& current = g_pChangeTracker->text();
+    std::vector<SelectionModel::Edit> edits;
+    if (deleteDirection < 0)
+    {
+        g_selections.deleteBackward(current, edits);
+    }
+    else if (deleteDirection > 0)
+    {
+        g_selections.deleteForward(current, edits);
+    }
+    else
+    {
+        g_selections.insert(text.size(), edits);
+    }
+    if (edits.empty())
+    {
+        ShowPrimarySelection();
+        return;
+    }
+
+    // EDIT-контрол получает весь пакет одной заменой участка: отмена
+    // возвращает ввод во все курсоры за один шаг
+    std::wstring span;
+    size_t spanLength = 0;
+    size_t spanStart = SelectionModel::composeSpan(current, edits, text, span, spanLength);
+    SendMessage(hEditControl, WM_SETREDRAW, FALSE, 0);
+    g_isReplacingText = TRUE;
+    SendMessage(hEditControl, EM_SETSEL, (WPARAM)spanStart, (LPARAM)(spanStart + spanLength));
+    SendMessage(hEditControl, EM_REPLACESEL, TRUE, (LPARAM)span.c_str());
+    g_isReplacingText = FALSE;
+
+    // Теневая копия и индексы обновляются по каждой замене, с конца
+    for (size_t i = edits.size(); i-- > 0;)
+    {
+        g_pChangeTracker->applyEdit(edits[i].offset, edits[i].removeCount, text);
+    }
+    if (g_pEditJournal)
+    {
+        g_pEditJournal->compactIfNeeded(g_pChangeTracker->text());
+    }
+
+    ShowPrimarySelection();
+    SendMessage(hEditControl, WM_SETREDRAW, TRUE, 0);
+    InvalidateRect(hEditControl, NULL, TRUE);
+    SetFileModified((!g_pTextHash || g_pTextHash->isModified()) ? TRUE : FALSE);
+    UpdateWindowTitle(hMainWnd);
+}
+
+// Запись нажатия клавиши в макрос (перемещения с Ctrl и Shift и мышь не записываются)
+void RecordMacroKey(UINT message, WPARAM wParam)
+{
+    if (message == WM_CHAR)
+    {
+        if (wParam == VK_BACK)
+        {
+            g_macro.recordOperation(KeyboardMacro::OP_DELETE_BACK);
+        }
+        else if (wParam == VK_RETURN)
+        {
+            g_macro.recordText(L"\r\n", 2);
+        }
+        else if ((wParam >= L' ' && wParam != 0x7F) || wParam == L'\t')
+        {
+            WCHAR character = (WCHAR)wParam;
+            g_macro.recordText(&character, 1);
+        }
+        return;
+    }
+
+    if ((GetKeyState(VK_CONTROL) & 0x8000) || (GetKeyState(VK_SHIFT) & 0x8000))
+        return;
+
+    switch (wParam)
+    {
+    case VK_DELETE:
+        g_macro.recordOperation(KeyboardMacro::OP_DELETE_FORWARD);
+        break;
+    case VK_LEFT:
+        g_macro.recordOperation(KeyboardMacro::OP_CHAR_LEFT);
+        break;
+    case VK_RIGHT:
+        g_macro.recordOperation(KeyboardMacro::OP_CHAR_RIGHT);
+        break;
+    case VK_UP:
+        g_macro.recordOperation(KeyboardMacro::OP_LINE_UP);
+        break;
+    case VK_DOWN:
+        g_macro.recordOperation(KeyboardMacro::OP_LINE_DOWN);
+        break;
+    case VK_HOME:
+        g_macro.recordOperation(KeyboardMacro::OP_LINE_HOME);
+        break;
+    case VK_END:
+        g_macro.recordOperation(KeyboardMacro::OP_LINE_END);
+        break;
+    }
+}
+
+// Начало или окончание записи макроса
+void ToggleMacroRecording(HWND hWnd)
+{
+    if (!g_isRecordingMacro)
+    {
+        if (!hEditControl || g_pActiveViewer)
+            return;
+        ResetSelections();
+        g_macro.clear();
+    }
+    g_isRecordingMacro = !g_isRecordingMacro;
+    CheckMenuItem(GetMenu(hWnd), IDM_EDIT_MACRO_RECORD, MF_BYCOMMAND | (g_isRecordingMacro ? MF_CHECKED : MF_UNCHECKED));
+    UpdateWindowTitle(hWnd);
+}
+
+// Выполнение макроса над копией текста и перенос результата одной правкой
+void PlayMacro(HWND hWnd, BOOL askCount)
+{
+    if (!hEditControl || g_pActiveViewer || !g_pChangeTracker || g_isRecordingMacro || g_macro.isEmpty())
+        return;
+
+    // Без числа повторов макрос выполняется до первого невозможного шага
+    size_t times = 1;
+    if (askCount)
+    {
+        std::wstring text;
+        if (!ShowInputDialog(hWnd, L"Макрос", L"Число повторов (пусто - до конца текста):", text))
+            return;
+        times = text.empty() ? (g_pLineIndex ? g_pLineIndex->lineCount() : 1) : (size_t)wcstoull(text.c_str(), NULL, 10);
+        if (times == 0)
+            return;
+    }
+
+    ResetSelections();
+    DWORD selectionStart = 0;
+    DWORD selectionEnd = 0;
+    SendMessage(hEditControl, EM_GETSEL, (WPARAM)&selectionStart, (LPARAM)&selectionEnd);
+
+    HLOCAL hText = (HLOCAL)SendMessage(hEditControl, EM_GETHANDLE, 0, 0);
+    const WCHAR* text = hText ? (const WCHAR*)LocalLock(hText) : NULL;
+    if (!text)
+        return;
+    MacroPlayer player(text, (size_t)GetWindowTextLengthW(hEditControl), selectionStart, selectionEnd);
+    LocalUnlock(hText);
+
+    player.run(g_macro, times);
+
+    size_t anchor = 0;
+    size_t caret = 0;
+    player.getSelection(anchor, caret);
+
+    // Все повторы попадают в EDIT-контрол одной заменой участка: одна
+    // перерисовка и один шаг отмены
+    size_t changeStart = 0;
+    size_t changeLength = 0;
+    std::wstring changeText;
+    SendMessage(hEditControl, WM_SETREDRAW, FALSE, 0);
+    if (player.getChange(changeStart, changeLength, changeText))
+    {
+        g_isReplacingText = TRUE;
+        SendMessage(hEditControl, EM_SETSEL, (WPARAM)changeStart, (LPARAM)(changeStart + changeLength));
+        SendMessage(hEditControl, EM_REPLACESEL, TRUE, (LPARAM)changeText.c_str());
+        g_isReplacingText = FALSE;
+
+        g_pChangeTracker->applyEdit(changeStart, changeLength, changeText);
+        if (g_pEditJournal)
+        {
+            g_pEditJournal->compactIfNeeded(g_pChangeTracker->text());
+        }
+    }
+    SendMessage(hEditControl, EM_SETSEL, (WPARAM)anchor, (LPARAM)caret);
+    SendMessage(hEditControl, EM_SCROLLCARET, 0, 0);
+    SendMessage(hEditControl, WM_SETREDRAW, TRUE, 0);
+    InvalidateRect(hEditControl, NULL, TRUE);
+    SetFileModified((!g_pTextHash || g_pTextHash->isModified()) ? TRUE : FALSE);
+}
+
+// Дополнение слова перед курсором самыми частыми словами документа
+void CompleteWord(HWND hWnd)
+{
+    const size_t MAX_COMPLETIONS = 10;
+
+    if (!hEditControl || g_pActiveViewer || !g_pChangeTracker || !g_pWordIndex)
+        return;
+
+    ResetSelections();
+    DWORD selectionStart = 0;
+    DWORD selectionEnd = 0;
+    SendMessage(hEditControl, EM_GETSEL, (WPARAM)&selectionStart, (LPARAM)&selectionEnd);
+    if (selectionStart != selectionEnd)
+        return;
+
+    // Префикс - начало слова, на конце которого стоит курсор
+    const ChunkedText& text = g_pChangeTracker->text();
+    size_t caret = selectionEnd;
+    size_t start = caret;
+    while (start > 0 && caret - start < WordCompletionIndex::MAX_WORD_LENGTH &&
+           WordCompletionIndex::isWordChar(text.charAt(start - 1)))
+    {
+        --start;
+    }
+    if (start == caret)
+        return;
+
+    std::vector<WordCompletionIndex::Completion> completions;
+    g_pWordIndex->complete(text.substr(start, caret - start), MAX_COMPLETIONS, completions);
+    if (completions.empty())
+    {
+        MessageBeep(MB_OK);
+        return;
+    }
+
+    // Единственный вариант подставляется сразу, несколько - выбираются из меню у курсора
+    size_t choice = 0;
+    if (completions.size() > 1)
+    {
+        HMENU hMenu = CreatePopupMenu();
+        for (size_t i = 0; i < completions.size(); ++i)
+        {
+            AppendMenuW(hMenu, MF_STRING, i + 1, completions[i].word.c_str());
+        }
+        POINT point = { 0, 0 };
+        GetCaretPos(&point);
+        ClientToScreen(hEditControl, &point);
+        UINT command = (UINT)TrackPopupMenu(hMenu, TPM_LEFTALIGN | TPM_BOTTOMALIGN | TPM_RETURNCMD | TPM_NONOTIFY,
+                                            point.x, point.y, 0, hWnd, NULL);
+        DestroyMenu(hMenu);
+        if (command == 0)
+            return;
+        choice = command - 1;
+    }
+
+    // Дописывается только недостающий конец слова
+    std::wstring suffix = completions[choice].word.substr(caret - start);
+    g_isReplacingText = TRUE;
+    SendMessage(hEditControl, EM_REPLACESEL, TRUE, (LPARAM)suffix.c_str());
+    g_isReplacingText = FALSE;
+    g_pChangeTracker->applyEdit(caret, 0, suffix);
+    if (g_pEditJournal)
+    {
+        g_pEditJournal->compactIfNeeded(g_pChangeTracker->text());
+    }
+    if (g_isRecordingMacro)
+    {
+        g_macro.recordText(suffix.data(), suffix.size());
+    }
+    SetFileModified((!g_pTextHash || g_pTextHash->isModified()) ? TRUE : FALSE);
+}
+
+// Подсветка скобок и переход к парной - только в файлах исходного кода
+BOOL IsCodeDocument()
+{
+    static const WCHAR* const CODE_EXTENSIONS[] = {
+        L"c", L"cc", L"cpp", L"cxx", L"h", L"hh", L"hpp", L"hxx", L"inl", L"cs", L"java", L"js", L"ts",
+        L"json", L"py", L"go", L"rs", L"php", L"css", L"sql", L"rc", L"cmake"
+    };
+
+    if (!hasFileName)
+        return FALSE;
+    const WCHAR* fileName = wcsrchr(currentFileName, L'\\');
+    const WCHAR* extension = wcsrchr(fileName ? fileName : currentFileName, L'.');
+    if (!extension)
+        return FALSE;
+    for (size_t i = 0; i < sizeof(CODE_EXTENSIONS) / sizeof(CODE_EXTENSIONS[0]); ++i)
+    {
+        if (_wcsicmp(extension + 1, CODE_EXTENSIONS[i]) == 0)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+// Скобка у курсора (сначала после него, затем перед ним) и ее пара
+BOOL FindBracketAtCaret(size_t& bracket, size_t& match, BOOL& isBeforeCaret)
+{
+    if (!hEditControl || g_pActiveViewer || !g_pChangeTracker || !g_pBracketIndex || !IsCodeDocument())
+        return FALSE;
+
+    DWORD selectionStart = 0;
+    DWORD selectionEnd = 0;
+    SendMessage(hEditControl, EM_GETSEL, (WPARAM)&selectionStart, (LPARAM)&selectionEnd);
+    if (selectionStart != selectionEnd)
+        return FALSE;
+
+    const ChunkedText& text = g_pChangeTracker->text();
+    size_t caret = selectionEnd;
+    if (g_pBracketIndex->findMatch(text, caret, match))
+    {
+        bracket = caret;
+        isBeforeCaret = FALSE;
+        return TRUE;
+    }
+    if (caret > 0 && g_pBracketIndex->findMatch(text, caret - 1, match))
+    {
+        bracket = caret - 1;
+        isBeforeCaret = TRUE;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+// Прямоугольник символа в EDIT-контроле
+BOOL GetEditCharRect(HWND hEdit, HDC hdc, size_t offset, RECT& rect)
+{
+    LRESULT position = SendMessage(hEdit, EM_POSFROMCHAR, (WPARAM)offset, 0);
+    if (position == -1)
+        return FALSE;
+
+    WCHAR character = g_pChangeTracker->text().charAt(offset);
+    SIZE size = { 0, 0 };
+    GetTextExtentPoint32W(hdc, &character, 1, &size);
+    rect.left = (short)LOWORD(position);
+    rect.top = (short)HIWORD(position);
+    rect.right = rect.left + size.cx;
+    rect.bottom = rect.top + size.cy;
+    return TRUE;
+}
+
+// Перерисовка областей подсвеченной пары скобок
+void InvalidateBracketHighlight()
+{
+    HDC hdc = GetDC(hEditControl);
+    HGDIOBJ oldFont = SelectObject(hdc, (HGDIOBJ)SendMessage(hEditControl, WM_GETFONT, 0, 0));
+    for (int i = 0; i < 2; ++i)
+    {
+        RECT rect;
+        if (g_bracketHighlight[i] < g_pChangeTracker->text().length() &&
+            GetEditCharRect(hEditControl, hdc, g_bracketHighlight[i], rect))
+        {
+            InvalidateRect(hEditControl, &rect, TRUE);
+        }
+    }
+    SelectObject(hdc, oldFont);
+    ReleaseDC(hEditControl, hdc);
+}
+
+// Пересчет подсветки после перемещения курсора или правки
+void UpdateBracketHighlight()
+{
+    size_t bracket = 0;
+    size_t match = 0;
+    BOOL isBeforeCaret = FALSE;
+    BOOL hasPair = FindBracketAtCaret(bracket, match, isBeforeCaret);
+    if (hasPair == g_hasBracketHighlight &&
+        (!hasPair || (g_bracketHighlight[0] == bracket && g_bracketHighlight[1] == match)))
+    {
+        return;
+    }
+
+    // Старые рамки стираются, новые рисуются при перерисовке
+    if (g_hasBracketHighlight)
+    {
+        InvalidateBracketHighlight();
+    }
+    g_hasBracketHighlight = hasPair;
+    if (hasPair)
+    {
+        g_bracketHighlight[0] = bracket;
+        g_bracketHighlight[1] = match;
+        InvalidateBracketHighlight();
+    }
+}
+
+// Рамки вокруг пары скобок
+void DrawBracketHighlight(HWND hEdit)
+{
+    if (!g_hasBracketHighlight || !g_pChangeTracker)
+        return;
+
+    HDC hdc = GetDC(hEdit);
+    HGDIOBJ oldFont = SelectObject(hdc, (HGDIOBJ)SendMessage(hEdit, WM_GETFONT, 0, 0));
+    HBRUSH hBrush = CreateSolidBrush(g_textColor);
+    for (int i = 0; i < 2; ++i)
+    {
+        RECT rect;
+        if (g_bracketHighlight[i] < g_pChangeTracker->text().length() &&
+            GetEditCharRect(hEdit, hdc, g_bracketHighlight[i], rect))
+        {
+            FrameRect(hdc, &rect, hBrush);
+        }
+    }
+    DeleteObject(hBrush);
+    SelectObject(hdc, oldFont);
+    ReleaseDC(hEdit, hdc);
+}
+
+// Переход к парной скобке: курсор встает с той же стороны от нее
+void GoToMatchingBracket()
+{
+    size_t bracket = 0;
+    size_t match = 0;
+    BOOL isBeforeCaret = FALSE;
+    if (!FindBracketAtCaret(bracket, match, isBeforeCaret))
+    {
+        if (IsCodeDocument())
+        {
+            MessageBeep(MB_OK);
+        }
+        return;
+    }
+
+    ResetSelections();
+    SetEditorCaret(isBeforeCaret ? match + 1 : match);
+    UpdateBracketHighlight();
+}
+
+// Сворачивание блока с текущей строки. EDIT-контрол не умеет скрывать
+// строки, поэтому блоки сворачиваются только в окне просмотра большого файла
+void ToggleFold(HWND hWnd)
+{
+    (void)hWnd;
+    if (!g_pActiveViewer)
+        return;
+
+    if (!g_pActiveViewer->toggleFold())
+    {
+        MessageBeep(MB_OK);
+    }
+}
+
+// Сравнение строк по правилам языка пользователя
+int CompareLinesLocale(const wchar_t* left, size_t leftLength, const wchar_t* right, size_t rightLength)
+{
+    return CompareStringEx(LOCALE_NAME_USER_DEFAULT, 0, left, (int)leftLength, right, (int)rightLength,
+                           NULL, NULL, 0) - CSTR_EQUAL;
+}
+
+// Сортировка, удаление повторов, обратный порядок или удаление пробелов в
+// конце строк для выделенных строк (без выделения - для всего документа)
+void ApplyLineOperation(HWND hWnd, int command)
+{
+    if (!hEditControl || g_pActiveViewer || !g_pChangeTracker || g_pPasteJob)
+        return;
+
+    ResetSelections();
+    DWORD selectionStart = 0;
+    DWORD selectionEnd = 0;
+    SendMessage(hEditControl, EM_GETSEL, (WPARAM)&selectionStart, (LPARAM)&selectionEnd);
+
+    // Строки читаются из буфера EDIT-контрола без копирования
+    size_t length = (size_t)GetWindowTextLengthW(hEditControl);
+    HLOCAL hBuffer = (HLOCAL)SendMessage(hEditControl, EM_GETHANDLE, 0, 0);
+    const WCHAR* buffer = hBuffer ? (const WCHAR*)LocalLock(hBuffer) : NULL;
+    if (!buffer)
+        return;
+
+    // Участок - целые строки выделения; перевод строки в его конце
+    // (выделение до начала строки, последняя строка файла) остается на месте
+    size_t rangeStart = 0;
+    size_t rangeEnd = length;
+    if (selectionStart != selectionEnd)
+    {
+        rangeStart = (std::min)((size_t)selectionStart, length);
+        rangeEnd = (std::min)((size_t)selectionEnd, length);
+        while (rangeStart > 0 && buffer[rangeStart - 1] != L'\n')
+        {
+            --rangeStart;
+        }
+        if (rangeEnd > 0 && buffer[rangeEnd - 1] != L'\n')
+        {
+            while (rangeEnd < length && buffer[rangeEnd] != L'\r' && buffer[rangeEnd] != L'\n')
+            {
+                ++rangeEnd;
+            }
+        }
+    }
+    if (rangeEnd > rangeStart && buffer[rangeEnd - 1] == L'\n')
+    {
+        --rangeEnd;
+        if (rangeEnd > rangeStart && buffer[rangeEnd - 1] == L'\r')
+        {
+            --rangeEnd;
+        }
+    }
+
+    HCURSOR hOldCursor = SetCursor(LoadCursor(NULL, IDC_WAIT));
+    const WCHAR* range = buffer + rangeStart;
+    std::vector<LineOperations::Line> lines;
+    LineOperations::split(range, rangeEnd - rangeStart, lines);
+    switch (command)
+    {
+    case IDM_EDIT_LINES_SORT:
+        LineOperations::sort(range, lines, CompareLinesLocale, 0);
+        break;
+    case IDM_EDIT_LINES_SORT_ORDINAL:
+        LineOperations::sort(range, lines, LineOperations::Compare(), 0);
+        break;
+    case IDM_EDIT_LINES_UNIQUE:
+        LineOperations::unique(range, lines, 0);
+        break;
+    case IDM_EDIT_LINES_REVERSE:
+        LineOperations::reverse(lines);
+        break;
+    case IDM_EDIT_LINES_TRIM:
+        LineOperations::trimTrailing(range, lines);
+        break;
+    }
+    std::wstring result;
+    LineOperations::join(range, lines, L"\r\n", result);
+
+    // Заменяется только отличающаяся середина участка
+    size_t rangeLength = rangeEnd - rangeStart;
+    size_t prefix = 0;
+    size_t maxCommon = (std::min)(rangeLength, result.size());
+    while (prefix < maxCommon && range[prefix] == result[prefix])
+    {
+        ++prefix;
+    }
+    size_t suffix = 0;
+    while (suffix < maxCommon - prefix &&
+           range[rangeLength - 1 - suffix] == result[result.size() - 1 - suffix])
+    {
+        ++suffix;
+    }
+    LocalUnlock(hBuffer);
+    SetCursor(hOldCursor);
+
+    if (prefix == rangeLength && prefix == result.size())
+    {
+        MessageBeep(MB_OK);
+        return;
+    }
+
+    // EDIT-контрол получает результат одной заменой: отмена возвращает
+    // весь участок за один шаг
+    size_t editStart = rangeStart + prefix;
+    size_t removeCount = rangeLength - prefix - suffix;
+    std::wstring inserted = result.substr(prefix, result.size() - prefix - suffix);
+    SendMessage(hEditControl, WM_SETREDRAW, FALSE, 0);
+    g_isReplacingText = TRUE;
+    SendMessage(hEditControl, EM_SETSEL, (WPARAM)editStart, (LPARAM)(editStart + removeCount));
+    SendMessage(hEditControl, EM_REPLACESEL, TRUE, (LPARAM)inserted.c_str());
+    g_isReplacingText = FALSE;
+
+    g_pChangeTracker->applyEdit(editStart, removeCount, inserted);
+    if (g_pEditJournal)
+    {
+        g_pEditJournal->compactIfNeeded(g_pChangeTracker->text());
+    }
+
+    SendMessage(hEditControl, EM_SETSEL, (WPARAM)rangeStart, (LPARAM)(rangeStart + result.size()));
+    SendMessage(hEditControl, WM_SETREDRAW, TRUE, 0);
+    InvalidateRect(hEditControl, NULL, TRUE);
+    SetFileModified((!g_pTextHash || g_pTextHash->isModified()) ? TRUE : FALSE);
+    UpdateWindowTitle(hWnd);
+}
+
+// Включение режима слежения: новые строки файла дописываются в редактор
+BOOL StartFollowingFile(HWND hWnd)
+{
+    if (!hasFileName || g_pActiveViewer)
+    {
+        MessageBoxW(hWnd, L"Слежение доступно только для файла, открытого в редакторе.",
+                    L"Слежение за файлом", MB_OK | MB_ICONINFORMATION);
+        return FALSE;
+    }
+    if (!g_hasDocumentInfo)
+    {
+        MessageBoxW(hWnd, L"Неизвестно, какая часть файла уже загружена. Сохраните или откройте файл заново.",
+                    L"Слежение за файлом", MB_OK | MB_ICONINFORMATION);
+        return FALSE;
+    }
+
+    LargeFileDocument::Encoding encoding = LargeFileDocument::ENCODING_SINGLE_BYTE;
+    if (g_documentFormat.codePage == CP_UTF8)
+    {
+        encoding = LargeFileDocument::ENCODING_UTF8;
+    }
+    else if (g_documentFormat.codePage == 1200)
+    {
+        encoding = LargeFileDocument::ENCODING_UTF16LE;
+    }
+    else if (g_documentFormat.codePage == 1201)
+    {
+        encoding = LargeFileDocument::ENCODING_UTF16BE;
+    }
+    std::vector<wchar_t> table;
+    BuildSingleByteTable(g_documentFormat.codePage, table);
+
+    // Читается только то, что дописано после загруженной части файла
+    g_pFileTail = new FileTail();
+    g_pFileTail->start(currentFileName, g_documentInfo.size, encoding, table);
+
+    // Уведомления сводятся в одно сообщение, пока предыдущее не обработано
+    UINT generation = g_documentGeneration;
+    g_pFileWatcher = new FileWatcher();
+    if (!g_pFileWatcher->start(currentFileName, [hWnd, generation]()
+        {
+            if (!g_isFollowPending.exchange(true))
+            {
+                PostMessage(hWnd, WM_APP_FILE_APPENDED, generation, 0);
+            }
+        }))
+    {
+        StopFollowingFile(hWnd);
+        MessageBoxW(hWnd, L"Не удалось начать слежение за файлом.", L"Ошибка", MB_OK | MB_ICONERROR);
+        return FALSE;
+    }
+
+    // Снимаем ограничение длины текста EDIT-контрола для растущих журналов
+    SendMessage(hEditControl, EM_SETLIMITTEXT, 0, 0);
+    CheckMenuItem(GetMenu(hWnd), IDM_VIEW_FOLLOW, MF_BYCOMMAND | MF_CHECKED);
+    ReadFollowedFile(hWnd);
+    return TRUE;
+}
+
+// Выключение режима слежения
+void StopFollowingFile(HWND hWnd)
+{
+    if (g_pFileWatcher)
+    {
+        g_pFileWatcher->stop();
+        delete g_pFileWatcher;
+        g_pFileWatcher = nullptr;
+    }
+    if (g_pFileTail)
+    {
+        delete g_pFileTail;
+        g_pFileTail = nullptr;
+    }
+    g_isFollowPending = false;
+    g_isFollowDeferred = FALSE;
+    CheckMenuItem(GetMenu(hWnd), IDM_VIEW_FOLLOW, MF_BYCOMMAND | MF_UNCHECKED);
+}
+
+// Чтение дописанной части файла в режиме слежения
+void ReadFollowedFile(HWND hWnd)
+{
+    std::wstring text;
+    FileTail::Status status = g_pFileTail->read(text);
+    if (status == FileTail::TAIL_TRUNCATED)
+    {
+        // Файл усечен или заменен (ротация журнала): неизмененный документ перечитывается
+        StopFollowingFile(hWnd);
+        if (!isFileModified && LoadFileContent(currentFileName))
+        {
+            SetFileModified(FALSE);
+            SyncChangeTracker(TRUE);
+            StartFollowingFile(hWnd);
+        }
+        else
+        {
+            MessageBoxW(hWnd, L"Файл был усечен на диске. Слежение остановлено.",
+                        L"Слежение за файлом", MB_OK | MB_ICONWARNING);
+        }
+        return;
+    }
+    if (status != FileTail::TAIL_APPENDED)
+        return;
+
+    if (!text.empty())
+    {
+        // Дописанные строки приводятся к CRLF так же, как при открытии файла
+        LineEndingScanner::normalize(text, LineEndingScanner::scanText(text.data(), text.size()));
+        AppendEditorText(text);
+    }
+
+    // Загруженная часть файла выросла; время изменения неизвестно, поэтому
+    // снимок сеанса для такого документа при запуске не используется
+    g_documentInfo.size = g_pFileTail->decodedOffset();
+    g_documentInfo.modifiedTime = 0;
+
+    // Большой прирост читается частями, не блокируя окно надолго
+    if (g_pFileTail->hasMoreData() && !g_isFollowPending.exchange(true))
+    {
+        PostMessage(hWnd, WM_APP_FILE_APPENDED, g_documentGeneration, 0);
+    }
+}
+
+// Дописывание текста в конец EDIT-контрола без записи в историю отмены
+void AppendEditorText(const std::wstring& text)
+{
+    BOOL wasModified = isFileModified;
+    DWORD selectionStart = 0;
+    DWORD selectionEnd = 0;
+    SendMessage(hEditControl, EM_GETSEL, (WPARAM)&selectionStart, (LPARAM)&selectionEnd);
+    LRESULT firstVisibleLine = SendMessage(hEditControl, EM_GETFIRSTVISIBLELINE, 0, 0);
+    int length = GetWindowTextLengthW(hEditControl);
+
+    g_isReplacingText = TRUE;
+    SendMessage(hEditControl, EM_SETSEL, length, length);
+    SendMessage(hEditControl, EM_REPLACESEL, FALSE, (LPARAM)text.c_str());
+    g_isReplacingText = FALSE;
+
+    // Курсор в конце текста следует за новыми строками, иначе позиция сохраняется
+    if (selectionEnd == (DWORD)length)
+    {
+        SendMessage(hEditControl, EM_SCROLLCARET, 0, 0);
+    }
+    else
+    {
+        SendMessage(hEditControl, EM_SETSEL, selectionStart, selectionEnd);
+        LRESULT currentLine = SendMessage(hEditControl, EM_GETFIRSTVISIBLELINE, 0, 0);
+        SendMessage(hEditControl, EM_LINESCROLL, 0, firstVisibleLine - currentLine);
+    }
+
+    // Правка передается теневой копии напрямую, без сравнения всего текста
+    if (g_pChangeTracker)
+    {
+        g_pChangeTracker->applyEdit((size_t)length, 0, text);
+        if (g_pEditJournal)
+        {
+            g_pEditJournal->compactIfNeeded(g_pChangeTracker->text());
+            if (!wasModified)
+            {
+                g_pEditJournal->markInSync();
+            }
+        }
+    }
+
+    // Дописанный текст совпадает с файлом на диске
+    if (!wasModified && g_pTextHash)
+    {
+        g_pTextHash->markSaved();
+    }
+}
+
+// Файл активного документа изменен на диске после загрузки или сохранения
+BOOL IsFileChangedOnDisk()
+{
+    // В режиме слежения дописывание файла ожидаемо и обрабатывается отдельно
+    if (!hasFileName || g_pActiveViewer || g_pFileWatcher || !g_hasDocumentInfo)
+        return FALSE;
+
+    PortableFile::Info info;
+    if (!PortableFile::getInfo(currentFileName, info))
+        return FALSE; // Файл удален: сохранение создаст его заново
+
+    if (info.size == g_documentInfo.size && info.modifiedTime == g_documentInfo.modifiedTime)
+        return FALSE;
+
+    // Время изменения могло смениться без изменения содержимого
+    if (SessionSnapshot::verifyContent(currentFileName, g_documentHash))
+    {
+        g_documentInfo = info;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// Проверка изменений файла другой программой
+void CheckExternalChanges(HWND hWnd)
+{
+    static BOOL isChecking = FALSE;
+    if (isChecking || !IsFileChangedOnDisk())
+        return;
+
+    // Окно сообщения не должно запускать повторную проверку
+    isChecking = TRUE;
+    if (!isFileModified)
+    {
+        ReloadDocumentIncrementally(hWnd);
+    }
+    else if (MessageBoxW(hWnd,
+                 L"Файл был изменен другой программой.\n\nПерезагрузить его? Несохраненные изменения будут потеряны.",
+                 L"Файл изменен", MB_YESNO | MB_ICONWARNING) == IDYES)
+    {
+        ReloadDocumentIncrementally(hWnd);
+    }
+    else
+    {
+        // Пользователь оставил свою версию: эта версия файла больше не предлагается
+        g_hasDocumentInfo = PortableFile::getInfo(currentFileName, g_documentInfo) ? TRUE : FALSE;
+    }
+    isChecking = FALSE;
+}
+
+// Отмена правки из нескольких участков одним шагом. Отмененная правка
+// становится новой группой, поэтому повторная отмена возвращает ее, как
+// и у самого EDIT-контрола
+BOOL ApplyUndoGroup()
+{
+    if (!g_pUndoGroup || !hEditControl)
+        return FALSE;
+
+    UndoGroup* group = g_pUndoGroup;
+    g_pUndoGroup = nullptr;
+
+    // Текущий текст участков становится текстом обратной группы
+    UndoGroup* inverse = new UndoGroup();
+    inverse->spans.resize(group->spans.size());
+    HLOCAL hBuffer = (HLOCAL)SendMessage(hEditControl, EM_GETHANDLE, 0, 0);
+    const WCHAR* current = hBuffer ? (const WCHAR*)LocalLock(hBuffer) : NULL;
+    if (!current)
+    {
+        delete group;
+        delete inverse;
+        return FALSE;
+    }
+    long long delta = 0;
+    for (size_t i = 0; i < group->spans.size(); ++i)
+    {
+        const UndoGroup::Span& span = group->spans[i];
+        inverse->spans[i].offset = (size_t)((long long)span.offset + delta);
+        inverse->spans[i].length = span.text.size();
+        inverse->spans[i].text.assign(current + span.offset, span.length);
+        delta += (long long)span.text.size() - (long long)span.length;
+    }
+    LocalUnlock(hBuffer);
+
+    // Участки заменяются с конца; теневая копия получает те же правки
+    ResetSelections();
+    SendMessage(hEditControl, WM_SETREDRAW, FALSE, 0);
+    g_isReplacingText = TRUE;
+    for (size_t i = group->spans.size(); i-- > 0;)
+    {
+        const UndoGroup::Span& span = group->spans[i];
+        SendMessage(hEditControl, EM_SETSEL, (WPARAM)span.offset, (LPARAM)(span.offset + span.length));
+        SendMessage(hEditControl, EM_REPLACESEL, FALSE, (LPARAM)span.text.c_str());
+        if (g_pChangeTracker)
+        {
+            g_pChangeTracker->applyEdit(span.offset, span.length, span.text);
+        }
+    }
+    g_isReplacingText = FALSE;
+    SendMessage(hEditControl, EM_EMPTYUNDOBUFFER, 0, 0);
+    SendMessage(hEditControl, WM_SETREDRAW, TRUE, 0);
+    InvalidateRect(hEditControl, NULL, TRUE);
+    if (!inverse->spans.empty())
+    {
+        SetEditorCaret(inverse->spans[0].offset);
+    }
+    delete group;
+    g_pUndoGroup = inverse;
+
+    if (g_pChangeTracker && g_pEditJournal)
+    {
+        g_pEditJournal->compactIfNeeded(g_pChangeTracker->text());
+    }
+    SetFileModified((!g_pTextHash || g_pTextHash->isModified()) ? TRUE : FALSE);
+    return TRUE;
+}
+
+// Отказ от групповой отмены (после другой правки или смены текста)
+void DiscardUndoGroup()
+{
+    if (g_pUndoGroup)
+    {
+        delete g_pUndoGroup;
+        g_pUndoGroup = nullptr;
+    }
+}
+
+// Перечитывание файла с заменой только изменившихся строк
+BOOL ReloadDocumentIncrementally(HWND hWnd)
+{
+    std::wstring text;
+    DocumentFormat format;
+    ULONGLONG contentHash = 0;
+    if (!hEditControl || !ReadTextFile(currentFileName, text, format, contentHash))
+        return FALSE;
+
+    // Новый текст сравнивается с буфером EDIT-контрола без копирования
+    HLOCAL hBuffer = (HLOCAL)SendMessage(hEditControl, EM_GETHANDLE, 0, 0);
+    const WCHAR* current = hBuffer ? (const WCHAR*)LocalLock(hBuffer) : NULL;
+    if (!current)
+        return FALSE;
+    std::vector<LineDiff::Hunk> hunks;
+    LineDiff::compute(current, (size_t)GetWindowTextLengthW(hEditControl), text.c_str(), text.size(), hunks);
+
+    // Близкие фрагменты заменяются вместе, далекие - каждый своей правкой;
+    // прежний текст участков запоминается для групповой отмены
+    std::vector<LineDiff::Hunk> spans;
+    LineDiff::mergeHunks(hunks, RELOAD_MERGE_GAP, spans);
+    UndoGroup* group = new UndoGroup();
+    group->spans.resize(spans.size());
+    for (size_t i = 0; i < spans.size(); ++i)
+    {
+        group->spans[i].offset = spans[i].newOffset;
+        group->spans[i].length = spans[i].newLength;
+        group->spans[i].text.assign(current + spans[i].oldOffset, spans[i].oldLength);
+    }
+    LocalUnlock(hBuffer);
+
+    DWORD selectionStart = 0;
+    DWORD selectionEnd = 0;
+    SendMessage(hEditControl, EM_GETSEL, (WPARAM)&selectionStart, (LPARAM)&selectionEnd);
+    LRESULT firstVisibleLine = SendMessage(hEditControl, EM_GETFIRSTVISIBLELINE, 0, 0);
+    LRESULT firstVisibleOffset = SendMessage(hEditControl, EM_LINEINDEX, (WPARAM)firstVisibleLine, 0);
+
+    // Участки заменяются с конца, чтобы не сдвигать смещения предыдущих
+    ResetSelections();
+    SendMessage(hEditControl, WM_SETREDRAW, FALSE, 0);
+    g_isReplacingText = TRUE;
+    for (size_t i = spans.size(); i-- > 0;)
+    {
+        const LineDiff::Hunk& span = spans[i];
+        std::wstring replacement = text.substr(span.newOffset, span.newLength);
+        SendMessage(hEditControl, EM_SETSEL, (WPARAM)span.oldOffset, (LPARAM)(span.oldOffset + span.oldLength));
+        SendMessage(hEditControl, EM_REPLACESEL, FALSE, (LPARAM)replacement.c_str());
+    }
+
+    // Теневой копии передаются сами фрагменты (с конца, чтобы не сдвигать
+    // смещения предыдущих): журнал и индексы получают только изменения
+    if (g_pChangeTracker)
+    {
+        for (size_t i = hunks.size(); i-- > 0;)
+        {
+            const LineDiff::Hunk& hunk = hunks[i];
+            g_pChangeTracker->applyEdit(hunk.oldOffset, hunk.oldLength, text.data() + hunk.newOffset, hunk.newLength);
+        }
+    }
+    g_isReplacingText = FALSE;
+
+    // EDIT-контрол отменил бы только последний участок: отмену выполняет группа
+    SendMessage(hEditControl, EM_EMPTYUNDOBUFFER, 0, 0);
+    if (!spans.empty())
+    {
+        g_pUndoGroup = group;
+    }
+    else
+    {
+        delete group;
+    }
+
+    // Выделение и прокрутка переносятся через найденные фрагменты
+    SendMessage(hEditControl, EM_SETSEL, (WPARAM)LineDiff::mapOffset(hunks, selectionStart),
+                (LPARAM)LineDiff::mapOffset(hunks, selectionEnd));
+    if (firstVisibleOffset >= 0)
+    {
+        LRESULT targetLine = SendMessage(hEditControl, EM_LINEFROMCHAR,
+                                         (WPARAM)LineDiff::mapOffset(hunks, (size_t)firstVisibleOffset), 0);
+        LRESULT currentLine = SendMessage(hEditControl, EM_GETFIRSTVISIBLELINE, 0, 0);
+        SendMessage(hEditControl, EM_LINESCROLL, 0, targetLine - currentLine);
+    }
+    SendMessage(hEditControl, WM_SETREDRAW, TRUE, 0);
+    InvalidateRect(hEditControl, NULL, TRUE);
+
+    // Текст снова совпадает с файлом на диске
+    SetFileModified(FALSE);
+    RememberDocumentFile(format, contentHash);
+    if (g_pChangeTracker && g_pEditJournal)
+    {
+        g_pEditJournal->compactIfNeeded(g_pChangeTracker->text());
+        g_pEditJournal->markInSync();
+    }
+    UpdateWindowTitle(hWnd);
+    return TRUE;
+}
+
+// Сравнение текста редактора с сохраненным файлом или с другим файлом
+void CompareWithFile(HWND hWnd, BOOL askFile)
+{
+    if (g_pActiveViewer)
+    {
+        MessageBoxW(hWnd, L"Большой файл открыт только для просмотра и не сравнивается.",
+                    L"Сравнение", MB_OK | MB_ICONINFORMATION);
+        return;
+    }
+
+    std::wstring filePath;
+    if (askFile)
+    {
+        WCHAR fileBuffer[MAX_PATH] = { 0 };
+        WCHAR filterBuffer[MAX_LOADSTRING * 2];
+        LoadFileDialogFilters(filterBuffer, MAX_LOADSTRING * 2);
+
+        OPENFILENAME ofn;
+        ZeroMemory(&ofn, sizeof(ofn));
+        ofn.lStructSize = sizeof(ofn);
+        ofn.hwndOwner = hWnd;
+        ofn.lpstrFile = fileBuffer;
+        ofn.nMaxFile = MAX_PATH;
+        ofn.lpstrFilter = filterBuffer;
+        ofn.nFilterIndex = 1;
+        ofn.lpstrTitle = L"Сравнить с файлом";
+        ofn.Flags = OFN_EXPLORER | OFN_FILEMUSTEXIST | OFN_HIDEREADONLY;
+        if (!GetOpenFileName(&ofn))
+            return;
+        filePath = fileBuffer;
+    }
+    else if (hasFileName)
+    {
+        filePath = currentFileName;
+    }
+    else
+    {
+        MessageBoxW(hWnd, L"Документ еще не сохранен.", L"Сравнение", MB_OK | MB_ICONINFORMATION);
+        return;
+    }
+
+    // Большой файл целиком в память не читается
+    if (IsLargeFile(filePath.c_str()))
+    {
+        MessageBoxW(hWnd, L"Файл слишком большой для сравнения.", L"Сравнение", MB_OK | MB_ICONINFORMATION);
+        return;
+    }
+
+    std::wstring fileText;
+    DocumentFormat format;
+    ULONGLONG contentHash = 0;
+    if (!ReadTextFile(filePath.c_str(), fileText, format, contentHash))
+    {
+        MessageBoxW(hWnd, L"Не удалось прочитать файл", L"Ошибка", MB_OK | MB_ICONERROR);
+        return;
+    }
+
+    std::wstring editorText((size_t)GetWindowTextLengthW(hEditControl), L'\0');
+    if (!editorText.empty())
+    {
+        GetWindowTextW(hEditControl, &editorText[0], (int)editorText.size() + 1);
+    }
+
+    if (!g_pCompareView)
+    {
+        g_pCompareView = new CompareView(hInst);
+    }
+
+    // Сравнение идет в фоне; окно сравнения открывается сразу
+    const WCHAR* fileName = wcsrchr(filePath.c_str(), L'\\');
+    std::wstring oldTitle = fileName ? fileName + 1 : filePath;
+    if (!g_pCompareView->compare(hWnd, oldTitle, fileText, L"Текущий текст", editorText))
+    {
+        MessageBoxW(hWnd, L"Не удалось открыть окно сравнения.", L"Ошибка", MB_OK | MB_ICONERROR);
+        return;
+    }
+    g_pCompareView->setFont(g_hCurrentFont);
+    g_pCompareView->setColors(g_textColor, g_backgroundColor);
+}
+
+// Создание строки состояния
+void CreateStatusBar(HWND hParent)
+{
+    hStatusBar = CreateWindowExW(
+        0,
+        STATUSCLASSNAMEW,
+        L"",
+        WS_CHILD | WS_VISIBLE | SBARS_SIZEGRIP,
+        0, 0, 0, 0,
+        hParent,
+        NULL,
+        hInst,
+        NULL
+    );
+}
+
+// Обновление строки состояния после обработки текущих сообщений
+// (серия правок или движений курсора дает одно обновление)
+void RequestStatusUpdate()
+{
+    if (hStatusBar && hMainWnd && !g_isStatusUpdatePending)
+    {
+        g_isStatusUpdatePending = TRUE;
+        PostMessage(hMainWnd, WM_APP_STATUS_UPDATE, 0, 0);
+    }
+}
+
+// Позиция курсора и счетчики документа в строке состояния
+void UpdateStatusBar()
+{
+    if (!hStatusBar)
+        return;
+
+    WCHAR parts[5][64] = {};
+    if (g_pActiveViewer)
+    {
+        wcscpy_s(parts[0], 64, L"Просмотр большого файла");
+    }
+    else if (hEditControl && g_pChangeTracker && g_pLineIndex && g_pStatistics)
+    {
+        // Позиция и счетчики берутся из индексов теневой копии без чтения текста
+        const ChunkedText& text = g_pChangeTracker->text();
+        // Курсор может стоять в начале выделения (выделение влево), поэтому
+        // берется отслеживаемый курсор, а при нескольких курсорах - основной
+        size_t caret = (g_selections.count() > 1) ? g_selections.primary().caret : g_editCaret;
+        caret = (std::min)(caret, text.length());
+        size_t line = g_pLineIndex->lineOfOffset(text, caret);
+        size_t column = caret - g_pLineIndex->lineStart(text, line);
+
+        TextStatistics::Counts counts = g_pStatistics->totals();
+        swprintf_s(parts[0], 64, L"Стр %zu, стлб %zu", line + 1, column + 1);
+        swprintf_s(parts[1], 64, L"Символов: %zu", counts.characters);
+        swprintf_s(parts[2], 64, L"Слов: %zu", counts.words);
+        swprintf_s(parts[3], 64, L"Строк: %zu", counts.lines);
+        swprintf_s(parts[4], 64, L"Не ASCII: %zu", counts.nonAscii);
+    }
+
+    for (int i = 0; i < 5; ++i)
+    {
+        SendMessage(hStatusBar, SB_SETTEXTW, i, (LPARAM)parts[i]);
+    }
+}
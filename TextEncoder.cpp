@@ -0,0 +1,336 @@
+#include "TextEncoder.h"
+#include "ChunkedText.h"
+#include "ContentHash.h"
+#include "PortableFile.h"
+
+// Определение нужно: константа передается по ссылке (assign)
+const unsigned short TextEncoder::UNMAPPED;
+
+namespace
+{
+    const unsigned int REPLACEMENT_CHARACTER = 0xFFFD;
+
+    /**
+     * @brief Приемник, который только считает байты
+     */
+    struct CountingSink
+    {
+        uint64_t size;
+
+        CountingSink() : size(0) {}
+        void put(unsigned char) { ++size; }
+        bool flushIfFull() { return true; }
+        bool flush() { return true; }
+    };
+
+    /**
+     * @brief Приемник, собирающий байты в строку
+     */
+    struct StringSink
+    {
+        std::string& output;
+
+        explicit StringSink(std::string& target) : output(target) {}
+        void put(unsigned char byte) { output.push_back(static_cast<char>(byte)); }
+        bool flushIfFull() { return true; }
+        bool flush() { return true; }
+    };
+
+    /**
+     * @brief Приемник, пишущий байты в файл блоками и считающий их хеш
+     */
+    struct FileSink
+    {
+        FILE* file;
+        ContentHash& hash;
+        std::string buffer;
+
+        FileSink(FILE* target, ContentHash& contentHash) : file(target), hash(contentHash)
+        {
+            buffer.reserve(TextEncoder::WRITE_BLOCK_SIZE + 16);
+        }
+
+        void put(unsigned char byte) { buffer.push_back(static_cast<char>(byte)); }
+
+        bool flushIfFull()
+        {
+            return buffer.size() < TextEncoder::WRITE_BLOCK_SIZE || flush();
+        }
+
+        bool flush()
+        {
+            if (buffer.empty())
+            {
+                return true;
+            }
+            hash.update(buffer.data(), buffer.size());
+            bool success = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+            buffer.clear();
+            return success;
+        }
+    };
+}
+
+TextEncoder::TextEncoder(const DocumentFormat& format, const std::vector<wchar_t>& singleByteTable)
+    : m_format(format)
+{
+    if (m_format.codePage == DocumentFormat::CODE_PAGE_UTF8 ||
+        m_format.codePage == DocumentFormat::CODE_PAGE_UTF16LE ||
+        m_format.codePage == DocumentFormat::CODE_PAGE_UTF16BE)
+    {
+        return;
+    }
+
+    // Обратная таблица; при повторах символа берется меньший байт
+    m_reverseTable.assign(65536, UNMAPPED);
+    for (int byte = 255; byte >= 0; --byte)
+    {
+        wchar_t symbol = singleByteTable.size() == 256 ? singleByteTable[byte] : static_cast<wchar_t>(byte);
+        if (symbol == L'?' && byte != '?')
+        {
+            continue;
+        }
+        m_reverseTable[static_cast<unsigned short>(symbol)] = static_cast<unsigned short>(byte);
+    }
+}
+
+TextEncoder::Measure TextEncoder::measure(const ChunkedText& text) const
+{
+    CountingSink sink;
+    State state;
+    run(text, sink, state);
+
+    Measure result;
+    result.size = sink.size;
+    result.unmappableCount = state.unmappableCount;
+    return result;
+}
+
+void TextEncoder::encode(const ChunkedText& text, std::string& output) const
+{
+    output.clear();
+    StringSink sink(output);
+    State state;
+    run(text, sink, state);
+}
+
+bool TextEncoder::writeFile(const std::wstring& path, const ChunkedText& text, const Measure& measured,
+                            uint64_t& contentHash) const
+{
+    FILE* file = PortableFile::open(path, "wb");
+    if (!file)
+    {
+        return false;
+    }
+
+    ContentHash hash(measured.size);
+    FileSink sink(file, hash);
+    State state;
+    bool success = run(text, sink, state);
+    success = (fclose(file) == 0) && success;
+    contentHash = hash.finish();
+    return success;
+}
+
+template <typename Sink>
+bool TextEncoder::run(const ChunkedText& text, Sink& sink, State& state) const
+{
+    state.hasCarriageReturn = false;
+    state.highSurrogate = 0;
+    state.unmappableCount = 0;
+
+    if (m_format.hasBom)
+    {
+        if (m_format.codePage == DocumentFormat::CODE_PAGE_UTF8)
+        {
+            sink.put(0xEF);
+            sink.put(0xBB);
+            sink.put(0xBF);
+        }
+        else if (m_format.codePage == DocumentFormat::CODE_PAGE_UTF16LE)
+        {
+            sink.put(0xFF);
+            sink.put(0xFE);
+        }
+        else if (m_format.codePage == DocumentFormat::CODE_PAGE_UTF16BE)
+        {
+            sink.put(0xFE);
+            sink.put(0xFF);
+        }
+    }
+
+    for (size_t i = 0; i < text.chunkCount(); ++i)
+    {
+        const std::wstring& chunk = text.chunkText(i);
+        if (!encodeRange(chunk.data(), chunk.size(), sink, state))
+        {
+            return false;
+        }
+    }
+
+    // Отложенные символы в конце текста
+    if (state.hasCarriageReturn)
+    {
+        state.hasCarriageReturn = false;
+        putUnit(L'\r', sink, state);
+    }
+    flushSurrogate(sink, state);
+    return sink.flush();
+}
+
+template <typename Sink>
+bool TextEncoder::encodeRange(const wchar_t* text, size_t length, Sink& sink, State& state) const
+{
+    bool convertsLineEndings = m_format.lineEnding != DocumentFormat::LINE_ENDING_CRLF;
+    for (size_t i = 0; i < length; ++i)
+    {
+        wchar_t unit = text[i];
+        if (state.hasCarriageReturn)
+        {
+            state.hasCarriageReturn = false;
+            if (unit == L'\n')
+            {
+                putLineEnding(sink, state);
+                continue;
+            }
+            putUnit(L'\r', sink, state);
+        }
+
+        if (unit == L'\r' && convertsLineEndings)
+        {
+            state.hasCarriageReturn = true;
+            continue;
+        }
+        putUnit(unit, sink, state);
+    }
+    return sink.flushIfFull();
+}
+
+template <typename Sink>
+void TextEncoder::putUnit(wchar_t unit, Sink& sink, State& state) const
+{
+    unsigned int value = static_cast<unsigned int>(unit);
+    switch (m_format.codePage)
+    {
+    case DocumentFormat::CODE_PAGE_UTF16LE:
+    case DocumentFormat::CODE_PAGE_UTF16BE:
+        if (sizeof(wchar_t) > 2 && value >= 0x10000)
+        {
+            // 32-битный wchar_t: символ вне BMP записывается суррогатной парой
+            value -= 0x10000;
+            putUtf16(0xD800 + (value >> 10), sink);
+            putUtf16(0xDC00 + (value & 0x3FF), sink);
+        }
+        else
+        {
+            putUtf16(value, sink);
+        }
+        return;
+
+    case DocumentFormat::CODE_PAGE_UTF8:
+        if (value >= 0xD800 && value <= 0xDBFF)
+        {
+            flushSurrogate(sink, state);
+            state.highSurrogate = unit;
+            return;
+        }
+        if (value >= 0xDC00 && value <= 0xDFFF)
+        {
+            if (state.highSurrogate)
+            {
+                unsigned int high = static_cast<unsigned int>(state.highSurrogate);
+                state.highSurrogate = 0;
+                putCodePoint(0x10000 + ((high - 0xD800) << 10) + (value - 0xDC00), sink, state);
+            }
+            else
+            {
+                putCodePoint(REPLACEMENT_CHARACTER, sink, state);
+            }
+            return;
+        }
+        flushSurrogate(sink, state);
+        putCodePoint(value, sink, state);
+        return;
+
+    default:
+    {
+        unsigned short byte = value <= 0xFFFF ? m_reverseTable[value] : UNMAPPED;
+        if (byte == UNMAPPED)
+        {
+            ++state.unmappableCount;
+            byte = '?';
+        }
+        sink.put(static_cast<unsigned char>(byte));
+        return;
+    }
+    }
+}
+
+template <typename Sink>
+void TextEncoder::putUtf16(unsigned int unit, Sink& sink) const
+{
+    unsigned char low = static_cast<unsigned char>(unit & 0xFF);
+    unsigned char high = static_cast<unsigned char>((unit >> 8) & 0xFF);
+    if (m_format.codePage == DocumentFormat::CODE_PAGE_UTF16LE)
+    {
+        sink.put(low);
+        sink.put(high);
+    }
+    else
+    {
+        sink.put(high);
+        sink.put(low);
+    }
+}
+
+template <typename Sink>
+void TextEncoder::putCodePoint(unsigned int codePoint, Sink& sink, State& state) const
+{
+    (void)state;
+    if (codePoint < 0x80)
+    {
+        sink.put(static_cast<unsigned char>(codePoint));
+    }
+    else if (codePoint < 0x800)
+    {
+        sink.put(static_cast<unsigned char>(0xC0 | (codePoint >> 6)));
+        sink.put(static_cast<unsigned char>(0x80 | (codePoint & 0x3F)));
+    }
+    else if (codePoint < 0x10000)
+    {
+        sink.put(static_cast<unsigned char>(0xE0 | (codePoint >> 12)));
+        sink.put(static_cast<unsigned char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        sink.put(static_cast<unsigned char>(0x80 | (codePoint & 0x3F)));
+    }
+    else
+    {
+        sink.put(static_cast<unsigned char>(0xF0 | (codePoint >> 18)));
+        sink.put(static_cast<unsigned char>(0x80 | ((codePoint >> 12) & 0x3F)));
+        sink.put(static_cast<unsigned char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        sink.put(static_cast<unsigned char>(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+template <typename Sink>
+void TextEncoder::flushSurrogate(Sink& sink, State& state) const
+{
+    // Старшая половина без младшей записывается как U+FFFD (так же, как в Utf8Codec)
+    if (state.highSurrogate)
+    {
+        state.highSurrogate = 0;
+        putCodePoint(REPLACEMENT_CHARACTER, sink, state);
+    }
+}
+
+template <typename Sink>
+void TextEncoder::putLineEnding(Sink& sink, State& state) const
+{
+    if (m_format.lineEnding != DocumentFormat::LINE_ENDING_LF)
+    {
+        putUnit(L'\r', sink, state);
+    }
+    if (m_format.lineEnding != DocumentFormat::LINE_ENDING_CR)
+    {
+        putUnit(L'\n', sink, state);
+    }
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "DocumentFormat.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ChunkedText;
+
+/**
+ * @brief Потоковое кодирование текста документа в формат файла
+ *
+ * Текст кодируется по блокам ChunkedText прямо в файл, без промежуточной
+ * копии всего документа ни в Unicode, ни в байтах. Переводы строк "\r\n"
+ * (так их хранит EDIT-контрол) заменяются на стиль документа; пара "\r\n"
+ * и суррогатная пара могут быть разрезаны границей блоков. Символы, которых
+ * нет в однобайтовой кодировке, заменяются на '?' и подсчитываются.
+ * Не зависит от WinAPI.
+ */
+class TextEncoder
+{
+public:
+    static const size_t WRITE_BLOCK_SIZE = 1024 * 1024;    ///< Размер блока записи (байт)
+
+    /**
+     * @brief Размер результата кодирования
+     */
+    struct Measure
+    {
+        uint64_t size;              ///< Размер файла в байтах (вместе с BOM)
+        uint64_t unmappableCount;   ///< Символов, замененных на '?'
+    };
+
+    /**
+     * @brief Конструктор
+     * @param format Формат файла
+     * @param singleByteTable Таблица однобайтовой кодировки: 256 символов по
+     *        значению байта (для UTF-8 и UTF-16 не используется; пустая таблица -
+     *        Latin-1)
+     */
+    TextEncoder(const DocumentFormat& format, const std::vector<wchar_t>& singleByteTable);
+
+    /**
+     * @brief Посчитать размер результата без записи
+     * @param text Текст
+     * @return Размер и число незаписываемых символов
+     */
+    Measure measure(const ChunkedText& text) const;
+
+    /**
+     * @brief Закодировать текст в строку байтов
+     * @param text Текст
+     * @param output Результат (вместе с BOM)
+     */
+    void encode(const ChunkedText& text, std::string& output) const;
+
+    /**
+     * @brief Записать текст в файл
+     * @param path Путь к файлу
+     * @param text Текст
+     * @param measured Результат measure для этого же текста (нужен для хеша)
+     * @param contentHash Хеш записанных байтов (ContentHash)
+     * @return false при ошибке записи
+     */
+    bool writeFile(const std::wstring& path, const ChunkedText& text, const Measure& measured,
+                   uint64_t& contentHash) const;
+
+private:
+    /**
+     * @brief Состояние между блоками текста
+     */
+    struct State
+    {
+        bool hasCarriageReturn;     ///< Отложенный '\r' (возможно, начало "\r\n")
+        wchar_t highSurrogate;      ///< Отложенная старшая половина суррогатной пары (0 - нет)
+        uint64_t unmappableCount;   ///< Символов, замененных на '?'
+    };
+
+    DocumentFormat m_format;                    ///< Формат файла
+    std::vector<unsigned short> m_reverseTable; ///< Байт однобайтовой кодировки по символу
+
+    static const unsigned short UNMAPPED = 0xFFFF;
+
+    /**
+     * @brief Прогнать текст через кодировщик
+     * @param text Текст
+     * @param sink Приемник байтов (put, flush)
+     * @return false если приемник сообщил об ошибке
+     */
+    template <typename Sink>
+    bool run(const ChunkedText& text, Sink& sink, State& state) const;
+
+    /**
+     * @brief Закодировать фрагмент
+     */
+    template <typename Sink>
+    bool encodeRange(const wchar_t* text, size_t length, Sink& sink, State& state) const;
+
+    /**
+     * @brief Закодировать один символ (перевод строк уже обработан)
+     */
+    template <typename Sink>
+    void putUnit(wchar_t unit, Sink& sink, State& state) const;
+
+    /**
+     * @brief Записать двухбайтовую единицу UTF-16 в порядке байтов документа
+     */
+    template <typename Sink>
+    void putUtf16(unsigned int unit, Sink& sink) const;
+
+    /**
+     * @brief Закодировать кодовую точку Unicode в UTF-8
+     */
+    template <typename Sink>
+    void putCodePoint(unsigned int codePoint, Sink& sink, State& state) const;
+
+    /**
+     * @brief Завершить отложенную суррогатную пару (одиночная половина)
+     */
+    template <typename Sink>
+    void flushSurrogate(Sink& sink, State& state) const;
+
+    /**
+     * @brief Записать перевод строк в стиле документа
+     */
+    template <typename Sink>
+    void putLineEnding(Sink& sink, State& state) const;
+};
@@ -0,0 +1,205 @@
+#include "TextStatistics.h"
+#include <algorithm>
+
+TextStatistics::TextStatistics()
+    : m_leafCount(1)
+    , m_chunkCount(0)
+{
+    m_tree.assign(2, empty());
+}
+
+void TextStatistics::onTextReset(const ChunkedText& text)
+{
+    std::vector<Summary> summaries(text.chunkCount());
+    for (size_t i = 0; i < text.chunkCount(); ++i)
+    {
+        summaries[i] = summarize(text.chunkText(i));
+    }
+    rebuild(summaries);
+}
+
+void TextStatistics::onTextEdited(const ChunkedText& text, const TextEdit& edit, const ChunkChange& change)
+{
+    (void)edit;
+
+    if (change.removedChunks == change.insertedChunks)
+    {
+        // Структура не изменилась - обновляем пути от затронутых листьев
+        for (size_t i = 0; i < change.insertedChunks; ++i)
+        {
+            size_t index = change.firstChunk + i;
+            updateLeaf(index, summarize(text.chunkText(index)));
+        }
+        return;
+    }
+
+    std::vector<Summary> inserted(change.insertedChunks);
+    for (size_t i = 0; i < change.insertedChunks; ++i)
+    {
+        inserted[i] = summarize(text.chunkText(change.firstChunk + i));
+    }
+
+    size_t newChunkCount = m_chunkCount - change.removedChunks + change.insertedChunks;
+    if (newChunkCount > m_leafCount)
+    {
+        std::vector<Summary> summaries(m_tree.begin() + m_leafCount, m_tree.begin() + m_leafCount + m_chunkCount);
+        summaries.erase(summaries.begin() + change.firstChunk,
+                        summaries.begin() + change.firstChunk + change.removedChunks);
+        summaries.insert(summaries.begin() + change.firstChunk, inserted.begin(), inserted.end());
+        rebuild(summaries);
+        return;
+    }
+
+    // Листья помещаются в дерево - сдвигаем хвост на месте и пересчитываем
+    // только узлы над листьями от первого измененного блока
+    std::vector<Summary>::iterator leaves = m_tree.begin() + m_leafCount;
+    std::vector<Summary>::iterator tail = leaves + change.firstChunk + change.removedChunks;
+    if (change.insertedChunks > change.removedChunks)
+    {
+        std::copy_backward(tail, leaves + m_chunkCount, leaves + newChunkCount);
+    }
+    else
+    {
+        std::copy(tail, leaves + m_chunkCount, leaves + change.firstChunk + change.insertedChunks);
+        std::fill(leaves + newChunkCount, leaves + m_chunkCount, empty());
+    }
+    std::copy(inserted.begin(), inserted.end(), leaves + change.firstChunk);
+
+    size_t last = std::max(m_chunkCount, newChunkCount) - 1;
+    m_chunkCount = newChunkCount;
+    updateNodes(change.firstChunk, last);
+}
+
+TextStatistics::Counts TextStatistics::totals() const
+{
+    const Summary& root = m_tree[1];
+    Counts counts = { root.characters, root.words, root.lineFeeds + 1, root.nonAscii };
+    return counts;
+}
+
+bool TextStatistics::isSpace(wchar_t character)
+{
+    if (character <= L' ')
+    {
+        return character == L' ' || (character >= L'\t' && character <= L'\r');
+    }
+    if (character < 0x85)
+    {
+        return false;
+    }
+    return character == 0x85 || character == 0xA0 || character == 0x1680 ||
+           (character >= 0x2000 && character <= 0x200A) || character == 0x2028 || character == 0x2029 ||
+           character == 0x202F || character == 0x205F || character == 0x3000;
+}
+
+TextStatistics::Summary TextStatistics::summarize(const std::wstring& chunk)
+{
+    Summary summary = empty();
+    bool isInWord = false;
+    for (size_t i = 0; i < chunk.size(); ++i)
+    {
+        wchar_t character = chunk[i];
+        if (isSpace(character))
+        {
+            isInWord = false;
+            if (character == L'\n')
+            {
+                ++summary.lineFeeds;
+                continue;
+            }
+            if (character == L'\r')
+            {
+                continue;
+            }
+        }
+        else if (!isInWord)
+        {
+            isInWord = true;
+            ++summary.words;
+        }
+
+        // Вторая половина суррогатной пары не считается отдельным символом
+        if (character >= 0xDC00 && character <= 0xDFFF)
+        {
+            continue;
+        }
+        ++summary.characters;
+        if (character >= 0x80)
+        {
+            ++summary.nonAscii;
+        }
+    }
+
+    if (!chunk.empty())
+    {
+        summary.isEmpty = false;
+        summary.startsInWord = !isSpace(chunk[0]);
+        summary.endsInWord = isInWord;
+    }
+    return summary;
+}
+
+TextStatistics::Summary TextStatistics::combine(const Summary& left, const Summary& right)
+{
+    if (left.isEmpty)
+    {
+        return right;
+    }
+    if (right.isEmpty)
+    {
+        return left;
+    }
+
+    // Слово, разрезанное границей участков, посчитано в обоих
+    Summary summary;
+    summary.characters = left.characters + right.characters;
+    summary.words = left.words + right.words - ((left.endsInWord && right.startsInWord) ? 1 : 0);
+    summary.lineFeeds = left.lineFeeds + right.lineFeeds;
+    summary.nonAscii = left.nonAscii + right.nonAscii;
+    summary.isEmpty = false;
+    summary.startsInWord = left.startsInWord;
+    summary.endsInWord = right.endsInWord;
+    return summary;
+}
+
+TextStatistics::Summary TextStatistics::empty()
+{
+    Summary summary = { 0, 0, 0, 0, true, false, false };
+    return summary;
+}
+
+void TextStatistics::rebuild(const std::vector<Summary>& summaries)
+{
+    m_chunkCount = summaries.size();
+    m_leafCount = 1;
+    while (m_leafCount < m_chunkCount)
+    {
+        m_leafCount *= 2;
+    }
+
+    m_tree.assign(2 * m_leafCount, empty());
+    std::copy(summaries.begin(), summaries.end(), m_tree.begin() + m_leafCount);
+    for (size_t node = m_leafCount - 1; node > 0; --node)
+    {
+        m_tree[node] = combine(m_tree[2 * node], m_tree[2 * node + 1]);
+    }
+}
+
+void TextStatistics::updateLeaf(size_t index, const Summary& summary)
+{
+    m_tree[m_leafCount + index] = summary;
+    updateNodes(index, index);
+}
+
+void TextStatistics::updateNodes(size_t first, size_t last)
+{
+    size_t low = (m_leafCount + first) / 2;
+    size_t high = (m_leafCount + last) / 2;
+    for (; low > 0; low /= 2, high /= 2)
+    {
+        for (size_t node = low; node <= high; ++node)
+        {
+            m_tree[node] = combine(m_tree[2 * node], m_tree[2 * node + 1]);
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "TextChangeTracker.h"
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Статистика документа для строки состояния
+ *
+ * Для каждого блока ChunkedText хранится сводка: символы, слова, переводы
+ * строки, символы вне ASCII и то, начинается ли и кончается ли блок внутри
+ * слова (слово на стыке блоков считается один раз). Сводки объединены в
+ * дерево отрезков, корень которого - итог по документу. Правка внутри
+ * блока пересчитывает один блок и O(log n) узлов, поэтому статистика не
+ * требует копии текста при каждом нажатии клавиши. Слово - участок без
+ * пробельных символов. Класс не зависит от WinAPI.
+ */
+class TextStatistics : public ITextChangeListener
+{
+public:
+    /**
+     * @brief Итоговые счетчики документа
+     */
+    struct Counts
+    {
+        size_t characters;  ///< Символов без переводов строки (суррогатная пара - один)
+        size_t words;       ///< Слов
+        size_t lines;       ///< Строк (не меньше одной)
+        size_t nonAscii;    ///< Символов вне ASCII
+    };
+
+    TextStatistics();
+
+    void onTextReset(const ChunkedText& text) override;
+    void onTextEdited(const ChunkedText& text, const TextEdit& edit, const ChunkChange& change) override;
+
+    /**
+     * @brief Получить счетчики всего документа
+     * @return Счетчики
+     */
+    Counts totals() const;
+
+    /**
+     * @brief Проверить, разделяет ли символ слова
+     * @param character Символ
+     * @return true для пробелов, табуляции, переводов строки и пробелов Unicode
+     */
+    static bool isSpace(wchar_t character);
+
+private:
+    /**
+     * @brief Сводка участка текста
+     */
+    struct Summary
+    {
+        size_t characters;  ///< Символов без переводов строки
+        size_t words;       ///< Слов, включая неполные на краях
+        size_t lineFeeds;   ///< Переводов строки
+        size_t nonAscii;    ///< Символов вне ASCII
+        bool isEmpty;       ///< Участок пуст
+        bool startsInWord;  ///< Первый символ - часть слова
+        bool endsInWord;    ///< Последний символ - часть слова
+    };
+
+    std::vector<Summary> m_tree;    ///< Дерево отрезков, листья с m_leafCount
+    size_t m_leafCount;             ///< Число листьев (степень двойки)
+    size_t m_chunkCount;            ///< Число блоков текста
+
+    /**
+     * @brief Посчитать сводку блока
+     */
+    static Summary summarize(const std::wstring& chunk);
+
+    /**
+     * @brief Объединить сводки соседних участков
+     */
+    static Summary combine(const Summary& left, const Summary& right);
+
+    /**
+     * @brief Получить сводку пустого участка
+     */
+    static Summary empty();
+
+    /**
+     * @brief Перестроить дерево по сводкам блоков
+     */
+    void rebuild(const std::vector<Summary>& summaries);
+
+    /**
+     * @brief Обновить лист и его предков
+     */
+    void updateLeaf(size_t index, const Summary& summary);
+
+    /**
+     * @brief Пересчитать предков листьев с first по last включительно
+     */
+    void updateNodes(size_t first, size_t last);
+};
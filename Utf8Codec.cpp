@@ -0,0 +1,263 @@
+#include "Utf8Codec.h"
+
+namespace
+{
+    const unsigned int REPLACEMENT_CHARACTER = 0xFFFD;
+
+    void appendCodePoint(unsigned int codePoint, std::wstring& output)
+    {
+        if (sizeof(wchar_t) == 2 && codePoint >= 0x10000)
+        {
+            // Суррогатная пара для UTF-16
+            codePoint -= 0x10000;
+            output.push_back(static_cast<wchar_t>(0xD800 + (codePoint >> 10)));
+            output.push_back(static_cast<wchar_t>(0xDC00 + (codePoint & 0x3FF)));
+        }
+        else
+        {
+            output.push_back(static_cast<wchar_t>(codePoint));
+        }
+    }
+}
+
+std::string Utf8Codec::encode(const std::wstring& text)
+{
+    std::string result;
+    result.reserve(text.size());
+    encodeAppend(text.data(), text.size(), result);
+    return result;
+}
+
+void Utf8Codec::encodeAppend(const wchar_t* text, size_t length, std::string& output)
+{
+    for (size_t i = 0; i < length; ++i)
+    {
+        unsigned int codePoint = static_cast<unsigned int>(text[i]);
+
+        // Собираем суррогатную пару (только для 16-битного wchar_t)
+        if (sizeof(wchar_t) == 2 && codePoint >= 0xD800 && codePoint <= 0xDBFF)
+        {
+            if (i + 1 < length)
+            {
+                unsigned int low = static_cast<unsigned int>(text[i + 1]);
+                if (low >= 0xDC00 && low <= 0xDFFF)
+                {
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    ++i;
+                }
+                else
+                {
+                    codePoint = REPLACEMENT_CHARACTER;
+                }
+            }
+            else
+            {
+                codePoint = REPLACEMENT_CHARACTER;
+            }
+        }
+        else if (codePoint >= 0xD800 && codePoint <= 0xDFFF)
+        {
+            codePoint = REPLACEMENT_CHARACTER;
+        }
+
+        if (codePoint < 0x80)
+        {
+            output.push_back(static_cast<char>(codePoint));
+        }
+        else if (codePoint < 0x800)
+        {
+            output.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+            output.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        }
+        else if (codePoint < 0x10000)
+        {
+            output.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+            output.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        }
+        else
+        {
+            output.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+            output.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            output.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        }
+    }
+}
+
+std::wstring Utf8Codec::decode(const std::string& text)
+{
+    std::wstring result;
+    result.reserve(text.size());
+    decodeAppend(text.data(), text.size(), result);
+    return result;
+}
+
+void Utf8Codec::decodeAppend(const char* data, size_t size, std::wstring& output)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    size_t i = 0;
+    while (i < size)
+    {
+        unsigned char lead = bytes[i];
+        if (lead < 0x80)
+        {
+            output.push_back(static_cast<wchar_t>(lead));
+            ++i;
+            continue;
+        }
+
+        size_t extra = 0;
+        unsigned int codePoint = 0;
+        unsigned int minimum = 0;
+        if ((lead & 0xE0) == 0xC0)
+        {
+            extra = 1;
+            codePoint = lead & 0x1F;
+            minimum = 0x80;
+        }
+        else if ((lead & 0xF0) == 0xE0)
+        {
+            extra = 2;
+            codePoint = lead & 0x0F;
+            minimum = 0x800;
+        }
+        else if ((lead & 0xF8) == 0xF0)
+        {
+            extra = 3;
+            codePoint = lead & 0x07;
+            minimum = 0x10000;
+        }
+        else
+        {
+            output.push_back(static_cast<wchar_t>(REPLACEMENT_CHARACTER));
+            ++i;
+            continue;
+        }
+
+        size_t consumed = 1;
+        bool valid = true;
+        while (consumed <= extra)
+        {
+            if (i + consumed >= size || (bytes[i + consumed] & 0xC0) != 0x80)
+            {
+                valid = false;
+                break;
+            }
+            codePoint = (codePoint << 6) | (bytes[i + consumed] & 0x3F);
+            ++consumed;
+        }
+
+        if (!valid || codePoint < minimum || codePoint > 0x10FFFF ||
+            (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+        {
+            output.push_back(static_cast<wchar_t>(REPLACEMENT_CHARACTER));
+            i += valid ? consumed : (consumed > 1 ? consumed : 1);
+            continue;
+        }
+
+        appendCodePoint(codePoint, output);
+        i += consumed;
+    }
+}
+
+bool Utf8Codec::isValid(const char* data, size_t size, bool allowTruncatedTail)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    size_t i = 0;
+    while (i < size)
+    {
+        unsigned char lead = bytes[i];
+        if (lead < 0x80)
+        {
+            ++i;
+            continue;
+        }
+
+        size_t extra;
+        unsigned int codePoint;
+        unsigned int minimum;
+        if ((lead & 0xE0) == 0xC0)
+        {
+            extra = 1;
+            codePoint = lead & 0x1F;
+            minimum = 0x80;
+        }
+        else if ((lead & 0xF0) == 0xE0)
+        {
+            extra = 2;
+            codePoint = lead & 0x0F;
+            minimum = 0x800;
+        }
+        else if ((lead & 0xF8) == 0xF0)
+        {
+            extra = 3;
+            codePoint = lead & 0x07;
+            minimum = 0x10000;
+        }
+        else
+        {
+            return false;
+        }
+
+        if (i + extra >= size)
+        {
+            // Последовательность обрывается на границе фрагмента
+            for (size_t j = i + 1; j < size; ++j)
+            {
+                if ((bytes[j] & 0xC0) != 0x80)
+                {
+                    return false;
+                }
+            }
+            return allowTruncatedTail;
+        }
+
+        for (size_t j = 1; j <= extra; ++j)
+        {
+            if ((bytes[i + j] & 0xC0) != 0x80)
+            {
+                return false;
+            }
+            codePoint = (codePoint << 6) | (bytes[i + j] & 0x3F);
+        }
+        if (codePoint < minimum || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+        {
+            return false;
+        }
+        i += extra + 1;
+    }
+    return true;
+}
+
+size_t Utf8Codec::completeLength(const char* data, size_t size)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+
+    // Последовательность занимает не больше 4 байт: смотрим только хвост
+    size_t continuation = 0;
+    while (continuation < 3 && continuation < size && (bytes[size - 1 - continuation] & 0xC0) == 0x80)
+    {
+        ++continuation;
+    }
+    if (continuation == size)
+    {
+        return size; // Ведущего байта нет: некорректные байты декодируются как есть
+    }
+
+    unsigned char lead = bytes[size - 1 - continuation];
+    size_t expected = 1;
+    if ((lead & 0xE0) == 0xC0)
+    {
+        expected = 2;
+    }
+    else if ((lead & 0xF0) == 0xE0)
+    {
+        expected = 3;
+    }
+    else if ((lead & 0xF8) == 0xF0)
+    {
+        expected = 4;
+    }
+    return (continuation + 1 < expected) ? size - continuation - 1 : size;
+}
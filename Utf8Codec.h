@@ -0,0 +1,69 @@
+#pragma once
+
+#include <string>
+
+/**
+ * @brief Переносимое преобразование между UTF-8 и wide-строками
+ *
+ * Не зависит от WinAPI, поэтому используется модулями, которые должны
+ * собираться и под Linux (файловые бэкенды настроек, журналы и т.п.).
+ * Учитывает разный размер wchar_t: UTF-16 в Windows и UTF-32 в Linux.
+ */
+class Utf8Codec
+{
+public:
+    /**
+     * @brief Закодировать wide-строку в UTF-8
+     * @param text Исходный текст
+     * @return Строка в UTF-8
+     */
+    static std::string encode(const std::wstring& text);
+
+    /**
+     * @brief Закодировать фрагмент wide-строки в UTF-8
+     * @param text Указатель на начало фрагмента
+     * @param length Длина фрагмента в символах
+     * @param output Строка, в конец которой дописывается результат
+     */
+    static void encodeAppend(const wchar_t* text, size_t length, std::string& output);
+
+    /**
+     * @brief Декодировать UTF-8 в wide-строку
+     *
+     * Некорректные последовательности заменяются символом U+FFFD.
+     *
+     * @param text Строка в UTF-8
+     * @return Декодированный текст
+     */
+    static std::wstring decode(const std::string& text);
+
+    /**
+     * @brief Декодировать фрагмент UTF-8 в wide-строку
+     * @param data Указатель на байты
+     * @param size Количество байт
+     * @param output Строка, в конец которой дописывается результат
+     */
+    static void decodeAppend(const char* data, size_t size, std::wstring& output);
+
+    /**
+     * @brief Проверить, что байты являются корректным UTF-8
+     * @param data Указатель на байты
+     * @param size Количество байт
+     * @param allowTruncatedTail Допускать оборванную последовательность в конце
+     *        (для проверки фрагмента, вырезанного из файла)
+     * @return true если некорректных последовательностей нет
+     */
+    static bool isValid(const char* data, size_t size, bool allowTruncatedTail);
+
+    /**
+     * @brief Получить длину фрагмента без оборванной последовательности в конце
+     *
+     * Нужна при потоковом чтении: хвост из неполного символа откладывается
+     * до следующего фрагмента, а не заменяется на U+FFFD.
+     *
+     * @param data Указатель на байты
+     * @param size Количество байт
+     * @return Количество байт, которые можно декодировать сейчас
+     */
+    static size_t completeLength(const char* data, size_t size);
+};
@@ -0,0 +1,325 @@
+#include "WordCompletionIndex.h"
+#include <algorithm>
+#include <cwctype>
+#include <queue>
+
+WordCompletionIndex::WordCompletionIndex()
+    : m_freeNode(NO_NODE)
+    , m_wordCount(0)
+{
+    Node root = { NO_NODE, NO_NODE, NO_NODE, 0, 0, 0 };
+    m_nodes.assign(1, root);
+}
+
+void WordCompletionIndex::onTextReset(const ChunkedText& text)
+{
+    Node root = { NO_NODE, NO_NODE, NO_NODE, 0, 0, 0 };
+    m_nodes.assign(1, root);
+    m_freeNode = NO_NODE;
+    m_wordCount = 0;
+
+    // Слово может продолжаться в следующем блоке
+    std::wstring word;
+    for (size_t i = 0; i < text.chunkCount(); ++i)
+    {
+        const std::wstring& chunk = text.chunkText(i);
+        scanWords(chunk.data(), chunk.size(), word, true);
+    }
+    flushWord(word, true);
+}
+
+void WordCompletionIndex::onTextEdited(const ChunkedText& text, const TextEdit& edit, const ChunkChange& change)
+{
+    (void)change;
+
+    // Правка задевает слова, на которые попадают ее края: фрагмент
+    // расширяется до границ слов. Расширение длиннее MAX_WORD_LENGTH
+    // означает слишком длинное слово, которое не индексируется ни до
+    // правки, ни после, поэтому дальше не просматривается.
+    size_t insertedEnd = edit.offset + edit.insertedLength;
+    size_t start = edit.offset;
+    while (start > 0 && edit.offset - start <= MAX_WORD_LENGTH && isWordChar(text.charAt(start - 1)))
+    {
+        --start;
+    }
+    size_t end = insertedEnd;
+    while (end < text.length() && end - insertedEnd <= MAX_WORD_LENGTH && isWordChar(text.charAt(end)))
+    {
+        ++end;
+    }
+    std::wstring left = text.substr(start, edit.offset - start);
+    std::wstring right = text.substr(insertedEnd, end - insertedEnd);
+
+    // Слова участка до правки удаляются, после правки - добавляются
+    std::wstring word;
+    scanWords(left.data(), left.size(), word, false);
+    scanWords(edit.removedText.data(), edit.removedText.size(), word, false);
+    scanWords(right.data(), right.size(), word, false);
+    flushWord(word, false);
+
+    scanWords(left.data(), left.size(), word, true);
+    scanWords(edit.insertedText, edit.insertedLength, word, true);
+    scanWords(right.data(), right.size(), word, true);
+    flushWord(word, true);
+}
+
+void WordCompletionIndex::complete(const std::wstring& prefix, size_t maxCount, std::vector<Completion>& output) const
+{
+    output.clear();
+    uint32_t prefixNode = 0;
+    for (size_t i = 0; i < prefix.size() && prefixNode != NO_NODE; ++i)
+    {
+        prefixNode = findChild(prefixNode, prefix[i]);
+    }
+    if (prefixNode == NO_NODE || maxCount == 0)
+    {
+        return;
+    }
+
+    // Обход по убыванию частоты: поддерево раскрывается, только когда его
+    // лучшая частота не меньше уже найденных слов. Слово с той же
+    // частотой, что и поддерево, выдается раньше него; из поддеревьев
+    // с равной частотой раньше раскрывается более новый (обычно более
+    // глубокий) узел, чтобы не перебирать все ветви со словами-одиночками.
+    struct Entry
+    {
+        uint32_t score;
+        bool isWord;
+        uint32_t node;
+
+        bool operator<(const Entry& other) const
+        {
+            if (score != other.score)
+                return score < other.score;
+            if (isWord != other.isWord)
+                return !isWord;
+            return node < other.node;
+        }
+    };
+
+    std::priority_queue<Entry> queue;
+    Entry first = { m_nodes[prefixNode].best, false, prefixNode };
+    queue.push(first);
+    while (!queue.empty() && output.size() < maxCount)
+    {
+        Entry entry = queue.top();
+        queue.pop();
+        const Node& node = m_nodes[entry.node];
+        if (entry.isWord)
+        {
+            if (entry.node != prefixNode)
+            {
+                Completion completion = { wordOf(entry.node), node.count };
+                output.push_back(completion);
+            }
+            continue;
+        }
+
+        if (node.count > 0)
+        {
+            Entry word = { node.count, true, entry.node };
+            queue.push(word);
+        }
+        for (uint32_t child = node.firstChild; child != NO_NODE; child = m_nodes[child].nextSibling)
+        {
+            Entry subtree = { m_nodes[child].best, false, child };
+            queue.push(subtree);
+        }
+    }
+}
+
+size_t WordCompletionIndex::wordCount() const
+{
+    return m_wordCount;
+}
+
+size_t WordCompletionIndex::memoryUsage() const
+{
+    return m_nodes.capacity() * sizeof(Node);
+}
+
+bool WordCompletionIndex::isWordChar(wchar_t character)
+{
+    if (character < 0x80)
+    {
+        return (character >= L'a' && character <= L'z') || (character >= L'A' && character <= L'Z') ||
+               (character >= L'0' && character <= L'9') || character == L'_';
+    }
+
+    // Латиница с диакритикой и кириллица - без iswalpha: в локали "C"
+    // (по умолчанию вне Windows) она не считает их буквами
+    if (character >= 0xC0 && character <= 0x24F)
+    {
+        return character != 0xD7 && character != 0xF7;
+    }
+    if (character >= 0x400 && character <= 0x52F)
+    {
+        return character < 0x482 || character > 0x489;
+    }
+    return iswalpha(character) != 0;
+}
+
+void WordCompletionIndex::scanWords(const wchar_t* text, size_t length, std::wstring& word, bool isAdding)
+{
+    for (size_t i = 0; i < length; ++i)
+    {
+        if (isWordChar(text[i]))
+        {
+            // Слишком длинное слово дальше не копится: оно все равно пропускается
+            if (word.size() <= MAX_WORD_LENGTH)
+            {
+                word.push_back(text[i]);
+            }
+        }
+        else if (!word.empty())
+        {
+            flushWord(word, isAdding);
+        }
+    }
+}
+
+void WordCompletionIndex::flushWord(std::wstring& word, bool isAdding)
+{
+    if (word.size() >= MIN_WORD_LENGTH && word.size() <= MAX_WORD_LENGTH && !(word[0] >= L'0' && word[0] <= L'9'))
+    {
+        if (isAdding)
+        {
+            addWord(word);
+        }
+        else
+        {
+            removeWord(word);
+        }
+    }
+    word.clear();
+}
+
+void WordCompletionIndex::addWord(const std::wstring& word)
+{
+    uint32_t node = 0;
+    for (size_t i = 0; i < word.size(); ++i)
+    {
+        // Найденный ребенок переносится в начало списка: частые слова
+        // находятся за несколько шагов
+        uint32_t* link = &m_nodes[node].firstChild;
+        while (*link != NO_NODE && m_nodes[*link].character != word[i])
+        {
+            link = &m_nodes[*link].nextSibling;
+        }
+        uint32_t child = *link;
+        if (child != NO_NODE && link != &m_nodes[node].firstChild)
+        {
+            *link = m_nodes[child].nextSibling;
+            m_nodes[child].nextSibling = m_nodes[node].firstChild;
+            m_nodes[node].firstChild = child;
+        }
+        else if (child == NO_NODE)
+        {
+            Node created = { node, NO_NODE, m_nodes[node].firstChild, 0, 0, word[i] };
+            if (m_freeNode != NO_NODE)
+            {
+                child = m_freeNode;
+                m_freeNode = m_nodes[child].nextSibling;
+                m_nodes[child] = created;
+            }
+            else
+            {
+                child = (uint32_t)m_nodes.size();
+                m_nodes.push_back(created);
+            }
+            m_nodes[node].firstChild = child;
+        }
+        node = child;
+    }
+
+    if (m_nodes[node].count++ == 0)
+    {
+        ++m_wordCount;
+    }
+
+    // Частота только выросла: предки обновляются без просмотра детей
+    uint32_t count = m_nodes[node].count;
+    while (node != NO_NODE && m_nodes[node].best < count)
+    {
+        m_nodes[node].best = count;
+        node = m_nodes[node].parent;
+    }
+}
+
+void WordCompletionIndex::removeWord(const std::wstring& word)
+{
+    uint32_t node = 0;
+    for (size_t i = 0; i < word.size() && node != NO_NODE; ++i)
+    {
+        node = findChild(node, word[i]);
+    }
+    if (node == NO_NODE || m_nodes[node].count == 0)
+    {
+        return;
+    }
+
+    if (--m_nodes[node].count == 0)
+    {
+        --m_wordCount;
+    }
+    updateBest(node);
+}
+
+uint32_t WordCompletionIndex::findChild(uint32_t node, wchar_t character) const
+{
+    uint32_t child = m_nodes[node].firstChild;
+    while (child != NO_NODE && m_nodes[child].character != character)
+    {
+        child = m_nodes[child].nextSibling;
+    }
+    return child;
+}
+
+void WordCompletionIndex::updateBest(uint32_t node)
+{
+    while (node != NO_NODE)
+    {
+        Node& current = m_nodes[node];
+        uint32_t best = current.count;
+        for (uint32_t child = current.firstChild; child != NO_NODE; child = m_nodes[child].nextSibling)
+        {
+            best = std::max(best, m_nodes[child].best);
+        }
+
+        uint32_t parent = current.parent;
+        if (best == 0 && node != 0)
+        {
+            // Под узлом не осталось слов (и детей): он отцепляется от родителя
+            uint32_t* link = &m_nodes[parent].firstChild;
+            while (*link != node)
+            {
+                link = &m_nodes[*link].nextSibling;
+            }
+            *link = current.nextSibling;
+            current.best = 0;
+            current.nextSibling = m_freeNode;
+            m_freeNode = node;
+        }
+        else if (best == current.best)
+        {
+            // Выше по дереву ничего не меняется
+            return;
+        }
+        else
+        {
+            current.best = best;
+        }
+        node = parent;
+    }
+}
+
+std::wstring WordCompletionIndex::wordOf(uint32_t node) const
+{
+    std::wstring word;
+    for (; node != 0; node = m_nodes[node].parent)
+    {
+        word.push_back(m_nodes[node].character);
+    }
+    std::reverse(word.begin(), word.end());
+    return word;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "TextChangeTracker.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Индекс слов документа для автодополнения
+ *
+ * Слова (идентификаторы: буквы, цифры и "_", не с цифры) хранятся в
+ * префиксном дереве с числом вхождений. Каждый узел помнит наибольшее
+ * число вхождений в своем поддереве, поэтому k самых частых продолжений
+ * префикса находятся обходом по убыванию частоты без просмотра всех слов.
+ * Правка пересчитывает только слова, которые она задела: удаленный
+ * фрагмент и вставленный, расширенные до границ слов. Класс не зависит
+ * от WinAPI.
+ */
+class WordCompletionIndex : public ITextChangeListener
+{
+public:
+    /**
+     * @brief Вариант дополнения
+     */
+    struct Completion
+    {
+        std::wstring word;  ///< Слово целиком
+        size_t count;       ///< Число вхождений в документе
+    };
+
+    static const size_t MIN_WORD_LENGTH = 2;    ///< Более короткие слова не дополняются
+    static const size_t MAX_WORD_LENGTH = 64;   ///< Более длинные (данные, хеши) не индексируются
+
+    WordCompletionIndex();
+
+    void onTextReset(const ChunkedText& text) override;
+    void onTextEdited(const ChunkedText& text, const TextEdit& edit, const ChunkChange& change) override;
+
+    /**
+     * @brief Найти самые частые слова с префиксом
+     * @param prefix Префикс (само слово, равное префиксу, не возвращается)
+     * @param maxCount Наибольшее число вариантов
+     * @param output Варианты по убыванию числа вхождений
+     */
+    void complete(const std::wstring& prefix, size_t maxCount, std::vector<Completion>& output) const;
+
+    /**
+     * @brief Получить число различных слов
+     * @return Количество слов
+     */
+    size_t wordCount() const;
+
+    /**
+     * @brief Получить объем памяти дерева
+     * @return Размер в байтах
+     */
+    size_t memoryUsage() const;
+
+    /**
+     * @brief Проверить, может ли символ входить в слово
+     * @param character Символ
+     * @return true для букв, цифр и "_"
+     */
+    static bool isWordChar(wchar_t character);
+
+private:
+    static const uint32_t NO_NODE = 0xFFFFFFFF;
+
+    /**
+     * @brief Узел дерева: дети хранятся списком через nextSibling
+     */
+    struct Node
+    {
+        uint32_t parent;        ///< Родитель
+        uint32_t firstChild;    ///< Первый ребенок
+        uint32_t nextSibling;   ///< Следующий ребенок родителя (или следующий свободный узел)
+        uint32_t count;         ///< Вхождений слова, кончающегося в узле
+        uint32_t best;          ///< Наибольшее count в поддереве
+        wchar_t character;      ///< Символ перехода от родителя
+    };
+
+    std::vector<Node> m_nodes;  ///< Узлы, m_nodes[0] - корень
+    uint32_t m_freeNode;        ///< Начало списка свободных узлов
+    size_t m_wordCount;         ///< Число различных слов
+
+    /**
+     * @brief Учесть слова фрагмента текста
+     *
+     * Слово на конце фрагмента накапливается в word и продолжается
+     * следующим фрагментом; последнее слово учитывает flushWord.
+     * @param text Фрагмент
+     * @param length Длина фрагмента
+     * @param word Незаконченное слово
+     * @param isAdding Добавить вхождения (false - удалить)
+     */
+    void scanWords(const wchar_t* text, size_t length, std::wstring& word, bool isAdding);
+
+    /**
+     * @brief Учесть накопленное слово и очистить его
+     */
+    void flushWord(std::wstring& word, bool isAdding);
+
+    /**
+     * @brief Добавить одно вхождение слова
+     */
+    void addWord(const std::wstring& word);
+
+    /**
+     * @brief Удалить одно вхождение слова
+     */
+    void removeWord(const std::wstring& word);
+
+    /**
+     * @brief Найти ребенка узла по символу
+     * @return Номер узла или NO_NODE
+     */
+    uint32_t findChild(uint32_t node, wchar_t character) const;
+
+    /**
+     * @brief Пересчитать наибольшую частоту от узла к корню
+     *
+     * Узлы, под которыми не осталось слов, возвращаются в список свободных.
+     */
+    void updateBest(uint32_t node);
+
+    /**
+     * @brief Собрать слово по пути от корня к узлу
+     */
+    std::wstring wordOf(uint32_t node) const;
+};
@@ -0,0 +1,300 @@
+#include "WrapLayout.h"
+
+namespace
+{
+    // Доля изменившихся строк, начиная с которой дерево перестраивается целиком
+    const size_t REBUILD_DIVISOR = 16;
+
+    inline bool isBreakSpace(wchar_t symbol)
+    {
+        return symbol == L' ' || symbol == L'\t';
+    }
+}
+
+WrapLayout::WrapLayout(const GlyphWidthProvider& widths)
+    : m_widths(widths)
+    , m_width(0)
+    , m_visualLineCount(0)
+{
+}
+
+void WrapLayout::reset(size_t lineCount, const LineSource& source, int width)
+{
+    m_width = width;
+    m_lines.assign(lineCount, LineLayout());
+    std::wstring text;
+    for (size_t i = 0; i < lineCount; ++i)
+    {
+        text.clear();
+        source(i, text);
+        layoutLine(text, m_lines[i]);
+    }
+    rebuildIndex();
+}
+
+void WrapLayout::replaceLines(size_t firstLine, size_t removedCount, size_t insertedCount, const LineSource& source)
+{
+    if (firstLine > m_lines.size())
+    {
+        firstLine = m_lines.size();
+    }
+    if (removedCount > m_lines.size() - firstLine)
+    {
+        removedCount = m_lines.size() - firstLine;
+    }
+
+    std::vector<LineLayout> inserted(insertedCount);
+    std::wstring text;
+    for (size_t i = 0; i < insertedCount; ++i)
+    {
+        text.clear();
+        source(firstLine + i, text);
+        layoutLine(text, inserted[i]);
+    }
+
+    // Число строк не изменилось: дерево обновляется точечно
+    if (removedCount == insertedCount)
+    {
+        for (size_t i = 0; i < insertedCount; ++i)
+        {
+            LineLayout& layout = m_lines[firstLine + i];
+            size_t oldRows = layout.breaks.size() + 1;
+            layout.totalWidth = inserted[i].totalWidth;
+            layout.breaks.swap(inserted[i].breaks);
+            updateIndex(firstLine + i, oldRows, layout.breaks.size() + 1);
+        }
+        return;
+    }
+
+    m_lines.erase(m_lines.begin() + firstLine, m_lines.begin() + firstLine + removedCount);
+    m_lines.insert(m_lines.begin() + firstLine, inserted.begin(), inserted.end());
+    rebuildIndex();
+}
+
+size_t WrapLayout::setWidth(int width, const LineSource& source)
+{
+    if (width == m_width)
+    {
+        return 0;
+    }
+
+    // Строки не шире меньшей из ширин занимают одну экранную строку в обоих случаях;
+    // ширина 0 и меньше означает вывод без переноса
+    int64_t narrower = width;
+    if (m_width > 0 && (width <= 0 || m_width < width))
+    {
+        narrower = m_width;
+    }
+    m_width = width;
+
+    std::vector<size_t> changedLines;
+    std::vector<size_t> oldRowCounts;
+    size_t reflowed = 0;
+    std::wstring text;
+    for (size_t i = 0; i < m_lines.size(); ++i)
+    {
+        LineLayout& layout = m_lines[i];
+        if (narrower <= 0 || layout.totalWidth <= narrower)
+        {
+            continue;
+        }
+
+        size_t oldRows = layout.breaks.size() + 1;
+        if (m_width <= 0 || layout.totalWidth <= m_width)
+        {
+            layout.breaks.clear();
+        }
+        else
+        {
+            text.clear();
+            source(i, text);
+            layoutLine(text, layout);
+        }
+        ++reflowed;
+
+        if (layout.breaks.size() + 1 != oldRows)
+        {
+            changedLines.push_back(i);
+            oldRowCounts.push_back(oldRows);
+        }
+    }
+
+    if (changedLines.size() > m_lines.size() / REBUILD_DIVISOR)
+    {
+        rebuildIndex();
+    }
+    else
+    {
+        for (size_t i = 0; i < changedLines.size(); ++i)
+        {
+            size_t line = changedLines[i];
+            updateIndex(line, oldRowCounts[i], m_lines[line].breaks.size() + 1);
+        }
+    }
+    return reflowed;
+}
+
+int WrapLayout::width() const
+{
+    return m_width;
+}
+
+size_t WrapLayout::lineCount() const
+{
+    return m_lines.size();
+}
+
+uint64_t WrapLayout::visualLineCount() const
+{
+    return m_visualLineCount;
+}
+
+size_t WrapLayout::rowCount(size_t line) const
+{
+    return m_lines[line].breaks.size() + 1;
+}
+
+size_t WrapLayout::rowStart(size_t line, size_t row) const
+{
+    return row == 0 ? 0 : m_lines[line].breaks[row - 1];
+}
+
+size_t WrapLayout::rowOfColumn(size_t line, size_t column) const
+{
+    // Число точек переноса не после позиции
+    const std::vector<uint32_t>& breaks = m_lines[line].breaks;
+    size_t low = 0;
+    size_t high = breaks.size();
+    while (low < high)
+    {
+        size_t middle = (low + high) / 2;
+        if (breaks[middle] <= column)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+uint64_t WrapLayout::visualLineOf(size_t line) const
+{
+    // Префиксная сумма экранных строк [0, line)
+    uint64_t sum = 0;
+    for (size_t i = line; i > 0; i -= i & (~i + 1))
+    {
+        sum += m_tree[i];
+    }
+    return sum;
+}
+
+size_t WrapLayout::lineOfVisual(uint64_t visualLine, size_t& row) const
+{
+    if (m_lines.empty())
+    {
+        row = 0;
+        return 0;
+    }
+    if (visualLine >= m_visualLineCount)
+    {
+        row = m_lines.back().breaks.size();
+        return m_lines.size() - 1;
+    }
+
+    // Спуск по дереву: ищем число строк, целиком лежащих до экранной строки
+    size_t step = 1;
+    while (step * 2 <= m_lines.size())
+    {
+        step *= 2;
+    }
+    size_t position = 0;
+    uint64_t remaining = visualLine;
+    for (; step > 0; step /= 2)
+    {
+        if (position + step <= m_lines.size() && m_tree[position + step] <= remaining)
+        {
+            position += step;
+            remaining -= m_tree[position];
+        }
+    }
+    row = static_cast<size_t>(remaining);
+    return position;
+}
+
+void WrapLayout::layoutLine(const std::wstring& text, LineLayout& layout) const
+{
+    layout.breaks.clear();
+    layout.totalWidth = 0;
+
+    // Жадный перенос: строка рвется после последнего пробела, а слово длиннее
+    // области - на символе, который не поместился. Пробелы в конце экранной
+    // строки не переносятся и могут выходить за правый край.
+    int64_t rowWidth = 0;
+    int64_t wordWidth = 0;
+    size_t rowBegin = 0;
+    size_t wordBegin = 0;
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        int64_t symbolWidth = m_widths.width(text[i]);
+        layout.totalWidth += symbolWidth;
+        if (isBreakSpace(text[i]))
+        {
+            rowWidth += symbolWidth;
+            wordBegin = i + 1;
+            wordWidth = 0;
+            continue;
+        }
+
+        if (m_width > 0 && rowWidth + symbolWidth > m_width && i > rowBegin)
+        {
+            if (wordBegin > rowBegin)
+            {
+                rowBegin = wordBegin;
+                rowWidth = wordWidth;
+            }
+            else
+            {
+                rowBegin = i;
+                rowWidth = 0;
+                wordWidth = 0;
+            }
+            layout.breaks.push_back(static_cast<uint32_t>(rowBegin));
+        }
+        rowWidth += symbolWidth;
+        wordWidth += symbolWidth;
+    }
+}
+
+void WrapLayout::rebuildIndex()
+{
+    // Построение дерева Фенвика за O(n)
+    m_tree.assign(m_lines.size() + 1, 0);
+    m_visualLineCount = 0;
+    for (size_t i = 1; i <= m_lines.size(); ++i)
+    {
+        uint64_t rows = m_lines[i - 1].breaks.size() + 1;
+        m_visualLineCount += rows;
+        m_tree[i] += rows;
+        size_t parent = i + (i & (~i + 1));
+        if (parent <= m_lines.size())
+        {
+            m_tree[parent] += m_tree[i];
+        }
+    }
+}
+
+void WrapLayout::updateIndex(size_t line, size_t oldRows, size_t newRows)
+{
+    if (oldRows == newRows)
+    {
+        return;
+    }
+    m_visualLineCount = m_visualLineCount - oldRows + newRows;
+    for (size_t i = line + 1; i < m_tree.size(); i += i & (~i + 1))
+    {
+        m_tree[i] = m_tree[i] - oldRows + newRows;
+    }
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Источник ширины символов для разметки переноса строк
+ */
+class GlyphWidthProvider
+{
+public:
+    virtual ~GlyphWidthProvider() {}
+
+    /**
+     * @brief Ширина символа
+     * @param symbol Символ
+     * @return Ширина в пикселях (или других единицах, общих с шириной области)
+     */
+    virtual int width(wchar_t symbol) const = 0;
+};
+
+/**
+ * @brief Разметка мягкого переноса строк
+ *
+ * Для каждой логической строки хранит ее полную ширину и точки переноса
+ * (начала экранных строк). Число экранных строк по логическим строкам
+ * лежит в дереве Фенвика, поэтому переход между номером экранной строки
+ * и логической строкой стоит O(log n). Правка пересчитывает только
+ * затронутые строки; при изменении ширины области пересчитываются только
+ * строки шире меньшей из двух ширин - остальные занимают одну экранную
+ * строку и до, и после. Текст строк разметка не хранит: он запрашивается
+ * у вызывающего кода через LineSource. Не зависит от WinAPI.
+ */
+class WrapLayout
+{
+public:
+    /**
+     * @brief Получить текст логической строки (без перевода строки)
+     */
+    typedef std::function<void(size_t line, std::wstring& text)> LineSource;
+
+    /**
+     * @brief Конструктор
+     * @param widths Ширина символов (должна жить дольше разметки)
+     */
+    explicit WrapLayout(const GlyphWidthProvider& widths);
+
+    /**
+     * @brief Разметить документ заново
+     * @param lineCount Количество логических строк
+     * @param source Текст строк
+     * @param width Ширина области вывода
+     */
+    void reset(size_t lineCount, const LineSource& source, int width);
+
+    /**
+     * @brief Заменить диапазон логических строк
+     *
+     * Строки [firstLine, firstLine + removedCount) заменяются строками
+     * [firstLine, firstLine + insertedCount); source получает номера строк
+     * уже в новой нумерации.
+     * @param firstLine Первая затронутая строка
+     * @param removedCount Количество удаленных строк
+     * @param insertedCount Количество вставленных строк
+     * @param source Текст вставленных строк
+     */
+    void replaceLines(size_t firstLine, size_t removedCount, size_t insertedCount, const LineSource& source);
+
+    /**
+     * @brief Изменить ширину области вывода
+     * @param width Новая ширина
+     * @param source Текст строк (запрашиваются только переразмечаемые)
+     * @return Количество переразмеченных строк
+     */
+    size_t setWidth(int width, const LineSource& source);
+
+    /**
+     * @brief Получить ширину области вывода
+     * @return Ширина
+     */
+    int width() const;
+
+    /**
+     * @brief Получить количество логических строк
+     * @return Количество строк
+     */
+    size_t lineCount() const;
+
+    /**
+     * @brief Получить количество экранных строк документа
+     * @return Количество экранных строк
+     */
+    uint64_t visualLineCount() const;
+
+    /**
+     * @brief Получить количество экранных строк логической строки
+     * @param line Логическая строка
+     * @return Количество экранных строк (не меньше одной)
+     */
+    size_t rowCount(size_t line) const;
+
+    /**
+     * @brief Получить начало экранной строки внутри логической
+     * @param line Логическая строка
+     * @param row Экранная строка внутри логической
+     * @return Позиция первого символа
+     */
+    size_t rowStart(size_t line, size_t row) const;
+
+    /**
+     * @brief Найти экранную строку, содержащую позицию логической строки
+     * @param line Логическая строка
+     * @param column Позиция в строке
+     * @return Экранная строка внутри логической
+     */
+    size_t rowOfColumn(size_t line, size_t column) const;
+
+    /**
+     * @brief Получить номер первой экранной строки логической строки
+     * @param line Логическая строка
+     * @return Номер экранной строки в документе
+     */
+    uint64_t visualLineOf(size_t line) const;
+
+    /**
+     * @brief Найти логическую строку по номеру экранной строки
+     * @param visualLine Номер экранной строки (меньше visualLineCount)
+     * @param row Экранная строка внутри найденной логической
+     * @return Логическая строка
+     */
+    size_t lineOfVisual(uint64_t visualLine, size_t& row) const;
+
+private:
+    /**
+     * @brief Разметка одной логической строки
+     */
+    struct LineLayout
+    {
+        int64_t totalWidth;             ///< Ширина строки целиком
+        std::vector<uint32_t> breaks;   ///< Начала экранных строк, кроме первой
+    };
+
+    const GlyphWidthProvider& m_widths; ///< Ширина символов
+    int m_width;                        ///< Ширина области вывода
+    std::vector<LineLayout> m_lines;    ///< Разметка логических строк
+    std::vector<uint64_t> m_tree;       ///< Дерево Фенвика по числу экранных строк (1-based)
+    uint64_t m_visualLineCount;         ///< Всего экранных строк
+
+    /**
+     * @brief Разметить строку под текущую ширину
+     * @param text Текст строки
+     * @param layout Результат
+     */
+    void layoutLine(const std::wstring& text, LineLayout& layout) const;
+
+    /**
+     * @brief Перестроить дерево Фенвика
+     */
+    void rebuildIndex();
+
+    /**
+     * @brief Изменить число экранных строк логической строки в дереве
+     * @param line Логическая строка
+     * @param oldRows Прежнее число
+     * @param newRows Новое число
+     */
+    void updateIndex(size_t line, size_t oldRows, size_t newRows);
+};
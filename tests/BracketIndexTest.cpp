@@ -0,0 +1,171 @@
+#include "TestHarness.h"
+#include "BracketIndex.h"
+#include "TextChangeTracker.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+    bool isOpening(wchar_t character)
+    {
+        return character == L'(' || character == L'[' || character == L'{';
+    }
+
+    // Парная скобка простым просмотром текста
+    bool scanMatch(const std::wstring& text, size_t offset, size_t& match)
+    {
+        if (offset >= text.size() || !BracketIndex::isBracket(text[offset]))
+        {
+            return false;
+        }
+        bool isForward = isOpening(text[offset]);
+        size_t depth = 1;
+        for (size_t i = offset; isForward ? i + 1 < text.size() : i > 0;)
+        {
+            i = isForward ? i + 1 : i - 1;
+            if (BracketIndex::isBracket(text[i]))
+            {
+                depth = isOpening(text[i]) == isForward ? depth + 1 : depth - 1;
+            }
+            if (depth == 0)
+            {
+                const std::wstring pairs = L"()[]{}";
+                size_t open = pairs.find(isForward ? text[offset] : text[i]);
+                match = i;
+                return pairs[open + 1] == (isForward ? text[i] : text[offset]);
+            }
+        }
+        return false;
+    }
+
+    std::wstring randomCode(std::mt19937& random, size_t length)
+    {
+        std::wstring text;
+        for (size_t i = 0; i < length; ++i)
+        {
+            text.push_back(random() % 100 == 0 ? L"({[)}]"[random() % 6] : L"ab \n"[random() % 4]);
+        }
+        return text;
+    }
+}
+
+TEST_CASE(findsMatchingBrackets)
+{
+    std::wstring text = L"f(a[1], {b}) ( ] } x)";
+    TextChangeTracker tracker;
+    BracketIndex index;
+    tracker.addListener(&index);
+    tracker.reset(text.data(), text.size());
+
+    size_t match = 0;
+    CHECK(index.findMatch(tracker.text(), 1, match) && match == 11);
+    CHECK(index.findMatch(tracker.text(), 11, match) && match == 1);
+    CHECK(index.findMatch(tracker.text(), 3, match) && match == 5);
+    CHECK(index.findMatch(tracker.text(), 10, match) && match == 8);
+
+    // Разные скобки в паре, непарная скобка, не скобка
+    CHECK(!index.findMatch(tracker.text(), 13, match));
+    CHECK(!index.findMatch(tracker.text(), 17, match));
+    CHECK(!index.findMatch(tracker.text(), 0, match));
+    CHECK(!index.findMatch(tracker.text(), text.size(), match));
+}
+
+TEST_CASE(matchesScanAcrossChunks)
+{
+    // Вложенность на сотни тысяч символов: пара - в далеком блоке
+    std::wstring text = std::wstring(30000, L'{') + L"body" + std::wstring(30000, L'}');
+    TextChangeTracker tracker;
+    BracketIndex index;
+    tracker.addListener(&index);
+    tracker.reset(text.data(), text.size());
+    CHECK(tracker.text().chunkCount() > 10);
+
+    size_t match = 0;
+    CHECK(index.findMatch(tracker.text(), 0, match) && match == text.size() - 1);
+    CHECK(index.findMatch(tracker.text(), 29999, match) && match == 30004);
+    CHECK(index.findMatch(tracker.text(), 45000, match) && match == 15003);
+}
+
+TEST_CASE(bracketMovesToNeighbourChunk)
+{
+    // Скобка в третьем блоке, пара - в первом
+    std::wstring text(8 * ChunkedText::TARGET_CHUNK_SIZE, L'a');
+    text[50] = L'(';
+    TextChangeTracker tracker;
+    BracketIndex index;
+    tracker.addListener(&index);
+    tracker.reset(text.data(), text.size());
+    size_t closing = tracker.text().chunkOffset(2) + 200;
+    text[closing] = L')';
+    tracker.applyEdit(closing, 1, L")");
+    size_t chunkCount = tracker.text().chunkCount();
+
+    // Правка без скобок от первого до третьего блока: блоков столько же,
+    // но границы сдвинулись и скобка перешла во второй блок
+    size_t offset = 100;
+    size_t removeCount = closing - 100 - offset;
+    std::wstring inserted(ChunkedText::TARGET_CHUNK_SIZE + 200, L'x');
+    text.replace(offset, removeCount, inserted);
+    tracker.applyEdit(offset, removeCount, inserted);
+    CHECK(tracker.text().chunkCount() == chunkCount);
+    closing = text.find(L')');
+    CHECK(closing < tracker.text().chunkOffset(2));
+
+    size_t match = 0;
+    CHECK(index.findMatch(tracker.text(), 50, match) && match == closing);
+    CHECK(index.findMatch(tracker.text(), closing, match) && match == 50);
+}
+
+TEST_CASE(editsKeepIndexConsistent)
+{
+    std::mt19937 random(5);
+    bool isCorrect = true;
+    for (int round = 0; round < 3 && isCorrect; ++round)
+    {
+        std::wstring text = randomCode(random, 100000);
+        TextChangeTracker tracker;
+        BracketIndex index;
+        tracker.addListener(&index);
+        tracker.reset(text.data(), text.size());
+
+        // Правки без скобок, задевающие несколько блоков, сдвигают границы
+        // блоков, не меняя их числа: скобки переходят в соседний блок
+        for (int edit = 0; edit < 150 && isCorrect; ++edit)
+        {
+            size_t offset = random() % text.size();
+            size_t removeCount = std::min<size_t>(random() % 9000, text.size() - offset);
+            std::wstring inserted;
+            if (edit % 2 == 0)
+            {
+                inserted = randomCode(random, random() % 9000);
+            }
+            else
+            {
+                size_t bracket = text.find_first_of(L"()[]{}", offset);
+                removeCount = std::min(removeCount, (bracket == std::wstring::npos ? text.size() : bracket) - offset);
+                inserted.assign(random() % 9000, L'x');
+            }
+            text.replace(offset, removeCount, inserted);
+            tracker.applyEdit(offset, removeCount, inserted);
+
+            for (int probe = 0; probe < 50 && isCorrect; ++probe)
+            {
+                size_t position = random() % text.size();
+                while (position < text.size() && !BracketIndex::isBracket(text[position]))
+                {
+                    ++position;
+                }
+                size_t match = 0;
+                size_t expected = 0;
+                bool isFound = index.findMatch(tracker.text(), position, match);
+                isCorrect = isFound == scanMatch(text, position, expected) && (!isFound || match == expected);
+            }
+        }
+    }
+    CHECK(isCorrect);
+}
+
+int main()
+{
+    return TestHarness::runAll();
+}
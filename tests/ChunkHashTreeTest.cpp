@@ -0,0 +1,99 @@
+#include "TestHarness.h"
+#include "TestSupport.h"
+#include "ChunkHashTree.h"
+#include <random>
+
+namespace
+{
+    bool sameDigest(const ChunkHashTree::Digest& left, const ChunkHashTree::Digest& right)
+    {
+        return left.hash == right.hash && left.length == right.length;
+    }
+}
+
+TEST_CASE(digestFollowsEdits)
+{
+    std::wstring text = TestSupport::generateText(300000, 1);
+    TextChangeTracker tracker;
+    ChunkHashTree tree;
+    tracker.addListener(&tree);
+    tracker.reset(text.data(), text.size());
+    CHECK(sameDigest(tree.digest(), ChunkHashTree::computeDigest(text.data(), text.size())));
+
+    // Правки разного размера, в том числе через границы блоков и через update()
+    std::mt19937 random(3);
+    bool isCorrect = true;
+    for (int i = 0; i < 300; ++i)
+    {
+        size_t offset = random() % (text.size() + 1);
+        size_t removeCount = std::min<size_t>(random() % (i % 10 == 0 ? 100000 : 20), text.size() - offset);
+        std::wstring inserted = TestSupport::generateText(random() % (i % 7 == 0 ? 50000 : 10), i);
+        text.replace(offset, removeCount, inserted);
+        if (i % 2 == 0)
+        {
+            tracker.applyEdit(offset, removeCount, inserted);
+        }
+        else
+        {
+            tracker.update(text.data(), text.size());
+        }
+        isCorrect = isCorrect && sameDigest(tree.digest(), ChunkHashTree::computeDigest(text.data(), text.size()));
+    }
+    CHECK(isCorrect);
+    CHECK(tracker.text().toString() == text);
+}
+
+TEST_CASE(digestDoesNotDependOnChunks)
+{
+    std::wstring text = TestSupport::generateText(200000, 2);
+    TextChangeTracker whole;
+    ChunkHashTree wholeTree;
+    whole.addListener(&wholeTree);
+    whole.reset(text.data(), text.size());
+
+    // Тот же текст, собранный вставками по частям (другое разбиение на блоки)
+    TextChangeTracker pieces;
+    ChunkHashTree piecesTree;
+    pieces.addListener(&piecesTree);
+    pieces.reset(L"", 0);
+    for (size_t offset = 0; offset < text.size(); offset += 7001)
+    {
+        pieces.applyEdit(offset, 0, text.substr(offset, 7001));
+    }
+    CHECK(pieces.text().toString() == text);
+    CHECK(sameDigest(wholeTree.digest(), piecesTree.digest()));
+
+    std::wstring other = text;
+    other[100000] = L'Я';
+    CHECK(!sameDigest(wholeTree.digest(), ChunkHashTree::computeDigest(other.data(), other.size())));
+}
+
+TEST_CASE(typingAndDeletingKeepsDocumentUnmodified)
+{
+    std::wstring text = TestSupport::generateText(100000, 4);
+    TextChangeTracker tracker;
+    ChunkHashTree tree;
+    tracker.addListener(&tree);
+    tracker.reset(text.data(), text.size());
+    CHECK(tree.isModified());
+    tree.markSaved();
+    CHECK(!tree.isModified());
+
+    tracker.applyEdit(5000, 0, L"ж");
+    CHECK(tree.isModified());
+    tracker.applyEdit(5000, 1, L"");
+    CHECK(!tree.isModified());
+
+    // Сохраненная версия переносится между документами
+    ChunkHashTree::Digest saved = { 0, 0 };
+    CHECK(tree.getSavedDigest(saved));
+    tree.markUnsaved();
+    CHECK(tree.isModified() && !tree.getSavedDigest(saved));
+    tree.setSavedDigest(ChunkHashTree::computeDigest(text.data(), text.size()));
+    CHECK(!tree.isModified());
+}
+
+int main()
+{
+    return TestHarness::runAll();
+}
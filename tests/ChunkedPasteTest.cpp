@@ -0,0 +1,119 @@
+#include "TestHarness.h"
+#include "TestSupport.h"
+#include "ChunkedPaste.h"
+#include <random>
+
+namespace
+{
+    std::wstring toCrlf(const std::wstring& text)
+    {
+        std::wstring result;
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            if (text[i] == L'\r' || text[i] == L'\n')
+            {
+                result += L"\r\n";
+                if (text[i] == L'\r' && i + 1 < text.size() && text[i + 1] == L'\n')
+                {
+                    ++i;
+                }
+            }
+            else
+            {
+                result += text[i];
+            }
+        }
+        return result;
+    }
+
+    std::wstring randomText(std::mt19937& random, size_t length)
+    {
+        static const wchar_t PIECES[] = { L'a', L'ж', L'\r', L'\n', L' ' };
+        std::wstring text;
+        for (size_t i = 0; i < length; ++i)
+        {
+            text += PIECES[random() % 5];
+        }
+        return text;
+    }
+}
+
+TEST_CASE(appendNormalizesAcrossChunks)
+{
+    std::mt19937 random(53);
+    bool isCorrect = true;
+    for (int round = 0; round < 500; ++round)
+    {
+        std::wstring text = randomText(random, random() % 200);
+        std::wstring expected = toCrlf(text);
+        std::vector<wchar_t> output(expected.size());
+        ChunkedPaste paste(output.data(), output.size());
+
+        // Куски случайной длины, в том числе пустые и разрезающие "\r\n"
+        size_t offset = 0;
+        while (offset < text.size())
+        {
+            size_t count = std::min<size_t>(random() % 6, text.size() - offset);
+            isCorrect = isCorrect && paste.append(text.data() + offset, count);
+            offset += count;
+        }
+        isCorrect = isCorrect && ChunkedPaste::measure(text.data(), text.size()) == expected.size();
+        isCorrect = isCorrect && paste.length() == expected.size() &&
+                    std::wstring(output.data(), paste.length()) == expected;
+    }
+    CHECK(isCorrect);
+}
+
+TEST_CASE(appendReportsOverflow)
+{
+    std::vector<wchar_t> output(4);
+    ChunkedPaste paste(output.data(), output.size());
+    CHECK(paste.append(L"ab", 2));
+    CHECK(!paste.append(L"c\n", 2));
+
+    ChunkedPaste exact(output.data(), output.size());
+    CHECK(exact.append(L"a\nb", 3) && exact.length() == 4);
+    CHECK(!exact.append(L"x", 1));
+}
+
+TEST_CASE(insertBuildsDocumentText)
+{
+    std::wstring document = L"начало|выделение|конец";
+    std::wstring text = L"один\nдва\rтри";
+    size_t start = 7;
+    size_t end = 16;
+    std::wstring expected = document.substr(0, start) + toCrlf(text) + document.substr(end);
+    std::vector<wchar_t> output(expected.size() + 1, L'#');
+
+    size_t lastDone = 0;
+    size_t progressTotal = 0;
+    ChunkedPaste::Progress progress = [&](size_t done, size_t total)
+    {
+        lastDone = done;
+        progressTotal = total;
+        return true;
+    };
+    CHECK(ChunkedPaste::insert(document.data(), document.size(), start, end, text.data(), text.size(),
+                               output.data(), output.size(), progress));
+    CHECK(std::wstring(output.data()) == expected);
+    CHECK(progressTotal > 0 && lastDone == progressTotal);
+
+    // Мало места или отмена - false
+    CHECK(!ChunkedPaste::insert(document.data(), document.size(), start, end, text.data(), text.size(),
+                                output.data(), output.size() - 1, ChunkedPaste::Progress()));
+    std::wstring large = TestSupport::generateText(3 * ChunkedPaste::CHUNK_SIZE, 1);
+    std::vector<wchar_t> largeOutput(ChunkedPaste::measure(large.data(), large.size()) + document.size() + 1);
+    int callCount = 0;
+    ChunkedPaste::Progress cancel = [&](size_t, size_t)
+    {
+        return ++callCount < 2;
+    };
+    CHECK(!ChunkedPaste::insert(document.data(), document.size(), start, end, large.data(), large.size(),
+                                largeOutput.data(), largeOutput.size(), cancel));
+    CHECK(callCount == 2);
+}
+
+int main()
+{
+    return TestHarness::runAll();
+}
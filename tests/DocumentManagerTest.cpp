@@ -0,0 +1,265 @@
+#include "TestHarness.h"
+#include "TestSupport.h"
+#include "benchmarks/Benchmark.h"
+#include "DocumentManager.h"
+#include "Utf8Codec.h"
+#include <algorithm>
+#include <atomic>
+
+namespace
+{
+    const size_t DOCUMENT_COUNT = 500;
+    const size_t MEMORY_BUDGET = 1024 * 1024;
+
+    std::atomic<int> g_decodeCount(0);
+
+    // Декодер как в редакторе, но только для UTF-8
+    bool decodeUtf8(const std::wstring& path, DecodedDocument& result)
+    {
+        std::string bytes;
+        FILE* file = PortableFile::open(path, "rb");
+        if (!file)
+        {
+            return false;
+        }
+        char buffer[65536];
+        size_t count = 0;
+        while ((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+        {
+            bytes.append(buffer, count);
+        }
+        std::fclose(file);
+        result.text = Utf8Codec::decode(bytes);
+        result.format.codePage = DocumentFormat::CODE_PAGE_UTF8;
+        result.contentHash = bytes.size();
+        ++g_decodeCount;
+        return true;
+    }
+
+    std::string documentText(size_t index)
+    {
+        std::string text;
+        for (int line = 0; line < 500; ++line)
+        {
+            text += "документ " + std::to_string(index) + " строка " + std::to_string(line) + "\r\n";
+        }
+        return text;
+    }
+
+    std::vector<std::wstring> createDocuments(size_t count)
+    {
+        std::vector<std::wstring> paths;
+        for (size_t i = 0; i < count; ++i)
+        {
+            std::string path = TestSupport::temporaryPath("document" + std::to_string(i) + ".txt");
+            TestSupport::writeFile(path, documentText(i));
+            paths.push_back(std::wstring(path.begin(), path.end()));
+        }
+        return paths;
+    }
+
+    void removeDocuments(const std::vector<std::wstring>& paths)
+    {
+        for (size_t i = 0; i < paths.size(); ++i)
+        {
+            PortableFile::remove(paths[i]);
+        }
+    }
+}
+
+TEST_CASE(opensFiveHundredDocumentsWithinBudget)
+{
+    std::vector<std::wstring> paths = createDocuments(DOCUMENT_COUNT);
+    double baseMemory = Benchmark::residentMegabytes();
+    Benchmark::Stopwatch stopwatch;
+
+    DocumentManager manager(decodeUtf8, MEMORY_BUDGET, 4);
+    std::vector<DocumentId> ids;
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        ids.push_back(manager.openDocument(paths[i]));
+    }
+    CHECK(manager.documentCount() == DOCUMENT_COUNT);
+    double openTime = stopwatch.elapsedMilliseconds();
+
+    // Переключение: текст активной вкладки возвращается, следующей - забирается
+    ChunkedText active;
+    DocumentId current = ids[0];
+    CHECK(manager.acquireText(current, active));
+    std::vector<double> switchTimes;
+    bool isTextCorrect = true;
+    for (size_t step = 0; step < 2000; ++step)
+    {
+        size_t index = (step * 37 + 1) % DOCUMENT_COUNT;
+        if (ids[index] == current)
+        {
+            continue;
+        }
+        Benchmark::Stopwatch switchStopwatch;
+        manager.storeText(current, active);
+        bool isAcquired = manager.acquireText(ids[index], active);
+        switchTimes.push_back(switchStopwatch.elapsedMilliseconds());
+        current = ids[index];
+        CHECK(isAcquired);
+        isTextCorrect = isTextCorrect && Utf8Codec::encode(active.toString()) == documentText(index);
+    }
+    CHECK(isTextCorrect);
+
+    // Тексты неактивных документов укладываются в бюджет (лишние выгружены)
+    CHECK(manager.residentBytes() <= MEMORY_BUDGET);
+
+    std::sort(switchTimes.begin(), switchTimes.end());
+    std::printf("  Открытие %u документов: %.1f мс, RSS процесса: %.1f МБ (прирост %.1f МБ), в памяти менеджера: %.1f МБ\n",
+                (unsigned)DOCUMENT_COUNT, openTime, Benchmark::residentMegabytes(),
+                Benchmark::residentMegabytes() - baseMemory, manager.residentBytes() / 1048576.0);
+    std::printf("  Переключение вкладки: медиана %.3f мс, 99%% %.3f мс, максимум %.3f мс\n",
+                switchTimes[switchTimes.size() / 2], switchTimes[switchTimes.size() * 99 / 100], switchTimes.back());
+    removeDocuments(paths);
+}
+
+TEST_CASE(modifiedDocumentsAreNotEvicted)
+{
+    std::vector<std::wstring> paths = createDocuments(20);
+    DocumentManager manager(decodeUtf8, 16 * 1024, 2);
+    std::vector<DocumentId> ids;
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        ids.push_back(manager.openDocument(paths[i]));
+    }
+
+    // Первый документ изменен и возвращен: его текст не перечитывается с диска
+    ChunkedText text;
+    CHECK(manager.acquireText(ids[0], text));
+    text.replace(0, 0, L"правка ", 7);
+    DocumentInfo info = manager.getInfo(ids[0]);
+    info.isModified = true;
+    manager.setInfo(ids[0], info);
+    manager.storeText(ids[0], text);
+
+    for (size_t i = 1; i < ids.size(); ++i)
+    {
+        ChunkedText other;
+        CHECK(manager.acquireText(ids[i], other));
+        manager.storeText(ids[i], other);
+    }
+    ChunkedText restored;
+    CHECK(manager.acquireText(ids[0], restored));
+    CHECK(restored.toString() == text.toString());
+    removeDocuments(paths);
+}
+
+TEST_CASE(evictedDocumentIsReadAgain)
+{
+    std::vector<std::wstring> paths = createDocuments(10);
+    DocumentManager manager(decodeUtf8, 0, 1);
+    std::vector<DocumentId> ids;
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        ids.push_back(manager.openDocument(paths[i]));
+    }
+    // Каждый документ проходит через редактор: фоновые декодирования из
+    // очереди пула завершены и больше не меняют счетчик
+    ChunkedText text;
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        CHECK(manager.acquireText(ids[i], text));
+        manager.storeText(ids[i], text);
+    }
+    CHECK(manager.residentBytes() == 0);
+
+    int decodesBefore = g_decodeCount;
+    CHECK(manager.acquireText(ids[2], text));
+    CHECK(g_decodeCount == decodesBefore + 1);
+    CHECK(Utf8Codec::encode(text.toString()) == documentText(2));
+    removeDocuments(paths);
+}
+
+TEST_CASE(lookupAndClose)
+{
+    std::vector<std::wstring> paths = createDocuments(3);
+    DocumentManager manager(decodeUtf8, MEMORY_BUDGET, 1);
+    DocumentId first = manager.openDocument(paths[0]);
+    DocumentId second = manager.openDocument(paths[1]);
+    DocumentId created = manager.createDocument();
+    DocumentId missing = manager.openDocument(TestSupport::temporaryWidePath("missing.txt"));
+
+    CHECK(manager.findByPath(paths[1]) == second);
+    CHECK(manager.findByPath(paths[2]) == 0);
+    CHECK(manager.indexOf(created) == 2);
+    CHECK(manager.documentAt(0) == first);
+
+    ChunkedText text;
+    CHECK(!manager.acquireText(missing, text));
+    CHECK(manager.acquireText(created, text) && text.length() == 0);
+
+    manager.closeDocument(first);
+    CHECK(manager.documentCount() == 3);
+    CHECK(manager.indexOf(first) == manager.documentCount());
+    CHECK(manager.documentAt(0) == second);
+    removeDocuments(paths);
+}
+
+TEST_CASE(switchingTabsKeepsJournalOfModifiedDocument)
+{
+    std::wstring journalA = TestSupport::temporaryWidePath("journal-a.journal");
+    std::wstring journalB = TestSupport::temporaryWidePath("journal-b.journal");
+    TextChangeTracker tracker;
+    {
+        DocumentManager manager(decodeUtf8, MEMORY_BUDGET, 1);
+
+        // Документ A открыт и изменен
+        DocumentId first = manager.createDocument();
+        EditJournal* journal = manager.openJournal(first, journalA);
+        CHECK(journal != nullptr);
+        tracker.addListener(journal);
+        tracker.reset(L"первый документ", 15);
+        tracker.applyEdit(7, 8, std::wstring(L"текст без сохранения"));
+        DocumentInfo info;
+        info.isModified = true;
+        manager.setInfo(first, info);
+
+        // Переключение на B, как в редакторе: журнал A отключается до сброса текста
+        tracker.removeListener(journal);
+        manager.storeText(first, tracker.text());
+        DocumentId second = manager.createDocument();
+        tracker.reset(L"второй", 6);
+        journal = manager.openJournal(second, journalB);
+        CHECK(journal != nullptr);
+        tracker.addListener(journal);
+        journal->markSaved(tracker.text());
+        tracker.applyEdit(0, 0, std::wstring(L"!"));
+        CHECK(manager.getJournal(first) != nullptr);
+        CHECK(manager.getJournal(second) == journal);
+        tracker.removeListener(journal);
+
+        // Сбой: менеджер уничтожается без штатного закрытия журналов
+    }
+
+    RecoveredDocument recovered;
+    CHECK(EditJournal::recover(journalA, recovered));
+    CHECK(recovered.hasUnsavedChanges);
+    CHECK(recovered.text == L"первый текст без сохранения");
+    CHECK(EditJournal::recover(journalB, recovered));
+    CHECK(recovered.text == L"!второй");
+    PortableFile::remove(journalA);
+    PortableFile::remove(journalB);
+}
+
+TEST_CASE(closingDocumentRemovesItsJournal)
+{
+    std::wstring journalPath = TestSupport::temporaryWidePath("journal-closed.journal");
+    DocumentManager manager(decodeUtf8, MEMORY_BUDGET, 1);
+    DocumentId id = manager.createDocument();
+    CHECK(manager.openJournal(id, journalPath) == manager.getJournal(id));
+
+    PortableFile::Info fileInfo;
+    CHECK(PortableFile::getInfo(journalPath, fileInfo));
+    manager.closeDocument(id);
+    CHECK(manager.getJournal(id) == nullptr);
+    CHECK(!PortableFile::getInfo(journalPath, fileInfo));
+}
+
+int main()
+{
+    return TestHarness::runAll();
+}
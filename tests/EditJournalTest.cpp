@@ -0,0 +1,214 @@
+#include "TestHarness.h"
+#include "TestSupport.h"
+#include "EditJournal.h"
+#include "PortableFile.h"
+#include <csignal>
+#include <sys/wait.h>
+
+namespace
+{
+    // Случайная правка, которую одинаково повторяют пишущий процесс и проверка
+    struct RandomEditor
+    {
+        std::mt19937 random;
+        std::wstring text;
+        size_t editCount;
+
+        explicit RandomEditor(unsigned seed) : random(seed), editCount(0) {}
+
+        void next(size_t& offset, size_t& removeCount, std::wstring& inserted)
+        {
+            offset = text.empty() ? 0 : random() % (text.size() + 1);
+            removeCount = (random() % 3 == 0 && offset < text.size())
+                ? random() % std::min<size_t>(5, text.size() - offset) : 0;
+            inserted.assign(random() % 4, (wchar_t)(L'a' + editCount % 26));
+            text.replace(offset, removeCount, inserted);
+            ++editCount;
+        }
+    };
+
+    EditJournal::Options fastOptions()
+    {
+        EditJournal::Options options;
+        options.flushIntervalMs = 5;
+        options.syncIntervalMs = 20;
+        options.compactThreshold = 20000;
+        return options;
+    }
+
+    // Пишущий процесс: правки без конца, пока его не убьют
+    void runWriter(const std::wstring& journalPath, unsigned seed)
+    {
+        EditJournal journal(journalPath, fastOptions());
+        TextChangeTracker tracker;
+        tracker.addListener(&journal);
+        journal.setDocumentPath(L"/home/user/документ.txt");
+        journal.start();
+        tracker.reset(L"", 0);
+
+        RandomEditor editor(seed);
+        for (;;)
+        {
+            size_t offset = 0;
+            size_t removeCount = 0;
+            std::wstring inserted;
+            editor.next(offset, removeCount, inserted);
+            tracker.applyEdit(offset, removeCount, inserted);
+            journal.compactIfNeeded(tracker.text());
+            if (editor.editCount % 50 == 0)
+            {
+                usleep(100);
+            }
+        }
+    }
+
+    // Восстановленный текст должен совпасть с одним из состояний последовательности правок
+    bool isReachableState(const std::wstring& recovered, unsigned seed, size_t maxEdits)
+    {
+        RandomEditor editor(seed);
+        if (editor.text == recovered)
+        {
+            return true;
+        }
+        for (size_t i = 0; i < maxEdits; ++i)
+        {
+            size_t offset = 0;
+            size_t removeCount = 0;
+            std::wstring inserted;
+            editor.next(offset, removeCount, inserted);
+            if (editor.text.size() == recovered.size() && editor.text == recovered)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+TEST_CASE(recoversAfterKillAtRandomPoint)
+{
+    std::wstring journalPath = TestSupport::temporaryWidePath("kill.journal");
+    std::mt19937 random(42);
+    for (int round = 0; round < 8; ++round)
+    {
+        unsigned seed = random();
+        pid_t child = fork();
+        if (child == 0)
+        {
+            runWriter(journalPath, seed);
+            _exit(0);
+        }
+        usleep(20000 + random() % 200000);
+        kill(child, SIGKILL);
+        waitpid(child, nullptr, 0);
+
+        RecoveredDocument document;
+        CHECK(EditJournal::recover(journalPath, document));
+        CHECK(document.documentPath == L"/home/user/документ.txt");
+        CHECK(isReachableState(document.text, seed, 10000000));
+    }
+    PortableFile::remove(journalPath);
+}
+
+TEST_CASE(recoversPrefixOfTruncatedJournal)
+{
+    std::wstring journalPath = TestSupport::temporaryWidePath("truncated.journal");
+    std::string narrowPath = TestSupport::temporaryPath("truncated.journal");
+    const unsigned seed = 7;
+    {
+        EditJournal journal(journalPath);
+        TextChangeTracker tracker;
+        tracker.addListener(&journal);
+        journal.start();
+        tracker.reset(L"", 0);
+        RandomEditor editor(seed);
+        for (int i = 0; i < 2000; ++i)
+        {
+            size_t offset = 0;
+            size_t removeCount = 0;
+            std::wstring inserted;
+            editor.next(offset, removeCount, inserted);
+            tracker.applyEdit(offset, removeCount, inserted);
+        }
+        journal.flush();
+        journal.stop(false);
+    }
+
+    // Обрыв в любом месте после первого снимка оставляет целые правки
+    std::string bytes = TestSupport::readFile(narrowPath);
+    std::mt19937 random(3);
+    for (int round = 0; round < 20; ++round)
+    {
+        size_t length = bytes.size() / 2 + random() % (bytes.size() / 2);
+        CHECK(TestSupport::writeFile(narrowPath, bytes.substr(0, length)));
+        RecoveredDocument document;
+        CHECK(EditJournal::recover(journalPath, document));
+        CHECK(isReachableState(document.text, seed, 2000));
+    }
+    PortableFile::remove(journalPath);
+}
+
+TEST_CASE(savedStateIsNotUnsaved)
+{
+    std::wstring journalPath = TestSupport::temporaryWidePath("saved.journal");
+    EditJournal journal(journalPath);
+    TextChangeTracker tracker;
+    tracker.addListener(&journal);
+    journal.setDocumentPath(L"/tmp/a.txt");
+    journal.start();
+
+    std::wstring text = L"строка 1\r\nстрока 2";
+    tracker.reset(text.data(), text.size());
+    tracker.applyEdit(0, 0, L"новая ");
+    journal.flush();
+
+    RecoveredDocument document;
+    CHECK(EditJournal::recover(journalPath, document));
+    CHECK(document.hasUnsavedChanges);
+    CHECK(document.text == L"новая строка 1\r\nстрока 2");
+
+    journal.markSaved(tracker.text());
+    journal.flush();
+    CHECK(EditJournal::recover(journalPath, document));
+    CHECK(!document.hasUnsavedChanges);
+    CHECK(document.text == L"новая строка 1\r\nстрока 2");
+    CHECK(document.documentPath == L"/tmp/a.txt");
+
+    journal.stop(true);
+    CHECK(!EditJournal::recover(journalPath, document));
+}
+
+TEST_CASE(compactionKeepsText)
+{
+    std::wstring journalPath = TestSupport::temporaryWidePath("compact.journal");
+    std::string narrowPath = TestSupport::temporaryPath("compact.journal");
+    EditJournal journal(journalPath, fastOptions());
+    TextChangeTracker tracker;
+    tracker.addListener(&journal);
+    journal.start();
+    tracker.reset(L"", 0);
+
+    RandomEditor editor(11);
+    for (int i = 0; i < 50000; ++i)
+    {
+        size_t offset = 0;
+        size_t removeCount = 0;
+        std::wstring inserted;
+        editor.next(offset, removeCount, inserted);
+        tracker.applyEdit(offset, removeCount, inserted);
+        journal.compactIfNeeded(tracker.text());
+    }
+    journal.flush();
+
+    // Журнал уплотнен: он короче записей всех правок
+    CHECK(TestSupport::readFile(narrowPath).size() < 50000 * 20);
+    RecoveredDocument document;
+    CHECK(EditJournal::recover(journalPath, document));
+    CHECK(document.text == editor.text);
+    journal.stop(true);
+}
+
+int main()
+{
+    return TestHarness::runAll();
+}
@@ -0,0 +1,198 @@
+#include "TestHarness.h"
+#include "TestSupport.h"
+#include "CodePageTables.h"
+#include "EncodingDetector.h"
+#include "Utf8Codec.h"
+
+namespace
+{
+    const wchar_t* const RUSSIAN_SENTENCES[] = {
+        L"Вечером мы долго сидели у окна и говорили о будущем.",
+        L"Поезд опоздал на два часа, поэтому встреча перенесена на завтра.",
+        L"В отчете за третий квартал указаны расходы на ремонт здания.",
+        L"Съешь же ещё этих мягких французских булок, да выпей чаю.",
+        L"Функция возвращает пустую строку, если файл не найден.",
+        L"Ошибка чтения: диск переполнен или недоступен.",
+        L"Широкая электрификация южных губерний даст мощный толчок подъёму сельского хозяйства.",
+        L"Он посмотрел на часы, вздохнул и снова принялся за работу.",
+        L"Настройки сохраняются в файле рядом с программой."
+    };
+
+    const wchar_t* const WESTERN_SENTENCES[] = {
+        L"The quick brown fox jumps over the lazy dog near the riverbank.",
+        L"Le cœur déçu mais l'âme plutôt naïve, Louÿs rêva de crapaüter en canoë.",
+        L"Größere Änderungen müssen vor der Veröffentlichung geprüft werden.",
+        L"El pingüino Wenceslao hizo kilómetros bajo exhaustiva lluvia y frío.",
+        L"Configuration files are stored next to the application binary.",
+        L"À côté de l'église, le café était fermé pendant l'été."
+    };
+
+    const wchar_t* const CODE_LINES[] = {
+        L"    // Проверка входных данных перед записью",
+        L"    if (count == 0) { return false; }",
+        L"    result += value * 2; /* промежуточный итог */",
+        L"    printf(\"Готово: %d\\n\", total);"
+    };
+
+    /**
+     * @brief Размеченный образец корпуса
+     */
+    struct Sample
+    {
+        std::string name;
+        std::string bytes;
+        uint32_t codePage;
+        size_t bomLength;
+    };
+
+    std::wstring composeText(const wchar_t* const* sentences, size_t sentenceCount, size_t length, unsigned seed)
+    {
+        std::mt19937 random(seed);
+        std::wstring text;
+        while (text.size() < length)
+        {
+            text += sentences[random() % sentenceCount];
+            text += random() % 4 == 0 ? L"\r\n" : L" ";
+        }
+        return text;
+    }
+
+    std::wstring composeSource(size_t length, unsigned seed)
+    {
+        std::mt19937 random(seed);
+        std::wstring text;
+        while (text.size() < length)
+        {
+            text += CODE_LINES[random() % 4];
+            text += L"\r\n";
+        }
+        return text;
+    }
+
+    std::string encodeUtf16(const std::wstring& text, bool isBigEndian)
+    {
+        std::string bytes;
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            char high = (char)((unsigned)text[i] >> 8);
+            char low = (char)((unsigned)text[i] & 0xFF);
+            bytes += isBigEndian ? high : low;
+            bytes += isBigEndian ? low : high;
+        }
+        return bytes;
+    }
+
+    void addSamples(std::vector<Sample>& corpus, const std::string& kind, const std::wstring& text, bool isRussian)
+    {
+        Sample utf8 = { kind + " UTF-8", Utf8Codec::encode(text), EncodingDetector::CODE_PAGE_UTF8, 0 };
+        Sample utf8Bom = { kind + " UTF-8 BOM", "\xEF\xBB\xBF" + utf8.bytes, EncodingDetector::CODE_PAGE_UTF8, 3 };
+        Sample le = { kind + " UTF-16LE", encodeUtf16(text, false), EncodingDetector::CODE_PAGE_UTF16LE, 0 };
+        Sample be = { kind + " UTF-16BE", encodeUtf16(text, true), EncodingDetector::CODE_PAGE_UTF16BE, 0 };
+        Sample leBom = { kind + " UTF-16LE BOM", "\xFF\xFE" + le.bytes, EncodingDetector::CODE_PAGE_UTF16LE, 2 };
+        Sample beBom = { kind + " UTF-16BE BOM", "\xFE\xFF" + be.bytes, EncodingDetector::CODE_PAGE_UTF16BE, 2 };
+        corpus.push_back(utf8);
+        corpus.push_back(utf8Bom);
+        corpus.push_back(le);
+        corpus.push_back(be);
+        corpus.push_back(leBom);
+        corpus.push_back(beBom);
+
+        static const uint32_t RUSSIAN_CODE_PAGES[] = { 1251, 20866, 866 };
+        static const char* const RUSSIAN_NAMES[] = { " Windows-1251", " KOI8-R", " CP866" };
+        for (size_t i = 0; i < (isRussian ? 3 : 0); ++i)
+        {
+            Sample single = { kind + RUSSIAN_NAMES[i],
+                              TestSupport::encodeSingleByte(text, TestSupport::singleByteTable(RUSSIAN_CODE_PAGES[i])),
+                              RUSSIAN_CODE_PAGES[i], 0 };
+            corpus.push_back(single);
+        }
+        // Текст только из ASCII одинаков во всех однобайтовых кодировках и в UTF-8
+        bool isAscii = utf8.bytes.size() == text.size();
+        if (!isRussian)
+        {
+            Sample single = { kind + " Windows-1252", TestSupport::encodeSingleByte(text, TestSupport::singleByteTable(1252)),
+                              isAscii ? EncodingDetector::CODE_PAGE_UTF8 : EncodingDetector::CODE_PAGE_WINDOWS_1252, 0 };
+            corpus.push_back(single);
+        }
+    }
+
+    std::vector<Sample> buildCorpus(size_t length, unsigned seed)
+    {
+        std::vector<Sample> corpus;
+        addSamples(corpus, "проза", composeText(RUSSIAN_SENTENCES, 9, length, seed), true);
+        addSamples(corpus, "код", composeSource(length, seed), true);
+        addSamples(corpus, "prose", composeText(WESTERN_SENTENCES, 6, length, seed), false);
+        return corpus;
+    }
+
+    /**
+     * @brief Доля верно определенных образцов корпуса
+     */
+    double measureAccuracy(size_t length, bool isVerbose)
+    {
+        size_t correct = 0;
+        size_t total = 0;
+        for (unsigned seed = 1; seed <= 3; ++seed)
+        {
+            std::vector<Sample> corpus = buildCorpus(length, seed);
+            for (size_t i = 0; i < corpus.size(); ++i)
+            {
+                EncodingDetector::Result result = EncodingDetector::detect(corpus[i].bytes.data(), corpus[i].bytes.size());
+                bool isCorrect = result.codePage == corpus[i].codePage && result.bomLength == corpus[i].bomLength;
+                correct += isCorrect;
+                ++total;
+                if (!isCorrect && isVerbose)
+                {
+                    std::printf("  %u символов, %s: определено %u\n", (unsigned)length, corpus[i].name.c_str(),
+                                (unsigned)result.codePage);
+                }
+            }
+        }
+        return (double)correct / total;
+    }
+}
+
+TEST_CASE(detectsLabeledCorpus)
+{
+    // Короткие образцы (одна фраза) могут не содержать различающих букв;
+    // начиная с нескольких фраз ошибок быть не должно
+    static const size_t LENGTHS[] = { 40, 200, 1000, 20000, 300000, 1000000 };
+    for (size_t i = 0; i < sizeof(LENGTHS) / sizeof(LENGTHS[0]); ++i)
+    {
+        double accuracy = measureAccuracy(LENGTHS[i], true);
+        std::printf("  %u символов: точность %.1f%%\n", (unsigned)LENGTHS[i], accuracy * 100.0);
+        CHECK(accuracy >= (LENGTHS[i] < 200 ? 0.9 : 1.0));
+    }
+}
+
+TEST_CASE(fileIsReadBySamples)
+{
+    std::wstring text = composeText(RUSSIAN_SENTENCES, 9, 10 * 1024 * 1024, 4);
+    std::string path = TestSupport::temporaryPath("detect.txt");
+    CHECK(TestSupport::writeFile(path, TestSupport::encodeSingleByte(text, TestSupport::singleByteTable(20866))));
+
+    EncodingDetector::Result result;
+    CHECK(EncodingDetector::detectFile(std::wstring(path.begin(), path.end()), result));
+    CHECK(result.codePage == EncodingDetector::CODE_PAGE_KOI8_R);
+    CHECK(result.sampledBytes <= EncodingDetector::SAMPLE_SIZE * EncodingDetector::MAX_SAMPLES);
+    CHECK(EncodingDetector::isSingleByte(result.codePage));
+    CHECK(!EncodingDetector::isSingleByte(EncodingDetector::CODE_PAGE_UTF8));
+
+    std::remove(path.c_str());
+    CHECK(!EncodingDetector::detectFile(std::wstring(path.begin(), path.end()), result));
+}
+
+TEST_CASE(emptyAndTinyInputs)
+{
+    EncodingDetector::Result result = EncodingDetector::detect("", 0);
+    CHECK(result.codePage == EncodingDetector::CODE_PAGE_UTF8 && result.bomLength == 0);
+    result = EncodingDetector::detect("\xEF\xBB\xBF", 3);
+    CHECK(result.codePage == EncodingDetector::CODE_PAGE_UTF8 && result.bomLength == 3);
+    result = EncodingDetector::detect("\xFF\xFE", 2);
+    CHECK(result.codePage == EncodingDetector::CODE_PAGE_UTF16LE && result.bomLength == 2);
+}
+
+int main()
+{
+    return TestHarness::runAll();
+}
@@ -0,0 +1,131 @@
+#include "TestHarness.h"
+#include "TestSupport.h"
+#include "FileTail.h"
+#include "FileWatcher.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace
+{
+    void appendBytes(const std::string& path, const std::string& bytes)
+    {
+        FILE* file = std::fopen(path.c_str(), "ab");
+        std::fwrite(bytes.data(), 1, bytes.size(), file);
+        std::fclose(file);
+    }
+}
+
+TEST_CASE(readsOnlyAppendedText)
+{
+    std::string path = TestSupport::temporaryPath("tail.log");
+    CHECK(TestSupport::writeFile(path, "старое\n"));
+    FileTail tail;
+    tail.start(std::wstring(path.begin(), path.end()), 13, LargeFileDocument::ENCODING_UTF8, std::vector<wchar_t>());
+
+    std::wstring text;
+    CHECK(tail.read(text) == FileTail::TAIL_UNCHANGED);
+    appendBytes(path, "новое\n");
+    CHECK(tail.read(text) == FileTail::TAIL_APPENDED);
+    CHECK(text == L"новое\n");
+    CHECK(tail.offset() == 24 && tail.decodedOffset() == 24);
+    std::remove(path.c_str());
+}
+
+TEST_CASE(holdsBrokenUtf8Character)
+{
+    std::string path = TestSupport::temporaryPath("tail8.log");
+    CHECK(TestSupport::writeFile(path, ""));
+    FileTail tail;
+    tail.start(std::wstring(path.begin(), path.end()), 0, LargeFileDocument::ENCODING_UTF8, std::vector<wchar_t>());
+
+    // "Ж" и смайлик, дописанные по одному байту
+    std::string bytes = "\xD0\x96\xF0\x9F\x98\x80";
+    std::wstring text;
+    for (size_t i = 0; i < bytes.size(); ++i)
+    {
+        appendBytes(path, bytes.substr(i, 1));
+        tail.read(text);
+    }
+    CHECK(text == std::wstring(L"Ж") + (sizeof(wchar_t) == 2 ? std::wstring(L"\xD83D\xDE00") : std::wstring(1, (wchar_t)0x1F600)));
+    CHECK(tail.decodedOffset() == tail.offset());
+    std::remove(path.c_str());
+}
+
+TEST_CASE(holdsBrokenUtf16CharacterAndCarriageReturn)
+{
+    std::string path = TestSupport::temporaryPath("tail16.log");
+    CHECK(TestSupport::writeFile(path, ""));
+    FileTail tail;
+    tail.start(std::wstring(path.begin(), path.end()), 0, LargeFileDocument::ENCODING_UTF16LE, std::vector<wchar_t>());
+
+    // "A", "Б", "\r\n" в UTF-16LE, дописанные с разрывами внутри символов и между \r и \n
+    std::string bytes("A\0\x11\x04\r\0\n\0", 8);
+    size_t cuts[] = { 1, 3, 6, 8 };
+    std::wstring text;
+    size_t previous = 0;
+    for (size_t i = 0; i < 4; ++i)
+    {
+        appendBytes(path, bytes.substr(previous, cuts[i] - previous));
+        previous = cuts[i];
+        tail.read(text);
+        if (cuts[i] == 6)
+        {
+            // "\r" отложен до прихода "\n"
+            CHECK(text == L"AБ" && tail.decodedOffset() == 4);
+        }
+    }
+    CHECK(text == L"AБ\r\n");
+    std::remove(path.c_str());
+}
+
+TEST_CASE(reportsTruncationAndLimitsReadSize)
+{
+    std::string path = TestSupport::temporaryPath("tailbig.log");
+    CHECK(TestSupport::writeFile(path, std::string(FileTail::MAX_READ_SIZE + 100, 'a')));
+    FileTail tail;
+    tail.start(std::wstring(path.begin(), path.end()), 0, LargeFileDocument::ENCODING_UTF8, std::vector<wchar_t>());
+
+    std::wstring text;
+    CHECK(tail.read(text) == FileTail::TAIL_APPENDED);
+    CHECK(text.size() == FileTail::MAX_READ_SIZE && tail.hasMoreData());
+    CHECK(tail.read(text) == FileTail::TAIL_APPENDED);
+    CHECK(text.size() == FileTail::MAX_READ_SIZE + 100 && !tail.hasMoreData());
+
+    CHECK(TestSupport::writeFile(path, "x"));
+    CHECK(tail.read(text) == FileTail::TAIL_TRUNCATED);
+    std::remove(path.c_str());
+    CHECK(tail.read(text) == FileTail::TAIL_FAILED);
+}
+
+TEST_CASE(watcherReportsAppend)
+{
+    std::string path = TestSupport::temporaryPath("watched.log");
+    CHECK(TestSupport::writeFile(path, ""));
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool isChanged = false;
+    FileWatcher watcher;
+    CHECK(watcher.start(std::wstring(path.begin(), path.end()), [&]()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isChanged = true;
+        changed.notify_one();
+    }));
+    CHECK(watcher.isRunning());
+
+    appendBytes(path, "строка\n");
+    {
+        // Уведомление приходит раньше контрольной проверки
+        std::unique_lock<std::mutex> lock(mutex);
+        CHECK(changed.wait_for(lock, std::chrono::milliseconds(FileWatcher::POLL_INTERVAL / 2), [&]() { return isChanged; }));
+    }
+    watcher.stop();
+    CHECK(!watcher.isRunning());
+    std::remove(path.c_str());
+}
+
+int main()
+{
+    return TestHarness::runAll();
+}
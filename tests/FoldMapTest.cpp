@@ -0,0 +1,150 @@
+#include "TestHarness.h"
+#include "FoldMap.h"
+#include <algorithm>
+#include <random>
+#include <sstream>
+
+namespace
+{
+    std::vector<std::wstring> splitLines(const std::wstring& text)
+    {
+        std::vector<std::wstring> lines;
+        std::wstringstream stream(text);
+        std::wstring line;
+        while (std::getline(stream, line))
+        {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    FoldMap::LineReader readerOf(const std::vector<std::wstring>& document)
+    {
+        return [&document](uint64_t firstLine, size_t count, std::vector<std::wstring>& lines) -> size_t
+        {
+            lines.clear();
+            for (uint64_t line = firstLine; line < document.size() && lines.size() < count; ++line)
+            {
+                lines.push_back(document[(size_t)line]);
+            }
+            return lines.size();
+        };
+    }
+
+    struct Fold
+    {
+        uint64_t header;
+        uint64_t lastLine;
+    };
+}
+
+TEST_CASE(findsRegionsByBracketsAndIndentation)
+{
+    std::vector<std::wstring> document = splitLines(
+        L"int f()\n{\n    a;\n\n    b;\n}\nvoid g() {\n  if (x) {\n    y;\n  }\n}\n"
+        L"{\"a\": [\n 1, 2,\n 3]}\n<root>\n  <item/>\n  <item/>\n</root>\npython:\n    pass\n\n\nend\n");
+    FoldMap::LineReader reader = readerOf(document);
+    uint64_t lastLine = 0;
+    CHECK(FoldMap::findRegion(1, reader, lastLine) && lastLine == 5);
+    CHECK(!FoldMap::findRegion(0, reader, lastLine));
+    CHECK(FoldMap::findRegion(6, reader, lastLine) && lastLine == 10);
+    CHECK(FoldMap::findRegion(7, reader, lastLine) && lastLine == 9);
+    CHECK(FoldMap::findRegion(11, reader, lastLine) && lastLine == 13);
+
+    // Отступ и закрывающий тег; пустые строки в конце блока не входят
+    CHECK(FoldMap::findRegion(14, reader, lastLine) && lastLine == 17);
+    CHECK(FoldMap::findRegion(18, reader, lastLine) && lastLine == 19);
+    CHECK(!FoldMap::findRegion(3, reader, lastLine));
+    CHECK(!FoldMap::findRegion(22, reader, lastLine));
+
+    std::vector<std::wstring> unclosed = splitLines(L"{\n a\n b\n");
+    CHECK(!FoldMap::findRegion(0, readerOf(unclosed), lastLine));
+    std::vector<std::wstring> tail = splitLines(L"x:\n  a\n  b");
+    CHECK(FoldMap::findRegion(0, readerOf(tail), lastLine) && lastLine == 2);
+}
+
+TEST_CASE(mapsLinesLikeHiddenLineList)
+{
+    std::mt19937 random(5);
+    bool isCorrect = true;
+    for (int round = 0; round < 300 && isCorrect; ++round)
+    {
+        uint64_t lineCount = 1 + random() % 300;
+        FoldMap map;
+        std::vector<Fold> folds;
+        for (int operation = 0; operation < 40 && isCorrect; ++operation)
+        {
+            int kind = random() % 10;
+            if (kind < 7)
+            {
+                // Свертывание, развертывание; блоки вложены и пересекаются
+                uint64_t header = random() % lineCount;
+                uint64_t lastLine = std::min(lineCount - 1, header + random() % 20);
+                bool wasFolded = map.isFolded(header);
+                bool isFolded = map.toggle(header, lastLine);
+                std::vector<Fold>::iterator found = std::find_if(folds.begin(), folds.end(),
+                                                                 [&](const Fold& fold) { return fold.header == header; });
+                if (found != folds.end())
+                {
+                    folds.erase(found);
+                    isCorrect = wasFolded && !isFolded;
+                }
+                else
+                {
+                    Fold fold = { header, lastLine };
+                    folds.insert(folds.end(), lastLine > header ? 1 : 0, fold);
+                    isCorrect = isFolded == (lastLine > header);
+                }
+            }
+            else if (kind < 9)
+            {
+                uint64_t line = random() % lineCount;
+                map.reveal(line);
+                folds.erase(std::remove_if(folds.begin(), folds.end(),
+                                           [&](const Fold& fold) { return fold.header < line && fold.lastLine >= line; }),
+                            folds.end());
+            }
+            else
+            {
+                map.clear();
+                folds.clear();
+            }
+
+            std::vector<bool> hidden((size_t)lineCount, false);
+            for (size_t i = 0; i < folds.size(); ++i)
+            {
+                std::fill(hidden.begin() + (size_t)folds[i].header + 1, hidden.begin() + (size_t)folds[i].lastLine + 1, true);
+            }
+            std::vector<uint64_t> visible;
+            for (uint64_t line = 0; line < lineCount; ++line)
+            {
+                visible.insert(visible.end(), hidden[(size_t)line] ? 0 : 1, line);
+            }
+            isCorrect = isCorrect && map.foldCount() == folds.size() && map.visibleLineCount(lineCount) == visible.size();
+            for (size_t i = 0; i < visible.size() && isCorrect; ++i)
+            {
+                uint64_t runEnd = std::find(hidden.begin() + (size_t)visible[i], hidden.end(), true) - hidden.begin();
+                isCorrect = map.toDocument(i) == visible[i] && map.toVisible(visible[i]) == i &&
+                            (i + 1 == visible.size() || map.nextVisible(visible[i]) == visible[i + 1]) &&
+                            (runEnd == lineCount || map.visibleRunEnd(visible[i]) == runEnd);
+            }
+
+            // Скрытая строка переводится в номер своего заголовка
+            for (uint64_t line = 0; line < lineCount && isCorrect; ++line)
+            {
+                uint64_t header = line;
+                while (hidden[(size_t)header])
+                {
+                    --header;
+                }
+                isCorrect = map.toVisible(line) == map.toVisible(header);
+            }
+        }
+    }
+    CHECK(isCorrect);
+}
+
+int main()
+{
+    return TestHarness::runAll();
+}
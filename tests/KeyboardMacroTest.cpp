@@ -0,0 +1,317 @@
+#include "TestHarness.h"
+#include "MacroPlayer.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+    // Независимое выполнение шагов над обычной строкой
+    struct ReferenceEditor
+    {
+        std::wstring text;
+        size_t anchor;
+        size_t caret;
+        size_t column;
+
+        size_t lineStart(size_t position) const
+        {
+            while (position > 0 && text[position - 1] != L'\n')
+            {
+                --position;
+            }
+            return position;
+        }
+
+        size_t lineEnd(size_t position) const
+        {
+            while (position < text.size() && text[position] != L'\r' && text[position] != L'\n')
+            {
+                ++position;
+            }
+            return position;
+        }
+
+        size_t previousSize(size_t position) const
+        {
+            return position >= 2 && text[position - 1] == L'\n' && text[position - 2] == L'\r' ? 2 : 1;
+        }
+
+        size_t nextSize(size_t position) const
+        {
+            return position + 1 < text.size() && text[position] == L'\r' && text[position + 1] == L'\n' ? 2 : 1;
+        }
+
+        bool deleteSelection()
+        {
+            if (anchor == caret)
+            {
+                return false;
+            }
+            size_t start = std::min(anchor, caret);
+            text.erase(start, std::max(anchor, caret) - start);
+            anchor = caret = start;
+            return true;
+        }
+
+        bool execute(const KeyboardMacro::Step& step)
+        {
+            size_t start = std::min(anchor, caret);
+            size_t end = std::max(anchor, caret);
+            if (step.opcode != KeyboardMacro::OP_LINE_UP && step.opcode != KeyboardMacro::OP_LINE_DOWN)
+            {
+                column = (size_t)-1;
+            }
+            switch (step.opcode)
+            {
+            case KeyboardMacro::OP_INSERT:
+                deleteSelection();
+                text.insert(caret, step.text, step.length);
+                caret += step.length;
+                break;
+            case KeyboardMacro::OP_DELETE_BACK:
+                if (!deleteSelection())
+                {
+                    if (caret == 0)
+                    {
+                        return false;
+                    }
+                    size_t size = previousSize(caret);
+                    caret -= size;
+                    text.erase(caret, size);
+                }
+                break;
+            case KeyboardMacro::OP_DELETE_FORWARD:
+                if (!deleteSelection())
+                {
+                    if (caret == text.size())
+                    {
+                        return false;
+                    }
+                    text.erase(caret, nextSize(caret));
+                }
+                break;
+            case KeyboardMacro::OP_CHAR_LEFT:
+                if (start != end)
+                {
+                    caret = start;
+                }
+                else if (caret == 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    caret -= previousSize(caret);
+                }
+                break;
+            case KeyboardMacro::OP_CHAR_RIGHT:
+                if (start != end)
+                {
+                    caret = end;
+                }
+                else if (caret == text.size())
+                {
+                    return false;
+                }
+                else
+                {
+                    caret += nextSize(caret);
+                }
+                break;
+            case KeyboardMacro::OP_LINE_UP:
+            case KeyboardMacro::OP_LINE_DOWN:
+            {
+                size_t currentStart = lineStart(caret);
+                if (column == (size_t)-1)
+                {
+                    column = caret - currentStart;
+                }
+                size_t target = 0;
+                if (step.opcode == KeyboardMacro::OP_LINE_UP)
+                {
+                    if (currentStart == 0)
+                    {
+                        return false;
+                    }
+                    target = lineStart(currentStart - 1);
+                }
+                else
+                {
+                    size_t currentEnd = lineEnd(caret);
+                    if (currentEnd == text.size())
+                    {
+                        return false;
+                    }
+                    target = currentEnd + nextSize(currentEnd);
+                }
+                caret = std::min(target + column, lineEnd(target));
+                break;
+            }
+            case KeyboardMacro::OP_LINE_HOME:
+                caret = lineStart(caret);
+                break;
+            case KeyboardMacro::OP_LINE_END:
+                caret = lineEnd(caret);
+                break;
+            case KeyboardMacro::OP_FIND_NEXT:
+            {
+                size_t found = text.find(std::wstring(step.text, step.length), end);
+                if (found == std::wstring::npos || step.length == 0)
+                {
+                    return false;
+                }
+                anchor = found;
+                caret = found + step.length;
+                return true;
+            }
+            }
+            anchor = caret;
+            return true;
+        }
+
+        size_t run(const KeyboardMacro& macro, size_t times)
+        {
+            std::vector<KeyboardMacro::Step> steps;
+            macro.decode(steps);
+            if (steps.empty())
+            {
+                return 0;
+            }
+            for (size_t iteration = 0; iteration < times; ++iteration)
+            {
+                for (size_t i = 0; i < steps.size(); ++i)
+                {
+                    for (size_t repeat = 0; repeat < steps[i].count; ++repeat)
+                    {
+                        if (!execute(steps[i]))
+                        {
+                            return iteration;
+                        }
+                    }
+                }
+            }
+            return times;
+        }
+    };
+}
+
+TEST_CASE(recordingMergesRepeatedSteps)
+{
+    KeyboardMacro macro;
+    CHECK(macro.isEmpty());
+    macro.recordText(L"ab", 2);
+    macro.recordText(L"в", 1);
+    for (int i = 0; i < 5; ++i)
+    {
+        macro.recordOperation(KeyboardMacro::OP_CHAR_RIGHT);
+    }
+    macro.recordOperation(KeyboardMacro::OP_LINE_DOWN);
+    macro.recordFind(L"ab");
+    macro.recordFind(L"ab");
+
+    std::vector<KeyboardMacro::Step> steps;
+    macro.decode(steps);
+    CHECK(steps.size() == 5);
+    CHECK(steps[0].opcode == KeyboardMacro::OP_INSERT && std::wstring(steps[0].text, steps[0].length) == L"abв");
+    CHECK(steps[1].opcode == KeyboardMacro::OP_CHAR_RIGHT && steps[1].count == 5);
+    CHECK(steps[2].opcode == KeyboardMacro::OP_LINE_DOWN && steps[2].count == 1);
+
+    // Повторный поиск не сливается: каждый находит следующее вхождение
+    CHECK(steps[3].opcode == KeyboardMacro::OP_FIND_NEXT && steps[4].opcode == KeyboardMacro::OP_FIND_NEXT);
+    CHECK(macro.codeSize() < 30);
+
+    macro.clear();
+    CHECK(macro.isEmpty() && macro.codeSize() == 0);
+}
+
+TEST_CASE(replayMatchesReferenceEditor)
+{
+    std::mt19937 random(4);
+    int errorCount = 0;
+    for (int round = 0; round < 3000; ++round)
+    {
+        std::wstring document;
+        int pieceCount = random() % 300;
+        for (int i = 0; i < pieceCount; ++i)
+        {
+            int kind = random() % 10;
+            document += kind == 0 ? L"\r\n" : (kind == 1 ? L"ab" : std::wstring(1, (wchar_t)(L'a' + random() % 4)));
+        }
+
+        KeyboardMacro macro;
+        int stepCount = 1 + random() % 8;
+        for (int i = 0; i < stepCount; ++i)
+        {
+            int opcode = 1 + random() % 10;
+            if (opcode == KeyboardMacro::OP_INSERT)
+            {
+                std::wstring text = random() % 4 == 0 ? L"\r\n" : std::wstring(1 + random() % 3, L'x');
+                macro.recordText(text.data(), text.size());
+            }
+            else if (opcode == KeyboardMacro::OP_FIND_NEXT)
+            {
+                macro.recordFind(random() % 2 ? L"ab" : L"c\r");
+            }
+            else
+            {
+                macro.recordOperation((KeyboardMacro::Opcode)opcode);
+            }
+        }
+
+        // Курсор и якорь не внутри "\r\n"
+        size_t caret = random() % (document.size() + 1);
+        size_t anchor = random() % 3 == 0 ? random() % (document.size() + 1) : caret;
+        caret -= caret > 0 && caret < document.size() && document[caret - 1] == L'\r' ? 1 : 0;
+        anchor -= anchor > 0 && anchor < document.size() && document[anchor - 1] == L'\r' ? 1 : 0;
+        size_t times = 1 + random() % 20;
+
+        MacroPlayer player(document.data(), document.size(), anchor, caret);
+        size_t iterations = player.run(macro, times);
+        ReferenceEditor reference = { document, anchor, caret, (size_t)-1 };
+        size_t referenceIterations = reference.run(macro, times);
+
+        // Изменение возвращается одним участком
+        std::wstring result = document;
+        size_t start = 0;
+        size_t oldLength = 0;
+        std::wstring newText;
+        if (player.getChange(start, oldLength, newText))
+        {
+            result.replace(start, oldLength, newText);
+        }
+        size_t playerAnchor = 0;
+        size_t playerCaret = 0;
+        player.getSelection(playerAnchor, playerCaret);
+        if (iterations != referenceIterations || result != reference.text || player.length() != result.size() ||
+            playerAnchor != reference.anchor || playerCaret != reference.caret)
+        {
+            ++errorCount;
+        }
+    }
+    CHECK(errorCount == 0);
+}
+
+TEST_CASE(unchangedTextHasNoChange)
+{
+    std::wstring document = L"one\r\ntwo\r\nthree";
+    KeyboardMacro macro;
+    macro.recordOperation(KeyboardMacro::OP_LINE_DOWN);
+    macro.recordOperation(KeyboardMacro::OP_LINE_END);
+
+    // Движение вниз останавливается на последней строке
+    MacroPlayer player(document.data(), document.size(), 0, 0);
+    CHECK(player.run(macro, 10) == 2);
+    size_t start = 0;
+    size_t oldLength = 0;
+    std::wstring newText;
+    CHECK(!player.getChange(start, oldLength, newText));
+    size_t anchor = 0;
+    size_t caret = 0;
+    player.getSelection(anchor, caret);
+    CHECK(anchor == document.size() && caret == document.size());
+}
+
+int main()
+{
+    return TestHarness::runAll();
+}
@@ -0,0 +1,168 @@
+#include "TestHarness.h"
+#include "TestSupport.h"
+#include "LargeFileDocument.h"
+#include "Utf8Codec.h"
+#include <chrono>
+#include <thread>
+
+namespace
+{
+    const int LINE_COUNT = 20000;
+
+    std::wstring lineText(int line)
+    {
+        wchar_t number[32];
+        std::swprintf(number, 32, L"%012d", line);
+        return L"line " + std::wstring(number) + L" пример \U0001F600 текста";
+    }
+
+    std::string encodeUtf16(const std::wstring& text, bool isBigEndian)
+    {
+        std::string bytes;
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            uint32_t code = (uint32_t)text[i];
+            uint16_t units[2] = { (uint16_t)code, 0 };
+            size_t unitCount = 1;
+            if (code > 0xFFFF)
+            {
+                code -= 0x10000;
+                units[0] = (uint16_t)(0xD800 + (code >> 10));
+                units[1] = (uint16_t)(0xDC00 + (code & 0x3FF));
+                unitCount = 2;
+            }
+            for (size_t j = 0; j < unitCount; ++j)
+            {
+                char high = (char)(units[j] >> 8);
+                char low = (char)(units[j] & 0xFF);
+                bytes += isBigEndian ? high : low;
+                bytes += isBigEndian ? low : high;
+            }
+        }
+        return bytes;
+    }
+
+    std::wstring documentText()
+    {
+        std::wstring text;
+        for (int line = 0; line < LINE_COUNT; ++line)
+        {
+            text += lineText(line) + L"\r\n";
+        }
+        return text;
+    }
+
+    void waitForIndex(LargeFileDocument& document)
+    {
+        while (!document.isIndexComplete())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+
+    void checkDocument(const std::string& bytes, LargeFileDocument::Encoding expectedEncoding)
+    {
+        std::string path = TestSupport::temporaryPath("large.txt");
+        CHECK(TestSupport::writeFile(path, bytes));
+        LargeFileDocument document;
+        CHECK(document.open(std::wstring(path.begin(), path.end()), std::vector<wchar_t>()));
+        waitForIndex(document);
+
+        CHECK(document.encoding() == expectedEncoding);
+        CHECK(document.lineCount() == (uint64_t)LINE_COUNT + 1);
+        CHECK(document.fileSize() == bytes.size());
+
+        std::vector<std::wstring> lines;
+        CHECK(document.readLines(12345, 3, lines) == 3);
+        CHECK(lines.size() == 3 && lines[0] == lineText(12345) && lines[2] == lineText(12347));
+
+        // Последняя строка пустая: файл кончается переводом строки
+        CHECK(document.readLines(LINE_COUNT, 5, lines) == 1);
+        CHECK(lines.size() == 1 && lines[0].empty());
+
+        uint64_t offset = document.find(L"000000019999 пример", 0, nullptr);
+        uint64_t line = 0;
+        CHECK(offset != LargeFileDocument::NOT_FOUND);
+        CHECK(document.lineOfOffset(offset, line) && line == 19999);
+        uint64_t start = 0;
+        CHECK(document.lineStartOffset(19999, start) && start < offset);
+        uint64_t column = 0;
+        CHECK(document.columnOfOffset(19999, offset, column) && column == 5);
+        CHECK(document.find(L"не встречается", 0, nullptr) == LargeFileDocument::NOT_FOUND);
+        document.close();
+        std::remove(path.c_str());
+    }
+}
+
+TEST_CASE(readsUtf8)
+{
+    checkDocument(Utf8Codec::encode(documentText()), LargeFileDocument::ENCODING_UTF8);
+}
+
+TEST_CASE(readsUtf16WithBom)
+{
+    checkDocument("\xFF\xFE" + encodeUtf16(documentText(), false), LargeFileDocument::ENCODING_UTF16LE);
+    checkDocument("\xFE\xFF" + encodeUtf16(documentText(), true), LargeFileDocument::ENCODING_UTF16BE);
+}
+
+TEST_CASE(readsSingleByteThroughTable)
+{
+    // Кириллица в таблице с 0xC0 (как в windows-1251)
+    std::vector<wchar_t> table;
+    for (int i = 0; i < 256; ++i)
+    {
+        table.push_back(i < 128 ? (wchar_t)i : (i >= 0xC0 ? (wchar_t)(0x410 + (i - 0xC0)) : L'?'));
+    }
+    std::string bytes;
+    for (int line = 0; line < 1000; ++line)
+    {
+        bytes += "line " + std::to_string(line) + " \xEF\xF0\xE8\xEC\xE5\xF0\r\n";
+    }
+    std::string path = TestSupport::temporaryPath("single.txt");
+    CHECK(TestSupport::writeFile(path, bytes));
+    LargeFileDocument document;
+    CHECK(document.open(std::wstring(path.begin(), path.end()), table));
+    waitForIndex(document);
+    CHECK(document.encoding() == LargeFileDocument::ENCODING_SINGLE_BYTE);
+    std::vector<std::wstring> lines;
+    CHECK(document.readLines(500, 1, lines) == 1 && lines[0] == L"line 500 пример");
+    document.close();
+    std::remove(path.c_str());
+}
+
+TEST_CASE(longLineIsReadBySegments)
+{
+    // Строка в 1 МБ: читается участок у заданного столбца, а не вся строка
+    std::string longLine;
+    for (int i = 0; longLine.size() < 1024 * 1024; ++i)
+    {
+        longLine += std::to_string(i % 10);
+    }
+    std::string bytes = "short\n" + longLine + "\nlast";
+    std::string path = TestSupport::temporaryPath("longline.txt");
+    CHECK(TestSupport::writeFile(path, bytes));
+    LargeFileDocument document;
+    CHECK(document.open(std::wstring(path.begin(), path.end()), std::vector<wchar_t>()));
+    waitForIndex(document);
+    CHECK(document.lineCount() == 3);
+
+    std::vector<LargeFileDocument::LineSegment> segments;
+    uint64_t column = 900000;
+    CHECK(document.readSegments(0, 3, column, 80, segments) == 3);
+    CHECK(segments.size() == 3);
+    CHECK(segments[0].text == L"short" && !segments[0].isLong);
+    CHECK(segments[1].isLong);
+    CHECK(segments[1].length == longLine.size());
+    CHECK(segments[1].column <= column && segments[1].column + segments[1].text.size() >= column + 80);
+    CHECK(segments[1].text.size() < LargeFileDocument::MAX_LINE_BYTES);
+    std::string expected = longLine.substr((size_t)segments[1].column, segments[1].text.size());
+    CHECK(segments[1].text == std::wstring(expected.begin(), expected.end()));
+    CHECK(segments[2].text == L"last");
+    document.close();
+    std::remove(path.c_str());
+}
+
+int main()
+{
+    return TestHarness::runAll();
+}
@@ -0,0 +1,285 @@
+#include "TestHarness.h"
+#include "TestSupport.h"
+#include "LineDiff.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+    std::vector<std::wstring> splitLines(const std::wstring& text)
+    {
+        std::vector<std::wstring> lines;
+        size_t start = 0;
+        while (start < text.size())
+        {
+            size_t end = text.find(L'\n', start);
+            end = end == std::wstring::npos ? text.size() : end + 1;
+            lines.push_back(text.substr(start, end - start));
+            start = end;
+        }
+        return lines;
+    }
+
+    // Длина наибольшей общей подпоследовательности строк (для проверки минимальности)
+    size_t commonLineCount(const std::vector<std::wstring>& oldLines, const std::vector<std::wstring>& newLines)
+    {
+        std::vector<std::vector<size_t>> table(oldLines.size() + 1, std::vector<size_t>(newLines.size() + 1, 0));
+        for (size_t i = 1; i <= oldLines.size(); ++i)
+        {
+            for (size_t j = 1; j <= newLines.size(); ++j)
+            {
+                table[i][j] = oldLines[i - 1] == newLines[j - 1] ? table[i - 1][j - 1] + 1
+                                                                 : std::max(table[i - 1][j], table[i][j - 1]);
+            }
+        }
+        return table[oldLines.size()][newLines.size()];
+    }
+
+    // Применение фрагментов с конца, как при перезагрузке документа
+    std::wstring applyHunks(std::wstring text, const std::wstring& newText, const std::vector<LineDiff::Hunk>& hunks)
+    {
+        for (size_t i = hunks.size(); i-- > 0;)
+        {
+            const LineDiff::Hunk& hunk = hunks[i];
+            text.replace(hunk.oldOffset, hunk.oldLength, newText, hunk.newOffset, hunk.newLength);
+        }
+        return text;
+    }
+
+    std::wstring randomText(std::mt19937& random, size_t lineCount)
+    {
+        static const wchar_t* const WORDS[] = { L"а\n", L"б\n", L"в\n", L"г\n", L"д" };
+        std::wstring text;
+        for (size_t i = 0; i < lineCount; ++i)
+        {
+            text += WORDS[random() % 5];
+        }
+        return text;
+    }
+
+    bool checkHunks(const std::wstring& oldText, const std::wstring& newText, const std::vector<LineDiff::Hunk>& hunks)
+    {
+        bool isCorrect = applyHunks(oldText, newText, hunks) == newText;
+        for (size_t i = 0; i < hunks.size(); ++i)
+        {
+            isCorrect = isCorrect && (hunks[i].oldLineCount > 0 || hunks[i].newLineCount > 0);
+            isCorrect = isCorrect && (i == 0 || hunks[i - 1].oldLine + hunks[i - 1].oldLineCount < hunks[i].oldLine);
+        }
+        return isCorrect;
+    }
+}
+
+TEST_CASE(findsChangedLines)
+{
+    std::wstring oldText = L"один\nдва\nтри\nчетыре\n";
+    std::wstring newText = L"один\nДВА\nтри\nчетыре\nпять\n";
+    std::vector<LineDiff::Hunk> hunks;
+    LineDiff::compute(oldText.data(), oldText.size(), newText.data(), newText.size(), hunks);
+
+    CHECK(hunks.size() == 2);
+    CHECK(hunks[0].oldLine == 1 && hunks[0].oldLineCount == 1 && hunks[0].newLine == 1 && hunks[0].newLineCount == 1);
+    CHECK(hunks[0].oldOffset == 5 && hunks[0].oldLength == 4 && hunks[0].newLength == 4);
+    CHECK(hunks[1].oldLine == 4 && hunks[1].oldLineCount == 0 && hunks[1].newLineCount == 1);
+    CHECK(checkHunks(oldText, newText, hunks));
+
+    LineDiff::compute(oldText.data(), oldText.size(), oldText.data(), oldText.size(), hunks);
+    CHECK(hunks.empty());
+}
+
+TEST_CASE(lastLineWithoutNewline)
+{
+    std::wstring oldText = L"а\nб";
+    std::wstring newText = L"а\nб\n";
+    std::vector<LineDiff::Hunk> hunks;
+    LineDiff::compute(oldText.data(), oldText.size(), newText.data(), newText.size(), hunks);
+    CHECK(hunks.size() == 1 && checkHunks(oldText, newText, hunks));
+
+    LineDiff::compute(L"", 0, newText.data(), newText.size(), hunks);
+    CHECK(hunks.size() == 1 && hunks[0].newLength == newText.size());
+}
+
+TEST_CASE(randomTextsAreMinimal)
+{
+    std::mt19937 random(7);
+    for (int round = 0; round < 300; ++round)
+    {
+        std::wstring oldText = randomText(random, random() % 40);
+        std::wstring newText = randomText(random, random() % 40);
+        std::vector<LineDiff::Hunk> hunks;
+        LineDiff::compute(oldText.data(), oldText.size(), newText.data(), newText.size(), hunks);
+        CHECK(checkHunks(oldText, newText, hunks));
+
+        std::vector<std::wstring> oldLines = splitLines(oldText);
+        std::vector<std::wstring> newLines = splitLines(newText);
+        size_t changedLines = 0;
+        for (size_t i = 0; i < hunks.size(); ++i)
+        {
+            changedLines += hunks[i].oldLineCount + hunks[i].newLineCount;
+        }
+        CHECK(changedLines == oldLines.size() + newLines.size() - 2 * commonLineCount(oldLines, newLines));
+    }
+}
+
+TEST_CASE(costLimitKeepsResultCorrect)
+{
+    std::mt19937 random(11);
+    std::wstring oldText = randomText(random, 2000);
+    std::wstring newText = randomText(random, 2000);
+    std::vector<LineDiff::Hunk> hunks;
+    LineDiff::compute(oldText.data(), oldText.size(), newText.data(), newText.size(), hunks, 8);
+    CHECK(checkHunks(oldText, newText, hunks));
+}
+
+TEST_CASE(mapsOffsetsThroughHunks)
+{
+    std::wstring oldText = L"а\nб\nв\nг\n";
+    std::wstring newText = L"новая\nа\nв\nг\n";
+    std::vector<LineDiff::Hunk> hunks;
+    LineDiff::compute(oldText.data(), oldText.size(), newText.data(), newText.size(), hunks);
+    CHECK(checkHunks(oldText, newText, hunks));
+
+    CHECK(LineDiff::mapOffset(hunks, 0) == 6);      // "а" сдвинута вставкой
+    CHECK(LineDiff::mapOffset(hunks, 3) == 8);      // внутри удаленной "б" - к началу фрагмента
+    CHECK(LineDiff::mapOffset(hunks, 6) == 10);     // "г" после всех фрагментов
+    CHECK(LineDiff::mapOffset(hunks, oldText.size()) == newText.size());
+}
+
+TEST_CASE(mergesOnlyCloseHunks)
+{
+    std::wstring oldText;
+    for (int line = 0; line < 100; ++line)
+    {
+        oldText += L"строка " + std::to_wstring(line) + L"\n";
+    }
+    std::vector<std::wstring> lines = splitLines(oldText);
+    lines[10] = L"правка\n";
+    lines[12] = L"правка\n";
+    lines[90] = L"правка\n";
+    std::wstring newText;
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        newText += lines[i];
+    }
+
+    std::vector<LineDiff::Hunk> hunks;
+    LineDiff::compute(oldText.data(), oldText.size(), newText.data(), newText.size(), hunks);
+    CHECK(hunks.size() == 3);
+
+    // Строки 10 и 12 разделены одной строкой, строка 90 далеко
+    std::vector<LineDiff::Hunk> merged;
+    LineDiff::mergeHunks(hunks, 50, merged);
+    CHECK(checkHunks(oldText, newText, merged));
+    CHECK(merged.size() == 2);
+    CHECK(merged.size() == 2 && merged[0].oldLine == 10 && merged[0].oldLineCount == 3 &&
+          merged[0].newLineCount == 3 && merged[1].oldLine == 90);
+
+    LineDiff::mergeHunks(hunks, 0, merged);
+    CHECK(merged.size() == 3);
+    LineDiff::mergeHunks(hunks, oldText.size(), merged);
+    CHECK(merged.size() == 1 && checkHunks(oldText, newText, merged));
+}
+
+TEST_CASE(histogramResultIsCorrect)
+{
+    std::mt19937 random(13);
+    for (int round = 0; round < 200; ++round)
+    {
+        std::wstring oldText = randomText(random, random() % 60);
+        std::wstring newText = randomText(random, random() % 60);
+        std::vector<LineDiff::Hunk> hunks;
+        CHECK(LineDiff::compute(oldText.data(), oldText.size(), newText.data(), newText.size(), hunks,
+                                LineDiff::ALGORITHM_HISTOGRAM, LineDiff::Progress()));
+        CHECK(checkHunks(oldText, newText, hunks));
+    }
+
+    // Уникальные строки с разбросанными правками: оба алгоритма находят одно и то же
+    std::wstring oldText = TestSupport::generateText(200000, 9);
+    std::wstring newText = oldText;
+    for (size_t offset = 1000; offset < newText.size(); offset += 40000)
+    {
+        newText.insert(newText.find(L'\n', offset) + 1, L"новая строка\r\n");
+    }
+    std::vector<LineDiff::Hunk> myersHunks;
+    std::vector<LineDiff::Hunk> histogramHunks;
+    LineDiff::compute(oldText.data(), oldText.size(), newText.data(), newText.size(), myersHunks);
+    CHECK(LineDiff::compute(oldText.data(), oldText.size(), newText.data(), newText.size(), histogramHunks,
+                            LineDiff::ALGORITHM_HISTOGRAM, LineDiff::Progress()));
+    CHECK(checkHunks(oldText, newText, histogramHunks));
+    CHECK(histogramHunks.size() == myersHunks.size());
+}
+
+TEST_CASE(histogramAnchorsOnRepeatedLines)
+{
+    // Каждая строка повторяется четыре раза, уникальных строк нет. Предел
+    // числа правок не дает Майерсу найти ничего, кроме замены всей области,
+    // а гистограмма опирается на строки с наименьшим числом вхождений
+    std::wstring oldText;
+    for (int copy = 0; copy < 4; ++copy)
+    {
+        for (int line = 0; line < 10; ++line)
+        {
+            oldText += L"строка " + std::to_wstring(line) + L"\n";
+        }
+    }
+    std::vector<std::wstring> lines = splitLines(oldText);
+    lines[5] = L"первая правка\n";
+    lines[34] = L"вторая правка\n";
+    std::wstring newText;
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        newText += lines[i];
+    }
+
+    std::vector<LineDiff::Hunk> hunks;
+    CHECK(LineDiff::compute(oldText.data(), oldText.size(), newText.data(), newText.size(), hunks,
+                            LineDiff::ALGORITHM_HISTOGRAM, LineDiff::Progress(), 1));
+    CHECK(checkHunks(oldText, newText, hunks));
+    CHECK(hunks.size() == 2);
+    CHECK(hunks.size() == 2 && hunks[0].oldLine == 5 && hunks[0].oldLineCount == 1 &&
+          hunks[1].oldLine == 34 && hunks[1].newLineCount == 1);
+
+    LineDiff::compute(oldText.data(), oldText.size(), newText.data(), newText.size(), hunks, 1);
+    CHECK(hunks.size() == 1);
+}
+
+TEST_CASE(reportsProgressAndCancels)
+{
+    std::mt19937 random(17);
+    std::wstring oldText = randomText(random, 5000);
+    std::wstring newText = randomText(random, 5000);
+    std::vector<LineDiff::Hunk> hunks;
+    size_t lineTotal = splitLines(oldText).size();
+
+    size_t callCount = 0;
+    size_t lastProcessed = 0;
+    bool isMonotonic = true;
+    bool isTotalCorrect = true;
+    LineDiff::Progress progress = [&](size_t processedLines, size_t totalLines)
+    {
+        ++callCount;
+        isMonotonic = isMonotonic && processedLines >= lastProcessed && processedLines <= totalLines;
+        isTotalCorrect = isTotalCorrect && totalLines == lineTotal;
+        lastProcessed = processedLines;
+        return true;
+    };
+    CHECK(LineDiff::compute(oldText.data(), oldText.size(), newText.data(), newText.size(), hunks,
+                            LineDiff::ALGORITHM_HISTOGRAM, progress));
+    CHECK(callCount > 1 && isMonotonic && isTotalCorrect && lastProcessed == lineTotal);
+    CHECK(checkHunks(oldText, newText, hunks));
+
+    // Отмена при первом же отчете: результат пуст
+    callCount = 0;
+    LineDiff::Progress cancel = [&](size_t, size_t)
+    {
+        ++callCount;
+        return false;
+    };
+    CHECK(!LineDiff::compute(oldText.data(), oldText.size(), newText.data(), newText.size(), hunks,
+                             LineDiff::ALGORITHM_MYERS, cancel));
+    CHECK(hunks.empty() && callCount == 1);
+}
+
+int main()
+{
+    return TestHarness::runAll();
+}
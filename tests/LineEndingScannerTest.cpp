@@ -0,0 +1,101 @@
+#include "TestHarness.h"
+#include "TestSupport.h"
+#include "LineEndingScanner.h"
+
+namespace
+{
+    // Простой подсчет для сравнения: по единицам заданного размера
+    LineEndingScanner::Counts countSlowly(const std::string& bytes, size_t offset, size_t size, size_t unitSize, bool isBigEndian)
+    {
+        LineEndingScanner::Counts counts = { 0, 0, 0 };
+        size_t unitCount = size / unitSize;
+        std::vector<unsigned> units(unitCount);
+        for (size_t i = 0; i < unitCount; ++i)
+        {
+            const unsigned char* unit = (const unsigned char*)bytes.data() + offset + i * unitSize;
+            units[i] = unitSize == 1 ? unit[0] : isBigEndian ? (unit[0] << 8) | unit[1] : (unit[1] << 8) | unit[0];
+        }
+        for (size_t i = 0; i < unitCount; ++i)
+        {
+            if (units[i] == '\r' && i + 1 < unitCount && units[i + 1] == '\n')
+            {
+                ++counts.crlf;
+                ++i;
+            }
+            else if (units[i] == '\r')
+            {
+                ++counts.cr;
+            }
+            else if (units[i] == '\n')
+            {
+                ++counts.lf;
+            }
+        }
+        return counts;
+    }
+
+    bool sameCounts(const LineEndingScanner::Counts& left, const LineEndingScanner::Counts& right)
+    {
+        return left.crlf == right.crlf && left.lf == right.lf && left.cr == right.cr;
+    }
+}
+
+TEST_CASE(scanMatchesSimpleCount)
+{
+    // Переводы строк часто, чтобы пары попадали на границы 16-байтовых шагов
+    std::mt19937 random(41);
+    static const char ALPHABET[] = { '\r', '\n', 'a', '\0', '\x04', '\r', '\n' };
+    std::string bytes;
+    for (int i = 0; i < 20000; ++i)
+    {
+        bytes += ALPHABET[random() % sizeof(ALPHABET)];
+    }
+
+    bool isCorrect = true;
+    for (int round = 0; round < 2000; ++round)
+    {
+        size_t offset = random() % 64;
+        size_t size = random() % (round % 10 == 0 ? bytes.size() - offset : 100);
+        size_t unitSize = 1 + round % 2;
+        bool isBigEndian = round % 4 == 3;
+        LineEndingScanner::Counts fast = LineEndingScanner::scan(bytes.data() + offset, size, unitSize, isBigEndian);
+        isCorrect = isCorrect && sameCounts(fast, countSlowly(bytes, offset, size, unitSize, isBigEndian));
+    }
+    CHECK(isCorrect);
+}
+
+TEST_CASE(scansTextAndPicksDominantStyle)
+{
+    std::wstring text = L"a\r\nb\nc\nd\re\r\n\r";
+    LineEndingScanner::Counts counts = LineEndingScanner::scanText(text.data(), text.size());
+    CHECK(counts.crlf == 2 && counts.lf == 2 && counts.cr == 2);
+    CHECK(LineEndingScanner::expansion(counts) == 4);
+
+    LineEndingScanner::Counts lf = { 1, 5, 2 };
+    LineEndingScanner::Counts cr = { 1, 0, 3 };
+    LineEndingScanner::Counts none = { 0, 0, 0 };
+    CHECK(LineEndingScanner::dominant(lf) == DocumentFormat::LINE_ENDING_LF);
+    CHECK(LineEndingScanner::dominant(cr) == DocumentFormat::LINE_ENDING_CR);
+    CHECK(LineEndingScanner::dominant(none) == DocumentFormat::LINE_ENDING_CRLF);
+}
+
+TEST_CASE(normalizesInPlace)
+{
+    std::wstring text = L"\nодин\nдва\r\nтри\rчетыре\r";
+    LineEndingScanner::Counts counts = LineEndingScanner::scanText(text.data(), text.size());
+    text.reserve(text.size() + (size_t)LineEndingScanner::expansion(counts));
+    const wchar_t* data = text.data();
+    LineEndingScanner::normalize(text, counts);
+    CHECK(text == L"\r\nодин\r\nдва\r\nтри\r\nчетыре\r\n");
+    CHECK(text.data() == data);
+
+    // Текст без одиночных переводов не меняется
+    std::wstring crlf = L"a\r\nb";
+    LineEndingScanner::normalize(crlf, LineEndingScanner::scanText(crlf.data(), crlf.size()));
+    CHECK(crlf == L"a\r\nb");
+}
+
+int main()
+{
+    return TestHarness::runAll();
+}
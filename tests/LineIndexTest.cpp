@@ -0,0 +1,141 @@
+#include "TestHarness.h"
+#include "TestSupport.h"
+#include "ChunkLineIndex.h"
+#include "SparseLineIndex.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <thread>
+
+namespace
+{
+    void waitForIndex(const SparseLineIndex& index)
+    {
+        while (!index.isComplete())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+
+    std::vector<size_t> lineStarts(const std::wstring& text)
+    {
+        std::vector<size_t> starts(1, 0);
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            if (text[i] == L'\n')
+            {
+                starts.push_back(i + 1);
+            }
+        }
+        return starts;
+    }
+}
+
+TEST_CASE(findsLineFeedInEncodedUnits)
+{
+    const char utf8[] = "ab\ncd";
+    CHECK(SparseLineIndex::findLineFeed(utf8, utf8 + 5, 0, 1, false) == utf8 + 2);
+    CHECK(SparseLineIndex::findLineFeed(utf8, utf8 + 2, 0, 1, false) == utf8 + 2);
+
+    // U+0A0D ("\x0D\x0A" в LE) не перевод строки; "\n" LE - байты 0A 00
+    const char le[] = { 'a', 0, 0x0D, 0x0A, '\n', 0 };
+    CHECK(SparseLineIndex::findLineFeed(le, le + 6, 0, 2, false) == le + 4);
+    const char be[] = { 0, 'a', 0x0A, 0x0D, 0, '\n' };
+    CHECK(SparseLineIndex::findLineFeed(be, be + 6, 0, 2, true) == be + 4);
+
+    // Выравнивание единиц считается от начала файла, а не буфера
+    CHECK(SparseLineIndex::findLineFeed(le + 1, le + 6, 1, 2, false) == le + 4);
+}
+
+TEST_CASE(sparseIndexFindsCheckpoints)
+{
+    std::string bytes;
+    std::vector<uint64_t> starts;
+    for (int line = 0; line < 100000; ++line)
+    {
+        starts.push_back(bytes.size());
+        bytes += "строка " + std::to_string(line) + "\n";
+    }
+    std::string path = TestSupport::temporaryPath("sparse.txt");
+    CHECK(TestSupport::writeFile(path, bytes));
+
+    SparseLineIndex index;
+    index.start(std::wstring(path.begin(), path.end()), 0, 1, false);
+    waitForIndex(index);
+    CHECK(index.lineCount() == 100001);
+    CHECK(index.scannedBytes() == bytes.size());
+
+    bool isCorrect = true;
+    std::mt19937 random(43);
+    for (int i = 0; i < 1000; ++i)
+    {
+        uint64_t line = random() % 100000;
+        uint64_t checkpointLine = 0;
+        uint64_t checkpointOffset = 0;
+        isCorrect = isCorrect && index.checkpointForLine(line, checkpointLine, checkpointOffset);
+        isCorrect = isCorrect && checkpointLine <= line && line - checkpointLine < SparseLineIndex::DEFAULT_STRIDE;
+        isCorrect = isCorrect && checkpointOffset == starts[(size_t)checkpointLine];
+
+        uint64_t offset = starts[(size_t)line] + 3;
+        isCorrect = isCorrect && index.checkpointForOffset(offset, checkpointLine, checkpointOffset);
+        isCorrect = isCorrect && checkpointOffset <= offset && checkpointLine <= line && checkpointOffset == starts[(size_t)checkpointLine];
+    }
+    CHECK(isCorrect);
+    uint64_t lineEnd = 0;
+    CHECK(!index.longLineEnd(0, lineEnd));
+    index.stop();
+    std::remove(path.c_str());
+}
+
+TEST_CASE(sparseIndexRemembersLongLines)
+{
+    std::string bytes = "a\n" + std::string(SparseLineIndex::LONG_LINE_BYTES + 10, 'x') + "\nb";
+    std::string path = TestSupport::temporaryPath("long.txt");
+    CHECK(TestSupport::writeFile(path, bytes));
+    SparseLineIndex index;
+    index.start(std::wstring(path.begin(), path.end()), 0, 1, false);
+    waitForIndex(index);
+    uint64_t lineEnd = 0;
+    CHECK(index.longLineEnd(2, lineEnd) && lineEnd == bytes.size() - 2);
+    CHECK(index.lineCount() == 3);
+    index.stop();
+    std::remove(path.c_str());
+}
+
+TEST_CASE(chunkIndexFollowsEdits)
+{
+    std::wstring text = TestSupport::generateText(200000, 8);
+    TextChangeTracker tracker;
+    ChunkLineIndex index;
+    tracker.addListener(&index);
+    tracker.reset(text.data(), text.size());
+
+    std::mt19937 random(47);
+    bool isCorrect = true;
+    for (int round = 0; round < 200 && isCorrect; ++round)
+    {
+        size_t offset = random() % (text.size() + 1);
+        size_t removeCount = std::min<size_t>(random() % 3000, text.size() - offset);
+        std::wstring inserted = TestSupport::generateText(random() % 3000, round);
+        text.replace(offset, removeCount, inserted);
+        tracker.applyEdit(offset, removeCount, inserted);
+
+        std::vector<size_t> starts = lineStarts(text);
+        isCorrect = index.lineCount() == starts.size();
+        for (int probe = 0; probe < 20 && isCorrect; ++probe)
+        {
+            size_t line = random() % starts.size();
+            size_t position = starts[line] + random() % 3;
+            size_t expectedLine = std::upper_bound(starts.begin(), starts.end(), std::min(position, text.size())) - starts.begin() - 1;
+            isCorrect = index.lineStart(tracker.text(), line) == starts[line] &&
+                        index.lineOfOffset(tracker.text(), std::min(position, text.size())) == expectedLine;
+        }
+    }
+    CHECK(isCorrect);
+    CHECK(index.lineStart(tracker.text(), index.lineCount() + 10) == lineStarts(text).back());
+}
+
+int main()
+{
+    return TestHarness::runAll();
+}
@@ -0,0 +1,142 @@
+#include "TestHarness.h"
+#include "LineOperations.h"
+#include <algorithm>
+#include <cwctype>
+#include <random>
+#include <set>
+
+namespace
+{
+    typedef LineOperations::Line Line;
+
+    std::vector<std::wstring> lineTexts(const std::wstring& text, const std::vector<Line>& lines)
+    {
+        std::vector<std::wstring> result;
+        for (size_t i = 0; i < lines.size(); ++i)
+        {
+            result.push_back(text.substr(lines[i].offset, lines[i].length));
+        }
+        return result;
+    }
+
+    // Сравнение без учета регистра: у равных строк разный текст, что
+    // проверяет устойчивость сортировки
+    int compareIgnoreCase(const wchar_t* left, size_t leftLength, const wchar_t* right, size_t rightLength)
+    {
+        for (size_t i = 0; i < std::min(leftLength, rightLength); ++i)
+        {
+            wchar_t leftCharacter = (wchar_t)towlower(left[i]);
+            wchar_t rightCharacter = (wchar_t)towlower(right[i]);
+            if (leftCharacter != rightCharacter)
+            {
+                return leftCharacter < rightCharacter ? -1 : 1;
+            }
+        }
+        return leftLength < rightLength ? -1 : (leftLength > rightLength ? 1 : 0);
+    }
+
+    std::wstring randomLines(std::mt19937& random, size_t lineCount, bool hasPrefix)
+    {
+        std::wstring text;
+        for (size_t i = 0; i < lineCount; ++i)
+        {
+            text += hasPrefix ? L"pre" : L"";
+            for (size_t length = random() % 4; length > 0; --length)
+            {
+                text.push_back(L"aAbB \t"[random() % 6]);
+            }
+            text += i + 1 == lineCount ? L"" : (random() % 2 ? L"\r\n" : L"\n");
+        }
+        return text;
+    }
+}
+
+TEST_CASE(splitsAndJoinsLines)
+{
+    std::wstring text = L"b\r\na  \n\nc\t";
+    std::vector<Line> lines;
+    LineOperations::split(text.data(), text.size(), lines);
+    CHECK(lines.size() == 4);
+    CHECK(lineTexts(text, lines) == std::vector<std::wstring>({ L"b", L"a  ", L"", L"c\t" }));
+
+    LineOperations::trimTrailing(text.data(), lines);
+    LineOperations::reverse(lines);
+    std::wstring result;
+    LineOperations::join(text.data(), lines, L"\r\n", result);
+    CHECK(result == L"c\r\n\r\na\r\nb");
+
+    LineOperations::split(L"", 0, lines);
+    CHECK(lines.size() == 1 && lines[0].length == 0);
+}
+
+TEST_CASE(sortsStablyWithAnyThreadCount)
+{
+    std::mt19937 random(3);
+    bool isCorrect = true;
+    for (int round = 0; round < 6 && isCorrect; ++round)
+    {
+        // Каждая третья проба больше MIN_LINES_PER_THREAD на поток
+        size_t lineCount = round % 3 == 0 ? 100000 + random() % 50000 : random() % 2000;
+        std::wstring text = randomLines(random, lineCount, round % 2 == 1);
+        std::vector<Line> lines;
+        LineOperations::split(text.data(), text.size(), lines);
+        std::vector<std::wstring> texts = lineTexts(text, lines);
+
+        std::vector<std::wstring> expected = texts;
+        std::stable_sort(expected.begin(), expected.end());
+        std::vector<size_t> order(lines.size());
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](size_t left, size_t right)
+        {
+            return compareIgnoreCase(texts[left].data(), texts[left].size(), texts[right].data(), texts[right].size()) < 0;
+        });
+
+        const size_t threadCounts[] = { 1, 2, 3, 5, 8 };
+        for (size_t i = 0; i < sizeof(threadCounts) / sizeof(threadCounts[0]) && isCorrect; ++i)
+        {
+            std::vector<Line> ordinal = lines;
+            LineOperations::sort(text.data(), ordinal, LineOperations::Compare(), threadCounts[i]);
+            std::vector<Line> ignoreCase = lines;
+            LineOperations::sort(text.data(), ignoreCase, compareIgnoreCase, threadCounts[i]);
+            isCorrect = lineTexts(text, ordinal) == expected;
+            for (size_t j = 0; j < order.size() && isCorrect; ++j)
+            {
+                isCorrect = ignoreCase[j].offset == lines[order[j]].offset;
+            }
+        }
+    }
+    CHECK(isCorrect);
+}
+
+TEST_CASE(uniqueKeepsFirstOccurrence)
+{
+    std::mt19937 random(4);
+    bool isCorrect = true;
+    for (int round = 0; round < 6 && isCorrect; ++round)
+    {
+        std::wstring text = randomLines(random, round % 2 == 0 ? 100000 : 3000, round % 3 == 0);
+        std::vector<Line> lines;
+        LineOperations::split(text.data(), text.size(), lines);
+        std::vector<std::wstring> expected;
+        std::set<std::wstring> seen;
+        std::vector<std::wstring> texts = lineTexts(text, lines);
+        for (size_t i = 0; i < texts.size(); ++i)
+        {
+            if (seen.insert(texts[i]).second)
+            {
+                expected.push_back(texts[i]);
+            }
+        }
+        LineOperations::unique(text.data(), lines, 1 + round % 4);
+        isCorrect = lineTexts(text, lines) == expected;
+    }
+    CHECK(isCorrect);
+}
+
+int main()
+{
+    return TestHarness::runAll();
+}
@@ -0,0 +1,122 @@
+#include "TestHarness.h"
+#include "MinimapCache.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+    std::wstring randomText(std::mt19937& random, size_t length)
+    {
+        const wchar_t alphabet[] = L"ab \t\r\n\n xyz";
+        std::wstring text;
+        for (size_t i = 0; i < length; ++i)
+        {
+            text.push_back(alphabet[random() % (sizeof(alphabet) / sizeof(alphabet[0]) - 1)]);
+        }
+        return text;
+    }
+}
+
+TEST_CASE(rastersNonBlankCharacters)
+{
+    std::wstring text = L"ab  cd\r\n\tx\r\n";
+    TextChangeTracker tracker;
+    MinimapCache cache;
+    tracker.addListener(&cache);
+    tracker.reset(text.data(), text.size());
+    CHECK(cache.lineCount() == 3);
+
+    // Строка текста - две точки по высоте, точка - два столбца
+    std::vector<uint8_t> pixels;
+    CHECK(cache.render(10, pixels) == 6);
+    CHECK(pixels.size() == 10 * MinimapCache::WIDTH);
+    const uint8_t* first = &pixels[1 * MinimapCache::WIDTH];
+    const uint8_t* second = &pixels[2 * MinimapCache::WIDTH];
+    CHECK(first[0] == 255 && first[1] == 0 && first[2] == 255 && first[3] == 0);
+    CHECK(second[0] == 0 && second[1] == 0 && second[2] == 127 && second[3] == 0);
+    CHECK(std::count(pixels.begin() + 4 * MinimapCache::WIDTH, pixels.end(), 0) == 6 * (int)MinimapCache::WIDTH);
+
+    CHECK(cache.rowOfLine(1, 10) == 2 && cache.lineAtRow(3, 10) == 1 && cache.lineAtRow(9, 10) == 2);
+    uint32_t version = cache.version();
+    tracker.applyEdit(0, 0, L"\r\n");
+    CHECK(cache.version() != version && cache.lineCount() == 4);
+}
+
+TEST_CASE(editsMatchFreshBuild)
+{
+    std::mt19937 random(5);
+    bool isCorrect = true;
+    for (int round = 0; round < 60 && isCorrect; ++round)
+    {
+        std::wstring text = randomText(random, random() % 6000);
+        TextChangeTracker tracker;
+        MinimapCache cache;
+        tracker.addListener(&cache);
+        tracker.reset(text.data(), text.size());
+
+        // Документ короче TARGET_ROWS строк: строка растра - одна строка
+        // текста, и картинка не зависит от разбиения на плитки
+        for (int edit = 0; edit < 30 && isCorrect; ++edit)
+        {
+            size_t length = tracker.text().length();
+            size_t offset = length > 0 ? random() % (length + 1) : 0;
+            size_t removeCount = std::min<size_t>(random() % (random() % 5 == 0 ? 1000 : 5), length - offset);
+            tracker.applyEdit(offset, removeCount, randomText(random, random() % (random() % 5 == 0 ? 1000 : 4)));
+
+            MinimapCache fresh;
+            fresh.onTextReset(tracker.text());
+            std::vector<uint8_t> pixels;
+            std::vector<uint8_t> freshPixels;
+            size_t height = 700 + random() % 1000;
+            isCorrect = cache.lineCount() == fresh.lineCount() && cache.lineCount() < MinimapCache::TARGET_ROWS &&
+                        cache.render(height, pixels) == fresh.render(height, freshPixels) && pixels == freshPixels;
+        }
+    }
+    CHECK(isCorrect);
+}
+
+TEST_CASE(largeDocumentKeepsRasterSize)
+{
+    std::mt19937 random(6);
+    std::wstring text = randomText(random, 2000000);
+    TextChangeTracker tracker;
+    MinimapCache cache;
+    tracker.addListener(&cache);
+    tracker.reset(text.data(), text.size());
+    size_t lineCount = (size_t)std::count(text.begin(), text.end(), L'\n') + 1;
+    CHECK(cache.lineCount() == lineCount);
+    CHECK(cache.tileCount() <= 2 * MinimapCache::TARGET_ROWS);
+
+    // Правки с переводами строк обновляют число строк, растр не растет
+    for (int edit = 0; edit < 200; ++edit)
+    {
+        size_t offset = random() % tracker.text().length();
+        std::wstring removed = tracker.text().substr(offset, random() % 100);
+        std::wstring inserted = randomText(random, random() % 100);
+        lineCount = lineCount - std::count(removed.begin(), removed.end(), L'\n') + std::count(inserted.begin(), inserted.end(), L'\n');
+        tracker.applyEdit(offset, removed.size(), inserted);
+    }
+    MinimapCache fresh;
+    fresh.onTextReset(tracker.text());
+    CHECK(cache.lineCount() == lineCount && fresh.lineCount() == lineCount);
+    CHECK(cache.tileCount() <= 2 * MinimapCache::TARGET_ROWS);
+    CHECK(cache.memoryUsage() <= 2 * fresh.memoryUsage());
+
+    // Строка карты и строка текста переводятся друг в друга монотонно
+    std::vector<uint8_t> pixels;
+    CHECK(cache.render(900, pixels) == 900);
+    size_t previous = 0;
+    bool isMonotonic = true;
+    for (size_t y = 0; y < 900; ++y)
+    {
+        size_t line = cache.lineAtRow(y, 900);
+        isMonotonic = isMonotonic && line >= previous && cache.rowOfLine(line, 900) <= y;
+        previous = line;
+    }
+    CHECK(isMonotonic);
+}
+
+int main()
+{
+    return TestHarness::runAll();
+}
@@ -0,0 +1,194 @@
+#include "TestHarness.h"
+#include "TestSupport.h"
+#include "SelectionModel.h"
+#include "TextChangeTracker.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+    // Применить пакет замен к строке, как к тексту редактора: с конца
+    void applyEdits(std::wstring& text, const std::vector<SelectionModel::Edit>& edits, const std::wstring& inserted)
+    {
+        for (size_t i = edits.size(); i-- > 0;)
+        {
+            text.replace(edits[i].offset, edits[i].removeCount, inserted);
+        }
+    }
+
+    // Текст из generateText содержит только переводы строки "\r\n"
+    bool hasBrokenLineEnd(const std::wstring& text)
+    {
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            bool isCarriageReturn = text[i] == L'\r';
+            bool isLineFeedNext = i + 1 < text.size() && text[i + 1] == L'\n';
+            if (isCarriageReturn != isLineFeedNext)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Позиция не внутри "\r\n"
+    size_t lineBoundary(const std::wstring& text, size_t position)
+    {
+        return position > 0 && position < text.size() && text[position - 1] == L'\r' ? position + 1 : position;
+    }
+
+    bool isSortedAndDisjoint(const SelectionModel& model)
+    {
+        for (size_t i = 1; i < model.count(); ++i)
+        {
+            if (model.at(i - 1).end() >= model.at(i).start())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+TEST_CASE(addMergesTouchingSelections)
+{
+    SelectionModel model;
+    model.reset(50, 50);
+    model.add(10, 20);
+    model.add(30, 30);
+    CHECK(model.count() == 3 && model.at(0).start() == 10 && model.at(2).caret == 50);
+    CHECK(model.primary().caret == 30);
+
+    // Новое выделение поглощает касающееся и пересекающееся
+    model.add(35, 20);
+    CHECK(model.count() == 2);
+    CHECK(model.at(0).anchor == 35 && model.at(0).caret == 10);
+    CHECK(model.primary().caret == 10);
+
+    model.reset(7, 3);
+    CHECK(model.count() == 1 && model.primary().start() == 3 && model.primary().end() == 7);
+}
+
+TEST_CASE(typingIntoAllCaretsKeepsTextConsistent)
+{
+    std::wstring text = TestSupport::generateText(200000, 11);
+    TextChangeTracker tracker;
+    ChunkLineIndex lines;
+    tracker.addListener(&lines);
+    tracker.reset(text.data(), text.size());
+
+    std::mt19937 random(61);
+    SelectionModel model;
+    model.reset(0, 0);
+    for (int i = 0; i < 300; ++i)
+    {
+        size_t position = lineBoundary(text, random() % (text.size() + 1));
+        if (i % 4 == 0)
+        {
+            model.add(position, lineBoundary(text, std::min(text.size(), position + random() % 20)));
+        }
+        else
+        {
+            model.add(position, position);
+        }
+    }
+
+    bool isCorrect = isSortedAndDisjoint(model);
+    std::vector<SelectionModel::Edit> edits;
+    for (int step = 0; step < 200 && isCorrect; ++step)
+    {
+        std::wstring inserted;
+        int action = random() % 5;
+        if (action == 3)
+        {
+            model.deleteBackward(tracker.text(), edits);
+        }
+        else if (action == 4)
+        {
+            model.deleteForward(tracker.text(), edits);
+        }
+        else
+        {
+            inserted = action == 2 ? L"\r\n" : std::wstring(1 + random() % 3, L"яx"[random() % 2]);
+            model.insert(inserted.size(), edits);
+        }
+
+        // Одна замена участка (для EDIT-контрола) дает тот же текст
+        std::wstring span;
+        size_t spanLength = 0;
+        size_t spanStart = SelectionModel::composeSpan(tracker.text(), edits, inserted, span, spanLength);
+        std::wstring whole = text;
+        whole.replace(spanStart, spanLength, span);
+
+        applyEdits(text, edits, inserted);
+        for (size_t i = edits.size(); i-- > 0;)
+        {
+            tracker.applyEdit(edits[i].offset, edits[i].removeCount, inserted);
+        }
+        isCorrect = whole == text && tracker.text().toString() == text && isSortedAndDisjoint(model) &&
+                    !hasBrokenLineEnd(text);
+
+        // Каждый курсор стоит сразу после вставленного текста
+        for (size_t i = 0; i < model.count() && isCorrect; ++i)
+        {
+            size_t caret = model.at(i).caret;
+            isCorrect = caret <= text.size() && model.at(i).anchor == caret &&
+                        (inserted.empty() || text.compare(caret - inserted.size(), inserted.size(), inserted) == 0);
+        }
+    }
+    CHECK(isCorrect);
+    CHECK(model.count() > 1);
+    CHECK(lines.lineCount() == (size_t)std::count(text.begin(), text.end(), L'\n') + 1);
+}
+
+TEST_CASE(deleteMergesAdjacentCarets)
+{
+    std::wstring text = L"abc\r\ndef";
+    ChunkedText chunks;
+    chunks.assign(text.data(), text.size());
+    SelectionModel model;
+    model.reset(5, 5);
+    model.add(6, 6);
+    model.add(0, 0);
+
+    // Курсор в начале текста удалять нечего, "\r\n" удаляется целиком
+    std::vector<SelectionModel::Edit> edits;
+    model.deleteBackward(chunks, edits);
+    CHECK(edits.size() == 2);
+    CHECK(edits[0].offset == 3 && edits[0].removeCount == 2);
+    CHECK(edits[1].offset == 5 && edits[1].removeCount == 1);
+    applyEdits(text, edits, L"");
+    CHECK(text == L"abcef");
+    CHECK(model.count() == 2 && model.at(0).caret == 0 && model.at(1).caret == 3);
+}
+
+TEST_CASE(addsCaretsByLinesAndColumns)
+{
+    std::wstring text = L"first line\r\nab\r\nthird line\r\n";
+    TextChangeTracker tracker;
+    ChunkLineIndex lines;
+    tracker.addListener(&lines);
+    tracker.reset(text.data(), text.size());
+
+    // Столбец сохраняется, но не выходит за конец короткой строки
+    SelectionModel model;
+    model.reset(6, 6);
+    CHECK(model.addCaretOnLine(tracker.text(), lines, 1));
+    CHECK(model.primary().caret == 14);
+    CHECK(model.addCaretOnLine(tracker.text(), lines, 1));
+    CHECK(model.primary().caret == 18);
+    CHECK(!model.addCaretOnLine(tracker.text(), lines, 2));
+    CHECK(model.count() == 3);
+
+    model.selectColumn(tracker.text(), lines, 1, 24);
+    CHECK(model.count() == 3);
+    CHECK(model.at(0).start() == 1 && model.at(0).end() == 8);
+    CHECK(model.at(1).start() == 13 && model.at(1).end() == 14);
+    CHECK(model.at(2).start() == 17 && model.at(2).end() == 24);
+    CHECK(model.primary().caret == 24);
+}
+
+int main()
+{
+    return TestHarness::runAll();
+}
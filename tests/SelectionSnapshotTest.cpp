@@ -0,0 +1,74 @@
+#include "TestHarness.h"
+#include "TestSupport.h"
+#include "SelectionSnapshot.h"
+#include "benchmarks/Benchmark.h"
+#include <random>
+
+namespace
+{
+    std::wstring render(const SelectionSnapshot& snapshot)
+    {
+        std::vector<wchar_t> output(snapshot.length() + 1, L'#');
+        snapshot.copyTo(output.data());
+        return output[snapshot.length()] == L'\0' ? std::wstring(output.data(), snapshot.length()) : L"нет нуля";
+    }
+}
+
+TEST_CASE(rendersSelectedRange)
+{
+    std::wstring text = TestSupport::generateText(100000, 3);
+    ChunkedText chunks;
+    chunks.assign(text.data(), text.size());
+
+    std::mt19937 random(59);
+    bool isCorrect = true;
+    for (int i = 0; i < 500; ++i)
+    {
+        size_t offset = random() % (text.size() + 1);
+        size_t count = random() % (i % 5 == 0 ? 50000 : 100);
+        SelectionSnapshot snapshot(chunks, offset, count);
+        isCorrect = isCorrect && render(snapshot) == text.substr(offset, count);
+    }
+    CHECK(isCorrect);
+
+    // Фрагмент за концом текста обрезается
+    SelectionSnapshot tail(chunks, text.size() - 5, 100);
+    CHECK(tail.length() == 5 && render(tail) == text.substr(text.size() - 5));
+    SelectionSnapshot empty(chunks, text.size(), 10);
+    CHECK(empty.length() == 0 && render(empty).empty());
+}
+
+TEST_CASE(laterEditsDoNotChangeSnapshot)
+{
+    std::wstring text = TestSupport::generateText(50000, 4);
+    ChunkedText chunks;
+    chunks.assign(text.data(), text.size());
+    SelectionSnapshot snapshot(chunks, 1000, 30000);
+    std::wstring expected = text.substr(1000, 30000);
+
+    chunks.replace(5000, 10000, L"правка", 6);
+    chunks.replace(0, 0, L"начало", 6);
+    chunks.assign(L"новый текст", 11);
+    CHECK(render(snapshot) == expected);
+}
+
+TEST_CASE(creationDoesNotCopyText)
+{
+    // Снимок почти всего текста в 20 МБ: время и память - по числу блоков
+    std::wstring text = TestSupport::generateText(10 * 1024 * 1024, 5);
+    ChunkedText chunks;
+    chunks.assign(text.data(), text.size());
+    double baseMemory = Benchmark::residentMegabytes();
+    Benchmark::Stopwatch stopwatch;
+    SelectionSnapshot snapshot(chunks, 1, text.size() - 2);
+    double creationTime = stopwatch.elapsedMilliseconds();
+    double memory = Benchmark::residentMegabytes() - baseMemory;
+    std::printf("  Снимок %.1f МБ текста: %.3f мс, прирост RSS %.2f МБ\n", text.size() * 2 / 1048576.0, creationTime, memory);
+    CHECK(snapshot.length() == text.size() - 2);
+    CHECK(memory < 2.0);
+}
+
+int main()
+{
+    return TestHarness::runAll();
+}
@@ -0,0 +1,117 @@
+#include "TestHarness.h"
+#include "TestSupport.h"
+#include "ChunkedText.h"
+#include "ContentHash.h"
+#include "SessionSnapshot.h"
+#include <unistd.h>
+
+namespace
+{
+    SessionState sampleState(const std::wstring& documentPath)
+    {
+        SessionState state;
+        state.documentPath = documentPath;
+        state.fileSize = 10;
+        state.fileModifiedTime = 20;
+        state.contentHash = ContentHash::compute("abc", 3);
+        state.format.codePage = DocumentFormat::CODE_PAGE_UTF16LE;
+        state.format.hasBom = true;
+        state.format.lineEnding = DocumentFormat::LINE_ENDING_LF;
+        state.selectionStart = 5;
+        state.selectionEnd = 7;
+        state.firstVisibleLine = 100;
+        return state;
+    }
+}
+
+TEST_CASE(restoresTextStateAndLineIndex)
+{
+    std::wstring text;
+    for (int i = 0; i < 5000; ++i)
+    {
+        text += L"строка " + std::to_wstring(i) + L"\r\n";
+    }
+    ChunkedText chunks;
+    chunks.assign(text.data(), text.size());
+    std::wstring snapshotPath = TestSupport::temporaryWidePath("restore.snap");
+    SessionState state = sampleState(L"/home/user/документ.txt");
+    CHECK(SessionSnapshot::write(snapshotPath, state, chunks));
+
+    SessionSnapshot snapshot;
+    CHECK(snapshot.open(snapshotPath));
+    CHECK(snapshot.textLength() == text.size());
+    CHECK(std::wstring(snapshot.text(), snapshot.textLength()) == text);
+    CHECK(snapshot.text()[snapshot.textLength()] == L'\0');
+    CHECK(snapshot.lineCount() == 5001);
+    CHECK(snapshot.lineOffset(1) == text.find(L'\n') + 1);
+    CHECK(snapshot.lineOffset(5000) == text.size());
+
+    const SessionState& restored = snapshot.state();
+    CHECK(restored.documentPath == state.documentPath);
+    CHECK(restored.contentHash == state.contentHash);
+    CHECK(restored.format.codePage == DocumentFormat::CODE_PAGE_UTF16LE);
+    CHECK(restored.format.hasBom);
+    CHECK(restored.format.lineEnding == DocumentFormat::LINE_ENDING_LF);
+    CHECK(restored.selectionStart == 5 && restored.selectionEnd == 7);
+    CHECK(restored.firstVisibleLine == 100);
+    snapshot.close();
+    PortableFile::remove(snapshotPath);
+}
+
+TEST_CASE(matchesOnlySameFileVersion)
+{
+    ChunkedText chunks;
+    chunks.assign(L"abc", 3);
+    std::wstring snapshotPath = TestSupport::temporaryWidePath("match.snap");
+    CHECK(SessionSnapshot::write(snapshotPath, sampleState(L"/tmp/doc.txt"), chunks));
+
+    SessionSnapshot snapshot;
+    CHECK(snapshot.open(snapshotPath));
+    PortableFile::Info info = { 10, 20 };
+    CHECK(snapshot.matches(L"/tmp/doc.txt", info));
+    CHECK(!snapshot.matches(L"/tmp/other.txt", info));
+    info.size = 11;
+    CHECK(!snapshot.matches(L"/tmp/doc.txt", info));
+    info.size = 10;
+    info.modifiedTime = 21;
+    CHECK(!snapshot.matches(L"/tmp/doc.txt", info));
+    snapshot.close();
+    PortableFile::remove(snapshotPath);
+}
+
+TEST_CASE(verifiesContentHash)
+{
+    std::string documentPath = TestSupport::temporaryPath("verify.txt");
+    CHECK(TestSupport::writeFile(documentPath, "abc"));
+    std::wstring widePath(documentPath.begin(), documentPath.end());
+    uint64_t hash = ContentHash::compute("abc", 3);
+    CHECK(SessionSnapshot::verifyContent(widePath, hash));
+    CHECK(!SessionSnapshot::verifyContent(widePath, hash + 1));
+    PortableFile::remove(widePath);
+    CHECK(!SessionSnapshot::verifyContent(widePath, hash));
+}
+
+TEST_CASE(rejectsDamagedSnapshot)
+{
+    std::wstring text = TestSupport::generateText(100000, 5);
+    ChunkedText chunks;
+    chunks.assign(text.data(), text.size());
+    std::string narrowPath = TestSupport::temporaryPath("damaged.snap");
+    std::wstring snapshotPath(narrowPath.begin(), narrowPath.end());
+    CHECK(SessionSnapshot::write(snapshotPath, sampleState(L"/tmp/doc.txt"), chunks));
+
+    std::string bytes = TestSupport::readFile(narrowPath);
+    SessionSnapshot snapshot;
+    CHECK(TestSupport::writeFile(narrowPath, bytes.substr(0, bytes.size() - 2)));
+    CHECK(!snapshot.open(snapshotPath));
+    CHECK(TestSupport::writeFile(narrowPath, bytes.substr(0, 16)));
+    CHECK(!snapshot.open(snapshotPath));
+    CHECK(TestSupport::writeFile(narrowPath, std::string()));
+    CHECK(!snapshot.open(snapshotPath));
+    PortableFile::remove(snapshotPath);
+}
+
+int main()
+{
+    return TestHarness::runAll();
+}
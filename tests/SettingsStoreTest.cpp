@@ -0,0 +1,191 @@
+#include "TestHarness.h"
+#include "TestSupport.h"
+#include "IniSettingsBackend.h"
+#include "SettingsStore.h"
+
+namespace
+{
+    // Содержимое бэкенда в памяти и счетчики обращений к нему
+    struct BackendState
+    {
+        SettingsMap stored;
+        int loadCount;
+        int saveCount;
+        std::set<std::wstring> lastDirtyNames;
+
+        BackendState() : loadCount(0), saveCount(0) {}
+    };
+
+    // Бэкенд в памяти; состояние переживает хранилище, которое им владеет
+    class CountingBackend : public ISettingsBackend
+    {
+    public:
+        explicit CountingBackend(BackendState& state) : m_state(state) {}
+
+        bool loadAll(SettingsMap& values) override
+        {
+            ++m_state.loadCount;
+            values = m_state.stored;
+            return true;
+        }
+
+        bool saveBatch(const SettingsMap& values, const std::set<std::wstring>& dirtyNames) override
+        {
+            ++m_state.saveCount;
+            m_state.lastDirtyNames = dirtyNames;
+            for (std::set<std::wstring>::const_iterator it = dirtyNames.begin(); it != dirtyNames.end(); ++it)
+            {
+                m_state.stored[*it] = values.find(*it)->second;
+            }
+            return true;
+        }
+
+    private:
+        BackendState& m_state;
+    };
+
+    std::unique_ptr<ISettingsBackend> memoryBackend(BackendState& state)
+    {
+        return std::unique_ptr<ISettingsBackend>(new CountingBackend(state));
+    }
+
+    std::unique_ptr<ISettingsBackend> iniBackend(const std::wstring& path)
+    {
+        return std::unique_ptr<ISettingsBackend>(new IniSettingsBackend(path));
+    }
+}
+
+TEST_CASE(loadsOnceAndBatchesWrites)
+{
+    BackendState backend;
+    backend.stored[L"FontSize"] = SettingValue::fromNumber(12);
+    SettingsStore store(memoryBackend(backend));
+
+    CHECK(store.load());
+    CHECK(store.load());
+    CHECK(backend.loadCount == 1);
+
+    uint32_t size = 0;
+    CHECK(store.getNumber(L"FontSize", size) && size == 12);
+
+    store.setNumber(L"FontSize", 14);
+    store.setString(L"FontName", L"Consolas");
+    store.setNumber(L"TextColor", 0x00FFFFFF);
+    CHECK(backend.saveCount == 0);
+    CHECK(store.isDirty());
+
+    CHECK(store.flush());
+    CHECK(backend.saveCount == 1);
+    CHECK(backend.lastDirtyNames.size() == 3);
+    CHECK(!store.isDirty());
+
+    // Повторная запись прежнего значения не делает настройки измененными
+    store.setNumber(L"FontSize", 14);
+    CHECK(!store.isDirty());
+    CHECK(store.flush());
+    CHECK(backend.saveCount == 1);
+}
+
+TEST_CASE(typeMismatchIsNotFound)
+{
+    BackendState backend;
+    SettingsStore store(memoryBackend(backend));
+    store.load();
+    store.setString(L"Name", L"value");
+
+    uint32_t number = 0;
+    std::wstring text;
+    CHECK(!store.getNumber(L"Name", number));
+    CHECK(store.getString(L"Name", text) && text == L"value");
+    CHECK(!store.getString(L"Missing", text));
+}
+
+TEST_CASE(valuesSetBeforeLoadWin)
+{
+    BackendState backend;
+    backend.stored[L"FontSize"] = SettingValue::fromNumber(12);
+    SettingsStore store(memoryBackend(backend));
+
+    store.setNumber(L"FontSize", 20);
+    store.load();
+    uint32_t size = 0;
+    CHECK(store.getNumber(L"FontSize", size) && size == 20);
+}
+
+TEST_CASE(destructorFlushesChanges)
+{
+    BackendState backend;
+    {
+        SettingsStore store(memoryBackend(backend));
+        store.load();
+        store.setNumber(L"WordWrap", 1);
+        CHECK(backend.saveCount == 0);
+    }
+    CHECK(backend.saveCount == 1);
+    CHECK(backend.stored[L"WordWrap"] == SettingValue::fromNumber(1));
+}
+
+TEST_CASE(iniRoundTripKeepsSpecialCharacters)
+{
+    std::wstring path = TestSupport::temporaryWidePath("settings.ini");
+    std::remove(TestSupport::temporaryPath("settings.ini").c_str());
+
+    const std::wstring name = L"Шрифт \\ \"Consolas\"\nвторая строка";
+    {
+        SettingsStore store(iniBackend(path));
+        CHECK(store.load());
+        store.setString(L"FontName", name);
+        store.setNumber(L"FontSize", 16);
+        store.setNumber(L"BackgroundColor", 0xFFFFFFFFu);
+        CHECK(store.flush());
+    }
+
+    SettingsStore store(iniBackend(path));
+    CHECK(store.load());
+    std::wstring text;
+    uint32_t number = 0;
+    CHECK(store.getString(L"FontName", text) && text == name);
+    CHECK(store.getNumber(L"FontSize", number) && number == 16);
+    CHECK(store.getNumber(L"BackgroundColor", number) && number == 0xFFFFFFFFu);
+
+    std::remove(TestSupport::temporaryPath("settings.ini").c_str());
+}
+
+TEST_CASE(iniKeepsValuesNotInBatch)
+{
+    std::string narrowPath = TestSupport::temporaryPath("partial.ini");
+    std::wstring path = TestSupport::temporaryWidePath("partial.ini");
+    std::remove(narrowPath.c_str());
+    {
+        SettingsStore store(iniBackend(path));
+        store.load();
+        store.setNumber(L"A", 1);
+        store.setNumber(L"B", 2);
+    }
+    {
+        SettingsStore store(iniBackend(path));
+        store.load();
+        store.setNumber(L"B", 3);
+    }
+
+    SettingsStore store(iniBackend(path));
+    store.load();
+    uint32_t a = 0;
+    uint32_t b = 0;
+    CHECK(store.getNumber(L"A", a) && a == 1);
+    CHECK(store.getNumber(L"B", b) && b == 3);
+    std::remove(narrowPath.c_str());
+}
+
+TEST_CASE(missingIniFileIsEmpty)
+{
+    SettingsStore store(iniBackend(TestSupport::temporaryWidePath("missing.ini")));
+    CHECK(store.load());
+    uint32_t number = 0;
+    CHECK(!store.getNumber(L"FontSize", number));
+}
+
+int main()
+{
+    return TestHarness::runAll();
+}
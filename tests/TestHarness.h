@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+/**
+ * @brief Минимальный набор проверок для тестов переносимых модулей
+ *
+ * Тест - функция, объявленная макросом TEST_CASE. Проверка CHECK не
+ * прерывает тест, а считает ошибки; исполняемый файл возвращает 1, если
+ * не прошла хотя бы одна проверка (так результат видит ctest).
+ */
+namespace TestHarness
+{
+    struct TestCase
+    {
+        const char* name;       ///< Имя теста
+        void (*function)();     ///< Тело теста
+    };
+
+    inline std::vector<TestCase>& registry()
+    {
+        static std::vector<TestCase> tests;
+        return tests;
+    }
+
+    inline int& failureCount()
+    {
+        static int count = 0;
+        return count;
+    }
+
+    struct Registrar
+    {
+        Registrar(const char* name, void (*function)())
+        {
+            TestCase test = { name, function };
+            registry().push_back(test);
+        }
+    };
+
+    inline void reportFailure(const char* file, int line, const char* expression)
+    {
+        std::fprintf(stderr, "%s:%d: проверка не прошла: %s\n", file, line, expression);
+        ++failureCount();
+    }
+
+    /**
+     * @brief Выполнить все зарегистрированные тесты
+     * @return Код завершения процесса (0 - все проверки прошли)
+     */
+    inline int runAll()
+    {
+        for (size_t i = 0; i < registry().size(); ++i)
+        {
+            int failuresBefore = failureCount();
+            registry()[i].function();
+            std::printf("%s %s\n", failureCount() == failuresBefore ? "[ OK   ]" : "[ FAIL ]", registry()[i].name);
+        }
+        std::printf("Тестов: %u, ошибок: %d\n", (unsigned)registry().size(), failureCount());
+        return failureCount() == 0 ? 0 : 1;
+    }
+}
+
+#define TEST_CASE(name) \
+    static void name(); \
+    static TestHarness::Registrar name##Registrar(#name, name); \
+    static void name()
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            TestHarness::reportFailure(__FILE__, __LINE__, #condition); \
+        } \
+    } while (0)
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <unistd.h>
+
+/**
+ * @brief Общие вспомогательные функции тестов и бенчмарков
+ *
+ * Временные файлы создаются в $TMPDIR (или /tmp) с номером процесса в
+ * имени, поэтому тесты, запущенные параллельно (ctest -j), не мешают друг
+ * другу. Тесты собираются только под Linux.
+ */
+namespace TestSupport
+{
+    /**
+     * @brief Путь к временному файлу теста
+     * @param name Имя файла
+     */
+    inline std::string temporaryPath(const std::string& name)
+    {
+        const char* directory = std::getenv("TMPDIR");
+        std::string path = (directory && *directory) ? directory : "/tmp";
+        return path + "/editor-test-" + std::to_string((long)getpid()) + "-" + name;
+    }
+
+    /**
+     * @brief Путь к временному файлу в виде, который принимают модули редактора
+     */
+    inline std::wstring temporaryWidePath(const std::string& name)
+    {
+        std::string path = temporaryPath(name);
+        return std::wstring(path.begin(), path.end());
+    }
+
+    /**
+     * @brief Записать байты в файл целиком
+     * @return true если файл записан
+     */
+    inline bool writeFile(const std::string& path, const std::string& bytes)
+    {
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file)
+        {
+            return false;
+        }
+        bool isWritten = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+        return std::fclose(file) == 0 && isWritten;
+    }
+
+    /**
+     * @brief Прочитать файл целиком
+     */
+    inline std::string readFile(const std::string& path)
+    {
+        std::string bytes;
+        FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file)
+        {
+            return bytes;
+        }
+        char buffer[65536];
+        size_t count = 0;
+        while ((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+        {
+            bytes.append(buffer, count);
+        }
+        std::fclose(file);
+        return bytes;
+    }
+
+    /**
+     * @brief Текст из слов латиницы и кириллицы, разбитый на строки (CRLF)
+     * @param length Примерная длина в символах
+     * @param seed Начальное значение генератора
+     */
+    inline std::wstring generateText(size_t length, unsigned seed)
+    {
+        static const wchar_t* const WORDS[] = {
+            L"int", L"value", L"return", L"текст", L"строка", L"(", L")", L"{", L"}", L"if", L"файл", L"data"
+        };
+        std::mt19937 random(seed);
+        std::wstring text;
+        text.reserve(length + 16);
+        size_t lineLength = 0;
+        while (text.size() < length)
+        {
+            const wchar_t* word = WORDS[random() % (sizeof(WORDS) / sizeof(WORDS[0]))];
+            text += word;
+            lineLength += std::char_traits<wchar_t>::length(word);
+            if (lineLength > 20 + random() % 60)
+            {
+                text += L"\r\n";
+                lineLength = 0;
+            }
+            else
+            {
+                text += L' ';
+                ++lineLength;
+            }
+        }
+        return text;
+    }
+}
@@ -0,0 +1,208 @@
+#include "TestHarness.h"
+#include "TestSupport.h"
+#include "CodePageTables.h"
+#include "ChunkedText.h"
+#include "ContentHash.h"
+#include "TextEncoder.h"
+#include "Utf8Codec.h"
+
+namespace
+{
+    const uint32_t WINDOWS_1251 = 1251;
+
+    // Символ вне BMP: в 16-битном wchar_t - суррогатная пара
+    std::wstring supplementaryCharacter()
+    {
+        return sizeof(wchar_t) == 2 ? std::wstring(L"\xD83D\xDE00") : std::wstring(1, (wchar_t)0x1F600);
+    }
+
+    std::wstring randomText(std::mt19937& random, size_t length, bool isCyrillicOnly)
+    {
+        static const wchar_t* const PIECES[] = {
+            L"a", L"Z", L"7", L" ", L"ж", L"Ё", L"\r\n", L"\r\n", L"\r", L"\n", L"中", L"é", L"€"
+        };
+        size_t pieceCount = isCyrillicOnly ? 10 : 13;
+        std::wstring text;
+        while (text.size() < length)
+        {
+            size_t index = random() % (pieceCount + (isCyrillicOnly ? 0 : 1));
+            text += index < pieceCount ? std::wstring(PIECES[index]) : supplementaryCharacter();
+        }
+        return text;
+    }
+
+    // Текст из блоков разного размера: "\r\n" и суррогатные пары попадают на границы
+    void buildChunks(const std::wstring& text, std::mt19937& random, ChunkedText& chunks)
+    {
+        chunks.assign(L"", 0);
+        size_t offset = 0;
+        while (offset < text.size())
+        {
+            size_t count = std::min<size_t>(1 + random() % 9000, text.size() - offset);
+            chunks.replace(offset, 0, text.data() + offset, count);
+            offset += count;
+        }
+    }
+
+    std::wstring decode(const std::string& bytes, const DocumentFormat& format)
+    {
+        size_t bomLength = !format.hasBom ? 0 : format.codePage == DocumentFormat::CODE_PAGE_UTF8 ? 3 : 2;
+        if (format.codePage == DocumentFormat::CODE_PAGE_UTF8)
+        {
+            return Utf8Codec::decode(bytes.substr(bomLength));
+        }
+        std::wstring text;
+        if (format.codePage == WINDOWS_1251)
+        {
+            std::vector<wchar_t> table = TestSupport::singleByteTable(WINDOWS_1251);
+            for (size_t i = 0; i < bytes.size(); ++i)
+            {
+                text += table[(unsigned char)bytes[i]];
+            }
+            return text;
+        }
+        bool isBigEndian = format.codePage == DocumentFormat::CODE_PAGE_UTF16BE;
+        for (size_t i = bomLength; i + 1 < bytes.size(); i += 2)
+        {
+            unsigned first = (unsigned char)bytes[i];
+            unsigned second = (unsigned char)bytes[i + 1];
+            unsigned unit = isBigEndian ? (first << 8) | second : (second << 8) | first;
+            if (sizeof(wchar_t) > 2 && unit >= 0xDC00 && unit <= 0xDFFF && !text.empty() &&
+                (unsigned)text.back() >= 0xD800 && (unsigned)text.back() <= 0xDBFF)
+            {
+                text.back() = (wchar_t)(0x10000 + (((unsigned)text.back() - 0xD800) << 10) + (unit - 0xDC00));
+                continue;
+            }
+            text += (wchar_t)unit;
+        }
+        return text;
+    }
+
+    std::wstring convertLineEndings(const std::wstring& text, DocumentFormat::LineEnding lineEnding)
+    {
+        const wchar_t* ending = lineEnding == DocumentFormat::LINE_ENDING_LF ? L"\n"
+                              : lineEnding == DocumentFormat::LINE_ENDING_CR ? L"\r" : L"\r\n";
+        std::wstring result;
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            if (text[i] == L'\r' && i + 1 < text.size() && text[i + 1] == L'\n')
+            {
+                result += ending;
+                ++i;
+            }
+            else
+            {
+                result += text[i];
+            }
+        }
+        return result;
+    }
+
+    std::string expectedBom(const DocumentFormat& format)
+    {
+        if (!format.hasBom)
+        {
+            return std::string();
+        }
+        return format.codePage == DocumentFormat::CODE_PAGE_UTF8 ? "\xEF\xBB\xBF"
+             : format.codePage == DocumentFormat::CODE_PAGE_UTF16LE ? "\xFF\xFE" : "\xFE\xFF";
+    }
+}
+
+TEST_CASE(roundTripsAllFormats)
+{
+    static const uint32_t CODE_PAGES[] = {
+        DocumentFormat::CODE_PAGE_UTF8, DocumentFormat::CODE_PAGE_UTF16LE, DocumentFormat::CODE_PAGE_UTF16BE, WINDOWS_1251
+    };
+    std::mt19937 random(31);
+    std::vector<wchar_t> table = TestSupport::singleByteTable(WINDOWS_1251);
+    bool isCorrect = true;
+    bool hasSplitLineEnding = false;
+    for (int round = 0; round < 40; ++round)
+    {
+        for (size_t page = 0; page < 4; ++page)
+        {
+            DocumentFormat format;
+            format.codePage = CODE_PAGES[page];
+            format.hasBom = page != 3 && random() % 2 == 0;
+            format.lineEnding = (DocumentFormat::LineEnding)(random() % 3);
+
+            std::wstring text = randomText(random, 5000 + random() % 30000, page == 3);
+            ChunkedText chunks;
+            buildChunks(text, random, chunks);
+            for (size_t i = 0; i + 1 < chunks.chunkCount(); ++i)
+            {
+                const std::wstring& chunk = chunks.chunkText(i);
+                hasSplitLineEnding = hasSplitLineEnding || (chunk[chunk.size() - 1] == L'\r' && chunks.chunkText(i + 1)[0] == L'\n');
+            }
+
+            TextEncoder encoder(format, table);
+            std::string bytes;
+            encoder.encode(chunks, bytes);
+            TextEncoder::Measure measured = encoder.measure(chunks);
+            isCorrect = isCorrect && measured.size == bytes.size() && measured.unmappableCount == 0;
+            isCorrect = isCorrect && bytes.compare(0, expectedBom(format).size(), expectedBom(format)) == 0;
+            isCorrect = isCorrect && decode(bytes, format) == convertLineEndings(text, format.lineEnding);
+        }
+    }
+    CHECK(isCorrect);
+    CHECK(hasSplitLineEnding);
+}
+
+TEST_CASE(countsUnmappableCharacters)
+{
+    DocumentFormat format;
+    format.codePage = WINDOWS_1251;
+    TextEncoder encoder(format, TestSupport::singleByteTable(WINDOWS_1251));
+    std::wstring text = L"ж中a€" + supplementaryCharacter() + L"é";
+    ChunkedText chunks;
+    chunks.assign(text.data(), text.size());
+
+    std::string bytes;
+    encoder.encode(chunks, bytes);
+    CHECK(bytes == "\xE6?a\x88?" + std::string(sizeof(wchar_t) == 2 ? "??" : "?"));
+    CHECK(encoder.measure(chunks).unmappableCount == (sizeof(wchar_t) == 2 ? 4u : 3u));
+}
+
+TEST_CASE(loneSurrogateBecomesReplacementCharacter)
+{
+    DocumentFormat format;
+    TextEncoder encoder(format, std::vector<wchar_t>());
+    std::wstring text = L"a";
+    text += (wchar_t)0xD800;
+    text += L"b";
+    text += (wchar_t)0xDC00;
+    ChunkedText chunks;
+    chunks.assign(text.data(), text.size());
+    std::string bytes;
+    encoder.encode(chunks, bytes);
+    CHECK(bytes == "a\xEF\xBF\xBD" "b\xEF\xBF\xBD");
+}
+
+TEST_CASE(writesFileWithHash)
+{
+    std::mt19937 random(37);
+    std::wstring text = randomText(random, 3 * TextEncoder::WRITE_BLOCK_SIZE, false);
+    ChunkedText chunks;
+    chunks.assign(text.data(), text.size());
+    DocumentFormat format;
+    format.codePage = DocumentFormat::CODE_PAGE_UTF16BE;
+    format.hasBom = true;
+    format.lineEnding = DocumentFormat::LINE_ENDING_LF;
+    TextEncoder encoder(format, std::vector<wchar_t>());
+
+    std::string path = TestSupport::temporaryPath("encoded.txt");
+    uint64_t contentHash = 0;
+    CHECK(encoder.writeFile(std::wstring(path.begin(), path.end()), chunks, encoder.measure(chunks), contentHash));
+    std::string written = TestSupport::readFile(path);
+    std::string expected;
+    encoder.encode(chunks, expected);
+    CHECK(written == expected);
+    CHECK(contentHash == ContentHash::compute(written.data(), written.size()));
+    std::remove(path.c_str());
+}
+
+int main()
+{
+    return TestHarness::runAll();
+}
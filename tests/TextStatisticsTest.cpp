@@ -0,0 +1,113 @@
+#include "TestHarness.h"
+#include "TextStatistics.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+    // Счетчики простым просмотром текста
+    TextStatistics::Counts countText(const std::wstring& text)
+    {
+        TextStatistics::Counts counts = { 0, 0, 1, 0 };
+        bool isInWord = false;
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            wchar_t character = text[i];
+            bool isSpace = TextStatistics::isSpace(character);
+            counts.words += !isSpace && !isInWord ? 1 : 0;
+            isInWord = !isSpace;
+            if (character == L'\n')
+            {
+                ++counts.lines;
+            }
+            else if (character != L'\r' && !(character >= 0xDC00 && character <= 0xDFFF))
+            {
+                ++counts.characters;
+                counts.nonAscii += character >= 0x80 ? 1 : 0;
+            }
+        }
+        return counts;
+    }
+
+    bool equals(const TextStatistics::Counts& left, const TextStatistics::Counts& right)
+    {
+        return left.characters == right.characters && left.words == right.words &&
+               left.lines == right.lines && left.nonAscii == right.nonAscii;
+    }
+}
+
+TEST_CASE(countsSmallText)
+{
+    std::wstring text = L"Привет, мир!\r\n\tsecond  line　end\r\n";
+    TextChangeTracker tracker;
+    TextStatistics statistics;
+    tracker.addListener(&statistics);
+    tracker.reset(text.data(), text.size());
+    TextStatistics::Counts counts = statistics.totals();
+    CHECK(counts.characters == 29 && counts.words == 5 && counts.lines == 3 && counts.nonAscii == 10);
+
+    // Пустой документ - одна строка
+    tracker.applyEdit(0, text.size(), L"");
+    counts = statistics.totals();
+    CHECK(counts.characters == 0 && counts.words == 0 && counts.lines == 1 && counts.nonAscii == 0);
+}
+
+TEST_CASE(wordAcrossChunksIsCountedOnce)
+{
+    std::wstring text(3 * ChunkedText::TARGET_CHUNK_SIZE, L'a');
+    TextChangeTracker tracker;
+    TextStatistics statistics;
+    tracker.addListener(&statistics);
+    tracker.reset(text.data(), text.size());
+    CHECK(tracker.text().chunkCount() == 3);
+    CHECK(statistics.totals().words == 1);
+
+    // Пробел на стыке блоков делит слово
+    size_t boundary = tracker.text().chunkOffset(1);
+    tracker.applyEdit(boundary, 1, L" ");
+    CHECK(statistics.totals().words == 2);
+    tracker.applyEdit(boundary, 1, L"b");
+    CHECK(statistics.totals().words == 1);
+}
+
+TEST_CASE(editsMatchTextScan)
+{
+    const wchar_t alphabet[] = { L'a', L'b', L' ', L'\r', L'\n', 0x44F, 0xD83D, 0xDE00, 0x3000, L'\t', L'x' };
+    const size_t alphabetSize = sizeof(alphabet) / sizeof(alphabet[0]);
+    std::mt19937 random(7);
+    bool isCorrect = true;
+    for (int round = 0; round < 40 && isCorrect; ++round)
+    {
+        std::wstring text;
+        size_t length = random() % (round % 4 == 0 ? 100000 : 3000);
+        for (size_t i = 0; i < length; ++i)
+        {
+            text.push_back(alphabet[random() % alphabetSize]);
+        }
+        TextChangeTracker tracker;
+        TextStatistics statistics;
+        tracker.addListener(&statistics);
+        tracker.reset(text.data(), text.size());
+
+        for (int edit = 0; edit < 40 && isCorrect; ++edit)
+        {
+            size_t offset = text.empty() ? 0 : random() % (text.size() + 1);
+            size_t removeCount = std::min<size_t>(random() % (random() % 5 == 0 ? 30000 : 4), text.size() - offset);
+            std::wstring inserted;
+            size_t insertCount = random() % (random() % 5 == 0 ? 30000 : 4);
+            for (size_t i = 0; i < insertCount; ++i)
+            {
+                inserted.push_back(alphabet[random() % alphabetSize]);
+            }
+            text.replace(offset, removeCount, inserted);
+            tracker.applyEdit(offset, removeCount, inserted);
+            isCorrect = equals(statistics.totals(), countText(text));
+        }
+    }
+    CHECK(isCorrect);
+}
+
+int main()
+{
+    return TestHarness::runAll();
+}
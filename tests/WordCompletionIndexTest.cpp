@@ -0,0 +1,141 @@
+#include "TestHarness.h"
+#include "WordCompletionIndex.h"
+#include "TextChangeTracker.h"
+#include <algorithm>
+#include <map>
+#include <random>
+
+namespace
+{
+    // Частоты слов полным просмотром текста
+    std::map<std::wstring, size_t> countWords(const std::wstring& text)
+    {
+        std::map<std::wstring, size_t> counts;
+        std::wstring word;
+        for (size_t i = 0; i <= text.size(); ++i)
+        {
+            if (i < text.size() && WordCompletionIndex::isWordChar(text[i]))
+            {
+                word.push_back(text[i]);
+                continue;
+            }
+            if (word.size() >= WordCompletionIndex::MIN_WORD_LENGTH && word.size() <= WordCompletionIndex::MAX_WORD_LENGTH &&
+                !(word[0] >= L'0' && word[0] <= L'9'))
+            {
+                ++counts[word];
+            }
+            word.clear();
+        }
+        return counts;
+    }
+
+    // Самые частые продолжения совпадают с полным просмотром (по частотам:
+    // порядок равных частот не задан)
+    bool matchesCounts(const WordCompletionIndex& index, const std::map<std::wstring, size_t>& counts,
+                       const std::wstring& prefix, size_t maxCount)
+    {
+        std::vector<WordCompletionIndex::Completion> completions;
+        index.complete(prefix, maxCount, completions);
+        std::vector<size_t> expected;
+        for (std::map<std::wstring, size_t>::const_iterator it = counts.begin(); it != counts.end(); ++it)
+        {
+            if (it->first.compare(0, prefix.size(), prefix) == 0 && it->first != prefix)
+            {
+                expected.push_back(it->second);
+            }
+        }
+        std::sort(expected.rbegin(), expected.rend());
+        expected.resize(std::min(expected.size(), maxCount));
+        if (completions.size() != expected.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < completions.size(); ++i)
+        {
+            std::map<std::wstring, size_t>::const_iterator found = counts.find(completions[i].word);
+            if (completions[i].count != expected[i] || found == counts.end() || found->second != completions[i].count)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+TEST_CASE(completesByFrequency)
+{
+    std::wstring text = L"value valid value_2 2value v va value; valid(value) x Значение значение Значение";
+    TextChangeTracker tracker;
+    WordCompletionIndex index;
+    tracker.addListener(&index);
+    tracker.reset(text.data(), text.size());
+
+    std::vector<WordCompletionIndex::Completion> completions;
+    index.complete(L"va", 10, completions);
+    CHECK(completions.size() == 3);
+    CHECK(completions[0].word == L"value" && completions[0].count == 3);
+    CHECK(completions[1].word == L"valid" && completions[1].count == 2);
+    CHECK(completions[2].word == L"value_2");
+
+    // Слово, совпадающее с префиксом, не предлагается; короткие и с цифры не индексируются
+    index.complete(L"value", 10, completions);
+    CHECK(completions.size() == 1 && completions[0].word == L"value_2");
+    index.complete(L"2", 10, completions);
+    CHECK(completions.empty());
+    index.complete(L"Зн", 1, completions);
+    CHECK(completions.size() == 1 && completions[0].word == L"Значение" && completions[0].count == 2);
+    CHECK(index.wordCount() == 6);
+}
+
+TEST_CASE(editsUpdateOnlyTouchedWords)
+{
+    const wchar_t alphabet[] = L"ab_1 \r\nабcd";
+    const size_t alphabetSize = sizeof(alphabet) / sizeof(alphabet[0]) - 1;
+    const wchar_t* prefixes[] = { L"a", L"b", L"ab", L"аб", L"_", L"c" };
+    std::mt19937 random(7);
+    bool isCorrect = true;
+    for (int round = 0; round < 100 && isCorrect; ++round)
+    {
+        std::wstring text;
+        for (int i = 0; i < 3000; ++i)
+        {
+            text.push_back(alphabet[random() % alphabetSize]);
+        }
+        TextChangeTracker tracker;
+        WordCompletionIndex index;
+        tracker.addListener(&index);
+        tracker.reset(text.data(), text.size());
+
+        // Правки разрывают и склеивают слова, иногда вставляют слишком длинные
+        for (int edit = 0; edit < 40; ++edit)
+        {
+            size_t length = tracker.text().length();
+            size_t offset = length > 0 ? random() % length : 0;
+            size_t removeCount = std::min<size_t>(random() % (random() % 4 == 0 ? 200 : 5), length - offset);
+            std::wstring inserted;
+            size_t insertCount = random() % (random() % 4 == 0 ? 300 : 4);
+            for (size_t i = 0; i < insertCount; ++i)
+            {
+                inserted.push_back(alphabet[random() % alphabetSize]);
+            }
+            if (random() % 10 == 0)
+            {
+                inserted.assign(WordCompletionIndex::MAX_WORD_LENGTH + 6 + random() % 10, L'a');
+            }
+            tracker.applyEdit(offset, removeCount, inserted);
+        }
+
+        std::map<std::wstring, size_t> counts = countWords(tracker.text().toString());
+        isCorrect = counts.size() == index.wordCount();
+        for (size_t i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]) && isCorrect; ++i)
+        {
+            isCorrect = matchesCounts(index, counts, prefixes[i], 10);
+        }
+    }
+    CHECK(isCorrect);
+}
+
+int main()
+{
+    return TestHarness::runAll();
+}
@@ -0,0 +1,183 @@
+#include "TestHarness.h"
+#include "WrapLayout.h"
+#include <random>
+
+namespace
+{
+    // Моноширинный шрифт: 8 единиц, иероглифы - 16, табуляция - 32
+    class MockWidths : public GlyphWidthProvider
+    {
+    public:
+        int width(wchar_t symbol) const override
+        {
+            return symbol >= 0x3000 ? 16 : (symbol == L'\t' ? 32 : 8);
+        }
+    };
+
+    // Разметка строки простым жадным переносом (для сравнения)
+    std::vector<size_t> referenceBreaks(const std::wstring& text, int width, const GlyphWidthProvider& widths)
+    {
+        std::vector<size_t> breaks;
+        long rowWidth = 0;
+        long wordWidth = 0;
+        size_t rowBegin = 0;
+        size_t wordBegin = 0;
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            int symbolWidth = widths.width(text[i]);
+            if (text[i] == L' ' || text[i] == L'\t')
+            {
+                rowWidth += symbolWidth;
+                wordBegin = i + 1;
+                wordWidth = 0;
+                continue;
+            }
+            if (width > 0 && rowWidth + symbolWidth > width && i > rowBegin)
+            {
+                if (wordBegin > rowBegin)
+                {
+                    rowBegin = wordBegin;
+                    rowWidth = wordWidth;
+                }
+                else
+                {
+                    rowBegin = i;
+                    rowWidth = 0;
+                    wordWidth = 0;
+                }
+                breaks.push_back(rowBegin);
+            }
+            rowWidth += symbolWidth;
+            wordWidth += symbolWidth;
+        }
+        return breaks;
+    }
+
+    std::wstring randomLine(std::mt19937& random, size_t maxLength)
+    {
+        size_t length = random() % (maxLength + 1);
+        std::wstring line;
+        for (size_t i = 0; i < length; ++i)
+        {
+            unsigned kind = random() % 10;
+            line += kind == 0 ? L' ' : (kind == 1 && random() % 20 == 0) ? (wchar_t)0x4E2D : (wchar_t)(L'a' + random() % 26);
+        }
+        return line;
+    }
+
+    bool matchesReference(const WrapLayout& layout, const std::vector<std::wstring>& lines, const GlyphWidthProvider& widths)
+    {
+        uint64_t visualLine = 0;
+        for (size_t i = 0; i < lines.size(); ++i)
+        {
+            std::vector<size_t> breaks = referenceBreaks(lines[i], layout.width(), widths);
+            if (layout.rowCount(i) != breaks.size() + 1 || layout.visualLineOf(i) != visualLine)
+            {
+                return false;
+            }
+            for (size_t row = 0; row < layout.rowCount(i); ++row)
+            {
+                size_t foundRow = 0;
+                if ((row > 0 && layout.rowStart(i, row) != breaks[row - 1]) ||
+                    layout.lineOfVisual(visualLine + row, foundRow) != i || foundRow != row ||
+                    layout.rowOfColumn(i, layout.rowStart(i, row)) != row)
+                {
+                    return false;
+                }
+            }
+            visualLine += breaks.size() + 1;
+        }
+        return visualLine == layout.visualLineCount();
+    }
+}
+
+TEST_CASE(wrapsAtSpacesAndLongWords)
+{
+    MockWidths widths;
+    std::vector<std::wstring> lines = { L"один два три", L"", L"оченьдлинноеслово" };
+    WrapLayout layout(widths);
+    WrapLayout::LineSource source = [&](size_t line, std::wstring& text) { text = lines[line]; };
+    layout.reset(lines.size(), source, 64);
+
+    // "один " + "два " + "три" по 8 единиц на символ в ширину 64
+    CHECK(layout.rowCount(0) == 2);
+    CHECK(layout.rowStart(0, 1) == 9);
+    CHECK(layout.rowCount(1) == 1);
+    CHECK(layout.rowCount(2) == 3 && layout.rowStart(2, 1) == 8 && layout.rowStart(2, 2) == 16);
+    CHECK(layout.visualLineCount() == 6);
+    CHECK(layout.visualLineOf(2) == 3);
+    size_t row = 0;
+    CHECK(layout.lineOfVisual(4, row) == 2 && row == 1);
+    CHECK(layout.rowOfColumn(0, 10) == 1);
+
+    // Нулевая ширина - перенос выключен
+    layout.setWidth(0, source);
+    CHECK(layout.visualLineCount() == 3);
+}
+
+TEST_CASE(randomEditsMatchFullLayout)
+{
+    MockWidths widths;
+    std::mt19937 random(7);
+    bool isCorrect = true;
+    for (int round = 0; round < 100 && isCorrect; ++round)
+    {
+        std::vector<std::wstring> lines(random() % 200);
+        for (size_t i = 0; i < lines.size(); ++i)
+        {
+            lines[i] = randomLine(random, 300);
+        }
+        WrapLayout layout(widths);
+        WrapLayout::LineSource source = [&](size_t line, std::wstring& text) { text = lines[line]; };
+        layout.reset(lines.size(), source, 100 + random() % 900);
+        for (int step = 0; step < 40 && isCorrect; ++step)
+        {
+            if (random() % 3 == 0)
+            {
+                layout.setWidth(random() % 8 == 0 ? 0 : 40 + random() % 1200, source);
+            }
+            else
+            {
+                size_t first = random() % (lines.size() + 1);
+                size_t removed = std::min<size_t>(random() % 4, lines.size() - first);
+                size_t inserted = random() % 4;
+                lines.erase(lines.begin() + first, lines.begin() + first + removed);
+                for (size_t i = 0; i < inserted; ++i)
+                {
+                    lines.insert(lines.begin() + first, randomLine(random, 300));
+                }
+                layout.replaceLines(first, removed, inserted, source);
+            }
+            isCorrect = layout.lineCount() == lines.size() && matchesReference(layout, lines, widths);
+        }
+    }
+    CHECK(isCorrect);
+}
+
+TEST_CASE(resizeReflowsOnlyWideLines)
+{
+    MockWidths widths;
+    std::vector<std::wstring> lines(1000, L"короткая строка");
+    lines[10] = std::wstring(200, L'x');
+    lines[500] = std::wstring(100, L'y');
+    WrapLayout layout(widths);
+    size_t requested = 0;
+    WrapLayout::LineSource source = [&](size_t line, std::wstring& text)
+    {
+        ++requested;
+        text = lines[line];
+    };
+    layout.reset(lines.size(), source, 1000);
+    requested = 0;
+
+    // Строки уже 500 единиц занимают одну экранную строку при обеих ширинах
+    CHECK(layout.setWidth(500, source) == 2);
+    CHECK(requested == 2);
+    CHECK(layout.rowCount(10) == 4 && layout.rowCount(500) == 2);
+    CHECK(layout.visualLineCount() == 1004);
+}
+
+int main()
+{
+    return TestHarness::runAll();
+}
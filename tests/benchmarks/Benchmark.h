@@ -0,0 +1,110 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+/**
+ * @brief Вспомогательные средства бенчмарков: время, память, параметры
+ *
+ * Размеры данных задаются аргументами командной строки; значения по
+ * умолчанию соответствуют размерам из постановки задачи. Память берется
+ * из /proc/self/status (VmRSS - текущая, VmHWM - пиковая), поэтому
+ * бенчмарки работают только под Linux.
+ */
+namespace Benchmark
+{
+    /**
+     * @brief Секундомер на монотонных часах
+     */
+    class Stopwatch
+    {
+    public:
+        Stopwatch() : m_start(std::chrono::steady_clock::now()) {}
+
+        void restart()
+        {
+            m_start = std::chrono::steady_clock::now();
+        }
+
+        double elapsedMilliseconds() const
+        {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    /**
+     * @brief Значение поля /proc/self/status в килобайтах
+     */
+    inline size_t readStatusKilobytes(const char* field)
+    {
+        FILE* file = std::fopen("/proc/self/status", "r");
+        if (!file)
+        {
+            return 0;
+        }
+        size_t value = 0;
+        char line[256];
+        size_t fieldLength = std::strlen(field);
+        while (std::fgets(line, sizeof(line), file))
+        {
+            if (std::strncmp(line, field, fieldLength) == 0 && line[fieldLength] == ':')
+            {
+                value = (size_t)std::strtoull(line + fieldLength + 1, nullptr, 10);
+                break;
+            }
+        }
+        std::fclose(file);
+        return value;
+    }
+
+    /**
+     * @brief Текущий объем резидентной памяти процесса, МБ
+     */
+    inline double residentMegabytes()
+    {
+        return readStatusKilobytes("VmRSS") / 1024.0;
+    }
+
+    /**
+     * @brief Пиковый объем резидентной памяти процесса, МБ
+     */
+    inline double peakResidentMegabytes()
+    {
+        return readStatusKilobytes("VmHWM") / 1024.0;
+    }
+
+    /**
+     * @brief Числовой аргумент командной строки
+     * @param index Номер аргумента (с 1)
+     * @param defaultValue Значение, если аргумент не задан
+     */
+    inline size_t argument(int argc, char** argv, int index, size_t defaultValue)
+    {
+        return index < argc ? (size_t)std::strtoull(argv[index], nullptr, 10) : defaultValue;
+    }
+
+    /**
+     * @brief Напечатать строку результата (значение впереди: имена в UTF-8
+     * не выравниваются по ширине)
+     */
+    inline void report(const std::string& name, double value, const char* unit)
+    {
+        std::printf("%14.3f %-3s %s\n", value, unit, name.c_str());
+        std::fflush(stdout);
+    }
+
+    /**
+     * @brief Не дать компилятору выбросить вычисление, результат которого не используется
+     */
+    template <typename T>
+    inline void keep(const T& value)
+    {
+        __asm__ __volatile__("" : : "r"(&value) : "memory");
+    }
+}
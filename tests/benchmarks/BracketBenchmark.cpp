@@ -0,0 +1,143 @@
+// Поиск парной скобки в большом файле кода: поиск и обновление индекса
+//
+// Файл - одно пространство имен с функциями, пара внешней скобки лежит в
+// конце файла. Поиск через BracketIndex сравнивается с просмотром
+// текста от скобки, как без индекса. Обновление - ввод обычных символов
+// и скобок в середину файла; измеряется правка текста вместе с индексом
+// и без него.
+//
+// Аргументы: количество строк (100000)
+
+#include "benchmarks/Benchmark.h"
+#include "BracketIndex.h"
+#include "TextChangeTracker.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+    std::wstring generateCode(size_t lineCount)
+    {
+        std::wstring text = L"namespace editor {\r\n";
+        for (size_t line = 1; line + 1 < lineCount; line += 5)
+        {
+            std::wstring name = std::to_wstring(line);
+            text += L"int function" + name + L"(int value[4]) {\r\n";
+            text += L"    if (value[0] > " + name + L") {\r\n";
+            text += L"        return call(value[1], {" + name + L"});\r\n";
+            text += L"    }\r\n";
+            text += L"}\r\n";
+        }
+        return text + L"}\r\n";
+    }
+
+    // Пара скобки просмотром текста, без индекса
+    size_t scanMatch(const ChunkedText& text, size_t offset)
+    {
+        wchar_t bracket = text.charAt(offset);
+        bool isForward = bracket == L'(' || bracket == L'[' || bracket == L'{';
+        size_t depth = 1;
+        for (size_t i = offset; isForward ? i + 1 < text.length() : i > 0;)
+        {
+            i = isForward ? i + 1 : i - 1;
+            wchar_t character = text.charAt(i);
+            if (BracketIndex::isBracket(character))
+            {
+                bool isOpening = character == L'(' || character == L'[' || character == L'{';
+                depth = isOpening == isForward ? depth + 1 : depth - 1;
+                if (depth == 0)
+                {
+                    return i;
+                }
+            }
+        }
+        return text.length();
+    }
+
+    double median(std::vector<double> times)
+    {
+        std::sort(times.begin(), times.end());
+        return times[times.size() / 2];
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t lineCount = Benchmark::argument(argc, argv, 1, 100000);
+    std::wstring code = generateCode(lineCount);
+    std::vector<size_t> brackets;
+    for (size_t i = 0; i < code.size(); ++i)
+    {
+        if (BracketIndex::isBracket(code[i]))
+        {
+            brackets.push_back(i);
+        }
+    }
+
+    TextChangeTracker tracker;
+    BracketIndex index;
+    tracker.addListener(&index);
+    Benchmark::Stopwatch stopwatch;
+    tracker.reset(code.data(), code.size());
+    std::printf("Строк: %u, символов: %u, скобок: %u\n", (unsigned)lineCount, (unsigned)code.size(), (unsigned)brackets.size());
+    Benchmark::report("Загрузка текста с построением индекса", stopwatch.elapsedMilliseconds(), "мс");
+
+    // Внешняя скобка: пара в другом конце файла
+    bool isCorrect = true;
+    size_t outer = code.find(L'{');
+    size_t match = 0;
+    stopwatch.restart();
+    isCorrect = index.findMatch(tracker.text(), outer, match) && match == code.rfind(L'}');
+    Benchmark::report("Внешняя скобка: индекс", stopwatch.elapsedMilliseconds() * 1000.0, "мкс");
+    stopwatch.restart();
+    isCorrect = isCorrect && scanMatch(tracker.text(), outer) == match;
+    Benchmark::report("Внешняя скобка: просмотр текста", stopwatch.elapsedMilliseconds(), "мс");
+
+    // Случайные скобки
+    std::mt19937 random(46);
+    std::vector<double> times;
+    for (int i = 0; i < 20000; ++i)
+    {
+        size_t offset = brackets[random() % brackets.size()];
+        stopwatch.restart();
+        bool isFound = index.findMatch(tracker.text(), offset, match);
+        times.push_back(stopwatch.elapsedMilliseconds() * 1000.0);
+        isCorrect = isCorrect && isFound && match == scanMatch(tracker.text(), offset);
+    }
+    Benchmark::report("Случайная скобка: медиана", median(times), "мкс");
+    Benchmark::report("Случайная скобка: максимум", *std::max_element(times.begin(), times.end()), "мкс");
+
+    // Ввод в середину файла: буквы и скобки
+    TextChangeTracker plain;
+    plain.reset(code.data(), code.size());
+    const std::wstring typed = L"call(x[1]) + {y} ";
+    size_t position = code.size() / 2;
+    std::vector<double> indexedTimes;
+    std::vector<double> plainTimes;
+    for (int repeat = 0; repeat < 200; ++repeat)
+    {
+        for (size_t i = 0; i < typed.size(); ++i, ++position)
+        {
+            std::wstring character(1, typed[i]);
+            stopwatch.restart();
+            tracker.applyEdit(position, 0, character);
+            indexedTimes.push_back(stopwatch.elapsedMilliseconds() * 1000.0);
+            stopwatch.restart();
+            plain.applyEdit(position, 0, character);
+            plainTimes.push_back(stopwatch.elapsedMilliseconds() * 1000.0);
+        }
+    }
+    Benchmark::report("Нажатие с индексом: медиана", median(indexedTimes), "мкс");
+    Benchmark::report("Нажатие без индекса: медиана", median(plainTimes), "мкс");
+    Benchmark::report("Нажатие с индексом: максимум", *std::max_element(indexedTimes.begin(), indexedTimes.end()), "мкс");
+
+    stopwatch.restart();
+    isCorrect = isCorrect && index.findMatch(tracker.text(), outer, match) && match == tracker.text().length() - 3;
+    Benchmark::report("Внешняя скобка после ввода", stopwatch.elapsedMilliseconds() * 1000.0, "мкс");
+    if (!isCorrect)
+    {
+        std::printf("ОШИБКА: найденная пара не совпадает с просмотром текста\n");
+        return 1;
+    }
+    return 0;
+}
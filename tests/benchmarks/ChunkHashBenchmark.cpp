@@ -0,0 +1,92 @@
+// Стоимость поддержки хеша документа при вводе
+//
+// Нажатия клавиш (ввод и удаление символа в случайных местах) применяются
+// к теневой копии без подписчиков и с ChunkHashTree; разница - цена
+// поддержки хеша на одно нажатие. Каждый введенный символ стирается
+// следующим нажатием, поэтому при четном числе нажатий документ должен
+// остаться неизмененным. Отдельно замеряются проверка isModified() и,
+// для сравнения, хеш всего текста заново.
+//
+// Аргументы: размер текста в МБ UTF-16 (500), число нажатий (100000)
+
+#include "benchmarks/Benchmark.h"
+#include "TestSupport.h"
+#include "ChunkHashTree.h"
+#include <random>
+
+namespace
+{
+    double typeKeys(TextChangeTracker& tracker, size_t keyCount)
+    {
+        std::mt19937 random(8);
+        size_t offset = 0;
+        Benchmark::Stopwatch stopwatch;
+        for (size_t i = 0; i < keyCount; ++i)
+        {
+            // Введенный символ стирается следующим нажатием
+            if (i % 2 == 0)
+            {
+                offset = random() % tracker.text().length();
+                tracker.applyEdit(offset, 0, L"ж", 1);
+            }
+            else
+            {
+                tracker.applyEdit(offset, 1, L"", 0);
+            }
+        }
+        return stopwatch.elapsedMilliseconds() * 1000.0 / keyCount;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t megabytes = Benchmark::argument(argc, argv, 1, 500);
+    size_t keyCount = Benchmark::argument(argc, argv, 2, 100000);
+
+    TextChangeTracker plain;
+    TextChangeTracker hashed;
+    ChunkHashTree tree;
+    hashed.addListener(&tree);
+    {
+        std::wstring text = TestSupport::generateText(megabytes * 1024 * 1024 / 2, 6);
+        plain.reset(text.data(), text.size());
+        Benchmark::Stopwatch stopwatch;
+        hashed.reset(text.data(), text.size());
+        Benchmark::report("Загрузка текста с построением дерева", stopwatch.elapsedMilliseconds(), "мс");
+    }
+    std::printf("Текст: %.1f МБ, нажатий: %u\n", plain.text().length() * 2 / 1048576.0, (unsigned)keyCount);
+    tree.markSaved();
+
+    double plainTime = typeKeys(plain, keyCount);
+    double hashedTime = typeKeys(hashed, keyCount);
+    Benchmark::report("Нажатие без хеша", plainTime, "мкс");
+    Benchmark::report("Нажатие с ChunkHashTree", hashedTime, "мкс");
+    Benchmark::report("Цена хеша на нажатие", hashedTime - plainTime, "мкс");
+
+    Benchmark::Stopwatch stopwatch;
+    bool isModified = false;
+    for (int i = 0; i < 1000; ++i)
+    {
+        isModified = tree.isModified() || isModified;
+    }
+    Benchmark::report("Проверка isModified", stopwatch.elapsedMilliseconds(), "мкс");   // 1000 вызовов
+
+    std::wstring text = hashed.text().toString();
+    stopwatch.restart();
+    ChunkHashTree::Digest full = ChunkHashTree::computeDigest(text.data(), text.size());
+    Benchmark::report("Хеш всего текста заново (для сравнения)", stopwatch.elapsedMilliseconds(), "мс");
+
+    ChunkHashTree::Digest incremental = tree.digest();
+    bool isCorrect = full.hash == incremental.hash && full.length == incremental.length;
+    if (!isCorrect)
+    {
+        std::printf("ОШИБКА: хеш дерева не совпадает с хешем текста\n");
+        return 1;
+    }
+    if (keyCount % 2 == 0 && isModified)
+    {
+        std::printf("ОШИБКА: текст после ввода и удаления считается измененным\n");
+        return 1;
+    }
+    return 0;
+}
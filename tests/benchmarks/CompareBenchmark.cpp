@@ -0,0 +1,118 @@
+// Сравнение больших сгенерированных текстов: Майерс и гистограмма
+//
+// Пары текстов по миллиону строк с разбросанными правками: в первой паре
+// строки почти все разные, во второй много повторяющихся (пустые строки,
+// скобки), как в исходных текстах. Для каждой пары замеряются оба
+// алгоритма, число фрагментов и измененных строк, а также время от
+// запроса отмены до возврата из сравнения.
+//
+// Аргументы: число строк (1000000), число правок (2000)
+
+#include "benchmarks/Benchmark.h"
+#include "LineDiff.h"
+#include <random>
+
+namespace
+{
+    std::wstring generateLines(size_t lineCount, bool isRepetitive, std::mt19937& random)
+    {
+        static const wchar_t* const REPEATED[] = { L"\r\n", L"{\r\n", L"}\r\n", L"    return;\r\n", L"    break;\r\n" };
+        std::wstring text;
+        for (size_t i = 0; i < lineCount; ++i)
+        {
+            if (isRepetitive && random() % 2 == 0)
+            {
+                text += REPEATED[random() % 5];
+            }
+            else
+            {
+                text += L"    значение_" + std::to_wstring(random() % (lineCount * 4)) + L" = вызов(" + std::to_wstring(i) + L");\r\n";
+            }
+        }
+        return text;
+    }
+
+    std::wstring applyRandomEdits(std::wstring text, size_t editCount, std::mt19937& random)
+    {
+        for (size_t i = 0; i < editCount; ++i)
+        {
+            size_t start = text.find(L'\n', random() % text.size());
+            if (start == std::wstring::npos)
+            {
+                continue;
+            }
+            ++start;
+            size_t end = text.find(L'\n', start);
+            end = end == std::wstring::npos ? text.size() : end + 1;
+            if (i % 2 == 0)
+            {
+                text.replace(start, end - start, L"    правка(" + std::to_wstring(i) + L");\r\n");
+            }
+            else
+            {
+                text.erase(start, end - start);
+            }
+        }
+        return text;
+    }
+
+    void measure(const std::string& name, const std::wstring& oldText, const std::wstring& newText, LineDiff::Algorithm algorithm)
+    {
+        std::vector<LineDiff::Hunk> hunks;
+        size_t progressCount = 0;
+        LineDiff::Progress progress = [&](size_t, size_t)
+        {
+            ++progressCount;
+            return true;
+        };
+        Benchmark::Stopwatch stopwatch;
+        LineDiff::compute(oldText.data(), oldText.size(), newText.data(), newText.size(), hunks, algorithm, progress);
+        double time = stopwatch.elapsedMilliseconds();
+
+        size_t changedLines = 0;
+        for (size_t i = 0; i < hunks.size(); ++i)
+        {
+            changedLines += hunks[i].oldLineCount + hunks[i].newLineCount;
+        }
+        Benchmark::report(name + ": время", time, "мс");
+        Benchmark::report(name + ": фрагментов", (double)hunks.size(), "");
+        Benchmark::report(name + ": измененных строк", (double)changedLines, "");
+        Benchmark::report(name + ": отчетов о ходе работы", (double)progressCount, "");
+
+        // Отмена через половину времени полного сравнения
+        Benchmark::Stopwatch cancelStopwatch;
+        double cancelTime = 0;
+        LineDiff::Progress cancel = [&](size_t, size_t)
+        {
+            if (cancelTime == 0 && cancelStopwatch.elapsedMilliseconds() >= time / 2)
+            {
+                cancelTime = cancelStopwatch.elapsedMilliseconds();
+            }
+            return cancelTime == 0;
+        };
+        bool isCompleted = LineDiff::compute(oldText.data(), oldText.size(), newText.data(), newText.size(), hunks, algorithm, cancel);
+        if (!isCompleted)
+        {
+            Benchmark::report(name + ": возврат после отмены", cancelStopwatch.elapsedMilliseconds() - cancelTime, "мс");
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t lineCount = Benchmark::argument(argc, argv, 1, 1000000);
+    size_t editCount = Benchmark::argument(argc, argv, 2, 2000);
+    std::mt19937 random(21);
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        bool isRepetitive = pass == 1;
+        std::wstring oldText = generateLines(lineCount, isRepetitive, random);
+        std::wstring newText = applyRandomEdits(oldText, editCount, random);
+        std::printf("%s: %u строк, %u правок\n", isRepetitive ? "Повторяющиеся строки" : "Разные строки",
+                    (unsigned)lineCount, (unsigned)editCount);
+        measure("Майерс", oldText, newText, LineDiff::ALGORITHM_MYERS);
+        measure("Гистограмма", oldText, newText, LineDiff::ALGORITHM_HISTOGRAM);
+    }
+    return 0;
+}
@@ -0,0 +1,81 @@
+// Задержка нажатия клавиши с журналом правок и без него
+//
+// Аргументы: размер документа в МБ (100), число нажатий (200000)
+
+#include "benchmarks/Benchmark.h"
+#include "TestSupport.h"
+#include "EditJournal.h"
+#include "PortableFile.h"
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    // Ввод символов в середину документа; возвращает времена нажатий в мкс
+    std::vector<double> typeKeys(TextChangeTracker& tracker, EditJournal* journal, size_t keyCount)
+    {
+        std::vector<double> times;
+        times.reserve(keyCount);
+        size_t caret = tracker.text().length() / 2;
+        for (size_t i = 0; i < keyCount; ++i)
+        {
+            Benchmark::Stopwatch stopwatch;
+            wchar_t key = (i % 40 == 39) ? L'\n' : (wchar_t)(L'a' + i % 26);
+            tracker.applyEdit(caret, 0, &key, 1);
+            if (journal)
+            {
+                journal->compactIfNeeded(tracker.text());
+            }
+            times.push_back(stopwatch.elapsedMilliseconds() * 1000.0);
+            ++caret;
+        }
+        return times;
+    }
+
+    void reportTimes(const std::string& name, std::vector<double> times)
+    {
+        std::sort(times.begin(), times.end());
+        double total = 0;
+        for (size_t i = 0; i < times.size(); ++i)
+        {
+            total += times[i];
+        }
+        Benchmark::report(name + ": среднее", total / times.size(), "мкс");
+        Benchmark::report(name + ": 99-й процентиль", times[times.size() * 99 / 100], "мкс");
+        Benchmark::report(name + ": максимум", times.back(), "мкс");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t megabytes = Benchmark::argument(argc, argv, 1, 100);
+    size_t keyCount = Benchmark::argument(argc, argv, 2, 200000);
+    std::wstring text = TestSupport::generateText(megabytes * 1024 * 1024 / sizeof(wchar_t), 1);
+    std::printf("Документ: %u МБ, нажатий: %u\n", (unsigned)megabytes, (unsigned)keyCount);
+
+    {
+        TextChangeTracker tracker;
+        tracker.reset(text.data(), text.size());
+        reportTimes("Без журнала", typeKeys(tracker, nullptr, keyCount));
+    }
+
+    std::wstring journalPath = TestSupport::temporaryWidePath("benchmark.journal");
+    {
+        EditJournal journal(journalPath);
+        TextChangeTracker tracker;
+        tracker.addListener(&journal);
+        journal.start();
+        Benchmark::Stopwatch stopwatch;
+        tracker.reset(text.data(), text.size());
+        journal.flush();
+        Benchmark::report("Начальный снимок в журнал", stopwatch.elapsedMilliseconds(), "мс");
+
+        reportTimes("С журналом", typeKeys(tracker, &journal, keyCount));
+        stopwatch.restart();
+        journal.flush();
+        Benchmark::report("Запись оставшейся очереди", stopwatch.elapsedMilliseconds(), "мс");
+        journal.stop(true);
+    }
+    PortableFile::remove(journalPath);
+    return 0;
+}
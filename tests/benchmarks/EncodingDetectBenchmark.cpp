@@ -0,0 +1,76 @@
+// Определение кодировки большого файла по выборке блоков
+//
+// Файлы в Windows-1251 и UTF-16LE без BOM растущего размера. detectFile
+// читает только блоки выборки; для сравнения замеряется чтение файла
+// целиком с определением по всем данным в памяти.
+//
+// Аргументы: наибольший размер файла в МБ (1000)
+
+#include "benchmarks/Benchmark.h"
+#include "TestSupport.h"
+#include "CodePageTables.h"
+#include "EncodingDetector.h"
+
+namespace
+{
+    bool measure(const std::string& name, const std::string& block, size_t megabytes, uint32_t expectedCodePage)
+    {
+        std::string path = TestSupport::temporaryPath("detect.txt");
+        FILE* file = std::fopen(path.c_str(), "wb");
+        for (size_t written = 0; written < megabytes * 1024 * 1024; written += block.size())
+        {
+            std::fwrite(block.data(), 1, block.size(), file);
+        }
+        std::fclose(file);
+        std::wstring widePath(path.begin(), path.end());
+
+        Benchmark::Stopwatch stopwatch;
+        EncodingDetector::Result sampled;
+        EncodingDetector::detectFile(widePath, sampled);
+        double sampledTime = stopwatch.elapsedMilliseconds();
+
+        stopwatch.restart();
+        std::string bytes = TestSupport::readFile(path);
+        EncodingDetector::Result whole = EncodingDetector::detect(bytes.data(), bytes.size());
+        double wholeTime = stopwatch.elapsedMilliseconds();
+
+        std::string prefix = name + ", " + std::to_string(megabytes) + " МБ: ";
+        Benchmark::report(prefix + "по выборке", sampledTime, "мс");
+        Benchmark::report(prefix + "прочитано", sampled.sampledBytes / 1024.0, "КБ");
+        Benchmark::report(prefix + "чтение файла целиком и определение", wholeTime, "мс");
+        std::remove(path.c_str());
+        return sampled.codePage == expectedCodePage && whole.codePage == expectedCodePage;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t maxMegabytes = Benchmark::argument(argc, argv, 1, 1000);
+
+    std::wstring text;
+    while (text.size() < 1024 * 1024)
+    {
+        text += L"Поезд опоздал на два часа, поэтому встреча перенесена на завтра.\r\n"
+                L"Configuration files are stored next to the application binary.\r\n";
+    }
+    std::string windows1251 = TestSupport::encodeSingleByte(text, TestSupport::singleByteTable(1251));
+    std::string utf16;
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        utf16 += (char)(text[i] & 0xFF);
+        utf16 += (char)(text[i] >> 8);
+    }
+
+    bool isCorrect = true;
+    for (size_t megabytes = 10; megabytes <= maxMegabytes; megabytes *= 10)
+    {
+        isCorrect = measure("Windows-1251", windows1251, megabytes, EncodingDetector::CODE_PAGE_WINDOWS_1251) && isCorrect;
+        isCorrect = measure("UTF-16LE без BOM", utf16, megabytes, EncodingDetector::CODE_PAGE_UTF16LE) && isCorrect;
+    }
+    if (!isCorrect)
+    {
+        std::printf("ОШИБКА: кодировка определена неверно\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,160 @@
+// Слежение за концом растущего журнала: отставание и загрузка процессора
+//
+// Отдельный процесс дописывает строки UTF-8 с заданной скоростью, разрывая
+// запись внутри многобайтовых символов. Читатель ждет уведомлений
+// FileWatcher и дочитывает файл через FileTail, как режим "следить за
+// концом" в редакторе. Время процессора считается только для читателя,
+// вместе с посимвольной проверкой прочитанного текста.
+//
+// Аргументы: скорость записи в МБ/с (50), длительность в секундах (5)
+
+#include "benchmarks/Benchmark.h"
+#include "TestSupport.h"
+#include "FileTail.h"
+#include "FileWatcher.h"
+#include "PortableFile.h"
+#include "Utf8Codec.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+    const char LOG_LINE[] = "2024-01-01 12:00:00 [инфо] запрос обработан \xF0\x9F\x98\x80 код=200 время=15мс\n";
+
+    double elapsedSeconds(const std::chrono::steady_clock::time_point& start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double cpuSeconds()
+    {
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    }
+
+    void runWriter(const std::string& path, size_t bytesPerSecond, size_t seconds)
+    {
+        FILE* file = std::fopen(path.c_str(), "ab");
+        std::setvbuf(file, nullptr, _IONBF, 0);
+        std::string chunk;
+        while (chunk.size() < 64 * 1024)
+        {
+            chunk += LOG_LINE;
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        double total = 0;
+        while (elapsedSeconds(start) < seconds)
+        {
+            size_t cut = chunk.size() / 2 + 1;
+            std::fwrite(chunk.data(), 1, cut, file);
+            std::fwrite(chunk.data() + cut, 1, chunk.size() - cut, file);
+            total += chunk.size();
+            double delay = total / bytesPerSecond - elapsedSeconds(start);
+            if (delay > 0)
+            {
+                std::this_thread::sleep_for(std::chrono::duration<double>(delay));
+            }
+        }
+        std::fclose(file);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t megabytesPerSecond = Benchmark::argument(argc, argv, 1, 50);
+    size_t seconds = Benchmark::argument(argc, argv, 2, 5);
+    std::string path = TestSupport::temporaryPath("follow.log");
+    std::wstring widePath(path.begin(), path.end());
+    TestSupport::writeFile(path, "");
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool isChanged = false;
+    FileWatcher watcher;
+    if (!watcher.start(widePath, [&]()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isChanged = true;
+        changed.notify_one();
+    }))
+    {
+        std::printf("Не удалось начать наблюдение\n");
+        return 1;
+    }
+    FileTail tail;
+    tail.start(widePath, 0, LargeFileDocument::ENCODING_UTF8, std::vector<wchar_t>());
+
+    pid_t writer = fork();
+    if (writer == 0)
+    {
+        runWriter(path, megabytesPerSecond * 1024 * 1024, seconds);
+        _exit(0);
+    }
+
+    std::wstring expectedLine = Utf8Codec::decode(LOG_LINE);
+    size_t linePosition = 0;
+    size_t mismatchCount = 0;
+    std::vector<double> lags;
+    double cpuStart = cpuSeconds();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool isWriterDone = false;
+    std::wstring text;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait_for(lock, std::chrono::milliseconds(100), [&]() { return isChanged; });
+            isChanged = false;
+        }
+        do
+        {
+            text.clear();
+            if (tail.read(text) != FileTail::TAIL_APPENDED)
+            {
+                break;
+            }
+            for (size_t i = 0; i < text.size(); ++i)
+            {
+                mismatchCount += text[i] != expectedLine[linePosition];
+                linePosition = (linePosition + 1) % expectedLine.size();
+            }
+        }
+        while (tail.hasMoreData());
+
+        // Отставание - дописанные, но еще не показанные байты
+        PortableFile::Info info = { 0, 0 };
+        PortableFile::getInfo(widePath, info);
+        lags.push_back((info.size - tail.offset()) / 1048576.0);
+        if (!isWriterDone)
+        {
+            isWriterDone = waitpid(writer, nullptr, WNOHANG) == writer;
+        }
+        else if (tail.offset() == info.size)
+        {
+            break;
+        }
+    }
+    double wallTime = elapsedSeconds(start);
+    double cpuTime = cpuSeconds() - cpuStart;
+    watcher.stop();
+
+    std::sort(lags.begin(), lags.end());
+    Benchmark::report("Прочитано", tail.offset() / 1048576.0, "МБ");
+    Benchmark::report("Отставание: медиана", lags[lags.size() / 2], "МБ");
+    Benchmark::report("Отставание: максимум", lags.back(), "МБ");
+    Benchmark::report("Отставание: максимум по времени", lags.back() * 1000.0 / megabytesPerSecond, "мс");
+    Benchmark::report("Процессор читателя", cpuTime / wallTime * 100.0, "%");
+    std::remove(path.c_str());
+    if (mismatchCount != 0)
+    {
+        std::printf("ОШИБКА: прочитано %u неверных символов\n", (unsigned)mismatchCount);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Свертывание блоков: прокрутка и переключение блока при тысячах свернутых
+//
+// В документе свернуты блоки по 3-40 строк, каждый четвертый - с
+// вложенным свернутым блоком. Кадр прокрутки - перевод верхней видимой
+// строки в строку документа и переход по 60 видимым строкам окна.
+// Переключение - свертывание или развертывание блока и перевод строк
+// следующего кадра (скрытые интервалы перестраиваются при этом запросе).
+//
+// Аргументы: количество строк документа (1000000), количество кадров (200000)
+
+#include "benchmarks/Benchmark.h"
+#include "FoldMap.h"
+#include <random>
+
+int main(int argc, char** argv)
+{
+    uint64_t lineCount = Benchmark::argument(argc, argv, 1, 1000000);
+    size_t frameCount = Benchmark::argument(argc, argv, 2, 200000);
+    const int WINDOW_LINES = 60;
+
+    std::mt19937 random(47);
+    FoldMap map;
+    Benchmark::Stopwatch stopwatch;
+    for (uint64_t header = 0; header + 50 < lineCount;)
+    {
+        uint64_t length = 3 + random() % 38;
+        map.toggle(header, header + length);
+        if (random() % 4 == 0)
+        {
+            map.toggle(header + 1, header + 1 + length / 2);
+        }
+        header += length + 1 + random() % 10;
+    }
+    uint64_t visibleCount = map.visibleLineCount(lineCount);
+    Benchmark::report("Свертывание блоков по одному", stopwatch.elapsedMilliseconds(), "мс");
+    std::printf("Строк: %llu, свернуто блоков: %u, видимых строк: %llu\n", (unsigned long long)lineCount,
+                (unsigned)map.foldCount(), (unsigned long long)visibleCount);
+
+    // Кадр прокрутки: переход к строке окна - O(1)
+    uint64_t checksum = 0;
+    stopwatch.restart();
+    for (size_t frame = 0; frame < frameCount; ++frame)
+    {
+        uint64_t line = map.toDocument((uint64_t)frame * 37 % visibleCount);
+        for (int row = 0; row < WINDOW_LINES && line < lineCount; ++row)
+        {
+            checksum += line;
+            line = map.nextVisible(line);
+        }
+    }
+    Benchmark::report("Кадр прокрутки (60 строк)", stopwatch.elapsedMilliseconds() * 1000.0 / frameCount, "мкс");
+
+    // Полоса прокрутки: перевод строк в обе стороны
+    bool isCorrect = true;
+    stopwatch.restart();
+    for (size_t frame = 0; frame < frameCount; ++frame)
+    {
+        uint64_t visibleLine = (uint64_t)frame * 7919 % visibleCount;
+        isCorrect = isCorrect && map.toVisible(map.toDocument(visibleLine)) == visibleLine;
+    }
+    Benchmark::report("Перевод видимой строки и обратно", stopwatch.elapsedMilliseconds() * 1000.0 / frameCount, "мкс");
+
+    // Переключение блока в середине документа и следующий кадр
+    stopwatch.restart();
+    for (int i = 0; i < 200; ++i)
+    {
+        uint64_t header = map.toDocument(visibleCount / 2 + i);
+        map.toggle(header, header + 5);
+        checksum += map.toDocument(visibleCount / 3);
+    }
+    Benchmark::report("Переключение блока и кадр", stopwatch.elapsedMilliseconds() * 1000.0 / 200, "мкс");
+
+    stopwatch.restart();
+    for (int i = 0; i < 1000; ++i)
+    {
+        map.reveal(lineCount / 2 + i * 7);
+        checksum += map.toVisible(lineCount / 2);
+    }
+    Benchmark::report("Показ строки (переход к скрытой) и кадр", stopwatch.elapsedMilliseconds() * 1000.0 / 1000, "мкс");
+    Benchmark::keep(checksum);
+    if (!isCorrect)
+    {
+        std::printf("ОШИБКА: перевод строк не обратим\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+// Просмотр большого файла: память и переход к случайной строке
+//
+// Файл из строк одинаковой длины создается один раз и используется
+// повторно, если уже есть и имеет нужный размер; номер строки записан в
+// ее начале, поэтому прочитанный текст проверяется.
+//
+// Аргументы: размер файла в ГБ (20), путь к файлу (во временном каталоге)
+
+#include "benchmarks/Benchmark.h"
+#include "TestSupport.h"
+#include "LargeFileDocument.h"
+#include "PortableFile.h"
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    const size_t LINE_BYTES = 100;
+
+    void formatLine(uint64_t line, char* output)
+    {
+        int length = std::snprintf(output, LINE_BYTES, "line %016llu ", (unsigned long long)line);
+        std::fill(output + length, output + LINE_BYTES - 1, 'x');
+        output[LINE_BYTES - 1] = '\n';
+    }
+
+    bool createFile(const std::string& path, uint64_t size)
+    {
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file)
+        {
+            return false;
+        }
+        std::vector<char> buffer(LINE_BYTES * 65536);
+        uint64_t lineCount = size / LINE_BYTES;
+        for (uint64_t line = 0; line < lineCount;)
+        {
+            size_t count = (size_t)std::min<uint64_t>(65536, lineCount - line);
+            for (size_t i = 0; i < count; ++i)
+            {
+                formatLine(line + i, &buffer[i * LINE_BYTES]);
+            }
+            if (std::fwrite(buffer.data(), LINE_BYTES, count, file) != count)
+            {
+                std::fclose(file);
+                return false;
+            }
+            line += count;
+        }
+        return std::fclose(file) == 0;
+    }
+
+    void reportJumps(const std::string& name, LargeFileDocument& document, uint64_t lineLimit, bool& isCorrect)
+    {
+        std::mt19937_64 random(1);
+        std::vector<double> times;
+        std::vector<std::wstring> lines;
+        for (int i = 0; i < 2000; ++i)
+        {
+            uint64_t line = random() % lineLimit;
+            Benchmark::Stopwatch stopwatch;
+            size_t count = document.readLines(line, 60, lines);
+            times.push_back(stopwatch.elapsedMilliseconds());
+
+            char expected[LINE_BYTES];
+            formatLine(line, expected);
+            isCorrect = isCorrect && count > 0 && lines[0] == std::wstring(expected, expected + LINE_BYTES - 1);
+        }
+        std::sort(times.begin(), times.end());
+        Benchmark::report(name + ": медиана", times[times.size() / 2], "мс");
+        Benchmark::report(name + ": 99-й процентиль", times[times.size() * 99 / 100], "мс");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t gigabytes = Benchmark::argument(argc, argv, 1, 20);
+    std::string path = argc > 2 ? argv[2] : TestSupport::temporaryPath("large.txt");
+    std::wstring widePath(path.begin(), path.end());
+    uint64_t size = gigabytes * 1024 * 1024 * 1024 / LINE_BYTES * LINE_BYTES;
+
+    PortableFile::Info info = { 0, 0 };
+    if (!PortableFile::getInfo(widePath, info) || info.size != size)
+    {
+        std::printf("Создание файла %s (%llu ГБ)...\n", path.c_str(), (unsigned long long)gigabytes);
+        if (!createFile(path, size))
+        {
+            std::printf("Не удалось создать файл\n");
+            return 1;
+        }
+    }
+    uint64_t lineCount = size / LINE_BYTES;
+    std::printf("Файл: %.1f ГБ, строк: %llu\n", size / 1073741824.0, (unsigned long long)lineCount);
+
+    double baseMemory = Benchmark::residentMegabytes();
+    Benchmark::Stopwatch stopwatch;
+    LargeFileDocument document;
+    if (!document.open(widePath, std::vector<wchar_t>()))
+    {
+        std::printf("Не удалось открыть файл\n");
+        return 1;
+    }
+    std::vector<std::wstring> lines;
+    document.readLines(0, 60, lines);
+    Benchmark::report("Открытие и первый экран", stopwatch.elapsedMilliseconds(), "мс");
+
+    // Пока индекс строится, переходы возможны только в проиндексированную часть
+    bool isCorrect = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    uint64_t indexedLines = document.lineCount();
+    if (!document.isIndexComplete() && indexedLines > 1)
+    {
+        reportJumps("Переход во время индексации", document, indexedLines - 1, isCorrect);
+    }
+
+    while (!document.isIndexComplete())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    double indexTime = stopwatch.elapsedMilliseconds();
+    Benchmark::report("Построение индекса строк", indexTime, "мс");
+    Benchmark::report("Скорость индексации", size / 1048576.0 / (indexTime / 1000.0), "МБ/с");
+    isCorrect = isCorrect && document.lineCount() == lineCount + 1;
+
+    reportJumps("Переход к случайной строке", document, lineCount, isCorrect);
+    Benchmark::report("Прирост RSS", Benchmark::residentMegabytes() - baseMemory, "МБ");
+    Benchmark::report("Пиковый RSS процесса", Benchmark::peakResidentMegabytes(), "МБ");
+    document.close();
+    if (argc <= 2)
+    {
+        std::remove(path.c_str());
+    }
+    std::printf(isCorrect ? "Прочитанные строки совпадают с ожидаемыми\n" : "ОШИБКА: прочитан неверный текст\n");
+    return isCorrect ? 0 : 1;
+}
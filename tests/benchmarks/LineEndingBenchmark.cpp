@@ -0,0 +1,114 @@
+// Загрузка файлов с переводами строк LF и CRLF
+//
+// Загрузка как в редакторе: чтение байтов, подсчет переводов строк в них,
+// декодирование UTF-8 в строку заранее известного размера и приведение к
+// CRLF на месте. Для сравнения - прежнее приведение копированием в новую
+// строку. Прирост пикового RSS включает байты файла и итоговый текст
+// (в Linux wchar_t занимает 4 байта, поэтому текст больше, чем в Windows).
+//
+// Аргументы: размер файла в МБ (1024)
+
+#include "benchmarks/Benchmark.h"
+#include "TestSupport.h"
+#include "LineEndingScanner.h"
+#include "Utf8Codec.h"
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+    void createFile(const std::string& path, size_t megabytes, const char* lineEnding)
+    {
+        std::string block;
+        for (int line = 0; block.size() < 1024 * 1024; ++line)
+        {
+            block += "2024-01-01 запись журнала номер " + std::to_string(line) + " status=ok" + lineEnding;
+        }
+        FILE* file = std::fopen(path.c_str(), "wb");
+        for (size_t i = 0; i < megabytes; ++i)
+        {
+            std::fwrite(block.data(), 1, block.size(), file);
+        }
+        std::fclose(file);
+    }
+
+    // Каждый замер - в отдельном процессе, чтобы пиковый RSS считался заново
+    template <typename Load>
+    bool runInChild(Load load)
+    {
+        std::fflush(stdout);
+        pid_t child = fork();
+        if (child == 0)
+        {
+            _exit(load() ? 0 : 1);
+        }
+        int status = 0;
+        waitpid(child, &status, 0);
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+
+    bool loadInPlace(const std::string& name, const std::string& path, DocumentFormat::LineEnding expected)
+    {
+        double basePeak = Benchmark::peakResidentMegabytes();
+        std::string bytes = TestSupport::readFile(path);
+        Benchmark::Stopwatch stopwatch;
+        LineEndingScanner::Counts counts = LineEndingScanner::scan(bytes.data(), bytes.size(), 1, false);
+        double scanTime = stopwatch.elapsedMilliseconds();
+        std::wstring text;
+        text.reserve(bytes.size() + (size_t)LineEndingScanner::expansion(counts));
+        const wchar_t* reserved = text.data();
+        Utf8Codec::decodeAppend(bytes.data(), bytes.size(), text);
+        LineEndingScanner::normalize(text, counts);
+        double loadTime = stopwatch.elapsedMilliseconds();
+
+        Benchmark::report(name + ": подсчет переводов строк", scanTime, "мс");
+        Benchmark::report(name + ": скорость подсчета", bytes.size() / 1048576.0 / (scanTime / 1000.0), "МБ/с");
+        Benchmark::report(name + ": загрузка целиком", loadTime, "мс");
+        Benchmark::report(name + ": размер текста", text.size() * sizeof(wchar_t) / 1048576.0, "МБ");
+        Benchmark::report(name + ": прирост пикового RSS", Benchmark::peakResidentMegabytes() - basePeak, "МБ");
+        return LineEndingScanner::dominant(counts) == expected && text.data() == reserved;
+    }
+
+    bool loadByCopy(const std::string& name, const std::string& path)
+    {
+        double basePeak = Benchmark::peakResidentMegabytes();
+        std::string bytes = TestSupport::readFile(path);
+        Benchmark::Stopwatch stopwatch;
+        std::wstring decoded = Utf8Codec::decode(bytes);
+        std::wstring converted;
+        for (size_t i = 0; i < decoded.size(); ++i)
+        {
+            if (decoded[i] == L'\n' && (i == 0 || decoded[i - 1] != L'\r'))
+            {
+                converted += L'\r';
+            }
+            converted += decoded[i];
+        }
+        Benchmark::report(name + ": приведение копией (для сравнения)", stopwatch.elapsedMilliseconds(), "мс");
+        Benchmark::report(name + ": прирост пикового RSS копией", Benchmark::peakResidentMegabytes() - basePeak, "МБ");
+        return !converted.empty();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t megabytes = Benchmark::argument(argc, argv, 1, 1024);
+    std::string lfPath = TestSupport::temporaryPath("lf.txt");
+    std::string crlfPath = TestSupport::temporaryPath("crlf.txt");
+    createFile(lfPath, megabytes, "\n");
+    createFile(crlfPath, megabytes, "\r\n");
+    std::printf("Файлы: %u МБ\n", (unsigned)megabytes);
+
+    bool isCorrect = runInChild([&]() { return loadInPlace("LF", lfPath, DocumentFormat::LINE_ENDING_LF); });
+    isCorrect = runInChild([&]() { return loadByCopy("LF", lfPath); }) && isCorrect;
+    isCorrect = runInChild([&]() { return loadInPlace("CRLF", crlfPath, DocumentFormat::LINE_ENDING_CRLF); }) && isCorrect;
+    isCorrect = runInChild([&]() { return loadByCopy("CRLF", crlfPath); }) && isCorrect;
+    std::remove(lfPath.c_str());
+    std::remove(crlfPath.c_str());
+    if (!isCorrect)
+    {
+        std::printf("ОШИБКА: неверный стиль перевода строк или лишнее перераспределение памяти\n");
+        return 1;
+    }
+    return 0;
+}
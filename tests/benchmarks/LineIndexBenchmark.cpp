@@ -0,0 +1,153 @@
+// Переход к строке, смещению и проценту в файле на 2 ГБ
+//
+// Строки разной длины (от 20 до 200 байт), номер строки записан в ее
+// начале. Замеряются построение разреженного индекса в фоне (скорость и
+// память) и задержка команд перехода: к строке по номеру, к смещению в
+// байтах и к проценту файла; найденная строка проверяется по номеру.
+// Файл используется повторно, если уже есть и имеет нужный размер.
+//
+// Аргументы: размер файла в ГБ (2), путь к файлу (во временном каталоге)
+
+#include "benchmarks/Benchmark.h"
+#include "TestSupport.h"
+#include "LargeFileDocument.h"
+#include "PortableFile.h"
+#include <algorithm>
+#include <random>
+#include <thread>
+
+namespace
+{
+    // Длина строки по номеру, без перевода строки
+    size_t lineLength(uint64_t line)
+    {
+        return 20 + (size_t)((line * 2654435761ULL) % 181);
+    }
+
+    bool createFile(const std::string& path, uint64_t size)
+    {
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file)
+        {
+            return false;
+        }
+        std::string buffer;
+        uint64_t written = 0;
+        for (uint64_t line = 0; written < size; ++line)
+        {
+            char number[32];
+            int length = std::snprintf(number, sizeof(number), "%llu:", (unsigned long long)line);
+            buffer.append(number, length);
+            buffer.append(lineLength(line) - length, 'x');
+            buffer += '\n';
+            if (buffer.size() >= 1024 * 1024)
+            {
+                size_t count = (size_t)std::min<uint64_t>(buffer.size(), size - written);
+                std::fwrite(buffer.data(), 1, count, file);
+                written += count;
+                buffer.clear();
+            }
+        }
+        return std::fclose(file) == 0;
+    }
+
+    uint64_t lineNumber(const std::wstring& text)
+    {
+        return std::wcstoull(text.c_str(), nullptr, 10);
+    }
+
+    void reportLatency(const std::string& name, std::vector<double>& times)
+    {
+        std::sort(times.begin(), times.end());
+        Benchmark::report(name + ": медиана", times[times.size() / 2], "мс");
+        Benchmark::report(name + ": 99-й процентиль", times[times.size() * 99 / 100], "мс");
+    }
+
+    // Переход к строке, содержащей смещение (как для смещения, так и для процента)
+    bool goToOffset(LargeFileDocument& document, uint64_t offset, std::vector<std::wstring>& lines)
+    {
+        uint64_t line = 0;
+        uint64_t start = 0;
+        uint64_t next = 0;
+        return document.lineOfOffset(offset, line) && document.lineStartOffset(line, start) &&
+               document.lineStartOffset(line + 1, next) && start <= offset && offset < next &&
+               document.readLines(line, 1, lines) == 1 && lineNumber(lines[0]) == line;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t gigabytes = Benchmark::argument(argc, argv, 1, 2);
+    std::string path = argc > 2 ? argv[2] : TestSupport::temporaryPath("lines.txt");
+    std::wstring widePath(path.begin(), path.end());
+    uint64_t size = gigabytes * 1024 * 1024 * 1024;
+
+    PortableFile::Info info = { 0, 0 };
+    if (!PortableFile::getInfo(widePath, info) || info.size != size)
+    {
+        std::printf("Создание файла %s (%llu ГБ)...\n", path.c_str(), (unsigned long long)gigabytes);
+        if (!createFile(path, size))
+        {
+            std::printf("Не удалось создать файл\n");
+            return 1;
+        }
+    }
+
+    double baseMemory = Benchmark::residentMegabytes();
+    Benchmark::Stopwatch stopwatch;
+    LargeFileDocument document;
+    if (!document.open(widePath, std::vector<wchar_t>()))
+    {
+        std::printf("Не удалось открыть файл\n");
+        return 1;
+    }
+    while (!document.isIndexComplete())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    double indexTime = stopwatch.elapsedMilliseconds();
+    uint64_t lineCount = document.lineCount();
+    std::printf("Файл: %.1f ГБ, строк: %llu\n", size / 1073741824.0, (unsigned long long)lineCount);
+    Benchmark::report("Построение индекса", indexTime, "мс");
+    Benchmark::report("Скорость индексации", size / 1048576.0 / (indexTime / 1000.0), "МБ/с");
+    Benchmark::report("Прирост RSS с индексом", Benchmark::residentMegabytes() - baseMemory, "МБ");
+
+    std::mt19937_64 random(2);
+    std::vector<std::wstring> lines;
+    std::vector<double> lineTimes;
+    std::vector<double> offsetTimes;
+    std::vector<double> percentTimes;
+    bool isCorrect = true;
+    for (int i = 0; i < 2000 && isCorrect; ++i)
+    {
+        uint64_t line = random() % (lineCount - 1);
+        Benchmark::Stopwatch lookup;
+        isCorrect = document.readLines(line, 1, lines) == 1 && lineNumber(lines[0]) == line;
+        lineTimes.push_back(lookup.elapsedMilliseconds());
+
+        // Последняя строка оборвана размером файла и в проверке не участвует
+        uint64_t offset = random() % (size - 256);
+        lookup.restart();
+        isCorrect = isCorrect && goToOffset(document, offset, lines);
+        offsetTimes.push_back(lookup.elapsedMilliseconds());
+
+        lookup.restart();
+        isCorrect = isCorrect && goToOffset(document, size * (i % 100) / 100, lines);
+        percentTimes.push_back(lookup.elapsedMilliseconds());
+    }
+    reportLatency("Переход к строке", lineTimes);
+    reportLatency("Переход к смещению", offsetTimes);
+    reportLatency("Переход к проценту", percentTimes);
+
+    document.close();
+    if (argc <= 2)
+    {
+        std::remove(path.c_str());
+    }
+    if (!isCorrect)
+    {
+        std::printf("ОШИБКА: переход привел не к той строке\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,95 @@
+// Сортировка и удаление повторов в выгрузке из миллионов строк
+//
+// Строки похожи на CSV-выгрузку (шестнадцатеричный ключ, пользователь,
+// текст на кириллице). Сортировка по кодам символов выполняется в 1, 2, 4
+// и 8 потоках и сравнивается с std::stable_sort по тем же отрезкам; при
+// числе потоков больше числа ядер ускорения нет. Отдельно измеряются
+// сортировка с заданным сравнением, удаление повторов, обратный порядок
+// с удалением пробелов и сборка текста для одной правки.
+//
+// Аргументы: количество строк (10000000)
+
+#include "benchmarks/Benchmark.h"
+#include "LineOperations.h"
+#include <algorithm>
+#include <random>
+#include <thread>
+
+int main(int argc, char** argv)
+{
+    size_t lineCount = Benchmark::argument(argc, argv, 1, 10000000);
+    typedef LineOperations::Line Line;
+
+    std::mt19937 random(50);
+    std::wstring text;
+    text.reserve(lineCount * 42);
+    for (size_t i = 0; i < lineCount; ++i)
+    {
+        unsigned value = random();
+        wchar_t buffer[80];
+        int length = std::swprintf(buffer, 80, L"%08x,user%u,Строка %u,%u", value, value % 100000,
+                                   (value >> 8) % 5000, (unsigned)(random() % 1000));
+        text.append(buffer, length);
+        text += i + 1 < lineCount ? L"\r\n" : L"";
+    }
+
+    Benchmark::Stopwatch stopwatch;
+    std::vector<Line> lines;
+    LineOperations::split(text.data(), text.size(), lines);
+    std::printf("Строк: %u, текст %.0f МБ UTF-16, ядер: %u\n", (unsigned)lines.size(), text.size() * 2 / 1048576.0,
+                std::thread::hardware_concurrency());
+    Benchmark::report("Разбиение на строки", stopwatch.elapsedMilliseconds(), "мс");
+
+    std::vector<Line> expected = lines;
+    stopwatch.restart();
+    std::stable_sort(expected.begin(), expected.end(), [&](const Line& left, const Line& right)
+    {
+        return LineOperations::compareOrdinal(text.data() + left.offset, left.length,
+                                              text.data() + right.offset, right.length) < 0;
+    });
+    Benchmark::report("std::stable_sort", stopwatch.elapsedMilliseconds(), "мс");
+
+    bool isCorrect = true;
+    const size_t threadCounts[] = { 1, 2, 4, 8 };
+    for (size_t i = 0; i < sizeof(threadCounts) / sizeof(threadCounts[0]); ++i)
+    {
+        std::vector<Line> sorted = lines;
+        stopwatch.restart();
+        LineOperations::sort(text.data(), sorted, LineOperations::Compare(), threadCounts[i]);
+        Benchmark::report("Сортировка, потоков: " + std::to_string(threadCounts[i]), stopwatch.elapsedMilliseconds(), "мс");
+        for (size_t j = 0; j < sorted.size() && isCorrect; ++j)
+        {
+            isCorrect = sorted[j].offset == expected[j].offset;
+        }
+    }
+
+    std::vector<Line> work = lines;
+    stopwatch.restart();
+    LineOperations::sort(text.data(), work, LineOperations::compareOrdinal, 0);
+    Benchmark::report("Сортировка с заданным сравнением, все ядра", stopwatch.elapsedMilliseconds(), "мс");
+
+    work = lines;
+    stopwatch.restart();
+    LineOperations::unique(text.data(), work, 0);
+    Benchmark::report("Удаление повторов", stopwatch.elapsedMilliseconds(), "мс");
+    std::printf("Осталось строк: %u\n", (unsigned)work.size());
+
+    work = lines;
+    stopwatch.restart();
+    LineOperations::reverse(work);
+    LineOperations::trimTrailing(text.data(), work);
+    Benchmark::report("Обратный порядок и удаление пробелов", stopwatch.elapsedMilliseconds(), "мс");
+
+    std::wstring result;
+    stopwatch.restart();
+    LineOperations::join(text.data(), lines, L"\r\n", result);
+    Benchmark::report("Сборка текста", stopwatch.elapsedMilliseconds(), "мс");
+    Benchmark::report("Пиковый RSS процесса", Benchmark::peakResidentMegabytes(), "МБ");
+
+    if (!isCorrect || result != text)
+    {
+        std::printf("ОШИБКА: порядок строк или собранный текст не совпадает\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,127 @@
+// Строка в 1 МБ, 100 МБ и 1 ГБ: горизонтальная прокрутка до конца
+//
+// Файл из короткой строки, одной длинной (как минифицированный JSON или
+// base64) и еще одной короткой. Замеряются открытие до первого экрана,
+// построение индекса, переход в конец строки (End), перетаскивание
+// ползунка от начала до конца (1000 положений) и прокрутка на экран
+// вправо у конца строки. Текст каждого участка проверяется.
+//
+// Аргументы: наибольшая длина строки в МБ (1024)
+
+#include "benchmarks/Benchmark.h"
+#include "TestSupport.h"
+#include "LargeFileDocument.h"
+#include <algorithm>
+#include <thread>
+
+namespace
+{
+    const char PATTERN[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    const size_t PATTERN_LENGTH = 64;
+    const size_t SCREEN_COLUMNS = 200;
+
+    bool createFile(const std::string& path, uint64_t lineLength)
+    {
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file)
+        {
+            return false;
+        }
+        std::fputs("{\"data\":\n", file);
+        std::string block;
+        while (block.size() < 1024 * 1024)
+        {
+            block += PATTERN;
+        }
+        for (uint64_t written = 0; written < lineLength; written += block.size())
+        {
+            std::fwrite(block.data(), 1, (size_t)std::min<uint64_t>(block.size(), lineLength - written), file);
+        }
+        std::fputs("\n}\n", file);
+        return std::fclose(file) == 0;
+    }
+
+    bool readScreen(LargeFileDocument& document, uint64_t column, std::vector<LargeFileDocument::LineSegment>& segments)
+    {
+        if (document.readSegments(1, 1, column, SCREEN_COLUMNS, segments) != 1 || !segments[0].isLong)
+        {
+            return false;
+        }
+        const LargeFileDocument::LineSegment& segment = segments[0];
+        bool isCorrect = segment.column <= column;
+        for (size_t i = 0; i < segment.text.size() && isCorrect; ++i)
+        {
+            isCorrect = segment.text[i] == (wchar_t)PATTERN[(segment.column + i) % PATTERN_LENGTH];
+        }
+        return isCorrect;
+    }
+
+    bool measure(uint64_t megabytes)
+    {
+        uint64_t lineLength = megabytes * 1024 * 1024;
+        std::string path = TestSupport::temporaryPath("longline.txt");
+        if (!createFile(path, lineLength))
+        {
+            std::printf("Не удалось создать файл\n");
+            return false;
+        }
+        std::string prefix = "Строка " + std::to_string(megabytes) + " МБ: ";
+        double baseMemory = Benchmark::residentMegabytes();
+
+        Benchmark::Stopwatch stopwatch;
+        LargeFileDocument document;
+        std::vector<LargeFileDocument::LineSegment> segments;
+        bool isCorrect = document.open(std::wstring(path.begin(), path.end()), std::vector<wchar_t>());
+        isCorrect = isCorrect && document.readSegments(0, 40, 0, SCREEN_COLUMNS, segments) > 0;
+        Benchmark::report(prefix + "открытие и первый экран", stopwatch.elapsedMilliseconds(), "мс");
+        while (!document.isIndexComplete())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        Benchmark::report(prefix + "построение индекса", stopwatch.elapsedMilliseconds(), "мс");
+
+        stopwatch.restart();
+        isCorrect = isCorrect && readScreen(document, lineLength - SCREEN_COLUMNS, segments);
+        isCorrect = isCorrect && segments[0].length == lineLength;
+        Benchmark::report(prefix + "переход в конец строки", stopwatch.elapsedMilliseconds(), "мс");
+
+        double maxStep = 0;
+        stopwatch.restart();
+        for (int position = 0; position <= 1000 && isCorrect; ++position)
+        {
+            Benchmark::Stopwatch stepStopwatch;
+            isCorrect = readScreen(document, (lineLength - SCREEN_COLUMNS) / 1000 * position, segments);
+            maxStep = std::max(maxStep, stepStopwatch.elapsedMilliseconds());
+        }
+        Benchmark::report(prefix + "ползунок от начала до конца", stopwatch.elapsedMilliseconds(), "мс");
+        Benchmark::report(prefix + "самое долгое положение ползунка", maxStep, "мс");
+
+        stopwatch.restart();
+        for (int step = 0; step < 1000 && isCorrect; ++step)
+        {
+            isCorrect = readScreen(document, lineLength - (uint64_t)(1000 - step) * SCREEN_COLUMNS, segments);
+        }
+        Benchmark::report(prefix + "прокрутка на экран вправо", stopwatch.elapsedMilliseconds(), "мкс");   // 1000 шагов
+        Benchmark::report(prefix + "прирост RSS", Benchmark::residentMegabytes() - baseMemory, "МБ");
+        document.close();
+        std::remove(path.c_str());
+        return isCorrect;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t maxMegabytes = Benchmark::argument(argc, argv, 1, 1024);
+    static const uint64_t SIZES[] = { 1, 100, 1024 };
+    bool isCorrect = true;
+    for (size_t i = 0; i < 3 && SIZES[i] <= maxMegabytes; ++i)
+    {
+        isCorrect = measure(SIZES[i]) && isCorrect;
+    }
+    if (!isCorrect)
+    {
+        std::printf("ОШИБКА: участок строки прочитан неверно\n");
+        return 1;
+    }
+    return 0;
+}
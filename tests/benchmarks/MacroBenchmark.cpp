@@ -0,0 +1,158 @@
+// Повтор макроса клавиатуры над журналом: одна правка на все повторы
+//
+// Макрос из 20 шагов размечает строку журнала и переходит к следующей.
+// MacroPlayer выполняет повторы над копией текста с разрывом у курсора и
+// возвращает изменение одним участком, который применяется к тексту
+// документа одной правкой (один шаг отмены, одна перерисовка). Для
+// сравнения те же шаги выполняются прямо над строкой документа без
+// разрыва - так стоила бы каждая правка без пакетного выполнения.
+//
+// Аргументы: количество повторов (100000), повторов для сравнения (2000)
+
+#include "benchmarks/Benchmark.h"
+#include "MacroPlayer.h"
+#include "TextChangeTracker.h"
+
+namespace
+{
+    // Шаг над строкой без разрыва: вставка и удаление сдвигают хвост текста
+    void executeFlat(std::wstring& text, size_t& caret, const KeyboardMacro::Step& step)
+    {
+        switch (step.opcode)
+        {
+        case KeyboardMacro::OP_INSERT:
+            text.insert(caret, step.text, step.length);
+            caret += step.length;
+            break;
+        case KeyboardMacro::OP_DELETE_BACK:
+            caret -= caret > 0 ? 1 : 0;
+            text.erase(caret, 1);
+            break;
+        case KeyboardMacro::OP_DELETE_FORWARD:
+            text.erase(caret, 1);
+            break;
+        case KeyboardMacro::OP_CHAR_LEFT:
+            caret -= caret > 0 ? 1 : 0;
+            break;
+        case KeyboardMacro::OP_CHAR_RIGHT:
+            caret += caret < text.size() ? 1 : 0;
+            break;
+        case KeyboardMacro::OP_LINE_HOME:
+            while (caret > 0 && text[caret - 1] != L'\n')
+            {
+                --caret;
+            }
+            break;
+        case KeyboardMacro::OP_LINE_END:
+            while (caret < text.size() && text[caret] != L'\r')
+            {
+                ++caret;
+            }
+            break;
+        case KeyboardMacro::OP_LINE_DOWN:
+            while (caret < text.size() && text[caret] != L'\n')
+            {
+                ++caret;
+            }
+            caret += caret < text.size() ? 1 : 0;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t times = Benchmark::argument(argc, argv, 1, 100000);
+    size_t flatTimes = Benchmark::argument(argc, argv, 2, 2000);
+
+    std::wstring document;
+    for (size_t line = 0; line < times + 1; ++line)
+    {
+        document += L"2024-05-01 12:00:" + std::to_wstring(line % 60);
+        document += line % 7 == 0 ? L" ERROR disk full id=" : L" INFO request ok id=";
+        document += std::to_wstring(line) + L"\r\n";
+    }
+
+    // 20 шагов: "2024-05-01 12:00:0 ERROR ... id=0" становится "<2024-05-01]T12:00:0 ERROR ... id; #|"
+    KeyboardMacro macro;
+    macro.recordOperation(KeyboardMacro::OP_LINE_HOME);
+    macro.recordText(L"[", 1);
+    for (int i = 0; i < 10; ++i)
+    {
+        macro.recordOperation(KeyboardMacro::OP_CHAR_RIGHT);
+    }
+    macro.recordText(L"]", 1);
+    macro.recordOperation(KeyboardMacro::OP_DELETE_FORWARD);
+    macro.recordText(L"T", 1);
+    macro.recordOperation(KeyboardMacro::OP_LINE_END);
+    macro.recordOperation(KeyboardMacro::OP_DELETE_BACK);
+    macro.recordOperation(KeyboardMacro::OP_DELETE_BACK);
+    macro.recordText(L";", 1);
+    macro.recordOperation(KeyboardMacro::OP_CHAR_LEFT);
+    macro.recordOperation(KeyboardMacro::OP_CHAR_RIGHT);
+    macro.recordText(L" #", 2);
+    macro.recordOperation(KeyboardMacro::OP_LINE_HOME);
+    macro.recordOperation(KeyboardMacro::OP_CHAR_RIGHT);
+    macro.recordOperation(KeyboardMacro::OP_DELETE_BACK);
+    macro.recordText(L"<", 1);
+    macro.recordOperation(KeyboardMacro::OP_LINE_END);
+    macro.recordText(L"|", 1);
+    macro.recordOperation(KeyboardMacro::OP_LINE_DOWN);
+    macro.recordOperation(KeyboardMacro::OP_LINE_HOME);
+    std::vector<KeyboardMacro::Step> steps;
+    macro.decode(steps);
+    std::printf("Макрос: %u шагов, %u единиц байт-кода; документ: %.1f МБ UTF-16\n",
+                (unsigned)steps.size(), (unsigned)macro.codeSize(), document.size() * 2 / 1048576.0);
+
+    TextChangeTracker tracker;
+    tracker.reset(document.data(), document.size());
+
+    Benchmark::Stopwatch stopwatch;
+    MacroPlayer player(document.data(), document.size(), 0, 0);
+    size_t done = player.run(macro, times);
+    double runTime = stopwatch.elapsedMilliseconds();
+
+    stopwatch.restart();
+    size_t start = 0;
+    size_t oldLength = 0;
+    std::wstring newText;
+    player.getChange(start, oldLength, newText);
+    tracker.applyEdit(start, oldLength, newText);
+    double applyTime = stopwatch.elapsedMilliseconds();
+
+    Benchmark::report("Повторы макроса", runTime, "мс");
+    Benchmark::report("Один повтор", runTime * 1000.0 / done, "мкс");
+    Benchmark::report("Применение участка одной правкой", applyTime, "мс");
+
+    // Те же шаги прямо над строкой документа
+    std::wstring flat = document;
+    size_t caret = 0;
+    stopwatch.restart();
+    for (size_t iteration = 0; iteration < flatTimes; ++iteration)
+    {
+        for (size_t i = 0; i < steps.size(); ++i)
+        {
+            for (size_t repeat = 0; repeat < steps[i].count; ++repeat)
+            {
+                executeFlat(flat, caret, steps[i]);
+            }
+        }
+    }
+    double flatTime = stopwatch.elapsedMilliseconds();
+    Benchmark::report("Без разрыва: один повтор", flatTime * 1000.0 / flatTimes, "мкс");
+    Benchmark::report("Без разрыва: оценка для всех повторов", flatTime / flatTimes * times / 1000.0, "с");
+
+    // Строки, пройденные обоими способами, совпадают
+    bool isCorrect = done == times && caret > 0 && tracker.text().length() == player.length() &&
+                     tracker.text().substr(0, caret) == flat.substr(0, caret);
+    std::wstring firstLine = tracker.text().substr(0, 80);
+    std::printf("Первая строка: %ls\n", firstLine.substr(0, firstLine.find(L'\r')).c_str());
+    if (!isCorrect)
+    {
+        std::printf("ОШИБКА: результат повторов не совпадает\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Мини-карта документа из 1 млн строк: построение, правка и память
+//
+// Документ похож на код с разными отступами. Измеряется построение
+// растра при открытии, сборка картинки высотой в окно, правка (ввод
+// символа и перевода строки в случайных местах) с обновлением плиток
+// против той же правки без мини-карты, и вставка, удваивающая документ
+// (смена масштаба с полной перестройкой).
+//
+// Аргументы: количество строк (1000000), количество правок (2000)
+
+#include "benchmarks/Benchmark.h"
+#include "MinimapCache.h"
+#include <algorithm>
+#include <random>
+
+int main(int argc, char** argv)
+{
+    size_t lineCount = Benchmark::argument(argc, argv, 1, 1000000);
+    size_t editCount = Benchmark::argument(argc, argv, 2, 2000);
+    const size_t MAP_HEIGHT = 900;
+
+    std::wstring text;
+    for (size_t line = 0; line < lineCount; ++line)
+    {
+        text.append(line % 7 * 4, L' ');
+        text += line % 3 == 0 ? L"if (value[i] > limit) {\r\n" : L"result += compute(value, i); // note\r\n";
+    }
+    TextChangeTracker tracker;
+    tracker.reset(text.data(), text.size());
+    TextChangeTracker plain;
+    plain.reset(text.data(), text.size());
+    std::printf("Строк: %u, символов: %u\n", (unsigned)lineCount + 1, (unsigned)text.size());
+    std::wstring().swap(text);
+
+    double baseMemory = Benchmark::residentMegabytes();
+    Benchmark::Stopwatch stopwatch;
+    MinimapCache cache;
+    cache.onTextReset(tracker.text());
+    tracker.addListener(&cache);
+    Benchmark::report("Построение растра", stopwatch.elapsedMilliseconds(), "мс");
+    Benchmark::report("Память растра", cache.memoryUsage() / 1024.0, "КБ");
+    Benchmark::report("Прирост RSS", Benchmark::residentMegabytes() - baseMemory, "МБ");
+    std::printf("Плиток: %u\n", (unsigned)cache.tileCount());
+
+    std::vector<uint8_t> pixels;
+    stopwatch.restart();
+    for (int i = 0; i < 100; ++i)
+    {
+        cache.render(MAP_HEIGHT, pixels);
+    }
+    Benchmark::report("Сборка картинки 64x900", stopwatch.elapsedMilliseconds() * 1000.0 / 100, "мкс");
+
+    // Одинаковые правки в документ с мини-картой и без нее
+    std::mt19937 random(48);
+    std::vector<double> times;
+    double plainTime = 0;
+    for (size_t i = 0; i < editCount; ++i)
+    {
+        size_t offset = random() % tracker.text().length();
+        const wchar_t* inserted = i % 4 == 0 ? L"\r\n" : L"x";
+        stopwatch.restart();
+        plain.applyEdit(offset, 0, inserted);
+        plainTime += stopwatch.elapsedMilliseconds();
+        stopwatch.restart();
+        tracker.applyEdit(offset, 0, inserted);
+        times.push_back(stopwatch.elapsedMilliseconds() * 1000.0);
+    }
+    std::sort(times.begin(), times.end());
+    Benchmark::report("Правка с мини-картой: медиана", times[times.size() / 2], "мкс");
+    Benchmark::report("Правка с мини-картой: максимум", times.back(), "мкс");
+    Benchmark::report("Правка без мини-карты: среднее", plainTime * 1000.0 / editCount, "мкс");
+
+    // Вставка всего документа в конец: число строк удваивается, масштаб меняется
+    std::wstring whole = tracker.text().toString();
+    stopwatch.restart();
+    tracker.applyEdit(tracker.text().length(), 0, whole);
+    Benchmark::report("Вставка, удваивающая документ", stopwatch.elapsedMilliseconds(), "мс");
+    Benchmark::report("Память растра после вставки", cache.memoryUsage() / 1024.0, "КБ");
+
+    bool isCorrect = cache.lineCount() == 2 * (lineCount + editCount / 4) + 1 && cache.render(MAP_HEIGHT, pixels) == MAP_HEIGHT;
+    if (!isCorrect)
+    {
+        std::printf("ОШИБКА: число строк мини-карты не совпадает с документом\n");
+        return 1;
+    }
+    return 0;
+}
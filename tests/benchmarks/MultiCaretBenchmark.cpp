@@ -0,0 +1,128 @@
+// Ввод во множество курсоров: задержка нажатия клавиши
+//
+// Курсоры расставлены в начале равномерно распределенных строк документа.
+// Одно нажатие - пакет замен от SelectionModel: замены применяются к
+// тексту с конца (ChunkedText, индекс строк), а для EDIT-контрола
+// собирается одна замена участка, которая отменяется за один шаг.
+// Каждое десятое нажатие - Backspace.
+//
+// Аргументы: количество строк (1000000), количество курсоров (10000),
+// количество нажатий (200)
+
+#include "benchmarks/Benchmark.h"
+#include "SelectionModel.h"
+#include "TextChangeTracker.h"
+#include <algorithm>
+
+namespace
+{
+    std::wstring documentText(size_t lineCount)
+    {
+        std::wstring text;
+        text.reserve(lineCount * 40);
+        for (size_t line = 0; line < lineCount; ++line)
+        {
+            text += L"    value_" + std::to_wstring(line) + L" = compute(строка);\r\n";
+        }
+        return text;
+    }
+
+    double median(std::vector<double> times)
+    {
+        std::sort(times.begin(), times.end());
+        return times[times.size() / 2];
+    }
+
+    double maximum(const std::vector<double>& times)
+    {
+        return *std::max_element(times.begin(), times.end());
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t lineCount = Benchmark::argument(argc, argv, 1, 1000000);
+    size_t caretCount = Benchmark::argument(argc, argv, 2, 10000);
+    size_t keystrokeCount = Benchmark::argument(argc, argv, 3, 200);
+
+    TextChangeTracker tracker;
+    ChunkLineIndex lines;
+    tracker.addListener(&lines);
+    {
+        std::wstring text = documentText(lineCount);
+        tracker.reset(text.data(), text.size());
+    }
+
+    Benchmark::Stopwatch stopwatch;
+    SelectionModel model;
+    size_t lineStep = std::max<size_t>(1, lineCount / caretCount);
+    model.reset(0, 0);
+    for (size_t line = lineStep; line < lineCount && model.count() < caretCount; line += lineStep)
+    {
+        size_t position = lines.lineStart(tracker.text(), line);
+        model.add(position, position);
+    }
+    Benchmark::report("Расстановка курсоров", stopwatch.elapsedMilliseconds(), "мс");
+    std::printf("Строк: %u, курсоров: %u, нажатий: %u\n", (unsigned)lineCount, (unsigned)model.count(), (unsigned)keystrokeCount);
+
+    std::vector<double> modelTimes;
+    std::vector<double> textTimes;
+    std::vector<double> spanTimes;
+    std::vector<double> totalTimes;
+    std::vector<SelectionModel::Edit> edits;
+    std::wstring span;
+    std::wstring typed;
+    for (size_t key = 0; key < keystrokeCount; ++key)
+    {
+        bool isBackspace = key % 10 == 9;
+        std::wstring inserted = isBackspace ? std::wstring() : std::wstring(1, L"ж_x1"[key % 4]);
+
+        Benchmark::Stopwatch keyStopwatch;
+        stopwatch.restart();
+        if (isBackspace)
+        {
+            model.deleteBackward(tracker.text(), edits);
+            typed.pop_back();
+        }
+        else
+        {
+            model.insert(inserted.size(), edits);
+            typed += inserted;
+        }
+        modelTimes.push_back(stopwatch.elapsedMilliseconds());
+
+        stopwatch.restart();
+        size_t spanLength = 0;
+        SelectionModel::composeSpan(tracker.text(), edits, inserted, span, spanLength);
+        spanTimes.push_back(stopwatch.elapsedMilliseconds());
+
+        stopwatch.restart();
+        for (size_t i = edits.size(); i-- > 0;)
+        {
+            tracker.applyEdit(edits[i].offset, edits[i].removeCount, inserted);
+        }
+        textTimes.push_back(stopwatch.elapsedMilliseconds());
+        totalTimes.push_back(keyStopwatch.elapsedMilliseconds());
+    }
+
+    Benchmark::report("Пакет замен (SelectionModel): медиана", median(modelTimes), "мс");
+    Benchmark::report("Замены в тексте и индексе строк: медиана", median(textTimes), "мс");
+    Benchmark::report("Участок для EDIT-контрола: медиана", median(spanTimes), "мс");
+    Benchmark::report("Нажатие целиком: медиана", median(totalTimes), "мс");
+    Benchmark::report("Нажатие целиком: максимум", maximum(totalTimes), "мс");
+    Benchmark::report("Пиковый RSS процесса", Benchmark::peakResidentMegabytes(), "МБ");
+
+    // Перед каждым курсором - набранный текст, количество строк не изменилось
+    bool isCorrect = lines.lineCount() == lineCount + 1 && model.count() == std::min(caretCount, (lineCount - 1) / lineStep + 1);
+    for (size_t i = 0; i < model.count() && isCorrect; ++i)
+    {
+        size_t caret = model.at(i).caret;
+        isCorrect = caret >= typed.size() && tracker.text().substr(caret - typed.size(), typed.size()) == typed;
+    }
+    if (!isCorrect)
+    {
+        std::printf("ОШИБКА: текст у курсоров не совпадает с набранным\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+// Вставка 10, 100 и 500 МБ текста в документ
+//
+// Вставляемый текст с переводами строк LF заменяет выделение в середине
+// документа. Потоковый путь редактора: подсчет длины результата, сборка
+// нового текста документа в одном буфере с приведением к CRLF по кускам и
+// передача вставки трекеру без копии. Для сравнения - путь через
+// промежуточные строки: приведенная копия вставки, новый текст документа
+// и сравнение трекером. Каждый замер - в отдельном процессе, чтобы
+// пиковый RSS считался заново.
+//
+// Аргументы: размер документа в МБ UTF-16 (10), наибольшая вставка в МБ (500)
+
+#include "benchmarks/Benchmark.h"
+#include "TestSupport.h"
+#include "ChunkedPaste.h"
+#include "TextChangeTracker.h"
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+    std::wstring withoutCarriageReturns(const std::wstring& text)
+    {
+        std::wstring result;
+        result.reserve(text.size());
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            if (text[i] != L'\r')
+            {
+                result += text[i];
+            }
+        }
+        return result;
+    }
+
+    template <typename Paste>
+    bool runInChild(Paste paste)
+    {
+        std::fflush(stdout);
+        pid_t child = fork();
+        if (child == 0)
+        {
+            _exit(paste() ? 0 : 1);
+        }
+        int status = 0;
+        waitpid(child, &status, 0);
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+
+    bool pasteStreaming(const std::string& name, size_t documentMegabytes, size_t pasteMegabytes)
+    {
+        std::wstring document = TestSupport::generateText(documentMegabytes * 1024 * 1024 / 2, 1);
+        std::wstring pasted = withoutCarriageReturns(TestSupport::generateText(pasteMegabytes * 1024 * 1024 / 2, 2));
+        TextChangeTracker tracker;
+        tracker.reset(document.data(), document.size());
+        size_t start = document.size() / 2;
+        size_t end = start + 1000;
+        double basePeak = Benchmark::peakResidentMegabytes();
+
+        Benchmark::Stopwatch stopwatch;
+        size_t insertedLength = ChunkedPaste::measure(pasted.data(), pasted.size());
+        size_t capacity = start + insertedLength + (document.size() - end) + 1;
+        std::vector<wchar_t> output(capacity);
+        bool isBuilt = ChunkedPaste::insert(document.data(), document.size(), start, end, pasted.data(), pasted.size(),
+                                            output.data(), capacity, ChunkedPaste::Progress());
+        double buildTime = stopwatch.elapsedMilliseconds();
+        tracker.applyEdit(start, end - start, output.data() + start, insertedLength);
+        double totalTime = stopwatch.elapsedMilliseconds();
+
+        Benchmark::report(name + ": сборка текста", buildTime, "мс");
+        Benchmark::report(name + ": всего с теневой копией", totalTime, "мс");
+        Benchmark::report(name + ": прирост пикового RSS", Benchmark::peakResidentMegabytes() - basePeak, "МБ");
+        return isBuilt && tracker.text().length() == capacity - 1;
+    }
+
+    bool pasteByCopies(const std::string& name, size_t documentMegabytes, size_t pasteMegabytes)
+    {
+        std::wstring document = TestSupport::generateText(documentMegabytes * 1024 * 1024 / 2, 1);
+        std::wstring pasted = withoutCarriageReturns(TestSupport::generateText(pasteMegabytes * 1024 * 1024 / 2, 2));
+        TextChangeTracker tracker;
+        tracker.reset(document.data(), document.size());
+        size_t start = document.size() / 2;
+        size_t end = start + 1000;
+        double basePeak = Benchmark::peakResidentMegabytes();
+
+        Benchmark::Stopwatch stopwatch;
+        std::wstring normalized;
+        for (size_t i = 0; i < pasted.size(); ++i)
+        {
+            if (pasted[i] == L'\n')
+            {
+                normalized += L'\r';
+            }
+            normalized += pasted[i];
+        }
+        std::wstring result = document.substr(0, start) + normalized + document.substr(end);
+        tracker.update(result.data(), result.size());
+        Benchmark::report(name + ": через копии (для сравнения)", stopwatch.elapsedMilliseconds(), "мс");
+        Benchmark::report(name + ": прирост пикового RSS через копии", Benchmark::peakResidentMegabytes() - basePeak, "МБ");
+        return tracker.text().length() == result.size();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t documentMegabytes = Benchmark::argument(argc, argv, 1, 10);
+    size_t maxPasteMegabytes = Benchmark::argument(argc, argv, 2, 500);
+    static const size_t SIZES[] = { 10, 100, 500 };
+    bool isCorrect = true;
+    for (size_t i = 0; i < 3 && SIZES[i] <= maxPasteMegabytes; ++i)
+    {
+        std::string name = "Вставка " + std::to_string(SIZES[i]) + " МБ";
+        isCorrect = runInChild([&]() { return pasteStreaming(name, documentMegabytes, SIZES[i]); }) && isCorrect;
+        isCorrect = runInChild([&]() { return pasteByCopies(name, documentMegabytes, SIZES[i]); }) && isCorrect;
+    }
+    if (!isCorrect)
+    {
+        std::printf("ОШИБКА: длина текста после вставки неверна\n");
+        return 1;
+    }
+    return 0;
+}
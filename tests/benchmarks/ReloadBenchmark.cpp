@@ -0,0 +1,99 @@
+// Перезагрузка файла, измененного другой программой
+//
+// Документ в UTF-8 меняется на диске в нескольких местах. Замеряются шаги
+// перезагрузки, как в редакторе: чтение и хеш файла, декодирование,
+// построчное сравнение с текстом редактора и применение фрагментов к
+// теневой копии. Для сравнения - полная замена текста теневой копии.
+//
+// Аргументы: размер текста в МБ UTF-16 (100), число измененных строк (20)
+
+#include "benchmarks/Benchmark.h"
+#include "TestSupport.h"
+#include "ContentHash.h"
+#include "LineDiff.h"
+#include "TextChangeTracker.h"
+#include "Utf8Codec.h"
+#include <random>
+
+int main(int argc, char** argv)
+{
+    size_t megabytes = Benchmark::argument(argc, argv, 1, 100);
+    size_t changeCount = Benchmark::argument(argc, argv, 2, 20);
+
+    std::wstring current = TestSupport::generateText(megabytes * 1024 * 1024 / 2, 4);
+    TextChangeTracker tracker;
+    tracker.reset(current.data(), current.size());
+
+    // Правки другой программы: замена, вставка и удаление строк
+    std::wstring changed = current;
+    std::mt19937 random(5);
+    for (size_t i = 0; i < changeCount; ++i)
+    {
+        size_t start = changed.find(L'\n', random() % changed.size());
+        if (start == std::wstring::npos)
+        {
+            continue;
+        }
+        ++start;
+        size_t end = changed.find(L'\n', start);
+        end = end == std::wstring::npos ? changed.size() : end + 1;
+        switch (i % 3)
+        {
+        case 0:
+            changed.replace(start, end - start, L"измененная строка " + std::to_wstring(i) + L"\r\n");
+            break;
+        case 1:
+            changed.insert(start, L"вставленная строка\r\n");
+            break;
+        default:
+            changed.erase(start, end - start);
+            break;
+        }
+    }
+    std::string path = TestSupport::temporaryPath("reload.txt");
+    TestSupport::writeFile(path, Utf8Codec::encode(changed));
+    std::printf("Текст: %.1f МБ, строк изменено: %u\n", current.size() * 2 / 1048576.0, (unsigned)changeCount);
+
+    Benchmark::Stopwatch stopwatch;
+    std::string bytes = TestSupport::readFile(path);
+    uint64_t contentHash = ContentHash::compute(bytes.data(), bytes.size());
+    Benchmark::keep(contentHash);
+    Benchmark::report("Чтение и хеш файла", stopwatch.elapsedMilliseconds(), "мс");
+
+    stopwatch.restart();
+    std::wstring text = Utf8Codec::decode(bytes);
+    Benchmark::report("Декодирование", stopwatch.elapsedMilliseconds(), "мс");
+
+    stopwatch.restart();
+    std::vector<LineDiff::Hunk> hunks;
+    LineDiff::compute(current.data(), current.size(), text.data(), text.size(), hunks);
+    double diffTime = stopwatch.elapsedMilliseconds();
+    Benchmark::report("Построчное сравнение", diffTime, "мс");
+
+    // Фрагменты с конца, чтобы не сдвигать смещения предыдущих
+    stopwatch.restart();
+    for (size_t i = hunks.size(); i-- > 0;)
+    {
+        const LineDiff::Hunk& hunk = hunks[i];
+        tracker.applyEdit(hunk.oldOffset, hunk.oldLength, text.data() + hunk.newOffset, hunk.newLength);
+    }
+    double applyTime = stopwatch.elapsedMilliseconds();
+    Benchmark::report("Применение фрагментов", applyTime, "мс");
+    Benchmark::report("Фрагментов", (double)hunks.size(), "");
+    bool isCorrect = tracker.text().toString() == text;
+
+    TextChangeTracker fullTracker;
+    fullTracker.reset(current.data(), current.size());
+    stopwatch.restart();
+    fullTracker.reset(text.data(), text.size());
+    Benchmark::report("Полная замена текста (для сравнения)", stopwatch.elapsedMilliseconds(), "мс");
+    Benchmark::report("Сравнение и применение вместе", diffTime + applyTime, "мс");
+
+    std::remove(path.c_str());
+    if (!isCorrect)
+    {
+        std::printf("ОШИБКА: текст после перезагрузки не совпадает с файлом\n");
+        return 1;
+    }
+    return 0;
+}
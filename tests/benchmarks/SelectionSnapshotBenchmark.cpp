@@ -0,0 +1,56 @@
+// Копирование выделения в буфер обмена: снимок против копии текста
+//
+// Выделен почти весь документ. Копия текста (как при прежнем
+// копировании) сравнивается со снимком SelectionSnapshot; снимок
+// собирается в текст только по запросу другой программы. После создания
+// снимка документ правится, и собранный текст сверяется с исходным.
+//
+// Аргументы: размер выделения в МБ UTF-16 (1024)
+
+#include "benchmarks/Benchmark.h"
+#include "TestSupport.h"
+#include "SelectionSnapshot.h"
+
+int main(int argc, char** argv)
+{
+    size_t megabytes = Benchmark::argument(argc, argv, 1, 1024);
+    ChunkedText chunks;
+    {
+        std::wstring text = TestSupport::generateText(megabytes * 1024 * 1024 / 2 + 2, 7);
+        chunks.assign(text.data(), text.size());
+    }
+    size_t count = chunks.length() - 2;
+    std::printf("Выделение: %.1f МБ UTF-16, блоков: %u\n", count * 2 / 1048576.0, (unsigned)chunks.chunkCount());
+
+    // Снимок: только указатели на блоки
+    double baseMemory = Benchmark::residentMegabytes();
+    Benchmark::Stopwatch stopwatch;
+    SelectionSnapshot snapshot(chunks, 1, count);
+    Benchmark::report("Создание снимка", stopwatch.elapsedMilliseconds(), "мс");
+    Benchmark::report("Прирост RSS от снимка", Benchmark::residentMegabytes() - baseMemory, "МБ");
+
+    // Прежнее копирование: весь текст в отдельную строку
+    baseMemory = Benchmark::residentMegabytes();
+    stopwatch.restart();
+    std::wstring copy = chunks.substr(1, count);
+    Benchmark::report("Копия текста", stopwatch.elapsedMilliseconds(), "мс");
+    Benchmark::report("Прирост RSS от копии", Benchmark::residentMegabytes() - baseMemory, "МБ");
+
+    // Правка после копирования не меняет снимок
+    chunks.replace(0, chunks.length() / 2, L"правка", 6);
+
+    // Запрос буфера обмена другой программой
+    std::vector<wchar_t> output(snapshot.length() + 1);
+    stopwatch.restart();
+    snapshot.copyTo(output.data());
+    Benchmark::report("Сборка текста по запросу", stopwatch.elapsedMilliseconds(), "мс");
+
+    bool isCorrect = snapshot.length() == count && output[count] == L'\0' &&
+                     copy.compare(0, count, output.data(), count) == 0;
+    if (!isCorrect)
+    {
+        std::printf("ОШИБКА: собранный текст не совпадает с выделением\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,124 @@
+// Холодный старт до первой отрисовки: разбор исходного файла и снимок сеанса
+//
+// Первая отрисовка считается возможной, когда текст декодирован и известно
+// начало первой видимой строки. Без снимка файл читается, хешируется,
+// проверяется на кодировку, декодируется из UTF-8 и приводится к CRLF, как
+// при открытии в редакторе; со снимком он отображается в память.
+// Страницы файлов остаются в кэше ОС после первого прохода, поэтому оба
+// замера - при теплом кэше.
+//
+// Аргументы: размер текста в МБ UTF-16 (100; файл в UTF-8 меньше), первая
+// видимая строка (500000)
+
+#include "benchmarks/Benchmark.h"
+#include "TestSupport.h"
+#include "ChunkedText.h"
+#include "ContentHash.h"
+#include "EncodingDetector.h"
+#include "LineEndingScanner.h"
+#include "SessionSnapshot.h"
+#include "Utf8Codec.h"
+#include <cwchar>
+
+namespace
+{
+    // Смещение начала строки простым поиском переводов строки
+    size_t findLineStart(const wchar_t* text, size_t length, size_t line)
+    {
+        size_t offset = 0;
+        for (size_t i = 0; i < line && offset < length; ++i)
+        {
+            const wchar_t* found = std::wmemchr(text + offset, L'\n', length - offset);
+            if (!found)
+            {
+                return length;
+            }
+            offset = (size_t)(found - text) + 1;
+        }
+        return offset;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t megabytes = Benchmark::argument(argc, argv, 1, 100);
+    size_t firstVisibleLine = Benchmark::argument(argc, argv, 2, 500000);
+
+    // Исходный файл в UTF-8 с переводами строк LF
+    std::string documentPath = TestSupport::temporaryPath("document.txt");
+    std::wstring wideDocumentPath(documentPath.begin(), documentPath.end());
+    {
+        std::wstring text = TestSupport::generateText(megabytes * 1024 * 1024 / 2, 3);
+        std::wstring lf;
+        lf.reserve(text.size());
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            if (text[i] != L'\r')
+            {
+                lf += text[i];
+            }
+        }
+        TestSupport::writeFile(documentPath, Utf8Codec::encode(lf));
+    }
+    PortableFile::Info info = { 0, 0 };
+    PortableFile::getInfo(wideDocumentPath, info);
+    std::printf("Файл: %.1f МБ, первая видимая строка: %u\n", info.size / 1048576.0, (unsigned)firstVisibleLine);
+
+    // Открытие без снимка
+    Benchmark::Stopwatch stopwatch;
+    std::string bytes = TestSupport::readFile(documentPath);
+    uint64_t contentHash = ContentHash::compute(bytes.data(), bytes.size());
+    EncodingDetector::Result detected = EncodingDetector::detect(bytes.data(), bytes.size());
+    LineEndingScanner::Counts lineEndings = LineEndingScanner::scan(bytes.data(), bytes.size(), 1, false);
+    std::wstring text;
+    text.reserve(bytes.size() + (size_t)LineEndingScanner::expansion(lineEndings));
+    Utf8Codec::decodeAppend(bytes.data() + detected.bomLength, bytes.size() - detected.bomLength, text);
+    LineEndingScanner::normalize(text, lineEndings);
+    size_t lineStart = findLineStart(text.data(), text.size(), firstVisibleLine);
+    double parseTime = stopwatch.elapsedMilliseconds();
+    double parseMemory = Benchmark::residentMegabytes();
+    Benchmark::keep(lineStart);
+    Benchmark::report("Без снимка: до первой отрисовки", parseTime, "мс");
+
+    // Снимок пишется при выходе из редактора
+    ChunkedText chunks;
+    chunks.assign(text.data(), text.size());
+    SessionState state;
+    state.documentPath = wideDocumentPath;
+    state.fileSize = info.size;
+    state.fileModifiedTime = info.modifiedTime;
+    state.contentHash = contentHash;
+    state.firstVisibleLine = firstVisibleLine;
+    std::wstring snapshotPath = TestSupport::temporaryWidePath("session.snap");
+    stopwatch.restart();
+    SessionSnapshot::write(snapshotPath, state, chunks);
+    Benchmark::report("Запись снимка при выходе", stopwatch.elapsedMilliseconds(), "мс");
+    std::wstring().swap(text);
+    std::string().swap(bytes);
+    chunks.assign(L"", 0);
+
+    // Открытие из снимка
+    double baseMemory = Benchmark::residentMegabytes();
+    stopwatch.restart();
+    SessionSnapshot snapshot;
+    PortableFile::Info current = { 0, 0 };
+    bool isValid = snapshot.open(snapshotPath) && PortableFile::getInfo(wideDocumentPath, current) &&
+                   snapshot.matches(wideDocumentPath, current);
+    uint64_t snapshotLineStart = isValid ? snapshot.lineOffset((size_t)snapshot.state().firstVisibleLine) : 0;
+    double snapshotTime = stopwatch.elapsedMilliseconds();
+    Benchmark::report("Со снимком: до первой отрисовки", snapshotTime, "мс");
+    Benchmark::report("Ускорение", parseTime / (snapshotTime > 0 ? snapshotTime : 1e-3), "раз");
+
+    // Проверка содержимого в фоне не задерживает отрисовку
+    stopwatch.restart();
+    bool isCurrent = SessionSnapshot::verifyContent(wideDocumentPath, snapshot.state().contentHash);
+    Benchmark::report("Фоновая проверка хеша файла", stopwatch.elapsedMilliseconds(), "мс");
+    Benchmark::report("Память без снимка (RSS)", parseMemory, "МБ");
+    Benchmark::report("Прирост памяти со снимком (RSS)", Benchmark::residentMegabytes() - baseMemory, "МБ");
+
+    bool isCorrect = isValid && isCurrent && snapshotLineStart == lineStart;
+    snapshot.close();
+    PortableFile::remove(snapshotPath);
+    PortableFile::remove(wideDocumentPath);
+    return isCorrect ? 0 : 1;
+}
@@ -0,0 +1,74 @@
+// Время загрузки настроек при старте и пакетной записи изменений
+//
+// Аргументы: число значений (64), число повторов (1000)
+
+#include "benchmarks/Benchmark.h"
+#include "TestSupport.h"
+#include "IniSettingsBackend.h"
+#include "SettingsStore.h"
+
+int main(int argc, char** argv)
+{
+    size_t valueCount = Benchmark::argument(argc, argv, 1, 64);
+    size_t repeatCount = Benchmark::argument(argc, argv, 2, 1000);
+    std::string narrowPath = TestSupport::temporaryPath("settings.ini");
+    std::wstring path = TestSupport::temporaryWidePath("settings.ini");
+    std::remove(narrowPath.c_str());
+
+    // Файл с половиной строковых и половиной числовых значений
+    {
+        SettingsStore store(std::unique_ptr<ISettingsBackend>(new IniSettingsBackend(path)));
+        store.load();
+        for (size_t i = 0; i < valueCount; ++i)
+        {
+            std::wstring name = L"Value" + std::to_wstring(i);
+            if (i % 2 == 0)
+            {
+                store.setString(name, L"Строковое значение настройки " + std::to_wstring(i));
+            }
+            else
+            {
+                store.setNumber(name, (uint32_t)i);
+            }
+        }
+        store.flush();
+    }
+
+    // Загрузка целиком при старте, затем чтение всех значений из памяти
+    Benchmark::Stopwatch stopwatch;
+    size_t found = 0;
+    for (size_t repeat = 0; repeat < repeatCount; ++repeat)
+    {
+        SettingsStore store(std::unique_ptr<ISettingsBackend>(new IniSettingsBackend(path)));
+        store.load();
+        for (size_t i = 0; i < valueCount; ++i)
+        {
+            std::wstring text;
+            uint32_t number = 0;
+            std::wstring name = L"Value" + std::to_wstring(i);
+            found += (store.getString(name, text) || store.getNumber(name, number)) ? 1 : 0;
+        }
+    }
+    double loadTime = stopwatch.elapsedMilliseconds() / repeatCount;
+
+    // Изменение всех значений и одна пакетная запись
+    stopwatch.restart();
+    for (size_t repeat = 0; repeat < repeatCount / 10 + 1; ++repeat)
+    {
+        SettingsStore store(std::unique_ptr<ISettingsBackend>(new IniSettingsBackend(path)));
+        store.load();
+        for (size_t i = 0; i < valueCount; ++i)
+        {
+            store.setNumber(L"Value" + std::to_wstring(i), (uint32_t)(repeat + i));
+        }
+        store.flush();
+    }
+    double flushTime = stopwatch.elapsedMilliseconds() / (repeatCount / 10 + 1);
+
+    std::printf("Значений: %u, повторов: %u\n", (unsigned)valueCount, (unsigned)repeatCount);
+    Benchmark::report("Загрузка и чтение всех значений", loadTime, "мс");
+    Benchmark::report("Изменение всех значений и запись пакетом", flushTime, "мс");
+    Benchmark::keep(found);
+    std::remove(narrowPath.c_str());
+    return found == valueCount * repeatCount ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+// Скорость потокового сохранения документа в разных форматах
+//
+// Текст в блоках ChunkedText записывается в файл через TextEncoder в UTF-8,
+// UTF-16LE, UTF-16BE и Windows-1251, с заменой переводов строк на LF.
+// Для сравнения - прежний путь: копия всего текста, перекодирование в
+// строку байтов и запись. Замеряются время, скорость и прирост пикового RSS.
+//
+// Аргументы: размер текста в МБ UTF-16 (200)
+
+#include "benchmarks/Benchmark.h"
+#include "TestSupport.h"
+#include "CodePageTables.h"
+#include "ChunkedText.h"
+#include "TextEncoder.h"
+#include "Utf8Codec.h"
+
+int main(int argc, char** argv)
+{
+    size_t megabytes = Benchmark::argument(argc, argv, 1, 200);
+    ChunkedText chunks;
+    {
+        std::wstring text = TestSupport::generateText(megabytes * 1024 * 1024 / 2, 12);
+        chunks.assign(text.data(), text.size());
+    }
+    double textMegabytes = chunks.length() * 2 / 1048576.0;
+    std::printf("Текст: %.1f МБ\n", textMegabytes);
+
+    std::string path = TestSupport::temporaryPath("encoded.txt");
+    std::wstring widePath(path.begin(), path.end());
+    std::vector<wchar_t> table = TestSupport::singleByteTable(1251);
+
+    static const uint32_t CODE_PAGES[] = {
+        DocumentFormat::CODE_PAGE_UTF8, DocumentFormat::CODE_PAGE_UTF16LE, DocumentFormat::CODE_PAGE_UTF16BE, 1251
+    };
+    static const char* const NAMES[] = { "UTF-8", "UTF-16LE", "UTF-16BE", "Windows-1251" };
+    bool isCorrect = true;
+    for (size_t i = 0; i < 4; ++i)
+    {
+        DocumentFormat format;
+        format.codePage = CODE_PAGES[i];
+        format.lineEnding = DocumentFormat::LINE_ENDING_LF;
+        TextEncoder encoder(format, table);
+
+        double basePeak = Benchmark::peakResidentMegabytes();
+        Benchmark::Stopwatch stopwatch;
+        TextEncoder::Measure measured = encoder.measure(chunks);
+        uint64_t contentHash = 0;
+        isCorrect = encoder.writeFile(widePath, chunks, measured, contentHash) && isCorrect;
+        double time = stopwatch.elapsedMilliseconds();
+        isCorrect = isCorrect && measured.unmappableCount == 0;
+
+        Benchmark::report(std::string(NAMES[i]) + ": сохранение", time, "мс");
+        Benchmark::report(std::string(NAMES[i]) + ": скорость", textMegabytes / (time / 1000.0), "МБ/с");
+        Benchmark::report(std::string(NAMES[i]) + ": прирост пикового RSS", Benchmark::peakResidentMegabytes() - basePeak, "МБ");
+    }
+
+    // Прежний путь: весь текст, затем все байты в памяти
+    double basePeak = Benchmark::peakResidentMegabytes();
+    Benchmark::Stopwatch stopwatch;
+    std::string bytes = Utf8Codec::encode(chunks.toString());
+    isCorrect = TestSupport::writeFile(path, bytes) && isCorrect;
+    double time = stopwatch.elapsedMilliseconds();
+    Benchmark::report("UTF-8 через копию текста: сохранение", time, "мс");
+    Benchmark::report("UTF-8 через копию текста: прирост пикового RSS", Benchmark::peakResidentMegabytes() - basePeak, "МБ");
+
+    std::remove(path.c_str());
+    if (!isCorrect)
+    {
+        std::printf("ОШИБКА: текст сохранен не полностью\n");
+        return 1;
+    }
+    return 0;
+}
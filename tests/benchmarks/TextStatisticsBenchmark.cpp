@@ -0,0 +1,108 @@
+// Статистика документа при непрерывном вводе: стоимость нажатия клавиши
+//
+// Документ собирается в ChunkedText дописыванием частей, без второй копии
+// текста в одной строке. Ввод идет подряд в одном месте (блок растет и
+// делится), с пробелами и переводами строк, затем в случайных местах.
+// Время нажатия с TextStatistics сравнивается с таким же вводом без нее;
+// построение статистики - цена пересчета полным просмотром, которую
+// платило бы каждое нажатие без сводок. В конце итог сверяется с
+// построенной заново статистикой.
+//
+// Аргументы: размер документа в МБ UTF-16 (1024), количество нажатий (20000)
+
+#include "benchmarks/Benchmark.h"
+#include "TextStatistics.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+    void typeText(TextChangeTracker& tracker, size_t keyCount, size_t position, std::vector<double>& times)
+    {
+        Benchmark::Stopwatch stopwatch;
+        for (size_t i = 0; i < keyCount; ++i)
+        {
+            std::wstring key = i % 7 == 6 ? L" " : (i % 50 == 49 ? L"\r\n" : L"ы");
+            stopwatch.restart();
+            tracker.applyEdit(position, 0, key);
+            times.push_back(stopwatch.elapsedMilliseconds() * 1000.0);
+            position += key.size();
+        }
+    }
+
+    double median(std::vector<double> times)
+    {
+        std::sort(times.begin(), times.end());
+        return times[times.size() / 2];
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t megabytes = Benchmark::argument(argc, argv, 1, 1024);
+    size_t keyCount = Benchmark::argument(argc, argv, 2, 20000);
+
+    const std::wstring line = L"    Съешь же ещё этих мягких французских булок, да выпей чаю. The quick brown fox;\r\n";
+    std::wstring part;
+    while (part.size() + line.size() <= 1024 * 1024)
+    {
+        part += line;
+    }
+    TextChangeTracker tracker;
+    Benchmark::Stopwatch stopwatch;
+    for (size_t total = megabytes * 1024 * 1024 / 2; tracker.text().length() + part.size() <= total;)
+    {
+        tracker.applyEdit(tracker.text().length(), 0, part);
+    }
+    std::printf("Документ: %.2f ГБ UTF-16, блоков: %u, сборка %.0f мс\n", tracker.text().length() * 2 / 1073741824.0,
+                (unsigned)tracker.text().chunkCount(), stopwatch.elapsedMilliseconds());
+
+    // Ввод без статистики
+    size_t position = tracker.text().length() / 2;
+    std::vector<double> plainTimes;
+    typeText(tracker, keyCount, position, plainTimes);
+
+    stopwatch.restart();
+    TextStatistics statistics;
+    statistics.onTextReset(tracker.text());
+    tracker.addListener(&statistics);
+    Benchmark::report("Построение статистики", stopwatch.elapsedMilliseconds(), "мс");
+
+    std::vector<double> times;
+    typeText(tracker, keyCount, position + keyCount, times);
+    Benchmark::report("Нажатие со статистикой: медиана", median(times), "мкс");
+    Benchmark::report("Нажатие со статистикой: максимум", *std::max_element(times.begin(), times.end()), "мкс");
+    Benchmark::report("Нажатие без статистики: медиана", median(plainTimes), "мкс");
+
+    std::mt19937 random(49);
+    stopwatch.restart();
+    for (size_t i = 0; i < keyCount; ++i)
+    {
+        tracker.applyEdit(random() % tracker.text().length(), 0, L"a");
+    }
+    Benchmark::report("Нажатие в случайном месте со статистикой", stopwatch.elapsedMilliseconds() * 1000.0 / keyCount, "мкс");
+
+    stopwatch.restart();
+    size_t checksum = 0;
+    for (int i = 0; i < 1000000; ++i)
+    {
+        checksum += statistics.totals().words;
+    }
+    Benchmark::keep(checksum);
+    Benchmark::report("Чтение итогов для строки состояния", stopwatch.elapsedMilliseconds() / 1000.0, "мкс");
+
+    TextStatistics fresh;
+    fresh.onTextReset(tracker.text());
+    TextStatistics::Counts counts = statistics.totals();
+    TextStatistics::Counts expected = fresh.totals();
+    std::printf("Символов: %llu, слов: %llu, строк: %llu, вне ASCII: %llu\n", (unsigned long long)counts.characters,
+                (unsigned long long)counts.words, (unsigned long long)counts.lines, (unsigned long long)counts.nonAscii);
+    Benchmark::report("Пиковый RSS процесса", Benchmark::peakResidentMegabytes(), "МБ");
+    if (counts.characters != expected.characters || counts.words != expected.words ||
+        counts.lines != expected.lines || counts.nonAscii != expected.nonAscii)
+    {
+        std::printf("ОШИБКА: итог после ввода не совпадает с построенным заново\n");
+        return 1;
+    }
+    return 0;
+}
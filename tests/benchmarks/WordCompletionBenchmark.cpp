@@ -0,0 +1,146 @@
+// Индекс автодополнения: построение, память и задержка запроса
+//
+// Текст - исходники: по умолчанию созданный код на C++ из словаря
+// идентификаторов с неравномерной частотой (как в реальном дереве
+// исходников), или файл со склеенным деревом (например,
+// find src -name '*.cpp' -o -name '*.h' | xargs cat > tree.txt; байты
+// больше 0x7F заменяются на "?"). После построения измеряются запросы
+// k самых частых продолжений и ввод слов, обновляющий индекс по правкам.
+//
+// Аргументы: размер текста в МБ (50), путь к файлу с исходниками (нет)
+
+#include "benchmarks/Benchmark.h"
+#include "TestSupport.h"
+#include "TextChangeTracker.h"
+#include "WordCompletionIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace
+{
+    std::wstring generateSource(size_t length)
+    {
+        const wchar_t* keywords[] = { L"int", L"const", L"return", L"if", L"for", L"auto", L"std", L"size_t", L"void" };
+        const wchar_t* parts[] = { L"buffer", L"text", L"line", L"offset", L"count", L"index", L"chunk", L"length",
+                                   L"document", L"editor", L"result", L"value", L"state", L"cache", L"node", L"word" };
+        std::mt19937 random(45);
+        std::vector<std::wstring> identifiers;
+        for (size_t i = 0; i < 200000; ++i)
+        {
+            std::wstring name = parts[random() % 16];
+            name += i % 2 ? L"_" : L"";
+            name += parts[random() % 16];
+            identifiers.push_back(name + std::to_wstring(i));
+        }
+
+        // Частота идентификатора обратно пропорциональна его номеру
+        std::wstring text;
+        text.reserve(length + 256);
+        while (text.size() < length)
+        {
+            text += L"    ";
+            text += keywords[random() % 9];
+            for (int i = 0; i < 4; ++i)
+            {
+                double uniform = (random() + 1.0) / 4294967296.0;
+                size_t rank = (size_t)std::pow((double)identifiers.size(), uniform) - 1;
+                text += i == 1 ? L" = " : (i == 2 ? L"(" : L" ");
+                text += identifiers[std::min(rank, identifiers.size() - 1)];
+            }
+            text += L");\r\n";
+        }
+        return text;
+    }
+
+    double percentile(std::vector<double> times, size_t percent)
+    {
+        std::sort(times.begin(), times.end());
+        return times[std::min(times.size() - 1, times.size() * percent / 100)];
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t megabytes = Benchmark::argument(argc, argv, 1, 50);
+    std::wstring text;
+    if (argc > 2)
+    {
+        std::string bytes = TestSupport::readFile(argv[2]);
+        text.assign(bytes.begin(), bytes.end());
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            text[i] = (unsigned)text[i] < 0x80 ? text[i] : L'?';
+        }
+    }
+    else
+    {
+        text = generateSource(megabytes * 1024 * 1024);
+    }
+    TextChangeTracker tracker;
+    tracker.reset(text.data(), text.size());
+
+    double baseMemory = Benchmark::residentMegabytes();
+    Benchmark::Stopwatch stopwatch;
+    WordCompletionIndex index;
+    index.onTextReset(tracker.text());
+    tracker.addListener(&index);
+    std::printf("Текст: %.1f МБ, различных слов: %u\n", text.size() / 1048576.0, (unsigned)index.wordCount());
+    Benchmark::report("Построение индекса", stopwatch.elapsedMilliseconds(), "мс");
+    Benchmark::report("Память дерева", index.memoryUsage() / 1048576.0, "МБ");
+    Benchmark::report("Прирост RSS", Benchmark::residentMegabytes() - baseMemory, "МБ");
+
+    // Префиксы из 1-4 первых букв слов текста; однобуквенные - самые тяжелые
+    std::mt19937 random(3);
+    std::vector<std::wstring> prefixes;
+    for (size_t i = 0; i < 20000; ++i)
+    {
+        size_t position = random() % text.size();
+        while (position > 0 && WordCompletionIndex::isWordChar(text[position - 1]))
+        {
+            --position;
+        }
+        size_t length = 1 + random() % 4;
+        if (position + length <= text.size())
+        {
+            prefixes.push_back(text.substr(position, length));
+        }
+    }
+    std::vector<WordCompletionIndex::Completion> completions;
+    std::vector<double> times;
+    size_t completionCount = 0;
+    for (size_t i = 0; i < prefixes.size(); ++i)
+    {
+        stopwatch.restart();
+        index.complete(prefixes[i], 10, completions);
+        times.push_back(stopwatch.elapsedMilliseconds() * 1000.0);
+        completionCount += completions.size();
+    }
+    Benchmark::keep(completionCount);
+    Benchmark::report("Запрос 10 слов: медиана", percentile(times, 50), "мкс");
+    Benchmark::report("Запрос 10 слов: 99-й процентиль", percentile(times, 99), "мкс");
+    Benchmark::report("Запрос 10 слов: максимум", percentile(times, 100), "мкс");
+
+    // Ввод слов с начала строки в середине текста: каждое нажатие обновляет индекс
+    const std::wstring typed = L"completionCandidate";
+    size_t position = text.find(L'\n', text.size() / 2) + 1;
+    size_t editCount = 0;
+    stopwatch.restart();
+    for (int word = 0; word < 1000; ++word)
+    {
+        for (size_t i = 0; i <= typed.size(); ++i)
+        {
+            tracker.applyEdit(position++, 0, i < typed.size() ? typed.substr(i, 1) : L" ");
+            ++editCount;
+        }
+    }
+    Benchmark::report("Нажатие с обновлением индекса", stopwatch.elapsedMilliseconds() * 1000.0 / editCount, "мкс");
+
+    index.complete(L"completionC", 1, completions);
+    if (completions.size() != 1 || completions[0].word != typed || completions[0].count < 1000)
+    {
+        std::printf("ОШИБКА: набранное слово не найдено в индексе\n");
+        return 1;
+    }
+    return 0;
+}
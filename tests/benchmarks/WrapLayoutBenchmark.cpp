@@ -0,0 +1,104 @@
+// Перенос строк в документе из миллиона строк: изменение ширины окна
+//
+// Строки случайной длины (каждая десятая - до 400 символов), ширина
+// символов задается моноширинным источником. Замеряются начальная
+// разметка, изменения ширины (малые и большие, в обе стороны) с числом
+// переразмеченных строк, правки отдельных строк, вставки строк и переходы
+// между экранными и логическими строками при прокрутке.
+//
+// Аргументы: число строк (1000000)
+
+#include "benchmarks/Benchmark.h"
+#include "WrapLayout.h"
+#include <random>
+
+namespace
+{
+    class MonospaceWidths : public GlyphWidthProvider
+    {
+    public:
+        int width(wchar_t symbol) const override
+        {
+            return symbol >= 0x3000 ? 16 : (symbol == L'\t' ? 32 : 8);
+        }
+    };
+
+    std::wstring randomLine(std::mt19937& random, size_t maxLength)
+    {
+        size_t length = random() % (maxLength + 1);
+        std::wstring line;
+        for (size_t i = 0; i < length; ++i)
+        {
+            line += random() % 7 == 0 ? L' ' : (wchar_t)(L'а' + random() % 32);
+        }
+        return line;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t lineCount = Benchmark::argument(argc, argv, 1, 1000000);
+    std::mt19937 random(19);
+    std::vector<std::wstring> lines(lineCount);
+    for (size_t i = 0; i < lineCount; ++i)
+    {
+        lines[i] = randomLine(random, i % 10 == 0 ? 400 : 120);
+    }
+    MonospaceWidths widths;
+    WrapLayout layout(widths);
+    WrapLayout::LineSource source = [&](size_t line, std::wstring& text) { text = lines[line]; };
+
+    Benchmark::Stopwatch stopwatch;
+    layout.reset(lineCount, source, 800);
+    Benchmark::report("Начальная разметка", stopwatch.elapsedMilliseconds(), "мс");
+    std::printf("Строк: %u, экранных строк: %llu\n", (unsigned)lineCount, (unsigned long long)layout.visualLineCount());
+
+    static const int WIDTHS[] = { 790, 800, 1200, 1210, 600, 2000, 4000, 3990 };
+    for (size_t i = 0; i < sizeof(WIDTHS) / sizeof(WIDTHS[0]); ++i)
+    {
+        stopwatch.restart();
+        size_t reflowed = layout.setWidth(WIDTHS[i], source);
+        std::string name = "Ширина " + std::to_string(WIDTHS[i]);
+        Benchmark::report(name + ": время", stopwatch.elapsedMilliseconds(), "мс");
+        Benchmark::report(name + ": переразмечено строк", (double)reflowed, "");
+    }
+    {
+        stopwatch.restart();
+        WrapLayout full(widths);
+        full.reset(lineCount, source, layout.width());
+        Benchmark::report("Полная разметка при той же ширине (для сравнения)", stopwatch.elapsedMilliseconds(), "мс");
+    }
+
+    stopwatch.restart();
+    for (int i = 0; i < 100000; ++i)
+    {
+        size_t line = random() % lines.size();
+        lines[line] = randomLine(random, 200);
+        layout.replaceLines(line, 1, 1, source);
+    }
+    Benchmark::report("Правка строки", stopwatch.elapsedMilliseconds() * 1000.0 / 100000, "мкс");
+
+    double insertTime = 0;
+    for (int i = 0; i < 100; ++i)
+    {
+        size_t line = random() % lines.size();
+        lines.insert(lines.begin() + line, L"новая строка");
+        stopwatch.restart();
+        layout.replaceLines(line, 0, 1, source);
+        insertTime += stopwatch.elapsedMilliseconds();
+    }
+    Benchmark::report("Вставка строки", insertTime / 100, "мс");
+
+    const int LOOKUP_COUNT = 1000000;
+    uint64_t checksum = 0;
+    stopwatch.restart();
+    for (int i = 0; i < LOOKUP_COUNT; ++i)
+    {
+        size_t row = 0;
+        checksum += layout.lineOfVisual(random() % layout.visualLineCount(), row);
+        checksum += layout.visualLineOf(random() % lines.size());
+    }
+    Benchmark::keep(checksum);
+    Benchmark::report("Экранная строка в логическую и обратно", stopwatch.elapsedMilliseconds() * 1e6 / LOOKUP_COUNT, "нс");
+    return layout.lineCount() == lines.size() ? 0 : 1;
+}